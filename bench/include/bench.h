@@ -0,0 +1,76 @@
+#pragma once
+/**
+ * A minimal microbenchmark harness. A benchmark repeats the operation it
+ * measures 'n' times between 'bench_start' and 'bench_stop' and the runner
+ * grows 'n' until a run takes long enough for the result to be stable. Only
+ * what happens between start and stop is measured (time and allocations) so
+ * setup and cleanup can be done in the benchmark itself.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <swicc/swicc.h>
+
+/* State of one run of a benchmark. */
+typedef struct bench_s
+{
+    uint64_t n; /* How many operations to do in this run. */
+    bool fail;  /* Set when the benchmark failed, the result gets dropped. */
+
+    /* Only used by the harness. */
+    uint64_t time_start;
+    uint64_t time;
+    uint64_t alloc_start;
+    uint64_t alloc;
+} bench_st;
+
+typedef void bench_ft(bench_st *const b);
+
+/**
+ * @brief Add a benchmark to the ones that get run.
+ * @param[in] name Name of the benchmark, must stay valid.
+ * @param[in] fn
+ */
+void bench_register(char const *const name, bench_ft *const fn);
+
+/**
+ * @brief Start measuring the operations of a run.
+ * @param[in, out] b
+ */
+void bench_start(bench_st *const b);
+
+/**
+ * @brief Stop measuring the operations of a run.
+ * @param[in, out] b
+ */
+void bench_stop(bench_st *const b);
+
+/**
+ * @brief Mark a run as failed and print why.
+ * @param[in, out] b
+ * @param[in] reason
+ */
+void bench_fail(bench_st *const b, char const *const reason);
+
+/* Keep the compiler from dropping the computation of a value. */
+#define BENCH_KEEP(val) __asm__ volatile("" : : "g"(val) : "memory")
+
+/* Define a benchmark and register it before the runner starts. */
+#define BENCH(group, name)                                                     \
+    static bench_ft bench_##group##_##name;                                    \
+    __attribute__((constructor)) static void bench_reg_##group##_##name(void)  \
+    {                                                                          \
+        bench_register(#group "." #name, bench_##group##_##name);             \
+    }                                                                          \
+    static void bench_##group##_##name(bench_st *const b)
+
+/**
+ * @brief Create a disk holding an MF (ID 3F00) with a number of transparent
+ * EFs. EF number N gets ID 0x2000 + N and, for the first 254, SID N + 1. It is
+ * created from a JSON description written to the temporary directory.
+ * @param[out] disk
+ * @param[in] ef_count Number of EFs in the MF, at most 4096.
+ * @return Return code.
+ */
+swicc_ret_et bench_disk_create(swicc_disk_st *const disk,
+                               uint32_t const ef_count);
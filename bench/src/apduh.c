@@ -0,0 +1,82 @@
+#include <bench.h>
+#include <string.h>
+
+/**
+ * @brief Run one command again and again through the APDU demux (including
+ * the GET RESPONSE to retrieve its data).
+ * @param b
+ * @param fid File to select before starting.
+ * @param capdu
+ * @param capdu_len
+ * @param sw1 Expected SW1 of the response.
+ */
+static void bench_apduh(bench_st *const b, swicc_fs_id_kt const fid,
+                        uint8_t const *const capdu, uint16_t const capdu_len,
+                        uint8_t const sw1)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    if (swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                 "test/data/disk/006-in.json") !=
+            SWICC_RET_SUCCESS ||
+        swicc_va_select_file_id(&swicc_state.fs, fid) != SWICC_RET_SUCCESS)
+    {
+        bench_fail(b, "Failed to prepare the card");
+        swicc_terminate(&swicc_state);
+        return;
+    }
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        uint16_t rapdu_len = sizeof(rapdu);
+        if (swicc_apduh_exec(&swicc_state, capdu, capdu_len, rapdu,
+                             &rapdu_len) != SWICC_RET_SUCCESS ||
+            rapdu[rapdu_len - 2U] != sw1)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    swicc_terminate(&swicc_state);
+}
+
+BENCH(apduh, demux_unk)
+{
+    uint8_t const capdu[] = {0x00, 0xFF, 0x00, 0x00};
+    bench_apduh(b, 0xE7C7, capdu, sizeof(capdu), SWICC_APDU_SW1_CHER_INS);
+}
+
+BENCH(apduh, demux_select)
+{
+    /* Select by FID and return the FCP. */
+    uint8_t const capdu[] = {0x00, 0xA4, 0x00, 0x04, 0x02, 0xE9, 0x9D, 0x00};
+    bench_apduh(b, 0xE7C7, capdu, sizeof(capdu), SWICC_APDU_SW1_NORM_NONE);
+}
+
+BENCH(apduh, demux_bin_read)
+{
+    uint8_t const capdu[] = {0x00, 0xB0, 0x00, 0x00, 0x10};
+    bench_apduh(b, 0xF4F4, capdu, sizeof(capdu), SWICC_APDU_SW1_NORM_NONE);
+}
+
+BENCH(apduh, demux_rcrd_read)
+{
+    uint8_t const capdu[] = {0x00, 0xB2, 0x02, 0x04, 0x10};
+    bench_apduh(b, 0xE99D, capdu, sizeof(capdu), SWICC_APDU_SW1_NORM_NONE);
+}
+
+BENCH(apduh, demux_rcrd_update)
+{
+    uint8_t capdu[5U + 16U] = {0x00, 0xDC, 0x02, 0x04, 0x10};
+    memset(&capdu[5U], 0xA5, 16U);
+    bench_apduh(b, 0xE99D, capdu, sizeof(capdu), SWICC_APDU_SW1_NORM_NONE);
+}
+
+BENCH(apduh, demux_rcrd_search)
+{
+    /* Simple search forward from the first record for its first 2 bytes. */
+    uint8_t const capdu[] = {0x00, 0xA2, 0x01, 0x04, 0x02, 0xF6, 0x72, 0x00};
+    bench_apduh(b, 0xE99D, capdu, sizeof(capdu), SWICC_APDU_SW1_NORM_NONE);
+}
@@ -0,0 +1,98 @@
+#include <bench.h>
+
+/* Mix of the short path and of long tags and lengths. */
+static uint8_t bench_dato_buf[] = {0x62, 0x0C, 0x82, 0x02, 0x41, 0x21,
+                                   0xBF, 0x1F, 0x81, 0x04, 0x9F, 0x21,
+                                   0x01, 0x07, 0x8A, 0x00, 0x80, 0x00};
+
+BENCH(dato, bertlv_dec_all)
+{
+    swicc_dato_bertlv_node_st node[sizeof(bench_dato_buf) / 2U];
+    uint32_t node_count;
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        if (swicc_dato_bertlv_dec_all(bench_dato_buf, sizeof(bench_dato_buf),
+                                      node, sizeof(node) / sizeof(node[0U]),
+                                      &node_count) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+        BENCH_KEEP(node_count);
+    }
+    bench_stop(b);
+}
+
+BENCH(dato, bertlv_dec_next)
+{
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Walk the DOs at the root level. */
+        swicc_dato_bertlv_dec_st decoder;
+        swicc_dato_bertlv_dec_init(&decoder, bench_dato_buf,
+                                   sizeof(bench_dato_buf));
+        uint32_t count = 0U;
+        while (swicc_dato_bertlv_dec_next(&decoder) == SWICC_RET_SUCCESS)
+        {
+            count += 1U;
+        }
+        if (count != 3U)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+}
+
+BENCH(dato, bertlv_enc)
+{
+    swicc_dato_bertlv_tag_st tag_fcp;
+    swicc_dato_bertlv_tag_st tag_descr;
+    swicc_dato_bertlv_tag_st tag_id;
+    swicc_dato_bertlv_tag_st tag_lcs;
+    if (swicc_dato_bertlv_tag_create(&tag_fcp, 0x62) != SWICC_RET_SUCCESS ||
+        swicc_dato_bertlv_tag_create(&tag_descr, 0x82) != SWICC_RET_SUCCESS ||
+        swicc_dato_bertlv_tag_create(&tag_id, 0x83) != SWICC_RET_SUCCESS ||
+        swicc_dato_bertlv_tag_create(&tag_lcs, 0x8A) != SWICC_RET_SUCCESS)
+    {
+        bench_fail(b, "Failed to create the tags");
+        return;
+    }
+    uint8_t const descr[] = {0x41, 0x21};
+    uint8_t const id[] = {0x2F, 0xE2};
+    uint8_t const lcs[] = {0x05};
+    uint8_t buf[16U];
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Encoding goes backwards so the last DO comes first. */
+        swicc_dato_bertlv_enc_st enc;
+        swicc_dato_bertlv_enc_st enc_fcp;
+        swicc_dato_bertlv_enc_init(&enc, buf, sizeof(buf));
+        if (swicc_dato_bertlv_enc_nstd_start(&enc, &enc_fcp) !=
+                SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_data(&enc_fcp, lcs, sizeof(lcs)) !=
+                SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_hdr(&enc_fcp, &tag_lcs) !=
+                SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_data(&enc_fcp, id, sizeof(id)) !=
+                SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_hdr(&enc_fcp, &tag_id) != SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_data(&enc_fcp, descr, sizeof(descr)) !=
+                SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_hdr(&enc_fcp, &tag_descr) !=
+                SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_nstd_end(&enc, &enc_fcp) !=
+                SWICC_RET_SUCCESS ||
+            swicc_dato_bertlv_enc_hdr(&enc, &tag_fcp) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+        BENCH_KEEP(buf[0U]);
+    }
+    bench_stop(b);
+}
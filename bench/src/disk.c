@@ -0,0 +1,202 @@
+#include <bench.h>
+#include <stdio.h>
+
+swicc_ret_et bench_disk_create(swicc_disk_st *const disk,
+                               uint32_t const ef_count)
+{
+    if (ef_count > 4096U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    char path[64U];
+    snprintf(path, sizeof(path), "build/tmp/bench-%u.json", ef_count);
+    FILE *const f = fopen(path, "w");
+    if (f == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    fprintf(f, "{\"disk\": [{\"type\": \"file_mf\", \"id\": \"3F00\", "
+               "\"name\": {\"type\": \"ascii\", \"contents\": \"MF\"}, "
+               "\"contents\": [");
+    for (uint32_t ef_idx = 0U; ef_idx < ef_count; ++ef_idx)
+    {
+        fprintf(f, "%s{\"type\": \"file_ef_transparent\", \"id\": \"%04X\", ",
+                ef_idx == 0U ? "" : ", ", 0x2000U + ef_idx);
+        if (ef_idx < 254U)
+        {
+            fprintf(f, "\"sid\": \"%02X\", ", ef_idx + 1U);
+        }
+        fprintf(f, "\"contents\": {\"type\": \"hex\", \"contents\": "
+                   "\"00112233445566778899AABBCCDDEEFF\"}}");
+    }
+    fprintf(f, "]}]}\n");
+    if (fclose(f) != 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return swicc_diskjs_disk_create(disk, path);
+}
+
+/**
+ * @brief Look up EFs by ID in the MF of a disk, all EFs in turn.
+ * @param b
+ * @param ef_count Number of EFs in the disk.
+ */
+static void bench_lutid_lookup(bench_st *const b, uint32_t const ef_count)
+{
+    swicc_disk_st disk = {0U};
+    if (bench_disk_create(&disk, ef_count) != SWICC_RET_SUCCESS)
+    {
+        bench_fail(b, "Failed to create the disk");
+        return;
+    }
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Safe cast since the ID is at most 0x2000 + 4095. */
+        swicc_fs_id_kt const id = (swicc_fs_id_kt)(0x2000U + op % ef_count);
+        if (swicc_disk_lutid_lookup(&disk, &tree, id, &file) !=
+            SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+        BENCH_KEEP(file.data);
+    }
+    bench_stop(b);
+    swicc_disk_unload(&disk);
+}
+
+/**
+ * @brief Look up EFs by SID in the MF of a disk, all EFs with a SID in turn.
+ * @param b
+ * @param ef_count Number of EFs in the disk.
+ */
+static void bench_lutsid_lookup(bench_st *const b, uint32_t const ef_count)
+{
+    swicc_disk_st disk = {0U};
+    if (bench_disk_create(&disk, ef_count) != SWICC_RET_SUCCESS)
+    {
+        bench_fail(b, "Failed to create the disk");
+        return;
+    }
+    uint32_t const sid_count = ef_count < 254U ? ef_count : 254U;
+    swicc_fs_file_st file;
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Safe cast since the SID is at most 254. */
+        swicc_fs_sid_kt const sid = (swicc_fs_sid_kt)(1U + op % sid_count);
+        if (swicc_disk_lutsid_lookup(disk.root, sid, &file) !=
+            SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+        BENCH_KEEP(file.data);
+    }
+    bench_stop(b);
+    swicc_disk_unload(&disk);
+}
+
+BENCH(disk, lutid_lookup_16)
+{
+    bench_lutid_lookup(b, 16U);
+}
+
+BENCH(disk, lutid_lookup_256)
+{
+    bench_lutid_lookup(b, 256U);
+}
+
+BENCH(disk, lutid_lookup_4096)
+{
+    bench_lutid_lookup(b, 4096U);
+}
+
+BENCH(disk, lutsid_lookup_16)
+{
+    bench_lutsid_lookup(b, 16U);
+}
+
+BENCH(disk, lutsid_lookup_256)
+{
+    bench_lutsid_lookup(b, 256U);
+}
+
+BENCH(disk, lutsid_lookup_4096)
+{
+    bench_lutsid_lookup(b, 4096U);
+}
+
+BENCH(fs, file_prs)
+{
+    swicc_disk_st disk = {0U};
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    if (bench_disk_create(&disk, 16U) != SWICC_RET_SUCCESS ||
+        swicc_disk_lutid_lookup(&disk, &tree, 0x2007, &file) !=
+            SWICC_RET_SUCCESS)
+    {
+        bench_fail(b, "Failed to create the disk");
+        swicc_disk_unload(&disk);
+        return;
+    }
+    uint32_t const offset_trel = file.hdr_item.offset_trel;
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        if (swicc_fs_file_prs(tree, offset_trel, &file) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+        BENCH_KEEP(file.data);
+    }
+    bench_stop(b);
+    swicc_disk_unload(&disk);
+}
+
+/**
+ * @brief Create a disk from one of the JSON profiles of the tests.
+ * @param b
+ * @param disk_path
+ */
+static void bench_diskjs_disk_create(bench_st *const b,
+                                     char const *const disk_path)
+{
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        swicc_disk_st disk = {0U};
+        if (swicc_diskjs_disk_create(&disk, disk_path) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+        swicc_disk_unload(&disk);
+    }
+    bench_stop(b);
+}
+
+BENCH(diskjs, disk_create_000)
+{
+    bench_diskjs_disk_create(b, "test/data/disk/000-in.json");
+}
+
+BENCH(diskjs, disk_create_003)
+{
+    bench_diskjs_disk_create(b, "test/data/disk/003-in.json");
+}
+
+BENCH(diskjs, disk_create_004)
+{
+    bench_diskjs_disk_create(b, "test/data/disk/004-in.json");
+}
+
+BENCH(diskjs, disk_create_006)
+{
+    bench_diskjs_disk_create(b, "test/data/disk/006-in.json");
+}
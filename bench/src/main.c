@@ -0,0 +1,174 @@
+#include <bench.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Maximum number of benchmarks that can be registered. */
+#define BENCH_COUNT_MAX 128U
+
+/* A run has to take at least this long (ns) for its result to be kept. */
+#define BENCH_TIME_MIN 200000000ULL
+
+/* Never do more operations than this in a run. */
+#define BENCH_N_MAX 1000000000ULL
+
+typedef struct bench_entry_s
+{
+    char const *name;
+    bench_ft *fn;
+} bench_entry_st;
+
+static bench_entry_st bench_entry[BENCH_COUNT_MAX];
+static uint32_t bench_count = 0U;
+
+/**
+ * Allocations are counted by wrapping the allocator when linking (see the
+ * Makefile) so the counter can be read at the start and stop of a run.
+ */
+static uint64_t bench_alloc_count = 0U;
+
+void *__real_malloc(size_t const size);
+void *__real_calloc(size_t const count, size_t const size);
+void *__real_realloc(void *const ptr, size_t const size);
+void *__wrap_malloc(size_t const size);
+void *__wrap_calloc(size_t const count, size_t const size);
+void *__wrap_realloc(void *const ptr, size_t const size);
+
+void *__wrap_malloc(size_t const size)
+{
+    bench_alloc_count += 1U;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t const count, size_t const size)
+{
+    bench_alloc_count += 1U;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *const ptr, size_t const size)
+{
+    bench_alloc_count += 1U;
+    return __real_realloc(ptr, size);
+}
+
+/**
+ * @brief Get the current time of a monotonic clock.
+ * @return Time in nanoseconds.
+ */
+static uint64_t bench_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void bench_register(char const *const name, bench_ft *const fn)
+{
+    if (bench_count >= BENCH_COUNT_MAX)
+    {
+        fprintf(stderr, "Too many benchmarks, '%s' is skipped.\n", name);
+        return;
+    }
+    bench_entry[bench_count++] = (bench_entry_st){.name = name, .fn = fn};
+}
+
+void bench_start(bench_st *const b)
+{
+    b->alloc_start = bench_alloc_count;
+    b->time_start = bench_time();
+}
+
+void bench_stop(bench_st *const b)
+{
+    uint64_t const time_stop = bench_time();
+    b->time += time_stop - b->time_start;
+    b->alloc += bench_alloc_count - b->alloc_start;
+}
+
+void bench_fail(bench_st *const b, char const *const reason)
+{
+    fprintf(stderr, "Benchmark failed: %s.\n", reason);
+    b->fail = true;
+}
+
+/**
+ * @brief Check if a benchmark was selected on the command line.
+ * @param name Name of the benchmark.
+ * @param argc
+ * @param argv Each argument is a prefix of the names of selected benchmarks.
+ * @return True if selected, false otherwise.
+ */
+static bool bench_selected(char const *const name, int const argc,
+                           char *const *const argv)
+{
+    if (argc <= 1)
+    {
+        return true;
+    }
+    for (int arg_idx = 1; arg_idx < argc; ++arg_idx)
+    {
+        if (strncmp(name, argv[arg_idx], strlen(argv[arg_idx])) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Runs all (or the selected) benchmarks and prints one CSV line for each so the
+ * output can be collected for tracking trends. Anything that is not a result
+ * goes to stderr.
+ */
+int main(int const argc, char *const *const argv)
+{
+    int ret = EXIT_SUCCESS;
+    printf("name,n,ns_per_op,allocs_per_op\n");
+    for (uint32_t bench_idx = 0U; bench_idx < bench_count; ++bench_idx)
+    {
+        bench_entry_st const *const entry = &bench_entry[bench_idx];
+        if (!bench_selected(entry->name, argc, argv))
+        {
+            continue;
+        }
+
+        bench_st b = {.n = 1U};
+        for (;;)
+        {
+            b.fail = false;
+            b.time = 0U;
+            b.alloc = 0U;
+            entry->fn(&b);
+            if (b.fail || b.time >= BENCH_TIME_MIN || b.n >= BENCH_N_MAX)
+            {
+                break;
+            }
+            /* Aim a bit above the minimum time, growing at most 100x. */
+            uint64_t const time_op = b.time / b.n > 0U ? b.time / b.n : 1U;
+            uint64_t n_next = (BENCH_TIME_MIN + BENCH_TIME_MIN / 5U) / time_op;
+            if (n_next > b.n * 100U)
+            {
+                n_next = b.n * 100U;
+            }
+            b.n = n_next > b.n ? n_next : b.n + 1U;
+            if (b.n > BENCH_N_MAX)
+            {
+                b.n = BENCH_N_MAX;
+            }
+        }
+
+        if (b.fail)
+        {
+            fprintf(stderr, "'%s' failed.\n", entry->name);
+            ret = EXIT_FAILURE;
+            continue;
+        }
+        printf("%s,%" PRIu64 ",%.1f,%.2f\n", entry->name, b.n,
+               (double)b.time / (double)b.n, (double)b.alloc / (double)b.n);
+        fflush(stdout);
+    }
+    return ret;
+}
@@ -0,0 +1,85 @@
+#include <arpa/inet.h>
+#include <bench.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief Create a pair of connected TCP sockets over the loopback interface.
+ * @param sock Where the 2 sockets will be written.
+ * @return True on success, false otherwise.
+ */
+static bool bench_net_sock_pair(int32_t sock[2U])
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = 0U,
+        .sin_addr = {.s_addr = htonl(INADDR_LOOPBACK)},
+    };
+    socklen_t addr_len = sizeof(addr);
+    int const sock_listen = socket(AF_INET, SOCK_STREAM, 0);
+    sock[0U] = -1;
+    sock[1U] = -1;
+    if (sock_listen < 0)
+    {
+        return false;
+    }
+    bool ok = bind(sock_listen, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+              listen(sock_listen, 1) == 0 &&
+              getsockname(sock_listen, (struct sockaddr *)&addr, &addr_len) ==
+                  0;
+    if (ok)
+    {
+        sock[0U] = socket(AF_INET, SOCK_STREAM, 0);
+        ok = sock[0U] >= 0 &&
+             connect(sock[0U], (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    }
+    if (ok)
+    {
+        sock[1U] = accept(sock_listen, NULL, NULL);
+        ok = sock[1U] >= 0;
+    }
+    close(sock_listen);
+    if (!ok)
+    {
+        for (uint8_t sock_idx = 0U; sock_idx < 2U; ++sock_idx)
+        {
+            if (sock[sock_idx] >= 0)
+            {
+                close(sock[sock_idx]);
+            }
+        }
+    }
+    return ok;
+}
+
+BENCH(net, msg_send_recv)
+{
+    int32_t sock[2U];
+    if (!bench_net_sock_pair(sock))
+    {
+        bench_fail(b, "Failed to connect over loopback");
+        return;
+    }
+    /* A short C-APDU just like the ones the server sends. */
+    static swicc_net_msg_st msg_tx;
+    static swicc_net_msg_st msg_rx;
+    memset(&msg_tx, 0U, sizeof(msg_tx));
+    msg_tx.hdr.size = offsetof(swicc_net_msg_data_st, buf) + 5U;
+    msg_tx.data.ctrl = SWICC_NET_MSG_CTRL_APDU;
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        if (swicc_net_send(sock[0U], &msg_tx) != SWICC_RET_SUCCESS ||
+            swicc_net_recv(sock[1U], &msg_rx) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    close(sock[0U]);
+    close(sock[1U]);
+}
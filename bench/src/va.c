@@ -0,0 +1,169 @@
+#include <bench.h>
+#include <string.h>
+
+/* Bytes of the AID of the first ADF of the disk used by the ADF benchmarks. */
+static uint8_t const bench_va_aid[] = {0xF6, 0x18, 0xF6, 0x86, 0x9D, 0x19,
+                                       0x4B, 0xAD, 0x83, 0xD1, 0x07, 0x62,
+                                       0x2B, 0x92, 0x0D, 0x04};
+
+/**
+ * @brief Prepare the FS for a VA benchmark.
+ * @param b
+ * @param fs
+ * @param disk_path Disk to load, NULL for a generated one with 16 EFs.
+ * @param fid File to select before starting.
+ * @return True on success, false otherwise.
+ */
+static bool bench_va_fs(bench_st *const b, swicc_fs_st *const fs,
+                        char const *const disk_path, swicc_fs_id_kt const fid)
+{
+    memset(fs, 0U, sizeof(*fs));
+    swicc_ret_et const ret =
+        disk_path == NULL ? bench_disk_create(&fs->disk, 16U)
+                          : swicc_diskjs_disk_create(&fs->disk, disk_path);
+    if (ret != SWICC_RET_SUCCESS ||
+        swicc_va_select_file_id(fs, fid) != SWICC_RET_SUCCESS)
+    {
+        bench_fail(b, "Failed to prepare the FS");
+        swicc_disk_unload(&fs->disk);
+        return false;
+    }
+    return true;
+}
+
+BENCH(va, select_adf)
+{
+    static swicc_fs_st fs;
+    if (!bench_va_fs(b, &fs, "test/data/disk/006-in.json", 0xE7C7))
+    {
+        return;
+    }
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        if (swicc_va_select_adf(&fs, bench_va_aid, sizeof(bench_va_aid) - 5U) !=
+            SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    swicc_disk_unload(&fs.disk);
+}
+
+BENCH(va, select_file_dfname)
+{
+    static swicc_fs_st fs;
+    if (!bench_va_fs(b, &fs, NULL, 0x3F00))
+    {
+        return;
+    }
+    uint8_t const df_name[] = {'M', 'F'};
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        if (swicc_va_select_file_dfname(&fs, df_name, sizeof(df_name)) !=
+            SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    swicc_disk_unload(&fs.disk);
+}
+
+BENCH(va, select_file_id)
+{
+    static swicc_fs_st fs;
+    if (!bench_va_fs(b, &fs, NULL, 0x3F00))
+    {
+        return;
+    }
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Safe cast since the ID is at most 0x200F. */
+        swicc_fs_id_kt const fid = (swicc_fs_id_kt)(0x2000U + op % 16U);
+        if (swicc_va_select_file_id(&fs, fid) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    swicc_disk_unload(&fs.disk);
+}
+
+BENCH(va, select_file_sid)
+{
+    static swicc_fs_st fs;
+    if (!bench_va_fs(b, &fs, NULL, 0x3F00))
+    {
+        return;
+    }
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Safe cast since the SID is at most 16. */
+        swicc_fs_sid_kt const sid = (swicc_fs_sid_kt)(1U + op % 16U);
+        if (swicc_va_select_file_sid(&fs, sid) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    swicc_disk_unload(&fs.disk);
+}
+
+BENCH(va, select_file_path)
+{
+    static swicc_fs_st fs;
+    if (!bench_va_fs(b, &fs, NULL, 0x3F00))
+    {
+        return;
+    }
+    swicc_fs_id_kt path_buf[1U];
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Safe cast since the ID is at most 0x200F. */
+        path_buf[0U] = (swicc_fs_id_kt)(0x2000U + op % 16U);
+        swicc_fs_path_st const path = {
+            .type = SWICC_FS_PATH_TYPE_MF,
+            .b = path_buf,
+            .len = 1U,
+        };
+        if (swicc_va_select_file_path(&fs, path) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    swicc_disk_unload(&fs.disk);
+}
+
+BENCH(va, select_record_idx)
+{
+    static swicc_fs_st fs;
+    if (!bench_va_fs(b, &fs, "test/data/disk/006-in.json", 0xE99D))
+    {
+        return;
+    }
+    bench_start(b);
+    for (uint64_t op = 0U; op < b->n; ++op)
+    {
+        /* Safe cast since the file has 3 records. */
+        swicc_fs_rcrd_idx_kt const idx = (swicc_fs_rcrd_idx_kt)(op % 3U);
+        if (swicc_va_select_record_idx(&fs, idx) != SWICC_RET_SUCCESS)
+        {
+            b->fail = true;
+            break;
+        }
+    }
+    bench_stop(b);
+    swicc_disk_unload(&fs.disk);
+}
@@ -0,0 +1,127 @@
+#pragma once
+/**
+ * Hooks for allocating memory so that everything a disk owns (trees, LUTs,
+ * descriptors, indexes, overlays...) can come from a place chosen per disk
+ * instead of the heap of the C library, e.g. from an arena which is freed in
+ * one operation and whose chunks are taken from huge pages or from memory that
+ * is local to a NUMA node. A NULL allocator means the C library is used.
+ *
+ * Only memory kept by a disk (or by a dedup store) comes from its allocator.
+ * Scratch memory which only lives until an operation is done, e.g. an index
+ * being read, the jobs of the batch loader, or staged transactions, and memory
+ * owned by something else like snapshot buffers, always comes from the C
+ * library since an arena would only release it together with the disk.
+ *
+ * @note Hooks can get called from several threads at once, e.g. when a disk is
+ * compiled from JSON by several workers, so they must be thread-safe.
+ */
+
+#include "swicc/common.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+typedef void *swicc_alloc_malloc_ft(void *const ctx, size_t const size);
+
+/**
+ * Same as 'realloc' of the C library but also gets how large the allocation
+ * was so an allocator which does not track sizes can copy it.
+ */
+typedef void *swicc_alloc_realloc_ft(void *const ctx, void *const ptr,
+                                     size_t const size_old, size_t const size);
+typedef void swicc_alloc_free_ft(void *const ctx, void *const ptr);
+
+typedef struct swicc_alloc_s
+{
+    swicc_alloc_malloc_ft *malloc;
+    swicc_alloc_realloc_ft *realloc;
+    /**
+     * NULL when allocations are never freed one by one (e.g. an arena), then
+     * they are only released together with the allocator.
+     */
+    swicc_alloc_free_ft *free;
+    void *ctx; /* Passed to every hook. */
+} swicc_alloc_st;
+
+/* Chunks of an arena are at least this large. */
+#define SWICC_ALLOC_ARENA_CHUNK_SIZE_MIN 4096U
+
+typedef struct swicc_alloc_arena_chunk_s swicc_alloc_arena_chunk_st;
+struct swicc_alloc_arena_chunk_s
+{
+    swicc_alloc_arena_chunk_st *next;
+    size_t size; /* Usable bytes after the header. */
+    size_t used;
+};
+
+/**
+ * A bump allocator. Allocations are carved out of large chunks and are only
+ * ever released all at once. The last allocation can grow in place.
+ */
+typedef struct swicc_alloc_arena_s
+{
+    /* Hooks which allocate from this arena, e.g. to be given to a disk. */
+    swicc_alloc_st alloc;
+
+    /* Where chunks come from, NULL for the C library. */
+    swicc_alloc_st const *backing;
+    size_t chunk_size;
+    swicc_alloc_arena_chunk_st *chunk; /* The current chunk comes first. */
+    void *last;                        /* Last allocation of the chunk. */
+    atomic_flag lock;                  /* Held while allocating. */
+} swicc_alloc_arena_st;
+
+/**
+ * @brief Allocate memory.
+ * @param[in] alloc NULL for the C library.
+ * @param[in] size
+ * @return The memory or NULL on failure.
+ */
+void *swicc_alloc_malloc(swicc_alloc_st const *const alloc, size_t const size);
+
+/**
+ * @brief Allocate zeroed memory for an array.
+ * @param[in] alloc NULL for the C library.
+ * @param[in] count
+ * @param[in] size Size of an element.
+ * @return The memory or NULL on failure.
+ */
+void *swicc_alloc_calloc(swicc_alloc_st const *const alloc, size_t const count,
+                         size_t const size);
+
+/**
+ * @brief Resize an allocation. On failure, the old allocation is kept.
+ * @param[in] alloc NULL for the C library.
+ * @param[in] ptr NULL to allocate.
+ * @param[in] size_old Size the allocation currently has.
+ * @param[in] size
+ * @return The memory or NULL on failure.
+ */
+void *swicc_alloc_realloc(swicc_alloc_st const *const alloc, void *const ptr,
+                          size_t const size_old, size_t const size);
+
+/**
+ * @brief Free an allocation (if the allocator frees one by one).
+ * @param[in] alloc NULL for the C library.
+ * @param[in] ptr Can be NULL.
+ */
+void swicc_alloc_free(swicc_alloc_st const *const alloc, void *const ptr);
+
+/**
+ * @brief Create an empty arena.
+ * @param[out] arena
+ * @param[in] backing Where chunks are allocated from, NULL for the C library.
+ * It must free chunks one by one.
+ * @param[in] chunk_size Size of chunks, larger allocations get a chunk sized
+ * to fit. Raised to the minimum when smaller.
+ * @return Return code.
+ */
+swicc_ret_et swicc_alloc_arena_init(swicc_alloc_arena_st *const arena,
+                                    swicc_alloc_st const *const backing,
+                                    size_t const chunk_size);
+
+/**
+ * @brief Release everything that was allocated from an arena at once. The
+ * arena is empty and can be used again afterwards.
+ * @param[in, out] arena
+ */
+void swicc_alloc_arena_free(swicc_alloc_arena_st *const arena);
@@ -148,6 +148,13 @@ typedef struct swicc_apdu_res_s
     swicc_apdu_sw1_et sw1;
     uint8_t sw2;
     swicc_apdu_data_st data;
+
+    /**
+     * When not NULL, the response data is borrowed from here (e.g. straight
+     * from file data) instead of being in the data buffer, the length is still
+     * the one in data. It must stay valid until the response is sent.
+     */
+    uint8_t const *data_ref;
 } swicc_apdu_res_st;
 
 /**
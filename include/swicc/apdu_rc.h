@@ -8,16 +8,46 @@
 
 #include "swicc/common.h"
 
+/* Maximum number of separately enqueued parts of a chained response. */
+#define SWICC_APDU_RC_SEG_COUNT_MAX 8U
+
+/* One part of the chained response. */
+typedef struct swicc_apdu_rc_seg_s
+{
+    /**
+     * Borrowed data or NULL when the data was copied into the RC buffer at the
+     * offset.
+     */
+    uint8_t const *ref;
+    uint32_t offset;
+    uint32_t len;
+} swicc_apdu_rc_seg_st;
+
 /**
  * Contains all data for managing and storing the response chaining (RC) buffer.
  */
 typedef struct swicc_apdu_rc_s
 {
-    uint8_t b[SWICC_DATA_MAX];
-    uint32_t len;
+    /**
+     * Holds copied data. Borrowed from the pool of the thread on the first copy
+     * and grown as needed up to an extended response length.
+     */
+    uint8_t *b;
+    uint32_t size;
+    uint32_t b_len;
+
+    /* The response is the concatenation of all segments. */
+    swicc_apdu_rc_seg_st seg[SWICC_APDU_RC_SEG_COUNT_MAX];
+    uint32_t seg_count;
+
+    uint32_t len; /* Total length of all segments. */
 
     /* How much of the data was already returned to the interface. */
     uint32_t offset;
+    uint32_t seg_cur;        /* Segment which contains the offset. */
+    uint32_t seg_cur_offset; /* Offset inside of the current segment. */
+
+    bool b_pooled; /* If the buffer was borrowed from the pool. */
 } swicc_apdu_rc_st;
 
 /**
@@ -28,20 +58,46 @@ typedef struct swicc_apdu_rc_s
  * command is run in between GET RESPONSE instructions, is undefined. By
  * resetting the buffer at the start of instructions, the behavior can be made
  * deterministic i.e. resuming response chaining would always fail.
+ * @note A short buffer is given back to the pool of the thread (see
+ * 'swicc_pool_thread') so an idle card does not hold one, a larger buffer is
+ * kept allocated for the next response.
  */
 void swicc_apdu_rc_reset(swicc_apdu_rc_st *const rc);
 
+/**
+ * @brief Free the response chaining buffer.
+ * @param[in, out] rc
+ */
+void swicc_apdu_rc_free(swicc_apdu_rc_st *const rc);
+
 /**
  * @brief Enqueue data in the RC buffer.
  * @param[in, out] rc
  * @param[in] buf Shall contain the data to enqueue.
  * @param[in] buf_len Shall contain the length of the buffer.
- * @return Return code.
+ * @return Return code. Buffer too short when all enqueued data would not fit in
+ * an extended response.
  */
 swicc_ret_et swicc_apdu_rc_enq(swicc_apdu_rc_st *const rc,
                                uint8_t const *const buf,
                                uint32_t const buf_len);
 
+/**
+ * @brief Enqueue data in the RC buffer without copying it.
+ * @param[in, out] rc
+ * @param[in] buf Data to enqueue. It must stay unchanged until the RC buffer
+ * is reset.
+ * @param[in] buf_len Length of the data.
+ * @return Return code. Buffer too short when all enqueued data would not fit in
+ * an extended response or when there are too many segments.
+ * @note Any command other than GET RESPONSE resets the RC buffer before it is
+ * handled, so e.g. file data can be borrowed since it can only be modified by
+ * another command.
+ */
+swicc_ret_et swicc_apdu_rc_enq_ref(swicc_apdu_rc_st *const rc,
+                                   uint8_t const *const buf,
+                                   uint32_t const buf_len);
+
 /**
  * @brief Dequeue data from the RC buffer.
  * @param[in, out] rc
@@ -56,6 +112,19 @@ swicc_ret_et swicc_apdu_rc_enq(swicc_apdu_rc_st *const rc,
 swicc_ret_et swicc_apdu_rc_deq(swicc_apdu_rc_st *const rc, uint8_t *const buf,
                                uint32_t *const buf_len);
 
+/**
+ * @brief Dequeue data from the RC buffer without copying it, which is only
+ * possible when the requested data is contiguous.
+ * @param[in, out] rc
+ * @param[out] buf Where the pointer to the dequeued data will be written.
+ * @param[in] buf_len Requested length.
+ * @return Return code. Buffer too short when less data is available and error
+ * when the data is split across segments, in both cases nothing is dequeued.
+ */
+swicc_ret_et swicc_apdu_rc_deq_ref(swicc_apdu_rc_st *const rc,
+                                   uint8_t const **const buf,
+                                   uint32_t const buf_len);
+
 /**
  * @brief Return how much data is left in the RC buffer.
  * @param[in] rc
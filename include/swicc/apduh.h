@@ -7,6 +7,16 @@
 
 #include "swicc/apdu.h"
 #include "swicc/common.h"
+#include "swicc/fs/common.h"
+
+/* Number of possible instructions, i.e. entries in a handler table. */
+#define SWICC_APDUH_INS_COUNT 256U
+
+/**
+ * Number of CLA types that have a handler table. Only the interindustry and
+ * proprietary classes can have handlers.
+ */
+#define SWICC_APDUH_CLA_TYPE_COUNT 2U
 
 /**
  * APDU handlers often set SW1, SW2, and data length just before returning. This
@@ -20,6 +30,44 @@
     }                                                                          \
     while (0)
 
+/* Size of the space for decoded parameters in a handler context. */
+#define SWICC_APDUH_CTX_PARAM_SIZE 16U
+
+/**
+ * A handler that responds with procedure bytes gets called again for every
+ * phase of the command. What it decoded and looked up in the first phase can be
+ * kept here so the later phases can continue from it. The context is
+ * invalidated before the first phase of every command.
+ */
+typedef struct swicc_apduh_ctx_s
+{
+    bool valid; /* Set by the handler once it stored its state. */
+
+    /* Header of the command this context belongs to. Set by the demux. */
+    uint8_t cla_raw;
+    uint8_t ins;
+    uint8_t p1;
+    uint8_t p2;
+
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    uint8_t param[SWICC_APDUH_CTX_PARAM_SIZE];
+} swicc_apduh_ctx_st;
+
+/**
+ * A C-APDU that is handled from start to end without procedure bytes going to
+ * the interface, e.g. when it came in one go over T=1 or is executed directly
+ * by the host.
+ */
+typedef struct swicc_apduh_exec_s
+{
+    uint16_t lc; /* Cleared when the command becomes a GET RESPONSE. */
+    bool le;     /* If the C-APDU has Le. */
+
+    /* Length of the R-APDU collected so far. */
+    uint16_t rapdu_len;
+} swicc_apduh_exec_st;
+
 /**
  * @brief APDU handler.
  * @param[in, out] swicc_state
@@ -41,18 +89,33 @@ typedef swicc_ret_et swicc_apduh_ft(swicc_st *const swicc_state,
 /**
  * @brief All APDUs in the proprietary class require non-interindustry
  * implementations for handlers. The handler passed to this function is the
- * function that will get these proprietary messages and is expected to handle
- * them.
+ * function that will get the proprietary messages which have no handler
+ * registered for their instruction and is expected to handle them.
  * @param[in, out] swicc_state
- * @param[in] handler Handler for all proprietary messages. An attempt to handle
- * interindustry messages using the proprietary handler will be done before
- * running interindustry handlers in order to give a chance to override the
- * default implementastion.
+ * @param[in] handler Handler for proprietary messages.
  * @return Return code.
+ * @note Interindustry messages are never passed to this handler, use
+ * swicc_apduh_register to override the default implementation of one
+ * instruction.
  */
 swicc_ret_et swicc_apduh_pro_register(swicc_st *const swicc_state,
                                       swicc_apduh_ft *const handler);
 
+/**
+ * @brief Register the handler of one instruction of a class.
+ * @param[in, out] swicc_state
+ * @param[in] cla_type Interindustry or proprietary.
+ * @param[in] ins Instruction to handle.
+ * @param[in] handler Handler for this instruction or NULL to remove the one
+ * registered before. In the interindustry class, returning unhandled from the
+ * handler lets the default implementation handle the message.
+ * @return Return code.
+ */
+swicc_ret_et swicc_apduh_register(swicc_st *const swicc_state,
+                                  swicc_apdu_cla_type_et const cla_type,
+                                  uint8_t const ins,
+                                  swicc_apduh_ft *const handler);
+
 /**
  * @brief In some cases, the user may want to override what the card sends back
  * to the terminal even if the command received is handled completely within an
@@ -67,6 +130,18 @@ swicc_ret_et swicc_apduh_pro_register(swicc_st *const swicc_state,
 swicc_ret_et swicc_apduh_override_register(swicc_st *const swicc_state,
                                            swicc_apduh_ft *const handler);
 
+/**
+ * @brief Signal that the external operation, which a handler is waiting on
+ * after returning pending, has completed. The FSM will call the handler again
+ * with the same command and the same procedure count. Until then, it keeps
+ * sending NULL procedure bytes to the terminal.
+ * @param[in, out] swicc_state
+ * @note Safe to call from any thread. The handler context is kept so a handler
+ * can tell it is being resumed. A resumed handler may return pending again,
+ * e.g. if the result it expects is not there.
+ */
+void swicc_apduh_pending_complete(swicc_st *const swicc_state);
+
 /**
  * @brief Handle all APDUs.
  */
@@ -75,3 +150,66 @@ swicc_ret_et swicc_apduh_demux(swicc_st *const swicc_state,
                                swicc_apdu_cmd_st const *const cmd,
                                swicc_apdu_res_st *const res,
                                uint32_t const procedure_count);
+
+/**
+ * @brief Parse a C-APDU into the current command and get ready for handling it
+ * with 'swicc_apduh_exec_handle'. Handlers get the command like a T=0 TPDU so
+ * they need no knowledge of how it got to the card.
+ * @param[in, out] swicc_state
+ * @param[in] capdu
+ * @param[in] capdu_len
+ * @return Return code. Param bad if the C-APDU has an invalid length.
+ * @note Only short length fields are supported.
+ */
+swicc_ret_et swicc_apduh_exec_cmd_set(swicc_st *const swicc_state,
+                                      uint8_t const *const capdu,
+                                      uint16_t const capdu_len);
+
+/**
+ * @brief Run the handler of the current command until it has a response. The
+ * data is given to the handler as soon as it acknowledges and bytes available
+ * are retrieved with GET RESPONSE (when the C-APDU has Le) so the R-APDU
+ * contains the response data right away.
+ * @param[in, out] swicc_state
+ * @param[out] rapdu Where the R-APDU (data followed by SW1 and SW2) will be
+ * written. It gets written in parts so it must be the same buffer until a
+ * response is ready.
+ * @param[in] rapdu_size Size of the R-APDU buffer, at least 2.
+ * @return Pending if the handler is waiting for an external operation, success
+ * once the R-APDU is ready. Its length is in the exec state of the internals.
+ */
+swicc_ret_et swicc_apduh_exec_handle(swicc_st *const swicc_state,
+                                     uint8_t *const rapdu,
+                                     uint16_t const rapdu_size);
+
+/**
+ * @brief Perform a whole command-response exchange with the card logic in one
+ * call, without any transmission protocol i.e. neither the FSM nor the network
+ * are involved. Outgoing data gets retrieved with GET RESPONSE like on T=1.
+ * @param[in, out] swicc_state
+ * @param[in] capdu The C-APDU (header, then Lc and data, then Le).
+ * @param[in] capdu_len Length of the C-APDU.
+ * @param[out] rapdu Where to write the R-APDU (data followed by SW1 and SW2).
+ * @param[in, out] rapdu_len Must contain the size of the R-APDU buffer.
+ * Receives the length of the R-APDU on success.
+ * @return Return code. Pending if a handler waits for an external operation in
+ * which case the exchange is finished with 'swicc_apduh_exec_resume'.
+ * @note Must not be used while a command is being exchanged through the FSM
+ * since they share the current command.
+ */
+swicc_ret_et swicc_apduh_exec(swicc_st *const swicc_state,
+                              uint8_t const *const capdu,
+                              uint16_t const capdu_len, uint8_t *const rapdu,
+                              uint16_t *const rapdu_len);
+
+/**
+ * @brief Continue an exchange started with 'swicc_apduh_exec' that is pending.
+ * @param[in, out] swicc_state
+ * @param[out] rapdu Same R-APDU buffer as given when starting the exchange.
+ * @param[in, out] rapdu_len Same as for 'swicc_apduh_exec'.
+ * @return Return code. Pending again until the external operation completed
+ * (see 'swicc_apduh_pending_complete').
+ */
+swicc_ret_et swicc_apduh_exec_resume(swicc_st *const swicc_state,
+                                     uint8_t *const rapdu,
+                                     uint16_t *const rapdu_len);
@@ -0,0 +1,146 @@
+#pragma once
+/**
+ * Binary capture of the traffic of a card which can be replayed offline. A card
+ * only captures when it was given a capture (see 'capture' of the swICC state),
+ * then every command gets recorded as the C-APDU seen by the handlers and the
+ * R-APDU they returned, along with when it arrived and how long it took. Resets
+ * are recorded too so a replay goes through the same states of the card.
+ *
+ * A capture file starts with a header holding the identity of the disk the
+ * card was using when the capture started, followed by records. The C-APDU of
+ * a record is the header and P3 followed by the data (if any), the R-APDU is
+ * the data followed by SW1 and SW2. Procedure bytes are not recorded.
+ */
+
+#include "swicc/apdu.h"
+#include "swicc/common.h"
+#include "swicc/fs/disk.h"
+
+#define SWICC_CAPTURE_MAGIC "SWICCCAP"
+#define SWICC_CAPTURE_VERSION 1U
+
+/* Records are written out in chunks of this size. */
+#define SWICC_CAPTURE_BUF_SIZE 65536U
+
+/* Longest C-APDU and R-APDU of a record. */
+#define SWICC_CAPTURE_CAPDU_LEN_MAX                                            \
+    (sizeof(swicc_apdu_cmd_hdr_raw_st) + 1U + SWICC_DATA_MAX)
+#define SWICC_CAPTURE_RAPDU_LEN_MAX (SWICC_DATA_MAX + 2U)
+
+typedef enum swicc_capture_rcrd_type_e
+{
+    SWICC_CAPTURE_RCRD_TYPE_INVALID = 0,
+    SWICC_CAPTURE_RCRD_TYPE_APDU,  /* A command and its response. */
+    SWICC_CAPTURE_RCRD_TYPE_RESET, /* The card was reset. */
+} swicc_capture_rcrd_type_et;
+
+typedef struct swicc_capture_hdr_raw_s
+{
+    char magic[sizeof(SWICC_CAPTURE_MAGIC) - 1U];
+    uint16_t version;
+    uint64_t disk_id; /* See 'swicc_capture_disk_id'. */
+} __attribute__((packed)) swicc_capture_hdr_raw_st;
+
+/**
+ * Every record starts with this header and is followed by the bytes of the
+ * C-APDU then the ones of the R-APDU.
+ */
+typedef struct swicc_capture_rcrd_hdr_raw_s
+{
+    uint8_t type; /* One of swicc_capture_rcrd_type_et. */
+    uint16_t capdu_len;
+    uint16_t rapdu_len;
+    uint64_t time;     /* Since the start of the capture in nanoseconds. */
+    uint32_t duration; /* From the header to the response in nanoseconds. */
+} __attribute__((packed)) swicc_capture_rcrd_hdr_raw_st;
+
+typedef struct swicc_capture_s
+{
+    int32_t fd;
+    /* Set when writing failed, the records after that are lost. */
+    bool failed;
+    uint64_t time_start;
+    uint64_t time_cmd; /* When the header of the current command arrived. */
+    uint32_t buf_len;
+    uint8_t buf[SWICC_CAPTURE_BUF_SIZE];
+} swicc_capture_st;
+
+/* Outcome of a replay. */
+typedef struct swicc_capture_replay_s
+{
+    uint64_t cmd_count;
+    uint64_t reset_count;
+    uint64_t mismatch_count;
+    /* Index of the record of the first mismatch (if there was any). */
+    uint64_t mismatch_first;
+
+    /**
+     * Time spent by the card on the commands during the replay, and during
+     * the capture, in nanoseconds.
+     */
+    uint64_t time_replay;
+    uint64_t time_capture;
+} swicc_capture_replay_st;
+
+/**
+ * @brief Compute the identity of a disk, i.e. a hash (64-bit FNV-1a) of the
+ * content of all its trees.
+ * @param[in] disk
+ * @param[out] disk_id
+ * @return Return code.
+ */
+swicc_ret_et swicc_capture_disk_id(swicc_disk_st const *const disk,
+                                   uint64_t *const disk_id);
+
+/**
+ * @brief Create a capture file. Any existing file is truncated.
+ * @param[out] capture
+ * @param[in] disk Disk the card is using.
+ * @param[in] capture_path
+ * @return Return code.
+ * @note For a replay to start from the same state, the card should be reset
+ * right after this.
+ */
+swicc_ret_et swicc_capture_open(swicc_capture_st *const capture,
+                                swicc_disk_st const *const disk,
+                                char const *const capture_path);
+
+/**
+ * @brief Write out the pending records and close the capture file.
+ * @param[in, out] capture
+ * @return Return code. Error also when records were lost while capturing.
+ */
+swicc_ret_et swicc_capture_close(swicc_capture_st *const capture);
+
+/**
+ * @brief Record a command and its response.
+ * @param[in, out] capture
+ * @param[in] cmd
+ * @param[in] res Must not be a procedure.
+ * @param[in] time When the response was produced (see 'swicc_stats_time').
+ */
+void swicc_capture_apdu(swicc_capture_st *const capture,
+                        swicc_apdu_cmd_st const *const cmd,
+                        swicc_apdu_res_st const *const res,
+                        uint64_t const time);
+
+/**
+ * @brief Record a reset of the card.
+ * @param[in, out] capture
+ */
+void swicc_capture_reset(swicc_capture_st *const capture);
+
+/**
+ * @brief Feed a capture back to a card as fast as possible and compare the
+ * responses of the card with the captured ones.
+ * @param[in, out] swicc_state The card must be using the same disk (in the
+ * same state) as when the capture started.
+ * @param[in] capture_path
+ * @param[out] replay Receives the outcome of the replay.
+ * @return Return code. Error when the disk is not the one of the capture.
+ * Pending when a handler that waits for an external operation did not complete
+ * within about 100ms, the replay stops at that command.
+ */
+swicc_ret_et swicc_capture_replay(swicc_st *const swicc_state,
+                                  char const *const capture_path,
+                                  swicc_capture_replay_st *const replay);
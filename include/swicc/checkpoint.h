@@ -0,0 +1,66 @@
+#pragma once
+/**
+ * Checkpoints of a whole card (the state of the swICC framework, the VAs of
+ * all logical channels, and the contents of the disk) so that a card can be
+ * put back into a known state without replaying the activation, ATR, and PPS
+ * and without reloading the disk. Capturing copies the whole disk once while
+ * restoring only writes back the pages that are marked as modified, so it costs
+ * as much as the modifications and not as the whole disk.
+ */
+
+#include "swicc/common.h"
+#include "swicc/fs/disk.h"
+
+/* Contents of a tree as they were when the checkpoint was captured. */
+typedef struct swicc_checkpoint_tree_s
+{
+    swicc_disk_tree_st *tree;
+    uint32_t len;
+    uint8_t *buf;
+} swicc_checkpoint_tree_st;
+
+typedef struct swicc_checkpoint_s
+{
+    /**
+     * Copy of the card state. The RC buffer of the copy is owned by the
+     * checkpoint.
+     */
+    swicc_st *state;
+
+    swicc_checkpoint_tree_st *tree;
+    uint32_t tree_count;
+} swicc_checkpoint_st;
+
+/**
+ * @brief Capture the state of a card and the contents of its disk.
+ * @param[out] checkpoint
+ * @param[in] swicc_state
+ * @return Return code.
+ * @note The dirty state of the trees is left as it is. Anything modified after
+ * the dirty state was last cleared gets written back on restore so it must not
+ * be cleared (e.g. by capturing a snapshot) while the checkpoint is in use.
+ */
+swicc_ret_et swicc_checkpoint_capture(swicc_checkpoint_st *const checkpoint,
+                                      swicc_st const *const swicc_state);
+
+/**
+ * @brief Put a card back into the state it was in when the checkpoint was
+ * captured. Only the pages of the disk that are marked as modified get written
+ * back.
+ * @param[in] checkpoint
+ * @param[in, out] swicc_state The same card the checkpoint was captured from,
+ * with the same disk still loaded.
+ * @return Return code.
+ * @note The registered handlers, trace, userdata, and IO buffers are not part
+ * of a checkpoint and are kept as they are. Nothing is sent to the interface
+ * after a restore and the card expects the same length of data as it did at
+ * the time of the capture. The restored bytes are not journaled.
+ */
+swicc_ret_et swicc_checkpoint_restore(
+    swicc_checkpoint_st const *const checkpoint, swicc_st *const swicc_state);
+
+/**
+ * @brief Free all memory used by a checkpoint.
+ * @param[in, out] checkpoint
+ */
+void swicc_checkpoint_free(swicc_checkpoint_st *const checkpoint);
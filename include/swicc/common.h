@@ -7,7 +7,7 @@
  * @warning Only short APDUs are supported for now.
  */
 #define SWICC_DATA_MAX_SHRT 256U
-// #define SWICC_DATA_MAX_LONG 65536U
+#define SWICC_DATA_MAX_LONG 65536U
 #define SWICC_DATA_MAX SWICC_DATA_MAX_SHRT
 
 /**
@@ -43,6 +43,18 @@ typedef enum swicc_ret_e
                                        server. */
     SWICC_RET_NET_DISCONNECTED, /* Client connected to server and exchanged at
                                    least 1 message before getting an error. */
+    SWICC_RET_NET_MSG_INCOMPLETE, /* Not enough data was received to contain
+                                     a whole message. */
+
+    SWICC_RET_TRACE_EMPTY, /* There are no trace events to take. */
+
+    SWICC_RET_SNAPSHOT_BUSY,  /* All snapshot buffers are still being used. */
+    SWICC_RET_SNAPSHOT_EMPTY, /* There are no captured snapshots to write. */
+
+    SWICC_RET_FS_SWAP_PENDING, /* A disk swap was not done yet. */
+
+    SWICC_RET_APDU_PENDING, /* Handler waits for an external operation to
+                               complete and shall be called again after. */
 } swicc_ret_et;
 
 /**
@@ -52,6 +64,7 @@ typedef struct swicc_s swicc_st;
 typedef struct swicc_fs_file_s swicc_fs_file_st;
 typedef enum swicc_fsm_state_e swicc_fsm_state_et;
 typedef struct swicc_net_msg_s swicc_net_msg_st;
+typedef struct swicc_tp_s swicc_tp_st;
 
 /**
  * @brief Compute the elementary time unit (ETU) as described in ISO/IEC
@@ -89,6 +102,21 @@ swicc_ret_et swicc_hexstr_bytearr(char const *const hexstr,
                                   uint8_t *const bytearr,
                                   uint32_t *const bytearr_len);
 
+/**
+ * @brief Find the first occurrence of a byte string in a buffer.
+ * @param[in] buf
+ * @param[in] buf_len
+ * @param[in] pat The byte string to look for.
+ * @param[in] pat_len Length of the byte string. An empty one is found at the
+ * start of the buffer.
+ * @param[out] offset Where the offset of the occurrence in the buffer will be
+ * written.
+ * @return Return code. Not found if the buffer does not contain the string.
+ */
+swicc_ret_et swicc_mem_find(uint8_t const *const buf, uint32_t const buf_len,
+                            uint8_t const *const pat, uint32_t const pat_len,
+                            uint32_t *const offset);
+
 /**
  * @brief Perform a hard reset of the swICC state. After this, swICC will behave
  * as if it was just created.
@@ -0,0 +1,42 @@
+#pragma once
+/**
+ * CRC32C (Castagnoli) checksums, e.g. for detecting corrupted trees of a disk
+ * file. The CRC instructions of SSE4.2 (x86-64) and ARMv8 are used when the CPU
+ * has them, otherwise a table-driven implementation is used. Checksums of parts
+ * can be combined into the checksum of the whole without reading the parts
+ * again.
+ */
+
+#include "swicc/common.h"
+
+/**
+ * @brief Continue a checksum over some bytes.
+ * @param[in] crc Checksum of the preceding bytes, 0 for the first ones.
+ * @param[in] buf
+ * @param[in] len
+ * @return Checksum of the preceding bytes followed by these ones.
+ */
+uint32_t swicc_crc32c(uint32_t const crc, uint8_t const *const buf,
+                      uint32_t const len);
+
+/**
+ * @brief Create the operator for combining the checksum of some bytes with the
+ * checksum of the bytes that follow them, for a given length of the bytes that
+ * follow. Creating it takes longer than applying it so it can be created once
+ * for many parts of the same length.
+ * @param[in] len_b Length of the bytes that follow.
+ * @return Operator to give to 'swicc_crc32c_combine_op'.
+ */
+uint32_t swicc_crc32c_combine_gen(uint32_t const len_b);
+
+/**
+ * @brief Combine the checksums of 2 consecutive parts into the checksum of
+ * both.
+ * @param[in] crc_a Checksum of the first part.
+ * @param[in] crc_b Checksum of the second part.
+ * @param[in] op Operator created for the length of the second part using
+ * 'swicc_crc32c_combine_gen'.
+ * @return Checksum of the first part followed by the second part.
+ */
+uint32_t swicc_crc32c_combine_op(uint32_t const crc_a, uint32_t const crc_b,
+                                 uint32_t const op);
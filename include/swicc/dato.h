@@ -36,6 +36,7 @@
  * caller is given all information necessary to implement recursion themselves.
  */
 
+#include "swicc/alloc.h"
 #include "swicc/common.h"
 #include <assert.h>
 
@@ -133,6 +134,18 @@ typedef struct swicc_dato_bertlv_enc_s
 swicc_ret_et swicc_dato_bertlv_tag_create(
     swicc_dato_bertlv_tag_st *const bertlv_tag_out, uint32_t const tag);
 
+/**
+ * @brief Parse a BER-TLV tag (without the length and value).
+ * @param[out] bertlv_tag_out Where to store the parsed BER-TLV tag.
+ * @param[out] tag_len Where the length of the raw tag will be written.
+ * @param[in] tag_buf Buffer starting with the raw tag.
+ * @param[in] tag_buf_len Length of the buffer.
+ * @return Return code.
+ */
+swicc_ret_et swicc_dato_bertlv_tag_prs(
+    swicc_dato_bertlv_tag_st *const bertlv_tag_out, uint32_t *const tag_len,
+    uint8_t const *const tag_buf, uint32_t const tag_buf_len);
+
 /**
  * @brief Initialize decoding operation on a buffer containing an encoded
  * BER-TLV DO.
@@ -221,3 +234,110 @@ swicc_ret_et swicc_dato_bertlv_enc_hdr(
 swicc_ret_et swicc_dato_bertlv_enc_data(swicc_dato_bertlv_enc_st *const encoder,
                                         uint8_t const *const data,
                                         uint32_t const data_len);
+
+/* Parent index of the DOs at the root level of a buffer. */
+#define SWICC_DATO_BERTLV_NODE_PARENT_ROOT UINT32_MAX
+
+/* Deepest nesting of constructed DOs that can be decoded in bulk. */
+#define SWICC_DATO_BERTLV_DEPTH_MAX 16U
+
+/* One DO of a buffer decoded in bulk. */
+typedef struct swicc_dato_bertlv_node_s
+{
+    swicc_dato_bertlv_tag_st tag;
+    uint32_t depth;      /* 0 for DOs at the root level. */
+    uint32_t parent_idx; /* Node of the constructed DO containing this one. */
+    uint32_t offset;     /* Offset of the header in the buffer. */
+    uint32_t len_hdr;
+    uint32_t len_val;
+} swicc_dato_bertlv_node_st;
+
+/**
+ * Index of all DOs contained in a buffer (including nested ones) for finding a
+ * DO by its parent and tag without decoding the buffer again. When several DOs
+ * with the same tag share a parent, the first one is found.
+ */
+typedef struct swicc_dato_bertlv_idx_s
+{
+    /* All DOs in the order they appear in the buffer. */
+    swicc_dato_bertlv_node_st *node;
+    uint32_t node_count;
+
+    /**
+     * Hash table of (parent, tag) using linear probing. Each bucket holds the
+     * node index plus 1, or 0 if it is empty. The count is a power of 2.
+     */
+    uint32_t *bucket;
+    uint32_t bucket_count;
+
+    swicc_alloc_st const *alloc; /* Where the buffers were allocated from. */
+} swicc_dato_bertlv_idx_st;
+
+/**
+ * @brief Decode and validate all DOs of a buffer (including nested ones) in one
+ * pass. Parents always come before their children and every DO must fit inside
+ * its parent.
+ * @param[in] bertlv_buf
+ * @param[in] bertlv_len
+ * @param[out] node Where the decoded DOs will be written in the order they
+ * appear in the buffer.
+ * @param[in] node_count_max How many nodes fit in the node buffer. A buffer of
+ * half the BER-TLV length (rounded down) nodes is always enough.
+ * @param[out] node_count Where the number of decoded DOs will be written.
+ * @return Return code. Buffer too short when the nodes do not fit.
+ */
+swicc_ret_et swicc_dato_bertlv_dec_all(uint8_t const *const bertlv_buf,
+                                       uint32_t const bertlv_len,
+                                       swicc_dato_bertlv_node_st *const node,
+                                       uint32_t const node_count_max,
+                                       uint32_t *const node_count);
+
+/**
+ * @brief Create the index of a buffer containing BER-TLV DOs at its root level.
+ * @param[out] idx
+ * @param[in] alloc Where the buffers of the index are allocated from, NULL for
+ * the C library.
+ * @param[in] bertlv_buf
+ * @param[in] bertlv_len
+ * @return Return code.
+ * @note The index only holds offsets so the buffer can move after having been
+ * indexed, it must not be modified though.
+ */
+swicc_ret_et swicc_dato_bertlv_idx_build(swicc_dato_bertlv_idx_st *const idx,
+                                         swicc_alloc_st const *const alloc,
+                                         uint8_t const *const bertlv_buf,
+                                         uint32_t const bertlv_len);
+
+/**
+ * @brief Free everything the index owns.
+ * @param[in, out] idx
+ */
+void swicc_dato_bertlv_idx_free(swicc_dato_bertlv_idx_st *const idx);
+
+/**
+ * @brief Find a DO by the DO containing it and its tag.
+ * @param[in] idx
+ * @param[in] parent_idx Node index of the parent or
+ * SWICC_DATO_BERTLV_NODE_PARENT_ROOT for DOs at the root level.
+ * @param[in] tag
+ * @param[out] node_idx Where the node index of the DO will be written.
+ * @return Return code. Not found when no such DO exists.
+ */
+swicc_ret_et swicc_dato_bertlv_idx_lookup(
+    swicc_dato_bertlv_idx_st const *const idx, uint32_t const parent_idx,
+    swicc_dato_bertlv_tag_st const *const tag, uint32_t *const node_idx);
+
+/**
+ * @brief Find a DO by the tags of all DOs on the way to it starting from the
+ * root level.
+ * @param[in] idx
+ * @param[in] tag_path Tags of the DOs on the path, the last one is the tag of
+ * the DO to find.
+ * @param[in] tag_path_len Number of tags in the path.
+ * @param[out] node_idx Where the node index of the DO will be written.
+ * @return Return code. Not found when no such DO exists.
+ */
+swicc_ret_et swicc_dato_bertlv_idx_lookup_path(
+    swicc_dato_bertlv_idx_st const *const idx,
+    swicc_dato_bertlv_tag_st const *const tag_path,
+    uint32_t const tag_path_len, uint32_t *const node_idx);
@@ -9,3 +9,4 @@
 #include "swicc/dbg/net.h"
 #include "swicc/dbg/pps.h"
 #include "swicc/dbg/tpdu.h"
+#include "swicc/dbg/trace.h"
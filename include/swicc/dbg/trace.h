@@ -0,0 +1,16 @@
+#pragma once
+
+#include "swicc/common.h"
+#include "swicc/trace.h"
+
+/**
+ * @brief Generate a string for a trace event.
+ * @param[out] buf_str Where to write the string.
+ * @param[in, out] buf_str_len Must contain the max string length. Receives
+ * length of written string on success.
+ * @param[in] evt The trace event to stringify.
+ * @return Return code.
+ */
+swicc_ret_et swicc_dbg_trace_evt_str(char *const buf_str,
+                                     uint16_t *const buf_str_len,
+                                     swicc_trace_evt_st const *const evt);
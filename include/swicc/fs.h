@@ -1,7 +1,11 @@
 #pragma once
 
+#include "swicc/fs/dedup.h"
 #include "swicc/fs/disk.h"
+#include "swicc/fs/diskc.h"
 #include "swicc/fs/diskjs.h"
+#include "swicc/fs/snapshot.h"
+#include "swicc/fs/swap.h"
 #include "swicc/fs/va.h"
 
 /* File descriptor. */
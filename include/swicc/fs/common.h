@@ -209,9 +209,15 @@ typedef struct swicc_fs_ef_cyclic_hdr_s
 {
     uint8_t rcrd_size;
 } swicc_fs_ef_cyclic_hdr_st;
+/**
+ * The head is the last byte of the header so it directly precedes the records.
+ * It changes on every update so it is not part of the parsed header, it's read
+ * from the disk where needed.
+ */
 typedef struct swicc_fs_ef_cyclic_hdr_raw_s
 {
     uint8_t rcrd_size;
+    uint8_t rcrd_head; /* Index of the record slot holding record number 1. */
 } __attribute__((packed)) swicc_fs_ef_cyclic_hdr_raw_st;
 
 /* Describes a record of an EF. */
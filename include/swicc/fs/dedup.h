@@ -0,0 +1,135 @@
+#pragma once
+/**
+ * Content-addressed storage of trees shared by many disks. The card images of a
+ * fleet usually hold the same applications with their files in the same places
+ * and mostly the same data (records filled with 0xFF, certificates, applets...)
+ * and only a few files like the identity and keys differ. A store holds one
+ * copy of every tree structure (i.e. all the headers of a tree) it was given,
+ * found by the checksum of the structure. Trees that get shared with the store
+ * using 'swicc_disk_dedup' point to the buffer of the tree of the store and
+ * keep copies only of the files whose data differ, so memory scales with how
+ * much the cards differ and not with the number of cards. These copies are
+ * extents of the store, found by the checksum of the data, so files holding
+ * the same data share one copy across all trees and disks until one of them
+ * gets modified:
+ *
+ *     swicc_disk_dedup_st dedup;
+ *     swicc_disk_dedup_init(&dedup, NULL);
+ *     for (uint32_t card_idx = 0U; card_idx < card_count; ++card_idx)
+ *     {
+ *         swicc_diskjs_disk_create(&disk[card_idx], disk_path[card_idx]);
+ *         swicc_disk_dedup(&disk[card_idx], &dedup);
+ *     }
+ */
+
+#include "swicc/common.h"
+#include "swicc/fs/disk.h"
+#include <pthread.h>
+
+/**
+ * A tree of a store, its buffer, SID LUT, and descriptors are shared by the
+ * trees of disks. It never gets modified.
+ */
+struct swicc_disk_dedup_tree_s
+{
+    swicc_disk_dedup_st *dedup;
+    uint32_t key;       /* Checksum of the structure of the tree. */
+    uint32_t ref_count; /* Number of trees of disks sharing this one. */
+    swicc_disk_tree_st tree;
+};
+
+/**
+ * Data of files held once for all files of trees of disks holding the same
+ * bytes. It never gets modified.
+ */
+struct swicc_disk_dedup_extent_s
+{
+    swicc_disk_dedup_st *dedup;
+    uint32_t key;       /* Checksum of the data. */
+    uint32_t ref_count; /* Number of files sharing this data. */
+    uint32_t len;
+    uint8_t *data;
+};
+
+struct swicc_disk_dedup_s
+{
+    pthread_mutex_t lock;
+    swicc_alloc_st const *alloc; /* Where trees are allocated from. */
+    swicc_disk_dedup_tree_st **tree; /* Ordered by key. */
+    uint32_t tree_count;
+    uint32_t tree_count_max;
+
+    /**
+     * Length of all trees of the store, and of all trees of disks which share
+     * them. How many times larger the latter is, is how many times more memory
+     * the trees would take without the store.
+     */
+    uint64_t len_held;
+    uint64_t len_ref;
+
+    swicc_disk_dedup_extent_st **extent; /* Ordered by key. */
+    uint32_t extent_count;
+    uint32_t extent_count_max;
+
+    /* Same as for trees but for the data of extents. */
+    uint64_t extent_len_held;
+    uint64_t extent_len_ref;
+};
+
+/**
+ * @brief Create an empty store.
+ * @param[out] dedup
+ * @param[in] alloc Where the trees of the store are allocated from, NULL for
+ * the C library. Must outlive the store.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_dedup_init(swicc_disk_dedup_st *const dedup,
+                                   swicc_alloc_st const *const alloc);
+
+/**
+ * @brief Free all trees and extents of a store.
+ * @param[in, out] dedup
+ * @note No disk may be sharing trees with the store anymore.
+ */
+void swicc_disk_dedup_deinit(swicc_disk_dedup_st *const dedup);
+
+/**
+ * @brief Get the tree of a store which has the same structure as a given tree,
+ * adding a copy of the given tree to the store when there is none. Every tree
+ * gotten this way has to be given back with 'swicc_disk_dedup_tree_put'.
+ * @param[in, out] dedup
+ * @param[in] tree A tree in memory with its descriptors.
+ * @param[out] dedup_tree Where the tree of the store will be written.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_dedup_tree_get(
+    swicc_disk_dedup_st *const dedup, swicc_disk_tree_st const *const tree,
+    swicc_disk_dedup_tree_st **const dedup_tree);
+
+/**
+ * @brief Give back a tree of a store. The store frees it once no tree of a
+ * disk shares it anymore.
+ * @param[in, out] dedup_tree
+ */
+void swicc_disk_dedup_tree_put(swicc_disk_dedup_tree_st *const dedup_tree);
+
+/**
+ * @brief Get the extent of a store which holds the given data, adding a copy of
+ * the data to the store when there is none. Every extent gotten this way has to
+ * be given back with 'swicc_disk_dedup_extent_put'.
+ * @param[in, out] dedup
+ * @param[in] data
+ * @param[in] len
+ * @param[out] extent Where the extent of the store will be written.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_dedup_extent_get(
+    swicc_disk_dedup_st *const dedup, uint8_t const *const data,
+    uint32_t const len, swicc_disk_dedup_extent_st **const extent);
+
+/**
+ * @brief Give back an extent of a store. The store frees it once no file
+ * shares it anymore.
+ * @param[in, out] extent
+ */
+void swicc_disk_dedup_extent_put(swicc_disk_dedup_extent_st *const extent);
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "swicc/alloc.h"
 #include "swicc/common.h"
+#include "swicc/dato.h"
 #include "swicc/fs/common.h"
+#include "swicc/fs/remote.h"
 #include <assert.h>
 #include <stdint.h>
 
@@ -9,20 +12,22 @@
 
 /**
  * Different file signatures to differentiate the endianness of the swICC FS
- * file.
+ * file. The last byte before 'FS' is the version of the layout of the trees,
+ * it changes whenever the raw headers of items change (version 2 added the
+ * record head to cyclic EFs) so disk files of older versions get rejected.
  * @todo Implement loading such that a little-endian machine can load an FS file
  * saved by a big-endian machine (and vice-versa).
  */
 #if __BYTE_ORDER == __LITTLE_ENDIAN
 #define SWICC_DISK_MAGIC                                                       \
     {                                                                          \
-        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, '.', '.', '.', '.', 'F',    \
+        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, '.', '.', '.', '2', 'F',    \
             'S', 0xF0, 0x0F                                                    \
     }
 #elif __BYTE_ORDER == __BIG_ENDIAN
 #define SWICC_DISK_MAGIC                                                       \
     {                                                                          \
-        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, '.', '.', '.', '.', 'F',    \
+        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, '.', '.', '.', '2', 'F',    \
             'S', 0x0F, 0xF0                                                    \
     }
 #else
@@ -31,6 +36,98 @@
 static_assert(sizeof((uint8_t[])SWICC_DISK_MAGIC) == SWICC_DISK_MAGIC_LEN,
               "Magic length macro not equal to the magic array length");
 
+/**
+ * Disks saved with a persisted index use this magic instead. The index section
+ * follows the magic and precedes the trees. It also holds the checksum of every
+ * tree.
+ */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define SWICC_DISK_MAGIC_INDEX                                                 \
+    {                                                                          \
+        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, 'I', 'D', 'X', '4', 'F',    \
+            'S', 0xF0, 0x0F                                                    \
+    }
+#elif __BYTE_ORDER == __BIG_ENDIAN
+#define SWICC_DISK_MAGIC_INDEX                                                 \
+    {                                                                          \
+        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, 'I', 'D', 'X', '4', 'F',    \
+            'S', 0x0F, 0xF0                                                    \
+    }
+#else
+#error "Invalid endianness."
+#endif
+static_assert(sizeof((uint8_t[])SWICC_DISK_MAGIC_INDEX) == SWICC_DISK_MAGIC_LEN,
+              "Magic length macro not equal to the index magic array length");
+
+/**
+ * Disks saved with compressed trees use this magic instead. The index section
+ * follows the magic (with a larger entry per tree) and precedes the trees which
+ * are each compressed on their own into an LZ4 block.
+ */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define SWICC_DISK_MAGIC_LZ4                                                   \
+    {                                                                          \
+        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, 'L', 'Z', '4', '3', 'F',    \
+            'S', 0xF0, 0x0F                                                    \
+    }
+#elif __BYTE_ORDER == __BIG_ENDIAN
+#define SWICC_DISK_MAGIC_LZ4                                                   \
+    {                                                                          \
+        0x00, 's', 'w', 'I', 'C', 'C', 0x91, 0xCC, 'L', 'Z', '4', '3', 'F',    \
+            'S', 0x0F, 0xF0                                                    \
+    }
+#else
+#error "Invalid endianness."
+#endif
+static_assert(sizeof((uint8_t[])SWICC_DISK_MAGIC_LZ4) == SWICC_DISK_MAGIC_LEN,
+              "Magic length macro not equal to the LZ4 magic array length");
+
+/* Granularity (in bytes) at which modifications of trees are tracked. */
+#define SWICC_DISK_DIRTY_PAGE_SIZE 256U
+
+/* Start of every record of a journal ("JRN2" when read as big-endian). */
+#define SWICC_DISK_JOURNAL_MAGIC 0x4A524E32U
+/**
+ * Start of a journal record holding a whole transaction ("JTX2" when read as
+ * big-endian). Its bytes are the records of every write of the transaction.
+ */
+#define SWICC_DISK_JOURNAL_MAGIC_TXN 0x4A545832U
+/**
+ * Starts of the records of journals written before record headers carried the
+ * record head of cyclic EFs ("JRNL" and "JTXN"). These journals can't be
+ * replayed and are left untouched.
+ */
+#define SWICC_DISK_JOURNAL_MAGIC_V1 0x4A524E4CU
+#define SWICC_DISK_JOURNAL_MAGIC_TXN_V1 0x4A54584EU
+
+/**
+ * Number of entries in the direct SID table of a tree. SIDs are 5 bits so every
+ * valid SID has its own entry.
+ */
+#define SWICC_DISK_LUTSID_DIRECT_COUNT 32U
+
+static_assert(SWICC_FS_NAME_LEN == SWICC_FS_ADF_AID_LEN,
+              "Names and AIDs must have the same length to share a LUT");
+
+/* Entry in the direct SID table for a SID no file uses. */
+#define SWICC_DISK_LUTSID_DIRECT_NONE UINT32_MAX
+
+/* Number of paths remembered by the path cache of a disk (a power of 2). */
+#define SWICC_DISK_PATH_CACHE_COUNT 32U
+
+/* Longest path (in file IDs) that the path cache remembers. */
+#define SWICC_DISK_PATH_CACHE_LEN_MAX 8U
+
+/**
+ * Entries of the name LUT are prefixed with the kind so that a lookup of a DF
+ * name never matches an AID and vice versa.
+ */
+typedef enum swicc_disk_lutname_kind_e
+{
+    SWICC_DISK_LUTNAME_KIND_DFNAME = 0U, /* Name of an MF or DF. */
+    SWICC_DISK_LUTNAME_KIND_AID = 1U,    /* AID of an ADF. */
+} swicc_disk_lutname_kind_et;
+
 /* Representation of a LUT (lookup table). */
 typedef struct swicc_disk_lut_s
 {
@@ -45,8 +142,119 @@ typedef struct swicc_disk_lut_s
     uint32_t size_item2; /* Size of item in buffer 2. */
 } swicc_disk_lut_st;
 
-/* Representation of a tree in the root (forest). */
+/* Defined in 'swicc/fs/dedup.h'. */
+typedef struct swicc_disk_dedup_extent_s swicc_disk_dedup_extent_st;
+
+/**
+ * A file of a tree that is shared with a base disk whose data got copied out of
+ * the base tree before being modified, or whose data differed from the tree of
+ * a dedup store when it got shared.
+ */
+typedef struct swicc_disk_overlay_file_s
+{
+    uint32_t offset_trel;      /* Offset of the file in the tree. */
+    uint32_t data_offset_trel; /* Offset of the file data in the tree. */
+    uint32_t data_size;
+    uint8_t *data; /* Copy of the file data. */
+
+    /**
+     * When set, the data is not a private copy but the data of this extent of
+     * a dedup store which must not be modified. It gets copied before the
+     * first write.
+     */
+    swicc_disk_dedup_extent_st *extent;
+
+    /**
+     * Private copy of the record head of a cyclic EF which sits in the header
+     * right before the data (the header is not part of the data copy).
+     */
+    bool rcrd_head_own;
+    uint8_t rcrd_head;
+} swicc_disk_overlay_file_st;
+
+/**
+ * Index of the BER-TLV DOs held by the data of a file, created on the first
+ * lookup of a DO in the file.
+ */
+typedef struct swicc_disk_dato_idx_s
+{
+    uint32_t offset_trel;      /* Offset of the file in the tree. */
+    uint32_t data_offset_trel; /* Offset of the file data in the tree. */
+    uint32_t data_size;
+    swicc_dato_bertlv_idx_st idx;
+} swicc_disk_dato_idx_st;
+
+/**
+ * A response template of a file (e.g. the FCP) kept in its encoded form so it
+ * does not have to be encoded again on every selection of the file. The kind
+ * is picked by the user of the cache and tells apart templates of one file.
+ */
+typedef struct swicc_disk_fcp_s
+{
+    uint32_t offset_trel; /* Offset of the file in the tree. */
+    uint32_t hdr_size;    /* Size of the header of the file. */
+    uint8_t kind;
+    uint32_t len;
+    uint8_t *buf;
+} swicc_disk_fcp_st;
+
+/**
+ * A file header decoded ahead of time so that files don't have to be parsed
+ * from the raw headers on every access. Kept small so two fit in a cache line.
+ */
+typedef struct swicc_disk_descr_s
+{
+    uint32_t offset_trel;
+    uint32_t offset_prel;
+    uint32_t size;       /* Size of the whole item (header included). */
+    uint32_t parent_idx; /* Index of the parent descriptor (root has itself). */
+    swicc_fs_id_kt id;
+    swicc_fs_sid_kt sid;
+    uint8_t type;      /* One of 'swicc_fs_item_type_et'. */
+    uint8_t lcs;       /* One of 'swicc_fs_lcs_et'. */
+    uint8_t rcrd_size; /* Only used by linear-fixed and cyclic EFs. */
+} swicc_disk_descr_st;
+static_assert(sizeof(swicc_disk_descr_st) <= 32U,
+              "File descriptor no longer fits twice in a cache line");
+
+/* State of the journal of a disk. */
+typedef struct swicc_disk_journal_s
+{
+    bool enabled;
+    int32_t fd;
+    uint32_t group_count;   /* Sync after this many records (0 means never). */
+    uint32_t group_pending; /* Records appended since the last sync. */
+    /**
+     * Set when a record could not be appended whole and the torn part could
+     * not be cut off again. No more records are appended until compaction.
+     */
+    bool failed;
+} swicc_disk_journal_st;
+
 typedef struct swicc_disk_tree_s swicc_disk_tree_st;
+
+/* Defined in 'swicc/fs/dedup.h'. */
+typedef struct swicc_disk_dedup_s swicc_disk_dedup_st;
+typedef struct swicc_disk_dedup_tree_s swicc_disk_dedup_tree_st;
+
+/**
+ * A path that was selected before and the file it led to. The start of the
+ * path is the file it is relative to (none for paths from the MF) since the
+ * same path can lead to different files depending on where it starts.
+ */
+typedef struct swicc_disk_path_cache_entry_s
+{
+    swicc_disk_tree_st const *start_tree; /* NULL when relative to the MF. */
+    uint32_t start_offset_trel;
+    uint8_t type; /* One of 'swicc_fs_path_type_et'. */
+    uint8_t len;  /* 0 for an empty entry. */
+    swicc_fs_id_kt id[SWICC_DISK_PATH_CACHE_LEN_MAX];
+
+    swicc_disk_tree_st *tree; /* Tree of the file that was selected. */
+    uint32_t offset_trel;
+} swicc_disk_path_cache_entry_st;
+
+/* Representation of a tree in the root (forest). */
 struct swicc_disk_tree_s
 {
     /**
@@ -58,14 +266,180 @@ struct swicc_disk_tree_s
     uint32_t len;  /* Occupied size. */
     uint8_t *buf;  /* This buffer holds the whole disk (including LUTs). */
     swicc_disk_lut_st lutsid;
+
+    /**
+     * Offset of the file with a given SID (the index), built together with the
+     * SID LUT. This makes looking up a file by SID take constant time.
+     */
+    uint32_t lutsid_direct[SWICC_DISK_LUTSID_DIRECT_COUNT];
+
+    /**
+     * Descriptors of all files in the tree ordered by offset, built together
+     * with the SID LUT.
+     */
+    swicc_disk_descr_st *descr;
+    uint32_t descr_count;
+
+    /**
+     * How many times each file was accessed, by index of its descriptor.
+     * Allocated on the first access and dropped together with the descriptors.
+     */
+    uint32_t *access;
+
+    /**
+     * When set, the buffer and SID LUT belong to a tree of a base disk and must
+     * not be modified. Files that get modified are copied into the overlay
+     * which is kept sorted by offset of the file.
+     */
+    bool shared;
+    swicc_disk_overlay_file_st *overlay;
+    uint32_t overlay_count;
+    uint32_t overlay_count_max;
+
+    /**
+     * When the shared buffer and SID LUT belong to a tree of a dedup store
+     * instead of a base disk, this is that tree. It gets released when the
+     * tree is unloaded.
+     */
+    swicc_disk_dedup_tree_st *dedup;
+
+    /**
+     * Bitmap of the pages of the tree (as seen through the overlay) that were
+     * modified since they were last cleared. Allocated on the first
+     * modification.
+     */
+    uint64_t *dirty;
+    uint32_t dirty_word_count;
+
+    /**
+     * CRC32C of the tree (as seen through the overlay), valid until the tree
+     * gets modified. Once computed after a modification, the checksum of every
+     * page (of the dirty page size) is kept so that later on only the pages
+     * modified since are read again.
+     */
+    uint32_t check;
+    bool check_valid;
+    uint32_t *check_page;
+    uint32_t check_page_count;
+    uint64_t *check_stale; /* Bitmap of pages whose checksum is outdated. */
+
+    /**
+     * Indexes of the DOs in files of the tree. An index is dropped when the
+     * data of its file is marked as modified.
+     */
+    swicc_disk_dato_idx_st *dato_idx;
+    uint32_t dato_idx_count;
+
+    /**
+     * Encoded response templates of files in the tree ordered by offset of the
+     * file then kind. A template is dropped when the header of its file is
+     * marked as modified.
+     */
+    swicc_disk_fcp_st *fcp;
+    uint32_t fcp_count;
+
+    /**
+     * When set, the tree was not read from the disk file yet. The buffer and
+     * SID LUT are created on the first access using the file descriptor and
+     * the offset of the tree in the disk file. The length is already known.
+     * For a disk loaded from a remote, the tree is read from the remote
+     * instead of the file descriptor.
+     */
+    bool lazy;
+    int32_t lazy_fd;
+    swicc_disk_remote_st const *lazy_remote;
+    uint32_t lazy_offset;
+
+    /**
+     * When set, the tree is compressed in the disk file and is decompressed
+     * when it is read. Either way, it is checked against the checksum from the
+     * index once read.
+     */
+    bool lazy_lz4;
+    uint32_t lazy_len_lz4; /* Length of the tree in the disk file. */
+
+    /* Same as the allocator of the disk the tree belongs to. */
+    swicc_alloc_st const *alloc;
 };
 
 /* The in-memory struct storing a swICC FS disk. */
-typedef struct swicc_disk_s
+typedef struct swicc_disk_s swicc_disk_st;
+struct swicc_disk_s
 {
     swicc_disk_tree_st *root;
     swicc_disk_lut_st lutid; /* There is exactly one LUT for all IDs. */
-} swicc_disk_st;
+
+    /**
+     * All trees by their index, built together with the ID LUT so that the
+     * tree of a file found in the ID LUT does not have to be searched for.
+     */
+    swicc_disk_tree_st **lutid_tree;
+    uint32_t lutid_tree_count;
+
+    /**
+     * Lookup of MF/DF names and ADF AIDs, built together with the ID LUT. Item
+     * 1 is the kind followed by the name, item 2 is the same as in the ID LUT.
+     */
+    swicc_disk_lut_st lutname;
+
+    /**
+     * Paths selected before, by hash of the path and its start. Allocated on
+     * the first insertion and dropped together with the ID LUT, i.e. whenever
+     * files may have moved.
+     */
+    swicc_disk_path_cache_entry_st *path_cache;
+
+    /**
+     * When loaded using 'swicc_disk_load_mmap', the buffers of all trees point
+     * into this mapping of the disk file instead of being allocated.
+     */
+    uint8_t *map;
+    uint32_t map_size;
+
+    /**
+     * Disk whose trees and ID LUT are shared by this disk when it was created
+     * using 'swicc_disk_overlay_create'.
+     */
+    swicc_disk_st const *base;
+
+    /**
+     * When loaded using 'swicc_disk_load_lazy', this is the open disk file
+     * from which trees get read when they are first accessed. When loaded
+     * using 'swicc_disk_load_remote', this is the remote they get read from.
+     */
+    bool lazy;
+    int32_t lazy_fd;
+    swicc_disk_remote_st *remote;
+
+    /**
+     * Modifications get appended to the journal (when enabled) so that they
+     * can be persisted without saving the whole disk.
+     */
+    swicc_disk_journal_st journal;
+    /**
+     * Where everything the disk owns (trees, LUTs, descriptors, overlays,
+     * indexes, templates...) is allocated from, NULL for the C library. It is
+     * set before a disk is loaded or created and is kept by all functions that
+     * load, create, or unload the disk. When the allocator never frees one by
+     * one (e.g. an arena), unloading leaves the memory to be released together
+     * with the allocator.
+     */
+    swicc_alloc_st const *alloc;
+};
+
+/**
+ * Writes to any number of files of a disk which are applied all together or
+ * not at all. They are staged with 'swicc_disk_txn_write' and are only applied
+ * on 'swicc_disk_txn_commit', which appends them to the journal as one record.
+ */
+typedef struct swicc_disk_txn_s
+{
+    swicc_disk_st *disk;
+    /* Staged writes, each is a journal record header followed by the bytes. */
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t size;
+} swicc_disk_txn_st;
 
 /**
  * Looking up trees by index can be code-inefficient when trying to perform some
@@ -83,11 +457,134 @@ typedef struct swicc_disk_tree_iter_s
  * @brief Load a disk file (into memory).
  * @param[in, out] disk
  * @param[in] disk_path Path to the disk file.
- * @return Return code.
+ * @return Return code. Disk files with trees of an older layout (see
+ * 'SWICC_DISK_MAGIC') are rejected by this and all other loaders.
  */
 swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
                              char const *const disk_path);
 
+/**
+ * @brief Load a disk file by mapping it into memory instead of reading it. The
+ * trees use the mapping directly so nothing gets copied and unmodified pages
+ * are shared (through the page cache) by every disk loaded from the same file.
+ * The mapping is private so modifications of the disk stay local to it and are
+ * never written back to the file.
+ * @param[in, out] disk
+ * @param[in] disk_path Path to the disk file.
+ * @return Return code.
+ * @note Trees of such a disk can't be resized.
+ * @note A disk file with compressed trees is loaded as with 'swicc_disk_load'
+ * since its trees can't be used from the mapping.
+ */
+swicc_ret_et swicc_disk_load_mmap(swicc_disk_st *const disk,
+                                  char const *const disk_path);
+
+/**
+ * @brief Load a disk file lazily. Only the index (i.e. the locations of all
+ * trees and the ID and name LUTs) is read up front. A tree is read from the
+ * file, and gets its SID LUT, when it is first accessed through a tree iterator
+ * or a lookup in the ID or name LUT. The file is kept open until unloading.
+ * @param[in, out] disk
+ * @param[in] disk_path Path to the disk file.
+ * @return Return code.
+ * @note A disk file without an index is loaded as with 'swicc_disk_load'.
+ * @note A tree of a disk file with compressed trees gets decompressed when it
+ * is read.
+ * @note The disk file must not be modified while the disk is loaded.
+ */
+swicc_ret_et swicc_disk_load_lazy(swicc_disk_st *const disk,
+                                  char const *const disk_path);
+
+/**
+ * @brief Load a disk file from a remote store lazily. As with
+ * 'swicc_disk_load_lazy', only the index is read up front and each tree is
+ * fetched (with a range read) when it is first accessed.
+ * @param[in, out] disk
+ * @param[in] remote Copied into the disk, the user data and cache must outlive
+ * the disk.
+ * @return Return code.
+ * @note Only disk files with an index can be loaded from a remote.
+ * @note The disk file must not be modified while the disk is loaded.
+ */
+swicc_ret_et swicc_disk_load_remote(swicc_disk_st *const disk,
+                                    swicc_disk_remote_st const *const remote);
+
+/**
+ * @brief Read a tree of a lazily loaded disk from the disk file (if it was not
+ * read yet) and create its SID LUT.
+ * @param[in, out] tree
+ * @return Return code. For trees that are already in memory, this has no
+ * effect.
+ */
+swicc_ret_et swicc_disk_tree_load(swicc_disk_tree_st *const tree);
+
+/**
+ * @brief Load a disk file on several threads. The trees are read, validated,
+ * and get their SID LUT concurrently, each tree also gets its own fragment of
+ * the ID and name LUTs which are then merged into the LUTs of the disk. The
+ * result is the same as with 'swicc_disk_load'.
+ * @param[in, out] disk
+ * @param[in] disk_path Path to the disk file.
+ * @param[in] worker_count How many threads to load on (the calling thread
+ * included), 0 to use one per online core.
+ * @return Return code.
+ * @note The persisted index of a disk file is not used since the LUTs are built
+ * by the workers. A disk file with compressed trees is loaded as with
+ * 'swicc_disk_load'.
+ */
+swicc_ret_et swicc_disk_load_parallel(swicc_disk_st *const disk,
+                                      char const *const disk_path,
+                                      uint32_t const worker_count);
+
+/**
+ * @brief Load many disk files at once, same as 'swicc_disk_load_parallel' but
+ * with one pool of workers for all of them. The trees of all disks are read by
+ * the same workers so the reads of different disk files overlap.
+ * @param[in, out] disk Array of the disks to load.
+ * @param[in] disk_path Path to the disk file of every disk.
+ * @param[out] disk_ret Where the return code of loading every disk will be
+ * written, NULL to not get them. A disk that failed to load is left empty.
+ * @param[in] disk_count Number of disks to load.
+ * @param[in] worker_count How many threads to load on (the calling thread
+ * included), 0 to use one per online core.
+ * @return Return code. Success only if all disks were loaded.
+ */
+swicc_ret_et swicc_disk_load_batch(swicc_disk_st *const disk,
+                                   char const *const *const disk_path,
+                                   swicc_ret_et *const disk_ret,
+                                   uint32_t const disk_count,
+                                   uint32_t const worker_count);
+
+/**
+ * @brief Create a disk which shares all trees and LUTs of a base disk and only
+ * keeps private copies of files that get modified (copy-on-write). Many cards
+ * can be created from one base so memory use scales with how much the cards
+ * diverge from the base and not with the number of cards.
+ * @param[out] disk Will receive the overlay disk.
+ * @param[in] disk_base The base disk which must not be modified or unloaded
+ * while any overlay created from it is still loaded.
+ * @return Return code. An error is returned for a base with trees holding
+ * private copies of files, e.g. an overlay disk itself.
+ * @note The LUTs of an overlay disk can't be rebuilt.
+ */
+swicc_ret_et swicc_disk_overlay_create(swicc_disk_st *const disk,
+                                       swicc_disk_st const *const disk_base);
+
+/**
+ * @brief Share the trees of a disk with the trees of the same structure held
+ * by a dedup store. A tree the store does not hold yet gets copied into it.
+ * Files whose data differ from the tree of the store share the data of an
+ * extent of the store with all files holding the same bytes. Any file that
+ * gets modified later is copied first, same as for overlays of a base disk.
+ * @param[in, out] disk All trees get loaded first. Trees that are shared
+ * already are left as they are.
+ * @param[in, out] dedup Must outlive the disk.
+ * @return Return code.
+ * @note Trees of such a disk can't be resized and their LUTs can't be rebuilt.
+ */
+swicc_ret_et swicc_disk_dedup(swicc_disk_st *const disk,
+                              swicc_disk_dedup_st *const dedup);
+
 /**
  * @brief Unload the in-memory disk and frees any memory used for storing the
  * FS.
@@ -104,6 +601,151 @@ void swicc_disk_unload(swicc_disk_st *const disk);
 swicc_ret_et swicc_disk_save(swicc_disk_st const *const disk,
                              char const *const disk_path);
 
+/**
+ * @brief Save the disk like 'swicc_disk_save' but together with a persisted
+ * index containing all LUTs so that loading it does not have to rebuild them.
+ * @param[in] disk
+ * @param[in] disk_path Path where to save the disk file.
+ * @return Return code.
+ * @note Both load functions accept disks with and without an index. An index
+ * that does not match the trees is ignored and the LUTs get rebuilt instead.
+ * The CRC32C of every tree is saved in the index too and a tree that does not
+ * match it fails to load.
+ */
+swicc_ret_et swicc_disk_save_index(swicc_disk_st const *const disk,
+                                   char const *const disk_path);
+
+/**
+ * @brief Save the disk like 'swicc_disk_save_index' but with every tree
+ * compressed into an LZ4 block (trees that don't get smaller are stored
+ * uncompressed) and checked with its CRC32C when it is read back.
+ * @param[in] disk
+ * @param[in] disk_path Path where to save the disk file.
+ * @return Return code.
+ * @note When loaded using 'swicc_disk_load_lazy', a tree is only decompressed
+ * when it is first accessed. The other load functions decompress all trees
+ * right away.
+ */
+swicc_ret_et swicc_disk_save_lz4(swicc_disk_st const *const disk,
+                                 char const *const disk_path);
+
+/**
+ * @brief Open (or create) a journal for a disk. Every modification that gets
+ * journaled is appended to it so it can later be replayed on top of the disk
+ * file that was loaded.
+ * @param[in, out] disk
+ * @param[in] journal_path Path to the journal file.
+ * @param[in] group_count Number of records to group into one commit, i.e.
+ * after how many appended records the journal gets synced to storage. With 1,
+ * every record is durable once appended. With 0, the journal is only synced on
+ * 'swicc_disk_journal_sync', compaction, or close.
+ * @return Return code. A journal with records of an older layout can't be
+ * opened.
+ * @note The journal moves together with the disk when it gets mounted.
+ */
+swicc_ret_et swicc_disk_journal_open(swicc_disk_st *const disk,
+                                     char const *const journal_path,
+                                     uint32_t const group_count);
+
+/**
+ * @brief Sync and close the journal of a disk. This is also done on unload.
+ * @param[in, out] disk
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_journal_close(swicc_disk_st *const disk);
+
+/**
+ * @brief Write all appended records of the journal to storage.
+ * @param[in, out] disk
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_journal_sync(swicc_disk_st *const disk);
+
+/**
+ * @brief Append the current contents of a part of the data of a file to the
+ * journal. Should be called after every write to a file.
+ * @param[in, out] disk
+ * @param[in] tree Tree containing the file.
+ * @param[in] file
+ * @param[in] data_offset Offset of the modified bytes in the file data.
+ * @param[in] data_len Number of modified bytes.
+ * @return Return code. Success is also returned when there is no journal.
+ */
+swicc_ret_et swicc_disk_journal_append(swicc_disk_st *const disk,
+                                       swicc_disk_tree_st const *const tree,
+                                       swicc_fs_file_st const *const file,
+                                       uint32_t const data_offset,
+                                       uint32_t const data_len);
+
+/**
+ * @brief Apply all records of a journal to a disk. This should be done right
+ * after loading the disk file on top of which the journal was written. A record
+ * that is incomplete or corrupted (e.g. due to a crash while appending it) ends
+ * the journal and gets cut off together with whatever follows it. A journal
+ * written with an older layout of records is rejected and left untouched.
+ * @param[in, out] disk
+ * @param[in] journal_path Path to the journal file.
+ * @return Return code. A missing journal is treated as an empty one.
+ * @note Replay must happen before the journal is opened for appending.
+ */
+swicc_ret_et swicc_disk_journal_replay(swicc_disk_st *const disk,
+                                       char const *const journal_path);
+
+/**
+ * @brief Save the disk (with all modifications) to a fresh disk file which
+ * atomically replaces the given one, then empty the journal.
+ * @param[in, out] disk Must have an open journal.
+ * @param[in] disk_path Path of the disk file to replace.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_journal_compact(swicc_disk_st *const disk,
+                                        char const *const disk_path);
+
+/**
+ * @brief Begin a transaction on a disk.
+ * @param[in] disk
+ * @param[out] txn
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_txn_begin(swicc_disk_st *const disk,
+                                  swicc_disk_txn_st *const txn);
+
+/**
+ * @brief Stage a write to the data of a file. The file is left untouched until
+ * the transaction is committed.
+ * @param[in, out] txn
+ * @param[in] tree Tree containing the file.
+ * @param[in] file
+ * @param[in] data_offset Offset of the bytes to write in the file data.
+ * @param[in] data Bytes to write.
+ * @param[in] data_len Number of bytes to write.
+ * @return Return code.
+ * @note For cyclic EFs, the record head is kept as it is when staging.
+ */
+swicc_ret_et swicc_disk_txn_write(swicc_disk_txn_st *const txn,
+                                  swicc_disk_tree_st const *const tree,
+                                  swicc_fs_file_st const *const file,
+                                  uint32_t const data_offset,
+                                  uint8_t const *const data,
+                                  uint32_t const data_len);
+
+/**
+ * @brief Apply all writes of a transaction and end it. With an open journal,
+ * they are appended as a single record before being applied so a replay
+ * applies either all or none of them.
+ * @param[in, out] txn
+ * @return Return code. On failure, none of the writes were applied.
+ * @note The record is durable following the group count of the journal, like
+ * any other record.
+ */
+swicc_ret_et swicc_disk_txn_commit(swicc_disk_txn_st *const txn);
+
+/**
+ * @brief End a transaction without applying any of its writes.
+ * @param[in, out] txn
+ */
+void swicc_disk_txn_abort(swicc_disk_txn_st *const txn);
+
 /**
  * @brief A callback for the 'foreach' iterator.
  * @param[in, out] tree The tree inside which is the file.
@@ -175,24 +817,76 @@ swicc_ret_et swicc_disk_tree_iter_idx(swicc_disk_tree_iter_st *const tree_iter,
 void swicc_disk_root_empty(swicc_disk_st *const disk);
 
 /**
- * @brief Remove the SID LUT from a given tree.
+ * @brief Remove the SID LUT (and the file descriptors) from a given tree.
  * @param[in, out] tree The tree in which to empty the SID LUT.
  */
 void swicc_disk_lutsid_empty(swicc_disk_tree_st *const tree);
 
 /**
- * @brief Dealloc all disk buffers that hold ID LUT data.
+ * @brief Dealloc all disk buffers that hold ID LUT data (this includes the name
+ * LUT).
  * @param[in, out] disk Disk for which to empty the ID LUT.
  */
 void swicc_disk_lutid_empty(swicc_disk_st *const disk);
 
 /**
- * @brief Create the LUT for IDs on the disk.
+ * @brief Create the LUT for IDs on the disk, and with it the name LUT.
  * @param[in, out] disk
  * @return Return code.
  */
 swicc_ret_et swicc_disk_lutid_rebuild(swicc_disk_st *const disk);
 
+/**
+ * @brief Create the file descriptors of a tree on their own, without the SID
+ * LUT (which already creates them).
+ * @param[in, out] tree
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_descr_rebuild(swicc_disk_tree_st *const tree);
+
+/**
+ * @brief Find the descriptor of the file at a given offset in a tree.
+ * @param[in] tree
+ * @param[in] offset_trel Offset of the file in the tree.
+ * @param[out] descr_idx Where the index of the descriptor will be written.
+ * @return Return code. Not found is also returned when the tree has no
+ * descriptors.
+ */
+swicc_ret_et swicc_disk_descr_lookup(swicc_disk_tree_st const *const tree,
+                                     uint32_t const offset_trel,
+                                     uint32_t *const descr_idx);
+
+/**
+ * @brief Count an access to a file, e.g. a selection. The counts are what
+ * 'swicc_disk_tree_relayout' orders files by.
+ * @param[in, out] tree
+ * @param[in] file
+ * @return Return code.
+ * @note Counts stop at UINT32_MAX and are cleared whenever the descriptors of
+ * the tree get rebuilt.
+ */
+swicc_ret_et swicc_disk_file_access(swicc_disk_tree_st *const tree,
+                                    swicc_fs_file_st const *const file);
+
+/**
+ * @brief Rewrite a tree so that the files that were accessed the most come
+ * first in their folder, together with their data. Folders are ordered by the
+ * accesses of all files they contain so the headers on the way to the hottest
+ * files end up next to each other at the start of the tree. Files that were
+ * accessed equally keep their order. The offsets in the headers are updated,
+ * the SID LUT and the ID LUT are rebuilt, and the whole tree is marked as
+ * modified.
+ * @param[in, out] disk Disk the tree belongs to.
+ * @param[in, out] tree
+ * @return Return code. An error is returned for trees shared with a base disk
+ * and for disks with an enabled journal (whose records refer to the old
+ * layout).
+ * @note Files of the tree held elsewhere (e.g. in VAs) are no longer valid
+ * after this. The access counts are cleared.
+ */
+swicc_ret_et swicc_disk_tree_relayout(swicc_disk_st *const disk,
+                                      swicc_disk_tree_st *const tree);
+
 /**
  * @brief Create a LUT for SIDs for a tree.
  * @param[in, out] disk
@@ -229,11 +923,74 @@ swicc_ret_et swicc_disk_lutid_lookup(swicc_disk_st const *const disk,
                                      swicc_fs_id_kt const id,
                                      swicc_fs_file_st *const file);
 
+/**
+ * @brief Look up the file a path led to when it was last selected.
+ * @param[in] disk
+ * @param[in] key Path to look for. Only the start, type, length, and IDs are
+ * used.
+ * @param[out] tree Gets a pointer to the tree in which the file is located
+ * (only on success).
+ * @param[out] file Gets the file (only on success).
+ * @return Return code. Not found is returned when the path is not cached.
+ */
+swicc_ret_et swicc_disk_path_cache_lookup(
+    swicc_disk_st const *const disk,
+    swicc_disk_path_cache_entry_st const *const key,
+    swicc_disk_tree_st **const tree, swicc_fs_file_st *const file);
+
+/**
+ * @brief Remember the file a path led to. It replaces whichever path was
+ * remembered in the same slot of the cache.
+ * @param[in, out] disk
+ * @param[in] entry
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_path_cache_insert(
+    swicc_disk_st *const disk,
+    swicc_disk_path_cache_entry_st const *const entry);
+
+/**
+ * @brief Find a file whose ID is also used by another file in the same folder
+ * (so the two can't be told apart when selecting by ID).
+ * @param[in] disk
+ * @param[out] tree Gets a pointer to the tree in which the file is located
+ * (only on success).
+ * @param[out] file Gets the later of the two files in the tree (only on
+ * success).
+ * @return Return code. Not found is returned when all IDs are unique within
+ * their folder.
+ */
+swicc_ret_et swicc_disk_lutid_dup_find(swicc_disk_st const *const disk,
+                                       swicc_disk_tree_st **const tree,
+                                       swicc_fs_file_st *const file);
+
+/**
+ * @brief Perform a lookup in the name LUT of a given disk. A name shorter than
+ * the full length matches any name starting with it (e.g. a partial AID). When
+ * several files match, the first one in tree order is returned.
+ * @param[in] disk
+ * @param[in] kind What kind of name to look for.
+ * @param[in] name
+ * @param[in] name_len Length of the name, at most the full name length.
+ * @param[out] tree Gets a pointer to the tree in which the file is located
+ * (only on success).
+ * @param[out] file Gets the file header that was found with the lookup
+ * (only on success).
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_lutname_lookup(swicc_disk_st const *const disk,
+                                       swicc_disk_lutname_kind_et const kind,
+                                       uint8_t const *const name,
+                                       uint32_t const name_len,
+                                       swicc_disk_tree_st **const tree,
+                                       swicc_fs_file_st *const file);
+
 /**
  * @brief Obtain data contained in a record inside a file.
  * @param[in] tree The tree which contains the file.
  * @param[in] file The file which must contain the record.
- * @param[in] idx Index of the record to obtain.
+ * @param[in] idx Index of the record to obtain. For cyclic EFs, index 0 is the
+ * most recent record.
  * @param[out] buf Where the pointer to the record buffer will be written.
  * @param[in] len Length of the record buffer.
  * @return Return code.
@@ -243,6 +1000,173 @@ swicc_ret_et swicc_disk_file_rcrd(swicc_disk_tree_st const *const tree,
                                   swicc_fs_rcrd_idx_kt const idx,
                                   uint8_t **const buf, uint8_t *const len);
 
+/**
+ * @brief Get the data of a file. For trees shared with a base disk, this
+ * resolves through the overlay first so the data is always up to date even if
+ * the file was parsed before it got modified.
+ * @param[in] tree Tree containing the file.
+ * @param[in] file
+ * @param[out] data Will receive a pointer to the data of the file.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_file_data(swicc_disk_tree_st const *const tree,
+                                  swicc_fs_file_st const *const file,
+                                  uint8_t **const data);
+
+/**
+ * @brief Make the data of a file writable. For trees shared with a base disk,
+ * this copies the file data into the overlay of the tree (unless a private copy
+ * is already there). For any other tree, this has no effect.
+ * @param[in, out] tree Tree containing the file.
+ * @param[in, out] file The data pointer will be updated to the writable data.
+ * @return Return code.
+ * @note Must be called before every write to a file.
+ */
+swicc_ret_et swicc_disk_file_cow(swicc_disk_tree_st *const tree,
+                                 swicc_fs_file_st *const file);
+
+/**
+ * @brief Get the record head of a cyclic EF, i.e. the index of the record slot
+ * that holds record number 1 (the most recent record).
+ * @param[in] tree Tree containing the file.
+ * @param[in] file
+ * @param[out] rcrd_head Where the head will be written.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_file_rcrd_head(swicc_disk_tree_st const *const tree,
+                                       swicc_fs_file_st const *const file,
+                                       uint8_t *const rcrd_head);
+
+/**
+ * @brief Set the record head of a cyclic EF and mark it as modified.
+ * @param[in, out] tree Tree containing the file.
+ * @param[in] file
+ * @param[in] rcrd_head Index of the record slot that holds record number 1.
+ * @return Return code.
+ * @note The file must have been copied on write before, like for data writes.
+ */
+swicc_ret_et swicc_disk_file_rcrd_head_set(swicc_disk_tree_st *const tree,
+                                           swicc_fs_file_st const *const file,
+                                           uint8_t const rcrd_head);
+
+/**
+ * @brief Get the index of the BER-TLV DOs contained in the data of a file. The
+ * index is created on the first call and kept until the file gets modified.
+ * @param[in, out] tree Tree containing the file.
+ * @param[in] file
+ * @param[out] idx Where the pointer to the index will be written.
+ * @param[out] data Where the pointer to the file data (the indexed buffer) will
+ * be written.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_file_dato_idx(
+    swicc_disk_tree_st *const tree, swicc_fs_file_st const *const file,
+    swicc_dato_bertlv_idx_st const **const idx, uint8_t **const data);
+
+/**
+ * @brief Get a cached response template of a file.
+ * @param[in] tree Tree containing the file.
+ * @param[in] file
+ * @param[in] kind Which template of the file to get.
+ * @param[out] buf Where the pointer to the template will be written. It stays
+ * valid until the header of the file is modified or the tree is unloaded.
+ * @param[out] len Where the length of the template will be written.
+ * @return Return code. Not found if the template is not cached.
+ */
+swicc_ret_et swicc_disk_file_fcp_lookup(swicc_disk_tree_st const *const tree,
+                                        swicc_fs_file_st const *const file,
+                                        uint8_t const kind,
+                                        uint8_t const **const buf,
+                                        uint32_t *const len);
+
+/**
+ * @brief Add a response template of a file to the cache (replacing the cached
+ * one of the same kind).
+ * @param[in, out] tree Tree containing the file.
+ * @param[in] file
+ * @param[in] kind Which template of the file this is.
+ * @param[in] buf Encoded template, it gets copied.
+ * @param[in] len Length of the template.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_file_fcp_insert(swicc_disk_tree_st *const tree,
+                                        swicc_fs_file_st const *const file,
+                                        uint8_t const kind,
+                                        uint8_t const *const buf,
+                                        uint32_t const len);
+
+/**
+ * @brief Mark a range of a tree as modified.
+ * @param[in, out] tree
+ * @param[in] offset_trel Offset of the modified bytes in the tree.
+ * @param[in] len Number of modified bytes.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_tree_dirty_mark(swicc_disk_tree_st *const tree,
+                                        uint32_t const offset_trel,
+                                        uint32_t const len);
+
+/**
+ * @brief Mark a part of the data of a file as modified. Should be called after
+ * every write to a file.
+ * @param[in, out] tree Tree containing the file.
+ * @param[in] file
+ * @param[in] data_offset Offset of the modified bytes in the file data.
+ * @param[in] data_len Number of modified bytes.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_file_dirty_mark(swicc_disk_tree_st *const tree,
+                                        swicc_fs_file_st const *const file,
+                                        uint32_t const data_offset,
+                                        uint32_t const data_len);
+
+/**
+ * @brief Forget about all modifications of a tree.
+ * @param[in, out] tree
+ */
+void swicc_disk_tree_dirty_clear(swicc_disk_tree_st *const tree);
+
+/**
+ * @brief Get the CRC32C of a tree as seen through its overlay (if any), i.e.
+ * the checksum saved with it in the index. The checksum is computed when the
+ * tree is loaded and gets updated after modifications by reading only the
+ * pages that were marked as modified since.
+ * @param[in, out] tree
+ * @param[out] check
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_tree_check(swicc_disk_tree_st *const tree,
+                                   uint32_t *const check);
+
+/**
+ * @brief Copy a range of a tree, with the files of the overlay (if any) in
+ * place of the ones in the tree buffer, i.e. exactly as it would be saved.
+ * @param[in] tree
+ * @param[in] offset_trel Offset of the range in the tree.
+ * @param[in] len Length of the range.
+ * @param[out] buf Where the range will be copied to.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_tree_read(swicc_disk_tree_st const *const tree,
+                                  uint32_t const offset_trel,
+                                  uint32_t const len, uint8_t *const buf);
+
+/**
+ * @brief Write a range of a tree as it would be read by 'swicc_disk_tree_read'
+ * and mark it as modified. For trees shared with a base disk, only the files in
+ * the overlay get written since any other byte still belongs to the base.
+ * @param[in, out] tree
+ * @param[in] offset_trel Offset of the range in the tree.
+ * @param[in] len Length of the range.
+ * @param[in] buf Bytes to write.
+ * @return Return code.
+ * @note This does not append to the journal.
+ */
+swicc_ret_et swicc_disk_tree_write(swicc_disk_tree_st *const tree,
+                                   uint32_t const offset_trel,
+                                   uint32_t const len,
+                                   uint8_t const *const buf);
+
 /**
  * @brief Gets the number of records that a file holds.
  * @param[in] tree The tree which contains the file.
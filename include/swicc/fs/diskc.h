@@ -0,0 +1,44 @@
+#pragma once
+/**
+ * Generation of C source files holding a whole disk: the tree buffers, the SID,
+ * ID and name LUTs, the file descriptors, and the tree and disk structs are
+ * all emitted as constant data. Once linked into a binary, the disk needs no
+ * loading at all and lives in read-only pages (or ROM) shared by every process
+ * running the binary.
+ *
+ * The generated disk is only meant to be used as the base of overlay disks
+ * (see 'swicc_disk_overlay_create') so that files which get modified are copied
+ * into RAM and the constant data is never written to:
+ *
+ *     extern swicc_disk_st const disk_rom;
+ *     swicc_disk_st disk = {0};
+ *     swicc_disk_overlay_create(&disk, &disk_rom);
+ *     swicc_fs_disk_mount(&swicc_state, &disk);
+ *
+ * Everything the generated file defines is declared with the SWICC_DISKC_RODATA
+ * attribute macro (empty by default) so it can be placed in a section of choice
+ * when compiling the file, e.g. with
+ * -DSWICC_DISKC_RODATA='__attribute__((section(".fsrom")))'.
+ */
+
+#include "swicc/common.h"
+#include "swicc/fs/disk.h"
+
+/* Longest name the generated disk symbol can have. */
+#define SWICC_DISKC_NAME_LEN_MAX 64U
+
+/**
+ * @brief Generate a C source file that defines a disk as constant data.
+ * @param[in] disk The disk to generate the file from. Trees are written as they
+ * are seen through the overlay of the disk (if any) and lazily loaded trees
+ * get read.
+ * @param[in] c_path Path where to write the C source file.
+ * @param[in] name Name of the 'swicc_disk_st const' defined by the generated
+ * file, it must be a C identifier. Everything else in the file is static and
+ * prefixed with this name.
+ * @return Return code.
+ * @note The generated file can only be compiled for a machine with the same
+ * endianness as the one it was generated on.
+ */
+swicc_ret_et swicc_diskc_gen(swicc_disk_st const *const disk,
+                             char const *const c_path, char const *const name);
@@ -12,3 +12,36 @@
  */
 swicc_ret_et swicc_diskjs_disk_create(swicc_disk_st *const disk,
                                       char const *const disk_json_path);
+
+/**
+ * @brief Same as 'swicc_diskjs_disk_create' but lets the caller choose how many
+ * threads compile the trees. The trees of the 'disk' array are located without
+ * building a DOM of the whole disk, then each one is parsed and compiled on its
+ * own by one of the workers and the forest keeps the order of the JSON.
+ * @param[out] disk Disk struct to populate.
+ * @param[in] disk_json_path Path to the JSON file describing the disk.
+ * @param[in] worker_count How many threads to compile on (the calling thread
+ * being one of them), 0 to use one per online core.
+ * @return Return code.
+ */
+swicc_ret_et swicc_diskjs_disk_create_mt(swicc_disk_st *const disk,
+                                         char const *const disk_json_path,
+                                         uint32_t const worker_count);
+
+/**
+ * @brief Same as 'swicc_diskjs_disk_create_mt' but reuses trees compiled before
+ * from a compile cache. Each tree is looked up by a hash of its JSON text so
+ * only the trees that changed since they were cached get compiled, and these
+ * are then added to the cache.
+ * @param[out] disk Disk struct to populate.
+ * @param[in] disk_json_path Path to the JSON file describing the disk.
+ * @param[in] worker_count How many threads to compile on (the calling thread
+ * being one of them), 0 to use one per online core.
+ * @param[in] cache_path Path to an existing directory holding the cache. It
+ * can be shared between processes.
+ * @return Return code.
+ */
+swicc_ret_et swicc_diskjs_disk_create_cached(swicc_disk_st *const disk,
+                                             char const *const disk_json_path,
+                                             uint32_t const worker_count,
+                                             char const *const cache_path);
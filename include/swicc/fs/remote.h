@@ -0,0 +1,109 @@
+#pragma once
+/**
+ * Disk files kept in a remote store (e.g. an object store) which are read from
+ * with range reads instead of being downloaded whole. A disk is loaded from a
+ * remote with 'swicc_disk_load_remote': only the index is read up front and
+ * every tree is fetched when it is first accessed, like with a lazy load. Bytes
+ * that were fetched go into a bounded page cache which can be shared by all
+ * disks (of all cards) reading from remotes, so loading a disk whose trees are
+ * cached already does not touch the remote store:
+ *
+ *     swicc_disk_cache_st cache;
+ *     swicc_disk_cache_init(&cache, 1024U);
+ *     swicc_disk_remote_st const remote = {
+ *         .read = object_read, .userdata = &object, .len = object.len,
+ *         .id = object.etag, .cache = &cache,
+ *     };
+ *     swicc_disk_st disk = {0};
+ *     swicc_disk_load_remote(&disk, &remote);
+ */
+
+#include "swicc/common.h"
+#include <pthread.h>
+
+/* Granularity (in bytes) at which bytes of remotes get fetched and cached. */
+#define SWICC_DISK_CACHE_PAGE_SIZE 4096U
+
+/**
+ * @brief Read a range of bytes from a remote. This can be called from any
+ * thread that reads from a disk of the remote.
+ * @param[in, out] userdata What was given with the remote.
+ * @param[in] offset Offset of the bytes in the disk file.
+ * @param[in] len Number of bytes to read.
+ * @param[out] buf Where to write the bytes, all of them must be read.
+ * @return Return code.
+ */
+typedef swicc_ret_et swicc_disk_remote_read_ft(void *const userdata,
+                                               uint64_t const offset,
+                                               uint32_t const len,
+                                               uint8_t *const buf);
+
+/* A page of the cache holding a part of a disk file of a remote. */
+typedef struct swicc_disk_cache_page_s
+{
+    uint64_t remote_id;
+    uint64_t page_idx; /* Offset of the page in the disk file / page size. */
+    uint64_t used;     /* Tick of the last read from the page. */
+    uint32_t len;      /* Only the last page of a disk file can be shorter. */
+    uint8_t *buf;
+} swicc_disk_cache_page_st;
+
+/**
+ * Pages fetched from remotes, ordered by remote ID then page index. When full,
+ * the page that was least recently read from gets replaced.
+ */
+typedef struct swicc_disk_cache_s
+{
+    pthread_mutex_t lock;
+    swicc_disk_cache_page_st *page;
+    uint32_t page_count;
+    uint32_t page_count_max;
+    uint64_t tick;
+
+    /* Number of page reads that were served by the cache and by the remote. */
+    uint64_t hit_count;
+    uint64_t miss_count;
+} swicc_disk_cache_st;
+
+/* Where and how to read a disk file from a remote store. */
+typedef struct swicc_disk_remote_s
+{
+    swicc_disk_remote_read_ft *read;
+    void *userdata;
+    uint64_t len; /* Length of the disk file. */
+    /**
+     * Identifies the contents of the disk file in the cache so it must differ
+     * for any 2 disk files (or versions of one) sharing a cache.
+     */
+    uint64_t id;
+    swicc_disk_cache_st *cache; /* NULL to read everything from the remote. */
+} swicc_disk_remote_st;
+
+/**
+ * @brief Create an empty cache.
+ * @param[out] cache
+ * @param[in] page_count_max Most pages the cache holds at any time.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_cache_init(swicc_disk_cache_st *const cache,
+                                   uint32_t const page_count_max);
+
+/**
+ * @brief Free all pages of a cache.
+ * @param[in, out] cache
+ * @note No disk reading from a remote using the cache may be loaded anymore.
+ */
+void swicc_disk_cache_deinit(swicc_disk_cache_st *const cache);
+
+/**
+ * @brief Read a range of bytes of the disk file of a remote, through the cache
+ * of the remote (if any).
+ * @param[in] remote
+ * @param[in] offset Offset of the bytes in the disk file.
+ * @param[in] len Number of bytes to read.
+ * @param[out] buf Where to write the bytes.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_remote_read(swicc_disk_remote_st const *const remote,
+                                    uint64_t const offset, uint32_t const len,
+                                    uint8_t *const buf);
@@ -0,0 +1,99 @@
+#pragma once
+/**
+ * Incremental snapshots of a disk into the disk file it was loaded from (or
+ * last saved to). Only the pages of trees that were modified since the previous
+ * snapshot get written. Capturing copies the modified pages out of the disk
+ * (so it costs as much as the modifications and not as the whole disk) and is
+ * meant to run on the thread that owns the disk e.g. between APDUs. Writing the
+ * captured pages to the file is done separately, e.g. by a background thread,
+ * so the card never has to wait for storage. There are 2 snapshot buffers so a
+ * new snapshot can be captured while the previous one is still being written.
+ */
+
+#include "swicc/common.h"
+#include "swicc/fs/disk.h"
+#include <stdatomic.h>
+
+/* Number of snapshots that can be captured but not written yet. */
+#define SWICC_SNAPSHOT_BUF_COUNT 2U
+
+/* A range of the disk file which gets overwritten by a snapshot. */
+typedef struct swicc_snapshot_extent_s
+{
+    uint32_t offset; /* Offset in the disk file. */
+    uint32_t len;
+} swicc_snapshot_extent_st;
+
+/* Owned by the snapshot so not allocated by the allocator of the disk. */
+typedef struct swicc_snapshot_buf_s
+{
+    swicc_snapshot_extent_st *extent;
+    uint32_t extent_count;
+    uint32_t extent_count_max;
+
+    /* Data of all extents one after the other. */
+    uint8_t *data;
+    uint32_t data_len;
+    uint32_t data_size;
+} swicc_snapshot_buf_st;
+
+typedef struct swicc_snapshot_s
+{
+    int32_t fd;
+
+    /* Offset of the first tree in the disk file. */
+    uint32_t tree_offset;
+
+    /* Offset of the index entry of the first tree, 0 without an index. */
+    uint32_t index_tree_offset;
+
+    /**
+     * Free-running counters of snapshots. Captured is only written by the
+     * capturing side and written only by the writing side.
+     */
+    _Atomic uint32_t epoch_captured;
+    _Atomic uint32_t epoch_written;
+
+    swicc_snapshot_buf_st buf[SWICC_SNAPSHOT_BUF_COUNT];
+} swicc_snapshot_st;
+
+/**
+ * @brief Start taking snapshots of a disk into a disk file.
+ * @param[out] snapshot
+ * @param[in] disk
+ * @param[in] disk_path Path to the disk file which must hold the disk as it was
+ * when the dirty state of all trees was last clear (i.e. as loaded or saved).
+ * @return Return code.
+ */
+swicc_ret_et swicc_snapshot_init(swicc_snapshot_st *const snapshot,
+                                 swicc_disk_st const *const disk,
+                                 char const *const disk_path);
+
+/**
+ * @brief Free all memory used by the snapshots and close the disk file.
+ * @param[in, out] snapshot
+ * @note Must not be used while a snapshot is being captured or written.
+ */
+void swicc_snapshot_deinit(swicc_snapshot_st *const snapshot);
+
+/**
+ * @brief Capture all modifications of a disk since the previous snapshot and
+ * clear the dirty state of the disk.
+ * @param[in, out] snapshot
+ * @param[in, out] disk
+ * @return Return code. When all buffers are waiting to be written, the busy
+ * code is returned and the modifications will be part of a later snapshot.
+ * @note This is the capturing side.
+ */
+swicc_ret_et swicc_snapshot_capture(swicc_snapshot_st *const snapshot,
+                                    swicc_disk_st *const disk);
+
+/**
+ * @brief Write the oldest captured snapshot to the disk file and sync it.
+ * @param[in, out] snapshot
+ * @return Return code. If there are no captured snapshots, the snapshot empty
+ * code is returned.
+ * @note This is the writing side. A crash while writing can leave the disk
+ * file with a part of a snapshot so a journal is still needed for durability.
+ */
+swicc_ret_et swicc_snapshot_write(swicc_snapshot_st *const snapshot);
@@ -0,0 +1,81 @@
+#pragma once
+/**
+ * Hot-swap of the disk mounted in a card while the card keeps running. A new
+ * disk is loaded (and indexed) by any thread, then published to the card with
+ * 'swicc_fs_disk_swap'. The card takes it in between commands, so no command
+ * ever sees two disks, and re-resolves the VA of every open logical channel in
+ * the new disk. The disk that was swapped out is handed back to the publisher
+ * in the struct the new disk was published with, once no command of the card
+ * can reference it anymore, and the publisher reclaims it e.g. with
+ * 'swicc_disk_unload'. This works like RCU with the card as the only reader:
+ *
+ *     swicc_disk_st disk = {0};
+ *     swicc_disk_load(&disk, "new.swiccfs");
+ *     swicc_fs_disk_swap(&swicc_state, &disk);
+ *     while (swicc_fs_disk_swap_reclaim(&swicc_state, &disk) ==
+ *            SWICC_RET_FS_SWAP_PENDING)
+ *     {
+ *         ...
+ *     }
+ *     swicc_disk_unload(&disk); // Unloads the old disk.
+ *
+ * Swaps are taken automatically by 'swicc_io' and 'swicc_apduh_exec'.
+ */
+
+#include "swicc/common.h"
+#include "swicc/fs/disk.h"
+#include <stdatomic.h>
+
+typedef struct swicc_fs_swap_s
+{
+    /* Disk published for the card to swap in. Set by the publisher. */
+    _Atomic(swicc_disk_st *) pending;
+    /**
+     * Struct of the last disk that was swapped in, it now holds the disk it
+     * replaced. Set by the card and cleared by the publisher on reclaim.
+     */
+    _Atomic(swicc_disk_st *) retired;
+} swicc_fs_swap_st;
+
+/**
+ * @brief Publish a disk to be swapped in by a card as soon as it is in between
+ * commands. Can be called from any thread.
+ * @param[in, out] swicc_state
+ * @param[in, out] disk The new disk. It must stay untouched until it is
+ * reclaimed with 'swicc_fs_disk_swap_reclaim' since it will receive the disk it
+ * replaces. When shared with other disks (i.e. as the base of overlays), it is
+ * the struct holding the overlay that must be published.
+ * @return Return code. An error is returned when another swap is still pending.
+ */
+swicc_ret_et swicc_fs_disk_swap(swicc_st *const swicc_state,
+                                swicc_disk_st *const disk);
+
+/**
+ * @brief Swap in the published disk (if any). The VA of every open logical
+ * channel is re-resolved in the new disk: the same ADF, DF, EF, and record are
+ * selected again as far as they still exist, otherwise the channel is left on
+ * the deepest of them that does (at least the MF). A chained response that
+ * was not retrieved completely is dropped, so a GET RESPONSE after the swap
+ * fails.
+ * @param[in, out] swicc_state
+ * @return Return code. Success is returned when there was nothing to swap. The
+ * swap pending code is returned when the card is in the middle of a command or
+ * when the disk swapped out last was not reclaimed yet, then the swap is done
+ * on a later call.
+ * @note Must be called on the thread running the card. Checkpoints captured
+ * before a swap can't be restored after it.
+ */
+swicc_ret_et swicc_fs_disk_swap_apply(swicc_st *const swicc_state);
+
+/**
+ * @brief Check if a published disk was swapped in and get back the disk it
+ * replaced. Can be called from any thread.
+ * @param[in, out] swicc_state
+ * @param[in] disk The struct that was given to 'swicc_fs_disk_swap'. On
+ * success, it holds the disk that was swapped out and belongs to the caller
+ * again.
+ * @return Return code. The swap pending code is returned while the card has not
+ * taken the disk yet.
+ */
+swicc_ret_et swicc_fs_disk_swap_reclaim(swicc_st *const swicc_state,
+                                        swicc_disk_st *const disk);
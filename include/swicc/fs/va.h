@@ -12,6 +12,14 @@
  * their changes based on if they fail or not.
  */
 
+/**
+ * Number of logical channels, which is the most that can be referenced by a
+ * CLA byte i.e. channels 0 to 19. ISO/IEC 7816-4:2020 clause.5.4.1.
+ */
+#define SWICC_VA_LCHAN_COUNT 20U
+static_assert(SWICC_VA_LCHAN_COUNT <= 32U,
+              "Open logical channels no longer fit in a 32-bit mask");
+
 /**
  * For a logical channel, a validity area (VA) summarizes the result
  * of all successful file selections. ISO/IEC 7816-4:2020 clause.7.2.1.
@@ -41,12 +49,43 @@ typedef struct swicc_va_s
 
 /**
  * @brief Reset the VA to a state expected right after startup of the ICC i.e.
- * with the MF (3F00) selected.
+ * with the MF (3F00) selected and only the basic logical channel open.
  * @param[in, out] fs
  * @return Return code.
  */
 swicc_ret_et swicc_va_reset(swicc_fs_st *const fs);
 
+/**
+ * @brief Make the VA of a logical channel the current one. The VA of the
+ * channel that was current until now gets stored away with its channel.
+ * @param[in, out] fs
+ * @param[in] lchan Logical channel number.
+ * @return Return code. Not found if the channel is not open.
+ */
+swicc_ret_et swicc_va_lchan_switch(swicc_fs_st *const fs, uint8_t const lchan);
+
+/**
+ * @brief Open a logical channel from the current one. Opening from the basic
+ * channel selects the MF in the new channel, otherwise the new channel starts
+ * with the current DF of the channel it was opened from.
+ * @param[in, out] fs
+ * @param[in, out] lchan Channel to open, or 0 to open the lowest closed channel
+ * which will be written back here.
+ * @return Return code. Not found if no channel is left to open and param bad if
+ * the requested channel is invalid or already open.
+ * @note The current channel stays current.
+ */
+swicc_ret_et swicc_va_lchan_open(swicc_fs_st *const fs, uint8_t *const lchan);
+
+/**
+ * @brief Close a logical channel. The basic channel can't be closed.
+ * @param[in, out] fs
+ * @param[in] lchan Logical channel number.
+ * @return Return code.
+ * @note Closing the current channel makes the basic channel current.
+ */
+swicc_ret_et swicc_va_lchan_close(swicc_fs_st *const fs, uint8_t const lchan);
+
 /**
  * @brief Select an ADF (application) by its AID (application ID).
  * @param[in, out] fs
@@ -138,6 +138,14 @@ typedef enum swicc_fsm_state_e
      * after just the header.
      */
     SWICC_FSM_STATE_CMD_DATA,
+
+    /**
+     * When T=1 was selected with a PPS exchange, commands and responses are
+     * exchanged in blocks instead of the T=0 states above. The card receives
+     * one whole block then sends one block back.
+     * ISO/IEC 7816-3:2006 clause.11
+     */
+    SWICC_FSM_STATE_BLOCK,
 } swicc_fsm_state_et;
 
 /**
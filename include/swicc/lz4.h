@@ -0,0 +1,40 @@
+#pragma once
+/**
+ * Compression using the LZ4 block format (without the frame around it), e.g.
+ * for storing trees of a disk file in less space. Blocks compressed here can
+ * be decompressed by any LZ4 implementation and vice versa.
+ */
+
+#include "swicc/common.h"
+
+/* Largest size a block of a given length can have once compressed. */
+#define SWICC_LZ4_BOUND(len) ((len) + ((len) / 255U) + 16U)
+
+/**
+ * @brief Compress a buffer into an LZ4 block.
+ * @param[in] src
+ * @param[in] src_len
+ * @param[out] dst Where to write the block.
+ * @param[in] dst_size Size of the destination buffer. When it is at least
+ * 'SWICC_LZ4_BOUND(src_len)', compression can't fail.
+ * @param[out] dst_len Length of the block.
+ * @return Return code. An error is returned when the block does not fit in the
+ * destination buffer, e.g. when the data is not worth compressing.
+ */
+swicc_ret_et swicc_lz4_compress(uint8_t const *const src,
+                                uint32_t const src_len, uint8_t *const dst,
+                                uint32_t const dst_size,
+                                uint32_t *const dst_len);
+
+/**
+ * @brief Decompress an LZ4 block.
+ * @param[in] src The block.
+ * @param[in] src_len Length of the block.
+ * @param[out] dst Where to write the decompressed data.
+ * @param[in] dst_len Exact length of the decompressed data.
+ * @return Return code. An error is returned when the block is malformed or does
+ * not decompress to exactly the expected length.
+ */
+swicc_ret_et swicc_lz4_decompress(uint8_t const *const src,
+                                  uint32_t const src_len, uint8_t *const dst,
+                                  uint32_t const dst_len);
@@ -17,3 +17,23 @@
  */
 swicc_ret_et swicc_mock_reset_cold(swicc_st *const swicc_state,
                                    bool const mock_pps);
+
+/**
+ * @brief Perform a complete command-response exchange in one call by playing
+ * the role of the interface in the T=0 protocol i.e. send the header, answer
+ * the procedure bytes with data, and (like readers do) retrieve outgoing data
+ * using GET RESPONSE on '61XX' and re-issue the command on '6CXX'.
+ * @param[in, out] swicc_state An ICC which is waiting for a command.
+ * @param[in] cmd The C-APDU (in the T=0 TPDU form i.e. a 5 byte header
+ * followed by the data).
+ * @param[in] cmd_len Length of the C-APDU.
+ * @param[out] res Where to write the R-APDU (data followed by SW1 and SW2).
+ * @param[in, out] res_len Must contain the size of the response buffer.
+ * Receives length of the R-APDU on success.
+ * @return Return code.
+ * @note The buffers of the swICC state are pointed elsewhere while doing this
+ * and are restored before returning.
+ */
+swicc_ret_et swicc_mock_apdu(swicc_st *const swicc_state,
+                             uint8_t const *const cmd, uint16_t const cmd_len,
+                             uint8_t *const res, uint16_t *const res_len);
@@ -4,21 +4,52 @@
  */
 
 #include "swicc/common.h"
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
- * Maximum number of clients (cards) that can connect to one server. This is
- * arbitrary but note that the PC/SC IFD handler relies on this so number so
- * larger number means more resources will be used by the PC/SC middleware.
+ * Maximum number of clients (cards) that can connect to one server at once.
+ * This is arbitrary but note that the PC/SC IFD handler relies on this so
+ * number so larger number means more resources will be used by the PC/SC
+ * middleware. This is only the length of the accept queue, the slot table of a
+ * server grows as needed.
  */
 #define SWICC_NET_CLIENT_COUNT_MAX 8U
 
 /* If the keep-alive functionality of sockets should be used. */
 #define SWICC_NET_SERVER_CLIENT_KEEPALIVE 0U
 
-/* If the keep-alive messages should be logged with network logger method. */
-#define SWICC_NET_CLIENT_LOG_KEEPALIVE false
+/* Granularity (in milliseconds) of the keep-alive timers of a server. */
+#define SWICC_NET_KEEPALIVE_TICK 100U
+
+/**
+ * Shape of the timer wheel of a server: each level has a bucket per tick of the
+ * level below it. With 4 levels of 64 buckets, timers can be up to 64^4 ticks
+ * (about 19 days) away.
+ */
+#define SWICC_NET_KEEPALIVE_LEVEL_BITS 6U
+#define SWICC_NET_KEEPALIVE_LEVEL_SIZE (1U << SWICC_NET_KEEPALIVE_LEVEL_BITS)
+#define SWICC_NET_KEEPALIVE_LEVEL_COUNT 4U
+
+/* Marks the end of a list of timers. */
+#define SWICC_NET_KEEPALIVE_NONE UINT32_MAX
+
+/* Maximum number of events the reactor handles per wait for events. */
+#define SWICC_NET_REACTOR_EVENT_COUNT_MAX 64U
+
+/**
+ * How long (in milliseconds) the reactor waits for events before checking if
+ * it should shut down.
+ */
+#define SWICC_NET_REACTOR_TIMEOUT 100
+
+/**
+ * Default time budget (in nanoseconds) of the scheduler of a reactor, see
+ * 'budget' of the reactor.
+ */
+#define SWICC_NET_REACTOR_BUDGET_DEFAULT 200000U
 
 /* Possible values of the control field of a messaage. */
 typedef enum swicc_net_msg_ctrl_e
@@ -30,12 +61,38 @@ typedef enum swicc_net_msg_ctrl_e
     SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_Y,
     SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_N,
     SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_N,
+    /**
+     * Data is a complete C-APDU and the response will contain the complete
+     * R-APDU, see 'swicc_mock_apdu'.
+     */
+    SWICC_NET_MSG_CTRL_APDU,
 
     /* Control values for responses (client -> server). */
     SWICC_NET_MSG_CTRL_SUCCESS = 0xF0,
     SWICC_NET_MSG_CTRL_FAILURE = 0x0F,
+
+    /**
+     * Control value for both directions. The buffer holds a 32-bit card ID and
+     * the next message is for (request) or from (response) that card. It is
+     * only sent before messages of cards other than card 0 so connections that
+     * carry one card look exactly like they did before multiplexing. Peers that
+     * don't multiplex answer it with a failure.
+     */
+    SWICC_NET_MSG_CTRL_CARD = 0xCA,
 } swicc_net_msg_ctrl_et;
 
+/**
+ * How much a network client logs about the messages it handles. Errors are
+ * always logged. Below the trace level, no debug strings are created at all.
+ */
+typedef enum swicc_net_log_lvl_e
+{
+    SWICC_NET_LOG_LVL_ERROR = 0,
+    SWICC_NET_LOG_LVL_TRACE,           /* Messages except keep-alives. */
+    SWICC_NET_LOG_LVL_TRACE_KEEPALIVE, /* Also keep-alive messages. */
+    SWICC_NET_LOG_LVL_TRACE_TPDU,      /* Also the data parsed as TPDUs. */
+} swicc_net_log_lvl_et;
+
 typedef struct swicc_net_msg_hdr_s
 {
     uint32_t size; /* The size of the data. */
@@ -69,17 +126,344 @@ typedef struct swicc_net_msg_s
     swicc_net_msg_data_st data;
 } __attribute__((packed)) swicc_net_msg_st;
 
+/**
+ * A slot of a server is one card. Many slots can share one connection, they are
+ * told apart using card messages, see 'SWICC_NET_MSG_CTRL_CARD'.
+ */
+typedef struct swicc_net_server_slot_s
+{
+    int32_t sock; /* -1 when the slot is unused. */
+    uint32_t card;
+
+    /**
+     * Slot holding the keep-alive timer of the connection. It is the slot on
+     * which the client was connected, the others only point to it.
+     */
+    uint32_t ka_conn;
+    /* Set on traffic of any card of the connection, cleared by the timer. */
+    bool ka_active;
+    bool ka_armed;
+    uint16_t ka_bucket; /* Level * level size + bucket in the level. */
+    uint64_t ka_expiry; /* Tick of the wheel at which the timer fires. */
+    uint32_t ka_next;
+    uint32_t ka_prev;
+} swicc_net_server_slot_st;
+
+/**
+ * Hierarchical timer wheel tracking how long each connection of a server has
+ * been idle. Traffic only sets a flag on the connection, so it costs nothing
+ * on the hot path. A connection is only probed when its timer fires while the
+ * flag is clear.
+ */
+typedef struct swicc_net_keepalive_s
+{
+    uint32_t idle; /* Milliseconds, 0 when disabled. */
+    bool rearm;    /* Re-arm all timers on the next poll, e.g. on a new idle. */
+    uint64_t tick; /* Last tick the wheel was advanced to. */
+    bool tick_pending; /* Timers of the last tick are yet to be fired. */
+    uint32_t armed_count;
+    uint32_t bucket[SWICC_NET_KEEPALIVE_LEVEL_COUNT]
+                   [SWICC_NET_KEEPALIVE_LEVEL_SIZE];
+} swicc_net_keepalive_st;
+
+/**
+ * The slot table grows as slots get used so there is no limit on how many
+ * cards a server can have. Used slots are indexed by socket and card so that
+ * responses are matched to their slot in constant time.
+ */
 typedef struct swicc_net_server_s
 {
     int32_t sock_server;
+
+    /**
+     * Sockets of the first slots, -1 when unused. Servers used to only have
+     * this array, it is kept up to date for code written against it (e.g. the
+     * swICC PC/SC reader) and must only be read. Slots past it are only in the
+     * slot table.
+     */
     int32_t sock_client[SWICC_NET_CLIENT_COUNT_MAX];
+
+    swicc_net_server_slot_st *slot;
+    uint32_t slot_count;
+
+    /**
+     * Open-addressing hash table of the used slots, keyed by socket and card.
+     * An entry holds the slot + 1, 0 when empty. The size is a power of 2 (or
+     * 0 before the first slot is used) and the table is at most half full.
+     */
+    uint32_t *slot_index;
+    uint32_t slot_index_size;
+    uint32_t slot_index_count;
+
+    swicc_net_keepalive_st keepalive;
 } swicc_net_server_st;
 
+/**
+ * Number of messages that can be queued in each direction of a shared-memory
+ * channel.
+ */
+#define SWICC_NET_SHM_RING_LEN 4U
+
+/* Maximum length of the name of a shared-memory channel (including '\0'). */
+#define SWICC_NET_SHM_NAME_LEN_MAX 64U
+
+/**
+ * Single-producer, single-consumer queue of messages that lives in shared
+ * memory. The sequence number is changed on every push, pop, and close so that
+ * blocked peers can wait on it (using a futex) and get woken up by the other
+ * side.
+ */
+typedef struct swicc_net_shm_ring_s
+{
+    _Atomic uint32_t head; /* Only written by the producer. */
+    _Atomic uint32_t tail; /* Only written by the consumer. */
+    _Atomic uint32_t seq;
+    _Atomic uint32_t waiting; /* How many peers wait on the sequence number. */
+    swicc_net_msg_st msg[SWICC_NET_SHM_RING_LEN];
+} swicc_net_shm_ring_st;
+
+/* Layout of a shared-memory channel between a server and a client. */
+typedef struct swicc_net_shm_region_s
+{
+    _Atomic uint32_t closed;
+    swicc_net_shm_ring_st ring_req; /* Server -> client. */
+    swicc_net_shm_ring_st ring_res; /* Client -> server. */
+} swicc_net_shm_region_st;
+
+/**
+ * One end (server or client) of a shared-memory channel. This is an
+ * alternative to a TCP connection for when the server and client are on the
+ * same machine.
+ */
+typedef struct swicc_net_shm_s
+{
+    swicc_net_shm_region_st *region; /* NULL when not open. */
+    bool server;
+    char name[SWICC_NET_SHM_NAME_LEN_MAX];
+} swicc_net_shm_st;
+
+/**
+ * Size of the receive buffer of a connection. It can hold a few messages so
+ * that everything which is available on the socket can be read at once.
+ */
+#define SWICC_NET_CONN_BUF_SIZE (4U * sizeof(swicc_net_msg_st))
+
+/**
+ * Holds received data until complete messages can be extracted from it, or
+ * queued data until the socket can take it.
+ */
+typedef struct swicc_net_conn_s
+{
+    uint8_t buf[SWICC_NET_CONN_BUF_SIZE];
+    uint32_t len;    /* Number of bytes in the buffer. */
+    uint32_t offset; /* Where the next message starts in the buffer. */
+} swicc_net_conn_st;
+
+/**
+ * What a caller of 'swicc_net_client_step' shall wait for on the socket before
+ * stepping again. These are flags.
+ */
+typedef enum swicc_net_ready_e
+{
+    SWICC_NET_READY_NONE = 0U,
+    SWICC_NET_READY_READ = 1U << 0U,
+    SWICC_NET_READY_WRITE = 1U << 1U,
+} swicc_net_ready_et;
+
 typedef struct swicc_net_client_s
 {
     int32_t sock_client;
+    swicc_net_conn_st conn;
+    swicc_net_conn_st conn_tx; /* Only used by 'swicc_net_client_step'. */
+
+    /**
+     * When the shared-memory channel is open, it's used instead of the socket.
+     */
+    swicc_net_shm_st shm;
+
+    /**
+     * Set to 'SWICC_NET_LOG_LVL_ERROR' when the client is created. Can be
+     * changed at any time, even while the client is running.
+     */
+    swicc_net_log_lvl_et log_lvl;
 } swicc_net_client_st;
 
+/* Number of submission queue entries of an io_uring. */
+#define SWICC_NET_URING_ENTRY_COUNT 256U
+
+/**
+ * Number of buffers provided to the kernel for receiving with io_uring. They
+ * are shared by all cards of a reactor. Must be a power of 2.
+ */
+#define SWICC_NET_URING_BUF_COUNT 256U
+
+/* Size of each receive buffer of io_uring, enough for any message. */
+#define SWICC_NET_URING_BUF_SIZE (sizeof(swicc_net_msg_st))
+
+/* User data of operations whose completion does not matter. */
+#define SWICC_NET_URING_USER_DATA_NONE 0U
+
+/* ID that no receive buffer of io_uring has. */
+#define SWICC_NET_URING_BUF_ID_NONE UINT16_MAX
+
+/**
+ * A thin wrapper around the io_uring interface of Linux, only as much as the
+ * reactor needs. The rings are shared with the kernel.
+ */
+typedef struct swicc_net_uring_s
+{
+    int32_t fd;
+    void *ring;
+    size_t ring_size;
+    void *sqe;
+    size_t sqe_size;
+    void *buf_ring;
+    size_t buf_ring_size;
+    uint8_t *buf;
+
+    uint32_t sq_entries;
+    uint32_t to_submit; /* Queued entries that were not submitted yet. */
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t *sq_mask;
+    uint32_t *sq_array;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t *cq_mask;
+    void *cqe;
+} swicc_net_uring_st;
+
+/* A completed operation of an io_uring. */
+typedef struct swicc_net_uring_cqe_s
+{
+    uint64_t user_data;
+    int32_t res; /* Same as the return value of the equivalent syscall. */
+    bool more;   /* If more completions will follow for this operation. */
+
+    /**
+     * Buffer that holds the received data, NULL if none. It has to be released
+     * once the data was consumed.
+     */
+    uint8_t *buf;
+    uint16_t buf_id;
+} swicc_net_uring_cqe_st;
+
+/* Which mechanism a reactor uses to wait for I/O. */
+typedef enum swicc_net_reactor_backend_e
+{
+    SWICC_NET_REACTOR_BACKEND_EPOLL = 0,
+    SWICC_NET_REACTOR_BACKEND_URING,
+} swicc_net_reactor_backend_et;
+
+/* Operations of a card that can be in flight in an io_uring (flags). */
+typedef enum swicc_net_reactor_uring_op_e
+{
+    SWICC_NET_REACTOR_URING_OP_RECV = 1U << 0U,
+    SWICC_NET_REACTOR_URING_OP_SEND = 1U << 1U,
+} swicc_net_reactor_uring_op_et;
+
+/**
+ * Priority classes of cards in a reactor. A ready card is only given a turn
+ * when no card of a higher class is ready.
+ */
+typedef enum swicc_net_reactor_prio_e
+{
+    SWICC_NET_REACTOR_PRIO_HIGH = 0,
+    SWICC_NET_REACTOR_PRIO_NORMAL,
+    SWICC_NET_REACTOR_PRIO_LOW,
+} swicc_net_reactor_prio_et;
+
+/* Number of priority classes, see 'swicc_net_reactor_prio_et'. */
+#define SWICC_NET_REACTOR_PRIO_COUNT (SWICC_NET_REACTOR_PRIO_LOW + 1U)
+
+/**
+ * A card hosted by a reactor. It is owned by the user and must stay valid for
+ * as long as the card is part of the reactor. Messages of the card are held in
+ * buffers borrowed from the pool of the thread running the reactor, only while
+ * they are handled.
+ */
+typedef struct swicc_net_reactor_card_s
+{
+    swicc_st *swicc_state;
+    swicc_net_client_st *client_ctx;
+
+    /* If the card is part of a reactor. */
+    bool connected;
+
+    /* Only used with io_uring. */
+    uint32_t uring_slot;
+    uint8_t uring_op; /* In flight, see 'swicc_net_reactor_uring_op_et'. */
+    bool uring_closed; /* Peer closed its side, stays until all is answered. */
+
+    /**
+     * Receive buffers (oldest first) whose data did not fit in the client yet,
+     * linked through 'uring_held_next' of the reactor. Nothing more is received
+     * while there are any.
+     */
+    uint16_t uring_held_head;
+    uint16_t uring_held_tail;
+
+    /* Set with 'swicc_net_reactor_card_sched_set'. */
+    swicc_net_reactor_prio_et prio;
+    uint32_t weight; /* Most messages handled in one turn of the card. */
+
+    /**
+     * Used by the scheduler. A card is ready (and waits in the run queue of its
+     * class) while it has a complete message buffered.
+     */
+    struct swicc_net_reactor_card_s *sched_next;
+    uint64_t sched_time; /* When the card joined the run queue. */
+    bool sched_ready;
+} swicc_net_reactor_card_st;
+
+/**
+ * Completions of io_uring refer to cards through slots (not pointers) so that
+ * completions which arrive after a card was removed can be recognized using
+ * the generation of the slot and then ignored.
+ */
+typedef struct swicc_net_reactor_uring_slot_s
+{
+    struct swicc_net_reactor_card_s *card; /* NULL when the slot is free. */
+    uint32_t gen;
+} swicc_net_reactor_uring_slot_st;
+
+/**
+ * A single-threaded event loop which drives many cards at once, each card using
+ * its own network client.
+ */
+typedef struct swicc_net_reactor_s
+{
+    swicc_net_reactor_backend_et backend;
+    int32_t fd_epoll;
+    swicc_net_uring_st uring;
+    swicc_net_reactor_uring_slot_st *uring_slot;
+    uint32_t uring_slot_count;
+    /* Links and data lengths of the held receive buffers, by buffer ID. */
+    uint16_t uring_held_next[SWICC_NET_URING_BUF_COUNT];
+    uint32_t uring_held_len[SWICC_NET_URING_BUF_COUNT];
+    uint32_t card_count;
+
+    /* Run queues of the ready cards, one per priority class. */
+    struct swicc_net_reactor_card_s *sched_head[SWICC_NET_REACTOR_PRIO_COUNT];
+    struct swicc_net_reactor_card_s *sched_tail[SWICC_NET_REACTOR_PRIO_COUNT];
+    uint32_t sched_count;
+
+    /**
+     * Time (in nanoseconds) after which a card has to give up its turn even
+     * when it has not used up its weight, and after which the scheduler stops
+     * giving out turns to poll for I/O again. A command is never interrupted
+     * so a turn can take longer by as much as the command that is running.
+     * Can be changed while the reactor is not running.
+     */
+    uint64_t budget;
+
+    /**
+     * Set to true to make the reactor return (e.g. from a signal handler or
+     * another thread).
+     */
+    _Atomic bool shutdown;
+} swicc_net_reactor_st;
+
 /**
  * @brief Basically a printf function.
  * @param fmt
@@ -95,6 +479,14 @@ typedef void swicc_net_logger_ft(char const *const fmt, ...);
  */
 void swicc_net_logger_register(swicc_net_logger_ft *const logger_func);
 
+/**
+ * @brief Register a logger only for the calling thread. It takes precedence
+ * over the logger registered using 'swicc_net_logger_register'.
+ * @param[in] logger_func Same as for 'swicc_net_logger_register', NULL to go
+ * back to using the logger of the process.
+ */
+void swicc_net_logger_register_thread(swicc_net_logger_ft *const logger_func);
+
 /**
  * @brief Helper for setting a signal handler (SIGINT, SIGHUP, SIGTERM). This is
  * useful as the network client is an infinite loop that will not return unless
@@ -135,11 +527,23 @@ void swicc_net_server_destroy(swicc_net_server_st *const server_ctx);
  * @param[in] hostname_str String of the server hostname.
  * @param[in] port_str String of the server port.
  * @return Return code.
- * @note Client socket is blocking.
+ * @note Client socket is blocking and has Nagle's algorithm disabled.
+ * @note Only errors get logged until the log level of the client is changed.
  */
 swicc_ret_et swicc_net_client_create(swicc_net_client_st *const client_ctx,
                                      char const *const hostname_str,
                                      char const *const port_str);
+/**
+ * @brief Create a network client which uses a shared-memory channel (created
+ * by a server on the same machine) instead of a TCP connection.
+ * @param[out] client_ctx The network client context that will be initialized.
+ * @param[in] shm_name Name of the shared-memory channel.
+ * @return Return code.
+ * @note Only errors get logged until the log level of the client is changed.
+ */
+swicc_ret_et swicc_net_client_create_shm(swicc_net_client_st *const client_ctx,
+                                         char const *const shm_name);
+
 /**
  * @brief Destroy the network client.
  * @param[in, out] client_ctx The client to destroy.
@@ -151,9 +555,24 @@ void swicc_net_client_destroy(swicc_net_client_st *const client_ctx);
  * @param[in] sock Where to receive from.
  * @param[out] msg Where to write the received message.
  * @return Return code.
+ * @note Blocks until the whole message is received, no matter in how many
+ * segments it arrives.
  */
 swicc_ret_et swicc_net_recv(int32_t const sock, swicc_net_msg_st *const msg);
 
+/**
+ * @brief Receive a message on a given socket along with the card it is from,
+ * see 'SWICC_NET_MSG_CTRL_CARD'.
+ * @param[in] sock Where to receive from.
+ * @param[out] msg Where to write the received message.
+ * @param[out] card Where the card of the message will be written.
+ * @return Return code.
+ * @note Blocks the same way 'swicc_net_recv' does.
+ */
+swicc_ret_et swicc_net_recv_card(int32_t const sock,
+                                 swicc_net_msg_st *const msg,
+                                 uint32_t *const card);
+
 /**
  * @brief Send a message to some socket.
  * @param[in] sock Where to send message.
@@ -163,6 +582,141 @@ swicc_ret_et swicc_net_recv(int32_t const sock, swicc_net_msg_st *const msg);
 swicc_ret_et swicc_net_send(int32_t const sock,
                             swicc_net_msg_st const *const msg);
 
+/**
+ * @brief Create a shared-memory channel, this is done by the server.
+ * @param[out] shm The channel end that will be initialized.
+ * @param[in] name Name of the channel, it must start with a '/' and contain no
+ * other '/' e.g. "/swicc-0".
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_shm_create(swicc_net_shm_st *const shm,
+                                  char const *const name);
+
+/**
+ * @brief Open a shared-memory channel that was created by a server, this is
+ * done by the client.
+ * @param[out] shm The channel end that will be initialized.
+ * @param[in] name Name of the channel.
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_shm_open(swicc_net_shm_st *const shm,
+                                char const *const name);
+
+/**
+ * @brief Close one end of a shared-memory channel. The peer gets woken up and
+ * sees the channel as disconnected. The server also removes the name of the
+ * channel.
+ * @param[in, out] shm
+ */
+void swicc_net_shm_destroy(swicc_net_shm_st *const shm);
+
+/**
+ * @brief Send a message over a shared-memory channel. Servers send requests and
+ * clients send responses.
+ * @param[in, out] shm
+ * @param[in] msg
+ * @return Return code.
+ * @note Blocks while the queue is full.
+ */
+swicc_ret_et swicc_net_shm_send(swicc_net_shm_st *const shm,
+                                swicc_net_msg_st const *const msg);
+
+/**
+ * @brief Receive a message from a shared-memory channel.
+ * @param[in, out] shm
+ * @param[out] msg
+ * @return Return code.
+ * @note Blocks until a message arrives, the peer closes the channel, or a
+ * signal is received.
+ */
+swicc_ret_et swicc_net_shm_recv(swicc_net_shm_st *const shm,
+                                swicc_net_msg_st *const msg);
+
+/**
+ * @brief Create an io_uring with a group of provided receive buffers.
+ * @param[out] uring
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_uring_create(swicc_net_uring_st *const uring);
+
+/**
+ * @brief Destroy an io_uring, operations in flight get cancelled.
+ * @param[in, out] uring
+ */
+void swicc_net_uring_destroy(swicc_net_uring_st *const uring);
+
+/**
+ * @brief Queue a multishot receive on a socket which uses the provided
+ * buffers.
+ * @param[in, out] uring
+ * @param[in] sock
+ * @param[in] user_data Will be part of every completion of the receive.
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_uring_recv(swicc_net_uring_st *const uring,
+                                  int32_t const sock, uint64_t const user_data);
+
+/**
+ * @brief Queue a send on a socket.
+ * @param[in, out] uring
+ * @param[in] sock
+ * @param[in] buf Must stay valid until the send completes.
+ * @param[in] buf_len
+ * @param[in] user_data Will be part of the completion.
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_uring_send(swicc_net_uring_st *const uring,
+                                  int32_t const sock, uint8_t const *const buf,
+                                  uint32_t const buf_len,
+                                  uint64_t const user_data);
+
+/**
+ * @brief Queue the cancellation of an operation.
+ * @param[in, out] uring
+ * @param[in] user_data Of the operation to cancel.
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_uring_cancel(swicc_net_uring_st *const uring,
+                                    uint64_t const user_data);
+
+/**
+ * @brief Submit everything that was queued and cancel an operation, waiting
+ * until it is done e.g. so that the buffer of a send can be reused.
+ * @param[in, out] uring
+ * @param[in] user_data Of the operation to cancel.
+ * @return Return code. An operation that already completed is not an error,
+ * its completion is left in the queue like the one of a cancelled operation.
+ */
+swicc_ret_et swicc_net_uring_cancel_sync(swicc_net_uring_st *const uring,
+                                         uint64_t const user_data);
+
+/**
+ * @brief Submit everything that was queued and wait for at least one
+ * completion.
+ * @param[in, out] uring
+ * @param[in] timeout_ms How long to wait at most.
+ * @return Return code. A timeout or interruption is not an error.
+ */
+swicc_ret_et swicc_net_uring_wait(swicc_net_uring_st *const uring,
+                                  uint32_t const timeout_ms);
+
+/**
+ * @brief Get the next completion.
+ * @param[in, out] uring
+ * @param[out] cqe
+ * @return true if a completion was written, false if there are none.
+ */
+bool swicc_net_uring_next(swicc_net_uring_st *const uring,
+                          swicc_net_uring_cqe_st *const cqe);
+
+/**
+ * @brief Give the buffer of a completion back to the kernel.
+ * @param[in, out] uring
+ * @param[in] cqe
+ */
+void swicc_net_uring_buf_release(swicc_net_uring_st *const uring,
+                                 swicc_net_uring_cqe_st const *const cqe);
+
 /**
  * @brief Attempt to accept a client connection. Since the server socket is
  * non-blocking, this will indicate if no clients were present in queue, if a
@@ -177,13 +731,115 @@ swicc_ret_et swicc_net_server_client_connect(
     swicc_net_server_st *const server_ctx, uint16_t const slot);
 
 /**
- * @brief Disconnect a client from a server.
+ * @brief Use a socket that is already connected to a client, e.g. one accepted
+ * elsewhere or one end of a socket pair, as the client of a slot. The slot is
+ * card 0 of the connection, like after 'swicc_net_server_client_connect'.
+ * @param[in, out] server_ctx
+ * @param[in] slot The unused slot that will be assigned the connection.
+ * @param[in] sock Connected socket. The server owns it from here on and closes
+ * it when the client gets disconnected.
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_server_client_adopt(
+    swicc_net_server_st *const server_ctx, uint16_t const slot,
+    int32_t const sock);
+
+/**
+ * @brief Disconnect a client from a server. This closes the connection so all
+ * the slots that share it are freed as well.
  * @param[in, out] server_ctx
  * @param[in] slot Which client to disconnect.
  */
 void swicc_net_server_client_disconnect(swicc_net_server_st *const server_ctx,
                                         uint16_t const slot);
 
+/**
+ * @brief Use another card of an already connected (multiplexing) client as a
+ * new slot.
+ * @param[in, out] server_ctx
+ * @param[in] slot The unused slot that will be assigned the card.
+ * @param[in] slot_conn A slot with a connected client.
+ * @param[in] card Which card on the connection to use.
+ * @return Return code. Param bad when the card already has a slot.
+ */
+swicc_ret_et swicc_net_server_slot_attach(swicc_net_server_st *const server_ctx,
+                                          uint16_t const slot,
+                                          uint16_t const slot_conn,
+                                          uint32_t const card);
+
+/**
+ * @brief Find the slot of a card on a connection, e.g. to find out which slot a
+ * response received using 'swicc_net_recv_card' belongs to.
+ * @param[in, out] server_ctx
+ * @param[in] sock Socket of the connection.
+ * @param[in] card Card the message is from.
+ * @param[out] slot Where the slot will be written.
+ * @return Return code.
+ * @note A slot that is found counts as traffic of its connection for the
+ * keep-alive.
+ */
+swicc_ret_et swicc_net_server_slot_find(
+    swicc_net_server_st *const server_ctx, int32_t const sock,
+    uint32_t const card, uint16_t *const slot);
+
+/**
+ * @brief Send a request to the card in a slot.
+ * @param[in] server_ctx
+ * @param[in] slot
+ * @param[in] msg
+ * @return Return code.
+ * @note For cards other than 0, the request is preceded by a card message.
+ */
+swicc_ret_et swicc_net_server_slot_send(
+    swicc_net_server_st const *const server_ctx, uint16_t const slot,
+    swicc_net_msg_st const *const msg);
+
+/**
+ * @brief Receive the response of the card in a slot. A response counts as
+ * traffic of its connection for the keep-alive.
+ * @param[in, out] server_ctx
+ * @param[in] slot
+ * @param[out] msg
+ * @return Return code.
+ * @note Only one request may be pending per connection when using this. When
+ * requests are sent to many slots of one connection at once, the responses
+ * have to be received using 'swicc_net_recv_card' and then matched to slots
+ * using 'swicc_net_server_slot_find'.
+ */
+swicc_ret_et swicc_net_server_slot_recv(
+    swicc_net_server_st *const server_ctx, uint16_t const slot,
+    swicc_net_msg_st *const msg);
+
+/**
+ * @brief Change how long a connection of a server may be idle before it gets
+ * probed. Can be changed at any time, all timers are re-armed from the next
+ * poll.
+ * @param[in, out] server_ctx
+ * @param[in] idle Milliseconds, 0 disables the keep-alive.
+ */
+void swicc_net_server_keepalive_set(swicc_net_server_st *const server_ctx,
+                                    uint32_t const idle);
+
+/**
+ * @brief Advance the keep-alive timers of a server and get the connections
+ * that were idle for at least the idle time. There is one slot per connection
+ * no matter how many cards it carries. The caller probes each one, e.g. with a
+ * keep-alive message using 'swicc_net_server_slot_send' and
+ * 'swicc_net_server_slot_recv', and disconnects it when the probe fails.
+ * @param[in, out] server_ctx
+ * @param[in] now Current time in milliseconds, from a monotonic clock.
+ * @param[out] slot Where the slots to probe will be written.
+ * @param[in] slot_size Number of slots that fit in the buffer.
+ * @param[out] slot_count Where the number of slots written will be written.
+ * @return Return code.
+ * @note Connections that are due but don't fit in the buffer are returned by
+ * the next poll. A connection is probed between 1 and 2 idle times after its
+ * last traffic.
+ */
+swicc_ret_et swicc_net_server_keepalive_poll(
+    swicc_net_server_st *const server_ctx, uint64_t const now,
+    uint16_t *const slot, uint32_t const slot_size, uint32_t *const slot_count);
+
 /**
  * @brief An implementation of a complete network client with a receive loop
  * which gets messages, processes them using swICC functions, and sends back a
@@ -196,3 +852,119 @@ void swicc_net_server_client_disconnect(swicc_net_server_st *const server_ctx,
  */
 swicc_ret_et swicc_net_client(swicc_st *const swicc_state,
                               swicc_net_client_st *const client_ctx);
+
+/**
+ * @brief Same as 'swicc_net_client' except that the connection carries many
+ * cards. A message for card N (see 'SWICC_NET_MSG_CTRL_CARD') is handled by the
+ * Nth swICC state and the response is sent back for the same card.
+ * @param[in, out] swicc_state Array of initialized swICC states.
+ * @param[in] card_count Number of states in the array.
+ * @param[in, out] client_ctx An initialized network client context.
+ * @return Return code.
+ * @note Returns once any of the states has been asked to shut down.
+ */
+swicc_ret_et swicc_net_client_mux(swicc_st *const *const swicc_state,
+                                  uint32_t const card_count,
+                                  swicc_net_client_st *const client_ctx);
+
+/**
+ * @brief Perform all the work of a client that can be done without blocking.
+ * This receives whatever is available on the socket, handles every complete
+ * message, and sends as much of the responses as the socket accepts. Responses
+ * which could not be sent yet are queued and sent on the next step. This lets a
+ * client be driven by an external event loop.
+ * @param[in, out] swicc_state An initialized swICC state.
+ * @param[in, out] client_ctx An initialized network client context (using a
+ * socket).
+ * @param[out] ready Where the readiness mask will be written. It is a
+ * combination of 'swicc_net_ready_et' flags and says when the client shall be
+ * stepped next.
+ * @return Return code. On a disconnect or error, the client shall be
+ * destroyed.
+ */
+swicc_ret_et swicc_net_client_step(swicc_st *const swicc_state,
+                                   swicc_net_client_st *const client_ctx,
+                                   uint8_t *const ready);
+
+/**
+ * @brief Create a reactor which can host many cards in one thread.
+ * @param[out] reactor The reactor that will be initialized.
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_reactor_create(swicc_net_reactor_st *const reactor);
+
+/**
+ * @brief Create a reactor which uses io_uring instead of epoll. Receives stay
+ * posted all the time (multishot) and sends of all cards are submitted
+ * together, so handling a message needs almost no syscalls.
+ * @param[out] reactor The reactor that will be initialized.
+ * @return Return code.
+ * @note The network client of a card removed from such a reactor shall stay
+ * valid until the reactor is run again or destroyed since a send from its
+ * buffer may still be in flight.
+ */
+swicc_ret_et swicc_net_reactor_create_uring(
+    swicc_net_reactor_st *const reactor);
+
+/**
+ * @brief Destroy a reactor. The network clients of the cards are not destroyed
+ * by this.
+ * @param[in, out] reactor
+ */
+void swicc_net_reactor_destroy(swicc_net_reactor_st *const reactor);
+
+/**
+ * @brief Add a card to a reactor.
+ * @param[in, out] reactor
+ * @param[out] card Context of the card inside the reactor. It will be
+ * initialized by this function.
+ * @param[in, out] swicc_state An initialized swICC state. The RX and TX
+ * buffers are only set while a message of the card is handled.
+ * @param[in, out] client_ctx An initialized (connected) network client context.
+ * @return Return code.
+ */
+swicc_ret_et swicc_net_reactor_card_add(swicc_net_reactor_st *const reactor,
+                                        swicc_net_reactor_card_st *const card,
+                                        swicc_st *const swicc_state,
+                                        swicc_net_client_st *const client_ctx);
+
+/**
+ * @brief Remove a card from a reactor. The network client of the card is not
+ * destroyed by this.
+ * @param[in, out] reactor
+ * @param[in, out] card
+ */
+void swicc_net_reactor_card_remove(swicc_net_reactor_st *const reactor,
+                                   swicc_net_reactor_card_st *const card);
+
+/**
+ * @brief Set how a card gets scheduled. Every card starts with the normal
+ * priority class and a weight of 1.
+ * @param[in, out] reactor
+ * @param[in, out] card A card of the reactor.
+ * @param[in] prio Priority class of the card.
+ * @param[in] weight Most messages the card gets to handle in one turn, which
+ * is how much of the time of its class the card gets when it stays busy.
+ * @return Return code.
+ * @note Only the thread running the reactor may do this while it's running.
+ */
+swicc_ret_et swicc_net_reactor_card_sched_set(
+    swicc_net_reactor_st *const reactor, swicc_net_reactor_card_st *const card,
+    swicc_net_reactor_prio_et const prio, uint32_t const weight);
+
+/**
+ * @brief Run the reactor. Messages are received on every card without
+ * blocking and once a whole message is received, the card waits for its turn
+ * to process it using swICC functions and send back the response. Turns go
+ * round-robin over the ready cards of the highest priority class that has any,
+ * each card handling up to its weight of messages within the time budget, so
+ * one busy card can't hold up the others of its class by more than one turn.
+ * @param[in, out] reactor
+ * @return Return code.
+ * @note This returns once shutdown of the reactor is requested or when all
+ * cards were removed. Cards which get disconnected, fail, or get shutdown
+ * requested (checked whenever the card receives data) are removed from the
+ * reactor. Check the 'connected' member of a card to see if it's still part of
+ * the reactor.
+ */
+swicc_ret_et swicc_net_reactor_run(swicc_net_reactor_st *const reactor);
@@ -0,0 +1,68 @@
+#pragma once
+/**
+ * Pools of equally sized buffers. Buffers which are only needed while a command
+ * is in flight (network messages, short responses...) are borrowed from a pool
+ * instead of being part of every card, so a host with many cards only keeps as
+ * many of them as there are commands in flight. Free buffers are linked
+ * through their first bytes so an idle buffer costs nothing on top of itself.
+ *
+ * Every thread has a pool of its own (see 'swicc_pool_thread') so borrowing
+ * does not need locks. A buffer can be given back to the pool of any thread.
+ */
+
+#include "swicc/common.h"
+
+/**
+ * Size of the buffers in the pool of a thread. Large enough for a network
+ * message or a short response.
+ */
+#define SWICC_POOL_BUF_SIZE 512U
+
+/* How many free buffers the pool of a thread keeps around at most. */
+#define SWICC_POOL_THREAD_FREE_COUNT_MAX 64U
+
+typedef struct swicc_pool_s
+{
+    void *free; /* Free buffers, each begins with a pointer to the next one. */
+    uint32_t free_count;
+    uint32_t free_count_max; /* Returned buffers past this are freed. */
+    uint32_t buf_size;
+} swicc_pool_st;
+
+/**
+ * @brief Create an empty pool.
+ * @param[out] pool
+ * @param[in] buf_size Size of the buffers. Raised to the size of a pointer when
+ * smaller.
+ * @param[in] free_count_max How many free buffers to keep at most.
+ */
+void swicc_pool_init(swicc_pool_st *const pool, uint32_t const buf_size,
+                     uint32_t const free_count_max);
+
+/**
+ * @brief Borrow a buffer from a pool (it gets allocated if none is free).
+ * @param[in, out] pool
+ * @return The buffer or NULL on failure.
+ */
+void *swicc_pool_get(swicc_pool_st *const pool);
+
+/**
+ * @brief Give back a buffer to a pool.
+ * @param[in, out] pool
+ * @param[in] buf Must have been borrowed from a pool with the same buffer size.
+ * Can be NULL.
+ */
+void swicc_pool_put(swicc_pool_st *const pool, void *const buf);
+
+/**
+ * @brief Free all free buffers of a pool.
+ * @param[in, out] pool
+ */
+void swicc_pool_empty(swicc_pool_st *const pool);
+
+/**
+ * @brief Get the pool of the calling thread. Its free buffers are freed when
+ * the thread exits.
+ * @return The pool, its buffers have a size of SWICC_POOL_BUF_SIZE.
+ */
+swicc_pool_st *swicc_pool_thread(void);
@@ -0,0 +1,95 @@
+#pragma once
+/**
+ * A multi-threaded runtime for hosting many cards in one process. Cards are
+ * split into shards and every shard is driven by its own reactor running on a
+ * worker thread pinned to a core. Shards share nothing so cards of different
+ * shards never have to synchronize. Within a shard, the reactor schedules the
+ * cards fairly (see 'swicc_net_reactor_card_sched_set') and the queue delay of
+ * every card is counted in its stats block.
+ */
+
+#include "swicc/common.h"
+#include "swicc/net.h"
+#include <pthread.h>
+
+/* Maximum number of shards (worker threads) a runtime can have. */
+#define SWICC_RUNTIME_SHARD_COUNT_MAX 256U
+
+typedef struct swicc_runtime_shard_s
+{
+    swicc_net_reactor_st reactor;
+    pthread_t thread;
+    uint32_t core; /* Which core the worker thread is pinned to. */
+
+    /**
+     * Logger used by the worker thread, NULL to use the one of the process.
+     * Must be set before starting the runtime.
+     */
+    swicc_net_logger_ft *logger;
+
+    swicc_ret_et ret; /* What the reactor returned once it stopped. */
+} swicc_runtime_shard_st;
+
+typedef struct swicc_runtime_s
+{
+    swicc_runtime_shard_st shard[SWICC_RUNTIME_SHARD_COUNT_MAX];
+    uint32_t shard_count;
+    bool running;
+} swicc_runtime_st;
+
+/**
+ * @brief Create a runtime.
+ * @param[out] runtime The runtime that will be initialized.
+ * @param[in] shard_count How many shards (worker threads) to use, 0 to use one
+ * per online core.
+ * @return Return code.
+ */
+swicc_ret_et swicc_runtime_create(swicc_runtime_st *const runtime,
+                                  uint32_t const shard_count);
+
+/**
+ * @brief Destroy a runtime. It must not be running. The cards and their network
+ * clients are not destroyed.
+ * @param[in, out] runtime
+ */
+void swicc_runtime_destroy(swicc_runtime_st *const runtime);
+
+/**
+ * @brief Add a card to the shard with the fewest cards.
+ * @param[in, out] runtime
+ * @param[out] card Context of the card inside the runtime, same as for
+ * 'swicc_net_reactor_card_add'.
+ * @param[in, out] swicc_state An initialized swICC state.
+ * @param[in, out] client_ctx An initialized (connected) network client.
+ * @return Return code.
+ * @note Cards can only be added while the runtime is not running.
+ */
+swicc_ret_et swicc_runtime_card_add(swicc_runtime_st *const runtime,
+                                    swicc_net_reactor_card_st *const card,
+                                    swicc_st *const swicc_state,
+                                    swicc_net_client_st *const client_ctx);
+
+/**
+ * @brief Start a worker thread for every shard. The workers block the signals
+ * handled by 'swicc_net_client_sig_register' so these get delivered to the
+ * other threads of the process.
+ * @param[in, out] runtime
+ * @return Return code.
+ */
+swicc_ret_et swicc_runtime_start(swicc_runtime_st *const runtime);
+
+/**
+ * @brief Ask all workers to stop. Returns immediately, use
+ * 'swicc_runtime_wait' to wait for the workers to stop.
+ * @param[in, out] runtime
+ * @note Safe to call from a signal handler.
+ */
+void swicc_runtime_stop(swicc_runtime_st *const runtime);
+
+/**
+ * @brief Wait for all workers to stop. This happens once stop was requested or
+ * once all cards of a shard have disconnected.
+ * @param[in, out] runtime
+ * @return Return code. Success only if all the reactors stopped without error.
+ */
+swicc_ret_et swicc_runtime_wait(swicc_runtime_st *const runtime);
@@ -0,0 +1,153 @@
+#pragma once
+/**
+ * Counters of what a card is doing. A card only counts when it was given a
+ * stats block (see 'stats' of the swICC state), then a command costs a few
+ * increments and two reads of the monotonic clock. Counters are only written
+ * by the thread running the card but can be read by any thread at any time,
+ * e.g. to aggregate the blocks of all cards of a host into one snapshot.
+ */
+
+#include "swicc/apduh.h"
+#include "swicc/common.h"
+#include "swicc/fsm.h"
+#include <stdatomic.h>
+
+/* Number of CLA types, see 'swicc_apdu_cla_type_et'. */
+#define SWICC_STATS_CLA_TYPE_COUNT (SWICC_APDU_CLA_TYPE_RFU + 1U)
+
+/* Number of FSM states, see 'swicc_fsm_state_et'. */
+#define SWICC_STATS_FSM_STATE_COUNT (SWICC_FSM_STATE_BLOCK + 1U)
+
+/**
+ * Range of SW1 values (warnings and most errors) for which the SW2 is a
+ * qualifier and so is counted as well. For all other SW1 values, the SW2 is
+ * either a length or always 0.
+ */
+#define SWICC_STATS_SW2_SW1_FIRST 0x62U
+#define SWICC_STATS_SW2_SW1_LAST 0x6AU
+#define SWICC_STATS_SW2_SW1_COUNT                                              \
+    (SWICC_STATS_SW2_SW1_LAST - SWICC_STATS_SW2_SW1_FIRST + 1U)
+
+/**
+ * Number of buckets of the latency histograms. Bucket 0 holds latencies
+ * below 2ns, bucket N latencies in [2^N, 2^(N+1)) ns, and the last bucket
+ * also everything longer.
+ */
+#define SWICC_STATS_LAT_BUCKET_COUNT 32U
+
+typedef _Atomic uint64_t swicc_stats_ctr_kt;
+
+typedef struct swicc_stats_s
+{
+    /* Commands by CLA type. */
+    swicc_stats_ctr_kt cmd_cla[SWICC_STATS_CLA_TYPE_COUNT];
+
+    /**
+     * Commands by CLA type (interindustry then proprietary) and INS, along
+     * with the time spent in their handlers in nanoseconds (total and
+     * longest call).
+     */
+    swicc_stats_ctr_kt cmd_ins[SWICC_APDUH_CLA_TYPE_COUNT]
+                              [SWICC_APDUH_INS_COUNT];
+    swicc_stats_ctr_kt cmd_ins_time[SWICC_APDUH_CLA_TYPE_COUNT]
+                                   [SWICC_APDUH_INS_COUNT];
+    swicc_stats_ctr_kt cmd_ins_time_max[SWICC_APDUH_CLA_TYPE_COUNT]
+                                       [SWICC_APDUH_INS_COUNT];
+
+    /* Status words of responses (procedure bytes are not counted). */
+    swicc_stats_ctr_kt sw1[UINT8_MAX + 1U];
+    swicc_stats_ctr_kt sw2[SWICC_STATS_SW2_SW1_COUNT][UINT8_MAX + 1U];
+
+    /* Latency of every call of a handler, and their sum in nanoseconds. */
+    swicc_stats_ctr_kt lat[SWICC_STATS_LAT_BUCKET_COUNT];
+    swicc_stats_ctr_kt lat_sum;
+
+    /* How many times the FSM entered each state. */
+    swicc_stats_ctr_kt fsm[SWICC_STATS_FSM_STATE_COUNT];
+    swicc_stats_ctr_kt reset;
+
+    /* Messages handled by the network client (including the headers). */
+    swicc_stats_ctr_kt net_rx_msg;
+    swicc_stats_ctr_kt net_rx_byte;
+    swicc_stats_ctr_kt net_tx_msg;
+    swicc_stats_ctr_kt net_tx_byte;
+
+    /**
+     * How long the card waited for its turn in the scheduler of a reactor
+     * once it had a complete message (queue delay), their sum in nanoseconds,
+     * and how many turns ended with messages still waiting.
+     */
+    swicc_stats_ctr_kt sched_delay[SWICC_STATS_LAT_BUCKET_COUNT];
+    swicc_stats_ctr_kt sched_delay_sum;
+    swicc_stats_ctr_kt sched_yield;
+} swicc_stats_st;
+
+/**
+ * @brief Set all counters to 0.
+ * @param[out] stats
+ * @note Must not be used while the card is counting into the block.
+ */
+void swicc_stats_reset(swicc_stats_st *const stats);
+
+/**
+ * @brief Add to a counter. Only the thread running the card may do this.
+ * @param[in, out] ctr
+ * @param[in] val
+ */
+void swicc_stats_add(swicc_stats_ctr_kt *const ctr, uint64_t const val);
+
+/**
+ * @brief Raise a counter holding a maximum. Only the thread running the card
+ * may do this.
+ * @param[in, out] ctr
+ * @param[in] val
+ */
+void swicc_stats_max(swicc_stats_ctr_kt *const ctr, uint64_t const val);
+
+/**
+ * @brief Get the time used for measuring latencies.
+ * @return Monotonic time in nanoseconds.
+ */
+uint64_t swicc_stats_time(void);
+
+/**
+ * @brief Record one call of a handler.
+ * @param[in, out] stats
+ * @param[in] cla_type Index of the CLA type (0 for interindustry, 1 for
+ * proprietary).
+ * @param[in] ins
+ * @param[in] time How long the call took in nanoseconds.
+ */
+void swicc_stats_handler(swicc_stats_st *const stats, uint8_t const cla_type,
+                         uint8_t const ins, uint64_t const time);
+
+/**
+ * @brief Record one turn of a card in the scheduler of a reactor.
+ * @param[in, out] stats
+ * @param[in] delay How long the card waited for the turn in nanoseconds.
+ */
+void swicc_stats_sched(swicc_stats_st *const stats, uint64_t const delay);
+
+/**
+ * @brief Aggregate the counters of many cards.
+ * @param[out] snapshot Receives the sum of all counters (and the largest of
+ * the maximums).
+ * @param[in] stats Array of blocks to aggregate. They can be in use by their
+ * cards while doing this.
+ * @param[in] stats_count Number of blocks in the array.
+ */
+void swicc_stats_snapshot(swicc_stats_st *const snapshot,
+                          swicc_stats_st *const *const stats,
+                          uint32_t const stats_count);
+
+/**
+ * @brief Export counters in the text format of Prometheus. Labelled series
+ * whose counter is 0 are left out.
+ * @param[in] stats Usually a snapshot.
+ * @param[out] buf Where the text is written, it is null-terminated.
+ * @param[in, out] buf_len Size of the buffer on input, length of the text
+ * (without the null-terminator) on output.
+ * @return Return code.
+ */
+swicc_ret_et swicc_stats_prom(swicc_stats_st const *const stats,
+                              char *const buf, uint32_t *const buf_len);
@@ -1,17 +1,29 @@
 #pragma once
 
+#include "swicc/alloc.h"
 #include "swicc/apdu.h"
 #include "swicc/apduh.h"
 #include "swicc/atr.h"
+#include "swicc/capture.h"
+#include "swicc/checkpoint.h"
+#include "swicc/crc32c.h"
 #include "swicc/dato.h"
 #include "swicc/dbg.h"
 #include "swicc/fs.h"
 #include "swicc/fsm.h"
 #include "swicc/io.h"
+#include "swicc/lz4.h"
 #include "swicc/mock.h"
 #include "swicc/net.h"
+#include "swicc/pool.h"
 #include "swicc/pps.h"
+#include "swicc/runtime.h"
+#include "swicc/stats.h"
+#include "swicc/t1.h"
 #include "swicc/tpdu.h"
+#include "swicc/trace.h"
+#include "swicc/wire.h"
+#include <stdatomic.h>
 
 /* For holding transmission protocol configuration. */
 typedef struct swicc_tp_s
@@ -29,15 +41,42 @@ typedef struct swicc_tp_s
     uint16_t fi;
     uint32_t fmax;
     uint8_t di;
+
+    uint8_t t; /* Transmission protocol type: 0 or 1. */
 } swicc_tp_st;
 
 /* Anything that is part of the file system is held here. */
 typedef struct swicc_fs_s
 {
+    /* VA of the logical channel that is current (the one of the command). */
     swicc_va_st va;
     swicc_disk_st disk;
+
+    /**
+     * VAs of the logical channels that are open but not current. Switching a
+     * channel only swaps its VA with the current one so handlers keep using
+     * 'va' no matter which channel a command came on.
+     */
+    swicc_va_st va_lchan[SWICC_VA_LCHAN_COUNT];
+    /* Bit N is set when channel N is open. The basic channel is always open. */
+    uint32_t lchan_open;
+    uint8_t lchan_cur;
+
+    /* Disk hot-swap in progress (see 'swicc_fs_disk_swap'). */
+    swicc_fs_swap_st swap;
 } swicc_fs_st;
 
+/**
+ * State of one card. Per-card memory budget on x86-64: the state itself takes
+ * about 12 KiB, mostly the VAs of the logical channels (5.6 KiB), the table of
+ * instruction handlers (4 KiB), and the T=1 state (1 KiB). Buffers which are
+ * only needed while a command is in flight (messages of a reactor card and
+ * short responses) are borrowed from the pool of the thread (see
+ * 'swicc_pool_thread') so they cost SWICC_POOL_BUF_SIZE bytes per command in
+ * flight instead of per card. On top of this, a card needs its disk (trees and
+ * LUTs, or only the overlays when sharing a base disk) and when it's on the
+ * network, a client context (2.3 KiB, mostly connection buffers).
+ */
 typedef struct swicc_s
 {
     /**
@@ -88,6 +127,31 @@ typedef struct swicc_s
     swicc_fs_st fs;
     swicc_apdu_rc_st apdu_rc;
 
+    /**
+     * Handlers registered for single instructions, by CLA type (interindustry
+     * then proprietary) and INS. Kept across resets like the other handlers.
+     */
+    swicc_apduh_ft
+        *apduh_tbl[SWICC_APDUH_CLA_TYPE_COUNT][SWICC_APDUH_INS_COUNT];
+
+    /**
+     * Trace ring where the card records what it is doing. NULL disables
+     * tracing.
+     */
+    swicc_trace_st *trace;
+
+    /* Counters of what the card is doing. NULL disables counting. */
+    swicc_stats_st *stats;
+
+    /* Capture of the traffic of the card. NULL disables capturing. */
+    swicc_capture_st *capture;
+
+    /**
+     * Accounting of the time the traffic of the card would take on a physical
+     * link. NULL disables the accounting.
+     */
+    swicc_wire_st *wire;
+
     /* This shall not be modified by anything other than the swICC framework. */
     struct
     {
@@ -120,9 +184,23 @@ typedef struct swicc_s
          */
         uint32_t procedure_count;
 
+        /* State a handler keeps in between the phases of the command. */
+        swicc_apduh_ctx_st apduh_ctx;
+
+        /**
+         * Set while the handler of the current command is waiting for an
+         * external operation. The done flag can be set from any thread.
+         */
+        bool apduh_pending;
+        _Atomic bool apduh_pending_done;
+
+        /* State of a C-APDU handled in one go (over T=1 or directly). */
+        swicc_apduh_exec_st apduh_exec;
+
         swicc_fsm_state_et fsm_state;
 
         swicc_tp_st tp;
+        swicc_t1_st t1; /* Only used once T=1 was selected with a PPS. */
 
         swicc_apduh_ft *apduh_pro;      /* For all proprietary classes. */
         swicc_apduh_ft *apduh_override; /* For overriding responses before the
@@ -0,0 +1,93 @@
+#pragma once
+/**
+ * T=1 is the half-duplex block transmission protocol described in ISO/IEC
+ * 7816-3:2006 clause.11. A whole APDU (and its response) travels in the
+ * information field of I-blocks, chained if it does not fit in one block.
+ */
+
+#include "swicc/common.h"
+
+/* Length of the prologue field: NAD, PCB, and LEN. */
+#define SWICC_T1_PROLOGUE_LEN 3U
+
+/* Information field sizes are at most 254. ISO/IEC 7816-3:2006 clause.11.4.2 */
+#define SWICC_T1_IFS_MAX 254U
+
+/* IFSC and IFSD are 32 until indicated otherwise. */
+#define SWICC_T1_IFS_DEFAULT 32U
+
+/* IFSC offered by the card in TA3 of the ATR. */
+#define SWICC_T1_IFSC SWICC_T1_IFS_MAX
+
+/* Prologue, information field, and the LRC as the epilogue. */
+#define SWICC_T1_BLK_LEN_MAX                                                   \
+    (SWICC_T1_PROLOGUE_LEN + SWICC_T1_IFS_MAX + 1U)
+
+/* A short C-APDU: header, Lc, data, and Le. */
+#define SWICC_T1_CAPDU_LEN_MAX (4U + 1U + SWICC_DATA_MAX + 1U)
+
+/* R-APDU: data, SW1, and SW2. */
+#define SWICC_T1_RAPDU_LEN_MAX (SWICC_DATA_MAX + 2U)
+
+typedef struct swicc_t1_s
+{
+    uint8_t ifsc;
+    uint8_t ifsd; /* Received from the interface with an S(IFS request). */
+
+    uint8_t ns_tx; /* N(S) of the next I-block sent by the card. */
+    uint8_t ns_rx; /* N(S) expected in the next I-block from the interface. */
+
+    /* Block being received, kept until it is complete. */
+    uint8_t blk_rx[SWICC_T1_BLK_LEN_MAX];
+    uint16_t blk_rx_len;
+
+    /* Last block that was sent, for retransmission. */
+    uint8_t blk_tx[SWICC_T1_BLK_LEN_MAX];
+    uint16_t blk_tx_len;
+
+    /* The C-APDU received so far, possibly over several chained I-blocks. */
+    uint8_t capdu[SWICC_T1_CAPDU_LEN_MAX];
+    uint16_t capdu_len;
+
+    /* Set while the C-APDU is being handled (e.g. a handler is pending). */
+    bool exec;
+
+    /* The R-APDU and how much of it has been sent in I-blocks. */
+    uint8_t rapdu[SWICC_T1_RAPDU_LEN_MAX];
+    uint16_t rapdu_len;
+    uint16_t rapdu_offset;
+} swicc_t1_st;
+
+/**
+ * @brief Reset the protocol state as done when T=1 gets selected.
+ * @param[out] t1
+ */
+void swicc_t1_reset(swicc_t1_st *const t1);
+
+/**
+ * @brief Compute the expected length of a block.
+ * @param[in] blk A complete or partial block. It must contain at least the
+ * prologue for this function to work.
+ * @param[in] blk_len Length of the given block.
+ * @param[out] blk_len_exp Where the expected block length will be written.
+ * @return Return code.
+ */
+swicc_ret_et swicc_t1_blk_len(uint8_t const *const blk, uint16_t const blk_len,
+                              uint16_t *const blk_len_exp);
+
+/**
+ * @brief Handle a block received from the interface and create the block to
+ * send back. I-blocks carrying the end of a C-APDU get handled by the APDU
+ * demux, a pending handler gets resumed when the interface answers the WTX
+ * requests sent in the meantime.
+ * @param[in, out] swicc_state
+ * @param[in] blk Received block.
+ * @param[in] blk_len Length of the received block.
+ * @param[out] buf_tx Where the block to send will be written.
+ * @param[in, out] buf_tx_len Must contain the size of the TX buffer. It will
+ * get the length of the block to send.
+ * @return Return code.
+ */
+swicc_ret_et swicc_t1_blk(swicc_st *const swicc_state, uint8_t const *const blk,
+                          uint16_t const blk_len, uint8_t *const buf_tx,
+                          uint16_t *const buf_tx_len);
@@ -0,0 +1,94 @@
+#pragma once
+/**
+ * Binary tracing of what a card is doing. Events are recorded in a compact
+ * binary form into a single-producer, single-consumer, lock-free ring buffer
+ * and formatted later (if at all) by a consumer e.g. a separate thread or a
+ * post-mortem dump. The card is the producer and never blocks, when the ring
+ * is full, new events are dropped and counted.
+ */
+
+#include "swicc/common.h"
+#include <stdatomic.h>
+
+/* Number of events the ring can hold. Must be a power of 2. */
+#define SWICC_TRACE_EVT_COUNT 256U
+static_assert((SWICC_TRACE_EVT_COUNT & (SWICC_TRACE_EVT_COUNT - 1U)) == 0U,
+              "Trace event count must be a power of 2.");
+
+typedef enum swicc_trace_evt_type_e
+{
+    SWICC_TRACE_EVT_TYPE_INVALID = 0,
+    SWICC_TRACE_EVT_TYPE_APDU_CMD, /* Header of a command was received. */
+    SWICC_TRACE_EVT_TYPE_APDU_RES, /* A response or procedure was sent. */
+    SWICC_TRACE_EVT_TYPE_FSM,      /* The FSM changed state. */
+} swicc_trace_evt_type_et;
+
+typedef struct swicc_trace_evt_s
+{
+    uint64_t time; /* Monotonic time in nanoseconds. */
+    uint8_t type;  /* One of swicc_trace_evt_type_et. */
+    union {
+        struct
+        {
+            uint8_t cla;
+            uint8_t ins;
+            uint8_t p1;
+            uint8_t p2;
+            uint8_t p3;
+        } apdu_cmd;
+        struct
+        {
+            uint8_t sw1;
+            uint8_t sw2;
+            uint16_t data_len; /* Length of data sent along with the status. */
+        } apdu_res;
+        struct
+        {
+            uint8_t state_old; /* One of swicc_fsm_state_et. */
+            uint8_t state_new; /* One of swicc_fsm_state_et. */
+        } fsm;
+    };
+} swicc_trace_evt_st;
+
+typedef struct swicc_trace_s
+{
+    /**
+     * Free-running counters. Head is only written by the producer and tail only
+     * by the consumer.
+     */
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+
+    /* Number of events which were dropped because the ring was full. */
+    _Atomic uint32_t dropped;
+
+    swicc_trace_evt_st evt[SWICC_TRACE_EVT_COUNT];
+} swicc_trace_st;
+
+/**
+ * @brief Reset the trace ring to an empty state.
+ * @param[out] trace
+ * @note Must not be used while the ring is being produced into or consumed
+ * from.
+ */
+void swicc_trace_reset(swicc_trace_st *const trace);
+
+/**
+ * @brief Record an event. The time of the event is set by this function.
+ * @param[in, out] trace
+ * @param[in, out] evt The event to record.
+ * @note This is the producer side.
+ */
+void swicc_trace_push(swicc_trace_st *const trace,
+                      swicc_trace_evt_st *const evt);
+
+/**
+ * @brief Take the oldest event out of the ring.
+ * @param[in, out] trace
+ * @param[out] evt Where the event will be written.
+ * @return Return code. If there are no events, the trace empty code is
+ * returned.
+ * @note This is the consumer side.
+ */
+swicc_ret_et swicc_trace_pop(swicc_trace_st *const trace,
+                             swicc_trace_evt_st *const evt);
@@ -0,0 +1,88 @@
+#pragma once
+/**
+ * Accounting of how long the traffic of a card would take on a physical link
+ * (ISO/IEC 7816-3:2006) at the transmission parameters negotiated with the
+ * interface. A card only accounts when it was given a wire block (see 'wire'
+ * of the swICC state), then every character going through the FSM costs its
+ * duration in ETUs, including guard times and procedure bytes. Commands which
+ * are handled directly (without the FSM) are not accounted.
+ *
+ * One ETU lasts Fi / (Di * f) seconds where f is the frequency of the clock
+ * given by the interface (at most f(max) of the negotiated Fi). Like before a
+ * PPS exchange, Fi = 372 and Di = 1 are used while nothing was negotiated. The
+ * extra guard time (TC1) is assumed to be 0.
+ */
+
+#include "swicc/common.h"
+
+/* Clock frequency of most readers in Hz (9600 baud with the default Fi/Di). */
+#define SWICC_WIRE_CLK_DEFAULT 3571200U
+
+/**
+ * Time between the leading edges of consecutive characters in ETUs (ISO/IEC
+ * 7816-3:2006 clause.7.2, clause.10, and clause.11). A character takes
+ * 10 ETUs and the rest is guard time. When the direction changes, the delay is
+ * longer to let the other side turn around.
+ */
+#define SWICC_WIRE_ETU_T0_CHAR 12U
+#define SWICC_WIRE_ETU_T0_TURN 16U
+#define SWICC_WIRE_ETU_T1_CHAR 11U
+#define SWICC_WIRE_ETU_T1_TURN 22U /* Block guard time (BGT). */
+
+typedef struct swicc_wire_s
+{
+    uint32_t clk; /* Frequency of the clock in Hz. */
+
+    /* If the last character was sent by the card. */
+    bool dir_tx;
+    /* Set once the response of the current command was produced. */
+    bool cmd_done;
+
+    /* Time in nanoseconds and characters of the command being exchanged. */
+    uint64_t cmd_time;
+    uint64_t cmd_char;
+
+    /* Same as above but for the last command that was completed. */
+    uint64_t cmd_last_time;
+    uint64_t cmd_last_char;
+
+    /**
+     * Totals of the session, i.e. since the block was initialized. These
+     * include the ATR and PPS exchanges which are not part of any command.
+     */
+    uint64_t cmd_count;
+    uint64_t time;
+    uint64_t char_count;
+} swicc_wire_st;
+
+/**
+ * @brief Start a new session.
+ * @param[out] wire
+ * @param[in] clk Frequency of the clock in Hz, 0 for the default.
+ */
+void swicc_wire_init(swicc_wire_st *const wire, uint32_t const clk);
+
+/**
+ * @brief Get how long some ETUs last.
+ * @param[in] wire
+ * @param[in] tp Transmission parameters.
+ * @param[in] etu_count
+ * @return Time in nanoseconds.
+ */
+uint64_t swicc_wire_etu_time(swicc_wire_st const *const wire,
+                             swicc_tp_st const *const tp,
+                             uint64_t const etu_count);
+
+/**
+ * @brief Account one exchange of the FSM where the card receives some
+ * characters and then sends some.
+ * @param[in, out] wire
+ * @param[in] tp Transmission parameters used for the exchange.
+ * @param[in] rx_len Number of characters received.
+ * @param[in] tx_len Number of characters sent.
+ * @param[in] cmd If the exchange is part of a command (and not e.g. of the ATR
+ * or PPS).
+ */
+void swicc_wire_xfer(swicc_wire_st *const wire, swicc_tp_st const *const tp,
+                     uint16_t const rx_len, uint16_t const tx_len,
+                     bool const cmd);
@@ -0,0 +1,226 @@
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/* Every allocation of an arena is aligned like the C library would. */
+#define ARENA_ALIGN alignof(max_align_t)
+
+/* Where the usable bytes of a chunk start. */
+#define ARENA_CHUNK_HDR_SIZE                                                   \
+    ((sizeof(swicc_alloc_arena_chunk_st) + ARENA_ALIGN - 1U) &                 \
+     ~(ARENA_ALIGN - 1U))
+
+void *swicc_alloc_malloc(swicc_alloc_st const *const alloc, size_t const size)
+{
+    if (alloc == NULL)
+    {
+        return malloc(size);
+    }
+    return alloc->malloc(alloc->ctx, size);
+}
+
+void *swicc_alloc_calloc(swicc_alloc_st const *const alloc, size_t const count,
+                         size_t const size)
+{
+    if (alloc == NULL)
+    {
+        return calloc(count, size);
+    }
+    if (size > 0U && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+    void *const ptr = alloc->malloc(alloc->ctx, count * size);
+    if (ptr != NULL)
+    {
+        memset(ptr, 0U, count * size);
+    }
+    return ptr;
+}
+
+void *swicc_alloc_realloc(swicc_alloc_st const *const alloc, void *const ptr,
+                          size_t const size_old, size_t const size)
+{
+    if (alloc == NULL)
+    {
+        return realloc(ptr, size);
+    }
+    return alloc->realloc(alloc->ctx, ptr, ptr == NULL ? 0U : size_old, size);
+}
+
+void swicc_alloc_free(swicc_alloc_st const *const alloc, void *const ptr)
+{
+    if (alloc == NULL)
+    {
+        free(ptr);
+    }
+    else if (alloc->free != NULL)
+    {
+        alloc->free(alloc->ctx, ptr);
+    }
+}
+
+/**
+ * @brief Get the usable bytes of a chunk.
+ * @param chunk
+ * @return Start of the bytes.
+ */
+static uint8_t *arena_chunk_buf(swicc_alloc_arena_chunk_st *const chunk)
+{
+    return &((uint8_t *)chunk)[ARENA_CHUNK_HDR_SIZE];
+}
+
+/**
+ * @brief Allocate from an arena without taking the lock.
+ * @param arena
+ * @param size
+ * @return The memory or NULL on failure.
+ */
+static void *arena_malloc_unlocked(swicc_alloc_arena_st *const arena,
+                                   size_t const size)
+{
+    /* Zero-sized allocations still get a unique address. */
+    size_t const size_aligned =
+        ((size > 0U ? size : 1U) + ARENA_ALIGN - 1U) & ~(ARENA_ALIGN - 1U);
+    if (size_aligned < size)
+    {
+        return NULL;
+    }
+
+    swicc_alloc_arena_chunk_st *chunk = arena->chunk;
+    if (chunk == NULL || chunk->size - chunk->used < size_aligned)
+    {
+        size_t const chunk_size =
+            size_aligned > arena->chunk_size ? size_aligned : arena->chunk_size;
+        if (chunk_size > SIZE_MAX - ARENA_CHUNK_HDR_SIZE)
+        {
+            return NULL;
+        }
+        chunk = swicc_alloc_malloc(arena->backing,
+                                   ARENA_CHUNK_HDR_SIZE + chunk_size);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->size = chunk_size;
+        chunk->used = 0U;
+        if (arena->chunk != NULL && chunk_size > arena->chunk_size)
+        {
+            /**
+             * A large allocation gets a chunk of its own which goes after the
+             * current one so the space left in the current one is not lost.
+             */
+            chunk->next = arena->chunk->next;
+            arena->chunk->next = chunk;
+            chunk->used = size_aligned;
+            return arena_chunk_buf(chunk);
+        }
+        chunk->next = arena->chunk;
+        arena->chunk = chunk;
+    }
+    void *const ptr = &arena_chunk_buf(chunk)[chunk->used];
+    chunk->used += size_aligned;
+    arena->last = ptr;
+    return ptr;
+}
+
+/**
+ * @brief Wait for the lock of an arena. Allocating is short so it spins.
+ * @param arena
+ */
+static void arena_lock(swicc_alloc_arena_st *const arena)
+{
+    while (atomic_flag_test_and_set_explicit(&arena->lock,
+                                             memory_order_acquire))
+    {
+    }
+}
+
+/**
+ * @brief Release the lock of an arena.
+ * @param arena
+ */
+static void arena_unlock(swicc_alloc_arena_st *const arena)
+{
+    atomic_flag_clear_explicit(&arena->lock, memory_order_release);
+}
+
+static swicc_alloc_malloc_ft arena_malloc;
+static void *arena_malloc(void *const ctx, size_t const size)
+{
+    swicc_alloc_arena_st *const arena = ctx;
+    arena_lock(arena);
+    void *const ptr = arena_malloc_unlocked(arena, size);
+    arena_unlock(arena);
+    return ptr;
+}
+
+static swicc_alloc_realloc_ft arena_realloc;
+static void *arena_realloc(void *const ctx, void *const ptr,
+                           size_t const size_old, size_t const size)
+{
+    swicc_alloc_arena_st *const arena = ctx;
+    if (ptr != NULL && size <= size_old)
+    {
+        return ptr;
+    }
+    arena_lock(arena);
+    if (ptr != NULL && ptr == arena->last)
+    {
+        /* The last allocation can grow over the free bytes that follow it. */
+        swicc_alloc_arena_chunk_st *const chunk = arena->chunk;
+        size_t const offset = (size_t)((uint8_t *)ptr - arena_chunk_buf(chunk));
+        size_t const size_aligned =
+            (size + ARENA_ALIGN - 1U) & ~(ARENA_ALIGN - 1U);
+        if (size_aligned >= size && size_aligned <= chunk->size - offset)
+        {
+            chunk->used = offset + size_aligned;
+            arena_unlock(arena);
+            return ptr;
+        }
+    }
+    void *const ptr_new = arena_malloc_unlocked(arena, size);
+    arena_unlock(arena);
+    if (ptr_new != NULL && ptr != NULL)
+    {
+        memcpy(ptr_new, ptr, size_old);
+    }
+    return ptr_new;
+}
+
+swicc_ret_et swicc_alloc_arena_init(swicc_alloc_arena_st *const arena,
+                                    swicc_alloc_st const *const backing,
+                                    size_t const chunk_size)
+{
+    if (arena == NULL || (backing != NULL && backing->free == NULL))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    memset(arena, 0U, sizeof(*arena));
+    atomic_flag_clear(&arena->lock);
+    arena->alloc = (swicc_alloc_st){
+        .malloc = arena_malloc,
+        .realloc = arena_realloc,
+        .free = NULL,
+        .ctx = arena,
+    };
+    arena->backing = backing;
+    arena->chunk_size = chunk_size > SWICC_ALLOC_ARENA_CHUNK_SIZE_MIN
+                            ? chunk_size
+                            : SWICC_ALLOC_ARENA_CHUNK_SIZE_MIN;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_alloc_arena_free(swicc_alloc_arena_st *const arena)
+{
+    swicc_alloc_arena_chunk_st *chunk = arena->chunk;
+    while (chunk != NULL)
+    {
+        swicc_alloc_arena_chunk_st *const chunk_next = chunk->next;
+        swicc_alloc_free(arena->backing, chunk);
+        chunk = chunk_next;
+    }
+    arena->chunk = NULL;
+    arena->last = NULL;
+}
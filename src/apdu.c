@@ -50,6 +50,18 @@ swicc_apdu_cla_st swicc_apdu_cmd_cla_parse(uint8_t const cla_raw)
     else
     {
         cla.type = SWICC_APDU_CLA_TYPE_PROPRIETARY;
+        /**
+         * Proprietary classes of the UICC code the logical channel like the
+         * interindustry ones. ETSI TS 102 221 V16.4.0 clause.10.1.1.
+         */
+        if (cla_raw >> (8U - 3U) == 0b100U)
+        {
+            cla.lchan = cla_raw & 0b00000011U;
+        }
+        else if (cla_raw >> (8U - 2U) == 0b11U && cla_raw != 0xFF)
+        {
+            cla.lchan = (uint8_t)((cla_raw & 0b00001111U) + 4U);
+        }
     }
     return cla;
 }
@@ -98,7 +110,8 @@ swicc_ret_et swicc_apdu_res_deparse(uint8_t *const buf_raw,
         return SWICC_RET_ERROR;
     }
     *buf_raw_len = res->data.len;
-    memcpy(buf_raw, res->data.b, res->data.len);
+    memcpy(buf_raw, res->data_ref != NULL ? res->data_ref : res->data.b,
+           res->data.len);
     uint8_t *const status = &buf_raw[res->data.len];
     uint8_t const sw1_raw = (uint8_t)res->sw1;
 
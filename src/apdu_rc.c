@@ -1,14 +1,76 @@
+#include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <swicc/swicc.h>
 
+static_assert(SWICC_DATA_MAX_SHRT <= SWICC_POOL_BUF_SIZE,
+              "A short response does not fit in a buffer of the pool.");
+
 void swicc_apdu_rc_reset(swicc_apdu_rc_st *const rc)
 {
     if (rc != NULL)
     {
+        /* A short buffer is cheap to borrow again for the next response. */
+        if (rc->b_pooled)
+        {
+            swicc_pool_put(swicc_pool_thread(), rc->b);
+            rc->b = NULL;
+            rc->size = 0U;
+            rc->b_pooled = false;
+        }
+        rc->b_len = 0U;
+        rc->seg_count = 0U;
+        rc->len = 0U;
+        rc->offset = 0U;
+        rc->seg_cur = 0U;
+        rc->seg_cur_offset = 0U;
+    }
+}
+
+void swicc_apdu_rc_free(swicc_apdu_rc_st *const rc)
+{
+    if (rc != NULL)
+    {
+        free(rc->b);
         memset(rc, 0U, sizeof(*rc));
     }
 }
 
+/**
+ * @brief Get a pointer to the data of a segment.
+ * @param rc
+ * @param seg
+ * @return Pointer to the data.
+ */
+static uint8_t const *rc_seg_data(swicc_apdu_rc_st const *const rc,
+                                  swicc_apdu_rc_seg_st const *const seg)
+{
+    return seg->ref != NULL ? seg->ref : &rc->b[seg->offset];
+}
+
+/**
+ * @brief Move the read position forward by a number of bytes.
+ * @param rc
+ * @param len Must not be more than the remaining length.
+ */
+static void rc_advance(swicc_apdu_rc_st *const rc, uint32_t len)
+{
+    rc->offset += len;
+    while (len > 0U)
+    {
+        uint32_t const seg_len_rem =
+            rc->seg[rc->seg_cur].len - rc->seg_cur_offset;
+        uint32_t const len_step = len < seg_len_rem ? len : seg_len_rem;
+        rc->seg_cur_offset += len_step;
+        len -= len_step;
+        if (rc->seg_cur_offset == rc->seg[rc->seg_cur].len)
+        {
+            rc->seg_cur += 1U;
+            rc->seg_cur_offset = 0U;
+        }
+    }
+}
+
 swicc_ret_et swicc_apdu_rc_enq(swicc_apdu_rc_st *const rc,
                                uint8_t const *const buf, uint32_t const buf_len)
 {
@@ -17,18 +79,105 @@ swicc_ret_et swicc_apdu_rc_enq(swicc_apdu_rc_st *const rc,
         return SWICC_RET_PARAM_BAD;
     }
 
-    static_assert(sizeof(rc->b) <= UINT32_MAX,
-                  "Size of the RC buffer does not fit in a uint32.");
-
     /* Check if the new data will fit. */
-    if (rc->len + buf_len > sizeof(rc->b))
+    if (buf_len > SWICC_DATA_MAX_LONG - rc->len)
     {
         return SWICC_RET_BUFFER_TOO_SHORT;
     }
+    if (buf_len == 0U)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Data copied right after the last segment extends that segment. */
+    bool const seg_extend = rc->seg_count > 0U &&
+                            rc->seg[rc->seg_count - 1U].ref == NULL &&
+                            rc->seg[rc->seg_count - 1U].offset +
+                                    rc->seg[rc->seg_count - 1U].len ==
+                                rc->b_len;
+    if (!seg_extend && rc->seg_count >= SWICC_APDU_RC_SEG_COUNT_MAX)
+    {
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+
+    /* Safe cast since the copied data is never more than an extended max. */
+    uint32_t const b_len_new = (uint32_t)(rc->b_len + buf_len);
+    if (rc->size == 0U && b_len_new <= SWICC_DATA_MAX_SHRT)
+    {
+        /* Most responses are short so a short buffer is borrowed first. */
+        uint8_t *const b_new = swicc_pool_get(swicc_pool_thread());
+        if (b_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        rc->b = b_new;
+        rc->size = SWICC_DATA_MAX_SHRT;
+        rc->b_pooled = true;
+    }
+    else if (b_len_new > rc->size)
+    {
+        /* Most responses are short so start with a short response buffer. */
+        uint32_t size_new = rc->size == 0U ? SWICC_DATA_MAX_SHRT : rc->size;
+        while (size_new < b_len_new)
+        {
+            size_new *= 2U;
+        }
+        if (size_new > SWICC_DATA_MAX_LONG)
+        {
+            size_new = SWICC_DATA_MAX_LONG;
+        }
+        uint8_t *const b_new = realloc(rc->b, size_new);
+        if (b_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        rc->b = b_new;
+        rc->size = size_new;
+        /* Buffers of the pool come from the C library so can be resized. */
+        rc->b_pooled = false;
+    }
+
+    memcpy(&rc->b[rc->b_len], buf, buf_len);
+    if (seg_extend)
+    {
+        rc->seg[rc->seg_count - 1U].len += buf_len;
+    }
+    else
+    {
+        rc->seg[rc->seg_count++] = (swicc_apdu_rc_seg_st){
+            .ref = NULL,
+            .offset = rc->b_len,
+            .len = buf_len,
+        };
+    }
+    rc->b_len = b_len_new;
+    rc->len += buf_len;
+    return SWICC_RET_SUCCESS;
+}
 
-    memcpy(&rc->b[rc->len], buf, buf_len);
-    /* Safe cast since it was checked to not overflow the type. */
-    rc->len = (uint32_t)(rc->len + buf_len);
+swicc_ret_et swicc_apdu_rc_enq_ref(swicc_apdu_rc_st *const rc,
+                                   uint8_t const *const buf,
+                                   uint32_t const buf_len)
+{
+    if (rc == NULL || buf == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (buf_len > SWICC_DATA_MAX_LONG - rc->len ||
+        (buf_len > 0U && rc->seg_count >= SWICC_APDU_RC_SEG_COUNT_MAX))
+    {
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+    if (buf_len == 0U)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    rc->seg[rc->seg_count++] = (swicc_apdu_rc_seg_st){
+        .ref = buf,
+        .offset = 0U,
+        .len = buf_len,
+    };
+    rc->len += buf_len;
     return SWICC_RET_SUCCESS;
 }
 
@@ -47,13 +196,22 @@ swicc_ret_et swicc_apdu_rc_deq(swicc_apdu_rc_st *const rc, uint8_t *const buf,
     uint32_t const rc_len_rem = (uint32_t)(rc->len - rc->offset);
     if (*buf_len <= rc_len_rem)
     {
-        memcpy(buf, &rc->b[rc->offset], *buf_len);
-
-        /**
-         * Safe cast since the additon will not be greater than the RC length
-         * which fits in uint32.
-         */
-        rc->offset = (uint32_t)(rc->offset + *buf_len);
+        uint32_t seg_idx = rc->seg_cur;
+        uint32_t seg_offset = rc->seg_cur_offset;
+        for (uint32_t buf_offset = 0U; buf_offset < *buf_len; ++seg_idx)
+        {
+            swicc_apdu_rc_seg_st const *const seg = &rc->seg[seg_idx];
+            uint32_t len_copy = seg->len - seg_offset;
+            if (len_copy > *buf_len - buf_offset)
+            {
+                len_copy = *buf_len - buf_offset;
+            }
+            memcpy(&buf[buf_offset], &rc_seg_data(rc, seg)[seg_offset],
+                   len_copy);
+            buf_offset += len_copy;
+            seg_offset = 0U;
+        }
+        rc_advance(rc, *buf_len);
         return SWICC_RET_SUCCESS;
     }
     else
@@ -63,6 +221,33 @@ swicc_ret_et swicc_apdu_rc_deq(swicc_apdu_rc_st *const rc, uint8_t *const buf,
     }
 }
 
+swicc_ret_et swicc_apdu_rc_deq_ref(swicc_apdu_rc_st *const rc,
+                                   uint8_t const **const buf,
+                                   uint32_t const buf_len)
+{
+    if (rc == NULL || buf == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (buf_len > rc->len - rc->offset)
+    {
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+    if (buf_len == 0U)
+    {
+        *buf = NULL;
+        return SWICC_RET_SUCCESS;
+    }
+    swicc_apdu_rc_seg_st const *const seg = &rc->seg[rc->seg_cur];
+    if (buf_len > seg->len - rc->seg_cur_offset)
+    {
+        return SWICC_RET_ERROR;
+    }
+    *buf = &rc_seg_data(rc, seg)[rc->seg_cur_offset];
+    rc_advance(rc, buf_len);
+    return SWICC_RET_SUCCESS;
+}
+
 uint32_t swicc_apdu_rc_len_rem(swicc_apdu_rc_st const *const rc)
 {
     if (rc == NULL)
@@ -42,50 +42,6 @@ static swicc_ret_et apduh_select(swicc_st *const swicc_state,
         return SWICC_RET_SUCCESS;
     }
 
-    /**
-     * Check if we only got Lc which means we need to send back a procedure
-     * byte.
-     */
-    if (procedure_count == 0U)
-    {
-        /**
-         * Unexpected because before sending a procedure, no data should have
-         * been received.
-         */
-        if (cmd->data->len != 0U)
-        {
-            res->sw1 = SWICC_APDU_SW1_CHER_UNK;
-            res->sw2 = 0U;
-            res->data.len = 0U;
-            return SWICC_RET_SUCCESS;
-        }
-
-        /**
-         * If Lc is 0 it means data is absent so we can process what we got,
-         * otherwise we need more from the interface.
-         */
-        if (*cmd->p3 > 0)
-        {
-            res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
-            res->sw2 = 0U;
-            res->data.len = *cmd->p3; /* Length of expected data. */
-            return SWICC_RET_SUCCESS;
-        }
-    }
-
-    /**
-     * The ACK ALL procedure was sent and we expected to receive all the data
-     * (length of which was given in P3) but did not receive the expected amount
-     * of data.
-     */
-    if (cmd->data->len != *cmd->p3 && procedure_count >= 1U)
-    {
-        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
-        res->sw2 = 0x02; /* The value of Lc is not the one expected. */
-        res->data.len = 0U;
-        return SWICC_RET_SUCCESS;
-    }
-
     enum meth_e
     {
         METH_RFU,
@@ -131,7 +87,27 @@ static swicc_ret_et apduh_select(swicc_st *const swicc_state,
                         field present. */
     } data_req = DATA_REQ_RFU;
 
-    /* Parse the command parameters. */
+    /**
+     * Parameters get decoded in the first phase and are kept in the handler
+     * context for the data phase.
+     */
+    struct select_ctx_s
+    {
+        enum meth_e meth;
+        swicc_fs_occ_et occ;
+        enum data_req_e data_req;
+    } ctx;
+    static_assert(sizeof(ctx) <= SWICC_APDUH_CTX_PARAM_SIZE,
+                  "SELECT context does not fit in a handler context");
+    swicc_apduh_ctx_st *const apduh_ctx = &swicc_state->internal.apduh_ctx;
+    if (apduh_ctx->valid)
+    {
+        memcpy(&ctx, apduh_ctx->param, sizeof(ctx));
+        meth = ctx.meth;
+        occ = ctx.occ;
+        data_req = ctx.data_req;
+    }
+    else
     {
         /* Decode P1. */
         switch (cmd->hdr->p1)
@@ -211,19 +187,71 @@ static swicc_ret_et apduh_select(swicc_st *const swicc_state,
         }
     }
 
-    /* Perform the requested action. */
+    /* Unsupported P1/P2 parameters. */
+    if (meth == METH_RFU || data_req == DATA_REQ_RFU || meth == METH_DO ||
+        meth == METH_DO_PARENT || meth == METH_DF_PARENT ||
+        meth == METH_EF_NESTED || meth == METH_DF_NESTED)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * Check if we only got Lc which means we need to send back a procedure
+     * byte.
+     */
+    if (procedure_count == 0U)
     {
-        /* Unsupported P1/P2 parameters. */
-        if (meth == METH_RFU || data_req == DATA_REQ_RFU || meth == METH_DO ||
-            meth == METH_DO_PARENT || meth == METH_DF_PARENT ||
-            meth == METH_EF_NESTED || meth == METH_DF_NESTED)
+        /**
+         * Unexpected because before sending a procedure, no data should have
+         * been received.
+         */
+        if (cmd->data->len != 0U)
         {
-            res->sw1 = SWICC_APDU_SW1_CHER_P1P2;
+            res->sw1 = SWICC_APDU_SW1_CHER_UNK;
             res->sw2 = 0U;
             res->data.len = 0U;
             return SWICC_RET_SUCCESS;
         }
 
+        /**
+         * If Lc is 0 it means data is absent so we can process what we got,
+         * otherwise we need more from the interface.
+         */
+        if (*cmd->p3 > 0)
+        {
+            ctx = (struct select_ctx_s){
+                .meth = meth,
+                .occ = occ,
+                .data_req = data_req,
+            };
+            memcpy(apduh_ctx->param, &ctx, sizeof(ctx));
+            apduh_ctx->valid = true;
+
+            res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
+            res->sw2 = 0U;
+            res->data.len = *cmd->p3; /* Length of expected data. */
+            return SWICC_RET_SUCCESS;
+        }
+    }
+
+    /**
+     * The ACK ALL procedure was sent and we expected to receive all the data
+     * (length of which was given in P3) but did not receive the expected amount
+     * of data.
+     */
+    if (cmd->data->len != *cmd->p3 && procedure_count >= 1U)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+        res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Perform the requested action. */
+    {
         swicc_ret_et ret_select = SWICC_RET_ERROR;
         switch (meth)
         {
@@ -320,6 +348,33 @@ static swicc_ret_et apduh_select(swicc_st *const swicc_state,
         }
         else
         {
+            /**
+             * The templates only change together with the file header so the
+             * ones encoded on an earlier selection are served as they are.
+             * Safe cast since the data request enum has only a few values.
+             */
+            uint8_t const fcp_kind = (uint8_t)data_req;
+            uint8_t const *fcp;
+            uint32_t fcp_len;
+            if (swicc_disk_file_fcp_lookup(swicc_state->fs.va.cur_tree,
+                                           file_selected, fcp_kind, &fcp,
+                                           &fcp_len) == SWICC_RET_SUCCESS)
+            {
+                if (swicc_apdu_rc_enq_ref(&swicc_state->apdu_rc, fcp,
+                                          fcp_len) != SWICC_RET_SUCCESS)
+                {
+                    res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+                    res->sw2 = 0U;
+                    res->data.len = 0U;
+                    return SWICC_RET_SUCCESS;
+                }
+                res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+                /* Safe cast since only templates that fit in SW2 are cached. */
+                res->sw2 = (uint8_t)fcp_len;
+                res->data.len = 0U;
+                return SWICC_RET_SUCCESS;
+            }
+
             /**
              * Create tags for use in encoding.
              * ISO/IEC 7816-4:2020 clause.7.4.3 table.11.
@@ -534,6 +589,14 @@ static swicc_ret_et apduh_select(swicc_st *const swicc_state,
                 swicc_apdu_rc_enq(&swicc_state->apdu_rc, res->data.b,
                                   bertlv_len) == SWICC_RET_SUCCESS)
             {
+                /**
+                 * Failing to cache the template only means it will get encoded
+                 * again on the next selection.
+                 */
+                (void)swicc_disk_file_fcp_insert(
+                    swicc_state->fs.va.cur_tree, file_selected, fcp_kind,
+                    res->data.b, bertlv_len);
+
                 res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
                 /**
                  * @todo What happens when extended APDUs are supported and
@@ -608,7 +671,9 @@ static swicc_ret_et apduh_bin_read(swicc_st *const swicc_state,
         }
     }
 
-    uint8_t const len_expected = *cmd->p3;
+    /* Le of 00 means 256 bytes or, over T=0, an extended Ne. */
+    uint32_t const len_expected = *cmd->p3 == 0U ? SWICC_DATA_MAX_SHRT
+                                                 : *cmd->p3;
     uint16_t offset;
     swicc_fs_file_st file;
 
@@ -692,7 +757,14 @@ static swicc_ret_et apduh_bin_read(swicc_st *const swicc_state,
             res->data.len = 0U;
             return SWICC_RET_SUCCESS;
         }
-        else if (offset + len_expected > file.data_size)
+        /**
+         * When an extended Ne may have been requested and there is more data
+         * than fits in a short response, as much of it as fits in an extended
+         * response is chained instead (ISO/IEC 7816-3:2006 clause.12.2.3).
+         */
+        bool const chain = *cmd->p3 == 0U &&
+                           file.data_size - offset > SWICC_DATA_MAX_SHRT;
+        if (!chain && offset + len_expected > file.data_size)
         {
             res->sw1 = SWICC_APDU_SW1_CHER_LE;
             /* Safe cast since offset is less than data size. */
@@ -701,11 +773,49 @@ static swicc_ret_et apduh_bin_read(swicc_st *const swicc_state,
             return SWICC_RET_SUCCESS;
         }
 
-        /* Read data into response. */
-        memcpy(res->data.b, &file.data[offset], len_expected);
-        res->data.len = len_expected;
-        res->sw1 = SWICC_APDU_SW1_NORM_NONE;
-        res->sw2 = 0U;
+        /**
+         * The file may have been modified after it was selected so the data is
+         * looked up again.
+         */
+        uint8_t *file_data;
+        if (swicc_disk_file_data(swicc_state->fs.va.cur_tree, &file,
+                                 &file_data) != SWICC_RET_SUCCESS)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+            res->sw2 = 0U;
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+
+        if (chain)
+        {
+            uint32_t len_chain = file.data_size - offset;
+            if (len_chain > SWICC_DATA_MAX_LONG)
+            {
+                len_chain = SWICC_DATA_MAX_LONG;
+            }
+            if (swicc_apdu_rc_enq_ref(&swicc_state->apdu_rc,
+                                      &file_data[offset],
+                                      len_chain) != SWICC_RET_SUCCESS)
+            {
+                res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+                res->sw2 = 0U;
+                res->data.len = 0U;
+                return SWICC_RET_SUCCESS;
+            }
+            res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+            res->sw2 = 0U; /* 256 or more bytes available. */
+            res->data.len = 0U;
+        }
+        else
+        {
+            /* The file data is sent as-is without copying it. */
+            res->data_ref = &file_data[offset];
+            /* Safe cast since at most a short response is read. */
+            res->data.len = (uint16_t)len_expected;
+            res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+            res->sw2 = 0U;
+        }
 
         if (sid_use)
         {
@@ -748,21 +858,119 @@ static swicc_ret_et apduh_bin_read(swicc_st *const swicc_state,
     return SWICC_RET_SUCCESS;
 }
 
+/* Parameters of UPDATE BINARY kept in between the phases of the command. */
+typedef struct apduh_bin_update_ctx_s
+{
+    bool trgt_sid; /* The EF was referenced by its SID. */
+    uint16_t offset;
+} apduh_bin_update_ctx_st;
+static_assert(sizeof(apduh_bin_update_ctx_st) <= SWICC_APDUH_CTX_PARAM_SIZE,
+              "UPDATE BINARY context does not fit in a handler context");
+
 /**
- * @brief Handle the READ RECORD command in the interindustry class.
- * @note As described in ISO/IEC 7816-4:2020 p.82 sec.11.4.3.
+ * @brief Decode the parameters of UPDATE BINARY and look up the EF they
+ * reference.
+ * @param swicc_state
+ * @param cmd
+ * @param res Receives the status when the parameters get rejected.
+ * @param ctx Receives the decoded parameters.
+ * @param ef Receives the EF to update.
+ * @return True if the bytes to update are inside the EF, false if the response
+ * was set.
  */
-static swicc_apduh_ft apduh_rcrd_read;
-static swicc_ret_et apduh_rcrd_read(swicc_st *const swicc_state,
-                                    swicc_apdu_cmd_st const *const cmd,
-                                    swicc_apdu_res_st *const res,
-                                    uint32_t const procedure_count)
+static bool apduh_bin_update_prs(swicc_st *const swicc_state,
+                                 swicc_apdu_cmd_st const *const cmd,
+                                 swicc_apdu_res_st *const res,
+                                 apduh_bin_update_ctx_st *const ctx,
+                                 swicc_fs_file_st *const ef)
+{
+    /* Same referencing of the EF and offset as in READ BINARY. */
+    bool const sid_use = cmd->hdr->p1 & 0b10000000;
+    uint16_t offset;
+    if (sid_use)
+    {
+        /* b6 and b7 of P1 must be 0. */
+        if ((cmd->hdr->p1 & 0b01100000) != 0)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+            res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+            res->data.len = 0U;
+            return false;
+        }
+        swicc_fs_sid_kt const sid = cmd->hdr->p1 & 0b00011111;
+        offset = cmd->hdr->p2;
+        swicc_ret_et const ret_lookup =
+            swicc_disk_lutsid_lookup(swicc_state->fs.va.cur_tree, sid, ef);
+        if (ret_lookup != SWICC_RET_SUCCESS)
+        {
+            res->sw1 = ret_lookup == SWICC_RET_FS_NOT_FOUND
+                           ? SWICC_APDU_SW1_CHER_P1P2_INFO
+                           : SWICC_APDU_SW1_CHER_UNK;
+            /* "File or application not found." */
+            res->sw2 = ret_lookup == SWICC_RET_FS_NOT_FOUND ? 0x82 : 0U;
+            res->data.len = 0U;
+            return false;
+        }
+    }
+    else
+    {
+        /* Safe cast since just concatentating 2 bytes into short. */
+        offset = (uint16_t)(((0b01111111 & cmd->hdr->p1) << 8U) | cmd->hdr->p2);
+        *ef = swicc_state->fs.va.cur_ef;
+        if (ef->hdr_item.type == SWICC_FS_ITEM_TYPE_INVALID)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_CMD;
+            res->sw2 = 0x86; /* "Command not allowed (curEF not set)" */
+            res->data.len = 0U;
+            return false;
+        }
+    }
+
+    if (ef->hdr_item.type != SWICC_FS_ITEM_TYPE_FILE_EF_TRANSPARENT)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_CMD;
+        res->sw2 = 0x81; /* "Command incompatible with file structure" */
+        res->data.len = 0U;
+        return false;
+    }
+    if (offset >= ef->data_size)
+    {
+        /* Requested an offset which is outside the bounds of the file. */
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return false;
+    }
+    /* Either nothing to update or more than what is left of the file. */
+    if (*cmd->p3 == 0U || *cmd->p3 > ef->data_size - offset)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return false;
+    }
+    *ctx = (apduh_bin_update_ctx_st){
+        .trgt_sid = sid_use,
+        .offset = offset,
+    };
+    return true;
+}
+
+/**
+ * @brief Handle the UPDATE BINARY command in the interindustry class.
+ * @note As described in ISO/IEC 7816-4:2020 clause.11.3.5.
+ */
+static swicc_apduh_ft apduh_bin_update;
+static swicc_ret_et apduh_bin_update(swicc_st *const swicc_state,
+                                     swicc_apdu_cmd_st const *const cmd,
+                                     swicc_apdu_res_st *const res,
+                                     uint32_t const procedure_count)
 {
     /**
-     * Odd instruction (B3) not supported. It would have the data field encoded
-     * as a BER-TLV DO.
+     * Odd instruction (D7) not supported. The data would contain an offset DO
+     * and discretionary DO for encapsulating the updating data.
      */
-    if (cmd->hdr->ins != 0xB2)
+    if (cmd->hdr->ins != 0xD6)
     {
         res->sw1 = SWICC_APDU_SW1_CHER_INS;
         res->sw2 = 0U;
@@ -770,42 +978,275 @@ static swicc_ret_et apduh_rcrd_read(swicc_st *const swicc_state,
         return SWICC_RET_SUCCESS;
     }
 
-    /**
-     * This command does not take any data so send a procedure to get all data
-     * but set expected data length to be 0.
-     */
+    /* The EF is looked up before asking for the data. */
+    swicc_apduh_ctx_st *const apduh_ctx = &swicc_state->internal.apduh_ctx;
+    apduh_bin_update_ctx_st ctx;
+    swicc_fs_file_st ef_cur;
+    if (apduh_ctx->valid)
+    {
+        memcpy(&ctx, apduh_ctx->param, sizeof(ctx));
+        ef_cur = apduh_ctx->file;
+    }
+    else if (!apduh_bin_update_prs(swicc_state, cmd, res, &ctx, &ef_cur))
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Lc is the number of bytes to write so all of them are asked for. */
     if (procedure_count == 0U)
     {
+        memcpy(apduh_ctx->param, &ctx, sizeof(ctx));
+        apduh_ctx->tree = swicc_state->fs.va.cur_tree;
+        apduh_ctx->file = ef_cur;
+        apduh_ctx->valid = true;
+
         res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
         res->sw2 = 0U;
-        res->data.len = 0U; /* 0 bytes expected. */
+        res->data.len = *cmd->p3;
         return SWICC_RET_SUCCESS;
     }
-    else
+    if (cmd->data->len != *cmd->p3)
     {
-        /**
-         * We sent an ACK ALL procedure and expected 0 bytes but got more than 0
-         * bytes from the interface.
-         */
-        if (cmd->data->len != 0)
+        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+        res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * Have to select the file on success (only if EF was selected by SID).
+     * @warning If this fails, something weird is going on.
+     */
+    uint8_t *data;
+    if ((!ctx.trgt_sid ||
+         swicc_va_select_file_sid(&swicc_state->fs, ef_cur.hdr_file.sid) ==
+             SWICC_RET_SUCCESS) &&
+        swicc_disk_file_cow(swicc_state->fs.va.cur_tree, &ef_cur) ==
+            SWICC_RET_SUCCESS &&
+        swicc_disk_file_data(swicc_state->fs.va.cur_tree, &ef_cur, &data) ==
+            SWICC_RET_SUCCESS)
+    {
+        memcpy(&data[ctx.offset], cmd->data->b, cmd->data->len);
+        if (swicc_disk_file_dirty_mark(swicc_state->fs.va.cur_tree, &ef_cur,
+                                       ctx.offset, cmd->data->len) !=
+                SWICC_RET_SUCCESS ||
+            swicc_disk_journal_append(&swicc_state->fs.disk,
+                                      swicc_state->fs.va.cur_tree, &ef_cur,
+                                      ctx.offset,
+                                      cmd->data->len) != SWICC_RET_SUCCESS)
         {
-            res->sw1 = SWICC_APDU_SW1_CHER_LEN;
-            res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+            res->sw1 = SWICC_APDU_SW1_EXER_NVM_CHGM;
+            res->sw2 = 0x81; /* "Memory failure" */
             res->data.len = 0U;
             return SWICC_RET_SUCCESS;
         }
+        res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
     }
 
-    /* Where to read records from. */
-    enum trgt_e
-    {
-        TRGT_EF_CUR,
-        TRGT_EF_SID,
-        TRGT_MANY,
-    } trgt;
+    res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+    res->sw2 = 0U;
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
 
-    /* Which occurrence to read when reading using an ID. */
-    __attribute__((unused)) swicc_fs_occ_et occ = SWICC_FS_OCC_FIRST;
+/**
+ * @brief Read all records from P1 to the last one, or from the last one to P1,
+ * into a single response of READ RECORD. Responses too long for a short R-APDU
+ * are chained through GET RESPONSE.
+ * @param swicc_state
+ * @param cmd
+ * @param res
+ * @param ef The EF to read the records from.
+ * @param rcrd_idx Index of the record P1.
+ * @param rev If records are read from the last one to P1.
+ * @param sid_use If the EF was referenced by SID so it has to be selected.
+ * @return Return code.
+ * @note As described in ISO/IEC 7816-4:2020 p.82 sec.11.4.3.
+ */
+static swicc_ret_et apduh_rcrd_read_many(swicc_st *const swicc_state,
+                                         swicc_apdu_cmd_st const *const cmd,
+                                         swicc_apdu_res_st *const res,
+                                         swicc_fs_file_st const *const ef,
+                                         swicc_fs_rcrd_idx_kt const rcrd_idx,
+                                         bool const rev, bool const sid_use)
+{
+    swicc_disk_tree_st *const tree = swicc_state->fs.va.cur_tree;
+    uint32_t rcrd_cnt;
+    if (swicc_disk_file_rcrd_cnt(tree, ef, &rcrd_cnt) != SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    if (rcrd_idx >= rcrd_cnt)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x83; /* "Record not found" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * At most 254 records of at most 255 bytes each are read so the whole
+     * response always fits in an extended one.
+     */
+    uint32_t len_total = 0U;
+    for (uint32_t rcrd_num = rcrd_idx; rcrd_num < rcrd_cnt; ++rcrd_num)
+    {
+        uint8_t *rcrd_buf;
+        uint8_t rcrd_len;
+        /* Safe cast since record indices are in range 0 to 253. */
+        if (swicc_disk_file_rcrd(tree, ef, (swicc_fs_rcrd_idx_kt)rcrd_num,
+                                 &rcrd_buf, &rcrd_len) != SWICC_RET_SUCCESS)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+            res->sw2 = 0U;
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+        len_total += rcrd_len;
+    }
+
+    /**
+     * Same as for READ BINARY, when an extended Ne may have been requested, a
+     * response longer than a short one is chained.
+     */
+    uint32_t const len_expected =
+        *cmd->p3 == 0U ? SWICC_DATA_MAX_SHRT : *cmd->p3;
+    bool const chain = *cmd->p3 == 0U && len_total > SWICC_DATA_MAX_SHRT;
+    if (!chain && len_total != len_expected)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_LE;
+        /**
+         * Safe cast since a longer response is asked for with Le = 0 (i.e.
+         * 256) which then gets chained.
+         */
+        res->sw2 = (uint8_t)(len_total > SWICC_DATA_MAX_SHRT ? 0U : len_total);
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * Select the file (only if EF was referenced by SID) and make record P1
+     * the current one, same as when reading only record P1.
+     * @warning If this fails, something weird is going on.
+     */
+    if ((sid_use && swicc_va_select_file_sid(&swicc_state->fs,
+                                             ef->hdr_file.sid) !=
+                        SWICC_RET_SUCCESS) ||
+        swicc_va_select_record_idx(&swicc_state->fs, rcrd_idx) !=
+            SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    uint32_t len_res = 0U;
+    for (uint32_t rcrd_step = 0U; rcrd_step < rcrd_cnt - rcrd_idx; ++rcrd_step)
+    {
+        /* Safe cast since record indices are in range 0 to 253. */
+        swicc_fs_rcrd_idx_kt const rcrd_num =
+            (swicc_fs_rcrd_idx_kt)(rev ? rcrd_cnt - 1U - rcrd_step
+                                       : rcrd_idx + rcrd_step);
+        uint8_t *rcrd_buf;
+        uint8_t rcrd_len;
+        if (swicc_disk_file_rcrd(tree, ef, rcrd_num, &rcrd_buf, &rcrd_len) !=
+                SWICC_RET_SUCCESS ||
+            (chain && swicc_apdu_rc_enq(&swicc_state->apdu_rc, rcrd_buf,
+                                        rcrd_len) != SWICC_RET_SUCCESS))
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+            res->sw2 = 0U;
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+        if (!chain)
+        {
+            memcpy(&res->data.b[len_res], rcrd_buf, rcrd_len);
+        }
+        len_res += rcrd_len;
+    }
+
+    if (chain)
+    {
+        res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+        res->sw2 = 0U; /* 256 or more bytes available. */
+        res->data.len = 0U;
+    }
+    else
+    {
+        res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+        res->sw2 = 0U;
+        /* Safe cast since at most a short response is read. */
+        res->data.len = (uint16_t)len_res;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Handle the READ RECORD command in the interindustry class.
+ * @note As described in ISO/IEC 7816-4:2020 p.82 sec.11.4.3.
+ */
+static swicc_apduh_ft apduh_rcrd_read;
+static swicc_ret_et apduh_rcrd_read(swicc_st *const swicc_state,
+                                    swicc_apdu_cmd_st const *const cmd,
+                                    swicc_apdu_res_st *const res,
+                                    uint32_t const procedure_count)
+{
+    /**
+     * Odd instruction (B3) not supported. It would have the data field encoded
+     * as a BER-TLV DO.
+     */
+    if (cmd->hdr->ins != 0xB2)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_INS;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * This command does not take any data so send a procedure to get all data
+     * but set expected data length to be 0.
+     */
+    if (procedure_count == 0U)
+    {
+        res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
+        res->sw2 = 0U;
+        res->data.len = 0U; /* 0 bytes expected. */
+        return SWICC_RET_SUCCESS;
+    }
+    else
+    {
+        /**
+         * We sent an ACK ALL procedure and expected 0 bytes but got more than 0
+         * bytes from the interface.
+         */
+        if (cmd->data->len != 0)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+            res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+    }
+
+    /* Where to read records from. */
+    enum trgt_e
+    {
+        TRGT_EF_CUR,
+        TRGT_EF_SID,
+        TRGT_MANY,
+    } trgt;
+
+    /* Which occurrence to read when reading using an ID. */
+    __attribute__((unused)) swicc_fs_occ_et occ = SWICC_FS_OCC_FIRST;
 
     /* What record(s) to read when reading using a number. */
     enum what_e
@@ -889,7 +1330,7 @@ static swicc_ret_et apduh_rcrd_read(swicc_st *const swicc_state,
         /**
          * Operation "P1 set to '00' and one or more record handling
          * DO'7F76' in the command data field", selection by ID is not
-         * supported, reading many records is not supported.
+         * supported, reading records of many EFs is not supported.
          */
         if (cmd->hdr->p2 == 0b11111000 || meth == METH_RCRD_ID ||
             trgt == TRGT_MANY)
@@ -951,6 +1392,12 @@ static swicc_ret_et apduh_rcrd_read(swicc_st *const swicc_state,
                 res->data.len = 0U;
                 return SWICC_RET_SUCCESS;
             }
+            else if (ret_ef == SWICC_RET_SUCCESS && what != WHAT_P1)
+            {
+                return apduh_rcrd_read_many(swicc_state, cmd, res, &ef_cur,
+                                            rcrd_idx, what == WHAT_LAST_TO_P1,
+                                            trgt == TRGT_EF_SID);
+            }
             else if (ret_ef == SWICC_RET_SUCCESS)
             {
                 /* Got the target EF, can read the record now. */
@@ -1005,7 +1452,7 @@ static swicc_ret_et apduh_rcrd_read(swicc_st *const swicc_state,
                             res->sw1 = SWICC_APDU_SW1_NORM_NONE;
                             res->sw2 = 0U;
                             res->data.len = rcrd_len;
-                            memcpy(res->data.b, rcrd_buf, rcrd_len);
+                            res->data_ref = rcrd_buf;
                             return SWICC_RET_SUCCESS;
                         }
                     }
@@ -1019,28 +1466,34 @@ static swicc_ret_et apduh_rcrd_read(swicc_st *const swicc_state,
     return SWICC_RET_SUCCESS;
 }
 
+/* Parameters of UPDATE RECORD kept in between the phases of the command. */
+typedef struct apduh_rcrd_update_ctx_s
+{
+    bool trgt_sid;  /* The EF was referenced by its SID. */
+    bool rcrd_prev; /* Writing a new record of a cyclic EF. */
+    swicc_fs_rcrd_idx_kt rcrd_idx;
+    uint8_t rcrd_len;
+    uint32_t rcrd_cnt;
+} apduh_rcrd_update_ctx_st;
+static_assert(sizeof(apduh_rcrd_update_ctx_st) <= SWICC_APDUH_CTX_PARAM_SIZE,
+              "UPDATE RECORD context does not fit in a handler context");
+
 /**
- * @brief Handle the UPDATE RECORD command in the interindustry class.
- * @note As described in ISO/IEC 7816-4:2020 p.82 sec.11.4.5.
+ * @brief Decode the parameters of UPDATE RECORD and look up the EF and record
+ * they reference.
+ * @param swicc_state
+ * @param cmd
+ * @param res Receives the status when the parameters get rejected.
+ * @param ctx Receives the decoded parameters.
+ * @param ef Receives the EF to update.
+ * @return True if the record was found, false if the response was set.
  */
-static swicc_apduh_ft apduh_rcrd_update;
-static swicc_ret_et apduh_rcrd_update(swicc_st *const swicc_state,
-                                      swicc_apdu_cmd_st const *const cmd,
-                                      swicc_apdu_res_st *const res,
-                                      uint32_t const procedure_count)
+static bool apduh_rcrd_update_prs(swicc_st *const swicc_state,
+                                  swicc_apdu_cmd_st const *const cmd,
+                                  swicc_apdu_res_st *const res,
+                                  apduh_rcrd_update_ctx_st *const ctx,
+                                  swicc_fs_file_st *const ef)
 {
-    /**
-     * Odd instruction (DD) not supported. The data would contain an offset DO
-     * and discretionary DO for encapsulating the updating data.
-     */
-    if (cmd->hdr->ins != 0xDC)
-    {
-        res->sw1 = SWICC_APDU_SW1_CHER_INS;
-        res->sw2 = 0U;
-        res->data.len = 0U;
-        return SWICC_RET_SUCCESS;
-    }
-
     /* Which records to update. */
     enum trgt_e
     {
@@ -1050,7 +1503,7 @@ static swicc_ret_et apduh_rcrd_update(swicc_st *const swicc_state,
     } trgt;
 
     /* Which occurrence to update when updating using an ID. */
-    __attribute__((unused)) swicc_fs_occ_et occ = SWICC_FS_OCC_FIRST;
+    swicc_fs_occ_et occ = SWICC_FS_OCC_FIRST;
 
     /* What record(s) to update when updating using a number. */
     enum what_e
@@ -1129,162 +1582,771 @@ static swicc_ret_et apduh_rcrd_update(swicc_st *const swicc_state,
         }
     }
 
-    /* Perform the requested operation. */
+    /**
+     * Writing a new record to a cyclic EF is done in PREVIOUS mode with P1 set
+     * to 0. The oldest record gets overwritten and becomes record number 1.
+     */
+    bool const rcrd_prev = meth == METH_RCRD_ID && occ == SWICC_FS_OCC_PREV &&
+                           cmd->hdr->p1 == 0x00;
+
+    /**
+     * Look at `apduh_rcrd_read`.
+     */
+    if (cmd->hdr->p2 == 0b11111000 || (meth == METH_RCRD_ID && !rcrd_prev) ||
+        trgt == TRGT_MANY)
     {
-        /**
-         * Look at `apduh_rcrd_read`.
-         */
-        if (cmd->hdr->p2 == 0b11111000 || meth == METH_RCRD_ID ||
-            trgt == TRGT_MANY)
-        {
-            res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
-            res->sw2 = 0x81; /* "Function not supported" */
-            res->data.len = 0U;
-            return SWICC_RET_SUCCESS;
-        }
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x81; /* "Function not supported" */
+        res->data.len = 0U;
+        return false;
+    }
+
+    /**
+     * Look at `apduh_rcrd_read`.
+     */
+    if ((trgt == TRGT_MANY && meth == METH_RCRD_ID) ||
+        (trgt == TRGT_MANY && meth == METH_RCRD_NUM) ||
+        (what == WHAT_RFU && !rcrd_prev) ||
+        (cmd->hdr->p1 == 0x00 && !rcrd_prev) || cmd->hdr->p1 == 0xFF ||
+        (meth == METH_RCRD_NUM && cmd->hdr->p1 < 1))
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+        res->data.len = 0U;
+        return false;
+    }
+
+    /* Safe cast because P1 is >0 when not in PREVIOUS mode. */
+    *ctx = (apduh_rcrd_update_ctx_st){
+        .trgt_sid = trgt == TRGT_EF_SID,
+        .rcrd_prev = rcrd_prev,
+        .rcrd_idx = rcrd_prev ? 0U : (uint8_t)(cmd->hdr->p1 - 1U),
+        .rcrd_len = 0U,
+        .rcrd_cnt = 0U,
+    };
+
+    swicc_ret_et ret_ef = SWICC_RET_ERROR;
+    switch (trgt)
+    {
+    case TRGT_EF_CUR: {
+        *ef = swicc_state->fs.va.cur_ef;
+        ret_ef = SWICC_RET_SUCCESS;
+        break;
+    }
+    case TRGT_EF_SID: {
+        swicc_fs_sid_kt const sid = p2_target;
+        ret_ef = swicc_disk_lutsid_lookup(swicc_state->fs.va.cur_tree, sid, ef);
+        break;
+    }
+    default:
+        /* Already rejected 'many' operation before. */
+        __builtin_unreachable();
+    }
+
+    if (ret_ef == SWICC_RET_FS_NOT_FOUND)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x82; /* "File or application not found" */
+        res->data.len = 0U;
+        return false;
+    }
+    else if (ret_ef != SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return false;
+    }
 
+    /**
+     * Records of a cyclic EF are only written in PREVIOUS mode and that mode is
+     * only supported for cyclic EFs.
+     */
+    bool const ef_cyclic =
+        ef->hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC;
+    if (ef_cyclic != rcrd_prev)
+    {
         /**
-         * Look at `apduh_rcrd_read`.
+         * "Command incompatible with file structure" or "Function not
+         * supported".
          */
-        if ((trgt == TRGT_MANY && meth == METH_RCRD_ID) ||
-            (trgt == TRGT_MANY && meth == METH_RCRD_NUM) || what == WHAT_RFU ||
-            cmd->hdr->p1 == 0x00 || cmd->hdr->p1 == 0xFF ||
-            (meth == METH_RCRD_NUM && cmd->hdr->p1 < 1))
+        res->sw1 = ef_cyclic ? SWICC_APDU_SW1_CHER_CMD
+                             : SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x81;
+        res->data.len = 0U;
+        return false;
+    }
+    else if (rcrd_prev)
+    {
+        if (swicc_disk_file_rcrd_cnt(swicc_state->fs.va.cur_tree, ef,
+                                     &ctx->rcrd_cnt) != SWICC_RET_SUCCESS ||
+            ctx->rcrd_cnt == 0U)
         {
             res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
-            res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+            res->sw2 = 0x83; /* "Record not found" */
             res->data.len = 0U;
-            return SWICC_RET_SUCCESS;
+            return false;
         }
+        /* Safe cast since records are indexed with a uint8. */
+        ctx->rcrd_idx = (swicc_fs_rcrd_idx_kt)(ctx->rcrd_cnt - 1U);
+    }
 
-        if (meth == METH_RCRD_NUM)
-        {
-            /* Safe cast because P1 is >0. */
-            swicc_fs_rcrd_idx_kt const rcrd_idx = (uint8_t)(cmd->hdr->p1 - 1U);
-
-            swicc_fs_file_st ef_cur;
-            swicc_ret_et ret_ef = SWICC_RET_ERROR;
-            switch (trgt)
-            {
-            case TRGT_EF_CUR: {
-                ef_cur = swicc_state->fs.va.cur_ef;
-                ret_ef = SWICC_RET_SUCCESS;
-                break;
-            }
-            case TRGT_EF_SID: {
-                swicc_fs_sid_kt const sid = p2_target;
-                ret_ef = swicc_disk_lutsid_lookup(swicc_state->fs.va.cur_tree,
-                                                  sid, &ef_cur);
-                break;
-            }
-            default:
-                /* Already rejected 'many' operation before. */
-                __builtin_unreachable();
-            }
+    /* Got the target EF, can look up the record now. */
+    uint8_t *rcrd_buf;
+    swicc_ret_et const ret_rcrd =
+        swicc_disk_file_rcrd(swicc_state->fs.va.cur_tree, ef, ctx->rcrd_idx,
+                             &rcrd_buf, &ctx->rcrd_len);
+    if (ret_rcrd != SWICC_RET_SUCCESS)
+    {
+        res->sw1 = ret_rcrd == SWICC_RET_FS_NOT_FOUND
+                       ? SWICC_APDU_SW1_CHER_P1P2_INFO
+                       : SWICC_APDU_SW1_CHER_UNK;
+        /* "Record not found" */
+        res->sw2 = ret_rcrd == SWICC_RET_FS_NOT_FOUND ? 0x83 : 0U;
+        res->data.len = 0U;
+        return false;
+    }
+    return true;
+}
 
-            if (ret_ef == SWICC_RET_FS_NOT_FOUND)
-            {
-                res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
-                res->sw2 = 0x82; /* "File or application not found" */
-                res->data.len = 0U;
-                return SWICC_RET_SUCCESS;
-            }
-            else if (ret_ef == SWICC_RET_SUCCESS)
-            {
-                /* Got the target EF, can read the record now. */
-                uint8_t *rcrd_buf;
-                uint8_t rcrd_len;
-                swicc_ret_et const ret_rcrd =
-                    swicc_disk_file_rcrd(swicc_state->fs.va.cur_tree, &ef_cur,
-                                         rcrd_idx, &rcrd_buf, &rcrd_len);
-                if (ret_rcrd == SWICC_RET_FS_NOT_FOUND)
-                {
-                    res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
-                    res->sw2 = 0x83; /* "Record not found" */
-                    res->data.len = 0U;
-                    return SWICC_RET_SUCCESS;
-                }
-                else if (ret_rcrd == SWICC_RET_SUCCESS)
+/**
+ * @brief Handle the UPDATE RECORD command in the interindustry class.
+ * @note As described in ISO/IEC 7816-4:2020 p.82 sec.11.4.5.
+ */
+static swicc_apduh_ft apduh_rcrd_update;
+static swicc_ret_et apduh_rcrd_update(swicc_st *const swicc_state,
+                                      swicc_apdu_cmd_st const *const cmd,
+                                      swicc_apdu_res_st *const res,
+                                      uint32_t const procedure_count)
+{
+    /**
+     * Odd instruction (DD) not supported. The data would contain an offset DO
+     * and discretionary DO for encapsulating the updating data.
+     */
+    if (cmd->hdr->ins != 0xDC)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_INS;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * The record is looked up before asking for the data so the data phase
+     * continues from what was kept in the handler context.
+     */
+    swicc_apduh_ctx_st *const apduh_ctx = &swicc_state->internal.apduh_ctx;
+    apduh_rcrd_update_ctx_st ctx;
+    swicc_fs_file_st ef_cur;
+    if (apduh_ctx->valid)
+    {
+        memcpy(&ctx, apduh_ctx->param, sizeof(ctx));
+        ef_cur = apduh_ctx->file;
+    }
+    else if (!apduh_rcrd_update_prs(swicc_state, cmd, res, &ctx, &ef_cur))
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * This command (INS=DC) expects the updated data to be sent over. Transmit
+     * a procedure byte to get all of it.
+     */
+    if (procedure_count == 0U)
+    {
+        memcpy(apduh_ctx->param, &ctx, sizeof(ctx));
+        apduh_ctx->tree = swicc_state->fs.va.cur_tree;
+        apduh_ctx->file = ef_cur;
+        apduh_ctx->valid = true;
+
+        res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
+        res->sw2 = 0U;
+        res->data.len = ctx.rcrd_len; /* Expecting as many bytes as are in the
+                                         record. */
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * We sent an ACK ALL procedure and expected as many bytes as are in record
+     * but got a different amount from terminal.
+     */
+    if (cmd->data->len != ctx.rcrd_len)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+        res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+        res->data.len = ctx.rcrd_len;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Check if the expected response length is as expected. */
+    if (*cmd->p3 != ctx.rcrd_len)
+    {
+        /**
+         * Asking the interface to retry the command but this time with correct
+         * expected response length.
+         */
+        res->sw1 = SWICC_APDU_SW1_CHER_LE;
+        res->sw2 = ctx.rcrd_len;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * Have to select the file on success (only if EF was selected by SID).
+     * @warning If this fails, something weird is going on.
+     */
+    swicc_ret_et const ret_file_select =
+        ctx.trgt_sid
+            ? swicc_va_select_file_sid(&swicc_state->fs, ef_cur.hdr_file.sid)
+            : SWICC_RET_SUCCESS;
+    if (ret_file_select == SWICC_RET_SUCCESS)
+    {
+        /**
+         * In any case, have to select the record.
+         * @warning If this fails, something weird is going on.
+         */
+        swicc_ret_et const ret_rcrd_select = swicc_va_select_record_idx(
+            &swicc_state->fs, ctx.rcrd_prev ? 0U : ctx.rcrd_idx);
+        /**
+         * The record must be looked up again after making the file writable
+         * since the data may have moved.
+         */
+        uint8_t *rcrd_buf;
+        uint8_t rcrd_len;
+        if (ret_rcrd_select == SWICC_RET_SUCCESS &&
+            swicc_disk_file_cow(swicc_state->fs.va.cur_tree, &ef_cur) ==
+                SWICC_RET_SUCCESS &&
+            swicc_disk_file_rcrd(swicc_state->fs.va.cur_tree, &ef_cur,
+                                 ctx.rcrd_idx, &rcrd_buf,
+                                 &rcrd_len) == SWICC_RET_SUCCESS)
+        {
+            /* Update the record. */
+            memcpy(rcrd_buf, cmd->data->b, rcrd_len);
+
+            /**
+             * The oldest record slot now holds the most recent record so the
+             * head moves back onto it.
+             */
+            uint8_t rcrd_head;
+            if (ctx.rcrd_prev &&
+                (swicc_disk_file_rcrd_head(swicc_state->fs.va.cur_tree,
+                                           &ef_cur, &rcrd_head) !=
+                     SWICC_RET_SUCCESS ||
+                 swicc_disk_file_rcrd_head_set(
+                     swicc_state->fs.va.cur_tree, &ef_cur,
+                     /* Safe cast since head < count. */
+                     (uint8_t)((rcrd_head + ctx.rcrd_idx) % ctx.rcrd_cnt)) !=
+                     SWICC_RET_SUCCESS))
+            {
+                res->sw1 = SWICC_APDU_SW1_EXER_NVM_CHGM;
+                res->sw2 = 0x81; /* "Memory failure" */
+                res->data.len = 0U;
+                return SWICC_RET_SUCCESS;
+            }
+
+            /* Safe cast since the record is inside the file data. */
+            uint32_t const rcrd_offset = (uint32_t)(rcrd_buf - ef_cur.data);
+            if (swicc_disk_file_dirty_mark(swicc_state->fs.va.cur_tree,
+                                           &ef_cur, rcrd_offset,
+                                           rcrd_len) != SWICC_RET_SUCCESS ||
+                swicc_disk_journal_append(&swicc_state->fs.disk,
+                                          swicc_state->fs.va.cur_tree, &ef_cur,
+                                          rcrd_offset,
+                                          rcrd_len) != SWICC_RET_SUCCESS)
+            {
+                res->sw1 = SWICC_APDU_SW1_EXER_NVM_CHGM;
+                res->sw2 = 0x81; /* "Memory failure" */
+                res->data.len = 0U;
+                return SWICC_RET_SUCCESS;
+            }
+
+            res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+            res->sw2 = 0U;
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+    }
+
+    res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+    res->sw2 = 0U;
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Handle the SEARCH RECORD command in the interindustry class. The
+ * simple search and the enhanced search starting from record P1 are supported.
+ * The numbers of all records that contain the search string are returned.
+ * @note As described in ETSI TS 102 221 V16.4.0 clause.11.1.7.
+ */
+static swicc_apduh_ft apduh_rcrd_search;
+static swicc_ret_et apduh_rcrd_search(swicc_st *const swicc_state,
+                                      swicc_apdu_cmd_st const *const cmd,
+                                      swicc_apdu_res_st *const res,
+                                      uint32_t const procedure_count)
+{
+    /**
+     * Odd instruction (A3) not supported. The data would contain the search
+     * string and offset as BER-TLV DOs.
+     */
+    if (cmd->hdr->ins != 0xA2)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_INS;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* The data field holds the search string which is never empty. */
+    if (procedure_count == 0U)
+    {
+        if (*cmd->p3 == 0U)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+            res->sw2 = 0U;
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+        res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
+        res->sw2 = 0U;
+        res->data.len = *cmd->p3; /* Length of expected data. */
+        return SWICC_RET_SUCCESS;
+    }
+    else if (cmd->data->len != *cmd->p3)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+        res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Type of search. */
+    enum meth_e
+    {
+        METH_SIMPLE_FWD, /* Search forward from record P1. */
+        METH_SIMPLE_BWD, /* Search backward from record P1. */
+        METH_ENHANCED,   /* Search indication is in the data field. */
+        METH_PROPRIETARY,
+        METH_RFU,
+    } meth;
+
+    /* Value of first 5 bits which is the SFI or 0 for the current EF. */
+    uint8_t const p2_target = (cmd->hdr->p2 & 0b11111000) >> 3U;
+
+    /* Parse P2. */
+    switch (cmd->hdr->p2 & 0b00000111)
+    {
+    case 0b100:
+        meth = METH_SIMPLE_FWD;
+        break;
+    case 0b101:
+        meth = METH_SIMPLE_BWD;
+        break;
+    case 0b110:
+        meth = METH_ENHANCED;
+        break;
+    case 0b111:
+        meth = METH_PROPRIETARY;
+        break;
+    default:
+        meth = METH_RFU;
+        break;
+    }
+
+    if (p2_target == 0b11111 || meth == METH_PROPRIETARY)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x81; /* "Function not supported" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    if (meth == METH_RFU || cmd->hdr->p1 == 0x00 || cmd->hdr->p1 == 0xFF)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    bool fwd = meth == METH_SIMPLE_FWD;
+    /* Where searching starts in every record. */
+    bool start_after_value = false;
+    uint8_t start = 0U;
+    /* The search string. */
+    uint8_t const *str = cmd->data->b;
+    uint32_t str_len = cmd->data->len;
+    if (meth == METH_ENHANCED)
+    {
+        /* Search indication is 2 bytes followed by the search string. */
+        if (cmd->data->len < 3U)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+            res->sw2 = 0U;
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+        uint8_t const indic = cmd->data->b[0U];
+        /**
+         * Only searching from record P1 is supported, searching from the
+         * record after or before the current one is not.
+         */
+        if ((indic & 0b00000111) == 0b110 || (indic & 0b00000111) == 0b111)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+            res->sw2 = 0x81; /* "Function not supported" */
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+        if ((indic & 0b11110000) != 0U || (indic & 0b00000110) != 0b100)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+            res->sw2 = 0x80; /* "Incorrect parameters in the data field" */
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+        fwd = (indic & 0b00000001) == 0U;
+        /**
+         * Searching starts either at the offset in the second byte or right
+         * after the first occurrence of the value in the second byte.
+         */
+        start_after_value = (indic & 0b00001000) != 0U;
+        start = cmd->data->b[1U];
+        str = &cmd->data->b[2U];
+        str_len = cmd->data->len - 2U;
+    }
+
+    swicc_fs_file_st ef_cur;
+    swicc_ret_et ret_ef = SWICC_RET_SUCCESS;
+    if (p2_target == 0U)
+    {
+        ef_cur = swicc_state->fs.va.cur_ef;
+    }
+    else
+    {
+        swicc_fs_sid_kt const sid = p2_target;
+        ret_ef = swicc_disk_lutsid_lookup(swicc_state->fs.va.cur_tree, sid,
+                                          &ef_cur);
+    }
+    if (ret_ef == SWICC_RET_FS_NOT_FOUND)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x82; /* "File or application not found" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    uint32_t rcrd_cnt;
+    if (ret_ef != SWICC_RET_SUCCESS ||
+        swicc_disk_file_rcrd_cnt(swicc_state->fs.va.cur_tree, &ef_cur,
+                                 &rcrd_cnt) != SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_CMD;
+        res->sw2 = 0x81; /* "Command incompatible with file structure" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    /**
+     * Records of a cyclic EF are numbered starting from the head (most recent)
+     * one.
+     */
+    uint32_t const rcrd_slot_cnt = rcrd_cnt;
+    uint8_t rcrd_head = 0U;
+    if (ef_cur.hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
+    {
+        (void)swicc_disk_file_rcrd_head(swicc_state->fs.va.cur_tree, &ef_cur,
+                                        &rcrd_head);
+    }
+    /* Records after the last one that P1 can reference are not searched. */
+    if (rcrd_cnt > 0xFE)
+    {
+        rcrd_cnt = 0xFE;
+    }
+    if (cmd->hdr->p1 > rcrd_cnt)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x83; /* "Record not found" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* The records are stored one after another in the file data. */
+    uint8_t const rcrd_size =
+        ef_cur.hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_LINEARFIXED
+            ? ef_cur.hdr_spec.ef_linearfixed.rcrd_size
+            : ef_cur.hdr_spec.ef_cyclic.rcrd_size;
+    uint8_t *data;
+    if (swicc_disk_file_data(swicc_state->fs.va.cur_tree, &ef_cur, &data) !=
+        SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Numbers of the matching records in the order they were searched. */
+    uint8_t rcrd_match[0xFE];
+    uint32_t rcrd_match_count = 0U;
+    uint32_t const rcrd_idx_first = cmd->hdr->p1 - 1U;
+    uint32_t const rcrd_search_count =
+        fwd ? rcrd_cnt - rcrd_idx_first : rcrd_idx_first + 1U;
+    for (uint32_t search_idx = 0U; search_idx < rcrd_search_count;
+         ++search_idx)
+    {
+        uint32_t const rcrd_idx =
+            fwd ? rcrd_idx_first + search_idx : rcrd_idx_first - search_idx;
+        uint8_t const *const rcrd =
+            &data[((rcrd_head + rcrd_idx) % rcrd_slot_cnt) * rcrd_size];
+        uint32_t rcrd_offset = start;
+        if (start_after_value)
+        {
+            uint8_t const *const value = memchr(rcrd, start, rcrd_size);
+            if (value == NULL)
+            {
+                continue;
+            }
+            /* Safe cast since the value is inside the record. */
+            rcrd_offset = (uint32_t)(value - rcrd) + 1U;
+        }
+        uint32_t match_offset;
+        if (rcrd_offset <= rcrd_size &&
+            swicc_mem_find(&rcrd[rcrd_offset], rcrd_size - rcrd_offset, str,
+                           str_len, &match_offset) == SWICC_RET_SUCCESS)
+        {
+            /* Safe cast since the record count was limited to 254. */
+            rcrd_match[rcrd_match_count++] = (uint8_t)(rcrd_idx + 1U);
+        }
+    }
+
+    if (rcrd_match_count == 0U)
+    {
+        res->sw1 = SWICC_APDU_SW1_WARN_NVM_CHGN;
+        res->sw2 = 0x82; /* "Unsuccessful search" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * Select the file (only if EF was referenced by SID) and make the first
+     * matching record the current one.
+     * @warning If this fails, something weird is going on.
+     */
+    if ((p2_target == 0U ||
+         swicc_va_select_file_sid(&swicc_state->fs, ef_cur.hdr_file.sid) ==
+             SWICC_RET_SUCCESS) &&
+        swicc_va_select_record_idx(
+            &swicc_state->fs,
+            /* Safe cast since record numbers are in range 1 to 254. */
+            (swicc_fs_rcrd_idx_kt)(rcrd_match[0U] - 1U)) ==
+            SWICC_RET_SUCCESS &&
+        swicc_apdu_rc_enq(&swicc_state->apdu_rc, rcrd_match,
+                          rcrd_match_count) == SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+        /* Safe cast since at most 254 records are searched. */
+        res->sw2 = (uint8_t)rcrd_match_count;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+    res->sw2 = 0U;
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Handle the GET DATA command in the interindustry class. Both the even
+ * (CA) instruction which gets a DO at the root level of the current EF by the
+ * tag in P1-P2, and the odd (CB) one which gets a nested DO by a tag list (5C)
+ * in the data field, are supported.
+ * @note As described in ISO/IEC 7816-4:2020 clause.11.5.2.
+ */
+static swicc_apduh_ft apduh_data_get;
+static swicc_ret_et apduh_data_get(swicc_st *const swicc_state,
+                                   swicc_apdu_cmd_st const *const cmd,
+                                   swicc_apdu_res_st *const res,
+                                   uint32_t const procedure_count)
+{
+    bool const odd = cmd->hdr->ins == 0xCB;
+
+    /**
+     * The even instruction takes no data so 0 bytes are expected. For the odd
+     * one, P3 is the length of the data field.
+     */
+    if (procedure_count == 0U)
+    {
+        res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
+        res->sw2 = 0U;
+        res->data.len = odd ? *cmd->p3 : 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    else if (!odd && cmd->data->len != 0U)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+        res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    swicc_fs_file_st file = swicc_state->fs.va.cur_ef;
+    if (file.hdr_item.type == SWICC_FS_ITEM_TYPE_INVALID)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_CMD;
+        res->sw2 = 0x86; /* "Command not allowed (curEF not set)" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Tags of the DOs on the path to the requested DO. */
+    swicc_dato_bertlv_tag_st tag_path[SWICC_DATO_BERTLV_DEPTH_MAX];
+    uint32_t tag_path_len = 0U;
+    if (!odd)
+    {
+        /**
+         * P1-P2 is the tag. When P1 is 00, P2 is a tag of 1 byte, otherwise P1
+         * and P2 are the 2 bytes of the tag.
+         */
+        uint8_t const tag_raw[2U] = {cmd->hdr->p1, cmd->hdr->p2};
+        uint32_t const tag_raw_offset = cmd->hdr->p1 == 0U ? 1U : 0U;
+        uint32_t tag_len;
+        if (swicc_dato_bertlv_tag_prs(&tag_path[0U], &tag_len,
+                                      &tag_raw[tag_raw_offset],
+                                      2U - tag_raw_offset) !=
+                SWICC_RET_SUCCESS ||
+            tag_len != 2U - tag_raw_offset)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+            res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+        tag_path_len = 1U;
+    }
+    else
+    {
+        /* Only the current EF (P1-P2 = 0000) can be referenced. */
+        if (cmd->hdr->p1 != 0U || cmd->hdr->p2 != 0U)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+            res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+
+        /**
+         * The data field must be exactly one tag list (5C) DO holding the tags
+         * of the DOs on the path to the requested one.
+         */
+        swicc_dato_bertlv_dec_st decoder;
+        swicc_dato_bertlv_dec_init(&decoder, cmd->data->b, cmd->data->len);
+        bool data_valid =
+            swicc_dato_bertlv_dec_next(&decoder) == SWICC_RET_SUCCESS &&
+            decoder.offset == decoder.len &&
+            decoder.cur.tag.cla == SWICC_DATO_BERTLV_TAG_CLA_APPLICATION &&
+            !decoder.cur.tag.pc && decoder.cur.tag.num == 0x1C;
+        if (data_valid)
+        {
+            uint32_t tag_offset = decoder.offset - decoder.cur.len.val;
+            while (tag_offset < decoder.len)
+            {
+                uint32_t tag_len;
+                if (tag_path_len >= SWICC_DATO_BERTLV_DEPTH_MAX ||
+                    swicc_dato_bertlv_tag_prs(
+                        &tag_path[tag_path_len], &tag_len,
+                        &cmd->data->b[tag_offset],
+                        decoder.len - tag_offset) != SWICC_RET_SUCCESS)
                 {
-                    /**
-                     * This command (INS=DC) expects the updated data to be sent
-                     * over. Transmit a procedure byte to get all of it.
-                     */
-                    if (procedure_count == 0U)
-                    {
-                        res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
-                        res->sw2 = 0U;
-                        res->data.len = rcrd_len; /* Expecting as many bytes as
-                                                     are in the record. */
-                        return SWICC_RET_SUCCESS;
-                    }
-                    else
-                    {
-                        /**
-                         * We sent an ACK ALL procedure and expected as many
-                         * bytes as are in record but got a different amount
-                         * from terminal.
-                         */
-                        if (cmd->data->len != rcrd_len)
-                        {
-                            res->sw1 = SWICC_APDU_SW1_CHER_LEN;
-                            res->sw2 = 0x02; /* The value of Lc is not the one
-                                                expected. */
-                            res->data.len = rcrd_len;
-                            return SWICC_RET_SUCCESS;
-                        }
-                    }
+                    data_valid = false;
+                    break;
+                }
+                tag_offset += tag_len;
+                ++tag_path_len;
+            }
+        }
+        if (!data_valid || tag_path_len == 0U)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+            res->sw2 = 0x80; /* "Incorrect parameters in the command data
+                                field" */
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
+        }
+    }
 
-                    /* Check if the expected response length is as expected. */
-                    if (*cmd->p3 != rcrd_len)
-                    {
-                        /**
-                         * Asking the interface to retry the command but this
-                         * time with correct expected response length.
-                         */
-                        res->sw1 = SWICC_APDU_SW1_CHER_LE;
-                        res->sw2 = rcrd_len;
-                        res->data.len = 0U;
-                        return SWICC_RET_SUCCESS;
-                    }
+    /* DOs are only looked up in transparent EFs holding BER-TLV DOs. */
+    swicc_dato_bertlv_idx_st const *idx;
+    uint8_t *file_data;
+    if (file.hdr_item.type != SWICC_FS_ITEM_TYPE_FILE_EF_TRANSPARENT ||
+        swicc_disk_file_dato_idx(swicc_state->fs.va.cur_tree, &file, &idx,
+                                 &file_data) != SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_CMD;
+        res->sw2 = 0x81; /* "Command incompatible with file structure" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
 
-                    /**
-                     * Have to select the file on success (only if EF was
-                     * selected by SID).
-                     * @warning If this fails, something weird is going on.
-                     */
-                    swicc_ret_et const ret_file_select =
-                        trgt == TRGT_EF_SID
-                            ? swicc_va_select_file_sid(&swicc_state->fs,
-                                                       ef_cur.hdr_file.sid)
-                            : SWICC_RET_SUCCESS;
-                    if (ret_file_select == SWICC_RET_SUCCESS)
-                    {
-                        /**
-                         * In any case, have to select the record.
-                         * @warning If this fails, something weird is going on.
-                         */
-                        swicc_ret_et const ret_rcrd_select =
-                            swicc_va_select_record_idx(&swicc_state->fs,
-                                                       rcrd_idx);
-                        if (ret_rcrd_select == SWICC_RET_SUCCESS)
-                        {
-                            /* Update the record. */
-                            memcpy(rcrd_buf, cmd->data->b, rcrd_len);
+    uint32_t node_idx;
+    swicc_ret_et const ret_lookup = swicc_dato_bertlv_idx_lookup_path(
+        idx, tag_path, tag_path_len, &node_idx);
+    if (ret_lookup == SWICC_RET_FS_NOT_FOUND)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x88; /* "Referenced data or reference data not found" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    swicc_dato_bertlv_node_st const *const node = &idx->node[node_idx];
+    uint32_t const dato_len = node->len_hdr + node->len_val;
+    if (ret_lookup != SWICC_RET_SUCCESS || dato_len > SWICC_DATA_MAX_LONG)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
 
-                            res->sw1 = SWICC_APDU_SW1_NORM_NONE;
-                            res->sw2 = 0U;
-                            res->data.len = 0U;
-                            return SWICC_RET_SUCCESS;
-                        }
-                    }
-                }
-            }
+    static_assert(SWICC_DATA_MAX == SWICC_DATA_MAX_SHRT,
+                  "DO length might not fit in SW2");
+    if (!odd && dato_len <= SWICC_DATA_MAX)
+    {
+        /* P3 is Le where 0 means 256. */
+        uint32_t const len_expected = *cmd->p3 == 0U ? 256U : *cmd->p3;
+        if (dato_len != len_expected)
+        {
+            res->sw1 = SWICC_APDU_SW1_CHER_LE;
+            /* Safe cast since a DO length of 256 is encoded as 0. */
+            res->sw2 = (uint8_t)dato_len;
+            res->data.len = 0U;
+            return SWICC_RET_SUCCESS;
         }
+        res->data_ref = &file_data[node->offset];
+        /* Safe cast since the DO length is at most the response length. */
+        res->data.len = (uint16_t)dato_len;
+        res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+        res->sw2 = 0U;
+        return SWICC_RET_SUCCESS;
     }
 
-    res->sw1 = SWICC_APDU_SW1_CHER_UNK;
-    res->sw2 = 0U;
+    /**
+     * The odd instruction has data and DOs longer than a short response are
+     * chained so the DO is sent through GET RESPONSE.
+     */
+    if (swicc_apdu_rc_enq_ref(&swicc_state->apdu_rc,
+                              &file_data[node->offset],
+                              dato_len) != SWICC_RET_SUCCESS)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+    /**
+     * 00 means 256 or more bytes are available. Safe cast since it's only done
+     * when the length fits.
+     */
+    res->sw2 = dato_len > UINT8_MAX ? 0U : (uint8_t)dato_len;
     res->data.len = 0U;
     return SWICC_RET_SUCCESS;
 }
@@ -1329,18 +2391,17 @@ static swicc_ret_et apduh_res_get(swicc_st *const swicc_state,
         return SWICC_RET_SUCCESS;
     }
 
-    /* Did not request any data. */
-    if (*cmd->p3 == 0U)
+    /* Le of 00 means 256 bytes, e.g. after a 6100 was sent. */
+    uint32_t rc_len = *cmd->p3 == 0U ? SWICC_DATA_MAX_SHRT : *cmd->p3;
+    /* Only copy the data when it's split across parts of the response. */
+    swicc_ret_et ret_rc =
+        swicc_apdu_rc_deq_ref(&swicc_state->apdu_rc, &res->data_ref, rc_len);
+    if (ret_rc == SWICC_RET_ERROR)
     {
-        res->sw1 = SWICC_APDU_SW1_NORM_NONE;
-        res->sw2 = 0U;
-        res->data.len = 0U;
-        return SWICC_RET_SUCCESS;
+        res->data_ref = NULL;
+        ret_rc =
+            swicc_apdu_rc_deq(&swicc_state->apdu_rc, res->data.b, &rc_len);
     }
-
-    uint32_t rc_len = *cmd->p3;
-    swicc_ret_et const ret_rc =
-        swicc_apdu_rc_deq(&swicc_state->apdu_rc, res->data.b, &rc_len);
     if (ret_rc == SWICC_RET_SUCCESS)
     {
         uint32_t const rc_len_rem =
@@ -1351,24 +2412,26 @@ static swicc_ret_et apduh_res_get(swicc_st *const swicc_state,
             if (rc_len_rem > UINT8_MAX)
             {
                 /**
-                 * Can't indicate the real length remaining so just setting it
-                 * to max.
+                 * Can't indicate the real length remaining so 00 is used which
+                 * means 256 or more bytes are available.
                  */
-                res->sw2 = 0xFF;
+                res->sw2 = 0x00;
             }
             else
             {
                 /* Safe cast since if checks if leq uint8 max. */
                 res->sw2 = (uint8_t)rc_len_rem;
             }
-            res->data.len = *cmd->p3;
+            /* Safe cast since at most a short response is dequeued. */
+            res->data.len = (uint16_t)rc_len;
             return SWICC_RET_SUCCESS;
         }
         else
         {
             res->sw1 = SWICC_APDU_SW1_NORM_NONE;
             res->sw2 = 0U;
-            res->data.len = *cmd->p3;
+            /* Safe cast since at most a short response is dequeued. */
+            res->data.len = (uint16_t)rc_len;
             return SWICC_RET_SUCCESS;
         }
     }
@@ -1384,6 +2447,108 @@ static swicc_ret_et apduh_res_get(swicc_st *const swicc_state,
     return SWICC_RET_ERROR;
 }
 
+/**
+ * @brief Handle the MANAGE CHANNEL command in the interindustry class. Opening
+ * a channel chosen by the card (P2 = 00) returns the number of the opened
+ * channel, opening a given channel or closing one returns no data.
+ * @note As described in ISO/IEC 7816-4:2020 clause.11.1.2 and ETSI TS 102 221
+ * V16.4.0 clause.11.1.17.
+ */
+static swicc_apduh_ft apduh_lchan_manage;
+static swicc_ret_et apduh_lchan_manage(swicc_st *const swicc_state,
+                                       swicc_apdu_cmd_st const *const cmd,
+                                       swicc_apdu_res_st *const res,
+                                       uint32_t const procedure_count)
+{
+    /* No data is ever sent to the card. */
+    if (procedure_count == 0U)
+    {
+        res->sw1 = SWICC_APDU_SW1_PROC_ACK_ALL;
+        res->sw2 = 0U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    else if (cmd->data->len != 0U)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_LEN;
+        res->sw2 = 0x02; /* The value of Lc is not the one expected. */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    uint8_t lchan = cmd->hdr->p2;
+    swicc_ret_et ret_lchan;
+    switch (cmd->hdr->p1)
+    {
+    case 0x00:
+        ret_lchan = swicc_va_lchan_open(&swicc_state->fs, &lchan);
+        break;
+    case 0x80:
+        /* Not referencing a channel means closing the one of the command. */
+        if (lchan == 0U)
+        {
+            /* Safe cast since a channel number is at most 19. */
+            lchan = (uint8_t)cmd->hdr->cla.lchan;
+        }
+        ret_lchan = swicc_va_lchan_close(&swicc_state->fs, lchan);
+        break;
+    default:
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    if (ret_lchan == SWICC_RET_FS_NOT_FOUND)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x81; /* "Function not supported" (no channel left) */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    else if (ret_lchan == SWICC_RET_PARAM_BAD)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_P1P2_INFO;
+        res->sw2 = 0x86; /* "Incorrect parameters P1-P2" */
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    else if (ret_lchan != SWICC_RET_SUCCESS)
+    {
+        return ret_lchan;
+    }
+
+    /* Only the number of a channel chosen by the card is returned. */
+    if (cmd->hdr->p1 == 0x00 && cmd->hdr->p2 == 0U)
+    {
+        if (swicc_apdu_rc_enq(&swicc_state->apdu_rc, &lchan, 1U) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+        res->sw2 = 1U;
+        res->data.len = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+    res->sw2 = 0U;
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+/* Default handlers of the interindustry instructions. */
+static swicc_apduh_ft *const apduh_tbl_ii[SWICC_APDUH_INS_COUNT] = {
+    [0x70] = apduh_lchan_manage, [0xA2] = apduh_rcrd_search,
+    [0xA3] = apduh_rcrd_search,  [0xA4] = apduh_select,
+    [0xB0] = apduh_bin_read,     [0xB1] = apduh_bin_read,
+    [0xB2] = apduh_rcrd_read,    [0xB3] = apduh_rcrd_read,
+    [0xC0] = apduh_res_get,      [0xCA] = apduh_data_get,
+    [0xCB] = apduh_data_get,     [0xD6] = apduh_bin_update,
+    [0xD7] = apduh_bin_update,   [0xDC] = apduh_rcrd_update,
+    [0xDD] = apduh_rcrd_update,
+};
+
 swicc_ret_et swicc_apduh_pro_register(swicc_st *const swicc_state,
                                       swicc_apduh_ft *const handler)
 {
@@ -1395,6 +2560,21 @@ swicc_ret_et swicc_apduh_pro_register(swicc_st *const swicc_state,
     return SWICC_RET_SUCCESS;
 }
 
+swicc_ret_et swicc_apduh_register(swicc_st *const swicc_state,
+                                  swicc_apdu_cla_type_et const cla_type,
+                                  uint8_t const ins,
+                                  swicc_apduh_ft *const handler)
+{
+    if (swicc_state == NULL || (cla_type != SWICC_APDU_CLA_TYPE_INTERINDUSTRY &&
+                                cla_type != SWICC_APDU_CLA_TYPE_PROPRIETARY))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_state->apduh_tbl[cla_type - SWICC_APDU_CLA_TYPE_INTERINDUSTRY][ins] =
+        handler;
+    return SWICC_RET_SUCCESS;
+}
+
 swicc_ret_et swicc_apduh_override_register(swicc_st *const swicc_state,
                                            swicc_apduh_ft *const handler)
 {
@@ -1406,6 +2586,12 @@ swicc_ret_et swicc_apduh_override_register(swicc_st *const swicc_state,
     return SWICC_RET_SUCCESS;
 }
 
+void swicc_apduh_pending_complete(swicc_st *const swicc_state)
+{
+    atomic_store_explicit(&swicc_state->internal.apduh_pending_done, true,
+                          memory_order_release);
+}
+
 static __attribute__((unused)) void trace_custom(
     bool trace_cmd, bool trace_res, swicc_apdu_cmd_st const *const cmd,
     swicc_apdu_res_st *const res)
@@ -1432,12 +2618,130 @@ static __attribute__((unused)) void trace_custom(
     }
 }
 
+/**
+ * @brief Copy borrowed response data into the data buffer of the response.
+ * @param res
+ */
+static void apduh_res_data_own(swicc_apdu_res_st *const res)
+{
+    if (res->data_ref != NULL)
+    {
+        memmove(res->data.b, res->data_ref, res->data.len);
+        res->data_ref = NULL;
+    }
+}
+
+/**
+ * @brief Make the VA of the logical channel of a command the current one.
+ * @param swicc_state
+ * @param cmd
+ * @param res Receives the error status when the channel is not open.
+ * @return True if the command can be handled on its channel, false otherwise.
+ */
+static bool apduh_lchan_switch(swicc_st *const swicc_state,
+                               swicc_apdu_cmd_st const *const cmd,
+                               swicc_apdu_res_st *const res)
+{
+    /* Safe cast since a channel number is at most 19. */
+    if (swicc_va_lchan_switch(&swicc_state->fs,
+                              (uint8_t)cmd->hdr->cla.lchan) ==
+        SWICC_RET_SUCCESS)
+    {
+        return true;
+    }
+    res->sw1 = SWICC_APDU_SW1_CHER_CLA_FUNC;
+    res->sw2 = 0x81; /* "Logical channel not supported" */
+    res->data.len = 0U;
+    return false;
+}
+
+/**
+ * @brief Count a call of a handler in the stats of the card (if enabled).
+ * @param swicc_state
+ * @param cmd
+ * @param res Response of the handler, NULL when it is pending.
+ * @param cmd_new If this is the first call for the command.
+ * @param time_start When the handler was called.
+ */
+static void apduh_stats(swicc_st *const swicc_state,
+                        swicc_apdu_cmd_st const *const cmd,
+                        swicc_apdu_res_st const *const res, bool const cmd_new,
+                        uint64_t const time_start)
+{
+    swicc_stats_st *const stats = swicc_state->stats;
+    if (stats == NULL)
+    {
+        return;
+    }
+    uint64_t const time = swicc_stats_time() - time_start;
+    swicc_apdu_cla_type_et const cla_type = cmd->hdr->cla.type;
+    if (cmd_new && (uint32_t)cla_type < SWICC_STATS_CLA_TYPE_COUNT)
+    {
+        swicc_stats_add(&stats->cmd_cla[cla_type], 1U);
+    }
+    if (cla_type == SWICC_APDU_CLA_TYPE_INTERINDUSTRY ||
+        cla_type == SWICC_APDU_CLA_TYPE_PROPRIETARY)
+    {
+        uint8_t const cla_idx =
+            cla_type == SWICC_APDU_CLA_TYPE_INTERINDUSTRY ? 0 : 1;
+        if (cmd_new)
+        {
+            swicc_stats_add(&stats->cmd_ins[cla_idx][cmd->hdr->ins], 1U);
+        }
+        swicc_stats_handler(stats, cla_idx, cmd->hdr->ins, time);
+    }
+
+    /* Procedure bytes are not the status of a response. */
+    if (res != NULL && res->sw1 != SWICC_APDU_SW1_PROC_NULL &&
+        res->sw1 != SWICC_APDU_SW1_PROC_ACK_ONE &&
+        res->sw1 != SWICC_APDU_SW1_PROC_ACK_ALL)
+    {
+        /* Safe cast since the SW1 is a byte. */
+        uint8_t const sw1 = (uint8_t)res->sw1;
+        swicc_stats_add(&stats->sw1[sw1], 1U);
+        if (sw1 >= SWICC_STATS_SW2_SW1_FIRST && sw1 <= SWICC_STATS_SW2_SW1_LAST)
+        {
+            swicc_stats_add(
+                &stats->sw2[sw1 - SWICC_STATS_SW2_SW1_FIRST][res->sw2], 1U);
+        }
+    }
+}
+
 swicc_ret_et swicc_apduh_demux(swicc_st *const swicc_state,
                                swicc_apdu_cmd_st const *const cmd,
                                swicc_apdu_res_st *const res,
                                uint32_t const procedure_count)
 {
     swicc_ret_et ret = SWICC_RET_APDU_UNHANDLED;
+    res->data_ref = NULL;
+    uint64_t const time_start =
+        swicc_state->stats != NULL || swicc_state->capture != NULL
+            ? swicc_stats_time()
+            : 0U;
+    bool const cmd_new =
+        procedure_count == 0U && !swicc_state->internal.apduh_pending;
+    if (cmd_new && swicc_state->capture != NULL)
+    {
+        swicc_state->capture->time_cmd = time_start;
+    }
+
+    /**
+     * The handler context only lives through the phases of one command. It is
+     * also dropped if a later phase gets called for a different command. A
+     * handler resumed after pending is still in the same phase.
+     */
+    swicc_apduh_ctx_st *const apduh_ctx = &swicc_state->internal.apduh_ctx;
+    if (cmd_new || apduh_ctx->cla_raw != cmd->hdr->cla.raw ||
+        apduh_ctx->ins != cmd->hdr->ins || apduh_ctx->p1 != cmd->hdr->p1 ||
+        apduh_ctx->p2 != cmd->hdr->p2)
+    {
+        apduh_ctx->valid = false;
+        apduh_ctx->cla_raw = cmd->hdr->cla.raw;
+        apduh_ctx->ins = cmd->hdr->ins;
+        apduh_ctx->p1 = cmd->hdr->p1;
+        apduh_ctx->p2 = cmd->hdr->p2;
+    }
+
     switch (cmd->hdr->cla.type)
     {
     case SWICC_APDU_CLA_TYPE_INVALID:
@@ -1447,7 +2751,12 @@ swicc_ret_et swicc_apduh_demux(swicc_st *const swicc_state,
         res->data.len = 0;
         ret = SWICC_RET_SUCCESS;
         break;
-    case SWICC_APDU_CLA_TYPE_INTERINDUSTRY:
+    case SWICC_APDU_CLA_TYPE_INTERINDUSTRY: {
+        if (!apduh_lchan_switch(swicc_state, cmd, res))
+        {
+            ret = SWICC_RET_SUCCESS;
+            break;
+        }
         if (cmd->hdr->ins != 0xC0) /* GET RESPONSE instruction */
         {
             /* Make GET RESPONSE deterministically not work if resumed. */
@@ -1455,58 +2764,57 @@ swicc_ret_et swicc_apduh_demux(swicc_st *const swicc_state,
         }
 
         /**
-         * Let the interindustry implementations to be overridden by proprietary
-         * ones.
+         * A registered handler overrides the default implementation of the
+         * instruction unless it leaves the message unhandled.
          */
-        if (swicc_state->internal.apduh_pro != NULL)
+        swicc_apduh_ft *const apduh_reg =
+            swicc_state->apduh_tbl[0U][cmd->hdr->ins];
+        if (apduh_reg != NULL)
         {
-            ret = swicc_state->internal.apduh_pro(swicc_state, cmd, res,
-                                                  procedure_count);
+            ret = apduh_reg(swicc_state, cmd, res, procedure_count);
             if (ret != SWICC_RET_APDU_UNHANDLED)
             {
                 break;
             }
         }
 
-        swicc_apduh_ft *apduh_func = apduh_unk;
-        switch (cmd->hdr->ins)
+        swicc_apduh_ft *const apduh_func = apduh_tbl_ii[cmd->hdr->ins];
+        ret = (apduh_func == NULL ? apduh_unk : apduh_func)(
+            swicc_state, cmd, res, procedure_count);
+        break;
+    }
+    case SWICC_APDU_CLA_TYPE_PROPRIETARY: {
+        if (!apduh_lchan_switch(swicc_state, cmd, res))
         {
-        case 0xA4:
-            apduh_func = apduh_select;
-            break;
-        case 0xB0:
-        case 0xB1:
-            apduh_func = apduh_bin_read;
-            break;
-        case 0xB2:
-        case 0xB3:
-            apduh_func = apduh_rcrd_read;
-            break;
-        case 0xC0:
-            apduh_func = apduh_res_get;
-            break;
-        case 0xDC:
-        case 0xDD:
-            apduh_func = apduh_rcrd_update;
+            ret = SWICC_RET_SUCCESS;
             break;
         }
-        ret = apduh_func(swicc_state, cmd, res, procedure_count);
-        break;
-    case SWICC_APDU_CLA_TYPE_PROPRIETARY:
-        if (swicc_state->internal.apduh_pro == NULL)
+        swicc_apduh_ft *apduh_func = swicc_state->apduh_tbl[1U][cmd->hdr->ins];
+        if (apduh_func == NULL)
+        {
+            /* Fall back to the handler of the whole class. */
+            apduh_func = swicc_state->internal.apduh_pro;
+        }
+        if (apduh_func == NULL)
         {
             ret = SWICC_RET_APDU_UNHANDLED;
             break;
         }
-        ret = swicc_state->internal.apduh_pro(swicc_state, cmd, res,
-                                              procedure_count);
+        ret = apduh_func(swicc_state, cmd, res, procedure_count);
         break;
+    }
     default:
         ret = SWICC_RET_APDU_UNHANDLED;
         break;
     }
 
-    if (ret == SWICC_RET_APDU_UNHANDLED)
+    if (ret == SWICC_RET_APDU_PENDING)
+    {
+        /* There is no response yet, the handler will be called again. */
+        apduh_stats(swicc_state, cmd, NULL, cmd_new, time_start);
+        return ret;
+    }
+    else if (ret == SWICC_RET_APDU_UNHANDLED)
     {
         ret = SWICC_RET_SUCCESS;
         res->sw1 = SWICC_APDU_SW1_CHER_INS;
@@ -1530,6 +2838,8 @@ swicc_ret_et swicc_apduh_demux(swicc_st *const swicc_state,
 
     if (swicc_state->internal.apduh_override != NULL)
     {
+        /* The override may look at and modify the response data. */
+        apduh_res_data_own(res);
         ret = swicc_state->internal.apduh_override(swicc_state, cmd, res,
                                                    procedure_count);
         if (ret != SWICC_RET_SUCCESS)
@@ -1541,6 +2851,22 @@ swicc_ret_et swicc_apduh_demux(swicc_st *const swicc_state,
             res->data.len = 0;
         }
     }
+    apduh_stats(swicc_state, cmd, res, cmd_new, time_start);
+    if (swicc_state->capture != NULL &&
+        res->sw1 != SWICC_APDU_SW1_PROC_NULL &&
+        res->sw1 != SWICC_APDU_SW1_PROC_ACK_ONE &&
+        res->sw1 != SWICC_APDU_SW1_PROC_ACK_ALL)
+    {
+        swicc_capture_apdu(swicc_state->capture, cmd, res, swicc_stats_time());
+    }
+    if (swicc_state->wire != NULL &&
+        res->sw1 != SWICC_APDU_SW1_PROC_NULL &&
+        res->sw1 != SWICC_APDU_SW1_PROC_ACK_ONE &&
+        res->sw1 != SWICC_APDU_SW1_PROC_ACK_ALL)
+    {
+        /* The command is complete once this response got sent. */
+        swicc_state->wire->cmd_done = true;
+    }
 
 #ifdef TRACE_CUSTOM
 #pragma message("Tracing format: custom.")
@@ -1552,9 +2878,253 @@ swicc_ret_et swicc_apduh_demux(swicc_st *const swicc_state,
           res->sw1 == SWICC_APDU_SW1_PROC_ACK_ONE ||
           res->sw1 == SWICC_APDU_SW1_PROC_ACK_ALL))
     {
+        apduh_res_data_own(res);
         trace_custom(true, true, cmd, res);
     }
 #endif
 
     return ret;
 }
+
+swicc_ret_et swicc_apduh_exec_cmd_set(swicc_st *const swicc_state,
+                                      uint8_t const *const capdu,
+                                      uint16_t const capdu_len)
+{
+    if (swicc_state == NULL || capdu == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint8_t p3 = 0U;
+    uint16_t lc = 0U;
+    bool le = false;
+
+    if (capdu_len < sizeof(swicc_apdu_cmd_hdr_raw_st))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    else if (capdu_len == sizeof(swicc_apdu_cmd_hdr_raw_st) + 1U)
+    {
+        /* Case 2: only Le. */
+        p3 = capdu[4U];
+        le = true;
+    }
+    else if (capdu_len > sizeof(swicc_apdu_cmd_hdr_raw_st) + 1U)
+    {
+        /* Case 3 or 4: Lc then data, and Le in case 4. */
+        p3 = capdu[4U];
+        lc = p3;
+        if (lc == 0U)
+        {
+            /* Extended length fields are not supported. */
+            return SWICC_RET_PARAM_BAD;
+        }
+        if (capdu_len == 5U + lc + 1U)
+        {
+            le = true;
+        }
+        else if (capdu_len != 5U + lc)
+        {
+            return SWICC_RET_PARAM_BAD;
+        }
+    }
+
+    swicc_tpdu_cmd_st *const tpdu = &swicc_state->internal.tpdu_cur;
+    memset(tpdu, 0U, sizeof(*tpdu));
+    tpdu->hdr.cla = swicc_apdu_cmd_cla_parse(capdu[0U]);
+    tpdu->hdr.ins = capdu[1U];
+    tpdu->hdr.p1 = capdu[2U];
+    tpdu->hdr.p2 = capdu[3U];
+    tpdu->p3 = p3;
+    if (lc > 0U)
+    {
+        /* The data is only given to the handler once it acknowledges. */
+        memcpy(tpdu->data.b, &capdu[5U], lc);
+    }
+    swicc_tpdu_to_apdu(&swicc_state->internal.apdu_cur, tpdu);
+    swicc_state->internal.procedure_count = 0U;
+    swicc_state->internal.apduh_pending = false;
+    swicc_state->internal.apduh_exec = (swicc_apduh_exec_st){
+        .lc = lc,
+        .le = le,
+        .rapdu_len = 0U,
+    };
+
+    if (swicc_state->trace != NULL)
+    {
+        swicc_trace_evt_st evt = {
+            .type = SWICC_TRACE_EVT_TYPE_APDU_CMD,
+            .apdu_cmd =
+                {
+                    .cla = capdu[0U],
+                    .ins = capdu[1U],
+                    .p1 = capdu[2U],
+                    .p2 = capdu[3U],
+                    .p3 = p3,
+                },
+        };
+        swicc_trace_push(swicc_state->trace, &evt);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_apduh_exec_handle(swicc_st *const swicc_state,
+                                     uint8_t *const rapdu,
+                                     uint16_t const rapdu_size)
+{
+    if (swicc_state == NULL || rapdu == NULL || rapdu_size < 2U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_apduh_exec_st *const exec = &swicc_state->internal.apduh_exec;
+    swicc_tpdu_cmd_st *const tpdu = &swicc_state->internal.tpdu_cur;
+    swicc_apdu_res_st res;
+    for (;;)
+    {
+        /* A completion only counts if it comes after calling the handler. */
+        atomic_store_explicit(&swicc_state->internal.apduh_pending_done, false,
+                              memory_order_relaxed);
+        swicc_ret_et const ret =
+            swicc_apduh_demux(swicc_state, &swicc_state->internal.apdu_cur,
+                              &res, swicc_state->internal.procedure_count);
+        swicc_state->internal.apduh_pending = ret == SWICC_RET_APDU_PENDING;
+        if (swicc_state->internal.apduh_pending)
+        {
+            return ret;
+        }
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            SWICC_APDUH_RES((&res), SWICC_APDU_SW1_CHER_UNK, 0U, 0U);
+            res.data_ref = NULL;
+        }
+
+        if (res.sw1 == SWICC_APDU_SW1_PROC_ACK_ONE ||
+            res.sw1 == SWICC_APDU_SW1_PROC_ACK_ALL)
+        {
+            bool const data_rem = tpdu->data.len < exec->lc;
+            if ((data_rem || res.data.len == 0U) &&
+                swicc_state->internal.procedure_count < sizeof(uint32_t))
+            {
+                if (data_rem)
+                {
+                    /* Give all of the data at once. */
+                    tpdu->data.len = exec->lc;
+                }
+                swicc_state->internal.procedure_count += 1U;
+                continue;
+            }
+            /* Handler wants more data than the C-APDU has. */
+            SWICC_APDUH_RES((&res), SWICC_APDU_SW1_CHER_LEN, 0U, 0U);
+            res.data_ref = NULL;
+        }
+        else if (res.sw1 == SWICC_APDU_SW1_PROC_NULL)
+        {
+            SWICC_APDUH_RES((&res), SWICC_APDU_SW1_CHER_UNK, 0U, 0U);
+            res.data_ref = NULL;
+        }
+
+        uint8_t const *const data =
+            res.data_ref != NULL ? res.data_ref : res.data.b;
+        /* Length of the data that will be retrieved with GET RESPONSE. */
+        uint16_t const len_get = res.sw2 == 0U ? 256U : res.sw2;
+        if (res.sw1 == SWICC_APDU_SW1_NORM_BYTES_AVAILABLE && exec->le &&
+            (res.data.len > 0U || tpdu->hdr.ins != 0xC0) &&
+            (uint32_t)exec->rapdu_len + res.data.len + len_get + 2U <=
+                rapdu_size)
+        {
+            /**
+             * Keep the data then retrieve the rest with GET RESPONSE on the
+             * same logical channel. This stops if GET RESPONSE returns no data
+             * to avoid looping forever.
+             */
+            memcpy(&rapdu[exec->rapdu_len], data, res.data.len);
+            /* Safe cast since this was checked to fit in the R-APDU. */
+            exec->rapdu_len = (uint16_t)(exec->rapdu_len + res.data.len);
+            uint16_t const lchan = tpdu->hdr.cla.lchan;
+            /* Safe cast since a channel number is at most 19. */
+            tpdu->hdr.cla = swicc_apdu_cmd_cla_parse(
+                lchan < 4U ? (uint8_t)lchan : (uint8_t)(0x40U | (lchan - 4U)));
+            tpdu->hdr.ins = 0xC0;
+            tpdu->hdr.p1 = 0U;
+            tpdu->hdr.p2 = 0U;
+            tpdu->p3 = res.sw2;
+            tpdu->data.len = 0U;
+            exec->lc = 0U;
+            swicc_state->internal.procedure_count = 0U;
+            continue;
+        }
+
+        if ((uint32_t)exec->rapdu_len + res.data.len + 2U > rapdu_size)
+        {
+            /* The response does not fit. */
+            exec->rapdu_len = 0U;
+            SWICC_APDUH_RES((&res), SWICC_APDU_SW1_CHER_UNK, 0U, 0U);
+        }
+        memcpy(&rapdu[exec->rapdu_len], data, res.data.len);
+        /* Safe cast since this was checked to fit in the R-APDU. */
+        exec->rapdu_len = (uint16_t)(exec->rapdu_len + res.data.len);
+        /* Safe cast since SW1 is a byte. */
+        rapdu[exec->rapdu_len++] = (uint8_t)res.sw1;
+        rapdu[exec->rapdu_len++] = res.sw2;
+        break;
+    }
+
+    if (swicc_state->trace != NULL)
+    {
+        swicc_trace_evt_st evt = {
+            .type = SWICC_TRACE_EVT_TYPE_APDU_RES,
+            .apdu_res =
+                {
+                    /* Safe cast since SW1 is a byte. */
+                    .sw1 = (uint8_t)res.sw1,
+                    .sw2 = res.sw2,
+                    .data_len = (uint16_t)(exec->rapdu_len - 2U),
+                },
+        };
+        swicc_trace_push(swicc_state->trace, &evt);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_apduh_exec(swicc_st *const swicc_state,
+                              uint8_t const *const capdu,
+                              uint16_t const capdu_len, uint8_t *const rapdu,
+                              uint16_t *const rapdu_len)
+{
+    if (swicc_state == NULL || capdu == NULL || rapdu == NULL ||
+        rapdu_len == NULL || *rapdu_len < 2U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    /* A disk waiting to be swapped in is taken before the command starts. */
+    swicc_fs_disk_swap_apply(swicc_state);
+    swicc_ret_et const ret =
+        swicc_apduh_exec_cmd_set(swicc_state, capdu, capdu_len);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        return ret;
+    }
+    return swicc_apduh_exec_resume(swicc_state, rapdu, rapdu_len);
+}
+
+swicc_ret_et swicc_apduh_exec_resume(swicc_st *const swicc_state,
+                                     uint8_t *const rapdu,
+                                     uint16_t *const rapdu_len)
+{
+    if (swicc_state == NULL || rapdu == NULL || rapdu_len == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (swicc_state->internal.apduh_pending &&
+        !atomic_load_explicit(&swicc_state->internal.apduh_pending_done,
+                              memory_order_acquire))
+    {
+        return SWICC_RET_APDU_PENDING;
+    }
+    swicc_ret_et const ret =
+        swicc_apduh_exec_handle(swicc_state, rapdu, *rapdu_len);
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        *rapdu_len = swicc_state->internal.apduh_exec.rapdu_len;
+    }
+    return ret;
+}
@@ -43,31 +43,38 @@ uint8_t const swicc_atr[] = {
     0b00000000, /**
                  * TC1 = N (extra guard time) = 0 (default)
                  */
-    0b10010000, /**
+    0b10000000, /**
                  * LSB>MSB
                  * TD1 =   4b T  = 0 (half-duplex character-based protocol)
-                 *       + 4b Y2 = TA2 and TD2 are present
+                 *       + 4b Y2 = TD2 is present
+                 *
+                 * TA2 is absent so the card is in negotiable mode and T=1 can
+                 * be selected with a PPS exchange. Without PPS, the first
+                 * offered protocol (T=0) is used with default values.
                  */
-    0b00010000, /**
+    0b10010001, /**
                  * LSB>MSB
-                 * TA2 =   4b T       = 0 (half-duplex character-based protocol)
-                 *       + 1b F and D = 1 (implicit values)
-                 *       + 2b RFU     = 0
-                 *       + 1b Mode    = 0 (capable to change)
+                 * TD2 =   4b T  = 1 (half-duplex block protocol)
+                 *       + 4b Y3 = TA3 and TD3 are present
+                 */
+    0xFE,       /**
+                 * TA3 = IFSC = 254 (size of the information field the card can
+                 * receive in a block)
+                 * ISO/IEC 7816-3:2006 clause.11.4.2
                  */
     0b00111111, /**
                  * LSB>MSB
-                 * TD2 =   4b T  = 15
-                 *       + 4b Y3 = TA3 and TB3 are present
+                 * TD3 =   4b T  = 15
+                 *       + 4b Y4 = TA4 and TB4 are present
                  */
     0b00000111, /**
                  * LSB>MSB
-                 * TA3 =   6b Y = 7 = A, B, and C (class indicator)
+                 * TA4 =   6b Y = 7 = A, B, and C (class indicator)
                  *       + 2b X = 0 = Clock stop not supported
                  */
     0b00000000, /**
                  * LSB>MSB
-                 * TB3 =   7b SPU Purpose     = 0 (not used)
+                 * TB4 =   7b SPU Purpose     = 0 (not used)
                  *       + 1b SPU Proprietary = 0 (standard use of SPU)
                  */
 
@@ -142,7 +149,7 @@ uint8_t const swicc_atr[] = {
                  * 't', 'z', 'y' with: 4y + 2z + t + 1 (when not all =1, else it
                  * means 8 or more)
                  */
-    0x06,       /**
+    0x69,       /**
                  * Check byte (TCK)
                  *  = XOR of all bytes (with TCK=0)
                  */
@@ -0,0 +1,363 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Parameters of the 64-bit FNV-1a hash. */
+#define CAPTURE_FNV_OFFSET 14695981039346656037ULL
+#define CAPTURE_FNV_PRIME 1099511628211ULL
+
+/**
+ * How many times (every millisecond) a replay checks if a pending handler
+ * completed before giving up on it.
+ */
+#define CAPTURE_PENDING_WAIT_MAX 100U
+
+/**
+ * @brief Extend a hash (64-bit FNV-1a) with some bytes.
+ * @param hash
+ * @param buf
+ * @param buf_len
+ * @return The extended hash.
+ */
+static uint64_t capture_hash(uint64_t hash, uint8_t const *const buf,
+                             uint32_t const buf_len)
+{
+    for (uint32_t byte_idx = 0U; byte_idx < buf_len; ++byte_idx)
+    {
+        hash = (hash ^ buf[byte_idx]) * CAPTURE_FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Write all buffered records to the capture file.
+ * @param capture
+ */
+static void capture_flush(swicc_capture_st *const capture)
+{
+    uint32_t written = 0U;
+    while (!capture->failed && written < capture->buf_len)
+    {
+        ssize_t const len = write(capture->fd, &capture->buf[written],
+                                  capture->buf_len - written);
+        if (len < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (len <= 0)
+        {
+            capture->failed = true;
+            break;
+        }
+        /* Safe cast since at most the remaining length was written. */
+        written += (uint32_t)len;
+    }
+    capture->buf_len = 0U;
+}
+
+/**
+ * @brief Append a record to the capture.
+ * @param capture
+ * @param rcrd_hdr
+ * @param capdu
+ * @param rapdu_data Data of the R-APDU (without the status).
+ * @param rapdu_data_len
+ * @param sw Status of the R-APDU, only when there is an R-APDU.
+ */
+static void capture_rcrd(swicc_capture_st *const capture,
+                         swicc_capture_rcrd_hdr_raw_st const *const rcrd_hdr,
+                         uint8_t const *const capdu,
+                         uint8_t const *const rapdu_data,
+                         uint16_t const rapdu_data_len, uint8_t const *const sw)
+{
+    if (capture->failed)
+    {
+        return;
+    }
+    if (capture->buf_len + sizeof(*rcrd_hdr) + rcrd_hdr->capdu_len +
+            rcrd_hdr->rapdu_len >
+        sizeof(capture->buf))
+    {
+        capture_flush(capture);
+    }
+    uint8_t *const buf = &capture->buf[capture->buf_len];
+    uint32_t len = 0U;
+    memcpy(&buf[len], rcrd_hdr, sizeof(*rcrd_hdr));
+    len += sizeof(*rcrd_hdr);
+    /* A reset has neither a C-APDU nor an R-APDU. */
+    if (rcrd_hdr->type == SWICC_CAPTURE_RCRD_TYPE_APDU)
+    {
+        memcpy(&buf[len], capdu, rcrd_hdr->capdu_len);
+        len += rcrd_hdr->capdu_len;
+        memcpy(&buf[len], rapdu_data, rapdu_data_len);
+        len += rapdu_data_len;
+        memcpy(&buf[len], sw, 2U);
+        len += 2U;
+    }
+    capture->buf_len += len;
+}
+
+swicc_ret_et swicc_capture_disk_id(swicc_disk_st const *const disk,
+                                   uint64_t *const disk_id)
+{
+    if (disk == NULL || disk_id == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint64_t hash = CAPTURE_FNV_OFFSET;
+    swicc_disk_tree_iter_st tree_iter;
+    swicc_ret_et ret = swicc_disk_tree_iter(disk, &tree_iter);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        return ret;
+    }
+    swicc_disk_tree_st *tree = tree_iter.tree;
+    do
+    {
+        /* The length separates the trees so their bytes can not shift. */
+        hash = capture_hash(hash, (uint8_t const *)&tree->len,
+                            sizeof(tree->len));
+        uint8_t chunk[4096U];
+        for (uint32_t offset = 0U; offset < tree->len; offset += sizeof(chunk))
+        {
+            uint32_t const chunk_len = tree->len - offset < sizeof(chunk)
+                                           ? tree->len - offset
+                                           : sizeof(chunk);
+            ret = swicc_disk_tree_read(tree, offset, chunk_len, chunk);
+            if (ret != SWICC_RET_SUCCESS)
+            {
+                return ret;
+            }
+            hash = capture_hash(hash, chunk, chunk_len);
+        }
+    } while ((ret = swicc_disk_tree_iter_next(&tree_iter, &tree)) ==
+             SWICC_RET_SUCCESS);
+    if (ret != SWICC_RET_FS_NOT_FOUND)
+    {
+        return ret;
+    }
+    *disk_id = hash;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_capture_open(swicc_capture_st *const capture,
+                                swicc_disk_st const *const disk,
+                                char const *const capture_path)
+{
+    if (capture == NULL || disk == NULL || capture_path == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint64_t disk_id;
+    swicc_ret_et const ret = swicc_capture_disk_id(disk, &disk_id);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        return ret;
+    }
+    swicc_capture_hdr_raw_st hdr = {
+        .version = SWICC_CAPTURE_VERSION,
+        .disk_id = disk_id,
+    };
+    memcpy(hdr.magic, SWICC_CAPTURE_MAGIC, sizeof(hdr.magic));
+    int const fd = open(capture_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    capture->fd = fd;
+    capture->failed = false;
+    capture->time_start = swicc_stats_time();
+    capture->time_cmd = capture->time_start;
+    memcpy(capture->buf, &hdr, sizeof(hdr));
+    capture->buf_len = sizeof(hdr);
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_capture_close(swicc_capture_st *const capture)
+{
+    if (capture == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    capture_flush(capture);
+    swicc_ret_et ret = capture->failed ? SWICC_RET_ERROR : SWICC_RET_SUCCESS;
+    if (close(capture->fd) != 0)
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    capture->fd = -1;
+    return ret;
+}
+
+void swicc_capture_apdu(swicc_capture_st *const capture,
+                        swicc_apdu_cmd_st const *const cmd,
+                        swicc_apdu_res_st const *const res,
+                        uint64_t const time)
+{
+    uint8_t capdu[SWICC_CAPTURE_CAPDU_LEN_MAX];
+    uint16_t capdu_len = 0U;
+    capdu[capdu_len++] = cmd->hdr->cla.raw;
+    capdu[capdu_len++] = cmd->hdr->ins;
+    capdu[capdu_len++] = cmd->hdr->p1;
+    capdu[capdu_len++] = cmd->hdr->p2;
+    capdu[capdu_len++] = *cmd->p3;
+    memcpy(&capdu[capdu_len], cmd->data->b, cmd->data->len);
+    /* Safe cast since the data is at most 256 bytes long. */
+    capdu_len = (uint16_t)(capdu_len + cmd->data->len);
+
+    uint64_t const duration = time - capture->time_cmd;
+    /* Safe cast since SW1 is a byte. */
+    uint8_t const sw[2U] = {(uint8_t)res->sw1, res->sw2};
+    swicc_capture_rcrd_hdr_raw_st const rcrd_hdr = {
+        .type = SWICC_CAPTURE_RCRD_TYPE_APDU,
+        .capdu_len = capdu_len,
+        /* Safe cast since the data is at most 256 bytes long. */
+        .rapdu_len = (uint16_t)(res->data.len + 2U),
+        .time = capture->time_cmd - capture->time_start,
+        /* Safe cast since the duration is capped to the largest value. */
+        .duration = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration,
+    };
+    capture_rcrd(capture, &rcrd_hdr, capdu,
+                 res->data_ref != NULL ? res->data_ref : res->data.b,
+                 res->data.len, sw);
+}
+
+void swicc_capture_reset(swicc_capture_st *const capture)
+{
+    swicc_capture_rcrd_hdr_raw_st const rcrd_hdr = {
+        .type = SWICC_CAPTURE_RCRD_TYPE_RESET,
+        .time = swicc_stats_time() - capture->time_start,
+    };
+    capture_rcrd(capture, &rcrd_hdr, NULL, NULL, 0U, NULL);
+}
+
+/**
+ * @brief Run one captured command on a card the same way the handlers got it
+ * when it was captured.
+ * @param swicc_state
+ * @param capdu
+ * @param capdu_len
+ * @param rapdu Receives the response of the card.
+ * @param rapdu_len Must contain the size of the response buffer, receives the
+ * length of the response.
+ * @return Return code. Pending if a handler did not complete in time.
+ */
+static swicc_ret_et capture_replay_cmd(swicc_st *const swicc_state,
+                                       uint8_t const *const capdu,
+                                       uint16_t const capdu_len,
+                                       uint8_t *const rapdu,
+                                       uint16_t *const rapdu_len)
+{
+    swicc_ret_et ret = swicc_apduh_exec_cmd_set(swicc_state, capdu, capdu_len);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        return ret;
+    }
+    /**
+     * A GET RESPONSE that followed was captured as a command of its own so it
+     * must not be sent while running this one.
+     */
+    swicc_state->internal.apduh_exec.le = false;
+    struct timespec const wait = {.tv_sec = 0, .tv_nsec = 1000000};
+    ret = swicc_apduh_exec_resume(swicc_state, rapdu, rapdu_len);
+    for (uint32_t wait_count = 0U;
+         ret == SWICC_RET_APDU_PENDING && wait_count < CAPTURE_PENDING_WAIT_MAX;
+         ++wait_count)
+    {
+        nanosleep(&wait, NULL);
+        ret = swicc_apduh_exec_resume(swicc_state, rapdu, rapdu_len);
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_capture_replay(swicc_st *const swicc_state,
+                                  char const *const capture_path,
+                                  swicc_capture_replay_st *const replay)
+{
+    if (swicc_state == NULL || capture_path == NULL || replay == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    memset(replay, 0U, sizeof(*replay));
+    FILE *const f = fopen(capture_path, "rb");
+    if (f == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    swicc_capture_hdr_raw_st hdr;
+    uint64_t disk_id;
+    if (fread(&hdr, sizeof(hdr), 1U, f) != 1U ||
+        memcmp(hdr.magic, SWICC_CAPTURE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != SWICC_CAPTURE_VERSION ||
+        swicc_capture_disk_id(&swicc_state->fs.disk, &disk_id) !=
+            SWICC_RET_SUCCESS ||
+        disk_id != hdr.disk_id)
+    {
+        fclose(f);
+        return SWICC_RET_ERROR;
+    }
+
+    uint8_t capdu[SWICC_CAPTURE_CAPDU_LEN_MAX];
+    uint8_t rapdu[SWICC_CAPTURE_RAPDU_LEN_MAX];
+    swicc_capture_rcrd_hdr_raw_st rcrd_hdr;
+    for (uint64_t rcrd_idx = 0U;; ++rcrd_idx)
+    {
+        if (fread(&rcrd_hdr, sizeof(rcrd_hdr), 1U, f) != 1U)
+        {
+            /* Reaching the end of the file is how a replay ends. */
+            ret = feof(f) ? SWICC_RET_SUCCESS : SWICC_RET_ERROR;
+            break;
+        }
+        if (rcrd_hdr.type == SWICC_CAPTURE_RCRD_TYPE_RESET)
+        {
+            ret = swicc_reset(swicc_state);
+            if (ret != SWICC_RET_SUCCESS)
+            {
+                break;
+            }
+            replay->reset_count += 1U;
+            continue;
+        }
+        if (rcrd_hdr.type != SWICC_CAPTURE_RCRD_TYPE_APDU ||
+            rcrd_hdr.capdu_len < sizeof(swicc_apdu_cmd_hdr_raw_st) + 1U ||
+            rcrd_hdr.capdu_len > sizeof(capdu) || rcrd_hdr.rapdu_len < 2U ||
+            rcrd_hdr.rapdu_len > sizeof(rapdu) ||
+            fread(capdu, rcrd_hdr.capdu_len, 1U, f) != 1U ||
+            fread(rapdu, rcrd_hdr.rapdu_len, 1U, f) != 1U)
+        {
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+
+        uint8_t rapdu_replay[SWICC_CAPTURE_RAPDU_LEN_MAX];
+        uint16_t rapdu_replay_len = sizeof(rapdu_replay);
+        uint64_t const time_start = swicc_stats_time();
+        ret = capture_replay_cmd(swicc_state, capdu, rcrd_hdr.capdu_len,
+                                 rapdu_replay, &rapdu_replay_len);
+        replay->time_replay += swicc_stats_time() - time_start;
+        replay->time_capture += rcrd_hdr.duration;
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            break;
+        }
+        replay->cmd_count += 1U;
+
+        if (rapdu_replay_len != rcrd_hdr.rapdu_len ||
+            memcmp(rapdu_replay, rapdu, rapdu_replay_len) != 0)
+        {
+            if (replay->mismatch_count == 0U)
+            {
+                replay->mismatch_first = rcrd_idx;
+            }
+            replay->mismatch_count += 1U;
+        }
+    }
+    fclose(f);
+    return ret;
+}
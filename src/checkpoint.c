@@ -0,0 +1,224 @@
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/**
+ * @brief Write all dirty pages of a tree back from a checkpoint, merging
+ * consecutive pages into one write.
+ * @param[in] cp_tree
+ * @return Return code.
+ */
+static swicc_ret_et
+checkpoint_tree_restore(swicc_checkpoint_tree_st const *const cp_tree)
+{
+    swicc_disk_tree_st *const tree = cp_tree->tree;
+    uint32_t const page_count = tree->dirty_word_count * 64U;
+    uint32_t page = 0U;
+    while (page < page_count)
+    {
+        if (page % 64U == 0U && tree->dirty[page / 64U] == 0U)
+        {
+            page += 64U;
+            continue;
+        }
+        if ((tree->dirty[page / 64U] & (1ULL << (page % 64U))) == 0U)
+        {
+            page += 1U;
+            continue;
+        }
+        uint32_t const page_start = page;
+        while (page < page_count &&
+               (tree->dirty[page / 64U] & (1ULL << (page % 64U))) != 0U)
+        {
+            page += 1U;
+        }
+
+        /* Dirty pages are inside the tree but the last one may be partial. */
+        uint32_t const start = page_start * SWICC_DISK_DIRTY_PAGE_SIZE;
+        uint64_t const end_page = (uint64_t)page * SWICC_DISK_DIRTY_PAGE_SIZE;
+        /* Safe cast since the end is limited to the tree length. */
+        uint32_t const end =
+            end_page > tree->len ? tree->len : (uint32_t)end_page;
+        if (start >= end ||
+            swicc_disk_tree_write(tree, start, end - start,
+                                  &cp_tree->buf[start]) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_checkpoint_capture(swicc_checkpoint_st *const checkpoint,
+                                      swicc_st const *const swicc_state)
+{
+    if (checkpoint == NULL || swicc_state == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    memset(checkpoint, 0U, sizeof(*checkpoint));
+
+    checkpoint->state = malloc(sizeof(*checkpoint->state));
+    if (checkpoint->state == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(checkpoint->state, swicc_state, sizeof(*checkpoint->state));
+
+    /* The copy gets its own RC buffer holding only what is occupied. */
+    swicc_apdu_rc_st *const rc = &checkpoint->state->apdu_rc;
+    rc->b = NULL;
+    rc->size = 0U;
+    rc->b_pooled = false;
+    if (swicc_state->apdu_rc.b_len > 0U)
+    {
+        rc->b = malloc(swicc_state->apdu_rc.b_len);
+        if (rc->b == NULL)
+        {
+            swicc_checkpoint_free(checkpoint);
+            return SWICC_RET_ERROR;
+        }
+        memcpy(rc->b, swicc_state->apdu_rc.b, swicc_state->apdu_rc.b_len);
+        rc->size = swicc_state->apdu_rc.b_len;
+    }
+
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st const *tree = swicc_state->fs.disk.root;
+         tree != NULL; tree = tree->next)
+    {
+        tree_count += 1U;
+    }
+    if (tree_count > 0U)
+    {
+        checkpoint->tree = calloc(tree_count, sizeof(*checkpoint->tree));
+        if (checkpoint->tree == NULL)
+        {
+            swicc_checkpoint_free(checkpoint);
+            return SWICC_RET_ERROR;
+        }
+    }
+    for (swicc_disk_tree_st *tree = swicc_state->fs.disk.root; tree != NULL;
+         tree = tree->next)
+    {
+        swicc_checkpoint_tree_st *const cp_tree =
+            &checkpoint->tree[checkpoint->tree_count];
+        /* Allocate at least 1 byte so an empty tree still gets a buffer. */
+        cp_tree->buf = malloc(tree->len > 0U ? tree->len : 1U);
+        if (cp_tree->buf == NULL)
+        {
+            swicc_checkpoint_free(checkpoint);
+            return SWICC_RET_ERROR;
+        }
+        cp_tree->tree = tree;
+        cp_tree->len = tree->len;
+        checkpoint->tree_count += 1U;
+        if (swicc_disk_tree_read(tree, 0U, tree->len, cp_tree->buf) !=
+            SWICC_RET_SUCCESS)
+        {
+            swicc_checkpoint_free(checkpoint);
+            return SWICC_RET_ERROR;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_checkpoint_restore(
+    swicc_checkpoint_st const *const checkpoint, swicc_st *const swicc_state)
+{
+    if (checkpoint == NULL || checkpoint->state == NULL || swicc_state == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_st const *const state = checkpoint->state;
+
+    /* The disk must be made of the same trees as when it was captured. */
+    uint32_t tree_idx = 0U;
+    for (swicc_disk_tree_st const *tree = swicc_state->fs.disk.root;
+         tree != NULL; tree = tree->next, ++tree_idx)
+    {
+        if (tree_idx >= checkpoint->tree_count ||
+            checkpoint->tree[tree_idx].tree != tree ||
+            checkpoint->tree[tree_idx].len != tree->len)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    if (tree_idx != checkpoint->tree_count)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    swicc_apdu_rc_st *const rc = &swicc_state->apdu_rc;
+    if (state->apdu_rc.b_len > rc->size)
+    {
+        uint8_t *const b_new = realloc(rc->b, state->apdu_rc.b_len);
+        if (b_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        rc->b = b_new;
+        rc->size = state->apdu_rc.b_len;
+        rc->b_pooled = false;
+    }
+
+    for (tree_idx = 0U; tree_idx < checkpoint->tree_count; ++tree_idx)
+    {
+        if (checkpoint_tree_restore(&checkpoint->tree[tree_idx]) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    uint8_t *const rc_b = rc->b;
+    uint32_t const rc_size = rc->size;
+    bool const rc_b_pooled = rc->b_pooled;
+    *rc = state->apdu_rc;
+    rc->b = rc_b;
+    rc->size = rc_size;
+    rc->b_pooled = rc_b_pooled;
+    if (state->apdu_rc.b_len > 0U)
+    {
+        memcpy(rc->b, state->apdu_rc.b, state->apdu_rc.b_len);
+    }
+
+    swicc_state->fs.va = state->fs.va;
+    memcpy(swicc_state->fs.va_lchan, state->fs.va_lchan,
+           sizeof(swicc_state->fs.va_lchan));
+    swicc_state->fs.lchan_open = state->fs.lchan_open;
+    swicc_state->fs.lchan_cur = state->fs.lchan_cur;
+
+    swicc_apduh_ft *const apduh_pro = swicc_state->internal.apduh_pro;
+    swicc_apduh_ft *const apduh_override = swicc_state->internal.apduh_override;
+    memcpy(&swicc_state->internal, &state->internal,
+           sizeof(swicc_state->internal));
+    swicc_state->internal.apduh_pro = apduh_pro;
+    swicc_state->internal.apduh_override = apduh_override;
+
+    swicc_state->shutdown = state->shutdown;
+    swicc_state->cont_state_rx = state->cont_state_rx;
+    swicc_state->cont_state_tx = state->cont_state_tx;
+    swicc_state->buf_rx_len = state->buf_rx_len;
+    swicc_state->buf_tx_len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_checkpoint_free(swicc_checkpoint_st *const checkpoint)
+{
+    if (checkpoint == NULL)
+    {
+        return;
+    }
+    if (checkpoint->state != NULL)
+    {
+        free(checkpoint->state->apdu_rc.b);
+        free(checkpoint->state);
+    }
+    for (uint32_t tree_idx = 0U; tree_idx < checkpoint->tree_count;
+         ++tree_idx)
+    {
+        free(checkpoint->tree[tree_idx].buf);
+    }
+    free(checkpoint->tree);
+    memset(checkpoint, 0U, sizeof(*checkpoint));
+}
@@ -3,6 +3,12 @@
 #include <string.h>
 #include <swicc/swicc.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 void swicc_etu(uint32_t *const etu, uint16_t const fi, uint8_t const di,
                uint32_t const fmax)
 {
@@ -21,6 +27,68 @@ uint8_t swicc_ck(uint8_t const *const buf_raw, uint16_t const buf_raw_len)
     return tck;
 }
 
+/**
+ * @brief Decode one uppercase hex nibble.
+ * @param nibble_char
+ * @param[out] nibble
+ * @return Return code.
+ */
+static swicc_ret_et hexstr_nibble(uint8_t const nibble_char,
+                                  uint8_t *const nibble)
+{
+    if (nibble_char >= '0' && nibble_char <= '9')
+    {
+        /* Safe cast due to range check. */
+        *nibble = (uint8_t)(nibble_char - '0');
+    }
+    else if (nibble_char >= 'A' && nibble_char <= 'F')
+    {
+        /* Safe cast due to range check. */
+        *nibble = (uint8_t)(0x0A + (nibble_char - 'A'));
+    }
+    else
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief Decode 16 hex nibbles to 8 bytes in every 16-bit lane (low half of
+ * each lane).
+ * @param hexstr
+ * @param[out] valid Receives a mask with a 1 bit for every valid nibble.
+ * @return The 8 bytes, one in each 16-bit lane.
+ */
+static __m128i hexstr_decode16(char const *const hexstr, int *const valid)
+{
+    __m128i const chars = _mm_loadu_si128((__m128i const *)hexstr);
+    /**
+     * Signed compares are fine since all valid characters are below 0x80 and
+     * the rest are then negative and below '0'.
+     */
+    __m128i const digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    __m128i const upper = _mm_and_si128(
+        _mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)),
+        _mm_cmplt_epi8(chars, _mm_set1_epi8('F' + 1)));
+    *valid = _mm_movemask_epi8(_mm_or_si128(digit, upper));
+
+    /* 'A' maps to 0x0A so upper case characters get 'A' - 0x0A subtracted. */
+    __m128i const nibble = _mm_sub_epi8(
+        chars,
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8('0')),
+                     _mm_and_si128(upper, _mm_set1_epi8('A' - 0x0A))));
+    /* The first nibble of a byte is in the low half of each lane. */
+    __m128i const nibble_hi =
+        _mm_slli_epi16(_mm_and_si128(nibble, _mm_set1_epi16(0x00FF)), 4);
+    __m128i const nibble_lo = _mm_srli_epi16(nibble, 8);
+    return _mm_or_si128(nibble_hi, nibble_lo);
+}
+#endif
+
 swicc_ret_et swicc_hexstr_bytearr(char const *const hexstr,
                                   uint32_t const hexstr_len,
                                   uint8_t *const bytearr,
@@ -31,36 +99,73 @@ swicc_ret_et swicc_hexstr_bytearr(char const *const hexstr,
         /* Hex string must be even. */
         return SWICC_RET_PARAM_BAD;
     }
-    for (uint32_t hexstr_idx = 0U; hexstr_idx < hexstr_len; hexstr_idx += 2U)
+    if (hexstr_len / 2U > *bytearr_len)
     {
-        if ((hexstr_idx / 2U) > *bytearr_len)
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+
+    /**
+     * There are twice as many nibbles as bytes so we divide hex string index by
+     * 2 to get byte array index.
+     */
+    uint32_t hexstr_idx = 0U;
+#if defined(__SSE2__)
+    /* Decode 32 nibbles into 16 bytes per step. */
+    for (; hexstr_len - hexstr_idx >= 32U; hexstr_idx += 32U)
+    {
+        int valid[2U];
+        __m128i const bytes0 = hexstr_decode16(&hexstr[hexstr_idx], &valid[0U]);
+        __m128i const bytes1 =
+            hexstr_decode16(&hexstr[hexstr_idx + 16U], &valid[1U]);
+        if ((valid[0U] & valid[1U]) != 0xFFFF)
         {
-            return SWICC_RET_BUFFER_TOO_SHORT;
+            return SWICC_RET_PARAM_BAD;
         }
-        uint8_t nibble[2U] = {(uint8_t)hexstr[hexstr_idx + 0U],
-                              (uint8_t)hexstr[hexstr_idx + 1U]};
+        /* No saturation happens since every lane holds a single byte. */
+        _mm_storeu_si128((__m128i *)&bytearr[hexstr_idx / 2U],
+                         _mm_packus_epi16(bytes0, bytes1));
+    }
+#elif defined(__aarch64__)
+    /* Decode 32 nibbles into 16 bytes per step. */
+    for (; hexstr_len - hexstr_idx >= 32U; hexstr_idx += 32U)
+    {
+        uint8x16x2_t const chars =
+            vld2q_u8((uint8_t const *)&hexstr[hexstr_idx]);
+        uint8x16_t nibble[2U];
+        uint8x16_t valid = vdupq_n_u8(0xFF);
         for (uint8_t nibble_idx = 0U; nibble_idx < 2U; ++nibble_idx)
         {
-            if (nibble[nibble_idx] >= '0' && nibble[nibble_idx] <= '9')
-            {
-                /* Safe cast due to range check. */
-                nibble[nibble_idx] = (uint8_t)(nibble[nibble_idx] - '0');
-            }
-            else if (nibble[nibble_idx] >= 'A' && nibble[nibble_idx] <= 'F')
-            {
-                /* Safe cast due to range check. */
-                nibble[nibble_idx] =
-                    (uint8_t)(0x0A + (nibble[nibble_idx] - 'A'));
-            }
-            else
-            {
-                return SWICC_RET_PARAM_BAD;
-            }
+            /* Out of range characters wrap around to large values. */
+            uint8x16_t const digit =
+                vsubq_u8(chars.val[nibble_idx], vdupq_n_u8('0'));
+            uint8x16_t const upper =
+                vsubq_u8(chars.val[nibble_idx], vdupq_n_u8('A' - 0x0A));
+            uint8x16_t const digit_valid = vcleq_u8(digit, vdupq_n_u8(0x09));
+            uint8x16_t const upper_valid =
+                vandq_u8(vcgeq_u8(upper, vdupq_n_u8(0x0A)),
+                         vcleq_u8(upper, vdupq_n_u8(0x0F)));
+            nibble[nibble_idx] = vbslq_u8(digit_valid, digit, upper);
+            valid =
+                vandq_u8(valid, vorrq_u8(digit_valid, upper_valid));
+        }
+        if (vminvq_u8(valid) != 0xFF)
+        {
+            return SWICC_RET_PARAM_BAD;
+        }
+        vst1q_u8(&bytearr[hexstr_idx / 2U],
+                 vorrq_u8(vshlq_n_u8(nibble[0U], 4), nibble[1U]));
+    }
+#endif
+    for (; hexstr_idx < hexstr_len; hexstr_idx += 2U)
+    {
+        uint8_t nibble[2U];
+        if (hexstr_nibble((uint8_t)hexstr[hexstr_idx + 0U], &nibble[0U]) !=
+                SWICC_RET_SUCCESS ||
+            hexstr_nibble((uint8_t)hexstr[hexstr_idx + 1U], &nibble[1U]) !=
+                SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_PARAM_BAD;
         }
-        /**
-         * There are twice as many nibbles as bytes so we divide hex string
-         * index by 2 to get byte array index.
-         */
         bytearr[hexstr_idx / 2U] =
             (uint8_t)((nibble[0U] << 4) | nibble[1U]); /* Safe case due to range
                                                           check on nibble. */
@@ -69,6 +174,89 @@ swicc_ret_et swicc_hexstr_bytearr(char const *const hexstr,
     return SWICC_RET_SUCCESS;
 }
 
+swicc_ret_et swicc_mem_find(uint8_t const *const buf, uint32_t const buf_len,
+                            uint8_t const *const pat, uint32_t const pat_len,
+                            uint32_t *const offset)
+{
+    if (pat_len == 0U)
+    {
+        *offset = 0U;
+        return SWICC_RET_SUCCESS;
+    }
+    if (pat_len > buf_len)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+
+    /* Number of offsets where the string could start. */
+    uint32_t const pos_count = buf_len - pat_len + 1U;
+    uint32_t pos = 0U;
+#if defined(__SSE2__)
+    /**
+     * Check 16 start offsets per step by comparing the first and last byte of
+     * the string, only the candidates that match both get compared in full.
+     */
+    __m128i const pat_first = _mm_set1_epi8((char)pat[0U]);
+    __m128i const pat_last = _mm_set1_epi8((char)pat[pat_len - 1U]);
+    for (; pos_count - pos >= 16U; pos += 16U)
+    {
+        __m128i const block_first = _mm_loadu_si128((__m128i const *)&buf[pos]);
+        __m128i const block_last =
+            _mm_loadu_si128((__m128i const *)&buf[pos + pat_len - 1U]);
+        /* Safe cast since the mask only has the low 16 bits set. */
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, pat_first),
+                          _mm_cmpeq_epi8(block_last, pat_last)));
+        while (mask != 0U)
+        {
+            /* Safe cast since the mask is not 0. */
+            uint32_t const pos_cand = pos + (uint32_t)__builtin_ctz(mask);
+            if (memcmp(&buf[pos_cand], pat, pat_len) == 0)
+            {
+                *offset = pos_cand;
+                return SWICC_RET_SUCCESS;
+            }
+            mask &= mask - 1U;
+        }
+    }
+#elif defined(__aarch64__)
+    /* Same as the SSE2 variant but NEON has no byte mask extraction. */
+    uint8x16_t const pat_first = vdupq_n_u8(pat[0U]);
+    uint8x16_t const pat_last = vdupq_n_u8(pat[pat_len - 1U]);
+    for (; pos_count - pos >= 16U; pos += 16U)
+    {
+        uint8x16_t const cand =
+            vandq_u8(vceqq_u8(vld1q_u8(&buf[pos]), pat_first),
+                     vceqq_u8(vld1q_u8(&buf[pos + pat_len - 1U]), pat_last));
+        /* Narrow every byte of the compare result to a nibble of the mask. */
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(cand), 4)),
+            0);
+        while (mask != 0U)
+        {
+            /* Safe cast since the mask is not 0. */
+            uint32_t const nibble_idx = (uint32_t)__builtin_ctzll(mask) / 4U;
+            uint32_t const pos_cand = pos + nibble_idx;
+            if (memcmp(&buf[pos_cand], pat, pat_len) == 0)
+            {
+                *offset = pos_cand;
+                return SWICC_RET_SUCCESS;
+            }
+            mask &= ~(0xFULL << (nibble_idx * 4U));
+        }
+    }
+#endif
+    for (; pos < pos_count; ++pos)
+    {
+        if (buf[pos] == pat[0U] && memcmp(&buf[pos], pat, pat_len) == 0)
+        {
+            *offset = pos;
+            return SWICC_RET_SUCCESS;
+        }
+    }
+    return SWICC_RET_FS_NOT_FOUND;
+}
+
 swicc_ret_et swicc_reset(swicc_st *const swicc_state)
 {
     swicc_ret_et ret = SWICC_RET_ERROR;
@@ -81,13 +269,22 @@ swicc_ret_et swicc_reset(swicc_st *const swicc_state)
     swicc_apduh_ft *const apduh_pro = swicc_state->internal.apduh_pro;
     swicc_apduh_ft *const apduh_override = swicc_state->internal.apduh_override;
     memset(&swicc_state->internal, 0U, sizeof(swicc_state->internal));
-    memset(&swicc_state->apdu_rc, 0U, sizeof(swicc_state->apdu_rc));
+    /* The RC buffer stays allocated for later responses. */
+    swicc_apdu_rc_reset(&swicc_state->apdu_rc);
     memset(swicc_state->buf_tx, 0U, sizeof(*swicc_state->buf_tx));
     swicc_state->buf_tx_len = 0U;
     swicc_state->cont_state_tx = 0U;
     swicc_state->internal.apduh_pro = apduh_pro;
     swicc_state->internal.apduh_override = apduh_override;
     swicc_state->shutdown = false;
+    if (swicc_state->stats != NULL)
+    {
+        swicc_stats_add(&swicc_state->stats->reset, 1U);
+    }
+    if (swicc_state->capture != NULL)
+    {
+        swicc_capture_reset(swicc_state->capture);
+    }
 
     return SWICC_RET_SUCCESS;
 }
@@ -95,6 +292,7 @@ swicc_ret_et swicc_reset(swicc_st *const swicc_state)
 void swicc_terminate(swicc_st *const swicc_state)
 {
     swicc_disk_unload(&swicc_state->fs.disk);
+    swicc_apdu_rc_free(&swicc_state->apdu_rc);
 }
 
 void swicc_fsm_state(swicc_st *const swicc_state,
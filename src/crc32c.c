@@ -0,0 +1,269 @@
+#include <pthread.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+/* Castagnoli polynomial (reflected). */
+#define CRC32C_POLY 0x82F63B78U
+
+/**
+ * Buffers at least 3 times this long are checksummed as 3 interleaved lanes
+ * so the latency of the CRC instruction is hidden, the lanes are then combined.
+ */
+#define CRC32C_LANE_LEN_MIN 256U
+
+/**
+ * Checksum the register (i.e. without the inversions at the start and end)
+ * of some bytes.
+ */
+typedef uint32_t crc32c_ft(uint32_t reg, uint8_t const *buf, uint32_t len);
+
+/* Tables for processing 8 bytes at a time without the CRC instructions. */
+static uint32_t crc32c_table[8U][UINT8_MAX + 1U];
+
+/* Entry k is x^(2^k) modulo the polynomial. */
+static uint32_t crc32c_x2n[32U];
+
+static crc32c_ft *crc32c_impl;
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Multiply 2 polynomials modulo the CRC polynomial (bit-reflected).
+ * @param a
+ * @param b
+ * @return Product.
+ */
+static uint32_t crc32c_mult(uint32_t const a, uint32_t b)
+{
+    uint32_t prod = 0U;
+    for (uint32_t m = 1U << 31U; m != 0U; m >>= 1U)
+    {
+        if ((a & m) != 0U)
+        {
+            prod ^= b;
+            if ((a & (m - 1U)) == 0U)
+            {
+                break;
+            }
+        }
+        b = (b & 1U) != 0U ? (b >> 1U) ^ CRC32C_POLY : b >> 1U;
+    }
+    return prod;
+}
+
+/**
+ * @brief Register of the table-driven implementation.
+ * @param reg
+ * @param buf
+ * @param len
+ * @return Register after processing the bytes.
+ */
+static crc32c_ft crc32c_sw;
+static uint32_t crc32c_sw(uint32_t reg, uint8_t const *buf, uint32_t len)
+{
+    while (len >= 8U)
+    {
+        /* Assembled byte by byte so it does not depend on endianness. */
+        uint32_t const lo = reg ^ ((uint32_t)buf[0U] |
+                                   ((uint32_t)buf[1U] << 8U) |
+                                   ((uint32_t)buf[2U] << 16U) |
+                                   ((uint32_t)buf[3U] << 24U));
+        reg = crc32c_table[7U][lo & 0xFFU] ^
+              crc32c_table[6U][(lo >> 8U) & 0xFFU] ^
+              crc32c_table[5U][(lo >> 16U) & 0xFFU] ^
+              crc32c_table[4U][lo >> 24U] ^ crc32c_table[3U][buf[4U]] ^
+              crc32c_table[2U][buf[5U]] ^ crc32c_table[1U][buf[6U]] ^
+              crc32c_table[0U][buf[7U]];
+        buf += 8U;
+        len -= 8U;
+    }
+    for (; len > 0U; --len)
+    {
+        reg = crc32c_table[0U][(reg ^ *buf++) & 0xFFU] ^ (reg >> 8U);
+    }
+    return reg;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief Register of the SSE4.2 implementation.
+ * @param reg
+ * @param buf
+ * @param len
+ * @return Register after processing the bytes.
+ */
+static crc32c_ft crc32c_sse42;
+__attribute__((target("sse4.2"))) static uint32_t
+crc32c_sse42(uint32_t reg, uint8_t const *buf, uint32_t len)
+{
+    if (len >= 3U * CRC32C_LANE_LEN_MIN)
+    {
+        uint32_t const lane_len = (len / 3U) & ~7U;
+        uint64_t reg_a = reg;
+        uint64_t reg_b = 0U;
+        uint64_t reg_c = 0U;
+        for (uint32_t pos = 0U; pos < lane_len; pos += 8U)
+        {
+            uint64_t word_a;
+            uint64_t word_b;
+            uint64_t word_c;
+            memcpy(&word_a, &buf[pos], sizeof(word_a));
+            memcpy(&word_b, &buf[lane_len + pos], sizeof(word_b));
+            memcpy(&word_c, &buf[(2U * lane_len) + pos], sizeof(word_c));
+            reg_a = _mm_crc32_u64(reg_a, word_a);
+            reg_b = _mm_crc32_u64(reg_b, word_b);
+            reg_c = _mm_crc32_u64(reg_c, word_c);
+        }
+        uint32_t const op = swicc_crc32c_combine_gen(lane_len);
+        /* Safe casts since the CRC instruction gives 32-bit registers. */
+        reg = swicc_crc32c_combine_op((uint32_t)reg_a, (uint32_t)reg_b, op);
+        reg = swicc_crc32c_combine_op(reg, (uint32_t)reg_c, op);
+        buf += 3U * lane_len;
+        len -= 3U * lane_len;
+    }
+    uint64_t reg64 = reg;
+    for (; len >= 8U; buf += 8U, len -= 8U)
+    {
+        uint64_t word;
+        memcpy(&word, buf, sizeof(word));
+        reg64 = _mm_crc32_u64(reg64, word);
+    }
+    /* Safe cast since the CRC instruction gives 32-bit registers. */
+    reg = (uint32_t)reg64;
+    for (; len > 0U; --len)
+    {
+        reg = _mm_crc32_u8(reg, *buf++);
+    }
+    return reg;
+}
+#elif defined(__aarch64__)
+/**
+ * @brief Register of the ARMv8 CRC implementation.
+ * @param reg
+ * @param buf
+ * @param len
+ * @return Register after processing the bytes.
+ */
+static crc32c_ft crc32c_armv8;
+__attribute__((target("+crc"))) static uint32_t
+crc32c_armv8(uint32_t reg, uint8_t const *buf, uint32_t len)
+{
+    if (len >= 3U * CRC32C_LANE_LEN_MIN)
+    {
+        uint32_t const lane_len = (len / 3U) & ~7U;
+        uint32_t reg_a = reg;
+        uint32_t reg_b = 0U;
+        uint32_t reg_c = 0U;
+        for (uint32_t pos = 0U; pos < lane_len; pos += 8U)
+        {
+            uint64_t word_a;
+            uint64_t word_b;
+            uint64_t word_c;
+            memcpy(&word_a, &buf[pos], sizeof(word_a));
+            memcpy(&word_b, &buf[lane_len + pos], sizeof(word_b));
+            memcpy(&word_c, &buf[(2U * lane_len) + pos], sizeof(word_c));
+            reg_a = __crc32cd(reg_a, word_a);
+            reg_b = __crc32cd(reg_b, word_b);
+            reg_c = __crc32cd(reg_c, word_c);
+        }
+        uint32_t const op = swicc_crc32c_combine_gen(lane_len);
+        reg = swicc_crc32c_combine_op(reg_a, reg_b, op);
+        reg = swicc_crc32c_combine_op(reg, reg_c, op);
+        buf += 3U * lane_len;
+        len -= 3U * lane_len;
+    }
+    for (; len >= 8U; buf += 8U, len -= 8U)
+    {
+        uint64_t word;
+        memcpy(&word, buf, sizeof(word));
+        reg = __crc32cd(reg, word);
+    }
+    for (; len > 0U; --len)
+    {
+        reg = __crc32cb(reg, *buf++);
+    }
+    return reg;
+}
+#endif
+
+/**
+ * @brief Create the tables and pick the fastest implementation the CPU
+ * supports.
+ */
+static void crc32c_init(void)
+{
+    for (uint32_t byte = 0U; byte <= UINT8_MAX; ++byte)
+    {
+        uint32_t reg = byte;
+        for (uint32_t bit = 0U; bit < 8U; ++bit)
+        {
+            reg = (reg & 1U) != 0U ? (reg >> 1U) ^ CRC32C_POLY : reg >> 1U;
+        }
+        crc32c_table[0U][byte] = reg;
+    }
+    for (uint32_t byte = 0U; byte <= UINT8_MAX; ++byte)
+    {
+        uint32_t reg = crc32c_table[0U][byte];
+        for (uint32_t table_idx = 1U; table_idx < 8U; ++table_idx)
+        {
+            reg = crc32c_table[0U][reg & 0xFFU] ^ (reg >> 8U);
+            crc32c_table[table_idx][byte] = reg;
+        }
+    }
+
+    /* Bit 30 is x^1 since the polynomials are bit-reflected. */
+    crc32c_x2n[0U] = 1U << 30U;
+    for (uint32_t k = 1U; k < 32U; ++k)
+    {
+        crc32c_x2n[k] = crc32c_mult(crc32c_x2n[k - 1U], crc32c_x2n[k - 1U]);
+    }
+
+    crc32c_impl = crc32c_sw;
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        crc32c_impl = crc32c_sse42;
+    }
+#elif defined(__aarch64__)
+    if ((getauxval(AT_HWCAP) & HWCAP_CRC32) != 0U)
+    {
+        crc32c_impl = crc32c_armv8;
+    }
+#endif
+}
+
+uint32_t swicc_crc32c(uint32_t const crc, uint8_t const *const buf,
+                      uint32_t const len)
+{
+    pthread_once(&crc32c_once, crc32c_init);
+    return ~crc32c_impl(~crc, buf, len);
+}
+
+uint32_t swicc_crc32c_combine_gen(uint32_t const len_b)
+{
+    pthread_once(&crc32c_once, crc32c_init);
+    /* x^(8 * len) since every byte shifts the checksum by 8 bits. */
+    uint32_t op = 1U << 31U;
+    uint32_t k = 3U;
+    for (uint32_t n = len_b; n != 0U; n >>= 1U, k = (k + 1U) % 32U)
+    {
+        if ((n & 1U) != 0U)
+        {
+            op = crc32c_mult(crc32c_x2n[k], op);
+        }
+    }
+    return op;
+}
+
+uint32_t swicc_crc32c_combine_op(uint32_t const crc_a, uint32_t const crc_b,
+                                 uint32_t const op)
+{
+    return crc32c_mult(op, crc_a) ^ crc_b;
+}
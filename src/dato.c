@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include <string.h>
 #include <swicc/swicc.h>
 
@@ -111,6 +112,10 @@ static swicc_ret_et bertlv_hdr_prs(swicc_dato_bertlv_st *const bertlv_prsd,
     *bertlv_hdr_len += tag_len;
 
     /* Length. */
+    if (*bertlv_hdr_len >= buf_len)
+    {
+        return SWICC_RET_DATO_END;
+    }
     uint8_t const len_b0 = buf[(*bertlv_hdr_len)++];
     bertlv_prsd->len.val = len_b0 & 0b01111111;
 
@@ -140,20 +145,22 @@ static swicc_ret_et bertlv_hdr_prs(swicc_dato_bertlv_st *const bertlv_prsd,
              */
             uint8_t len_len = len_b0 & 0b01111111;
 
-            if (len_len > SWICC_DATO_BERTLV_LEN_LEN_MAX)
+            /* The first byte of the length is not part of the value. */
+            if (len_len > SWICC_DATO_BERTLV_LEN_LEN_MAX - 1U)
             {
                 return SWICC_RET_ERROR;
             }
 
-            for (uint8_t len_idx = 1U; len_idx < len_len; ++len_idx)
+            /* The length bytes after b0 hold the value in big endian. */
+            bertlv_prsd->len.val = 0U;
+            for (uint8_t len_idx = 0U; len_idx < len_len; ++len_idx)
             {
-                if (buf_len < *bertlv_hdr_len)
+                if (buf_len <= *bertlv_hdr_len)
                 {
                     return SWICC_RET_DATO_END;
                 }
-                /* Safe cast since we iterate for at most 2 times. */
-                bertlv_prsd->len.val |= (uint32_t)(buf[(*bertlv_hdr_len)++]
-                                                   << ((len_idx - 1U) * 7U));
+                bertlv_prsd->len.val = (bertlv_prsd->len.val << 8U) |
+                                       buf[(*bertlv_hdr_len)++];
             }
             break;
         }
@@ -383,6 +390,18 @@ swicc_ret_et swicc_dato_bertlv_tag_create(
     return bertlv_hdr_tag_prs(bertlv_tag_out, &tag_len, tag_buf, sizeof(tag));
 }
 
+swicc_ret_et swicc_dato_bertlv_tag_prs(
+    swicc_dato_bertlv_tag_st *const bertlv_tag_out, uint32_t *const tag_len,
+    uint8_t const *const tag_buf, uint32_t const tag_buf_len)
+{
+    if (bertlv_tag_out == NULL || tag_len == NULL || tag_buf == NULL ||
+        tag_buf_len == 0U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    return bertlv_hdr_tag_prs(bertlv_tag_out, tag_len, tag_buf, tag_buf_len);
+}
+
 void swicc_dato_bertlv_dec_init(swicc_dato_bertlv_dec_st *const decoder,
                                 uint8_t *const bertlv_buf,
                                 uint32_t const bertlv_len)
@@ -538,3 +557,272 @@ swicc_ret_et swicc_dato_bertlv_enc_data(swicc_dato_bertlv_enc_st *const encoder,
     }
     return SWICC_RET_SUCCESS;
 }
+
+/**
+ * @brief Hash a (parent, tag) pair for the index hash table.
+ * @param parent_idx
+ * @param tag
+ * @return The hash.
+ */
+static uint32_t bertlv_idx_hash(uint32_t const parent_idx,
+                                swicc_dato_bertlv_tag_st const *const tag)
+{
+    /* Safe cast since the class and P/C only use the lowest few bits. */
+    uint32_t hash = parent_idx * 0x9E3779B1U;
+    hash ^= tag->num * 0x85EBCA77U;
+    hash ^= (uint32_t)((tag->cla << 1U) | (tag->pc ? 1U : 0U));
+    hash ^= hash >> 15U;
+    hash *= 0x2C1B3C6DU;
+    hash ^= hash >> 12U;
+    return hash;
+}
+
+static bool bertlv_tag_eq(swicc_dato_bertlv_tag_st const *const a,
+                          swicc_dato_bertlv_tag_st const *const b)
+{
+    return a->num == b->num && a->cla == b->cla && a->pc == b->pc;
+}
+
+swicc_ret_et swicc_dato_bertlv_dec_all(uint8_t const *const bertlv_buf,
+                                       uint32_t const bertlv_len,
+                                       swicc_dato_bertlv_node_st *const node,
+                                       uint32_t const node_count_max,
+                                       uint32_t *const node_count)
+{
+    if ((bertlv_buf == NULL && bertlv_len > 0U) ||
+        (node == NULL && node_count_max > 0U) || node_count == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    static swicc_dato_bertlv_tag_cla_et const cla_lookup[4U] = {
+        SWICC_DATO_BERTLV_TAG_CLA_UNIVERSAL,
+        SWICC_DATO_BERTLV_TAG_CLA_APPLICATION,
+        SWICC_DATO_BERTLV_TAG_CLA_CONTEXT_SPECIFIC,
+        SWICC_DATO_BERTLV_TAG_CLA_PRIVATE,
+    };
+
+    /**
+     * Only the end offset and node of every open constructed DO are kept,
+     * index 0 is the whole buffer.
+     */
+    uint32_t stack_end[SWICC_DATO_BERTLV_DEPTH_MAX + 1U];
+    uint32_t stack_node[SWICC_DATO_BERTLV_DEPTH_MAX + 1U];
+    uint32_t depth = 0U;
+    stack_end[0U] = bertlv_len;
+    stack_node[0U] = SWICC_DATO_BERTLV_NODE_PARENT_ROOT;
+
+    uint32_t offset = 0U;
+    *node_count = 0U;
+    while (true)
+    {
+        /* Close all constructed DOs that end here. */
+        while (offset == stack_end[depth] && depth > 0U)
+        {
+            --depth;
+        }
+        if (offset == stack_end[depth])
+        {
+            break;
+        }
+
+        uint32_t const len_rem = stack_end[depth] - offset;
+        swicc_dato_bertlv_node_st node_cur;
+        uint8_t const b0 = bertlv_buf[offset];
+        if (len_rem >= 2U && (b0 & 0b00011111) != 0b00011111 &&
+            (bertlv_buf[offset + 1U] & 0b10000000) == 0U)
+        {
+            /* 1-byte tag and short length are by far the most common. */
+            node_cur.tag.cla = cla_lookup[b0 >> 6U];
+            node_cur.tag.pc = (b0 & 0b00100000) != 0U;
+            node_cur.tag.num = b0 & 0b00011111;
+            node_cur.len_hdr = 2U;
+            node_cur.len_val = bertlv_buf[offset + 1U];
+        }
+        else
+        {
+            swicc_dato_bertlv_st bertlv;
+            if (bertlv_hdr_prs(&bertlv, &node_cur.len_hdr, &bertlv_buf[offset],
+                               len_rem) != SWICC_RET_SUCCESS)
+            {
+                return SWICC_RET_ERROR;
+            }
+            node_cur.tag = bertlv.tag;
+            node_cur.len_val = bertlv.len.val;
+        }
+        /* The value must not go past the end of the containing DO. */
+        if (node_cur.len_val > len_rem - node_cur.len_hdr)
+        {
+            return SWICC_RET_ERROR;
+        }
+        if (*node_count >= node_count_max)
+        {
+            return SWICC_RET_BUFFER_TOO_SHORT;
+        }
+        node_cur.depth = depth;
+        node_cur.parent_idx = stack_node[depth];
+        node_cur.offset = offset;
+        node[*node_count] = node_cur;
+
+        offset += node_cur.len_hdr;
+        if (node_cur.tag.pc)
+        {
+            if (depth >= SWICC_DATO_BERTLV_DEPTH_MAX)
+            {
+                return SWICC_RET_ERROR;
+            }
+            ++depth;
+            stack_end[depth] = offset + node_cur.len_val;
+            stack_node[depth] = *node_count;
+        }
+        else
+        {
+            offset += node_cur.len_val;
+        }
+        *node_count += 1U;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_dato_bertlv_idx_build(swicc_dato_bertlv_idx_st *const idx,
+                                         swicc_alloc_st const *const alloc,
+                                         uint8_t const *const bertlv_buf,
+                                         uint32_t const bertlv_len)
+{
+    if (idx == NULL || (bertlv_buf == NULL && bertlv_len > 0U))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    memset(idx, 0U, sizeof(*idx));
+    idx->alloc = alloc;
+    if (bertlv_len < 2U)
+    {
+        /* Too short to hold any DO so it's either empty or invalid. */
+        return bertlv_len == 0U ? SWICC_RET_SUCCESS : SWICC_RET_ERROR;
+    }
+
+    /* Every DO takes at least 2 bytes so this many nodes are always enough. */
+    uint32_t const node_count_max = bertlv_len / 2U;
+    idx->node = swicc_alloc_malloc(alloc, node_count_max * sizeof(*idx->node));
+    if (idx->node == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et ret = swicc_dato_bertlv_dec_all(
+        bertlv_buf, bertlv_len, idx->node, node_count_max, &idx->node_count);
+    if (ret == SWICC_RET_SUCCESS && idx->node_count < node_count_max)
+    {
+        /* Give back what was not used, keeping the old buffer on failure. */
+        swicc_dato_bertlv_node_st *const node_new = swicc_alloc_realloc(
+            alloc, idx->node, node_count_max * sizeof(*idx->node),
+            (idx->node_count > 0U ? idx->node_count : 1U) * sizeof(*idx->node));
+        if (node_new != NULL)
+        {
+            idx->node = node_new;
+        }
+    }
+
+    if (ret == SWICC_RET_SUCCESS && idx->node_count > 0U)
+    {
+        /* Keep the load factor at or below 1/2. */
+        idx->bucket_count = 2U;
+        while (idx->bucket_count < idx->node_count * 2U)
+        {
+            idx->bucket_count *= 2U;
+        }
+        idx->bucket =
+            swicc_alloc_calloc(alloc, idx->bucket_count, sizeof(*idx->bucket));
+        if (idx->bucket == NULL)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+    }
+    for (uint32_t node_idx = 0U;
+         ret == SWICC_RET_SUCCESS && node_idx < idx->node_count; ++node_idx)
+    {
+        swicc_dato_bertlv_node_st const *const node = &idx->node[node_idx];
+        uint32_t bucket_idx = bertlv_idx_hash(node->parent_idx, &node->tag) &
+                              (idx->bucket_count - 1U);
+        /* Earlier DOs were inserted first so a duplicate is not inserted. */
+        for (; idx->bucket[bucket_idx] != 0U;
+             bucket_idx = (bucket_idx + 1U) & (idx->bucket_count - 1U))
+        {
+            swicc_dato_bertlv_node_st const *const node_other =
+                &idx->node[idx->bucket[bucket_idx] - 1U];
+            if (node_other->parent_idx == node->parent_idx &&
+                bertlv_tag_eq(&node_other->tag, &node->tag))
+            {
+                break;
+            }
+        }
+        if (idx->bucket[bucket_idx] == 0U)
+        {
+            idx->bucket[bucket_idx] = node_idx + 1U;
+        }
+    }
+
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        swicc_dato_bertlv_idx_free(idx);
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_dato_bertlv_idx_free(swicc_dato_bertlv_idx_st *const idx)
+{
+    swicc_alloc_free(idx->alloc, idx->node);
+    swicc_alloc_free(idx->alloc, idx->bucket);
+    memset(idx, 0U, sizeof(*idx));
+}
+
+swicc_ret_et swicc_dato_bertlv_idx_lookup(
+    swicc_dato_bertlv_idx_st const *const idx, uint32_t const parent_idx,
+    swicc_dato_bertlv_tag_st const *const tag, uint32_t *const node_idx)
+{
+    if (idx == NULL || tag == NULL || node_idx == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (idx->bucket_count == 0U)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+    for (uint32_t bucket_idx = bertlv_idx_hash(parent_idx, tag) &
+                               (idx->bucket_count - 1U);
+         idx->bucket[bucket_idx] != 0U;
+         bucket_idx = (bucket_idx + 1U) & (idx->bucket_count - 1U))
+    {
+        swicc_dato_bertlv_node_st const *const node =
+            &idx->node[idx->bucket[bucket_idx] - 1U];
+        if (node->parent_idx == parent_idx && bertlv_tag_eq(&node->tag, tag))
+        {
+            *node_idx = idx->bucket[bucket_idx] - 1U;
+            return SWICC_RET_SUCCESS;
+        }
+    }
+    return SWICC_RET_FS_NOT_FOUND;
+}
+
+swicc_ret_et swicc_dato_bertlv_idx_lookup_path(
+    swicc_dato_bertlv_idx_st const *const idx,
+    swicc_dato_bertlv_tag_st const *const tag_path,
+    uint32_t const tag_path_len, uint32_t *const node_idx)
+{
+    if (idx == NULL || tag_path == NULL || tag_path_len == 0U ||
+        node_idx == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t parent_idx = SWICC_DATO_BERTLV_NODE_PARENT_ROOT;
+    for (uint32_t tag_idx = 0U; tag_idx < tag_path_len; ++tag_idx)
+    {
+        swicc_ret_et const ret = swicc_dato_bertlv_idx_lookup(
+            idx, parent_idx, &tag_path[tag_idx], &parent_idx);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    *node_idx = parent_idx;
+    return SWICC_RET_SUCCESS;
+}
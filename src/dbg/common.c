@@ -23,6 +23,16 @@ static char const *const swicc_dbg_table_str_ret[] = {
     [SWICC_RET_DATO_END] = "DO end of data",
     [SWICC_RET_NET_CONN_QUEUE_EMPTY] = "connection queue is empty",
     [SWICC_RET_NET_DISCONNECTED] = "client got disconnected",
+    [SWICC_RET_NET_MSG_INCOMPLETE] = "message was not completely received",
+
+    [SWICC_RET_TRACE_EMPTY] = "no trace events",
+
+    [SWICC_RET_SNAPSHOT_BUSY] = "snapshot buffers are busy",
+    [SWICC_RET_SNAPSHOT_EMPTY] = "no snapshots to write",
+
+    [SWICC_RET_FS_SWAP_PENDING] = "disk swap is pending",
+
+    [SWICC_RET_APDU_PENDING] = "APDU handling is pending",
 };
 #endif
 
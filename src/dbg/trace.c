@@ -0,0 +1,61 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <swicc/swicc.h>
+
+swicc_ret_et swicc_dbg_trace_evt_str(char *const buf_str,
+                                     uint16_t *const buf_str_len,
+                                     swicc_trace_evt_st const *const evt)
+{
+#ifdef DEBUG
+    int bytes_written;
+    switch (evt->type)
+    {
+    case SWICC_TRACE_EVT_TYPE_APDU_CMD:
+        bytes_written = snprintf(
+            buf_str, *buf_str_len,
+            // clang-format off
+            "(" CLR_KND("Trace") " (" CLR_KND("Time") " " CLR_VAL("%" PRIu64) ")"
+            "\n  (" CLR_KND("C-APDU") " (" CLR_KND("CLA") " " CLR_VAL("0x%02X") ") (" CLR_KND("INS") " " CLR_VAL("0x%02X") " = " CLR_VAL("'%s'") ") (" CLR_KND("P1") " " CLR_VAL("0x%02X") ") (" CLR_KND("P2") " " CLR_VAL("0x%02X") ") (" CLR_KND("P3") " " CLR_VAL("0x%02X") ")))",
+            // clang-format on
+            evt->time, evt->apdu_cmd.cla, evt->apdu_cmd.ins,
+            swicc_dbg_apdu_ins_str(evt->apdu_cmd.ins), evt->apdu_cmd.p1,
+            evt->apdu_cmd.p2, evt->apdu_cmd.p3);
+        break;
+    case SWICC_TRACE_EVT_TYPE_APDU_RES:
+        bytes_written = snprintf(
+            buf_str, *buf_str_len,
+            // clang-format off
+            "(" CLR_KND("Trace") " (" CLR_KND("Time") " " CLR_VAL("%" PRIu64) ")"
+            "\n  (" CLR_KND("R-APDU") " (" CLR_KND("SW1") " " CLR_VAL("0x%02X") ") (" CLR_KND("SW2") " " CLR_VAL("0x%02X") ") (" CLR_KND("Data Len") " " CLR_VAL("%u") ")))",
+            // clang-format on
+            evt->time, evt->apdu_res.sw1, evt->apdu_res.sw2,
+            evt->apdu_res.data_len);
+        break;
+    case SWICC_TRACE_EVT_TYPE_FSM:
+        bytes_written = snprintf(
+            buf_str, *buf_str_len,
+            // clang-format off
+            "(" CLR_KND("Trace") " (" CLR_KND("Time") " " CLR_VAL("%" PRIu64) ")"
+            "\n  (" CLR_KND("FSM") " " CLR_VAL("'%s'") " -> " CLR_VAL("'%s'") "))",
+            // clang-format on
+            evt->time, swicc_dbg_fsm_state_str(evt->fsm.state_old),
+            swicc_dbg_fsm_state_str(evt->fsm.state_new));
+        break;
+    default:
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (bytes_written < 0 || bytes_written >= *buf_str_len)
+    {
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+    else
+    {
+        *buf_str_len =
+            (uint16_t)bytes_written; /* Safe cast due to args of snprintf */
+        return SWICC_RET_SUCCESS;
+    }
+#else
+    *buf_str_len = 0U;
+    return SWICC_RET_SUCCESS;
+#endif
+}
@@ -0,0 +1,720 @@
+#include "disk_internal.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Check that a file, and all files nested in it, lie inside of the tree
+ * and inside of the folder that contains them so the tree can be walked
+ * without reading past its end.
+ * @param tree
+ * @param offset_trel Offset of the file.
+ * @param end Offset right after the end of the folder containing the file.
+ * @return Return code.
+ */
+static swicc_ret_et tree_file_validate(swicc_disk_tree_st const *const tree,
+                                       uint32_t const offset_trel,
+                                       uint32_t const end)
+{
+    if (swicc_disk_index_file_check(tree, offset_trel, SWICC_FS_ID_MISSING,
+                                    SWICC_FS_SID_MISSING,
+                                    NULL) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_fs_item_hdr_raw_st item_hdr_raw;
+    swicc_fs_item_hdr_st item_hdr;
+    memcpy(&item_hdr_raw, &tree->buf[offset_trel], sizeof(item_hdr_raw));
+    swicc_fs_item_hdr_prs(&item_hdr_raw, offset_trel, &item_hdr);
+    if (item_hdr.size > end - offset_trel)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_MF &&
+        item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_ADF &&
+        item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_DF)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    /* Safe cast since the folder was checked to lie inside of the tree. */
+    uint32_t const end_nstd = (uint32_t)(offset_trel + item_hdr.size);
+    uint32_t offset_nstd =
+        offset_trel + swicc_fs_item_hdr_raw_size[item_hdr.type];
+    while (offset_nstd < end_nstd)
+    {
+        if (tree_file_validate(tree, offset_nstd, end_nstd) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        swicc_fs_item_hdr_st item_hdr_nstd;
+        memcpy(&item_hdr_raw, &tree->buf[offset_nstd], sizeof(item_hdr_raw));
+        swicc_fs_item_hdr_prs(&item_hdr_raw, offset_nstd, &item_hdr_nstd);
+        /* Never 0 since every item is at least as large as its header. */
+        offset_nstd += item_hdr_nstd.size;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Merge LUTs that are each sorted into a single sorted LUT. Entries with
+ * equal item 1 end up in reverse order of the LUTs they come from, so merging
+ * the sorted LUTs of all trees gives the same LUT as appending the entries of
+ * all trees to one LUT and sorting it with 'swicc_disk_lut_sort'.
+ * @param alloc Allocator of the LUT buffers.
+ * @param lut Must be empty and have its item sizes set.
+ * @param part The LUTs to merge.
+ * @param part_count
+ * @return Return code.
+ */
+static swicc_ret_et lut_merge(swicc_alloc_st const *const alloc,
+                              swicc_disk_lut_st *const lut,
+                              swicc_disk_lut_st const *const *const part,
+                              uint32_t const part_count)
+{
+    uint64_t count = 0U;
+    for (uint32_t part_idx = 0U; part_idx < part_count; ++part_idx)
+    {
+        count += part[part_idx]->count;
+    }
+    if (count > UINT32_MAX)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Safe cast since the count was checked to fit in uint32 range. */
+    lut->count_max = count > SWICC_DISK_LUT_COUNT_START
+                         ? (uint32_t)count
+                         : SWICC_DISK_LUT_COUNT_START;
+    lut->count = 0U;
+    lut->buf1 = swicc_alloc_malloc(alloc, lut->count_max * lut->size_item1);
+    lut->buf2 = swicc_alloc_malloc(alloc, lut->count_max * lut->size_item2);
+    if (lut->buf1 == NULL || lut->buf2 == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    uint32_t pos[part_count];
+    memset(pos, 0U, sizeof(pos));
+    while (lut->count < count)
+    {
+        /* On equal items the later LUT wins. */
+        uint32_t part_min = part_count;
+        for (uint32_t part_idx = 0U; part_idx < part_count; ++part_idx)
+        {
+            if (pos[part_idx] < part[part_idx]->count &&
+                (part_min == part_count ||
+                 memcmp(&part[part_idx]->buf1[lut->size_item1 * pos[part_idx]],
+                        &part[part_min]->buf1[lut->size_item1 * pos[part_min]],
+                        lut->size_item1) <= 0))
+            {
+                part_min = part_idx;
+            }
+        }
+        memcpy(&lut->buf1[lut->size_item1 * lut->count],
+               &part[part_min]->buf1[lut->size_item1 * pos[part_min]],
+               lut->size_item1);
+        memcpy(&lut->buf2[lut->size_item2 * lut->count],
+               &part[part_min]->buf2[lut->size_item2 * pos[part_min]],
+               lut->size_item2);
+        pos[part_min] += 1U;
+        lut->count += 1U;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/* Most threads a batch of disks is loaded on. */
+#define DISK_BATCH_WORKER_COUNT_MAX 256U
+
+/* A tree of a disk loaded in a batch. */
+typedef struct disk_batch_tree_s
+{
+    swicc_disk_tree_st *tree;
+    uint32_t offset; /* Where the tree is in the disk file. */
+    uint32_t check;  /* Checksum from the index, if the tree has one. */
+    bool check_has;
+
+    /* Fragments of the ID and name LUTs of the disk holding this one tree. */
+    swicc_disk_lut_st lutid;
+    swicc_disk_lut_st lutname;
+} disk_batch_tree_st;
+
+/* A disk loaded in a batch. */
+typedef struct disk_batch_disk_s
+{
+    swicc_disk_st *disk;
+    char const *disk_path;
+    int32_t fd;
+    disk_batch_tree_st *tree;
+    uint32_t tree_count;
+    bool loading; /* If the disk was emptied to be loaded. */
+    _Atomic bool failed;
+} disk_batch_disk_st;
+
+/* Tree of the batch as a disk index and a tree index in it. */
+typedef struct disk_batch_tree_ref_s
+{
+    uint32_t disk_idx;
+    uint32_t tree_idx;
+} disk_batch_tree_ref_st;
+
+typedef struct disk_batch_s disk_batch_st;
+
+/* A job of a stage of the batch, i.e. a disk or a tree. */
+typedef void disk_batch_job_ft(disk_batch_st *const batch,
+                               uint32_t const job_idx);
+
+/**
+ * Disks loaded by a group of workers. Loading goes through stages, in every
+ * stage each worker takes the next job that nobody has taken yet until none
+ * are left.
+ */
+struct disk_batch_s
+{
+    disk_batch_disk_st *disk;
+    uint32_t disk_count;
+
+    /* Trees of all disks so the reads of different disks overlap. */
+    disk_batch_tree_ref_st *tree_ref;
+    uint32_t tree_ref_count;
+
+    disk_batch_job_ft *job;
+    uint32_t job_count;
+    _Atomic uint32_t job_next;
+};
+
+/**
+ * @brief Read exactly the requested number of bytes from a file at an offset.
+ * @param fd
+ * @param buf
+ * @param len
+ * @param offset
+ * @return Return code.
+ */
+static swicc_ret_et disk_batch_pread(int32_t const fd, uint8_t *const buf,
+                                     uint32_t const len, uint32_t const offset)
+{
+    uint32_t len_read = 0U;
+    while (len_read < len)
+    {
+        ssize_t const ret = pread(fd, &buf[len_read], len - len_read,
+                                  (off_t)offset + len_read);
+        if (ret <= 0)
+        {
+            return SWICC_RET_ERROR;
+        }
+        /* Safe cast since at most the requested length is read. */
+        len_read += (uint32_t)ret;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Find the trees of a disk file by reading only their headers and
+ * allocate the trees. Disk files with compressed trees are loaded as with
+ * 'swicc_disk_load' right away.
+ * @param batch
+ * @param job_idx Index of the disk.
+ */
+static disk_batch_job_ft disk_batch_scan;
+static void disk_batch_scan(disk_batch_st *const batch, uint32_t const job_idx)
+{
+    disk_batch_disk_st *const job = &batch->disk[job_idx];
+    swicc_disk_st *const disk = job->disk;
+    job->fd = -1;
+    if (disk->root != NULL)
+    {
+        /* Get rid of the current disk first before loading a new one. */
+        atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        return;
+    }
+    swicc_alloc_st const *const alloc = disk->alloc;
+    memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
+    job->loading = true;
+
+    uint8_t const magic_expected[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC;
+    uint8_t const magic_index[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_INDEX;
+    uint8_t const magic_lz4[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_LZ4;
+    uint8_t magic[SWICC_DISK_MAGIC_LEN];
+    struct stat f_stat;
+    job->fd = open(job->disk_path, O_RDONLY);
+    if (job->fd < 0 || fstat(job->fd, &f_stat) != 0 || f_stat.st_size < 0 ||
+        f_stat.st_size > UINT32_MAX ||
+        disk_batch_pread(job->fd, magic, sizeof(magic), 0U) !=
+            SWICC_RET_SUCCESS)
+    {
+        atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        return;
+    }
+    /* Safe cast since the file size was checked to fit in uint32 range. */
+    uint32_t const f_len = (uint32_t)f_stat.st_size;
+    uint32_t data_idx = SWICC_DISK_MAGIC_LEN;
+    if (memcmp(magic, magic_lz4, sizeof(magic)) == 0)
+    {
+        close(job->fd);
+        job->fd = -1;
+        if (swicc_disk_load(disk, job->disk_path) != SWICC_RET_SUCCESS)
+        {
+            atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        }
+        return;
+    }
+    swicc_disk_index_hdr_raw_st index_hdr = {0U};
+    swicc_disk_index_tree_raw_st *index_tree = NULL;
+    if (memcmp(magic, magic_index, sizeof(magic)) == 0)
+    {
+        /**
+         * Only the checksums of the trees are used from the index since the
+         * LUTs get built by the workers.
+         */
+        if (disk_batch_pread(job->fd, (uint8_t *)&index_hdr,
+                             sizeof(index_hdr),
+                             data_idx) != SWICC_RET_SUCCESS ||
+            index_hdr.size < sizeof(index_hdr) ||
+            index_hdr.size > f_len - data_idx)
+        {
+            atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+            return;
+        }
+        if (index_hdr.tree_count <= UINT8_MAX + 1U &&
+            sizeof(index_hdr) + ((uint64_t)index_hdr.tree_count *
+                                 sizeof(*index_tree)) <=
+                index_hdr.size)
+        {
+            index_tree = malloc(index_hdr.tree_count * sizeof(*index_tree));
+            /* Safe casts since the entries were checked to fit the index. */
+            if (index_tree != NULL &&
+                disk_batch_pread(
+                    job->fd, (uint8_t *)index_tree,
+                    index_hdr.tree_count * (uint32_t)sizeof(*index_tree),
+                    data_idx + (uint32_t)sizeof(index_hdr)) !=
+                    SWICC_RET_SUCCESS)
+            {
+                free(index_tree);
+                index_tree = NULL;
+            }
+        }
+        data_idx += index_hdr.size;
+    }
+    else if (memcmp(magic, magic_expected, sizeof(magic)) != 0)
+    {
+        atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        free(index_tree);
+        return;
+    }
+
+    swicc_disk_tree_st **tree_next = &disk->root;
+    while (data_idx < f_len)
+    {
+        swicc_fs_item_hdr_raw_st item_hdr_raw;
+        swicc_fs_item_hdr_st item_hdr;
+        if (job->tree_count > UINT8_MAX ||
+            f_len - data_idx < sizeof(item_hdr_raw) ||
+            disk_batch_pread(job->fd, (uint8_t *)&item_hdr_raw,
+                             sizeof(item_hdr_raw),
+                             data_idx) != SWICC_RET_SUCCESS)
+        {
+            break;
+        }
+        swicc_fs_item_hdr_prs(&item_hdr_raw, 0U, &item_hdr);
+        /* The first tree is the MF and all other ones are ADFs. */
+        if ((job->tree_count == 0U &&
+             item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_MF) ||
+            (job->tree_count != 0U &&
+             item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_ADF) ||
+            item_hdr.size < sizeof(item_hdr_raw) ||
+            item_hdr.size > f_len - data_idx)
+        {
+            break;
+        }
+
+        disk_batch_tree_st *const tree_job_new = realloc(
+            job->tree, (job->tree_count + 1U) * sizeof(disk_batch_tree_st));
+        if (tree_job_new == NULL)
+        {
+            break;
+        }
+        job->tree = tree_job_new;
+        swicc_disk_tree_st *const tree =
+            swicc_alloc_malloc(alloc, sizeof(*tree));
+        if (tree == NULL)
+        {
+            break;
+        }
+        memset(tree, 0U, sizeof(*tree));
+        tree->alloc = alloc;
+        *tree_next = tree;
+        tree_next = &tree->next;
+        tree->buf = swicc_alloc_malloc(alloc, item_hdr.size);
+        if (tree->buf == NULL)
+        {
+            break;
+        }
+        tree->size = item_hdr.size;
+
+        disk_batch_tree_st *const tree_job = &job->tree[job->tree_count++];
+        memset(tree_job, 0U, sizeof(*tree_job));
+        tree_job->tree = tree;
+        tree_job->offset = data_idx;
+        data_idx += item_hdr.size;
+    }
+    if (data_idx != f_len || job->tree_count == 0U)
+    {
+        atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+    }
+    /* Same as the other loaders, an index that does not fit is ignored. */
+    else if (index_tree != NULL && index_hdr.tree_count == job->tree_count)
+    {
+        for (uint32_t tree_idx = 0U; tree_idx < job->tree_count; ++tree_idx)
+        {
+            job->tree[tree_idx].check = index_tree[tree_idx].check;
+            job->tree[tree_idx].check_has = true;
+        }
+    }
+    free(index_tree);
+}
+
+/**
+ * @brief Read a tree from the disk file, validate it, and create its SID LUT
+ * and its fragments of the ID and name LUTs.
+ * @param batch
+ * @param job_idx Index of the tree among the trees of all disks.
+ */
+static disk_batch_job_ft disk_batch_tree;
+static void disk_batch_tree(disk_batch_st *const batch, uint32_t const job_idx)
+{
+    disk_batch_tree_ref_st const *const ref = &batch->tree_ref[job_idx];
+    disk_batch_disk_st *const job = &batch->disk[ref->disk_idx];
+    disk_batch_tree_st *const tree_job = &job->tree[ref->tree_idx];
+    swicc_disk_tree_st *const tree = tree_job->tree;
+    if (atomic_load_explicit(&job->failed, memory_order_relaxed) == true)
+    {
+        return;
+    }
+
+    swicc_ret_et ret =
+        disk_batch_pread(job->fd, tree->buf, tree->size, tree_job->offset);
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        tree->len = tree->size;
+        if (tree_job->check_has)
+        {
+            tree->check = swicc_crc32c(0U, tree->buf, tree->len);
+            tree->check_valid = tree->check == tree_job->check;
+            ret = tree->check_valid ? SWICC_RET_SUCCESS : SWICC_RET_ERROR;
+        }
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = tree_file_validate(tree, 0U, tree->len);
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = swicc_disk_lutsid_rebuild(job->disk, tree);
+    }
+
+    /* Same as in 'swicc_disk_lutid_rebuild' but for this tree alone. */
+    tree_job->lutid.size_item1 = sizeof(swicc_fs_id_kt);
+    tree_job->lutid.size_item2 = sizeof(uint32_t) + sizeof(uint8_t);
+    tree_job->lutname.size_item1 = 1U + SWICC_FS_NAME_LEN;
+    tree_job->lutname.size_item2 = tree_job->lutid.size_item2;
+    /* Safe cast since there are fewer than 256 trees in the forest. */
+    swicc_disk_lutid_rebuild_cb_userdata_st userdata = {
+        .lut = &tree_job->lutid,
+        .lutname = &tree_job->lutname,
+        .tree_idx = (uint8_t)ref->tree_idx,
+    };
+    swicc_fs_file_st file_root;
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = swicc_disk_tree_file_root(tree, &file_root);
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = swicc_disk_file_foreach(tree, &file_root,
+                                      swicc_disk_lutid_rebuild_cb, &userdata,
+                                      true);
+    }
+    if (ret == SWICC_RET_SUCCESS &&
+        (swicc_disk_lut_sort(tree->alloc, &tree_job->lutid) !=
+             SWICC_RET_SUCCESS ||
+         swicc_disk_lut_sort(tree->alloc, &tree_job->lutname) !=
+             SWICC_RET_SUCCESS))
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Merge the LUT fragments of all trees of a disk into the ID and name
+ * LUTs of the disk. Disks which failed to load are emptied.
+ * @param batch
+ * @param job_idx Index of the disk.
+ */
+static disk_batch_job_ft disk_batch_finish;
+static void disk_batch_finish(disk_batch_st *const batch,
+                              uint32_t const job_idx)
+{
+    disk_batch_disk_st *const job = &batch->disk[job_idx];
+    swicc_disk_st *const disk = job->disk;
+    if (job->fd >= 0)
+    {
+        close(job->fd);
+        job->fd = -1;
+    }
+    /* Disks with compressed trees were loaded as a whole. */
+    bool ok = atomic_load_explicit(&job->failed, memory_order_relaxed) == false;
+    if (ok && job->tree_count > 0U)
+    {
+        swicc_disk_lut_st const *part_id[job->tree_count];
+        swicc_disk_lut_st const *part_name[job->tree_count];
+        for (uint32_t tree_idx = 0U; tree_idx < job->tree_count; ++tree_idx)
+        {
+            part_id[tree_idx] = &job->tree[tree_idx].lutid;
+            part_name[tree_idx] = &job->tree[tree_idx].lutname;
+        }
+        disk->lutid.size_item1 = sizeof(swicc_fs_id_kt);
+        disk->lutid.size_item2 = sizeof(uint32_t) + sizeof(uint8_t);
+        disk->lutname.size_item1 = 1U + SWICC_FS_NAME_LEN;
+        disk->lutname.size_item2 = disk->lutid.size_item2;
+        disk->lutid_tree = swicc_alloc_malloc(
+            disk->alloc, job->tree_count * sizeof(swicc_disk_tree_st *));
+        ok = disk->lutid_tree != NULL &&
+             lut_merge(disk->alloc, &disk->lutid, part_id, job->tree_count) ==
+                 SWICC_RET_SUCCESS &&
+             lut_merge(disk->alloc, &disk->lutname, part_name,
+                       job->tree_count) == SWICC_RET_SUCCESS;
+        for (uint32_t tree_idx = 0U; ok && tree_idx < job->tree_count;
+             ++tree_idx)
+        {
+            disk->lutid_tree[disk->lutid_tree_count++] =
+                job->tree[tree_idx].tree;
+        }
+    }
+    for (uint32_t tree_idx = 0U; tree_idx < job->tree_count; ++tree_idx)
+    {
+        disk_batch_tree_st *const tree_job = &job->tree[tree_idx];
+        swicc_alloc_free(disk->alloc, tree_job->lutid.buf1);
+        swicc_alloc_free(disk->alloc, tree_job->lutid.buf2);
+        swicc_alloc_free(disk->alloc, tree_job->lutname.buf1);
+        swicc_alloc_free(disk->alloc, tree_job->lutname.buf2);
+    }
+    free(job->tree);
+    job->tree = NULL;
+    if (!ok)
+    {
+        atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+    }
+    if (!ok && job->loading)
+    {
+        swicc_disk_root_empty(disk);
+        swicc_alloc_st const *const alloc = disk->alloc;
+        memset(disk, 0U, sizeof(*disk));
+        disk->alloc = alloc;
+    }
+}
+
+/**
+ * @brief Worker of a batch. It runs jobs of the current stage until none are
+ * left.
+ * @param arg The batch.
+ * @return Always NULL.
+ */
+static void *disk_batch_worker(void *const arg)
+{
+    disk_batch_st *const batch = arg;
+    while (true)
+    {
+        uint32_t const job_idx = atomic_fetch_add_explicit(
+            &batch->job_next, 1U, memory_order_relaxed);
+        if (job_idx >= batch->job_count)
+        {
+            break;
+        }
+        batch->job(batch, job_idx);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run all jobs of a stage of a batch on several threads and wait for
+ * them to be done.
+ * @param batch
+ * @param job
+ * @param job_count
+ * @param worker_count
+ */
+static void disk_batch_stage(disk_batch_st *const batch,
+                             disk_batch_job_ft *const job,
+                             uint32_t const job_count,
+                             uint32_t const worker_count)
+{
+    batch->job = job;
+    batch->job_count = job_count;
+    atomic_store_explicit(&batch->job_next, 0U, memory_order_relaxed);
+    uint32_t const worker_count_valid =
+        worker_count < job_count ? worker_count : job_count;
+
+    /**
+     * The calling thread is a worker too so if some threads can't be created,
+     * fewer jobs are run at a time but all still get done.
+     */
+    pthread_t thread[DISK_BATCH_WORKER_COUNT_MAX];
+    uint32_t thread_count = 0U;
+    for (; thread_count + 1U < worker_count_valid &&
+           thread_count < DISK_BATCH_WORKER_COUNT_MAX;
+         ++thread_count)
+    {
+        if (pthread_create(&thread[thread_count], NULL, disk_batch_worker,
+                           batch) != 0)
+        {
+            break;
+        }
+    }
+    disk_batch_worker(batch);
+    for (uint32_t thread_idx = 0U; thread_idx < thread_count; ++thread_idx)
+    {
+        pthread_join(thread[thread_idx], NULL);
+    }
+}
+
+swicc_ret_et swicc_disk_load_batch(swicc_disk_st *const disk,
+                                   char const *const *const disk_path,
+                                   swicc_ret_et *const disk_ret,
+                                   uint32_t const disk_count,
+                                   uint32_t const worker_count)
+{
+    if ((disk == NULL || disk_path == NULL) && disk_count > 0U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    for (uint32_t disk_idx = 0U; disk_idx < disk_count; ++disk_idx)
+    {
+        if (disk_path[disk_idx] == NULL)
+        {
+            return SWICC_RET_PARAM_BAD;
+        }
+    }
+    if (disk_count == 0U)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    uint32_t worker_count_valid = worker_count;
+    if (worker_count_valid == 0U)
+    {
+        int64_t const core_count = sysconf(_SC_NPROCESSORS_ONLN);
+        /* Safe cast since the core count is checked to be in range. */
+        worker_count_valid = core_count > 0 && core_count <= UINT32_MAX
+                                 ? (uint32_t)core_count
+                                 : 1U;
+    }
+
+    disk_batch_st batch = {
+        .disk = calloc(disk_count, sizeof(disk_batch_disk_st)),
+        .disk_count = disk_count,
+    };
+    if (batch.disk == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    for (uint32_t disk_idx = 0U; disk_idx < disk_count; ++disk_idx)
+    {
+        batch.disk[disk_idx].disk = &disk[disk_idx];
+        batch.disk[disk_idx].disk_path = disk_path[disk_idx];
+        batch.disk[disk_idx].fd = -1;
+        atomic_init(&batch.disk[disk_idx].failed, false);
+    }
+
+    /**
+     * Trees can only be found once the headers of the ones before them were
+     * read so disks get scanned first, then all trees are read and indexed,
+     * and at last the LUTs of every disk are merged.
+     */
+    disk_batch_stage(&batch, disk_batch_scan, disk_count, worker_count_valid);
+    uint64_t tree_ref_count = 0U;
+    for (uint32_t disk_idx = 0U; disk_idx < disk_count; ++disk_idx)
+    {
+        tree_ref_count += batch.disk[disk_idx].tree_count;
+    }
+    batch.tree_ref = tree_ref_count > 0U && tree_ref_count <= UINT32_MAX
+                         ? malloc(tree_ref_count * sizeof(*batch.tree_ref))
+                         : NULL;
+    if (batch.tree_ref != NULL)
+    {
+        /**
+         * Trees are interleaved across disks so that the first reads of every
+         * disk get issued right away.
+         */
+        for (uint32_t tree_idx = 0U; tree_idx <= UINT8_MAX; ++tree_idx)
+        {
+            for (uint32_t disk_idx = 0U; disk_idx < disk_count; ++disk_idx)
+            {
+                if (tree_idx < batch.disk[disk_idx].tree_count)
+                {
+                    batch.tree_ref[batch.tree_ref_count++] =
+                        (disk_batch_tree_ref_st){
+                            .disk_idx = disk_idx,
+                            .tree_idx = tree_idx,
+                        };
+                }
+            }
+        }
+        disk_batch_stage(&batch, disk_batch_tree, batch.tree_ref_count,
+                         worker_count_valid);
+    }
+    else
+    {
+        /* Without a list of trees, all disks with trees fail. */
+        for (uint32_t disk_idx = 0U; disk_idx < disk_count; ++disk_idx)
+        {
+            if (batch.disk[disk_idx].tree_count > 0U)
+            {
+                atomic_store_explicit(&batch.disk[disk_idx].failed, true,
+                                      memory_order_relaxed);
+            }
+        }
+    }
+    disk_batch_stage(&batch, disk_batch_finish, disk_count,
+                     worker_count_valid);
+
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    for (uint32_t disk_idx = 0U; disk_idx < disk_count; ++disk_idx)
+    {
+        swicc_ret_et const ret_disk =
+            atomic_load_explicit(&batch.disk[disk_idx].failed,
+                                 memory_order_relaxed) == true
+                ? SWICC_RET_ERROR
+                : SWICC_RET_SUCCESS;
+        if (disk_ret != NULL)
+        {
+            disk_ret[disk_idx] = ret_disk;
+        }
+        if (ret_disk != SWICC_RET_SUCCESS)
+        {
+            ret = ret_disk;
+        }
+    }
+    free(batch.tree_ref);
+    free(batch.disk);
+    return ret;
+}
+
+swicc_ret_et swicc_disk_load_parallel(swicc_disk_st *const disk,
+                                      char const *const disk_path,
+                                      uint32_t const worker_count)
+{
+    if (disk == NULL || disk_path == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    return swicc_disk_load_batch(disk, &disk_path, NULL, 1U, worker_count);
+}
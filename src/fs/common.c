@@ -98,10 +98,86 @@ void swicc_fs_file_hdr_prs(swicc_fs_file_hdr_raw_st const *const file_hdr_raw,
     file_hdr->sid = file_hdr_raw->sid;
 }
 
+/**
+ * @brief Create a file from its pre-decoded descriptor instead of parsing the
+ * raw headers. Only the names of folders still come from the tree buffer.
+ * @param tree
+ * @param descr
+ * @param file
+ * @return Return code.
+ */
+static swicc_ret_et file_prs_descr(swicc_disk_tree_st const *const tree,
+                                   swicc_disk_descr_st const *const descr,
+                                   swicc_fs_file_st *const file)
+{
+    uint32_t const offset_trel_hdr_spec = descr->offset_trel +
+                                          sizeof(swicc_fs_item_hdr_raw_st) +
+                                          sizeof(swicc_fs_file_hdr_raw_st);
+    memset(file, 0U, sizeof(*file));
+    file->hdr_item.size = descr->size;
+    file->hdr_item.offset_trel = descr->offset_trel;
+    file->hdr_item.offset_prel = descr->offset_prel;
+    file->hdr_item.type = descr->type;
+    file->hdr_item.lcs = descr->lcs;
+    file->hdr_file.id = descr->id;
+    file->hdr_file.sid = descr->sid;
+    file->internal.hdr_raw = &tree->buf[descr->offset_trel];
+    switch (file->hdr_item.type)
+    {
+    case SWICC_FS_ITEM_TYPE_FILE_MF:
+        memcpy(file->hdr_spec.mf.name,
+               ((swicc_fs_mf_hdr_raw_st *)&tree->buf[offset_trel_hdr_spec])
+                   ->name,
+               SWICC_FS_NAME_LEN);
+        break;
+    case SWICC_FS_ITEM_TYPE_FILE_ADF: {
+        swicc_fs_adf_hdr_raw_st const *const adf_hdr_raw =
+            (swicc_fs_adf_hdr_raw_st *)&tree->buf[offset_trel_hdr_spec];
+        memcpy(file->hdr_spec.adf.aid.rid, adf_hdr_raw->aid.rid,
+               sizeof(file->hdr_spec.adf.aid.rid));
+        memcpy(file->hdr_spec.adf.aid.pix, adf_hdr_raw->aid.pix,
+               sizeof(file->hdr_spec.adf.aid.pix));
+        break;
+    }
+    case SWICC_FS_ITEM_TYPE_FILE_DF:
+        memcpy(file->hdr_spec.df.name,
+               ((swicc_fs_df_hdr_raw_st *)&tree->buf[offset_trel_hdr_spec])
+                   ->name,
+               SWICC_FS_NAME_LEN);
+        break;
+    case SWICC_FS_ITEM_TYPE_FILE_EF_TRANSPARENT:
+        break;
+    case SWICC_FS_ITEM_TYPE_FILE_EF_LINEARFIXED:
+        file->hdr_spec.ef_linearfixed.rcrd_size = descr->rcrd_size;
+        break;
+    case SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC:
+        file->hdr_spec.ef_cyclic.rcrd_size = descr->rcrd_size;
+        break;
+    default:
+        return SWICC_RET_ERROR;
+    }
+    uint32_t const hdr_size = swicc_fs_item_hdr_raw_size[file->hdr_item.type];
+    file->data_size = file->hdr_item.size - hdr_size;
+    file->data = &tree->buf[descr->offset_trel + hdr_size];
+    if (tree->overlay_count > 0U)
+    {
+        return swicc_disk_file_data(tree, file, &file->data);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
 swicc_ret_et swicc_fs_file_prs(swicc_disk_tree_st const *const tree,
                                uint32_t const offset_trel,
                                swicc_fs_file_st *const file)
 {
+    uint32_t descr_idx;
+    if (tree->descr_count > 0U &&
+        swicc_disk_descr_lookup(tree, offset_trel, &descr_idx) ==
+            SWICC_RET_SUCCESS)
+    {
+        return file_prs_descr(tree, &tree->descr[descr_idx], file);
+    }
+
     swicc_fs_item_hdr_raw_st const *const item_hdr_raw =
         (swicc_fs_item_hdr_raw_st *)&tree->buf[offset_trel];
     swicc_fs_file_hdr_raw_st const *const file_hdr_raw =
@@ -171,5 +247,10 @@ swicc_ret_et swicc_fs_file_prs(swicc_disk_tree_st const *const tree,
     file->data_size = file->hdr_item.size - hdr_size;
     file->data = &tree->buf[offset_trel + hdr_size];
 
+    /* Modified files of shared trees live in the overlay. */
+    if (tree->overlay_count > 0U)
+    {
+        return swicc_disk_file_data(tree, file, &file->data);
+    }
     return SWICC_RET_SUCCESS;
 }
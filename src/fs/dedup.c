@@ -0,0 +1,474 @@
+#include <string.h>
+#include <swicc/swicc.h>
+
+/* Trees (and extents) the arrays of a store grow by when full. */
+#define DEDUP_TREE_COUNT_RESIZE 16U
+#define DEDUP_EXTENT_COUNT_RESIZE 64U
+
+/**
+ * @brief Get the length of the part of the header of a file that belongs to
+ * the structure of its tree. The record head of a cyclic EF (the last byte of
+ * its header) gets updated together with the data so it is left out.
+ * @param descr Descriptor of the file.
+ * @return Length of the part, it starts at the start of the header.
+ */
+static uint32_t dedup_hdr_len(swicc_disk_descr_st const *const descr)
+{
+    uint32_t const hdr_size = swicc_fs_item_hdr_raw_size[descr->type];
+    return descr->type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC ? hdr_size - 1U
+                                                            : hdr_size;
+}
+
+/**
+ * @brief Compute the checksum of the structure of a tree, i.e. of all the
+ * headers, and check that the headers and the data of the EFs make up the
+ * whole tree.
+ * @param tree
+ * @param key Where the checksum will be written.
+ * @return Return code.
+ */
+static swicc_ret_et dedup_key(swicc_disk_tree_st const *const tree,
+                              uint32_t *const key)
+{
+    uint32_t crc = swicc_crc32c(0U, (uint8_t const *)&tree->len,
+                                sizeof(tree->len));
+    uint64_t len_covered = 0U;
+    for (uint32_t descr_idx = 0U; descr_idx < tree->descr_count; ++descr_idx)
+    {
+        swicc_disk_descr_st const *const descr = &tree->descr[descr_idx];
+        if (descr->type < SWICC_FS_ITEM_TYPE_FILE_MF ||
+            descr->type > SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
+        {
+            return SWICC_RET_ERROR;
+        }
+        uint32_t const hdr_size = swicc_fs_item_hdr_raw_size[descr->type];
+        if (descr->size < hdr_size || descr->offset_trel > tree->len ||
+            descr->size > tree->len - descr->offset_trel)
+        {
+            return SWICC_RET_ERROR;
+        }
+        crc = swicc_crc32c(crc, &tree->buf[descr->offset_trel],
+                           dedup_hdr_len(descr));
+        /* Folders contain the other files, EFs contain their data. */
+        len_covered += descr->type <= SWICC_FS_ITEM_TYPE_FILE_DF
+                           ? hdr_size
+                           : descr->size;
+    }
+    if (len_covered != tree->len)
+    {
+        /* Some bytes are neither in a header nor in the data of an EF. */
+        return SWICC_RET_ERROR;
+    }
+    *key = crc;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Check if two trees have the same structure.
+ * @param tree_a
+ * @param tree_b
+ * @return true if they have, false otherwise.
+ */
+static bool dedup_same(swicc_disk_tree_st const *const tree_a,
+                       swicc_disk_tree_st const *const tree_b)
+{
+    if (tree_a->len != tree_b->len ||
+        tree_a->descr_count != tree_b->descr_count)
+    {
+        return false;
+    }
+    for (uint32_t descr_idx = 0U; descr_idx < tree_a->descr_count;
+         ++descr_idx)
+    {
+        swicc_disk_descr_st const *const descr = &tree_a->descr[descr_idx];
+        if (descr->offset_trel != tree_b->descr[descr_idx].offset_trel ||
+            descr->size != tree_b->descr[descr_idx].size ||
+            descr->type != tree_b->descr[descr_idx].type)
+        {
+            return false;
+        }
+        if (memcmp(&tree_a->buf[descr->offset_trel],
+                   &tree_b->buf[descr->offset_trel],
+                   dedup_hdr_len(descr)) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Copy a buffer into a new allocation.
+ * @param alloc Allocator of the store.
+ * @param buf
+ * @param len
+ * @return The copy, NULL on failure. Not NULL when the length is 0.
+ */
+static void *dedup_copy(swicc_alloc_st const *const alloc,
+                        void const *const buf, size_t const len)
+{
+    void *const copy = swicc_alloc_malloc(alloc, len > 0U ? len : 1U);
+    if (copy != NULL && len > 0U)
+    {
+        memcpy(copy, buf, len);
+    }
+    return copy;
+}
+
+/**
+ * @brief Free a tree of a store.
+ * @param dedup_tree
+ */
+static void dedup_tree_free(swicc_disk_dedup_tree_st *const dedup_tree)
+{
+    swicc_alloc_st const *const alloc = dedup_tree->tree.alloc;
+    swicc_alloc_free(alloc, dedup_tree->tree.buf);
+    swicc_disk_lutsid_empty(&dedup_tree->tree);
+    swicc_alloc_free(alloc, dedup_tree);
+}
+
+/**
+ * @brief Create a tree of a store as a copy of a tree of a disk. Only what is
+ * needed to share it is copied, i.e. the buffer, SID LUT, and descriptors.
+ * @param alloc Allocator of the store.
+ * @param tree
+ * @param key Checksum of the structure of the tree.
+ * @return The tree of the store, NULL on failure.
+ */
+static swicc_disk_dedup_tree_st *dedup_tree_create(
+    swicc_alloc_st const *const alloc, swicc_disk_tree_st const *const tree,
+    uint32_t const key)
+{
+    swicc_disk_dedup_tree_st *const dedup_tree =
+        swicc_alloc_malloc(alloc, sizeof(*dedup_tree));
+    if (dedup_tree == NULL)
+    {
+        return NULL;
+    }
+    memset(dedup_tree, 0U, sizeof(*dedup_tree));
+    dedup_tree->key = key;
+    swicc_disk_tree_st *const copy = &dedup_tree->tree;
+    copy->alloc = alloc;
+    copy->size = tree->len;
+    copy->len = tree->len;
+    copy->buf = dedup_copy(alloc, tree->buf, tree->len);
+    copy->lutsid = tree->lutsid;
+    copy->lutsid.count_max = tree->lutsid.count;
+    copy->lutsid.buf1 =
+        dedup_copy(alloc, tree->lutsid.buf1,
+                   tree->lutsid.count * tree->lutsid.size_item1);
+    copy->lutsid.buf2 =
+        dedup_copy(alloc, tree->lutsid.buf2,
+                   tree->lutsid.count * tree->lutsid.size_item2);
+    memcpy(copy->lutsid_direct, tree->lutsid_direct,
+           sizeof(copy->lutsid_direct));
+    copy->descr = dedup_copy(alloc, tree->descr,
+                             tree->descr_count * sizeof(*tree->descr));
+    copy->descr_count = tree->descr_count;
+    copy->check = tree->check;
+    copy->check_valid = tree->check_valid;
+    if (copy->buf == NULL || copy->lutsid.buf1 == NULL ||
+        copy->lutsid.buf2 == NULL || copy->descr == NULL)
+    {
+        dedup_tree_free(dedup_tree);
+        return NULL;
+    }
+    return dedup_tree;
+}
+
+/**
+ * @brief Free an extent of a store.
+ * @param alloc Allocator of the store.
+ * @param extent
+ */
+static void dedup_extent_free(swicc_alloc_st const *const alloc,
+                              swicc_disk_dedup_extent_st *const extent)
+{
+    swicc_alloc_free(alloc, extent->data);
+    swicc_alloc_free(alloc, extent);
+}
+
+/**
+ * @brief Find where the extents with a given key start in a store.
+ * @param dedup
+ * @param key
+ * @return Index of the first extent with the key, or where it would be.
+ */
+static uint32_t dedup_extent_find(swicc_disk_dedup_st const *const dedup,
+                                  uint32_t const key)
+{
+    uint32_t lo = 0U;
+    uint32_t hi = dedup->extent_count;
+    while (lo < hi)
+    {
+        uint32_t const mid = lo + ((hi - lo) / 2U);
+        if (dedup->extent[mid]->key < key)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+swicc_ret_et swicc_disk_dedup_init(swicc_disk_dedup_st *const dedup,
+                                   swicc_alloc_st const *const alloc)
+{
+    if (dedup == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    memset(dedup, 0U, sizeof(*dedup));
+    dedup->alloc = alloc;
+    if (pthread_mutex_init(&dedup->lock, NULL) != 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_disk_dedup_deinit(swicc_disk_dedup_st *const dedup)
+{
+    if (dedup == NULL)
+    {
+        return;
+    }
+    for (uint32_t tree_idx = 0U; tree_idx < dedup->tree_count; ++tree_idx)
+    {
+        dedup_tree_free(dedup->tree[tree_idx]);
+    }
+    swicc_alloc_free(dedup->alloc, dedup->tree);
+    for (uint32_t extent_idx = 0U; extent_idx < dedup->extent_count;
+         ++extent_idx)
+    {
+        dedup_extent_free(dedup->alloc, dedup->extent[extent_idx]);
+    }
+    swicc_alloc_free(dedup->alloc, dedup->extent);
+    pthread_mutex_destroy(&dedup->lock);
+    memset(dedup, 0U, sizeof(*dedup));
+}
+
+swicc_ret_et swicc_disk_dedup_tree_get(
+    swicc_disk_dedup_st *const dedup, swicc_disk_tree_st const *const tree,
+    swicc_disk_dedup_tree_st **const dedup_tree)
+{
+    if (dedup == NULL || tree == NULL || dedup_tree == NULL ||
+        tree->buf == NULL || tree->descr_count == 0U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t key;
+    if (dedup_key(tree, &key) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    pthread_mutex_lock(&dedup->lock);
+    uint32_t lo = 0U;
+    uint32_t hi = dedup->tree_count;
+    while (lo < hi)
+    {
+        uint32_t const mid = lo + ((hi - lo) / 2U);
+        if (dedup->tree[mid]->key < key)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    /* Different structures can have the same checksum. */
+    for (uint32_t tree_idx = lo;
+         tree_idx < dedup->tree_count && dedup->tree[tree_idx]->key == key;
+         ++tree_idx)
+    {
+        if (dedup_same(&dedup->tree[tree_idx]->tree, tree))
+        {
+            *dedup_tree = dedup->tree[tree_idx];
+            (*dedup_tree)->ref_count += 1U;
+            dedup->len_ref += tree->len;
+            pthread_mutex_unlock(&dedup->lock);
+            return SWICC_RET_SUCCESS;
+        }
+    }
+
+    if (dedup->tree_count >= dedup->tree_count_max)
+    {
+        uint32_t const count_max_new =
+            dedup->tree_count_max + DEDUP_TREE_COUNT_RESIZE;
+        swicc_disk_dedup_tree_st **const tree_new =
+            swicc_alloc_realloc(dedup->alloc, dedup->tree,
+                                dedup->tree_count_max * sizeof(*tree_new),
+                                count_max_new * sizeof(*tree_new));
+        if (tree_new == NULL)
+        {
+            pthread_mutex_unlock(&dedup->lock);
+            return SWICC_RET_ERROR;
+        }
+        dedup->tree = tree_new;
+        dedup->tree_count_max = count_max_new;
+    }
+    swicc_disk_dedup_tree_st *const tree_new =
+        dedup_tree_create(dedup->alloc, tree, key);
+    if (tree_new == NULL)
+    {
+        pthread_mutex_unlock(&dedup->lock);
+        return SWICC_RET_ERROR;
+    }
+    tree_new->dedup = dedup;
+    tree_new->ref_count = 1U;
+    memmove(&dedup->tree[lo + 1U], &dedup->tree[lo],
+            (dedup->tree_count - lo) * sizeof(*dedup->tree));
+    dedup->tree[lo] = tree_new;
+    dedup->tree_count += 1U;
+    dedup->len_held += tree->len;
+    dedup->len_ref += tree->len;
+    pthread_mutex_unlock(&dedup->lock);
+    *dedup_tree = tree_new;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_disk_dedup_tree_put(swicc_disk_dedup_tree_st *const dedup_tree)
+{
+    if (dedup_tree == NULL)
+    {
+        return;
+    }
+    swicc_disk_dedup_st *const dedup = dedup_tree->dedup;
+    pthread_mutex_lock(&dedup->lock);
+    dedup->len_ref -= dedup_tree->tree.len;
+    dedup_tree->ref_count -= 1U;
+    if (dedup_tree->ref_count > 0U)
+    {
+        pthread_mutex_unlock(&dedup->lock);
+        return;
+    }
+    for (uint32_t tree_idx = 0U; tree_idx < dedup->tree_count; ++tree_idx)
+    {
+        if (dedup->tree[tree_idx] == dedup_tree)
+        {
+            memmove(&dedup->tree[tree_idx], &dedup->tree[tree_idx + 1U],
+                    (dedup->tree_count - tree_idx - 1U) *
+                        sizeof(*dedup->tree));
+            dedup->tree_count -= 1U;
+            break;
+        }
+    }
+    dedup->len_held -= dedup_tree->tree.len;
+    pthread_mutex_unlock(&dedup->lock);
+    dedup_tree_free(dedup_tree);
+}
+
+swicc_ret_et swicc_disk_dedup_extent_get(
+    swicc_disk_dedup_st *const dedup, uint8_t const *const data,
+    uint32_t const len, swicc_disk_dedup_extent_st **const extent)
+{
+    if (dedup == NULL || (data == NULL && len > 0U) || extent == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t key = swicc_crc32c(0U, (uint8_t const *)&len, sizeof(len));
+    key = swicc_crc32c(key, data, len);
+
+    pthread_mutex_lock(&dedup->lock);
+    uint32_t const lo = dedup_extent_find(dedup, key);
+    /* Different data can have the same checksum. */
+    for (uint32_t extent_idx = lo; extent_idx < dedup->extent_count &&
+                                   dedup->extent[extent_idx]->key == key;
+         ++extent_idx)
+    {
+        swicc_disk_dedup_extent_st *const extent_cur =
+            dedup->extent[extent_idx];
+        if (extent_cur->len == len &&
+            (len == 0U || memcmp(extent_cur->data, data, len) == 0))
+        {
+            extent_cur->ref_count += 1U;
+            dedup->extent_len_ref += len;
+            pthread_mutex_unlock(&dedup->lock);
+            *extent = extent_cur;
+            return SWICC_RET_SUCCESS;
+        }
+    }
+
+    if (dedup->extent_count >= dedup->extent_count_max)
+    {
+        uint32_t const count_max_new =
+            dedup->extent_count_max + DEDUP_EXTENT_COUNT_RESIZE;
+        swicc_disk_dedup_extent_st **const extent_arr_new =
+            swicc_alloc_realloc(dedup->alloc, dedup->extent,
+                                dedup->extent_count_max *
+                                    sizeof(*extent_arr_new),
+                                count_max_new * sizeof(*extent_arr_new));
+        if (extent_arr_new == NULL)
+        {
+            pthread_mutex_unlock(&dedup->lock);
+            return SWICC_RET_ERROR;
+        }
+        dedup->extent = extent_arr_new;
+        dedup->extent_count_max = count_max_new;
+    }
+    swicc_disk_dedup_extent_st *const extent_new =
+        swicc_alloc_malloc(dedup->alloc, sizeof(*extent_new));
+    uint8_t *const data_new = dedup_copy(dedup->alloc, data, len);
+    if (extent_new == NULL || data_new == NULL)
+    {
+        swicc_alloc_free(dedup->alloc, extent_new);
+        swicc_alloc_free(dedup->alloc, data_new);
+        pthread_mutex_unlock(&dedup->lock);
+        return SWICC_RET_ERROR;
+    }
+    *extent_new = (swicc_disk_dedup_extent_st){
+        .dedup = dedup,
+        .key = key,
+        .ref_count = 1U,
+        .len = len,
+        .data = data_new,
+    };
+    memmove(&dedup->extent[lo + 1U], &dedup->extent[lo],
+            (dedup->extent_count - lo) * sizeof(*dedup->extent));
+    dedup->extent[lo] = extent_new;
+    dedup->extent_count += 1U;
+    dedup->extent_len_held += len;
+    dedup->extent_len_ref += len;
+    pthread_mutex_unlock(&dedup->lock);
+    *extent = extent_new;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_disk_dedup_extent_put(swicc_disk_dedup_extent_st *const extent)
+{
+    if (extent == NULL)
+    {
+        return;
+    }
+    swicc_disk_dedup_st *const dedup = extent->dedup;
+    pthread_mutex_lock(&dedup->lock);
+    dedup->extent_len_ref -= extent->len;
+    extent->ref_count -= 1U;
+    if (extent->ref_count > 0U)
+    {
+        pthread_mutex_unlock(&dedup->lock);
+        return;
+    }
+    /* The extent sits among the ones with the same key. */
+    for (uint32_t extent_idx = dedup_extent_find(dedup, extent->key);
+         extent_idx < dedup->extent_count; ++extent_idx)
+    {
+        if (dedup->extent[extent_idx] == extent)
+        {
+            memmove(&dedup->extent[extent_idx],
+                    &dedup->extent[extent_idx + 1U],
+                    (dedup->extent_count - extent_idx - 1U) *
+                        sizeof(*dedup->extent));
+            dedup->extent_count -= 1U;
+            break;
+        }
+    }
+    dedup->extent_len_held -= extent->len;
+    pthread_mutex_unlock(&dedup->lock);
+    dedup_extent_free(dedup->alloc, extent);
+}
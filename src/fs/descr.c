@@ -0,0 +1,191 @@
+#include "disk_internal.h"
+#include <string.h>
+#include <swicc/swicc.h>
+
+/* Descriptors are collected here and only attached to the tree when done. */
+typedef struct descr_rebuild_cb_userdata_s
+{
+    swicc_disk_descr_st *descr;
+    uint32_t count;
+    uint32_t count_max;
+} descr_rebuild_cb_userdata_st;
+
+/**
+ * @brief Callback used when rebuilding the file descriptors. It receives files
+ * (in order of increasing offset) and appends a descriptor for each of them.
+ * @param tree
+ * @param file
+ * @param userdata This must point to the userdata struct.
+ * @return Return code.
+ */
+static swicc_disk_file_foreach_cb descr_rebuild_cb;
+static swicc_ret_et descr_rebuild_cb(swicc_disk_tree_st *const tree,
+                                     swicc_fs_file_st *const file,
+                                     void *const userdata)
+{
+    descr_rebuild_cb_userdata_st *const ud = userdata;
+    if (ud->count >= ud->count_max)
+    {
+        uint32_t const count_max_new =
+            ud->count_max == 0U ? SWICC_DISK_LUT_COUNT_START
+                                : ud->count_max * 2U;
+        swicc_disk_descr_st *const descr_new = swicc_alloc_realloc(
+            tree->alloc, ud->descr, ud->count_max * sizeof(*descr_new),
+            count_max_new * sizeof(*descr_new));
+        if (descr_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        ud->descr = descr_new;
+        ud->count_max = count_max_new;
+    }
+
+    /**
+     * The parent was visited before its children so it is already in the
+     * (sorted) array. The root is its own parent.
+     */
+    uint32_t const offset_parent =
+        file->hdr_item.offset_trel - file->hdr_item.offset_prel;
+    uint32_t parent_idx = ud->count;
+    if (file->hdr_item.offset_prel != 0U)
+    {
+        uint32_t start = 0U;
+        uint32_t end = ud->count;
+        while (start < end)
+        {
+            uint32_t const mid = (start + end) / 2U;
+            if (ud->descr[mid].offset_trel < offset_parent)
+            {
+                start = mid + 1U;
+            }
+            else
+            {
+                end = mid;
+            }
+        }
+        if (start >= ud->count || ud->descr[start].offset_trel != offset_parent)
+        {
+            return SWICC_RET_ERROR;
+        }
+        parent_idx = start;
+    }
+
+    uint8_t rcrd_size = 0U;
+    if (file->hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_LINEARFIXED)
+    {
+        rcrd_size = file->hdr_spec.ef_linearfixed.rcrd_size;
+    }
+    else if (file->hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
+    {
+        rcrd_size = file->hdr_spec.ef_cyclic.rcrd_size;
+    }
+    ud->descr[ud->count++] = (swicc_disk_descr_st){
+        .offset_trel = file->hdr_item.offset_trel,
+        .offset_prel = file->hdr_item.offset_prel,
+        .size = file->hdr_item.size,
+        .parent_idx = parent_idx,
+        .id = file->hdr_file.id,
+        .sid = file->hdr_file.sid,
+        /* Safe casts since both enums have fewer than 256 members. */
+        .type = (uint8_t)file->hdr_item.type,
+        .lcs = (uint8_t)file->hdr_item.lcs,
+        .rcrd_size = rcrd_size,
+    };
+    return SWICC_RET_SUCCESS;
+}
+
+typedef struct descr_foreach_cb_userdata_s
+{
+    descr_rebuild_cb_userdata_st descr;
+    swicc_disk_file_foreach_cb *cb;
+} descr_foreach_cb_userdata_st;
+static swicc_disk_file_foreach_cb descr_foreach_cb;
+static swicc_ret_et descr_foreach_cb(swicc_disk_tree_st *const tree,
+                                     swicc_fs_file_st *const file,
+                                     void *const userdata)
+{
+    descr_foreach_cb_userdata_st *const ud = userdata;
+    swicc_ret_et const ret = descr_rebuild_cb(tree, file, &ud->descr);
+    if (ret != SWICC_RET_SUCCESS || ud->cb == NULL)
+    {
+        return ret;
+    }
+    return ud->cb(tree, file, NULL);
+}
+
+swicc_ret_et swicc_disk_descr_foreach(swicc_disk_tree_st *const tree,
+                                      swicc_disk_file_foreach_cb *const cb)
+{
+    /* Files must be parsed from the raw headers while collecting. */
+    if (!tree->shared)
+    {
+        swicc_alloc_free(tree->alloc, tree->descr);
+    }
+    tree->descr = NULL;
+    tree->descr_count = 0U;
+    swicc_alloc_free(tree->alloc, tree->access);
+    tree->access = NULL;
+
+    swicc_fs_file_st file_root;
+    swicc_ret_et ret = swicc_disk_tree_file_root(tree, &file_root);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        return ret;
+    }
+    descr_foreach_cb_userdata_st userdata = {.cb = cb};
+    ret = swicc_disk_file_foreach(tree, &file_root, descr_foreach_cb,
+                                  &userdata, true);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        swicc_alloc_free(tree->alloc, userdata.descr.descr);
+        return ret;
+    }
+    tree->descr = userdata.descr.descr;
+    tree->descr_count = userdata.descr.count;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_descr_rebuild(swicc_disk_tree_st *const tree)
+{
+    if (tree == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (tree->shared)
+    {
+        /* The descriptors are shared with the tree of the base disk. */
+        return SWICC_RET_ERROR;
+    }
+    return swicc_disk_descr_foreach(tree, NULL);
+}
+
+swicc_ret_et swicc_disk_descr_lookup(swicc_disk_tree_st const *const tree,
+                                     uint32_t const offset_trel,
+                                     uint32_t *const descr_idx)
+{
+    if (tree == NULL || descr_idx == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t start = 0U;
+    uint32_t end = tree->descr_count;
+    while (start < end)
+    {
+        uint32_t const mid = (start + end) / 2U;
+        if (tree->descr[mid].offset_trel < offset_trel)
+        {
+            start = mid + 1U;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+    if (start >= tree->descr_count ||
+        tree->descr[start].offset_trel != offset_trel)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+    *descr_idx = start;
+    return SWICC_RET_SUCCESS;
+}
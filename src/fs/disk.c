@@ -1,77 +1,49 @@
+#include "disk_internal.h"
 #include "swicc/fs/common.h"
+#include <fcntl.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <swicc/swicc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-/**
- * Used when creating LUTs. The 'start' count determines that size of the
- * smallest created LUT (measured in entry counts). If the 'start' count is too
- * small, the LUT will be resized by the 'resize' amount.
- */
-#define LUT_COUNT_START 64U
-#define LUT_COUNT_RESIZE 8U
+uint32_t swicc_disk_check_fnv1a(uint32_t hash, uint8_t const *const buf,
+                                uint32_t const len)
+{
+    for (uint32_t byte_idx = 0U; byte_idx < len; ++byte_idx)
+    {
+        hash = (hash ^ buf[byte_idx]) * 16777619U;
+    }
+    return hash;
+}
 
 /**
- * @brief Insert an entry into a LUT (resizes the LUT if needed).
- * @param lut
- * @param entry_item1 This will be placed in buffer 1 and must have size equal
- * to the item size 1.
- * @param entry_item2 This will be placed in buffer 2 and must have size equal
- * to the item size 2.
+ * @brief Load a disk file with compressed trees by decompressing all of them
+ * right away.
+ * @param disk
+ * @param disk_path
  * @return Return code.
  */
-static swicc_ret_et lut_insert(swicc_disk_lut_st *const lut,
-                               uint8_t const *const entry_item1,
-                               uint8_t const *const entry_item2)
-{
-    /* Check if need to resize the LUT to fit more items. */
-    if (lut->count >= lut->count_max)
-    {
-        lut->count_max += LUT_COUNT_RESIZE;
-        uint8_t *const buf1_new =
-            realloc(lut->buf1, lut->count_max * lut->size_item1);
-        uint8_t *const buf2_new =
-            realloc(lut->buf2, lut->count_max * lut->size_item2);
-        if (buf1_new == NULL || buf2_new == NULL)
-        {
-            free(buf1_new);
-            free(buf2_new);
-            return SWICC_RET_ERROR;
-        }
-        lut->buf1 = buf1_new;
-        lut->buf2 = buf2_new;
+static swicc_ret_et disk_load_lz4(swicc_disk_st *const disk,
+                                  char const *const disk_path)
+{
+    swicc_ret_et ret = swicc_disk_load_lazy(disk, disk_path);
+    for (swicc_disk_tree_st *tree = disk->root;
+         ret == SWICC_RET_SUCCESS && tree != NULL; tree = tree->next)
+    {
+        ret = swicc_disk_tree_load(tree);
     }
-
-    /**
-     * Insert such that item 1 of all entries are arranged in increasing order.
-     */
-    uint32_t start = 0U;
-    uint32_t end = lut->count;
-    uint32_t mid;
-    while (start < end)
+    if (ret != SWICC_RET_SUCCESS)
     {
-        mid = (start + end) / 2U;
-        /* value_mid < value_new */
-        if (memcmp(&lut->buf1[lut->size_item1 * mid], entry_item1,
-                   lut->size_item1) < 0)
-        {
-            start = mid + 1U;
-        }
-        else
-        {
-            end = mid;
-        }
+        swicc_disk_root_empty(disk);
+        return ret;
     }
-    memmove(&lut->buf1[lut->size_item1 * (start + 1U)],
-            &lut->buf1[lut->size_item1 * (start)],
-            lut->size_item1 * (lut->count - start));
-    memmove(&lut->buf2[lut->size_item2 * (start + 1U)],
-            &lut->buf2[lut->size_item2 * (start)],
-            lut->size_item2 * (lut->count - start));
-    memcpy(&lut->buf1[lut->size_item1 * start], entry_item1, lut->size_item1);
-    memcpy(&lut->buf2[lut->size_item2 * start], entry_item2, lut->size_item2);
-    lut->count += 1U;
+    /* Nothing gets read from the disk file anymore. */
+    close(disk->lazy_fd);
+    disk->lazy = false;
     return SWICC_RET_SUCCESS;
 }
 
@@ -90,9 +62,17 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
         return ret;
     }
 
-    /* Clear disk so that all the members have a known initial state. */
+    /**
+     * Clear disk so that all the members have a known initial state. The
+     * allocator is chosen by the caller so it is kept.
+     */
+    swicc_alloc_st const *const alloc = disk->alloc;
     memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
 
+    uint8_t *index = NULL;
+    uint32_t index_len = 0U;
+    bool lz4_has = false;
     FILE *f = fopen(disk_path, "rb");
     if (!(f == NULL))
     {
@@ -105,11 +85,20 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
                 {
                     uint8_t const magic_expected[SWICC_DISK_MAGIC_LEN] =
                         SWICC_DISK_MAGIC;
+                    uint8_t const magic_index[SWICC_DISK_MAGIC_LEN] =
+                        SWICC_DISK_MAGIC_INDEX;
+                    uint8_t const magic_lz4[SWICC_DISK_MAGIC_LEN] =
+                        SWICC_DISK_MAGIC_LZ4;
                     uint8_t magic[SWICC_DISK_MAGIC_LEN];
                     if (fread(&magic, SWICC_DISK_MAGIC_LEN, 1U, f) == 1U)
                     {
-                        if (memcmp(magic, magic_expected,
-                                   SWICC_DISK_MAGIC_LEN) == 0)
+                        lz4_has = memcmp(magic, magic_lz4,
+                                         SWICC_DISK_MAGIC_LEN) == 0;
+                        bool const index_has =
+                            memcmp(magic, magic_index, SWICC_DISK_MAGIC_LEN) ==
+                            0;
+                        if (index_has || memcmp(magic, magic_expected,
+                                                SWICC_DISK_MAGIC_LEN) == 0)
                         {
                             /**
                              * Parse the root (forest of trees) contained in the
@@ -119,16 +108,24 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
                             swicc_ret_et ret_item = SWICC_RET_SUCCESS;
                             uint32_t data_idx = SWICC_DISK_MAGIC_LEN;
                             uint8_t tree_idx = 0U;
+                            if (index_has)
+                            {
+                                ret_item = swicc_disk_index_fread(
+                                    f, &index, &index_len);
+                                data_idx += index_len;
+                            }
                             /**
                              * Assume the file length matches the disk length
                              * (no extra bytes).
                              */
-                            while (data_idx < f_len)
+                            while (ret_item == SWICC_RET_SUCCESS &&
+                                   data_idx < f_len)
                             {
                                 /* Check if creating the first tree. */
                                 if (tree == NULL)
                                 {
-                                    tree = malloc(sizeof(*tree));
+                                    tree = swicc_alloc_malloc(alloc,
+                                                              sizeof(*tree));
                                     if (tree == NULL)
                                     {
                                         ret_item = SWICC_RET_ERROR;
@@ -138,7 +135,8 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
                                 }
                                 else
                                 {
-                                    tree->next = malloc(sizeof(*tree));
+                                    tree->next = swicc_alloc_malloc(
+                                        alloc, sizeof(*tree));
                                     if (tree->next == NULL)
                                     {
                                         ret_item = SWICC_RET_ERROR;
@@ -147,6 +145,7 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
                                     tree = tree->next;
                                 }
                                 memset(tree, 0U, sizeof(*tree));
+                                tree->alloc = alloc;
 
                                 /* Got a header. */
                                 swicc_fs_item_hdr_raw_st item_hdr_raw;
@@ -180,7 +179,8 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
                                  * Know the size of the item so can allocate the
                                  * exact amount of space needed.
                                  */
-                                tree->buf = malloc(item_hdr.size);
+                                tree->buf =
+                                    swicc_alloc_malloc(alloc, item_hdr.size);
                                 if (tree->buf == NULL)
                                 {
                                     ret_item = SWICC_RET_ERROR;
@@ -233,31 +233,178 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
             ret = SWICC_RET_ERROR;
         }
     }
+    if (lz4_has)
+    {
+        return disk_load_lz4(disk, disk_path);
+    }
+    if (ret == SWICC_RET_SUCCESS && index != NULL)
+    {
+        ret = swicc_disk_index_tree_check(disk, index, index_len);
+    }
+    /* A persisted index is only an optimization so fall back to rebuilding. */
+    if (ret == SWICC_RET_SUCCESS &&
+        (index == NULL ||
+         swicc_disk_index_prs(disk, index, index_len) != SWICC_RET_SUCCESS))
+    {
+        ret = swicc_disk_lut_rebuild(disk);
+    }
+    free(index);
     if (ret != SWICC_RET_SUCCESS)
     {
         swicc_disk_root_empty(disk);
     }
-    else
+    return ret;
+}
+
+swicc_ret_et swicc_disk_load_mmap(swicc_disk_st *const disk,
+                                  char const *const disk_path)
+{
+    if (disk == NULL || disk_path == NULL)
     {
-        /* Create all the LUTs. */
-        swicc_disk_tree_st *tree = disk->root;
-        if (tree == NULL)
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->root != NULL)
+    {
+        /* Get rid of the current disk first before loading a new one. */
+        return SWICC_RET_ERROR;
+    }
+
+    /**
+     * Clear disk so that all the members have a known initial state. The
+     * allocator is chosen by the caller so it is kept.
+     */
+    swicc_alloc_st const *const alloc = disk->alloc;
+    memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
+
+    int32_t const fd = open(disk_path, O_RDONLY);
+    if (fd < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    struct stat f_stat;
+    if (fstat(fd, &f_stat) != 0 || f_stat.st_size <= SWICC_DISK_MAGIC_LEN ||
+        f_stat.st_size > UINT32_MAX)
+    {
+        close(fd);
+        return SWICC_RET_ERROR;
+    }
+    /* Safe cast since the size was checked to fit in uint32 range. */
+    uint32_t const f_len = (uint32_t)f_stat.st_size;
+    /**
+     * A private mapping can be written to (copy-on-write) even though the file
+     * was opened read-only.
+     */
+    void *const map =
+        mmap(NULL, f_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    /* The mapping stays valid after closing the descriptor. */
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        return SWICC_RET_ERROR;
+    }
+    disk->map = map;
+    disk->map_size = f_len;
+
+    uint8_t const magic_expected[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC;
+    uint8_t const magic_index[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_INDEX;
+    uint8_t const magic_lz4[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_LZ4;
+    if (memcmp(disk->map, magic_lz4, SWICC_DISK_MAGIC_LEN) == 0)
+    {
+        /* Compressed trees have to be decompressed into memory anyway. */
+        swicc_disk_root_empty(disk);
+        return disk_load_lz4(disk, disk_path);
+    }
+    bool const index_has =
+        memcmp(disk->map, magic_index, SWICC_DISK_MAGIC_LEN) == 0;
+    if (!index_has &&
+        memcmp(disk->map, magic_expected, SWICC_DISK_MAGIC_LEN) != 0)
+    {
+        swicc_disk_root_empty(disk);
+        return SWICC_RET_ERROR;
+    }
+
+    /* The index section (if any) is used directly from the mapping. */
+    uint8_t const *index = NULL;
+    uint32_t index_len = 0U;
+    if (index_has)
+    {
+        swicc_disk_index_hdr_raw_st hdr;
+        if (f_len - SWICC_DISK_MAGIC_LEN < sizeof(hdr))
+        {
+            swicc_disk_root_empty(disk);
+            return SWICC_RET_ERROR;
+        }
+        memcpy(&hdr, &disk->map[SWICC_DISK_MAGIC_LEN], sizeof(hdr));
+        if (hdr.size < sizeof(hdr) || hdr.size > f_len - SWICC_DISK_MAGIC_LEN)
+        {
+            swicc_disk_root_empty(disk);
+            return SWICC_RET_ERROR;
+        }
+        index = &disk->map[SWICC_DISK_MAGIC_LEN];
+        index_len = hdr.size;
+    }
+
+    /* Parse the root (forest of trees) contained in the file. */
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    swicc_disk_tree_st **tree_next = &disk->root;
+    uint32_t data_idx = SWICC_DISK_MAGIC_LEN + index_len;
+    uint8_t tree_idx = 0U;
+    while (data_idx < f_len)
+    {
+        swicc_fs_item_hdr_raw_st item_hdr_raw;
+        swicc_fs_item_hdr_st item_hdr;
+        if (f_len - data_idx < sizeof(item_hdr_raw))
         {
             ret = SWICC_RET_ERROR;
+            break;
         }
-        while (tree != NULL)
+        memcpy(&item_hdr_raw, &disk->map[data_idx], sizeof(item_hdr_raw));
+        swicc_fs_item_hdr_prs(&item_hdr_raw, 0U, &item_hdr);
+        /**
+         * Make sure all trees are valid, the first one is the MF, and all other
+         * ones are ADFs.
+         */
+        if (item_hdr.type == SWICC_FS_ITEM_TYPE_INVALID ||
+            (tree_idx == 0 && item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_MF) ||
+            (tree_idx != 0 && item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_ADF) ||
+            item_hdr.size < sizeof(item_hdr_raw) ||
+            item_hdr.size > f_len - data_idx)
         {
-            ret = swicc_disk_lutsid_rebuild(disk, tree);
-            if (ret != SWICC_RET_SUCCESS)
-            {
-                break;
-            }
-            tree = tree->next;
+            ret = SWICC_RET_ERROR;
+            break;
         }
-        if (ret == SWICC_RET_SUCCESS)
+
+        swicc_disk_tree_st *const tree =
+            swicc_alloc_malloc(alloc, sizeof(*tree));
+        if (tree == NULL)
         {
-            ret = swicc_disk_lutid_rebuild(disk);
+            ret = SWICC_RET_ERROR;
+            break;
         }
+        memset(tree, 0U, sizeof(*tree));
+        tree->alloc = alloc;
+        tree->buf = &disk->map[data_idx];
+        tree->size = item_hdr.size;
+        tree->len = item_hdr.size;
+        *tree_next = tree;
+        tree_next = &tree->next;
+
+        data_idx += tree->len;
+        /* Unsafe cast that relies on there being fewer than 256 trees. */
+        tree_idx = (uint8_t)(tree_idx + 1U);
+    }
+
+    if (ret == SWICC_RET_SUCCESS && index != NULL)
+    {
+        ret = swicc_disk_index_tree_check(disk, index, index_len);
+    }
+    /* A persisted index is only an optimization so fall back to rebuilding. */
+    if (ret == SWICC_RET_SUCCESS &&
+        (index == NULL ||
+         swicc_disk_index_prs(disk, index, index_len) != SWICC_RET_SUCCESS))
+    {
+        ret = swicc_disk_lut_rebuild(disk);
     }
     if (ret != SWICC_RET_SUCCESS)
     {
@@ -266,6 +413,96 @@ swicc_ret_et swicc_disk_load(swicc_disk_st *const disk,
     return ret;
 }
 
+swicc_ret_et swicc_disk_overlay_create(swicc_disk_st *const disk,
+                                       swicc_disk_st const *const disk_base)
+{
+    if (disk == NULL || disk_base == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->root != NULL || disk_base->root == NULL ||
+        disk_base->lutid_tree_count == 0U)
+    {
+        /* Get rid of the current disk first before creating a new one. */
+        return SWICC_RET_ERROR;
+    }
+    /**
+     * Trees can only be shared once they are in memory. Private copies of
+     * files are not taken along so trees holding any can't be shared.
+     */
+    for (uint32_t tree_idx = 0U; tree_idx < disk_base->lutid_tree_count;
+         ++tree_idx)
+    {
+        if (swicc_disk_tree_load(disk_base->lutid_tree[tree_idx]) !=
+                SWICC_RET_SUCCESS ||
+            disk_base->lutid_tree[tree_idx]->overlay_count > 0U)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    /**
+     * Clear disk so that all the members have a known initial state. The
+     * allocator is chosen by the caller so it is kept.
+     */
+    swicc_alloc_st const *const alloc = disk->alloc;
+    memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
+    disk->base = disk_base;
+    disk->lutid_tree = swicc_alloc_malloc(
+        alloc, disk_base->lutid_tree_count * sizeof(swicc_disk_tree_st *));
+    if (disk->lutid_tree == NULL)
+    {
+        memset(disk, 0U, sizeof(*disk));
+        disk->alloc = alloc;
+        return SWICC_RET_ERROR;
+    }
+    disk->lutid_tree_count = disk_base->lutid_tree_count;
+    /* These LUTs refer to trees by index so they can be shared as-is. */
+    disk->lutid = disk_base->lutid;
+    disk->lutname = disk_base->lutname;
+
+    /**
+     * Only the tree structs are private, the buffers and SID LUTs they point to
+     * belong to the base.
+     */
+    swicc_disk_tree_st **tree_next = &disk->root;
+    for (uint32_t tree_idx = 0U; tree_idx < disk->lutid_tree_count; ++tree_idx)
+    {
+        swicc_disk_tree_st *const tree =
+            swicc_alloc_malloc(alloc, sizeof(*tree));
+        if (tree == NULL)
+        {
+            swicc_disk_root_empty(disk);
+            return SWICC_RET_ERROR;
+        }
+        *tree = *disk_base->lutid_tree[tree_idx];
+        tree->alloc = alloc;
+        tree->next = NULL;
+        tree->shared = true;
+        tree->overlay = NULL;
+        tree->overlay_count = 0U;
+        tree->overlay_count_max = 0U;
+        /* The tree of the base keeps the tree of the store. */
+        tree->dedup = NULL;
+        tree->dirty = NULL;
+        tree->dirty_word_count = 0U;
+        /* The checksum of the base still holds but its pages are its own. */
+        tree->check_page = NULL;
+        tree->check_page_count = 0U;
+        tree->check_stale = NULL;
+        tree->dato_idx = NULL;
+        tree->dato_idx_count = 0U;
+        tree->fcp = NULL;
+        tree->fcp_count = 0U;
+        tree->access = NULL;
+        disk->lutid_tree[tree_idx] = tree;
+        *tree_next = tree;
+        tree_next = &tree->next;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
 void swicc_disk_unload(swicc_disk_st *const disk)
 {
     if (disk == NULL)
@@ -277,38 +514,184 @@ void swicc_disk_unload(swicc_disk_st *const disk)
         return;
     }
 
+    /* Nothing can be done about a failing sync when unloading. */
+    (void)swicc_disk_journal_close(disk);
+
     /* This also frees the SID LUT of all trees. */
     swicc_disk_root_empty(disk);
 
     swicc_disk_lutid_empty(disk);
+    swicc_alloc_st const *const alloc = disk->alloc;
     memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
 }
 
-swicc_ret_et swicc_disk_save(swicc_disk_st const *const disk,
-                             char const *const disk_path)
+/**
+ * @brief Write a tree to a file with all the files of the overlay (if any) in
+ * place of the ones in the tree buffer.
+ * @param[in] tree
+ * @param[in] f
+ * @return Return code.
+ */
+static swicc_ret_et disk_tree_write(swicc_disk_tree_st const *const tree,
+                                    FILE *const f)
+{
+    uint32_t offset = 0U;
+    for (uint32_t ovl_idx = 0U; ovl_idx < tree->overlay_count; ++ovl_idx)
+    {
+        swicc_disk_overlay_file_st const *const ovl = &tree->overlay[ovl_idx];
+        /* A private record head replaces the byte right before the data. */
+        uint32_t const base_end =
+            ovl->data_offset_trel - (ovl->rcrd_head_own ? 1U : 0U);
+        if ((base_end > offset &&
+             fwrite(&tree->buf[offset], base_end - offset, 1U, f) != 1U) ||
+            (ovl->rcrd_head_own && fwrite(&ovl->rcrd_head, 1U, 1U, f) != 1U) ||
+            (ovl->data_size > 0U &&
+             fwrite(ovl->data, ovl->data_size, 1U, f) != 1U))
+        {
+            return SWICC_RET_ERROR;
+        }
+        offset = ovl->data_offset_trel + ovl->data_size;
+    }
+    if (tree->len > offset &&
+        fwrite(&tree->buf[offset], tree->len - offset, 1U, f) != 1U)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Compress all trees of a disk (as seen through their overlay).
+ * @param disk
+ * @param tree_lz4 Will receive an allocated array with one entry per tree.
+ * @param tree_count Will receive the number of trees.
+ * @return Return code. On failure, the array (if any) must still be freed.
+ */
+static swicc_ret_et
+disk_tree_lz4_create(swicc_disk_st const *const disk,
+                     swicc_disk_tree_lz4_st **const tree_lz4,
+                     uint32_t *const tree_count)
+{
+    uint32_t count = 0U;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        count += 1U;
+    }
+    /* Entries that are not filled in stay empty so they can all be freed. */
+    *tree_lz4 = calloc(count, sizeof(swicc_disk_tree_lz4_st));
+    if (*tree_lz4 == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    *tree_count = count;
+    uint32_t tree_idx = 0U;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        swicc_disk_tree_lz4_st *const entry = &(*tree_lz4)[tree_idx++];
+        uint8_t *const buf = malloc(tree->len);
+        if (buf == NULL ||
+            swicc_disk_tree_read(tree, 0U, tree->len, buf) != SWICC_RET_SUCCESS)
+        {
+            free(buf);
+            return SWICC_RET_ERROR;
+        }
+
+        /* A tree which does not get smaller is stored as it is. */
+        entry->buf = buf;
+        entry->len = tree->len;
+        uint8_t *const buf_lz4 = malloc(tree->len);
+        uint32_t len_lz4;
+        if (buf_lz4 != NULL &&
+            swicc_lz4_compress(buf, tree->len, buf_lz4, tree->len - 1U,
+                               &len_lz4) == SWICC_RET_SUCCESS)
+        {
+            free(buf);
+            entry->buf = buf_lz4;
+            entry->len = len_lz4;
+        }
+        else
+        {
+            free(buf_lz4);
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Save a disk with or without a persisted index.
+ * @param disk
+ * @param disk_path
+ * @param index If the index section shall be saved.
+ * @param lz4 If the trees shall be compressed (implies an index).
+ * @return Return code.
+ */
+static swicc_ret_et disk_save(swicc_disk_st const *const disk,
+                              char const *const disk_path, bool const index,
+                              bool const lz4)
 {
     if (disk == NULL || disk_path == NULL)
     {
         return SWICC_RET_PARAM_BAD;
     }
 
+    /**
+     * Trees that were not read yet are read before opening the file for
+     * writing since it may be the very file they would be read from.
+     */
+    for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        if (swicc_disk_tree_load(tree) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    /* Compressing first gives the lengths the index has to hold. */
+    swicc_disk_tree_lz4_st *tree_lz4 = NULL;
+    uint32_t tree_lz4_count = 0U;
     swicc_ret_et ret = SWICC_RET_ERROR;
-    FILE *f = fopen(disk_path, "wb");
+    FILE *f = NULL;
+    if (!lz4 || disk_tree_lz4_create(disk, &tree_lz4, &tree_lz4_count) ==
+                    SWICC_RET_SUCCESS)
+    {
+        f = fopen(disk_path, "wb");
+    }
     if (f != NULL)
     {
-        uint8_t magic[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC;
-        if (fwrite(magic, SWICC_DISK_MAGIC_LEN, 1U, f) == 1U)
+        uint8_t const magic_plain[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC;
+        uint8_t const magic_index[SWICC_DISK_MAGIC_LEN] =
+            SWICC_DISK_MAGIC_INDEX;
+        uint8_t const magic_lz4[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_LZ4;
+        if (fwrite(lz4 ? magic_lz4 : (index ? magic_index : magic_plain),
+                   SWICC_DISK_MAGIC_LEN, 1U, f) == 1U &&
+            (!(index || lz4) ||
+             swicc_disk_index_write(disk, f, tree_lz4) == SWICC_RET_SUCCESS))
         {
             swicc_disk_tree_st *tree = disk->root;
+            uint32_t tree_idx = 0U;
             while (tree != NULL)
             {
-                if (fwrite(tree->buf, tree->len, 1U, f) != 1U)
+                if (lz4)
+                {
+                    ret = fwrite(tree_lz4[tree_idx].buf,
+                                 tree_lz4[tree_idx].len, 1U, f) == 1U
+                              ? SWICC_RET_SUCCESS
+                              : SWICC_RET_ERROR;
+                }
+                else
+                {
+                    ret = disk_tree_write(tree, f);
+                }
+                if (ret != SWICC_RET_SUCCESS)
                 {
-                    ret = SWICC_RET_ERROR;
                     break;
                 }
                 tree = tree->next;
-                ret = SWICC_RET_SUCCESS;
+                tree_idx += 1U;
             }
         }
         if (fclose(f) != 0)
@@ -316,9 +699,32 @@ swicc_ret_et swicc_disk_save(swicc_disk_st const *const disk,
             ret = SWICC_RET_ERROR;
         }
     }
+    for (uint32_t tree_idx = 0U; tree_idx < tree_lz4_count; ++tree_idx)
+    {
+        free(tree_lz4[tree_idx].buf);
+    }
+    free(tree_lz4);
     return ret;
 }
 
+swicc_ret_et swicc_disk_save(swicc_disk_st const *const disk,
+                             char const *const disk_path)
+{
+    return disk_save(disk, disk_path, false, false);
+}
+
+swicc_ret_et swicc_disk_save_index(swicc_disk_st const *const disk,
+                                   char const *const disk_path)
+{
+    return disk_save(disk, disk_path, true, false);
+}
+
+swicc_ret_et swicc_disk_save_lz4(swicc_disk_st const *const disk,
+                                 char const *const disk_path)
+{
+    return disk_save(disk, disk_path, true, true);
+}
+
 swicc_ret_et swicc_disk_file_foreach(swicc_disk_tree_st *const tree,
                                      swicc_fs_file_st *const file,
                                      swicc_disk_file_foreach_cb *const cb,
@@ -404,7 +810,8 @@ swicc_ret_et swicc_disk_tree_iter(swicc_disk_st const *const disk,
     {
         return SWICC_RET_PARAM_BAD;
     }
-    if (disk->root != NULL)
+    if (disk->root != NULL &&
+        swicc_disk_tree_load(disk->root) == SWICC_RET_SUCCESS)
     {
         tree_iter->tree = disk->root;
         tree_iter->tree_idx = 0U;
@@ -422,6 +829,10 @@ swicc_ret_et swicc_disk_tree_iter_next(swicc_disk_tree_iter_st *const tree_iter,
     }
     if (tree_iter->tree->next != NULL)
     {
+        if (swicc_disk_tree_load(tree_iter->tree->next) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
         tree_iter->tree = tree_iter->tree->next;
         /* Unsafe cast that relies on there being fewer than 256 trees. */
         tree_iter->tree_idx = (uint8_t)(tree_iter->tree_idx + 1U);
@@ -459,334 +870,537 @@ swicc_ret_et swicc_disk_tree_iter_idx(swicc_disk_tree_iter_st *const tree_iter,
     return SWICC_RET_SUCCESS;
 }
 
-void swicc_disk_root_empty(swicc_disk_st *const disk)
+/**
+ * @brief Drop the DO indexes of all files whose data overlaps a range of a
+ * tree.
+ * @param[in, out] tree
+ * @param[in] offset_trel Offset of the range in the tree.
+ * @param[in] len Length of the range.
+ */
+static void tree_dato_idx_drop(swicc_disk_tree_st *const tree,
+                               uint32_t const offset_trel, uint32_t const len)
 {
-    if (disk == NULL)
-    {
-        return;
-    }
-    swicc_disk_tree_st *tree = disk->root;
-    while (tree != NULL)
+    uint32_t dato_idx_keep = 0U;
+    for (uint32_t dato_idx = 0U; dato_idx < tree->dato_idx_count; ++dato_idx)
     {
-        if (tree->buf != NULL)
+        swicc_disk_dato_idx_st *const entry = &tree->dato_idx[dato_idx];
+        /* Compare as 64-bit to not overflow at the end of the tree. */
+        if ((uint64_t)entry->data_offset_trel + entry->data_size >
+                offset_trel &&
+            entry->data_offset_trel < (uint64_t)offset_trel + len)
         {
-            free(tree->buf);
+            swicc_dato_bertlv_idx_free(&entry->idx);
+        }
+        else
+        {
+            tree->dato_idx[dato_idx_keep++] = *entry;
         }
-
-        /* Free the SID LUT of this tree. */
-        swicc_disk_lutsid_empty(tree);
-
-        swicc_disk_tree_st *const tree_next = tree->next;
-        free(tree);
-        tree = tree_next;
     }
-    disk->root = NULL;
-    /* Since there will be no trees left, the ID LUT shall also be destroyed. */
-    swicc_disk_lutid_empty(disk);
+    tree->dato_idx_count = dato_idx_keep;
+    if (tree->dato_idx_count == 0U)
+    {
+        swicc_alloc_free(tree->alloc, tree->dato_idx);
+        tree->dato_idx = NULL;
+    }
 }
 
-void swicc_disk_lutsid_empty(swicc_disk_tree_st *const tree)
+/**
+ * @brief Drop the cached response templates of all files whose header overlaps
+ * a range of a tree.
+ * @param[in, out] tree
+ * @param[in] offset_trel Offset of the range in the tree.
+ * @param[in] len Length of the range.
+ */
+static void tree_fcp_drop(swicc_disk_tree_st *const tree,
+                          uint32_t const offset_trel, uint32_t const len)
 {
-    if (tree == NULL)
-    {
-        return;
-    }
-    swicc_disk_lut_st *lutsid = &tree->lutsid;
-    if (lutsid->buf1 != NULL)
+    uint32_t fcp_keep = 0U;
+    for (uint32_t fcp_idx = 0U; fcp_idx < tree->fcp_count; ++fcp_idx)
     {
-        free(lutsid->buf1);
+        swicc_disk_fcp_st *const entry = &tree->fcp[fcp_idx];
+        /* Compare as 64-bit to not overflow at the end of the tree. */
+        if ((uint64_t)entry->offset_trel + entry->hdr_size > offset_trel &&
+            entry->offset_trel < (uint64_t)offset_trel + len)
+        {
+            swicc_alloc_free(tree->alloc, entry->buf);
+        }
+        else
+        {
+            tree->fcp[fcp_keep++] = *entry;
+        }
     }
-    if (lutsid->buf2 != NULL)
+    tree->fcp_count = fcp_keep;
+    if (tree->fcp_count == 0U)
     {
-        free(lutsid->buf2);
+        swicc_alloc_free(tree->alloc, tree->fcp);
+        tree->fcp = NULL;
     }
-    memset(&tree->lutsid, 0U, sizeof(tree->lutsid));
 }
 
-void swicc_disk_lutid_empty(swicc_disk_st *const disk)
+/**
+ * @brief Free the copy of the data of a file in the overlay of a tree.
+ * @param tree
+ * @param ovl
+ */
+static void overlay_free(swicc_disk_tree_st const *const tree,
+                         swicc_disk_overlay_file_st *const ovl)
 {
-    if (disk == NULL)
+    if (ovl->extent != NULL)
     {
-        return;
+        swicc_disk_dedup_extent_put(ovl->extent);
+        ovl->extent = NULL;
     }
-    swicc_disk_lut_st *lutid = &disk->lutid;
-    if (lutid->buf1 != NULL)
+    else
     {
-        free(lutid->buf1);
+        swicc_alloc_free(tree->alloc, ovl->data);
     }
-    if (lutid->buf2 != NULL)
-    {
-        free(lutid->buf2);
-    }
-    memset(&disk->lutid, 0U, sizeof(disk->lutid));
+    ovl->data = NULL;
 }
 
-typedef struct lutid_rebuild_cb_userdata_s
-{
-    swicc_disk_lut_st *lut;
-    uint8_t tree_idx;
-} lutid_rebuild_cb_userdata_st;
 /**
- * @brief Callback used when rebuilding the ID LUT. It receives files and
- * inserts their info into the ID LUT.
+ * @brief Make the copy of the data of a file in the overlay of a tree private
+ * so it can be modified, i.e. copy it out of the extent it is shared through.
  * @param tree
- * @param file
- * @param userdata This must point to the userdata struct.
+ * @param ovl
  * @return Return code.
  */
-static swicc_disk_file_foreach_cb lutid_rebuild_cb;
-static swicc_ret_et lutid_rebuild_cb(swicc_disk_tree_st *const tree,
-                                     swicc_fs_file_st *const file,
-                                     void *const userdata)
+static swicc_ret_et overlay_own(swicc_disk_tree_st const *const tree,
+                                swicc_disk_overlay_file_st *const ovl)
 {
-    if (file->hdr_file.id == SWICC_FS_ID_MISSING)
+    if (ovl->extent == NULL)
     {
         return SWICC_RET_SUCCESS;
     }
-
-    /* Insert the ID + offset into the ID LUT. */
-    lutid_rebuild_cb_userdata_st const *const userdata_struct = userdata;
-    swicc_disk_lut_st *const lutid = userdata_struct->lut;
-    uint8_t entry_item1[sizeof(swicc_fs_id_kt)];
-    /**
-     * @note IDs are kept in big-endian inside the LUT so that they are sorted
-     * from MSB to LSB.
-     */
-    swicc_fs_id_kt const id_be = htobe16(file->hdr_file.id);
-    memcpy(entry_item1, &id_be, sizeof(swicc_fs_id_kt));
-    uint8_t entry_item2[lutid->size_item2];
-    memcpy(&entry_item2[0U], &file->hdr_item.offset_trel, sizeof(uint32_t));
-    memcpy(&entry_item2[sizeof(uint32_t)], &userdata_struct->tree_idx,
-           sizeof(uint8_t));
-    return lut_insert(lutid, entry_item1, entry_item2);
+    uint8_t *const data_new = swicc_alloc_malloc(
+        tree->alloc, ovl->data_size > 0U ? ovl->data_size : 1U);
+    if (data_new == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(data_new, ovl->data, ovl->data_size);
+    swicc_disk_dedup_extent_put(ovl->extent);
+    ovl->extent = NULL;
+    ovl->data = data_new;
+    return SWICC_RET_SUCCESS;
 }
 
-swicc_ret_et swicc_disk_lutid_rebuild(swicc_disk_st *const disk)
+void swicc_disk_root_empty(swicc_disk_st *const disk)
 {
     if (disk == NULL)
     {
-        return SWICC_RET_PARAM_BAD;
-    }
-    swicc_ret_et ret = SWICC_RET_ERROR;
-    /* Cleanup the old ID LUT before rebuilding it. */
-    swicc_disk_lutid_empty(disk);
-    disk->lutid.size_item1 = sizeof(swicc_fs_id_kt);
-    disk->lutid.size_item2 =
-        sizeof(uint32_t) + sizeof(uint8_t); /* Offset + tree index */
-    disk->lutid.count_max = LUT_COUNT_START;
-    disk->lutid.count = 0U;
-    disk->lutid.buf1 = malloc(disk->lutid.count_max * disk->lutid.size_item1);
-    disk->lutid.buf2 = malloc(disk->lutid.count_max * disk->lutid.size_item2);
-    if (disk->lutid.buf1 == NULL || disk->lutid.buf2 == NULL)
-    {
-        swicc_disk_lutid_empty(disk);
-        return SWICC_RET_ERROR;
+        return;
     }
-
     swicc_disk_tree_st *tree = disk->root;
-    uint8_t tree_idx = 0U;
     while (tree != NULL)
     {
-        lutid_rebuild_cb_userdata_st userdata = {.lut = &disk->lutid,
-                                                 .tree_idx = tree_idx};
-        swicc_fs_file_st file_root;
-        ret = swicc_disk_tree_file_root(tree, &file_root);
-        if (ret != SWICC_RET_SUCCESS)
+        /**
+         * Buffers of trees of a mapped disk are part of the mapping and shared
+         * trees borrow the buffer from the base disk.
+         */
+        if (tree->buf != NULL && disk->map == NULL && !tree->shared)
         {
-            swicc_disk_lutid_empty(disk);
-            break;
+            swicc_alloc_free(tree->alloc, tree->buf);
         }
-        ret = swicc_disk_file_foreach(tree, &file_root, lutid_rebuild_cb,
-                                      &userdata, true);
-        if (ret != SWICC_RET_SUCCESS)
+        for (uint32_t ovl_idx = 0U; ovl_idx < tree->overlay_count; ++ovl_idx)
         {
-            swicc_disk_lutid_empty(disk);
-            break;
+            overlay_free(tree, &tree->overlay[ovl_idx]);
         }
+        swicc_alloc_free(tree->alloc, tree->overlay);
+        swicc_alloc_free(tree->alloc, tree->dirty);
+        swicc_alloc_free(tree->alloc, tree->check_page);
+        swicc_alloc_free(tree->alloc, tree->check_stale);
 
-        tree = tree->next;
+        /* Free the SID LUT of this tree. */
+        swicc_disk_lutsid_empty(tree);
+        swicc_disk_dedup_tree_put(tree->dedup);
 
-        /**
-         * Unsafe cast that relies on there being fewer than 256 trees in the
-         * forest.
-         */
-        tree_idx = (uint8_t)(tree_idx + 1U);
+        swicc_disk_tree_st *const tree_next = tree->next;
+        swicc_alloc_free(tree->alloc, tree);
+        tree = tree_next;
     }
-    return ret;
+    disk->root = NULL;
+    if (disk->map != NULL)
+    {
+        munmap(disk->map, disk->map_size);
+        disk->map = NULL;
+        disk->map_size = 0U;
+    }
+    if (disk->lazy)
+    {
+        if (disk->remote != NULL)
+        {
+            swicc_alloc_free(disk->alloc, disk->remote);
+            disk->remote = NULL;
+        }
+        else
+        {
+            close(disk->lazy_fd);
+        }
+        disk->lazy = false;
+    }
+    /* Since there will be no trees left, the ID LUT shall also be destroyed. */
+    swicc_disk_lutid_empty(disk);
+    disk->base = NULL;
 }
 
-/**
- * @brief Callback used when rebuilding the SID LUT. It receives files and
- * inserts their info into the SID LUT.
- * @param tree
- * @param file
- * @param userdata
- * @return Return code.
- */
-static swicc_disk_file_foreach_cb lutsid_rebuild_cb;
-static swicc_ret_et lutsid_rebuild_cb(swicc_disk_tree_st *const tree,
-                                      swicc_fs_file_st *const file,
-                                      void *const userdata)
+void swicc_disk_lutsid_empty(swicc_disk_tree_st *const tree)
 {
-    if (file->hdr_file.sid == SWICC_FS_SID_MISSING)
+    if (tree == NULL)
     {
-        return SWICC_RET_SUCCESS;
+        return;
+    }
+    swicc_disk_lut_st *lutsid = &tree->lutsid;
+    /* A shared tree does not own its SID LUT. */
+    if (lutsid->buf1 != NULL && !tree->shared)
+    {
+        swicc_alloc_free(tree->alloc, lutsid->buf1);
+    }
+    if (lutsid->buf2 != NULL && !tree->shared)
+    {
+        swicc_alloc_free(tree->alloc, lutsid->buf2);
+    }
+    memset(&tree->lutsid, 0U, sizeof(tree->lutsid));
+    if (!tree->shared)
+    {
+        swicc_alloc_free(tree->alloc, tree->descr);
+    }
+    tree->descr = NULL;
+    tree->descr_count = 0U;
+    swicc_alloc_free(tree->alloc, tree->access);
+    tree->access = NULL;
+    /* Files may have moved so the DO indexes are dropped too. */
+    tree_dato_idx_drop(tree, 0U, UINT32_MAX);
+    tree_fcp_drop(tree, 0U, UINT32_MAX);
+    for (uint32_t sid = 0U; sid < SWICC_DISK_LUTSID_DIRECT_COUNT; ++sid)
+    {
+        tree->lutsid_direct[sid] = SWICC_DISK_LUTSID_DIRECT_NONE;
     }
-
-    /* Insert the SID + offset into the SID LUT. */
-    return lut_insert(&tree->lutsid, (uint8_t *)&file->hdr_file.sid,
-                      (uint8_t *)&file->hdr_item.offset_trel);
 }
 
-swicc_ret_et swicc_disk_lutsid_rebuild(swicc_disk_st *const disk,
-                                       swicc_disk_tree_st *const tree)
+void swicc_disk_lutid_empty(swicc_disk_st *const disk)
 {
-    if (disk == NULL || tree == NULL)
+    if (disk == NULL)
     {
-        return SWICC_RET_PARAM_BAD;
+        return;
     }
-
-    /* Cleanup the old SID LUT before rebuilding it. */
-    swicc_disk_lutsid_empty(tree);
-    tree->lutsid.size_item1 = sizeof(swicc_fs_sid_kt);
-    tree->lutsid.size_item2 = sizeof(uint32_t);
-    tree->lutsid.count_max = LUT_COUNT_START;
-    tree->lutsid.count = 0U;
-    tree->lutsid.buf1 =
-        malloc(tree->lutsid.count_max * tree->lutsid.size_item1);
-    tree->lutsid.buf2 =
-        malloc(tree->lutsid.count_max * tree->lutsid.size_item2);
-    if (tree->lutsid.buf1 == NULL || tree->lutsid.buf2 == NULL)
+    swicc_disk_lut_st *lutid = &disk->lutid;
+    /* An overlay disk does not own its ID LUT. */
+    if (lutid->buf1 != NULL && disk->base == NULL)
     {
-        swicc_disk_lutsid_empty(tree);
-        return SWICC_RET_ERROR;
+        swicc_alloc_free(disk->alloc, lutid->buf1);
     }
-
-    swicc_fs_file_st file_root;
-    swicc_ret_et ret = swicc_disk_tree_file_root(tree, &file_root);
-    if (ret != SWICC_RET_SUCCESS)
+    if (lutid->buf2 != NULL && disk->base == NULL)
     {
-        swicc_disk_lutsid_empty(tree);
-        return ret;
+        swicc_alloc_free(disk->alloc, lutid->buf2);
     }
-    ret = swicc_disk_file_foreach(tree, &file_root, lutsid_rebuild_cb, NULL,
-                                  true);
-    if (ret != SWICC_RET_SUCCESS)
+    memset(&disk->lutid, 0U, sizeof(disk->lutid));
+    swicc_disk_lut_st *lutname = &disk->lutname;
+    if (lutname->buf1 != NULL && disk->base == NULL)
     {
-        swicc_disk_lutsid_empty(tree);
-        return ret;
+        swicc_alloc_free(disk->alloc, lutname->buf1);
     }
-    return ret;
+    if (lutname->buf2 != NULL && disk->base == NULL)
+    {
+        swicc_alloc_free(disk->alloc, lutname->buf2);
+    }
+    memset(&disk->lutname, 0U, sizeof(disk->lutname));
+    /* The cached paths lead to offsets which may no longer hold the files. */
+    swicc_alloc_free(disk->alloc, disk->path_cache);
+    disk->path_cache = NULL;
+    swicc_alloc_free(disk->alloc, disk->lutid_tree);
+    disk->lutid_tree = NULL;
+    disk->lutid_tree_count = 0U;
 }
 
-swicc_ret_et swicc_disk_lutsid_lookup(swicc_disk_tree_st const *const tree,
-                                      swicc_fs_sid_kt const sid,
-                                      swicc_fs_file_st *const file)
+swicc_ret_et swicc_disk_file_access(swicc_disk_tree_st *const tree,
+                                    swicc_fs_file_st const *const file)
 {
     if (tree == NULL || file == NULL)
     {
         return SWICC_RET_PARAM_BAD;
     }
-
-    swicc_disk_lut_st const *const lutsid = &tree->lutsid;
-    /* Make sure the SID LUT is as expected. */
-    if (lutsid->buf1 == NULL || lutsid->size_item1 != sizeof(swicc_fs_sid_kt) ||
-        lutsid->size_item2 != sizeof(uint32_t))
+    uint32_t descr_idx;
+    swicc_ret_et const ret =
+        swicc_disk_descr_lookup(tree, file->hdr_item.offset_trel, &descr_idx);
+    if (ret != SWICC_RET_SUCCESS)
     {
-        return SWICC_RET_ERROR;
+        return ret;
     }
-
-    /* Find the file by SID. */
-    uint32_t entry_idx = 0U;
-    while (entry_idx < lutsid->count)
+    if (tree->access == NULL)
     {
-        if (memcmp(&lutsid->buf1[lutsid->size_item1 * entry_idx], &sid,
-                   lutsid->size_item1) == 0)
+        tree->access = swicc_alloc_calloc(tree->alloc, tree->descr_count,
+                                          sizeof(*tree->access));
+        if (tree->access == NULL)
         {
-            break;
+            return SWICC_RET_ERROR;
         }
-        entry_idx += 1U;
     }
-    if (entry_idx >= lutsid->count)
+    /* Saturate instead of wrapping around so hot files don't turn cold. */
+    if (tree->access[descr_idx] < UINT32_MAX)
     {
-        return SWICC_RET_FS_NOT_FOUND;
+        tree->access[descr_idx] += 1U;
     }
+    return SWICC_RET_SUCCESS;
+}
+
+typedef struct tree_relayout_s
+{
+    swicc_disk_tree_st const *tree;
+    uint64_t const *heat; /* Accesses of a file and everything inside of it. */
+    uint8_t *buf;         /* The new layout of the tree. */
+} tree_relayout_st;
 
-    uint32_t const offset =
-        *(uint32_t *)&lutsid->buf2[lutsid->size_item2 * entry_idx];
-    /* Offset too large. */
-    if (offset >= tree->len)
+/**
+ * @brief Write a file (and all files inside of it) to the new layout of a tree
+ * with its children ordered by decreasing heat.
+ * @param relayout
+ * @param descr_idx Index of the descriptor of the file.
+ * @param offset_trel Where to put the file in the new layout.
+ * @param offset_trel_parent Where the parent was put in the new layout.
+ * @return Return code.
+ */
+static swicc_ret_et tree_relayout_file(tree_relayout_st const *const relayout,
+                                       uint32_t const descr_idx,
+                                       uint32_t const offset_trel,
+                                       uint32_t const offset_trel_parent)
+{
+    swicc_disk_tree_st const *const tree = relayout->tree;
+    swicc_disk_descr_st const *const descr = &tree->descr[descr_idx];
+    if (descr->offset_trel > tree->len ||
+        descr->size > tree->len - descr->offset_trel ||
+        descr->size > tree->len - offset_trel)
     {
         return SWICC_RET_ERROR;
     }
-    if (swicc_fs_file_prs(tree, offset, file) != SWICC_RET_SUCCESS)
+
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    if (descr->type != SWICC_FS_ITEM_TYPE_FILE_MF &&
+        descr->type != SWICC_FS_ITEM_TYPE_FILE_ADF &&
+        descr->type != SWICC_FS_ITEM_TYPE_FILE_DF)
     {
-        return SWICC_RET_ERROR;
+        /* Data of an EF is right after its header. */
+        memcpy(&relayout->buf[offset_trel], &tree->buf[descr->offset_trel],
+               descr->size);
     }
-    return SWICC_RET_SUCCESS;
+    else
+    {
+        uint32_t const hdr_size = swicc_fs_item_hdr_raw_size[descr->type];
+        if (hdr_size > descr->size)
+        {
+            return SWICC_RET_ERROR;
+        }
+        memcpy(&relayout->buf[offset_trel], &tree->buf[descr->offset_trel],
+               hdr_size);
+
+        /* Descriptors of everything inside the folder come right after it. */
+        uint32_t const end = descr->offset_trel + descr->size;
+        uint32_t child_count = 0U;
+        uint32_t nstd_end = descr_idx + 1U;
+        while (nstd_end < tree->descr_count &&
+               tree->descr[nstd_end].offset_trel < end)
+        {
+            if (tree->descr[nstd_end].parent_idx == descr_idx)
+            {
+                child_count += 1U;
+            }
+            nstd_end += 1U;
+        }
+        uint32_t *const child = malloc(
+            (child_count > 0U ? child_count : 1U) * sizeof(*child));
+        if (child == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        /* Insertion sort is stable and folders have few children. */
+        uint32_t child_idx = 0U;
+        for (uint32_t nstd_idx = descr_idx + 1U; nstd_idx < nstd_end;
+             ++nstd_idx)
+        {
+            if (tree->descr[nstd_idx].parent_idx != descr_idx)
+            {
+                continue;
+            }
+            uint32_t pos = child_idx++;
+            while (pos > 0U &&
+                   relayout->heat[child[pos - 1U]] < relayout->heat[nstd_idx])
+            {
+                child[pos] = child[pos - 1U];
+                pos -= 1U;
+            }
+            child[pos] = nstd_idx;
+        }
+
+        uint32_t offset_trel_child = offset_trel + hdr_size;
+        for (child_idx = 0U; child_idx < child_count; ++child_idx)
+        {
+            ret = tree_relayout_file(relayout, child[child_idx],
+                                     offset_trel_child, offset_trel);
+            if (ret != SWICC_RET_SUCCESS)
+            {
+                break;
+            }
+            offset_trel_child += tree->descr[child[child_idx]].size;
+        }
+        free(child);
+        /* A folder holds nothing but its header and its children. */
+        if (ret == SWICC_RET_SUCCESS &&
+            offset_trel_child != offset_trel + descr->size)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+    }
+
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        uint32_t const offset_prel =
+            descr->offset_prel == 0U ? 0U : offset_trel - offset_trel_parent;
+        memcpy(&relayout->buf[offset_trel +
+                              offsetof(swicc_fs_item_hdr_raw_st, offset_prel)],
+               &offset_prel, sizeof(offset_prel));
+    }
+    return ret;
 }
 
-swicc_ret_et swicc_disk_lutid_lookup(swicc_disk_st const *const disk,
-                                     swicc_disk_tree_st **const tree,
-                                     swicc_fs_id_kt const id,
-                                     swicc_fs_file_st *const file)
+swicc_ret_et swicc_disk_tree_relayout(swicc_disk_st *const disk,
+                                      swicc_disk_tree_st *const tree)
 {
-    if (disk == NULL || tree == NULL || file == NULL)
+    if (disk == NULL || tree == NULL)
     {
         return SWICC_RET_PARAM_BAD;
     }
-
-    swicc_disk_lut_st const *const lutid = &disk->lutid;
-
-    /* Make sure the ID LUT is as expected. */
-    if (lutid->buf1 == NULL || lutid->size_item1 != sizeof(swicc_fs_id_kt) ||
-        lutid->size_item2 != sizeof(uint32_t) + sizeof(uint8_t))
+    if (tree->shared || disk->base != NULL || disk->journal.enabled)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (swicc_disk_tree_load(tree) != SWICC_RET_SUCCESS ||
+        (tree->descr_count == 0U &&
+         swicc_disk_descr_rebuild(tree) != SWICC_RET_SUCCESS) ||
+        tree->descr_count == 0U)
     {
         return SWICC_RET_ERROR;
     }
 
-    /* Find the file by ID. */
-    uint32_t entry_idx = 0U;
-    /* ID's are stored in big-endian inside the LUT. */
-    swicc_fs_id_kt const id_be = htobe16(id);
-    while (entry_idx < lutid->count)
+    uint64_t *const heat = calloc(tree->descr_count, sizeof(*heat));
+    uint8_t *const buf = malloc(tree->len);
+    if (heat == NULL || buf == NULL)
+    {
+        free(heat);
+        free(buf);
+        return SWICC_RET_ERROR;
+    }
+    /* Children come after their parent so their heat is summed up first. */
+    for (uint32_t descr_idx = tree->descr_count; descr_idx-- > 0U;)
     {
-        if (memcmp(&lutid->buf1[lutid->size_item1 * entry_idx], &id_be,
-                   lutid->size_item1) == 0)
+        if (tree->access != NULL)
         {
-            break;
+            heat[descr_idx] += tree->access[descr_idx];
+        }
+        if (descr_idx > 0U)
+        {
+            heat[tree->descr[descr_idx].parent_idx] += heat[descr_idx];
         }
-        entry_idx += 1U;
     }
-    if (entry_idx >= lutid->count)
+    tree_relayout_st const relayout = {
+        .tree = tree,
+        .heat = heat,
+        .buf = buf,
+    };
+    swicc_ret_et ret = tree_relayout_file(&relayout, 0U, 0U, 0U);
+    if (ret == SWICC_RET_SUCCESS)
     {
-        return SWICC_RET_FS_NOT_FOUND;
+        /* In place so that buffers of mapped disks keep their owner. */
+        memcpy(tree->buf, buf, tree->len);
+    }
+    free(heat);
+    free(buf);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        return ret;
     }
 
-    uint32_t const offset =
-        *(uint32_t *)&lutid->buf2[(lutid->size_item2 * entry_idx) + 0U];
-    uint8_t const tree_idx =
-        lutid->buf2[(lutid->size_item2 * entry_idx) + sizeof(uint32_t)];
-
-    /* Find the tree in which the file resides. */
-    swicc_disk_tree_iter_st tree_iter;
-    if (swicc_disk_tree_iter(disk, &tree_iter) != SWICC_RET_SUCCESS ||
-        swicc_disk_tree_iter_idx(&tree_iter, tree_idx, tree) !=
-            SWICC_RET_SUCCESS ||
-        (*tree)->len <= offset)
+    /* Every offset into the tree may have changed. */
+    if (swicc_disk_tree_dirty_mark(tree, 0U, tree->len) != SWICC_RET_SUCCESS ||
+        swicc_disk_tree_lutsid_rebuild(tree) != SWICC_RET_SUCCESS)
     {
         return SWICC_RET_ERROR;
     }
+    return swicc_disk_lutid_rebuild(disk);
+}
 
-    /* Offset too large. */
-    if (offset >= (*tree)->len)
+/**
+ * @brief Get the slot of a path in the path cache.
+ * @param key
+ * @return Index of the slot.
+ */
+static uint32_t path_cache_slot(swicc_disk_path_cache_entry_st const *const key)
+{
+    uintptr_t const start_tree = (uintptr_t)key->start_tree;
+    uint32_t hash = SWICC_DISK_CHECK_FNV1A_BASIS;
+    hash = swicc_disk_check_fnv1a(hash, (uint8_t const *)&start_tree,
+                                  sizeof(start_tree));
+    hash = swicc_disk_check_fnv1a(hash,
+                                  (uint8_t const *)&key->start_offset_trel,
+                                  sizeof(key->start_offset_trel));
+    hash = swicc_disk_check_fnv1a(hash, &key->type, sizeof(key->type));
+    hash = swicc_disk_check_fnv1a(hash, (uint8_t const *)key->id,
+                                  key->len * sizeof(key->id[0U]));
+    return hash & (SWICC_DISK_PATH_CACHE_COUNT - 1U);
+}
+
+swicc_ret_et swicc_disk_path_cache_lookup(
+    swicc_disk_st const *const disk,
+    swicc_disk_path_cache_entry_st const *const key,
+    swicc_disk_tree_st **const tree, swicc_fs_file_st *const file)
+{
+    if (disk == NULL || key == NULL || tree == NULL || file == NULL ||
+        key->len > SWICC_DISK_PATH_CACHE_LEN_MAX)
     {
-        return SWICC_RET_ERROR;
+        return SWICC_RET_PARAM_BAD;
     }
-    if (swicc_fs_file_prs(*tree, offset, file) != SWICC_RET_SUCCESS)
+    if (disk->path_cache == NULL || key->len == 0U)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+    swicc_disk_path_cache_entry_st const *const entry =
+        &disk->path_cache[path_cache_slot(key)];
+    if (entry->len != key->len || entry->type != key->type ||
+        entry->start_tree != key->start_tree ||
+        entry->start_offset_trel != key->start_offset_trel ||
+        memcmp(entry->id, key->id, key->len * sizeof(key->id[0U])) != 0)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+    if (swicc_fs_file_prs(entry->tree, entry->offset_trel, file) !=
+        SWICC_RET_SUCCESS)
     {
         return SWICC_RET_ERROR;
     }
+    *tree = entry->tree;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_path_cache_insert(
+    swicc_disk_st *const disk,
+    swicc_disk_path_cache_entry_st const *const entry)
+{
+    if (disk == NULL || entry == NULL || entry->tree == NULL ||
+        entry->len == 0U || entry->len > SWICC_DISK_PATH_CACHE_LEN_MAX)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->path_cache == NULL)
+    {
+        disk->path_cache =
+            swicc_alloc_calloc(disk->alloc, SWICC_DISK_PATH_CACHE_COUNT,
+                               sizeof(*disk->path_cache));
+        if (disk->path_cache == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    swicc_disk_path_cache_entry_st *const slot =
+        &disk->path_cache[path_cache_slot(entry)];
+    *slot = *entry;
     return SWICC_RET_SUCCESS;
 }
 
@@ -818,16 +1432,31 @@ swicc_ret_et swicc_disk_file_rcrd(swicc_disk_tree_st const *const tree,
             {
                 return SWICC_RET_FS_NOT_FOUND;
             }
-            /* Safe cast since uint8 * uint8 will fit in a uint32. */
-            uint32_t const rcrd_offset = (uint32_t)(rcrd_size * idx);
+            /* Records of a cyclic EF are numbered starting from the head. */
+            uint32_t rcrd_slot = idx;
+            if (file->hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
+            {
+                uint8_t rcrd_head;
+                if (swicc_disk_file_rcrd_head(tree, file, &rcrd_head) !=
+                        SWICC_RET_SUCCESS ||
+                    rcrd_head >= rcrd_cnt)
+                {
+                    return SWICC_RET_ERROR;
+                }
+                rcrd_slot = (rcrd_head + rcrd_slot) % rcrd_cnt;
+            }
+            /* Safe cast since the record slot is below the uint8 index. */
+            uint32_t const rcrd_offset = (uint32_t)(rcrd_size * rcrd_slot);
             static_assert(
                 sizeof(rcrd_size) == 1 && sizeof(idx) == 1,
                 "Expected values to be 1 byte wide for cast to be safe");
-            if (rcrd_offset >= file->data_size)
+            uint8_t *data;
+            if (rcrd_offset >= file->data_size ||
+                swicc_disk_file_data(tree, file, &data) != SWICC_RET_SUCCESS)
             {
                 return SWICC_RET_ERROR;
             }
-            *buf = &file->data[rcrd_offset];
+            *buf = &data[rcrd_offset];
             *len = rcrd_size;
             return SWICC_RET_SUCCESS;
         }
@@ -835,6 +1464,881 @@ swicc_ret_et swicc_disk_file_rcrd(swicc_disk_tree_st const *const tree,
     return SWICC_RET_ERROR;
 }
 
+/**
+ * @brief Find the position of a file in the overlay of a tree.
+ * @param[in] tree
+ * @param[in] offset_trel Offset of the file in the tree.
+ * @param[out] ovl_idx Index of the file in the overlay on success, otherwise
+ * the index where it would have to be inserted.
+ * @return Return code.
+ */
+static swicc_ret_et overlay_lookup(swicc_disk_tree_st const *const tree,
+                                   uint32_t const offset_trel,
+                                   uint32_t *const ovl_idx)
+{
+    uint32_t lo = 0U;
+    uint32_t hi = tree->overlay_count;
+    while (lo < hi)
+    {
+        uint32_t const mid = lo + ((hi - lo) / 2U);
+        if (tree->overlay[mid].offset_trel < offset_trel)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    *ovl_idx = lo;
+    if (lo < tree->overlay_count &&
+        tree->overlay[lo].offset_trel == offset_trel)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    return SWICC_RET_FS_NOT_FOUND;
+}
+
+swicc_ret_et swicc_disk_file_data(swicc_disk_tree_st const *const tree,
+                                  swicc_fs_file_st const *const file,
+                                  uint8_t **const data)
+{
+    if (tree == NULL || file == NULL || data == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t ovl_idx;
+    if (tree->overlay_count > 0U &&
+        overlay_lookup(tree, file->hdr_item.offset_trel, &ovl_idx) ==
+            SWICC_RET_SUCCESS)
+    {
+        *data = tree->overlay[ovl_idx].data;
+    }
+    else
+    {
+        *data = file->data;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Get the offset of the record head of a cyclic EF in its tree.
+ * @param[in] file
+ * @return Offset of the head.
+ */
+static uint32_t rcrd_head_offset_trel(swicc_fs_file_st const *const file)
+{
+    /* Safe cast since the header is only a few bytes. */
+    return file->hdr_item.offset_trel +
+           (uint32_t)(sizeof(swicc_fs_file_raw_st) +
+                      offsetof(swicc_fs_ef_cyclic_hdr_raw_st, rcrd_head));
+}
+
+swicc_ret_et swicc_disk_file_rcrd_head(swicc_disk_tree_st const *const tree,
+                                       swicc_fs_file_st const *const file,
+                                       uint8_t *const rcrd_head)
+{
+    if (tree == NULL || file == NULL || rcrd_head == NULL ||
+        file->hdr_item.type != SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t ovl_idx;
+    if (tree->overlay_count > 0U &&
+        overlay_lookup(tree, file->hdr_item.offset_trel, &ovl_idx) ==
+            SWICC_RET_SUCCESS &&
+        tree->overlay[ovl_idx].rcrd_head_own)
+    {
+        *rcrd_head = tree->overlay[ovl_idx].rcrd_head;
+        return SWICC_RET_SUCCESS;
+    }
+    uint32_t const offset_trel = rcrd_head_offset_trel(file);
+    if (offset_trel >= tree->len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    *rcrd_head = tree->buf[offset_trel];
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_file_rcrd_head_set(swicc_disk_tree_st *const tree,
+                                           swicc_fs_file_st const *const file,
+                                           uint8_t const rcrd_head)
+{
+    if (tree == NULL || file == NULL ||
+        file->hdr_item.type != SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t const offset_trel = rcrd_head_offset_trel(file);
+    if (offset_trel >= tree->len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (tree->shared)
+    {
+        /* The header belongs to the base so the overlay holds the head. */
+        uint32_t ovl_idx;
+        if (overlay_lookup(tree, file->hdr_item.offset_trel, &ovl_idx) !=
+                SWICC_RET_SUCCESS ||
+            !tree->overlay[ovl_idx].rcrd_head_own)
+        {
+            return SWICC_RET_ERROR;
+        }
+        tree->overlay[ovl_idx].rcrd_head = rcrd_head;
+    }
+    else
+    {
+        tree->buf[offset_trel] = rcrd_head;
+    }
+    return swicc_disk_tree_dirty_mark(tree, offset_trel, 1U);
+}
+
+swicc_ret_et swicc_disk_file_dato_idx(
+    swicc_disk_tree_st *const tree, swicc_fs_file_st const *const file,
+    swicc_dato_bertlv_idx_st const **const idx, uint8_t **const data)
+{
+    if (tree == NULL || file == NULL || idx == NULL || data == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint8_t *data_file;
+    if (swicc_disk_file_data(tree, file, &data_file) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    for (uint32_t dato_idx = 0U; dato_idx < tree->dato_idx_count; ++dato_idx)
+    {
+        if (tree->dato_idx[dato_idx].offset_trel == file->hdr_item.offset_trel)
+        {
+            *idx = &tree->dato_idx[dato_idx].idx;
+            *data = data_file;
+            return SWICC_RET_SUCCESS;
+        }
+    }
+
+    uint32_t data_offset_trel;
+    uint32_t ovl_idx;
+    if (tree->overlay_count > 0U &&
+        overlay_lookup(tree, file->hdr_item.offset_trel, &ovl_idx) ==
+            SWICC_RET_SUCCESS)
+    {
+        data_offset_trel = tree->overlay[ovl_idx].data_offset_trel;
+    }
+    else if (file->data >= tree->buf && file->data <= tree->buf + tree->len)
+    {
+        /* Safe cast since the file data is part of the tree buffer. */
+        data_offset_trel = (uint32_t)(file->data - tree->buf);
+    }
+    else
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    swicc_disk_dato_idx_st *const dato_idx_new = swicc_alloc_realloc(
+        tree->alloc, tree->dato_idx,
+        tree->dato_idx_count * sizeof(*dato_idx_new),
+        (tree->dato_idx_count + 1U) * sizeof(*dato_idx_new));
+    if (dato_idx_new == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    tree->dato_idx = dato_idx_new;
+    swicc_disk_dato_idx_st *const entry = &tree->dato_idx[tree->dato_idx_count];
+    entry->offset_trel = file->hdr_item.offset_trel;
+    entry->data_offset_trel = data_offset_trel;
+    entry->data_size = file->data_size;
+    if (swicc_dato_bertlv_idx_build(&entry->idx, tree->alloc, data_file,
+                                    file->data_size) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    tree->dato_idx_count += 1U;
+    *idx = &entry->idx;
+    *data = data_file;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Find the position of a response template in the cache of a tree.
+ * @param[in] tree
+ * @param[in] offset_trel Offset of the file in the tree.
+ * @param[in] kind
+ * @param[out] fcp_idx Index of the template on success, otherwise the index
+ * where it would have to be inserted.
+ * @return Return code.
+ */
+static swicc_ret_et fcp_lookup(swicc_disk_tree_st const *const tree,
+                               uint32_t const offset_trel, uint8_t const kind,
+                               uint32_t *const fcp_idx)
+{
+    uint32_t lo = 0U;
+    uint32_t hi = tree->fcp_count;
+    while (lo < hi)
+    {
+        uint32_t const mid = lo + ((hi - lo) / 2U);
+        if (tree->fcp[mid].offset_trel < offset_trel ||
+            (tree->fcp[mid].offset_trel == offset_trel &&
+             tree->fcp[mid].kind < kind))
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    *fcp_idx = lo;
+    if (lo < tree->fcp_count && tree->fcp[lo].offset_trel == offset_trel &&
+        tree->fcp[lo].kind == kind)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    return SWICC_RET_FS_NOT_FOUND;
+}
+
+swicc_ret_et swicc_disk_file_fcp_lookup(swicc_disk_tree_st const *const tree,
+                                        swicc_fs_file_st const *const file,
+                                        uint8_t const kind,
+                                        uint8_t const **const buf,
+                                        uint32_t *const len)
+{
+    if (tree == NULL || file == NULL || buf == NULL || len == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t fcp_idx;
+    swicc_ret_et const ret =
+        fcp_lookup(tree, file->hdr_item.offset_trel, kind, &fcp_idx);
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        *buf = tree->fcp[fcp_idx].buf;
+        *len = tree->fcp[fcp_idx].len;
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_file_fcp_insert(swicc_disk_tree_st *const tree,
+                                        swicc_fs_file_st const *const file,
+                                        uint8_t const kind,
+                                        uint8_t const *const buf,
+                                        uint32_t const len)
+{
+    if (tree == NULL || file == NULL || (buf == NULL && len > 0U) ||
+        file->data_size > file->hdr_item.size)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    /* Always allocate at least 1 byte so an empty template is not NULL. */
+    uint8_t *const buf_new =
+        swicc_alloc_malloc(tree->alloc, len > 0U ? len : 1U);
+    if (buf_new == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (len > 0U)
+    {
+        memcpy(buf_new, buf, len);
+    }
+
+    uint32_t fcp_idx;
+    if (fcp_lookup(tree, file->hdr_item.offset_trel, kind, &fcp_idx) ==
+        SWICC_RET_SUCCESS)
+    {
+        swicc_alloc_free(tree->alloc, tree->fcp[fcp_idx].buf);
+    }
+    else
+    {
+        swicc_disk_fcp_st *const fcp_new = swicc_alloc_realloc(
+            tree->alloc, tree->fcp, tree->fcp_count * sizeof(*fcp_new),
+            (tree->fcp_count + 1U) * sizeof(*fcp_new));
+        if (fcp_new == NULL)
+        {
+            swicc_alloc_free(tree->alloc, buf_new);
+            return SWICC_RET_ERROR;
+        }
+        tree->fcp = fcp_new;
+        memmove(&tree->fcp[fcp_idx + 1U], &tree->fcp[fcp_idx],
+                (tree->fcp_count - fcp_idx) * sizeof(*fcp_new));
+        tree->fcp_count += 1U;
+    }
+    tree->fcp[fcp_idx] = (swicc_disk_fcp_st){
+        .offset_trel = file->hdr_item.offset_trel,
+        .hdr_size = file->hdr_item.size - file->data_size,
+        .kind = kind,
+        .len = len,
+        .buf = buf_new,
+    };
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Add a copy of the data of a file to the overlay of a tree.
+ * @param[in, out] tree
+ * @param[in] ovl_idx Where to insert the file as given by the lookup.
+ * @param[in] offset_trel Offset of the file in the tree.
+ * @param[in] data_offset_trel Offset of the data of the file in the tree.
+ * @param[in] data_size
+ * @param[in] data_src What the private copy holds at first.
+ * @param[in] extent When not NULL, the file shares the data of this extent
+ * instead of getting a private copy. Only taken over on success.
+ * @param[in] rcrd_head_own If the file is a cyclic EF.
+ * @param[in] rcrd_head Record head of the cyclic EF.
+ * @param[out] data Will receive a pointer to the copy.
+ * @return Return code.
+ */
+static swicc_ret_et overlay_insert(swicc_disk_tree_st *const tree,
+                                   uint32_t const ovl_idx,
+                                   uint32_t const offset_trel,
+                                   uint32_t const data_offset_trel,
+                                   uint32_t const data_size,
+                                   uint8_t const *const data_src,
+                                   swicc_disk_dedup_extent_st *const extent,
+                                   bool const rcrd_head_own,
+                                   uint8_t const rcrd_head,
+                                   uint8_t **const data)
+{
+    if (tree->overlay_count >= tree->overlay_count_max)
+    {
+        uint32_t const count_max_new =
+            tree->overlay_count_max == 0U ? SWICC_DISK_LUT_COUNT_RESIZE
+                                          : tree->overlay_count_max * 2U;
+        swicc_disk_overlay_file_st *const overlay_new = swicc_alloc_realloc(
+            tree->alloc, tree->overlay,
+            tree->overlay_count_max * sizeof(*overlay_new),
+            count_max_new * sizeof(*overlay_new));
+        if (overlay_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        tree->overlay = overlay_new;
+        tree->overlay_count_max = count_max_new;
+    }
+
+    uint8_t *data_new;
+    if (extent != NULL)
+    {
+        data_new = extent->data;
+    }
+    else
+    {
+        /* At least 1 byte so an empty file still gets a valid pointer. */
+        data_new =
+            swicc_alloc_malloc(tree->alloc, data_size > 0U ? data_size : 1U);
+        if (data_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        memcpy(data_new, data_src, data_size);
+    }
+
+    memmove(&tree->overlay[ovl_idx + 1U], &tree->overlay[ovl_idx],
+            (tree->overlay_count - ovl_idx) * sizeof(tree->overlay[0U]));
+    tree->overlay[ovl_idx] = (swicc_disk_overlay_file_st){
+        .offset_trel = offset_trel,
+        .data_offset_trel = data_offset_trel,
+        .data_size = data_size,
+        .data = data_new,
+        .extent = extent,
+        .rcrd_head_own = rcrd_head_own,
+        .rcrd_head = rcrd_head,
+    };
+    tree->overlay_count += 1U;
+    *data = data_new;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_file_cow(swicc_disk_tree_st *const tree,
+                                 swicc_fs_file_st *const file)
+{
+    if (tree == NULL || file == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (!tree->shared)
+    {
+        /* Files of a tree that is not shared can be modified in place. */
+        return SWICC_RET_SUCCESS;
+    }
+
+    uint32_t ovl_idx;
+    if (overlay_lookup(tree, file->hdr_item.offset_trel, &ovl_idx) ==
+        SWICC_RET_SUCCESS)
+    {
+        swicc_ret_et const ret = overlay_own(tree, &tree->overlay[ovl_idx]);
+        file->data = tree->overlay[ovl_idx].data;
+        return ret;
+    }
+
+    /* Safe cast since the file data is part of the tree buffer. */
+    uint32_t const data_offset_trel = (uint32_t)(file->data - tree->buf);
+    if (file->data < tree->buf || data_offset_trel > tree->len ||
+        file->data_size > tree->len - data_offset_trel)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    bool const rcrd_head_own =
+        file->hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC;
+    /* The head directly precedes the data. */
+    return overlay_insert(tree, ovl_idx, file->hdr_item.offset_trel,
+                          data_offset_trel, file->data_size,
+                          &tree->buf[data_offset_trel], NULL, rcrd_head_own,
+                          rcrd_head_own ? tree->buf[data_offset_trel - 1U]
+                                        : 0U,
+                          &file->data);
+}
+
+/**
+ * @brief Share a tree of a disk with the tree of a store that has the same
+ * structure.
+ * @param disk
+ * @param tree A tree in memory that is not shared.
+ * @param dedup
+ * @return Return code. On failure, the tree is left as it was.
+ */
+static swicc_ret_et tree_dedup(swicc_disk_st const *const disk,
+                               swicc_disk_tree_st *const tree,
+                               swicc_disk_dedup_st *const dedup)
+{
+    if (tree->descr_count == 0U &&
+        swicc_disk_descr_rebuild(tree) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_disk_dedup_tree_st *dedup_tree;
+    if (swicc_disk_dedup_tree_get(dedup, tree, &dedup_tree) !=
+        SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_disk_tree_st const *const base = &dedup_tree->tree;
+
+    /**
+     * Files whose data differ from the tree of the store share the data with
+     * all other files holding the same bytes through an extent of the store,
+     * taken while the buffer of the tree still holds their data.
+     */
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    for (uint32_t descr_idx = 0U; descr_idx < tree->descr_count; ++descr_idx)
+    {
+        swicc_disk_descr_st const *const descr = &tree->descr[descr_idx];
+        if (descr->type <= SWICC_FS_ITEM_TYPE_FILE_DF)
+        {
+            continue;
+        }
+        uint32_t const hdr_size = swicc_fs_item_hdr_raw_size[descr->type];
+        uint32_t const data_offset_trel = descr->offset_trel + hdr_size;
+        uint32_t const data_size = descr->size - hdr_size;
+        bool const rcrd_head_own =
+            descr->type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC;
+        /* The head directly precedes the data. */
+        uint8_t const rcrd_head =
+            rcrd_head_own ? tree->buf[data_offset_trel - 1U] : 0U;
+        if (memcmp(&tree->buf[data_offset_trel],
+                   &base->buf[data_offset_trel], data_size) == 0 &&
+            (!rcrd_head_own || rcrd_head == base->buf[data_offset_trel - 1U]))
+        {
+            continue;
+        }
+        swicc_disk_dedup_extent_st *extent;
+        ret = swicc_disk_dedup_extent_get(dedup, &tree->buf[data_offset_trel],
+                                          data_size, &extent);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            break;
+        }
+        uint8_t *data;
+        ret = overlay_insert(tree, tree->overlay_count, descr->offset_trel,
+                             data_offset_trel, data_size,
+                             &tree->buf[data_offset_trel], extent,
+                             rcrd_head_own, rcrd_head, &data);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            swicc_disk_dedup_extent_put(extent);
+            break;
+        }
+    }
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        for (uint32_t ovl_idx = 0U; ovl_idx < tree->overlay_count; ++ovl_idx)
+        {
+            overlay_free(tree, &tree->overlay[ovl_idx]);
+        }
+        swicc_alloc_free(tree->alloc, tree->overlay);
+        tree->overlay = NULL;
+        tree->overlay_count = 0U;
+        tree->overlay_count_max = 0U;
+        swicc_disk_dedup_tree_put(dedup_tree);
+        return ret;
+    }
+
+    /* From now on the tree is seen through the overlay. */
+    uint8_t *const buf_own = tree->buf;
+    swicc_disk_lutsid_empty(tree);
+    if (disk->map == NULL)
+    {
+        swicc_alloc_free(tree->alloc, buf_own);
+    }
+    tree->buf = base->buf;
+    tree->size = base->size;
+    tree->lutsid = base->lutsid;
+    memcpy(tree->lutsid_direct, base->lutsid_direct,
+           sizeof(tree->lutsid_direct));
+    tree->descr = base->descr;
+    tree->descr_count = base->descr_count;
+    tree->shared = true;
+    tree->dedup = dedup_tree;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_dedup(swicc_disk_st *const disk,
+                              swicc_disk_dedup_st *const dedup)
+{
+    if (disk == NULL || dedup == NULL || disk->root == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        if (swicc_disk_tree_load(tree) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        if (!tree->shared &&
+            tree_dedup(disk, tree, dedup) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_tree_dirty_mark(swicc_disk_tree_st *const tree,
+                                        uint32_t const offset_trel,
+                                        uint32_t const len)
+{
+    if (tree == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (offset_trel > tree->len || len > tree->len - offset_trel)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (len == 0U)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    tree_dato_idx_drop(tree, offset_trel, len);
+    tree_fcp_drop(tree, offset_trel, len);
+
+    uint32_t const page_count =
+        (tree->len + SWICC_DISK_DIRTY_PAGE_SIZE - 1U) /
+        SWICC_DISK_DIRTY_PAGE_SIZE;
+    uint32_t const word_count = (page_count + 63U) / 64U;
+    if (tree->dirty_word_count < word_count)
+    {
+        uint64_t *const dirty_new = swicc_alloc_realloc(
+            tree->alloc, tree->dirty,
+            tree->dirty_word_count * sizeof(*dirty_new),
+            word_count * sizeof(*dirty_new));
+        if (dirty_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        memset(&dirty_new[tree->dirty_word_count], 0U,
+               (word_count - tree->dirty_word_count) * sizeof(*dirty_new));
+        tree->dirty = dirty_new;
+        tree->dirty_word_count = word_count;
+    }
+
+    uint32_t const page_last =
+        (offset_trel + len - 1U) / SWICC_DISK_DIRTY_PAGE_SIZE;
+    for (uint32_t page = offset_trel / SWICC_DISK_DIRTY_PAGE_SIZE;
+         page <= page_last; ++page)
+    {
+        tree->dirty[page / 64U] |= 1ULL << (page % 64U);
+        /* The page checksums get rebuilt anyway when the page count changed. */
+        if (tree->check_stale != NULL && page < tree->check_page_count)
+        {
+            tree->check_stale[page / 64U] |= 1ULL << (page % 64U);
+        }
+    }
+    tree->check_valid = false;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_file_dirty_mark(swicc_disk_tree_st *const tree,
+                                        swicc_fs_file_st const *const file,
+                                        uint32_t const data_offset,
+                                        uint32_t const data_len)
+{
+    if (tree == NULL || file == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (data_offset > file->data_size ||
+        data_len > file->data_size - data_offset)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    uint32_t data_offset_trel;
+    uint32_t ovl_idx;
+    if (tree->overlay_count > 0U &&
+        overlay_lookup(tree, file->hdr_item.offset_trel, &ovl_idx) ==
+            SWICC_RET_SUCCESS)
+    {
+        data_offset_trel = tree->overlay[ovl_idx].data_offset_trel;
+    }
+    else if (file->data >= tree->buf && file->data <= tree->buf + tree->len)
+    {
+        /* Safe cast since the file data is part of the tree buffer. */
+        data_offset_trel = (uint32_t)(file->data - tree->buf);
+    }
+    else
+    {
+        return SWICC_RET_ERROR;
+    }
+    return swicc_disk_tree_dirty_mark(tree, data_offset_trel + data_offset,
+                                      data_len);
+}
+
+void swicc_disk_tree_dirty_clear(swicc_disk_tree_st *const tree)
+{
+    if (tree == NULL || tree->dirty == NULL)
+    {
+        return;
+    }
+    memset(tree->dirty, 0U, tree->dirty_word_count * sizeof(tree->dirty[0U]));
+}
+
+swicc_ret_et swicc_disk_tree_check(swicc_disk_tree_st *const tree,
+                                   uint32_t *const check)
+{
+    if (tree == NULL || check == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (tree->check_valid)
+    {
+        *check = tree->check;
+        return SWICC_RET_SUCCESS;
+    }
+    /* Only trees that are in memory can have been modified. */
+    if (swicc_disk_tree_load(tree) != SWICC_RET_SUCCESS || tree->len == 0U)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    uint32_t const page_count =
+        (tree->len + SWICC_DISK_DIRTY_PAGE_SIZE - 1U) /
+        SWICC_DISK_DIRTY_PAGE_SIZE;
+    uint32_t const word_count = (page_count + 63U) / 64U;
+    if (tree->check_page == NULL || tree->check_page_count != page_count)
+    {
+        uint32_t *const check_page_new = swicc_alloc_realloc(
+            tree->alloc, tree->check_page,
+            tree->check_page_count * sizeof(*check_page_new),
+            page_count * sizeof(*check_page_new));
+        uint64_t *const check_stale_new = swicc_alloc_realloc(
+            tree->alloc, tree->check_stale,
+            ((tree->check_page_count + 63U) / 64U) * sizeof(*check_stale_new),
+            word_count * sizeof(*check_stale_new));
+        if (check_page_new != NULL)
+        {
+            tree->check_page = check_page_new;
+        }
+        if (check_stale_new != NULL)
+        {
+            tree->check_stale = check_stale_new;
+        }
+        if (check_page_new == NULL || check_stale_new == NULL)
+        {
+            /* Page checksums that are kept must cover the whole tree. */
+            swicc_alloc_free(tree->alloc, tree->check_page);
+            swicc_alloc_free(tree->alloc, tree->check_stale);
+            tree->check_page = NULL;
+            tree->check_stale = NULL;
+            tree->check_page_count = 0U;
+            return SWICC_RET_ERROR;
+        }
+        tree->check_page_count = page_count;
+        memset(tree->check_stale, 0xFF, word_count * sizeof(uint64_t));
+    }
+
+    for (uint32_t page = 0U; page < page_count; ++page)
+    {
+        if ((tree->check_stale[page / 64U] & (1ULL << (page % 64U))) == 0U)
+        {
+            continue;
+        }
+        uint32_t const offset_trel = page * SWICC_DISK_DIRTY_PAGE_SIZE;
+        uint32_t const len =
+            tree->len - offset_trel < SWICC_DISK_DIRTY_PAGE_SIZE
+                ? tree->len - offset_trel
+                : SWICC_DISK_DIRTY_PAGE_SIZE;
+        /* Pages with files of the overlay have to be assembled first. */
+        uint8_t page_buf[SWICC_DISK_DIRTY_PAGE_SIZE];
+        uint8_t const *page_data = &tree->buf[offset_trel];
+        if (tree->overlay_count > 0U)
+        {
+            if (swicc_disk_tree_read(tree, offset_trel, len, page_buf) !=
+                SWICC_RET_SUCCESS)
+            {
+                return SWICC_RET_ERROR;
+            }
+            page_data = page_buf;
+        }
+        tree->check_page[page] = swicc_crc32c(0U, page_data, len);
+        tree->check_stale[page / 64U] &= ~(1ULL << (page % 64U));
+    }
+
+    /* Only the last page can be shorter than the others. */
+    uint32_t const page_last_len =
+        tree->len - ((page_count - 1U) * SWICC_DISK_DIRTY_PAGE_SIZE);
+    uint32_t const op = swicc_crc32c_combine_gen(SWICC_DISK_DIRTY_PAGE_SIZE);
+    uint32_t const op_last = swicc_crc32c_combine_gen(page_last_len);
+    uint32_t crc = tree->check_page[0U];
+    for (uint32_t page = 1U; page < page_count; ++page)
+    {
+        crc = swicc_crc32c_combine_op(crc, tree->check_page[page],
+                                      page + 1U == page_count ? op_last : op);
+    }
+    tree->check = crc;
+    tree->check_valid = true;
+    *check = crc;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_tree_read(swicc_disk_tree_st const *const tree,
+                                  uint32_t const offset_trel,
+                                  uint32_t const len, uint8_t *const buf)
+{
+    if (tree == NULL || buf == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (offset_trel > tree->len || len > tree->len - offset_trel)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (tree->lazy && tree->lazy_lz4)
+    {
+        /* Only whole blocks can be decompressed. */
+        uint8_t *const tree_buf = malloc(tree->len);
+        if (tree_buf == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        swicc_ret_et const ret = swicc_disk_tree_lazy_read(tree, tree_buf);
+        if (ret == SWICC_RET_SUCCESS)
+        {
+            memcpy(buf, &tree_buf[offset_trel], len);
+        }
+        free(tree_buf);
+        return ret;
+    }
+    if (tree->lazy)
+    {
+        /* Not read yet so the disk file holds exactly what is in the tree. */
+        return swicc_disk_tree_lazy_pread(tree, offset_trel, len, buf);
+    }
+    memcpy(buf, &tree->buf[offset_trel], len);
+
+    /* Overlay files are ordered by offset so they are also ordered by data. */
+    uint32_t const end = offset_trel + len;
+    for (uint32_t ovl_idx = 0U; ovl_idx < tree->overlay_count; ++ovl_idx)
+    {
+        swicc_disk_overlay_file_st const *const ovl = &tree->overlay[ovl_idx];
+        uint32_t const ovl_end = ovl->data_offset_trel + ovl->data_size;
+        /* A private record head replaces the byte right before the data. */
+        if (ovl->rcrd_head_own && ovl->data_offset_trel - 1U >= offset_trel &&
+            ovl->data_offset_trel - 1U < end)
+        {
+            buf[ovl->data_offset_trel - 1U - offset_trel] = ovl->rcrd_head;
+        }
+        if (ovl->data_offset_trel >= end)
+        {
+            break;
+        }
+        if (ovl_end <= offset_trel)
+        {
+            continue;
+        }
+        uint32_t const copy_start = ovl->data_offset_trel > offset_trel
+                                        ? ovl->data_offset_trel
+                                        : offset_trel;
+        uint32_t const copy_end = ovl_end < end ? ovl_end : end;
+        memcpy(&buf[copy_start - offset_trel],
+               &ovl->data[copy_start - ovl->data_offset_trel],
+               copy_end - copy_start);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_tree_write(swicc_disk_tree_st *const tree,
+                                   uint32_t const offset_trel,
+                                   uint32_t const len,
+                                   uint8_t const *const buf)
+{
+    if (tree == NULL || buf == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (offset_trel > tree->len || len > tree->len - offset_trel)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (tree->lazy)
+    {
+        /* A tree that was never read can't have been modified in memory. */
+        return SWICC_RET_ERROR;
+    }
+    if (!tree->shared)
+    {
+        memcpy(&tree->buf[offset_trel], buf, len);
+        return swicc_disk_tree_dirty_mark(tree, offset_trel, len);
+    }
+
+    /**
+     * Only the files in the overlay can differ from the base so the rest of the
+     * range is left to the base.
+     */
+    uint32_t const end = offset_trel + len;
+    for (uint32_t ovl_idx = 0U; ovl_idx < tree->overlay_count; ++ovl_idx)
+    {
+        swicc_disk_overlay_file_st *const ovl = &tree->overlay[ovl_idx];
+        uint32_t const ovl_end = ovl->data_offset_trel + ovl->data_size;
+        if (ovl->rcrd_head_own && ovl->data_offset_trel - 1U >= offset_trel &&
+            ovl->data_offset_trel - 1U < end)
+        {
+            ovl->rcrd_head = buf[ovl->data_offset_trel - 1U - offset_trel];
+        }
+        if (ovl->data_offset_trel >= end)
+        {
+            break;
+        }
+        if (ovl_end <= offset_trel)
+        {
+            continue;
+        }
+        uint32_t const copy_start = ovl->data_offset_trel > offset_trel
+                                        ? ovl->data_offset_trel
+                                        : offset_trel;
+        uint32_t const copy_end = ovl_end < end ? ovl_end : end;
+        if (overlay_own(tree, ovl) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        memcpy(&ovl->data[copy_start - ovl->data_offset_trel],
+               &buf[copy_start - offset_trel], copy_end - copy_start);
+    }
+    return swicc_disk_tree_dirty_mark(tree, offset_trel, len);
+}
+
 swicc_ret_et swicc_disk_file_rcrd_cnt(swicc_disk_tree_st const *const tree,
                                       swicc_fs_file_st const *const file,
                                       uint32_t *const rcrd_cnt)
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include <swicc/swicc.h>
+
+/**
+ * Internals of the disk which are shared by the parts of it in 'src/fs'. None
+ * of this is part of the API, the raw layouts can change with the disk format.
+ */
+
+/* Starting value of FNV-1a checksums. */
+#define SWICC_DISK_CHECK_FNV1A_BASIS 2166136261U
+
+/**
+ * Used when creating LUTs. The 'start' count determines that size of the
+ * smallest created LUT (measured in entry counts). If the 'start' count is too
+ * small, the LUT will be resized by the 'resize' amount.
+ */
+#define SWICC_DISK_LUT_COUNT_START 64U
+#define SWICC_DISK_LUT_COUNT_RESIZE 8U
+
+/**
+ * Header of the persisted index section. It is followed by one tree entry per
+ * tree, the ID LUT (buffer 1 then buffer 2), the name LUT, and the SID LUT of
+ * every tree (in the same order as the trees).
+ */
+typedef struct swicc_disk_index_hdr_raw_s
+{
+    uint32_t size; /* Size of the whole index section including this header. */
+    uint32_t tree_count;
+    uint32_t lutid_count;
+    uint32_t lutname_count;
+} __attribute__((packed)) swicc_disk_index_hdr_raw_st;
+
+typedef struct swicc_disk_index_tree_raw_s
+{
+    uint32_t offset; /* Offset of the tree from the start of the disk file. */
+    uint32_t len;
+    uint32_t lutsid_count;
+    uint32_t check; /* CRC32C of the tree, checked when the tree is loaded. */
+} __attribute__((packed)) swicc_disk_index_tree_raw_st;
+
+/**
+ * Entry of a tree in the index of a disk with compressed trees. The offset is
+ * the one of the compressed tree and the length is the one of the tree once
+ * decompressed.
+ */
+typedef struct swicc_disk_index_tree_lz4_raw_s
+{
+    uint32_t offset;
+    uint32_t len;
+    uint32_t lutsid_count;
+    uint32_t check;   /* CRC32C of the decompressed tree. */
+    uint32_t len_lz4; /* Equal to the length when stored uncompressed. */
+} __attribute__((packed)) swicc_disk_index_tree_lz4_raw_st;
+static_assert(offsetof(swicc_disk_index_tree_lz4_raw_st, len_lz4) ==
+                  sizeof(swicc_disk_index_tree_raw_st),
+              "Index entry of a compressed tree must extend the plain one");
+
+/* A tree of a disk that gets saved with compressed trees. */
+typedef struct swicc_disk_tree_lz4_s
+{
+    uint8_t *buf; /* What gets written to the disk file. */
+    uint32_t len;
+} swicc_disk_tree_lz4_st;
+
+/**
+ * Every journal record starts with this header and is followed by the bytes
+ * that were written to the file.
+ */
+typedef struct swicc_disk_journal_rcrd_hdr_raw_s
+{
+    uint32_t magic;
+    uint32_t offset_trel;      /* Offset of the file in the tree. */
+    uint32_t data_offset_frel; /* Offset of the bytes in the file data. */
+    uint32_t len;
+    uint32_t check; /* Checksum of the header (without this field) and bytes. */
+    uint8_t tree_idx;
+    uint8_t rcrd_head; /* Record head of a cyclic EF after the write. */
+} __attribute__((packed)) swicc_disk_journal_rcrd_hdr_raw_st;
+
+/**
+ * @brief Continue an FNV-1a checksum over some bytes.
+ * @param[in] hash Checksum of the preceding bytes (the basis for the first
+ * ones).
+ * @param[in] buf
+ * @param[in] len
+ * @return Checksum.
+ */
+uint32_t swicc_disk_check_fnv1a(uint32_t hash, uint8_t const *const buf,
+                                uint32_t const len);
+
+/**
+ * @brief Get the name of a file as it is stored in the name LUT.
+ * @param[in] file
+ * @param[out] entry_item1 Where the kind and the name will be written.
+ * @return Return code. Not found is returned for files that have no name.
+ */
+swicc_ret_et swicc_disk_lutname_item(
+    swicc_fs_file_st const *const file,
+    uint8_t entry_item1[1U + SWICC_FS_NAME_LEN]);
+
+/**
+ * @brief Check that a file with the given ID, SID, or name is located at an
+ * offset in a tree. This is used to validate the entries of a persisted index.
+ * @param[in] tree
+ * @param[in] offset_trel
+ * @param[in] id Expected ID or SWICC_FS_ID_MISSING to skip the check.
+ * @param[in] sid Expected SID or SWICC_FS_SID_MISSING to skip the check.
+ * @param[in] name Expected name LUT item or NULL to skip the check.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_index_file_check(swicc_disk_tree_st const *const tree,
+                                         uint32_t const offset_trel,
+                                         swicc_fs_id_kt const id,
+                                         swicc_fs_sid_kt const sid,
+                                         uint8_t const *const name);
+
+/**
+ * @brief Create a LUT from a persisted copy of its buffers.
+ * @param[in] alloc Allocator of the LUT buffers.
+ * @param[out] lut
+ * @param[in] size_item1
+ * @param[in] size_item2
+ * @param[in] count Number of entries in the persisted LUT.
+ * @param[in] buf Persisted buffer 1 followed by persisted buffer 2.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_index_lut_prs(swicc_alloc_st const *const alloc,
+                                      swicc_disk_lut_st *const lut,
+                                      uint32_t const size_item1,
+                                      uint32_t const size_item2,
+                                      uint32_t const count,
+                                      uint8_t const *const buf);
+
+/**
+ * @brief Check every tree of a freshly loaded disk against the checksum the
+ * index has for it.
+ * @param[in, out] disk
+ * @param[in] index The index section of the disk file.
+ * @param[in] index_len Length of the index section.
+ * @return Return code. Success is also returned when the index does not have
+ * an entry for every tree since it gets ignored then, the trees are left
+ * without a known checksum.
+ */
+swicc_ret_et swicc_disk_index_tree_check(swicc_disk_st *const disk,
+                                         uint8_t const *const index,
+                                         uint32_t const index_len);
+
+/**
+ * @brief Create all the LUTs of a freshly loaded disk from a persisted index.
+ * @param[in, out] disk
+ * @param[in] index The index section of the disk file.
+ * @param[in] index_len Length of the index section.
+ * @return Return code. On failure the LUTs are left empty.
+ */
+swicc_ret_et swicc_disk_index_prs(swicc_disk_st *const disk,
+                                  uint8_t const *const index,
+                                  uint32_t const index_len);
+
+/**
+ * @brief Read the persisted index section of a disk file.
+ * @param[in] f File positioned right after the magic.
+ * @param[out] index Will receive a buffer holding the index section, it is
+ * allocated by the C library (see 'swicc/alloc.h').
+ * @param[out] index_len Will receive the length of the index section.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_index_fread(FILE *const f, uint8_t **const index,
+                                    uint32_t *const index_len);
+
+/**
+ * @brief Write the persisted index section of a disk.
+ * @param[in] disk
+ * @param[in] f
+ * @param[in] tree_lz4 The compressed trees (in the order of the forest) when
+ * saving with compressed trees, NULL otherwise.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_index_write(
+    swicc_disk_st const *const disk, FILE *const f,
+    swicc_disk_tree_lz4_st const *const tree_lz4);
+
+/**
+ * @brief Sort the entries of a LUT such that item 1 of all entries is in
+ * increasing order (as compared by memcmp). This is an LSD radix sort over the
+ * bytes of item 1 so it takes linear time. Entries with equal item 1 end up in
+ * reverse order of being appended.
+ * @param[in] alloc Allocator of the LUT buffers.
+ * @param[in, out] lut
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_lut_sort(swicc_alloc_st const *const alloc,
+                                 swicc_disk_lut_st *const lut);
+
+/**
+ * @brief Create all the LUTs of a freshly loaded disk.
+ * @param[in, out] disk
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_lut_rebuild(swicc_disk_st *const disk);
+
+/**
+ * @brief Create the SID LUT of a tree which does not need a disk for it.
+ * @param[in, out] tree
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_tree_lutsid_rebuild(swicc_disk_tree_st *const tree);
+
+/* Userdata of the callback that rebuilds the ID (and name) LUT. */
+typedef struct swicc_disk_lutid_rebuild_cb_userdata_s
+{
+    swicc_disk_lut_st *lut;
+    swicc_disk_lut_st *lutname;
+    uint8_t tree_idx;
+} swicc_disk_lutid_rebuild_cb_userdata_st;
+
+/**
+ * @brief Callback used when rebuilding the ID LUT. It receives files and
+ * inserts their info into the ID LUT.
+ * @param[in] tree
+ * @param[in] file
+ * @param[in] userdata This must point to the userdata struct.
+ * @return Return code.
+ */
+swicc_disk_file_foreach_cb swicc_disk_lutid_rebuild_cb;
+
+/**
+ * @brief Traverse a tree with a callback that also collects file descriptors,
+ * and attach them to the tree on success.
+ * @param[in, out] tree
+ * @param[in] cb Callback to run after the descriptor of a file was collected.
+ * May be NULL.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_descr_foreach(swicc_disk_tree_st *const tree,
+                                      swicc_disk_file_foreach_cb *const cb);
+
+/**
+ * @brief Read bytes of a tree that is not in memory yet as they are in the disk
+ * file, either from the file descriptor or from the remote of the tree.
+ * @param[in] tree
+ * @param[in] offset Offset of the bytes from the start of the tree in the file.
+ * @param[in] len Number of bytes to read.
+ * @param[out] buf Where to write the bytes.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_tree_lazy_pread(swicc_disk_tree_st const *const tree,
+                                        uint32_t const offset,
+                                        uint32_t const len, uint8_t *const buf);
+
+/**
+ * @brief Read a whole tree that is not in memory yet from the disk file and
+ * decompress it (if it is compressed).
+ * @param[in] tree
+ * @param[out] buf Where to write the tree, it must fit the length of the tree.
+ * @return Return code.
+ */
+swicc_ret_et swicc_disk_tree_lazy_read(swicc_disk_tree_st const *const tree,
+                                       uint8_t *const buf);
@@ -0,0 +1,352 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/* How many bytes of a buffer get written on one line. */
+#define DISKC_LINE_BYTE_COUNT 12U
+
+/* Trees are read through the overlay in chunks of this size. */
+#define DISKC_TREE_CHUNK_SIZE 4096U
+
+/**
+ * @brief Check if a string can be used as a C identifier.
+ * @param name
+ * @return True if it can, false otherwise.
+ */
+static bool diskc_name_valid(char const *const name)
+{
+    size_t const name_len = strlen(name);
+    if (name_len == 0U || name_len > SWICC_DISKC_NAME_LEN_MAX ||
+        isdigit((unsigned char)name[0U]))
+    {
+        return false;
+    }
+    for (size_t char_idx = 0U; char_idx < name_len; ++char_idx)
+    {
+        /* Only ASCII is accepted regardless of the locale. */
+        char const c = name[char_idx];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              (c >= '0' && c <= '9') || c == '_'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write the initializer elements of a byte array.
+ * @param f
+ * @param buf
+ * @param len
+ * @param offset Offset of the first byte in the whole array, used to know
+ * where lines end when the array is written in parts.
+ */
+static void diskc_bytes(FILE *const f, uint8_t const *const buf,
+                        uint32_t const len, uint32_t const offset)
+{
+    for (uint32_t byte_idx = 0U; byte_idx < len; ++byte_idx)
+    {
+        uint32_t const col = (offset + byte_idx) % DISKC_LINE_BYTE_COUNT;
+        fprintf(f, "%s0x%02X,%s", col == 0U ? "    " : " ", buf[byte_idx],
+                col == DISKC_LINE_BYTE_COUNT - 1U ? "\n" : "");
+    }
+}
+
+/**
+ * @brief Write the buffer of a tree (as seen through the overlay).
+ * @param f
+ * @param name
+ * @param tree_idx
+ * @param tree
+ * @return Return code.
+ */
+static swicc_ret_et diskc_tree_buf(FILE *const f, char const *const name,
+                                   uint32_t const tree_idx,
+                                   swicc_disk_tree_st const *const tree)
+{
+    fprintf(f,
+            "static uint8_t const %s_tree%u_buf[%u] SWICC_DISKC_RODATA = {\n",
+            name, tree_idx, tree->len);
+    uint8_t chunk[DISKC_TREE_CHUNK_SIZE];
+    for (uint32_t offset = 0U; offset < tree->len;
+         offset += DISKC_TREE_CHUNK_SIZE)
+    {
+        uint32_t const chunk_len = tree->len - offset < DISKC_TREE_CHUNK_SIZE
+                                       ? tree->len - offset
+                                       : DISKC_TREE_CHUNK_SIZE;
+        if (swicc_disk_tree_read(tree, offset, chunk_len, chunk) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        diskc_bytes(f, chunk, chunk_len, offset);
+    }
+    fprintf(f, "%s};\n\n", tree->len % DISKC_LINE_BYTE_COUNT == 0U ? "" : "\n");
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Write both buffers of a LUT (if it is not empty).
+ * @param f
+ * @param name
+ * @param lut_name Name of the LUT in the generated array names.
+ * @param lut
+ */
+static void diskc_lut_buf(FILE *const f, char const *const name,
+                          char const *const lut_name,
+                          swicc_disk_lut_st const *const lut)
+{
+    if (lut->count == 0U)
+    {
+        return;
+    }
+    uint32_t const len1 = lut->count * lut->size_item1;
+    uint32_t const len2 = lut->count * lut->size_item2;
+    fprintf(f, "static uint8_t const %s_%s1[%u] SWICC_DISKC_RODATA = {\n", name,
+            lut_name, len1);
+    diskc_bytes(f, lut->buf1, len1, 0U);
+    fprintf(f, "%s};\n", len1 % DISKC_LINE_BYTE_COUNT == 0U ? "" : "\n");
+    fprintf(f, "static uint8_t const %s_%s2[%u] SWICC_DISKC_RODATA = {\n", name,
+            lut_name, len2);
+    diskc_bytes(f, lut->buf2, len2, 0U);
+    fprintf(f, "%s};\n\n", len2 % DISKC_LINE_BYTE_COUNT == 0U ? "" : "\n");
+}
+
+/**
+ * @brief Write the initializer of a LUT struct. The LUT is full so it can
+ * never be appended to.
+ * @param f
+ * @param name
+ * @param lut_name Name of the LUT in the generated array names.
+ * @param lut
+ * @param indent Indentation of the member the LUT initializes.
+ */
+static void diskc_lut_struct(FILE *const f, char const *const name,
+                             char const *const lut_name,
+                             swicc_disk_lut_st const *const lut,
+                             char const *const indent)
+{
+    fprintf(f, "{\n");
+    fprintf(f, "%s    .count_max = %uU,\n", indent, lut->count);
+    fprintf(f, "%s    .count = %uU,\n", indent, lut->count);
+    if (lut->count > 0U)
+    {
+        fprintf(f, "%s    .buf1 = (uint8_t *)%s_%s1,\n", indent, name,
+                lut_name);
+    }
+    fprintf(f, "%s    .size_item1 = %uU,\n", indent, lut->size_item1);
+    if (lut->count > 0U)
+    {
+        fprintf(f, "%s    .buf2 = (uint8_t *)%s_%s2,\n", indent, name,
+                lut_name);
+    }
+    fprintf(f, "%s    .size_item2 = %uU,\n", indent, lut->size_item2);
+    fprintf(f, "%s},\n", indent);
+}
+
+/**
+ * @brief Write the descriptors of a tree (if it has any).
+ * @param f
+ * @param name
+ * @param tree_idx
+ * @param tree
+ */
+static void diskc_tree_descr(FILE *const f, char const *const name,
+                             uint32_t const tree_idx,
+                             swicc_disk_tree_st const *const tree)
+{
+    if (tree->descr_count == 0U)
+    {
+        return;
+    }
+    fprintf(f,
+            "static swicc_disk_descr_st const %s_tree%u_descr[%u] "
+            "SWICC_DISKC_RODATA = {\n",
+            name, tree_idx, tree->descr_count);
+    for (uint32_t descr_idx = 0U; descr_idx < tree->descr_count; ++descr_idx)
+    {
+        swicc_disk_descr_st const *const descr = &tree->descr[descr_idx];
+        fprintf(f,
+                "    {.offset_trel = %uU, .offset_prel = %uU, .size = %uU,\n"
+                "     .parent_idx = %uU, .id = 0x%04X, .sid = 0x%02X,\n"
+                "     .type = %u, .lcs = %u, .rcrd_size = %u},\n",
+                descr->offset_trel, descr->offset_prel, descr->size,
+                descr->parent_idx, descr->id, descr->sid, descr->type,
+                descr->lcs, descr->rcrd_size);
+    }
+    fprintf(f, "};\n\n");
+}
+
+/**
+ * @brief Write the initializer of a tree struct.
+ * @param f
+ * @param name
+ * @param tree_idx
+ * @param tree_count
+ * @param tree
+ */
+static void diskc_tree_struct(FILE *const f, char const *const name,
+                              uint32_t const tree_idx,
+                              uint32_t const tree_count,
+                              swicc_disk_tree_st const *const tree)
+{
+    char lut_name[32U];
+    snprintf(lut_name, sizeof(lut_name), "tree%u_lutsid", tree_idx);
+    fprintf(f, "    {\n");
+    if (tree_idx + 1U < tree_count)
+    {
+        fprintf(f, "        .next = (swicc_disk_tree_st *)&%s_tree[%u],\n",
+                name, tree_idx + 1U);
+    }
+    fprintf(f, "        .size = %uU,\n", tree->len);
+    fprintf(f, "        .len = %uU,\n", tree->len);
+    if (tree->len > 0U)
+    {
+        fprintf(f, "        .buf = (uint8_t *)%s_tree%u_buf,\n", name,
+                tree_idx);
+    }
+    fprintf(f, "        .lutsid = ");
+    diskc_lut_struct(f, name, lut_name, &tree->lutsid, "        ");
+    fprintf(f, "        .lutsid_direct = {\n");
+    for (uint32_t sid = 0U; sid < SWICC_DISK_LUTSID_DIRECT_COUNT; ++sid)
+    {
+        fprintf(f, "%s0x%08XU,%s", sid % 4U == 0U ? "            " : " ",
+                tree->lutsid_direct[sid], sid % 4U == 3U ? "\n" : "");
+    }
+    fprintf(f, "        },\n");
+    if (tree->descr_count > 0U)
+    {
+        fprintf(f, "        .descr = (swicc_disk_descr_st *)%s_tree%u_descr,\n",
+                name, tree_idx);
+    }
+    fprintf(f, "        .descr_count = %uU,\n", tree->descr_count);
+    fprintf(f, "    },\n");
+}
+
+swicc_ret_et swicc_diskc_gen(swicc_disk_st const *const disk,
+                             char const *const c_path, char const *const name)
+{
+    if (disk == NULL || c_path == NULL || name == NULL ||
+        !diskc_name_valid(name))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->root == NULL || disk->lutid_tree_count == 0U)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Descriptors and SID LUTs only exist for trees that are in memory. */
+    for (uint32_t tree_idx = 0U; tree_idx < disk->lutid_tree_count; ++tree_idx)
+    {
+        if (swicc_disk_tree_load(disk->lutid_tree[tree_idx]) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    FILE *const f = fopen(c_path, "w");
+    if (f == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+
+    // clang-format off
+    fprintf(f,
+        "/* Generated from a swICC disk by 'swicc_diskc_gen', do not edit. */\n"
+        "#include <swicc/swicc.h>\n"
+        "\n"
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        "#if __BYTE_ORDER != __LITTLE_ENDIAN\n"
+        "#error \"This disk was generated for a little-endian machine.\"\n"
+#else
+        "#if __BYTE_ORDER != __BIG_ENDIAN\n"
+        "#error \"This disk was generated for a big-endian machine.\"\n"
+#endif
+        "#endif\n"
+        "\n"
+        "#ifndef SWICC_DISKC_RODATA\n"
+        "#define SWICC_DISKC_RODATA\n"
+        "#endif\n"
+        "\n");
+    // clang-format on
+
+    for (uint32_t tree_idx = 0U; tree_idx < disk->lutid_tree_count; ++tree_idx)
+    {
+        swicc_disk_tree_st const *const tree = disk->lutid_tree[tree_idx];
+        char lut_name[32U];
+        snprintf(lut_name, sizeof(lut_name), "tree%u_lutsid", tree_idx);
+        if (tree->len > 0U)
+        {
+            ret = diskc_tree_buf(f, name, tree_idx, tree);
+            if (ret != SWICC_RET_SUCCESS)
+            {
+                break;
+            }
+        }
+        diskc_lut_buf(f, name, lut_name, &tree->lutsid);
+        diskc_tree_descr(f, name, tree_idx, tree);
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        diskc_lut_buf(f, name, "lutid", &disk->lutid);
+        diskc_lut_buf(f, name, "lutname", &disk->lutname);
+
+        /**
+         * The structs are constant as well since the disk is only used as the
+         * base of overlays which never write to the trees of their base.
+         */
+        fprintf(f,
+                "static swicc_disk_tree_st const %s_tree[%u] "
+                "SWICC_DISKC_RODATA = {\n",
+                name, disk->lutid_tree_count);
+        for (uint32_t tree_idx = 0U; tree_idx < disk->lutid_tree_count;
+             ++tree_idx)
+        {
+            diskc_tree_struct(f, name, tree_idx, disk->lutid_tree_count,
+                              disk->lutid_tree[tree_idx]);
+        }
+        fprintf(f, "};\n\n");
+
+        fprintf(f,
+                "static swicc_disk_tree_st *const %s_lutid_tree[%u] "
+                "SWICC_DISKC_RODATA = {\n",
+                name, disk->lutid_tree_count);
+        for (uint32_t tree_idx = 0U; tree_idx < disk->lutid_tree_count;
+             ++tree_idx)
+        {
+            fprintf(f, "    (swicc_disk_tree_st *)&%s_tree[%u],\n", name,
+                    tree_idx);
+        }
+        fprintf(f, "};\n\n");
+
+        fprintf(f, "swicc_disk_st const %s SWICC_DISKC_RODATA = {\n", name);
+        fprintf(f, "    .root = (swicc_disk_tree_st *)&%s_tree[0],\n", name);
+        fprintf(f, "    .lutid = ");
+        diskc_lut_struct(f, name, "lutid", &disk->lutid, "    ");
+        fprintf(f, "    .lutid_tree = (swicc_disk_tree_st **)%s_lutid_tree,\n",
+                name);
+        fprintf(f, "    .lutid_tree_count = %uU,\n", disk->lutid_tree_count);
+        fprintf(f, "    .lutname = ");
+        diskc_lut_struct(f, name, "lutname", &disk->lutname, "    ");
+        fprintf(f, "};\n");
+    }
+
+    if (ferror(f))
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    if (fclose(f) != 0)
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        /* Don't leave a partial file behind that could get compiled. */
+        remove(c_path);
+    }
+    return ret;
+}
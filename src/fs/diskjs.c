@@ -1,8 +1,13 @@
 #include <cJSON.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <swicc/swicc.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 /**
  * @warning The following 2 arrays (and the count variable) must be kept in sync
@@ -39,10 +44,12 @@ static_assert(
 
 /**
  * Used when creating a swICC FS disk. The 'start' size is the initial buffer
- * size, and if it's not large enough, it will grow by the 'resize' amount.
+ * size, and if it's not large enough, it will be multiplied by the 'growth'
+ * factor. Growing geometrically keeps the number of times a large tree has to
+ * be parsed again logarithmic in its size.
  */
 #define DISK_SIZE_START 4096U
-#define DISK_SIZE_RESIZE 4096U
+#define DISK_SIZE_GROWTH 2U
 
 /**
  * A function type for item type parsers i.e. parsers that parse a specific type
@@ -800,12 +807,31 @@ static swicc_ret_et jsitem_prs_file_ef_cyclic(cJSON const *const item_json,
         return SWICC_RET_PARAM_BAD;
     }
 
+    /**
+     * The records are parsed like those of a linear-fixed EF, then moved to
+     * make room for the record head at the end of the header.
+     */
+    if (*buf_len < 1U)
+    {
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+    uint32_t buf_len_lf = *buf_len - 1U;
     swicc_ret_et const ret = jsitem_prs[SWICC_FS_ITEM_TYPE_FILE_EF_LINEARFIXED](
-        item_json, offset_prel, buf, buf_len);
+        item_json, offset_prel, buf, &buf_len_lf);
     if (ret == SWICC_RET_SUCCESS)
     {
+        uint32_t const hdr_len_lf =
+            swicc_fs_item_hdr_raw_size[SWICC_FS_ITEM_TYPE_FILE_EF_LINEARFIXED];
+        memmove(&buf[hdr_len_lf + 1U], &buf[hdr_len_lf],
+                buf_len_lf - hdr_len_lf);
         swicc_fs_file_raw_st *file_raw = (swicc_fs_file_raw_st *)buf;
+        swicc_fs_ef_cyclic_hdr_raw_st *const ef_hdr_raw =
+            (swicc_fs_ef_cyclic_hdr_raw_st *)file_raw->data;
         file_raw->hdr_item.type = SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC;
+        file_raw->hdr_item.size = buf_len_lf + 1U;
+        /* The first record in the JSON is the most recent one. */
+        ef_hdr_raw->rcrd_head = 0U;
+        *buf_len = file_raw->hdr_item.size;
     }
     return ret;
 }
@@ -1255,190 +1281,738 @@ static jsitem_prs_ft *const jsitem_prs[] = {
 };
 
 /**
- * @brief Parse the JSON of a disk into an in-memory representation (swICC FS
- * disk format).
- * @param disk Disk structure to populate.
- * @param disk_json Disk in JSON format.
+ * @brief Compile the JSON of one tree into the swICC FS disk format and create
+ * the SID LUT of the tree.
+ * @param disk Disk the tree belongs to.
+ * @param tree Tree to populate. Must be zeroed except for the link to the next
+ * tree. On failure the tree may own a buffer that is freed when the root is
+ * emptied.
+ * @param tree_json JSON of the root file of the tree.
  * @return Return code.
  */
-static swicc_ret_et disk_json_prs(swicc_disk_st *const disk,
-                                  cJSON const *const disk_json)
+static swicc_ret_et tree_json_prs(swicc_disk_st *const disk,
+                                  swicc_disk_tree_st *const tree,
+                                  cJSON const *const tree_json)
 {
-    if (disk == NULL || disk_json == NULL || cJSON_IsObject(disk_json) != true)
-    {
-        return SWICC_RET_PARAM_BAD;
-    }
-
-    swicc_ret_et ret = SWICC_RET_SUCCESS;
-    if (disk->root != NULL)
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    tree->buf = swicc_alloc_malloc(tree->alloc, DISK_SIZE_START);
+    if (tree->buf == NULL)
     {
-        fprintf(stderr, "Root: Old disk must be unloaded first.\n");
+        fprintf(stderr, "Tree: Failed to allocate a tree buffer.\n");
         return SWICC_RET_ERROR;
     }
+    tree->size = DISK_SIZE_START;
+    tree->len = 0U;
 
-    uint8_t tree_count = 0U;
-    cJSON *const disk_obj = cJSON_GetObjectItemCaseSensitive(disk_json, "disk");
-    if (disk_obj != NULL && cJSON_IsArray(disk_obj) == true)
+    uint32_t item_size;
+    do
     {
-        cJSON *tree_obj;
-        swicc_disk_tree_st *tree = NULL;
-        cJSON_ArrayForEach(tree_obj, disk_obj)
+        item_size = tree->size - tree->len;
+        ret = jsitem_prs_demux(tree_json, 0U, &tree->buf[tree->len],
+                               &item_size);
+        if (ret == SWICC_RET_BUFFER_TOO_SHORT)
         {
-            /**
-             * Check if this is the first item in the root. If so, add a
-             * reference to the forest of trees (linked list) to the disk root.
-             */
-            if (tree == NULL)
+            uint64_t tree_buf_size_new =
+                (uint64_t)tree->size * DISK_SIZE_GROWTH;
+            if (tree_buf_size_new > UINT32_MAX)
             {
-                tree = malloc(sizeof(*tree));
-                if (tree == NULL)
+                /* Try the largest size that is still possible. */
+                tree_buf_size_new = UINT32_MAX;
+            }
+            uint8_t *const buf_new = swicc_alloc_realloc(
+                tree->alloc, tree->buf, tree->size, tree_buf_size_new);
+            if (buf_new != NULL)
+            {
+                if (tree_buf_size_new == tree->size)
                 {
-                    fprintf(
-                        stderr,
-                        "Tree: Failed to allocate space for a tree struct for the root tree.\n");
-                    /* Nothing should have been allocated before. */
+                    fprintf(stderr,
+                            "Tree: Buffer size limit has been reached.\n");
                     ret = SWICC_RET_ERROR;
-                    break;
+                    /**
+                     * No break because we still have to update the tree so it
+                     * gets properly freed later.
+                     */
                 }
-                disk->root = tree;
+                tree->buf = buf_new;
+                /* Safe cast due to the bound check against uint32 max. */
+                tree->size = (uint32_t)tree_buf_size_new;
+                fprintf(stderr, "Tree: Allocated more memory, retrying.\n");
             }
             else
             {
-                tree->next = malloc(sizeof(*tree));
-                if (tree->next == NULL)
+                fprintf(
+                    stderr,
+                    "Tree: Failed to realloc tree buffer from %u bytes to %llu bytes.\n",
+                    tree->size, (unsigned long long)tree_buf_size_new);
+                ret = SWICC_RET_ERROR;
+                break;
+            }
+        }
+        else if (ret != SWICC_RET_SUCCESS)
+        {
+            fprintf(stderr, "Tree: Failed to parse tree JSON: %s.\n",
+                    swicc_dbg_ret_str(ret));
+        }
+    } while (ret == SWICC_RET_BUFFER_TOO_SHORT);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Tree: Failed to parse tree contents: %s.\n",
+                swicc_dbg_ret_str(ret));
+        return ret;
+    }
+
+    /**
+     * Each tree contains exactly one file so the tree length equals to the root
+     * element length.
+     */
+    tree->len = item_size;
+
+    ret = swicc_disk_lutsid_rebuild(disk, tree);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        /**
+         * No need to clean up SID LUT since this will be done when whole root
+         * get emptied due to this error.
+         */
+        fprintf(stderr, "Tree: Failed to create the SID LUT: %s.\n",
+                swicc_dbg_ret_str(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief Create the ID LUT of a disk whose trees were all parsed and make sure
+ * no folder contains 2 files with the same ID.
+ * @param disk
+ * @return Return code.
+ */
+static swicc_ret_et disk_json_finish(swicc_disk_st *const disk)
+{
+    swicc_ret_et ret = swicc_disk_lutid_rebuild(disk);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Root: Failed to rebuild ID LUT.\n");
+        swicc_disk_lutid_empty(disk);
+        return ret;
+    }
+
+    swicc_disk_tree_st *tree_dup;
+    swicc_fs_file_st file_dup;
+    if (swicc_disk_lutid_dup_find(disk, &tree_dup, &file_dup) ==
+        SWICC_RET_SUCCESS)
+    {
+        fprintf(
+            stderr,
+            "Root: File ID %04X at offset %u of a tree is also used by another file in the same folder.\n",
+            file_dup.hdr_file.id, file_dup.hdr_item.offset_trel);
+        swicc_disk_unload(disk);
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * The tree index in the ID LUT is 1 byte so a disk can't have more trees than
+ * this.
+ */
+#define DISKJS_TREE_COUNT_MAX 256U
+
+/**
+ * Location of the JSON of one tree inside the JSON of the whole disk, and the
+ * tree it gets compiled into.
+ */
+typedef struct diskjs_tree_job_s
+{
+    uint32_t json_offset;
+    uint32_t json_len;
+    swicc_disk_tree_st *tree;
+} diskjs_tree_job_st;
+
+/**
+ * Trees of a disk that are compiled by a group of workers. Every worker takes
+ * the next tree that nobody has taken yet until none are left.
+ */
+typedef struct diskjs_job_s
+{
+    swicc_disk_st *disk;
+    char const *json;
+    diskjs_tree_job_st tree[DISKJS_TREE_COUNT_MAX];
+    uint32_t tree_count;
+    _Atomic uint32_t tree_next;
+    _Atomic bool failed;
+
+    /* Directory of the compile cache, NULL when not using a cache. */
+    char const *cache_path;
+} diskjs_job_st;
+
+/**
+ * Compiled trees are cached in files named after the hash of the JSON of the
+ * tree. The compiled tree depends on how diskjs encodes items so the magic
+ * must change whenever the encoding does.
+ */
+#define DISKJS_CACHE_MAGIC 0x32304A43U /* "CJ02" */
+#define DISKJS_CACHE_FILE_SUFFIX ".swiccjc"
+
+/**
+ * Header of a cache file. It is followed by the JSON of the tree and then the
+ * compiled tree. The JSON is stored to rule out hash collisions.
+ */
+typedef struct diskjs_cache_hdr_s
+{
+    uint32_t magic;
+    uint32_t json_len;
+    uint32_t tree_len;
+    uint32_t tree_check; /* FNV-1a of the compiled tree. */
+} diskjs_cache_hdr_st;
+
+/**
+ * @brief Get the index of the first non-whitespace character.
+ * @param json
+ * @param json_len
+ * @param idx Where to start looking.
+ * @return Index of the character or the JSON length if there is none.
+ */
+static uint32_t json_ws_skip(char const *const json, uint32_t const json_len,
+                             uint32_t idx)
+{
+    while (idx < json_len && (json[idx] == ' ' || json[idx] == '\t' ||
+                              json[idx] == '\r' || json[idx] == '\n'))
+    {
+        ++idx;
+    }
+    return idx;
+}
+
+/**
+ * @brief Skip over one JSON value without parsing it. Only strings and the
+ * nesting of objects and arrays is tracked, everything else gets checked by
+ * cJSON once the value is parsed (if it ever is).
+ * @param json
+ * @param json_len
+ * @param[in, out] idx Index of the first character of the value. Will receive
+ * the index of the first character after the value.
+ * @return Return code.
+ */
+static swicc_ret_et json_value_skip(char const *const json,
+                                    uint32_t const json_len,
+                                    uint32_t *const idx)
+{
+    uint32_t depth = 0U;
+    uint32_t idx_cur = *idx;
+    do
+    {
+        if (idx_cur >= json_len)
+        {
+            return SWICC_RET_ERROR;
+        }
+        char const c = json[idx_cur];
+        if (c == '"')
+        {
+            for (++idx_cur; idx_cur < json_len && json[idx_cur] != '"';
+                 ++idx_cur)
+            {
+                if (json[idx_cur] == '\\')
                 {
-                    fprintf(
-                        stderr,
-                        "Tree: Failed to allocate a tree struct for next tree.\n");
-                    ret = SWICC_RET_ERROR;
-                    break;
+                    ++idx_cur;
                 }
-                tree = tree->next;
             }
+            if (idx_cur >= json_len)
+            {
+                return SWICC_RET_ERROR;
+            }
+            ++idx_cur;
+        }
+        else if (c == '{' || c == '[')
+        {
+            ++depth;
+            ++idx_cur;
+        }
+        else if (c == '}' || c == ']')
+        {
+            if (depth == 0U)
+            {
+                return SWICC_RET_ERROR;
+            }
+            --depth;
+            ++idx_cur;
+        }
+        else if (depth > 0U)
+        {
+            ++idx_cur;
+        }
+        else
+        {
+            /* A number or a literal which ends where the next token starts. */
+            uint32_t const idx_start = idx_cur;
+            while (idx_cur < json_len && json[idx_cur] != ',' &&
+                   json[idx_cur] != '}' && json[idx_cur] != ']' &&
+                   json_ws_skip(json, json_len, idx_cur) == idx_cur)
+            {
+                ++idx_cur;
+            }
+            if (idx_cur == idx_start)
+            {
+                return SWICC_RET_ERROR;
+            }
+        }
+    } while (depth > 0U);
+    *idx = idx_cur;
+    return SWICC_RET_SUCCESS;
+}
 
-            memset(tree, 0U, sizeof(*tree));
-            tree->buf = malloc(DISK_SIZE_START);
-            if (tree->buf == NULL)
+/**
+ * @brief Find the JSON of every tree in the 'disk' array of a disk JSON
+ * without parsing the trees themselves.
+ * @param[in, out] job Receives the location of each tree and the tree count.
+ * @param json_len Length of the JSON of the job.
+ * @return Return code.
+ */
+static swicc_ret_et disk_json_split(diskjs_job_st *const job,
+                                    uint32_t const json_len)
+{
+    char const *const json = job->json;
+    uint32_t idx = json_ws_skip(json, json_len, 0U);
+    if (idx >= json_len || json[idx] != '{')
+    {
+        fprintf(stderr, "Root: Disk JSON is not an object.\n");
+        return SWICC_RET_ERROR;
+    }
+    idx = json_ws_skip(json, json_len, idx + 1U);
+
+    bool disk_found = false;
+    job->tree_count = 0U;
+    while (idx < json_len && json[idx] != '}')
+    {
+        if (json[idx] != '"')
+        {
+            return SWICC_RET_ERROR;
+        }
+        uint32_t const key_start = idx;
+        if (json_value_skip(json, json_len, &idx) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        /* Compared with the quotes included. */
+        bool const key_disk = disk_found == false && idx - key_start == 6U &&
+                              memcmp(&json[key_start], "\"disk\"", 6U) == 0;
+        idx = json_ws_skip(json, json_len, idx);
+        if (idx >= json_len || json[idx] != ':')
+        {
+            return SWICC_RET_ERROR;
+        }
+        idx = json_ws_skip(json, json_len, idx + 1U);
+
+        if (key_disk == true)
+        {
+            if (idx >= json_len || json[idx] != '[')
             {
-                fprintf(stderr, "Tree: Failed to allocate a tree buffer.\n");
-                ret = SWICC_RET_ERROR;
                 break;
             }
-            tree->size = DISK_SIZE_START;
-            tree->len = 0U;
-
-            uint32_t item_size;
-            do
+            disk_found = true;
+            idx = json_ws_skip(json, json_len, idx + 1U);
+            while (idx < json_len && json[idx] != ']')
             {
-                item_size = tree->size - tree->len;
-                ret = jsitem_prs_demux(tree_obj, 0U, &tree->buf[tree->len],
-                                       &item_size);
-                if (ret == SWICC_RET_BUFFER_TOO_SHORT)
+                if (job->tree_count >= DISKJS_TREE_COUNT_MAX)
                 {
-                    uint8_t *const buf_new =
-                        realloc(tree->buf, tree->size + DISK_SIZE_RESIZE);
-                    if (buf_new != NULL)
-                    {
-                        uint64_t const tree_buf_size_new =
-                            tree->size + DISK_SIZE_RESIZE;
-                        if (tree_buf_size_new > UINT32_MAX)
-                        {
-                            fprintf(
-                                stderr,
-                                "Tree: Buffer size limit has been reached.\n");
-                            ret = SWICC_RET_ERROR;
-                            /**
-                             * No break because we still have to update the tree
-                             * so it gets properly freed later.
-                             */
-                        }
-                        tree->buf = buf_new;
-                        /**
-                         * Safe cast due to the bound check against uint32 max.
-                         */
-                        tree->size = (uint32_t)tree_buf_size_new;
-                        fprintf(stderr,
-                                "Tree: Allocated more memory, retrying.\n");
-                    }
-                    else
-                    {
-                        fprintf(
-                            stderr,
-                            "Tree: Failed to realloc tree buffer from %u bytes to %u bytes.\n",
-                            tree->size, tree->size + DISK_SIZE_RESIZE);
-                        ret = SWICC_RET_ERROR;
-                        break;
-                    }
+                    fprintf(stderr, "Root: Disk has more than %u trees.\n",
+                            DISKJS_TREE_COUNT_MAX);
+                    return SWICC_RET_ERROR;
+                }
+                uint32_t const tree_start = idx;
+                if (json_value_skip(json, json_len, &idx) != SWICC_RET_SUCCESS)
+                {
+                    return SWICC_RET_ERROR;
+                }
+                job->tree[job->tree_count].json_offset = tree_start;
+                job->tree[job->tree_count].json_len = idx - tree_start;
+                job->tree_count += 1U;
+
+                idx = json_ws_skip(json, json_len, idx);
+                if (idx < json_len && json[idx] == ',')
+                {
+                    idx = json_ws_skip(json, json_len, idx + 1U);
                 }
-                else if (ret != SWICC_RET_SUCCESS)
+                else if (idx >= json_len || json[idx] != ']')
                 {
-                    fprintf(stderr, "Tree: Failed to parse tree JSON: %s.\n",
-                            swicc_dbg_ret_str(ret));
+                    return SWICC_RET_ERROR;
                 }
-            } while (ret == SWICC_RET_BUFFER_TOO_SHORT);
-            if (ret != SWICC_RET_SUCCESS)
+            }
+            if (idx >= json_len)
             {
-                fprintf(stderr, "Tree: Failed to parse tree contents: %s.\n",
-                        swicc_dbg_ret_str(ret));
-                break;
+                return SWICC_RET_ERROR;
             }
+            ++idx;
+        }
+        else if (json_value_skip(json, json_len, &idx) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
 
-            /**
-             * Each tree contains exactly one file so the tree length equals to
-             * the root element length.
-             */
-            tree->len = item_size;
+        idx = json_ws_skip(json, json_len, idx);
+        if (idx < json_len && json[idx] == ',')
+        {
+            idx = json_ws_skip(json, json_len, idx + 1U);
+        }
+        else if (idx >= json_len || json[idx] != '}')
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    if (idx >= json_len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (disk_found == false)
+    {
+        fprintf(stderr, "Root: 'disk' missing or not of type: array.\n");
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
 
-            ret = swicc_disk_lutsid_rebuild(disk, tree);
-            if (ret != SWICC_RET_SUCCESS)
-            {
-                /**
-                 * No need to clean up SID LUT since this will be done when
-                 * whole root get emptied due to this error.
-                 */
-                fprintf(stderr, "Tree: Failed to create the SID LUT: %s.\n",
-                        swicc_dbg_ret_str(ret));
-                break;
-            }
+/**
+ * @brief Compute a 32-bit FNV-1a hash.
+ * @param buf
+ * @param buf_len
+ * @return The hash.
+ */
+static uint32_t cache_check(uint8_t const *const buf, uint32_t const buf_len)
+{
+    uint32_t hash = 2166136261U;
+    for (uint32_t byte_idx = 0U; byte_idx < buf_len; ++byte_idx)
+    {
+        hash = (hash ^ buf[byte_idx]) * 16777619U;
+    }
+    return hash;
+}
 
-            /**
-             * Unsafe case which relies on there being fewer than 256 trees in
-             * the root.
-             */
-            tree_count = (uint8_t)(tree_count + 1U);
+/**
+ * @brief Create the path of the cache file that holds the compiled tree of a
+ * tree JSON. The name is a 64-bit FNV-1a hash of the JSON.
+ * @param job
+ * @param tree_job
+ * @return The path which must be freed by the caller, NULL on failure.
+ */
+static char *cache_file_path(diskjs_job_st const *const job,
+                             diskjs_tree_job_st const *const tree_job)
+{
+    char const *const tree_json = &job->json[tree_job->json_offset];
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint32_t char_idx = 0U; char_idx < tree_job->json_len; ++char_idx)
+    {
+        hash = (hash ^ (uint8_t)tree_json[char_idx]) * 1099511628211ULL;
+    }
+
+    /* Separator, 16 hex digits, suffix and null-terminator. */
+    size_t const path_len = strlen(job->cache_path) + 1U + 16U +
+                            sizeof(DISKJS_CACHE_FILE_SUFFIX);
+    char *const path = malloc(path_len);
+    if (path != NULL)
+    {
+        snprintf(path, path_len, "%s/%016llx%s", job->cache_path,
+                 (unsigned long long)hash, DISKJS_CACHE_FILE_SUFFIX);
+    }
+    return path;
+}
+
+/**
+ * @brief Read a compiled tree from the compile cache.
+ * @param job
+ * @param tree_job Tree to populate. On failure the tree does not own a buffer.
+ * @return Return code. Not found is returned when the tree is not cached.
+ */
+static swicc_ret_et cache_load(diskjs_job_st const *const job,
+                               diskjs_tree_job_st *const tree_job)
+{
+    char *const path = cache_file_path(job, tree_job);
+    if (path == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    int const fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+
+    swicc_ret_et ret = SWICC_RET_FS_NOT_FOUND;
+    swicc_disk_tree_st *const tree = tree_job->tree;
+    diskjs_cache_hdr_st hdr;
+    char *json_cached = NULL;
+    if (pread(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+        hdr.magic == DISKJS_CACHE_MAGIC &&
+        hdr.json_len == tree_job->json_len && hdr.tree_len > 0U)
+    {
+        json_cached = malloc(hdr.json_len);
+        tree->buf = swicc_alloc_malloc(tree->alloc, hdr.tree_len);
+    }
+    if (json_cached != NULL && tree->buf != NULL &&
+        pread(fd, json_cached, hdr.json_len, sizeof(hdr)) ==
+            (ssize_t)hdr.json_len &&
+        memcmp(json_cached, &job->json[tree_job->json_offset],
+               hdr.json_len) == 0 &&
+        pread(fd, tree->buf, hdr.tree_len,
+              (off_t)sizeof(hdr) + hdr.json_len) == (ssize_t)hdr.tree_len &&
+        cache_check(tree->buf, hdr.tree_len) == hdr.tree_check)
+    {
+        tree->size = hdr.tree_len;
+        tree->len = hdr.tree_len;
+        ret = SWICC_RET_SUCCESS;
+    }
+    else
+    {
+        swicc_alloc_free(tree->alloc, tree->buf);
+        tree->buf = NULL;
+    }
+    free(json_cached);
+    close(fd);
+    return ret;
+}
+
+/**
+ * @brief Add a compiled tree to the compile cache. The file is written under a
+ * temporary name and then renamed so processes sharing the cache never read a
+ * partial file.
+ * @param job
+ * @param tree_job A tree that has been compiled.
+ * @return Return code.
+ */
+static swicc_ret_et cache_store(diskjs_job_st const *const job,
+                                diskjs_tree_job_st const *const tree_job)
+{
+    static char const path_suffix[] = ".XXXXXX";
+    char *const path = cache_file_path(job, tree_job);
+    if (path == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    size_t const path_len = strlen(path);
+    char *const path_tmp = malloc(path_len + sizeof(path_suffix));
+    if (path_tmp == NULL)
+    {
+        free(path);
+        return SWICC_RET_ERROR;
+    }
+    memcpy(path_tmp, path, path_len);
+    memcpy(&path_tmp[path_len], path_suffix, sizeof(path_suffix));
+
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    swicc_disk_tree_st const *const tree = tree_job->tree;
+    int const fd = mkstemp(path_tmp);
+    if (fd >= 0)
+    {
+        diskjs_cache_hdr_st hdr = {
+            .magic = DISKJS_CACHE_MAGIC,
+            .json_len = tree_job->json_len,
+            .tree_len = tree->len,
+            .tree_check = cache_check(tree->buf, tree->len),
+        };
+        struct iovec const iov[3U] = {
+            {.iov_base = &hdr, .iov_len = sizeof(hdr)},
+            {.iov_base = (void *)&job->json[tree_job->json_offset],
+             .iov_len = tree_job->json_len},
+            {.iov_base = tree->buf, .iov_len = tree->len},
+        };
+        ssize_t const written = writev(fd, iov, 3);
+        if (close(fd) == 0 && written >= 0 &&
+            (size_t)written == sizeof(hdr) + tree_job->json_len + tree->len &&
+            rename(path_tmp, path) == 0)
+        {
+            ret = SWICC_RET_SUCCESS;
+        }
+        else
+        {
+            unlink(path_tmp);
+        }
+    }
+    free(path_tmp);
+    free(path);
+    return ret;
+}
+
+/**
+ * @brief Entry point of a worker compiling trees. Each tree is parsed on its
+ * own so only the JSON DOMs of the trees being compiled exist at any time.
+ * @param arg The job the worker is part of.
+ * @return Always NULL, failures are recorded in the job.
+ */
+static void *disk_json_worker(void *const arg)
+{
+    diskjs_job_st *const job = arg;
+    while (atomic_load_explicit(&job->failed, memory_order_relaxed) == false)
+    {
+        uint32_t const tree_idx = atomic_fetch_add_explicit(
+            &job->tree_next, 1U, memory_order_relaxed);
+        if (tree_idx >= job->tree_count)
+        {
+            break;
         }
+        diskjs_tree_job_st *const tree_job = &job->tree[tree_idx];
 
-        /* Make sure the forest has been created successfully. */
+        swicc_ret_et ret = SWICC_RET_ERROR;
+        if (job->cache_path != NULL &&
+            cache_load(job, tree_job) == SWICC_RET_SUCCESS)
+        {
+            ret = swicc_disk_lutsid_rebuild(job->disk, tree_job->tree);
+            /* Nothing to write back to the cache. */
+        }
+        else
+        {
+            cJSON *const tree_json = cJSON_ParseWithLength(
+                &job->json[tree_job->json_offset], tree_job->json_len);
+            if (tree_json == NULL)
+            {
+                fprintf(stderr, "Tree: Invalid JSON of tree %u.\n", tree_idx);
+            }
+            else
+            {
+                ret = tree_json_prs(job->disk, tree_job->tree, tree_json);
+                cJSON_Delete(tree_json);
+            }
+            /* The cache is only an optimization so a failure is not fatal. */
+            if (ret == SWICC_RET_SUCCESS && job->cache_path != NULL &&
+                cache_store(job, tree_job) != SWICC_RET_SUCCESS)
+            {
+                fprintf(stderr, "Tree: Failed to cache compiled tree %u.\n",
+                        tree_idx);
+            }
+        }
         if (ret != SWICC_RET_SUCCESS)
         {
-            swicc_disk_root_empty(disk);
-            memset(disk, 0U, sizeof(*disk));
+            atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Compile the trees of a disk JSON on several threads.
+ * @param disk Disk to populate, must be empty.
+ * @param disk_json Disk in JSON format.
+ * @param disk_json_len Length of the disk JSON.
+ * @param worker_count How many threads to compile on, 0 to use one per online
+ * core.
+ * @param cache_path Directory of the compile cache, NULL to not use a cache.
+ * @return Return code.
+ */
+static swicc_ret_et disk_json_compile(swicc_disk_st *const disk,
+                                      char const *const disk_json,
+                                      uint32_t const disk_json_len,
+                                      uint32_t const worker_count,
+                                      char const *const cache_path)
+{
+    if (disk == NULL || disk_json == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->root != NULL)
+    {
+        fprintf(stderr, "Root: Old disk must be unloaded first.\n");
+        return SWICC_RET_ERROR;
+    }
+
+    diskjs_job_st *const job = malloc(sizeof(*job));
+    if (job == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    job->disk = disk;
+    job->json = disk_json;
+    job->cache_path = cache_path;
+    atomic_init(&job->tree_next, 0U);
+    atomic_init(&job->failed, false);
+    if (disk_json_split(job, disk_json_len) != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Root: Failed to find the trees in the disk JSON.\n");
+        free(job);
+        return SWICC_RET_ERROR;
+    }
+
+    /**
+     * All tree structs are linked into the forest before compiling so the trees
+     * keep the order they have in the JSON.
+     */
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    swicc_disk_tree_st **tree_next = &disk->root;
+    for (uint32_t tree_idx = 0U; tree_idx < job->tree_count; ++tree_idx)
+    {
+        swicc_disk_tree_st *const tree =
+            swicc_alloc_malloc(disk->alloc, sizeof(*tree));
+        if (tree == NULL)
+        {
+            fprintf(stderr, "Tree: Failed to allocate a tree struct.\n");
             ret = SWICC_RET_ERROR;
-            fprintf(
-                stderr,
-                "Root: Failed to create the forest of trees (parsed %u trees): %s.\n",
-                tree_count, swicc_dbg_ret_str(ret));
+            break;
         }
-        if (ret == SWICC_RET_SUCCESS)
+        memset(tree, 0U, sizeof(*tree));
+        tree->alloc = disk->alloc;
+        job->tree[tree_idx].tree = tree;
+        *tree_next = tree;
+        tree_next = &tree->next;
+    }
+
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        uint32_t worker_count_valid = worker_count;
+        if (worker_count_valid == 0U)
+        {
+            int64_t const core_count = sysconf(_SC_NPROCESSORS_ONLN);
+            /* Safe cast since the core count is checked to be in range. */
+            worker_count_valid = core_count > 0 && core_count <= UINT32_MAX
+                                     ? (uint32_t)core_count
+                                     : 1U;
+        }
+        if (worker_count_valid > job->tree_count)
         {
-            ret = swicc_disk_lutid_rebuild(disk);
-            if (ret != SWICC_RET_SUCCESS)
+            worker_count_valid = job->tree_count;
+        }
+
+        /**
+         * The calling thread is a worker too so if some threads can't be
+         * created, fewer trees are compiled at a time but all still get done.
+         */
+        pthread_t thread[DISKJS_TREE_COUNT_MAX];
+        uint32_t thread_count = 0U;
+        for (; thread_count + 1U < worker_count_valid; ++thread_count)
+        {
+            if (pthread_create(&thread[thread_count], NULL, disk_json_worker,
+                               job) != 0)
             {
-                fprintf(stderr, "Root: Failed to rebuild ID LUT.\n");
-                swicc_disk_lutid_empty(disk);
+                break;
             }
         }
+        disk_json_worker(job);
+        for (uint32_t thread_idx = 0U; thread_idx < thread_count; ++thread_idx)
+        {
+            pthread_join(thread[thread_idx], NULL);
+        }
+        if (atomic_load(&job->failed) == true)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+    }
+
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = disk_json_finish(disk);
     }
     else
     {
-        fprintf(stderr, "Root: 'disk' missing or not of type: object.\n");
-        ret = SWICC_RET_ERROR;
+        swicc_disk_root_empty(disk);
+        swicc_alloc_st const *const alloc = disk->alloc;
+        memset(disk, 0U, sizeof(*disk));
+        disk->alloc = alloc;
+        fprintf(stderr, "Root: Failed to create the forest of trees.\n");
     }
+    free(job);
     return ret;
 }
 
-swicc_ret_et swicc_diskjs_disk_create(swicc_disk_st *const disk,
-                                      char const *const disk_json_path)
+swicc_ret_et swicc_diskjs_disk_create_cached(swicc_disk_st *const disk,
+                                             char const *const disk_json_path,
+                                             uint32_t const worker_count,
+                                             char const *const cache_path)
 {
     /* Need to unload old disk to create a new one in its place. */
     if (disk->root != NULL || disk->lutid.buf1 != NULL ||
@@ -1446,7 +2020,10 @@ swicc_ret_et swicc_diskjs_disk_create(swicc_disk_st *const disk,
     {
         return SWICC_RET_ERROR;
     }
+    /* The allocator is chosen by the caller so it is kept. */
+    swicc_alloc_st const *const alloc = disk->alloc;
     memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
     swicc_ret_et ret = SWICC_RET_ERROR;
     FILE *f = fopen(disk_json_path, "rb");
     if (f != NULL)
@@ -1468,13 +2045,9 @@ swicc_ret_et swicc_diskjs_disk_create(swicc_disk_st *const disk,
                         if (fread(disk_json_raw, 1U, disk_json_raw_len, f) ==
                             disk_json_raw_len)
                         {
-                            cJSON *const disk_json = cJSON_ParseWithLength(
-                                disk_json_raw, disk_json_raw_len);
-                            if (disk_json != NULL)
-                            {
-                                ret = disk_json_prs(disk, disk_json);
-                                cJSON_Delete(disk_json);
-                            }
+                            ret = disk_json_compile(
+                                disk, disk_json_raw, disk_json_raw_len,
+                                worker_count, cache_path);
                         }
                     }
                     free(disk_json_raw);
@@ -1488,3 +2061,17 @@ swicc_ret_et swicc_diskjs_disk_create(swicc_disk_st *const disk,
     }
     return ret;
 }
+
+swicc_ret_et swicc_diskjs_disk_create_mt(swicc_disk_st *const disk,
+                                         char const *const disk_json_path,
+                                         uint32_t const worker_count)
+{
+    return swicc_diskjs_disk_create_cached(disk, disk_json_path, worker_count,
+                                           NULL);
+}
+
+swicc_ret_et swicc_diskjs_disk_create(swicc_disk_st *const disk,
+                                      char const *const disk_json_path)
+{
+    return swicc_diskjs_disk_create_mt(disk, disk_json_path, 0U);
+}
@@ -0,0 +1,423 @@
+#include "disk_internal.h"
+#include <endian.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+swicc_ret_et swicc_disk_index_file_check(swicc_disk_tree_st const *const tree,
+                                         uint32_t const offset_trel,
+                                         swicc_fs_id_kt const id,
+                                         swicc_fs_sid_kt const sid,
+                                         uint8_t const *const name)
+{
+    swicc_fs_item_hdr_raw_st item_hdr_raw;
+    swicc_fs_item_hdr_st item_hdr;
+    if (offset_trel >= tree->len ||
+        tree->len - offset_trel < sizeof(swicc_fs_file_raw_st))
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(&item_hdr_raw, &tree->buf[offset_trel], sizeof(item_hdr_raw));
+    swicc_fs_item_hdr_prs(&item_hdr_raw, offset_trel, &item_hdr);
+    if (item_hdr.type == SWICC_FS_ITEM_TYPE_INVALID ||
+        item_hdr.type > SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC ||
+        item_hdr.size < swicc_fs_item_hdr_raw_size[item_hdr.type] ||
+        item_hdr.size > tree->len - offset_trel)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_fs_file_st file;
+    if (swicc_fs_file_prs(tree, offset_trel, &file) != SWICC_RET_SUCCESS ||
+        (id != SWICC_FS_ID_MISSING && file.hdr_file.id != id) ||
+        (sid != SWICC_FS_SID_MISSING && file.hdr_file.sid != sid))
+    {
+        return SWICC_RET_ERROR;
+    }
+    uint8_t file_name[1U + SWICC_FS_NAME_LEN];
+    if (name != NULL &&
+        (swicc_disk_lutname_item(&file, file_name) != SWICC_RET_SUCCESS ||
+         memcmp(file_name, name, sizeof(file_name)) != 0))
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_index_lut_prs(swicc_alloc_st const *const alloc,
+                                      swicc_disk_lut_st *const lut,
+                                      uint32_t const size_item1,
+                                      uint32_t const size_item2,
+                                      uint32_t const count,
+                                      uint8_t const *const buf)
+{
+    lut->size_item1 = size_item1;
+    lut->size_item2 = size_item2;
+    lut->count = count;
+    /* Leave some space so a LUT that gets rebuilt later does not resize. */
+    lut->count_max = count > SWICC_DISK_LUT_COUNT_START
+                         ? count
+                         : SWICC_DISK_LUT_COUNT_START;
+    lut->buf1 = swicc_alloc_malloc(alloc, lut->count_max * size_item1);
+    lut->buf2 = swicc_alloc_malloc(alloc, lut->count_max * size_item2);
+    if (lut->buf1 == NULL || lut->buf2 == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(lut->buf1, buf, count * size_item1);
+    memcpy(lut->buf2, &buf[count * size_item1], count * size_item2);
+    for (uint32_t entry_idx = 1U; entry_idx < count; ++entry_idx)
+    {
+        /* Lookups rely on the entries being sorted. */
+        if (memcmp(&lut->buf1[size_item1 * (entry_idx - 1U)],
+                   &lut->buf1[size_item1 * entry_idx], size_item1) > 0)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_index_tree_check(swicc_disk_st *const disk,
+                                         uint8_t const *const index,
+                                         uint32_t const index_len)
+{
+    swicc_disk_index_hdr_raw_st hdr;
+    if (index_len < sizeof(hdr))
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    memcpy(&hdr, index, sizeof(hdr));
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        tree_count += 1U;
+    }
+    if (hdr.tree_count != tree_count ||
+        sizeof(hdr) + ((uint64_t)tree_count *
+                       sizeof(swicc_disk_index_tree_raw_st)) >
+            index_len)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    uint8_t const *const index_tree = &index[sizeof(hdr)];
+    uint32_t tree_idx = 0U;
+    for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        swicc_disk_index_tree_raw_st tree_raw;
+        memcpy(&tree_raw, &index_tree[tree_idx++ * sizeof(tree_raw)],
+               sizeof(tree_raw));
+        uint32_t const check = swicc_crc32c(0U, tree->buf, tree->len);
+        if (check != tree_raw.check)
+        {
+            return SWICC_RET_ERROR;
+        }
+        tree->check = check;
+        tree->check_valid = true;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_index_prs(swicc_disk_st *const disk,
+                                  uint8_t const *const index,
+                                  uint32_t const index_len)
+{
+    swicc_disk_index_hdr_raw_st hdr;
+    if (index_len < sizeof(hdr))
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(&hdr, index, sizeof(hdr));
+
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        tree_count += 1U;
+    }
+    uint32_t const lutid_size_item1 = sizeof(swicc_fs_id_kt);
+    uint32_t const lutid_size_item2 = sizeof(uint32_t) + sizeof(uint8_t);
+    uint32_t const lutname_size_item1 = 1U + SWICC_FS_NAME_LEN;
+    uint32_t const lutsid_size_item1 = sizeof(swicc_fs_sid_kt);
+    uint32_t const lutsid_size_item2 = sizeof(uint32_t);
+    uint64_t index_len_exp =
+        sizeof(hdr) +
+        ((uint64_t)tree_count * sizeof(swicc_disk_index_tree_raw_st)) +
+        ((uint64_t)hdr.lutid_count * (lutid_size_item1 + lutid_size_item2)) +
+        ((uint64_t)hdr.lutname_count * (lutname_size_item1 + lutid_size_item2));
+    if (tree_count == 0U || hdr.size != index_len ||
+        hdr.tree_count != tree_count || index_len_exp > index_len)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* Trees must be exactly where the index says they are. */
+    uint8_t const *const index_tree = &index[sizeof(hdr)];
+    uint64_t tree_offset = SWICC_DISK_MAGIC_LEN + (uint64_t)index_len;
+    uint32_t tree_idx = 0U;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        swicc_disk_index_tree_raw_st tree_raw;
+        memcpy(&tree_raw, &index_tree[tree_idx * sizeof(tree_raw)],
+               sizeof(tree_raw));
+        if (tree_raw.offset != tree_offset || tree_raw.len != tree->len)
+        {
+            return SWICC_RET_ERROR;
+        }
+        index_len_exp += (uint64_t)tree_raw.lutsid_count *
+                         (lutsid_size_item1 + lutsid_size_item2);
+        tree_offset += tree->len;
+        tree_idx += 1U;
+    }
+    if (index_len_exp != index_len)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* Load the ID LUT and check that every entry points to the right file. */
+    /* Safe cast since the whole index was checked to fit in the length. */
+    uint32_t index_offset = (uint32_t)(
+        sizeof(hdr) + (tree_count * sizeof(swicc_disk_index_tree_raw_st)));
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    swicc_disk_lutid_empty(disk);
+    disk->lutid_tree = swicc_alloc_malloc(
+        disk->alloc, tree_count * sizeof(swicc_disk_tree_st *));
+    if (disk->lutid_tree != NULL)
+    {
+        for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+             tree = tree->next)
+        {
+            disk->lutid_tree[disk->lutid_tree_count++] = tree;
+        }
+        ret = swicc_disk_index_lut_prs(disk->alloc, &disk->lutid,
+                                       lutid_size_item1, lutid_size_item2,
+                                       hdr.lutid_count, &index[index_offset]);
+    }
+    for (uint32_t entry_idx = 0U;
+         ret == SWICC_RET_SUCCESS && entry_idx < disk->lutid.count; ++entry_idx)
+    {
+        uint16_t id_be;
+        uint32_t offset;
+        uint8_t id_tree_idx;
+        memcpy(&id_be, &disk->lutid.buf1[lutid_size_item1 * entry_idx],
+               sizeof(id_be));
+        memcpy(&offset, &disk->lutid.buf2[lutid_size_item2 * entry_idx],
+               sizeof(offset));
+        memcpy(&id_tree_idx,
+               &disk->lutid.buf2[(lutid_size_item2 * entry_idx) +
+                                 sizeof(uint32_t)],
+               sizeof(id_tree_idx));
+        if (id_tree_idx >= tree_count ||
+            swicc_disk_index_file_check(disk->lutid_tree[id_tree_idx],
+                                        offset, be16toh(id_be),
+                                        SWICC_FS_SID_MISSING,
+                                        NULL) != SWICC_RET_SUCCESS)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+    }
+    index_offset += hdr.lutid_count * (lutid_size_item1 + lutid_size_item2);
+
+    /* The name LUT has the same layout of item 2 as the ID LUT. */
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = swicc_disk_index_lut_prs(disk->alloc, &disk->lutname,
+                                       lutname_size_item1, lutid_size_item2,
+                                       hdr.lutname_count, &index[index_offset]);
+    }
+    for (uint32_t entry_idx = 0U;
+         ret == SWICC_RET_SUCCESS && entry_idx < disk->lutname.count;
+         ++entry_idx)
+    {
+        uint32_t offset;
+        memcpy(&offset, &disk->lutname.buf2[lutid_size_item2 * entry_idx],
+               sizeof(offset));
+        uint8_t const name_tree_idx =
+            disk->lutname
+                .buf2[(lutid_size_item2 * entry_idx) + sizeof(uint32_t)];
+        if (name_tree_idx >= tree_count ||
+            swicc_disk_index_file_check(
+                disk->lutid_tree[name_tree_idx], offset, SWICC_FS_ID_MISSING,
+                SWICC_FS_SID_MISSING,
+                &disk->lutname.buf1[lutname_size_item1 * entry_idx]) !=
+                SWICC_RET_SUCCESS)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+    }
+    index_offset +=
+        hdr.lutname_count * (lutname_size_item1 + lutid_size_item2);
+
+    /* Load the SID LUT of every tree, validated the same way. */
+    tree_idx = 0U;
+    for (swicc_disk_tree_st *tree = disk->root;
+         ret == SWICC_RET_SUCCESS && tree != NULL; tree = tree->next)
+    {
+        swicc_disk_index_tree_raw_st tree_raw;
+        memcpy(&tree_raw, &index_tree[tree_idx * sizeof(tree_raw)],
+               sizeof(tree_raw));
+        swicc_disk_lutsid_empty(tree);
+        ret = swicc_disk_index_lut_prs(
+            tree->alloc, &tree->lutsid, lutsid_size_item1, lutsid_size_item2,
+            tree_raw.lutsid_count, &index[index_offset]);
+        /* Iterate backwards so the first entry of a repeated SID wins. */
+        for (uint32_t entry_idx = tree->lutsid.count;
+             ret == SWICC_RET_SUCCESS && entry_idx > 0U; --entry_idx)
+        {
+            swicc_fs_sid_kt const sid = tree->lutsid.buf1[entry_idx - 1U];
+            uint32_t offset;
+            memcpy(&offset,
+                   &tree->lutsid.buf2[lutsid_size_item2 * (entry_idx - 1U)],
+                   sizeof(offset));
+            ret = swicc_disk_index_file_check(tree, offset,
+                                              SWICC_FS_ID_MISSING, sid, NULL);
+            if (sid < SWICC_DISK_LUTSID_DIRECT_COUNT)
+            {
+                tree->lutsid_direct[sid] = offset;
+            }
+        }
+        index_offset +=
+            tree_raw.lutsid_count * (lutsid_size_item1 + lutsid_size_item2);
+        tree_idx += 1U;
+    }
+
+    /* The file descriptors are not persisted so they are created here. */
+    for (swicc_disk_tree_st *tree = disk->root;
+         ret == SWICC_RET_SUCCESS && tree != NULL; tree = tree->next)
+    {
+        ret = swicc_disk_descr_rebuild(tree);
+    }
+
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+             tree = tree->next)
+        {
+            swicc_disk_lutsid_empty(tree);
+        }
+        swicc_disk_lutid_empty(disk);
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_index_fread(FILE *const f, uint8_t **const index,
+                                    uint32_t *const index_len)
+{
+    swicc_disk_index_hdr_raw_st hdr;
+    if (fread(&hdr, sizeof(hdr), 1U, f) != 1U || hdr.size < sizeof(hdr))
+    {
+        return SWICC_RET_ERROR;
+    }
+    *index = malloc(hdr.size);
+    if (*index == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(*index, &hdr, sizeof(hdr));
+    if (hdr.size > sizeof(hdr) &&
+        fread(&(*index)[sizeof(hdr)], hdr.size - sizeof(hdr), 1U, f) != 1U)
+    {
+        return SWICC_RET_ERROR;
+    }
+    *index_len = hdr.size;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_index_write(
+    swicc_disk_st const *const disk, FILE *const f,
+    swicc_disk_tree_lz4_st const *const tree_lz4)
+{
+    size_t const tree_raw_size = tree_lz4 == NULL
+                                     ? sizeof(swicc_disk_index_tree_raw_st)
+                                     : sizeof(swicc_disk_index_tree_lz4_raw_st);
+    swicc_disk_lut_st const *const lutid = &disk->lutid;
+    swicc_disk_lut_st const *const lutname = &disk->lutname;
+    uint64_t index_len =
+        sizeof(swicc_disk_index_hdr_raw_st) +
+        ((uint64_t)lutid->count * (lutid->size_item1 + lutid->size_item2)) +
+        ((uint64_t)lutname->count *
+         (lutname->size_item1 + lutname->size_item2));
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        index_len += tree_raw_size +
+                     ((uint64_t)tree->lutsid.count *
+                      (tree->lutsid.size_item1 + tree->lutsid.size_item2));
+        tree_count += 1U;
+    }
+    if (index_len > UINT32_MAX - SWICC_DISK_MAGIC_LEN)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    swicc_disk_index_hdr_raw_st const hdr = {
+        /* Safe cast since the length was checked to fit in uint32 range. */
+        .size = (uint32_t)index_len,
+        .tree_count = tree_count,
+        .lutid_count = lutid->count,
+        .lutname_count = lutname->count,
+    };
+    if (fwrite(&hdr, sizeof(hdr), 1U, f) != 1U)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Overflow is not possible since the sum of all trees is checked later. */
+    uint32_t tree_offset = SWICC_DISK_MAGIC_LEN + hdr.size;
+    uint32_t tree_idx = 0U;
+    for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        uint32_t check;
+        if (swicc_disk_tree_check(tree, &check) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        swicc_disk_index_tree_lz4_raw_st const tree_raw = {
+            .offset = tree_offset,
+            .len = tree->len,
+            .lutsid_count = tree->lutsid.count,
+            .check = check,
+            .len_lz4 = tree_lz4 == NULL ? 0U : tree_lz4[tree_idx].len,
+        };
+        /* The plain entry is the start of the one with compression. */
+        if (fwrite(&tree_raw, tree_raw_size, 1U, f) != 1U)
+        {
+            return SWICC_RET_ERROR;
+        }
+        tree_offset += tree_lz4 == NULL ? tree->len : tree_lz4[tree_idx].len;
+        tree_idx += 1U;
+    }
+    if (lutid->count > 0U &&
+        (fwrite(lutid->buf1, lutid->size_item1 * lutid->count, 1U, f) != 1U ||
+         fwrite(lutid->buf2, lutid->size_item2 * lutid->count, 1U, f) != 1U))
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (lutname->count > 0U &&
+        (fwrite(lutname->buf1, lutname->size_item1 * lutname->count, 1U, f) !=
+             1U ||
+         fwrite(lutname->buf2, lutname->size_item2 * lutname->count, 1U, f) !=
+             1U))
+    {
+        return SWICC_RET_ERROR;
+    }
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        swicc_disk_lut_st const *const lutsid = &tree->lutsid;
+        if (lutsid->count > 0U &&
+            (fwrite(lutsid->buf1, lutsid->size_item1 * lutsid->count, 1U, f) !=
+                 1U ||
+             fwrite(lutsid->buf2, lutsid->size_item2 * lutsid->count, 1U, f) !=
+                 1U))
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
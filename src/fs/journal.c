@@ -0,0 +1,682 @@
+#include "disk_internal.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * @brief Compute the checksum of a journal record (FNV-1a).
+ * @param[in] hdr Header of the record, the checksum field is ignored.
+ * @param[in] data The bytes of the record.
+ * @return Checksum.
+ */
+static uint32_t journal_check(
+    swicc_disk_journal_rcrd_hdr_raw_st const *const hdr,
+    uint8_t const *const data)
+{
+    swicc_disk_journal_rcrd_hdr_raw_st hdr_nocheck = *hdr;
+    hdr_nocheck.check = 0U;
+    uint32_t const hash = swicc_disk_check_fnv1a(
+        SWICC_DISK_CHECK_FNV1A_BASIS, (uint8_t const *)&hdr_nocheck,
+        sizeof(hdr_nocheck));
+    return swicc_disk_check_fnv1a(hash, data, hdr->len);
+}
+
+swicc_ret_et swicc_disk_journal_open(swicc_disk_st *const disk,
+                                     char const *const journal_path,
+                                     uint32_t const group_count)
+{
+    if (disk == NULL || journal_path == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->journal.enabled)
+    {
+        /* Close the current journal first before opening a new one. */
+        return SWICC_RET_ERROR;
+    }
+    int const fd = open(journal_path, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Records must not be appended after ones of an older layout. */
+    uint32_t magic;
+    if (pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) &&
+        (magic == SWICC_DISK_JOURNAL_MAGIC_V1 ||
+         magic == SWICC_DISK_JOURNAL_MAGIC_TXN_V1))
+    {
+        close(fd);
+        return SWICC_RET_ERROR;
+    }
+    disk->journal = (swicc_disk_journal_st){
+        .enabled = true,
+        .fd = fd,
+        .group_count = group_count,
+        .group_pending = 0U,
+    };
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_journal_close(swicc_disk_st *const disk)
+{
+    if (disk == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (!disk->journal.enabled)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    swicc_ret_et ret = swicc_disk_journal_sync(disk);
+    if (close(disk->journal.fd) != 0)
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    memset(&disk->journal, 0U, sizeof(disk->journal));
+    return ret;
+}
+
+swicc_ret_et swicc_disk_journal_sync(swicc_disk_st *const disk)
+{
+    if (disk == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (!disk->journal.enabled)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (disk->journal.group_pending > 0U)
+    {
+        if (fdatasync(disk->journal.fd) != 0)
+        {
+            return SWICC_RET_ERROR;
+        }
+        disk->journal.group_pending = 0U;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Append a record to the journal of a disk. A record that could not be
+ * written whole is cut off again so that later records don't end up after a
+ * torn one, which would get them dropped on replay. If it can't be cut off, the
+ * journal takes no more records.
+ * @param[in, out] disk
+ * @param[in] iov The header and the bytes of the record.
+ * @return Return code.
+ */
+static swicc_ret_et journal_write(swicc_disk_st *const disk,
+                                  struct iovec const iov[2U])
+{
+    if (disk->journal.failed)
+    {
+        return SWICC_RET_ERROR;
+    }
+    off_t const journal_len = lseek(disk->journal.fd, 0, SEEK_END);
+    if (journal_len < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    ssize_t const written = writev(disk->journal.fd, iov, 2);
+    if (written >= 0 && (size_t)written == iov[0U].iov_len + iov[1U].iov_len)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    if (written > 0 && ftruncate(disk->journal.fd, journal_len) != 0)
+    {
+        disk->journal.failed = true;
+    }
+    return SWICC_RET_ERROR;
+}
+
+/**
+ * @brief Write the directory entries of the directory containing a file to
+ * storage, e.g. to make a rename of the file durable.
+ * @param[in] path Path to the file.
+ * @return Return code.
+ */
+static swicc_ret_et path_dir_sync(char const *const path)
+{
+    char const *const dir_end = strrchr(path, '/');
+    char *dir_path = NULL;
+    if (dir_end != NULL)
+    {
+        /* Safe cast since the separator is inside the path. */
+        size_t const dir_len = dir_end == path ? 1U : (size_t)(dir_end - path);
+        dir_path = malloc(dir_len + 1U);
+        if (dir_path == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        memcpy(dir_path, path, dir_len);
+        dir_path[dir_len] = '\0';
+    }
+    int const fd = open(dir_path == NULL ? "." : dir_path,
+                        O_RDONLY | O_DIRECTORY);
+    free(dir_path);
+    if (fd < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et const ret =
+        fsync(fd) == 0 ? SWICC_RET_SUCCESS : SWICC_RET_ERROR;
+    if (close(fd) != 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_journal_append(swicc_disk_st *const disk,
+                                       swicc_disk_tree_st const *const tree,
+                                       swicc_fs_file_st const *const file,
+                                       uint32_t const data_offset,
+                                       uint32_t const data_len)
+{
+    if (disk == NULL || tree == NULL || file == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (!disk->journal.enabled)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    if (data_offset > file->data_size ||
+        data_len > file->data_size - data_offset)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    uint32_t tree_idx = 0U;
+    swicc_disk_tree_st const *tree_cur = disk->root;
+    while (tree_cur != NULL && tree_cur != tree)
+    {
+        tree_cur = tree_cur->next;
+        tree_idx += 1U;
+    }
+    if (tree_cur == NULL || tree_idx > UINT8_MAX)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    uint8_t *data;
+    if (swicc_disk_file_data(tree, file, &data) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_disk_journal_rcrd_hdr_raw_st hdr = {
+        .magic = SWICC_DISK_JOURNAL_MAGIC,
+        .offset_trel = file->hdr_item.offset_trel,
+        .data_offset_frel = data_offset,
+        .len = data_len,
+        .check = 0U,
+        /* Safe cast since the index was checked to fit in uint8 range. */
+        .tree_idx = (uint8_t)tree_idx,
+        .rcrd_head = 0U,
+    };
+    if (file->hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC &&
+        swicc_disk_file_rcrd_head(tree, file, &hdr.rcrd_head) !=
+            SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    hdr.check = journal_check(&hdr, &data[data_offset]);
+
+    /* Header and bytes are written together so a record is never split. */
+    struct iovec const iov[2U] = {
+        {.iov_base = &hdr, .iov_len = sizeof(hdr)},
+        {.iov_base = &data[data_offset], .iov_len = data_len},
+    };
+    if (journal_write(disk, iov) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    disk->journal.group_pending += 1U;
+    if (disk->journal.group_count > 0U &&
+        disk->journal.group_pending >= disk->journal.group_count)
+    {
+        return swicc_disk_journal_sync(disk);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Resolve the file a journal record writes to and get it ready for the
+ * write, i.e. make it writable and mark the bytes as dirty. This does not
+ * modify the file so it can be done for many records before writing any.
+ * @param[in, out] disk
+ * @param[in] hdr Header of the record.
+ * @param[out] tree Tree containing the file.
+ * @param[out] file
+ * @return Return code.
+ */
+static swicc_ret_et journal_rcrd_prepare(
+    swicc_disk_st *const disk,
+    swicc_disk_journal_rcrd_hdr_raw_st const *const hdr,
+    swicc_disk_tree_st **const tree, swicc_fs_file_st *const file)
+{
+    swicc_disk_tree_iter_st tree_iter;
+    *tree = NULL;
+    if (swicc_disk_tree_iter(disk, &tree_iter) != SWICC_RET_SUCCESS ||
+        swicc_disk_tree_iter_idx(&tree_iter, hdr->tree_idx, tree) !=
+            SWICC_RET_SUCCESS ||
+        *tree == NULL ||
+        swicc_fs_file_prs(*tree, hdr->offset_trel, file) !=
+            SWICC_RET_SUCCESS ||
+        hdr->data_offset_frel > file->data_size ||
+        hdr->len > file->data_size - hdr->data_offset_frel ||
+        swicc_disk_file_cow(*tree, file) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return swicc_disk_file_dirty_mark(*tree, file, hdr->data_offset_frel,
+                                      hdr->len);
+}
+
+/**
+ * @brief Apply one record of a journal to a disk.
+ * @param[in, out] disk
+ * @param[in] hdr Header of the record.
+ * @param[in] data The bytes of the record.
+ * @return Return code.
+ */
+static swicc_ret_et journal_rcrd_apply(
+    swicc_disk_st *const disk,
+    swicc_disk_journal_rcrd_hdr_raw_st const *const hdr,
+    uint8_t const *const data)
+{
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    if (journal_rcrd_prepare(disk, hdr, &tree, &file) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(&file.data[hdr->data_offset_frel], data, hdr->len);
+
+    if (file.hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
+    {
+        return swicc_disk_file_rcrd_head_set(tree, &file, hdr->rcrd_head);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Go through the records of a transaction and either prepare or apply
+ * each of them.
+ * @param[in, out] disk
+ * @param[in] buf Records of the transaction.
+ * @param[in] len Length of the records.
+ * @param[in] apply If the records get applied, otherwise only prepared.
+ * @return Return code.
+ */
+static swicc_ret_et journal_txn_foreach(swicc_disk_st *const disk,
+                                        uint8_t const *const buf,
+                                        uint32_t const len, bool const apply)
+{
+    uint32_t offset = 0U;
+    while (offset < len)
+    {
+        swicc_disk_journal_rcrd_hdr_raw_st hdr;
+        if (len - offset < sizeof(hdr))
+        {
+            return SWICC_RET_ERROR;
+        }
+        memcpy(&hdr, &buf[offset], sizeof(hdr));
+        offset += (uint32_t)sizeof(hdr);
+        if (hdr.magic != SWICC_DISK_JOURNAL_MAGIC || hdr.len > len - offset ||
+            journal_check(&hdr, &buf[offset]) != hdr.check)
+        {
+            return SWICC_RET_ERROR;
+        }
+
+        swicc_ret_et ret;
+        if (apply)
+        {
+            ret = journal_rcrd_apply(disk, &hdr, &buf[offset]);
+        }
+        else
+        {
+            swicc_disk_tree_st *tree;
+            swicc_fs_file_st file;
+            ret = journal_rcrd_prepare(disk, &hdr, &tree, &file);
+        }
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            return ret;
+        }
+        offset += hdr.len;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Apply all records of a transaction to a disk. The records are all
+ * prepared first so none is applied when any of them does not fit the disk.
+ * @param[in, out] disk
+ * @param[in] buf Records of the transaction.
+ * @param[in] len Length of the records.
+ * @return Return code.
+ */
+static swicc_ret_et journal_txn_apply(swicc_disk_st *const disk,
+                                      uint8_t const *const buf,
+                                      uint32_t const len)
+{
+    if (journal_txn_foreach(disk, buf, len, false) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return journal_txn_foreach(disk, buf, len, true);
+}
+
+swicc_ret_et swicc_disk_journal_replay(swicc_disk_st *const disk,
+                                       char const *const journal_path)
+{
+    if (disk == NULL || journal_path == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->root == NULL || disk->journal.enabled)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    FILE *const f = fopen(journal_path, "rb");
+    if (f == NULL)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    struct stat f_stat;
+    if (fstat(fileno(f), &f_stat) != 0 || f_stat.st_size < 0)
+    {
+        fclose(f);
+        return SWICC_RET_ERROR;
+    }
+    uint64_t const journal_len = (uint64_t)f_stat.st_size;
+
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    uint8_t *data = NULL;
+    uint64_t valid_len = 0U;
+    while (valid_len < journal_len)
+    {
+        swicc_disk_journal_rcrd_hdr_raw_st hdr;
+        size_t const hdr_read = fread(&hdr, 1U, sizeof(hdr), f);
+        if (hdr_read >= sizeof(hdr.magic) &&
+            (hdr.magic == SWICC_DISK_JOURNAL_MAGIC_V1 ||
+             hdr.magic == SWICC_DISK_JOURNAL_MAGIC_TXN_V1))
+        {
+            /**
+             * Records of an older layout are not torn ones, cutting them off
+             * would lose them.
+             */
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        if (hdr_read != sizeof(hdr) ||
+            (hdr.magic != SWICC_DISK_JOURNAL_MAGIC &&
+             hdr.magic != SWICC_DISK_JOURNAL_MAGIC_TXN) ||
+            hdr.len > journal_len - valid_len - sizeof(hdr))
+        {
+            break;
+        }
+        /* Allocate at least 1 byte so an empty record gets a valid pointer. */
+        uint8_t *const data_new = realloc(data, hdr.len > 0U ? hdr.len : 1U);
+        if (data_new == NULL)
+        {
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        data = data_new;
+        if ((hdr.len > 0U && fread(data, hdr.len, 1U, f) != 1U) ||
+            journal_check(&hdr, data) != hdr.check)
+        {
+            break;
+        }
+        ret = hdr.magic == SWICC_DISK_JOURNAL_MAGIC_TXN
+                  ? journal_txn_apply(disk, data, hdr.len)
+                  : journal_rcrd_apply(disk, &hdr, data);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            /* The journal does not belong to this disk. */
+            break;
+        }
+        valid_len += sizeof(hdr) + hdr.len;
+    }
+    free(data);
+    fclose(f);
+
+    /* Cut off the torn tail so that appended records don't end up after it. */
+    if (ret == SWICC_RET_SUCCESS && valid_len < journal_len &&
+        truncate(journal_path, (off_t)valid_len) != 0)
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_journal_compact(swicc_disk_st *const disk,
+                                        char const *const disk_path)
+{
+    if (disk == NULL || disk_path == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (!disk->journal.enabled)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    static char const path_suffix[] = ".tmp";
+    size_t const disk_path_len = strlen(disk_path);
+    char *const path_tmp = malloc(disk_path_len + sizeof(path_suffix));
+    if (path_tmp == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(path_tmp, disk_path, disk_path_len);
+    memcpy(&path_tmp[disk_path_len], path_suffix, sizeof(path_suffix));
+
+    /**
+     * The new disk file must be on storage before it replaces the old one and
+     * the old one must be replaced before emptying the journal, otherwise a
+     * crash in between would lose modifications.
+     */
+    swicc_ret_et ret = swicc_disk_save_index(disk, path_tmp);
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        int const fd_tmp = open(path_tmp, O_RDONLY);
+        if (fd_tmp < 0 || fsync(fd_tmp) != 0 ||
+            rename(path_tmp, disk_path) != 0)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+        if (fd_tmp >= 0 && close(fd_tmp) != 0)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+        /* The rename itself is only durable once the directory is synced. */
+        if (ret == SWICC_RET_SUCCESS &&
+            path_dir_sync(disk_path) != SWICC_RET_SUCCESS)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+    }
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        unlink(path_tmp);
+    }
+    free(path_tmp);
+
+    if (ret == SWICC_RET_SUCCESS &&
+        (ftruncate(disk->journal.fd, 0) != 0 ||
+         fdatasync(disk->journal.fd) != 0))
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        disk->journal.group_pending = 0U;
+        disk->journal.failed = false;
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_txn_begin(swicc_disk_st *const disk,
+                                  swicc_disk_txn_st *const txn)
+{
+    if (disk == NULL || txn == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    *txn = (swicc_disk_txn_st){
+        .disk = disk,
+        .buf = NULL,
+        .len = 0U,
+        .size = 0U,
+    };
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_txn_write(swicc_disk_txn_st *const txn,
+                                  swicc_disk_tree_st const *const tree,
+                                  swicc_fs_file_st const *const file,
+                                  uint32_t const data_offset,
+                                  uint8_t const *const data,
+                                  uint32_t const data_len)
+{
+    if (txn == NULL || txn->disk == NULL || tree == NULL || file == NULL ||
+        (data == NULL && data_len > 0U))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (data_offset > file->data_size ||
+        data_len > file->data_size - data_offset)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    uint32_t tree_idx = 0U;
+    swicc_disk_tree_st const *tree_cur = txn->disk->root;
+    while (tree_cur != NULL && tree_cur != tree)
+    {
+        tree_cur = tree_cur->next;
+        tree_idx += 1U;
+    }
+    if (tree_cur == NULL || tree_idx > UINT8_MAX)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_disk_journal_rcrd_hdr_raw_st hdr = {
+        .magic = SWICC_DISK_JOURNAL_MAGIC,
+        .offset_trel = file->hdr_item.offset_trel,
+        .data_offset_frel = data_offset,
+        .len = data_len,
+        .check = 0U,
+        /* Safe cast since the index was checked to fit in uint8 range. */
+        .tree_idx = (uint8_t)tree_idx,
+        .rcrd_head = 0U,
+    };
+    if (file->hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC &&
+        swicc_disk_file_rcrd_head(tree, file, &hdr.rcrd_head) !=
+            SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    hdr.check = journal_check(&hdr, data);
+
+    /* The transaction must still fit in a single journal record. */
+    if (data_len > UINT32_MAX - sizeof(hdr) - sizeof(hdr) - txn->len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Safe cast since the size was checked to fit in uint32 range. */
+    uint32_t const len_new = (uint32_t)(txn->len + sizeof(hdr) + data_len);
+    if (len_new > txn->size)
+    {
+        uint32_t const size_new =
+            len_new > UINT32_MAX / 2U ? len_new : len_new * 2U;
+        /* Staged records only live until the commit, see 'swicc/alloc.h'. */
+        uint8_t *const buf_new = realloc(txn->buf, size_new);
+        if (buf_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        txn->buf = buf_new;
+        txn->size = size_new;
+    }
+    memcpy(&txn->buf[txn->len], &hdr, sizeof(hdr));
+    if (data_len > 0U)
+    {
+        memcpy(&txn->buf[txn->len + sizeof(hdr)], data, data_len);
+    }
+    txn->len = len_new;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_txn_commit(swicc_disk_txn_st *const txn)
+{
+    if (txn == NULL || txn->disk == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_disk_st *const disk = txn->disk;
+    if (txn->len == 0U)
+    {
+        swicc_disk_txn_abort(txn);
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Every write must fit the disk before the record gets appended. */
+    swicc_ret_et ret = journal_txn_foreach(disk, txn->buf, txn->len, false);
+    if (ret == SWICC_RET_SUCCESS && disk->journal.enabled)
+    {
+        swicc_disk_journal_rcrd_hdr_raw_st hdr = {
+            .magic = SWICC_DISK_JOURNAL_MAGIC_TXN,
+            .offset_trel = 0U,
+            .data_offset_frel = 0U,
+            .len = txn->len,
+            .check = 0U,
+            .tree_idx = 0U,
+            .rcrd_head = 0U,
+        };
+        hdr.check = journal_check(&hdr, txn->buf);
+
+        /* Header and writes are written together so a record is never split. */
+        struct iovec const iov[2U] = {
+            {.iov_base = &hdr, .iov_len = sizeof(hdr)},
+            {.iov_base = txn->buf, .iov_len = txn->len},
+        };
+        ret = journal_write(disk, iov);
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = journal_txn_foreach(disk, txn->buf, txn->len, true);
+    }
+    if (ret == SWICC_RET_SUCCESS && disk->journal.enabled)
+    {
+        disk->journal.group_pending += 1U;
+        if (disk->journal.group_count > 0U &&
+            disk->journal.group_pending >= disk->journal.group_count)
+        {
+            ret = swicc_disk_journal_sync(disk);
+        }
+    }
+    swicc_disk_txn_abort(txn);
+    return ret;
+}
+
+void swicc_disk_txn_abort(swicc_disk_txn_st *const txn)
+{
+    if (txn == NULL)
+    {
+        return;
+    }
+    free(txn->buf);
+    memset(txn, 0U, sizeof(*txn));
+}
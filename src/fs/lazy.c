@@ -0,0 +1,407 @@
+#include "disk_internal.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Create all trees of a lazily loaded disk (without reading them) and
+ * the ID and name LUTs from the index.
+ * @param disk
+ * @param index The index section of the disk file.
+ * @param index_len Length of the index section.
+ * @param file_len Length of the disk file.
+ * @param fd File descriptor of the disk file.
+ * @param remote Remote of the disk file, NULL when read from the descriptor.
+ * @param lz4 If the trees of the disk file are compressed.
+ * @return Return code.
+ * @note Entries of the LUTs can't be checked against the trees without reading
+ * them so only their bounds are checked here. Lookups check the rest.
+ */
+static swicc_ret_et disk_index_lazy_prs(
+    swicc_disk_st *const disk, uint8_t const *const index,
+    uint32_t const index_len, uint64_t const file_len, int32_t const fd,
+    swicc_disk_remote_st const *const remote, bool const lz4)
+{
+    swicc_disk_index_hdr_raw_st hdr;
+    if (index_len < sizeof(hdr))
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(&hdr, index, sizeof(hdr));
+    uint32_t const lutid_size_item1 = sizeof(swicc_fs_id_kt);
+    uint32_t const lutid_size_item2 = sizeof(uint32_t) + sizeof(uint8_t);
+    uint32_t const lutname_size_item1 = 1U + SWICC_FS_NAME_LEN;
+    uint32_t const lutsid_size = sizeof(swicc_fs_sid_kt) + sizeof(uint32_t);
+    uint32_t const tree_raw_size =
+        lz4 ? sizeof(swicc_disk_index_tree_lz4_raw_st)
+            : sizeof(swicc_disk_index_tree_raw_st);
+    uint64_t index_len_exp =
+        sizeof(hdr) + ((uint64_t)hdr.tree_count * tree_raw_size) +
+        ((uint64_t)hdr.lutid_count * (lutid_size_item1 + lutid_size_item2)) +
+        ((uint64_t)hdr.lutname_count * (lutname_size_item1 + lutid_size_item2));
+    if (hdr.tree_count == 0U || hdr.tree_count > UINT8_MAX + 1U ||
+        hdr.size != index_len || index_len_exp > index_len)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* Trees must follow each other right after the index up to the end. */
+    uint8_t const *const index_tree = &index[sizeof(hdr)];
+    uint64_t tree_offset = SWICC_DISK_MAGIC_LEN + (uint64_t)index_len;
+    swicc_disk_tree_st **tree_next = &disk->root;
+    for (uint32_t tree_idx = 0U; tree_idx < hdr.tree_count; ++tree_idx)
+    {
+        /* The plain entry is the start of the one with compression. */
+        swicc_disk_index_tree_lz4_raw_st tree_raw = {0U};
+        memcpy(&tree_raw, &index_tree[tree_idx * tree_raw_size],
+               tree_raw_size);
+        if (!lz4)
+        {
+            tree_raw.len_lz4 = tree_raw.len;
+        }
+        if (tree_raw.offset != tree_offset || tree_raw.len == 0U ||
+            tree_raw.len_lz4 == 0U || tree_raw.len_lz4 > tree_raw.len)
+        {
+            return SWICC_RET_ERROR;
+        }
+        swicc_disk_tree_st *const tree =
+            swicc_alloc_malloc(disk->alloc, sizeof(*tree));
+        if (tree == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        memset(tree, 0U, sizeof(*tree));
+        tree->alloc = disk->alloc;
+        tree->len = tree_raw.len;
+        tree->lazy = true;
+        tree->lazy_fd = fd;
+        tree->lazy_remote = remote;
+        tree->lazy_offset = tree_raw.offset;
+        tree->lazy_lz4 = lz4;
+        tree->lazy_len_lz4 = tree_raw.len_lz4;
+        tree->check = tree_raw.check;
+        tree->check_valid = true;
+        *tree_next = tree;
+        tree_next = &tree->next;
+
+        index_len_exp += (uint64_t)tree_raw.lutsid_count * lutsid_size;
+        tree_offset += tree_raw.len_lz4;
+    }
+    if (index_len_exp != index_len || tree_offset != file_len)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    disk->lutid_tree = swicc_alloc_malloc(
+        disk->alloc, hdr.tree_count * sizeof(swicc_disk_tree_st *));
+    if (disk->lutid_tree == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        disk->lutid_tree[disk->lutid_tree_count++] = tree;
+    }
+
+    /* Safe cast since the whole index was checked to fit in the length. */
+    uint32_t const index_offset =
+        (uint32_t)(sizeof(hdr) + (hdr.tree_count * tree_raw_size));
+    uint32_t const index_offset_name =
+        index_offset +
+        (hdr.lutid_count * (lutid_size_item1 + lutid_size_item2));
+    if (swicc_disk_index_lut_prs(disk->alloc, &disk->lutid, lutid_size_item1,
+                                 lutid_size_item2, hdr.lutid_count,
+                                 &index[index_offset]) != SWICC_RET_SUCCESS ||
+        swicc_disk_index_lut_prs(disk->alloc, &disk->lutname,
+                                 lutname_size_item1, lutid_size_item2,
+                                 hdr.lutname_count,
+                                 &index[index_offset_name]) !=
+            SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_disk_lut_st const *const luts[2U] = {&disk->lutid, &disk->lutname};
+    for (uint32_t lut_idx = 0U; lut_idx < 2U; ++lut_idx)
+    {
+        swicc_disk_lut_st const *const lut = luts[lut_idx];
+        for (uint32_t entry_idx = 0U; entry_idx < lut->count; ++entry_idx)
+        {
+            uint32_t offset;
+            memcpy(&offset, &lut->buf2[lut->size_item2 * entry_idx],
+                   sizeof(offset));
+            uint8_t const tree_idx =
+                lut->buf2[(lut->size_item2 * entry_idx) + sizeof(uint32_t)];
+            if (tree_idx >= disk->lutid_tree_count ||
+                offset >= disk->lutid_tree[tree_idx]->len)
+            {
+                return SWICC_RET_ERROR;
+            }
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_load_lazy(swicc_disk_st *const disk,
+                                  char const *const disk_path)
+{
+    if (disk == NULL || disk_path == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->root != NULL)
+    {
+        /* Get rid of the current disk first before loading a new one. */
+        return SWICC_RET_ERROR;
+    }
+
+    /**
+     * Clear disk so that all the members have a known initial state. The
+     * allocator is chosen by the caller so it is kept.
+     */
+    swicc_alloc_st const *const alloc = disk->alloc;
+    memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
+
+    int const fd = open(disk_path, O_RDONLY);
+    if (fd < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    FILE *const f = fdopen(dup(fd), "rb");
+    if (f == NULL)
+    {
+        close(fd);
+        return SWICC_RET_ERROR;
+    }
+
+    uint8_t const magic_plain[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC;
+    uint8_t const magic_index[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_INDEX;
+    uint8_t const magic_lz4[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_LZ4;
+    uint8_t magic[SWICC_DISK_MAGIC_LEN];
+    struct stat f_stat;
+    if (fstat(fd, &f_stat) != 0 || f_stat.st_size < 0 ||
+        fread(magic, sizeof(magic), 1U, f) != 1U)
+    {
+        fclose(f);
+        close(fd);
+        return SWICC_RET_ERROR;
+    }
+    bool const lz4 = memcmp(magic, magic_lz4, sizeof(magic)) == 0;
+    if (!lz4 && memcmp(magic, magic_index, sizeof(magic)) != 0)
+    {
+        fclose(f);
+        close(fd);
+        /* Without an index, the trees would have to be read to find them. */
+        if (memcmp(magic, magic_plain, sizeof(magic)) == 0)
+        {
+            return swicc_disk_load(disk, disk_path);
+        }
+        return SWICC_RET_ERROR;
+    }
+
+    uint8_t *index = NULL;
+    uint32_t index_len = 0U;
+    swicc_ret_et ret = swicc_disk_index_fread(f, &index, &index_len);
+    if (fclose(f) != 0)
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = disk_index_lazy_prs(disk, index, index_len,
+                                  (uint64_t)f_stat.st_size, fd, NULL, lz4);
+    }
+    free(index);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        swicc_disk_root_empty(disk);
+        close(fd);
+        return ret;
+    }
+    disk->lazy = true;
+    disk->lazy_fd = fd;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_load_remote(swicc_disk_st *const disk,
+                                    swicc_disk_remote_st const *const remote)
+{
+    if (disk == NULL || remote == NULL || remote->read == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->root != NULL)
+    {
+        /* Get rid of the current disk first before loading a new one. */
+        return SWICC_RET_ERROR;
+    }
+
+    /**
+     * Clear disk so that all the members have a known initial state. The
+     * allocator is chosen by the caller so it is kept.
+     */
+    swicc_alloc_st const *const alloc = disk->alloc;
+    memset(disk, 0U, sizeof(*disk));
+    disk->alloc = alloc;
+
+    /* Trees keep pointing to the remote so it must not move with the disk. */
+    swicc_disk_remote_st *const remote_own =
+        swicc_alloc_malloc(disk->alloc, sizeof(*remote_own));
+    if (remote_own == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    *remote_own = *remote;
+
+    uint8_t const magic_index[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_INDEX;
+    uint8_t const magic_lz4[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_LZ4;
+    uint8_t magic[SWICC_DISK_MAGIC_LEN];
+    swicc_disk_index_hdr_raw_st hdr;
+    if (swicc_disk_remote_read(remote_own, 0U, sizeof(magic), magic) !=
+            SWICC_RET_SUCCESS ||
+        swicc_disk_remote_read(remote_own, sizeof(magic), sizeof(hdr),
+                               (uint8_t *)&hdr) != SWICC_RET_SUCCESS ||
+        hdr.size < sizeof(hdr))
+    {
+        swicc_alloc_free(disk->alloc, remote_own);
+        return SWICC_RET_ERROR;
+    }
+    /* Without an index, the whole disk file would have to be fetched. */
+    bool const lz4 = memcmp(magic, magic_lz4, sizeof(magic)) == 0;
+    if (!lz4 && memcmp(magic, magic_index, sizeof(magic)) != 0)
+    {
+        swicc_alloc_free(disk->alloc, remote_own);
+        return SWICC_RET_ERROR;
+    }
+
+    uint8_t *const index = malloc(hdr.size);
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    if (index != NULL &&
+        swicc_disk_remote_read(remote_own, sizeof(magic), hdr.size, index) ==
+            SWICC_RET_SUCCESS)
+    {
+        ret = disk_index_lazy_prs(disk, index, hdr.size, remote_own->len, -1,
+                                  remote_own, lz4);
+    }
+    free(index);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        swicc_disk_root_empty(disk);
+        swicc_alloc_free(disk->alloc, remote_own);
+        return ret;
+    }
+    disk->lazy = true;
+    disk->lazy_fd = -1;
+    disk->remote = remote_own;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_tree_lazy_pread(swicc_disk_tree_st const *const tree,
+                                        uint32_t const offset,
+                                        uint32_t const len, uint8_t *const buf)
+{
+    if (tree->lazy_remote != NULL)
+    {
+        return swicc_disk_remote_read(tree->lazy_remote,
+                                      (uint64_t)tree->lazy_offset + offset,
+                                      len, buf);
+    }
+    uint32_t buf_len = 0U;
+    while (buf_len < len)
+    {
+        ssize_t const ret_read =
+            pread(tree->lazy_fd, &buf[buf_len], len - buf_len,
+                  (off_t)tree->lazy_offset + offset + buf_len);
+        if (ret_read <= 0)
+        {
+            return SWICC_RET_ERROR;
+        }
+        /* Safe cast since at most the remaining length gets read. */
+        buf_len += (uint32_t)ret_read;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_tree_lazy_read(swicc_disk_tree_st const *const tree,
+                                       uint8_t *const buf)
+{
+    /* A compressed tree is read next to the buffer, then decompressed in it. */
+    bool const lz4 = tree->lazy_lz4 && tree->lazy_len_lz4 < tree->len;
+    uint32_t const len = tree->lazy_lz4 ? tree->lazy_len_lz4 : tree->len;
+    uint8_t *const buf_read = lz4 ? malloc(len) : buf;
+    if (buf_read == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et ret = swicc_disk_tree_lazy_pread(tree, 0U, len, buf_read);
+    if (lz4)
+    {
+        if (ret == SWICC_RET_SUCCESS)
+        {
+            ret = swicc_lz4_decompress(buf_read, len, buf, tree->len);
+        }
+        free(buf_read);
+    }
+    if (ret == SWICC_RET_SUCCESS && tree->check_valid &&
+        swicc_crc32c(0U, buf, tree->len) != tree->check)
+    {
+        ret = SWICC_RET_ERROR;
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_tree_load(swicc_disk_tree_st *const tree)
+{
+    if (tree == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (!tree->lazy)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    if (tree->len < sizeof(swicc_fs_item_hdr_raw_st))
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    uint8_t *const buf = swicc_alloc_malloc(tree->alloc, tree->len);
+    if (buf == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (swicc_disk_tree_lazy_read(tree, buf) != SWICC_RET_SUCCESS)
+    {
+        swicc_alloc_free(tree->alloc, buf);
+        return SWICC_RET_ERROR;
+    }
+
+    /* The tree must hold exactly one MF or ADF. */
+    swicc_fs_item_hdr_st item_hdr;
+    swicc_fs_item_hdr_prs((swicc_fs_item_hdr_raw_st *)buf, 0U, &item_hdr);
+    if ((item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_MF &&
+         item_hdr.type != SWICC_FS_ITEM_TYPE_FILE_ADF) ||
+        item_hdr.size != tree->len)
+    {
+        swicc_alloc_free(tree->alloc, buf);
+        return SWICC_RET_ERROR;
+    }
+
+    tree->buf = buf;
+    tree->size = tree->len;
+    tree->lazy = false;
+    if (swicc_disk_tree_lutsid_rebuild(tree) != SWICC_RET_SUCCESS)
+    {
+        swicc_alloc_free(tree->alloc, tree->buf);
+        tree->buf = NULL;
+        tree->size = 0U;
+        tree->lazy = true;
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
@@ -0,0 +1,726 @@
+#include "disk_internal.h"
+#include <endian.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/**
+ * @brief Append an entry to the end of a LUT (resizes the LUT if needed). The
+ * LUT has to be sorted using 'swicc_disk_lut_sort' after all entries have been
+ * appended.
+ * @param alloc Allocator of the LUT buffers.
+ * @param lut
+ * @param entry_item1 This will be placed in buffer 1 and must have size equal
+ * to the item size 1.
+ * @param entry_item2 This will be placed in buffer 2 and must have size equal
+ * to the item size 2.
+ * @return Return code.
+ */
+static swicc_ret_et lut_append(swicc_alloc_st const *const alloc,
+                               swicc_disk_lut_st *const lut,
+                               uint8_t const *const entry_item1,
+                               uint8_t const *const entry_item2)
+{
+    /* Grow geometrically so appending N entries takes O(N) time in total. */
+    if (lut->count >= lut->count_max)
+    {
+        uint64_t const count_max_new =
+            lut->count_max < SWICC_DISK_LUT_COUNT_START
+                ? SWICC_DISK_LUT_COUNT_START
+                : (uint64_t)lut->count_max * 2U;
+        if (count_max_new > UINT32_MAX)
+        {
+            return SWICC_RET_ERROR;
+        }
+        uint8_t *const buf1_new =
+            swicc_alloc_realloc(alloc, lut->buf1,
+                                lut->count_max * lut->size_item1,
+                                count_max_new * lut->size_item1);
+        if (buf1_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        lut->buf1 = buf1_new;
+        uint8_t *const buf2_new =
+            swicc_alloc_realloc(alloc, lut->buf2,
+                                lut->count_max * lut->size_item2,
+                                count_max_new * lut->size_item2);
+        if (buf2_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        lut->buf2 = buf2_new;
+        /* Safe cast since the count was checked to fit in uint32 range. */
+        lut->count_max = (uint32_t)count_max_new;
+    }
+    memcpy(&lut->buf1[lut->size_item1 * lut->count], entry_item1,
+           lut->size_item1);
+    memcpy(&lut->buf2[lut->size_item2 * lut->count], entry_item2,
+           lut->size_item2);
+    lut->count += 1U;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_lut_sort(swicc_alloc_st const *const alloc,
+                                 swicc_disk_lut_st *const lut)
+{
+    if (lut->count < 2U)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    /* The buffers get swapped so these have to come from the same place. */
+    uint8_t *buf1_dst =
+        swicc_alloc_malloc(alloc, lut->count_max * lut->size_item1);
+    uint8_t *buf2_dst =
+        swicc_alloc_malloc(alloc, lut->count_max * lut->size_item2);
+    if (buf1_dst == NULL || buf2_dst == NULL)
+    {
+        swicc_alloc_free(alloc, buf1_dst);
+        swicc_alloc_free(alloc, buf2_dst);
+        return SWICC_RET_ERROR;
+    }
+
+    /**
+     * The first pass takes the entries in reverse. All passes are stable so
+     * equal entries keep that order.
+     */
+    bool reverse = true;
+    for (uint32_t byte_idx = lut->size_item1; byte_idx-- > 0U;)
+    {
+        uint32_t bucket[UINT8_MAX + 1U] = {0U};
+        for (uint32_t entry_idx = 0U; entry_idx < lut->count; ++entry_idx)
+        {
+            bucket[lut->buf1[(lut->size_item1 * entry_idx) + byte_idx]] += 1U;
+        }
+        /* A byte equal in all entries would leave the order as it is. */
+        if (!reverse && bucket[lut->buf1[byte_idx]] == lut->count)
+        {
+            continue;
+        }
+        uint32_t bucket_start = 0U;
+        for (uint32_t bucket_idx = 0U; bucket_idx <= UINT8_MAX; ++bucket_idx)
+        {
+            uint32_t const bucket_count = bucket[bucket_idx];
+            bucket[bucket_idx] = bucket_start;
+            bucket_start += bucket_count;
+        }
+        for (uint32_t pos = 0U; pos < lut->count; ++pos)
+        {
+            uint32_t const entry_idx = reverse ? lut->count - 1U - pos : pos;
+            uint32_t const entry_idx_dst =
+                bucket[lut->buf1[(lut->size_item1 * entry_idx) + byte_idx]]++;
+            memcpy(&buf1_dst[lut->size_item1 * entry_idx_dst],
+                   &lut->buf1[lut->size_item1 * entry_idx], lut->size_item1);
+            memcpy(&buf2_dst[lut->size_item2 * entry_idx_dst],
+                   &lut->buf2[lut->size_item2 * entry_idx], lut->size_item2);
+        }
+        uint8_t *const buf1_src = lut->buf1;
+        uint8_t *const buf2_src = lut->buf2;
+        lut->buf1 = buf1_dst;
+        lut->buf2 = buf2_dst;
+        buf1_dst = buf1_src;
+        buf2_dst = buf2_src;
+        reverse = false;
+    }
+    swicc_alloc_free(alloc, buf1_dst);
+    swicc_alloc_free(alloc, buf2_dst);
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Find the first entry of a LUT whose item 1 is equal to a given value.
+ * Relies on item 1 of all entries being in increasing order.
+ * @param lut
+ * @param item1 Must have size equal to the item size 1.
+ * @param entry_idx Where the index of the entry will be written.
+ * @return Return code.
+ */
+static swicc_ret_et lut_lookup(swicc_disk_lut_st const *const lut,
+                               uint8_t const *const item1,
+                               uint32_t *const entry_idx)
+{
+    /* Finds the first entry >= the value. */
+    uint32_t start = 0U;
+    uint32_t end = lut->count;
+    uint32_t mid;
+    while (start < end)
+    {
+        mid = (start + end) / 2U;
+        if (memcmp(&lut->buf1[lut->size_item1 * mid], item1, lut->size_item1) <
+            0)
+        {
+            start = mid + 1U;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+    if (start >= lut->count ||
+        memcmp(&lut->buf1[lut->size_item1 * start], item1, lut->size_item1) !=
+            0)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+    *entry_idx = start;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_lut_rebuild(swicc_disk_st *const disk)
+{
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    swicc_disk_tree_st *tree = disk->root;
+    while (tree != NULL)
+    {
+        ret = swicc_disk_lutsid_rebuild(disk, tree);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            return ret;
+        }
+        tree = tree->next;
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = swicc_disk_lutid_rebuild(disk);
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_lutname_item(
+    swicc_fs_file_st const *const file,
+    uint8_t entry_item1[1U + SWICC_FS_NAME_LEN])
+{
+    switch (file->hdr_item.type)
+    {
+    case SWICC_FS_ITEM_TYPE_FILE_MF:
+        entry_item1[0U] = SWICC_DISK_LUTNAME_KIND_DFNAME;
+        memcpy(&entry_item1[1U], file->hdr_spec.mf.name, SWICC_FS_NAME_LEN);
+        return SWICC_RET_SUCCESS;
+    case SWICC_FS_ITEM_TYPE_FILE_DF:
+        entry_item1[0U] = SWICC_DISK_LUTNAME_KIND_DFNAME;
+        memcpy(&entry_item1[1U], file->hdr_spec.df.name, SWICC_FS_NAME_LEN);
+        return SWICC_RET_SUCCESS;
+    case SWICC_FS_ITEM_TYPE_FILE_ADF:
+        entry_item1[0U] = SWICC_DISK_LUTNAME_KIND_AID;
+        memcpy(&entry_item1[1U], file->hdr_spec.adf.aid.rid,
+               SWICC_FS_ADF_AID_RID_LEN);
+        memcpy(&entry_item1[1U + SWICC_FS_ADF_AID_RID_LEN],
+               file->hdr_spec.adf.aid.pix, SWICC_FS_ADF_AID_PIX_LEN);
+        return SWICC_RET_SUCCESS;
+    default:
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+}
+
+swicc_ret_et swicc_disk_lutid_rebuild_cb(swicc_disk_tree_st *const tree,
+                                         swicc_fs_file_st *const file,
+                                         void *const userdata)
+{
+    swicc_disk_lutid_rebuild_cb_userdata_st const *const userdata_struct =
+        userdata;
+    swicc_disk_lut_st *const lutid = userdata_struct->lut;
+    uint8_t entry_item2[lutid->size_item2];
+    memcpy(&entry_item2[0U], &file->hdr_item.offset_trel, sizeof(uint32_t));
+    memcpy(&entry_item2[sizeof(uint32_t)], &userdata_struct->tree_idx,
+           sizeof(uint8_t));
+
+    /* Insert the name + offset into the name LUT (only for named files). */
+    uint8_t entry_name[1U + SWICC_FS_NAME_LEN];
+    if (swicc_disk_lutname_item(file, entry_name) == SWICC_RET_SUCCESS)
+    {
+        swicc_ret_et const ret_name =
+            lut_append(tree->alloc, userdata_struct->lutname, entry_name,
+                       entry_item2);
+        if (ret_name != SWICC_RET_SUCCESS)
+        {
+            return ret_name;
+        }
+    }
+
+    if (file->hdr_file.id == SWICC_FS_ID_MISSING)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Insert the ID + offset into the ID LUT. */
+    uint8_t entry_item1[sizeof(swicc_fs_id_kt)];
+    /**
+     * @note IDs are kept in big-endian inside the LUT so that they are sorted
+     * from MSB to LSB.
+     */
+    swicc_fs_id_kt const id_be = htobe16(file->hdr_file.id);
+    memcpy(entry_item1, &id_be, sizeof(swicc_fs_id_kt));
+    return lut_append(tree->alloc, lutid, entry_item1, entry_item2);
+}
+
+swicc_ret_et swicc_disk_lutid_rebuild(swicc_disk_st *const disk)
+{
+    if (disk == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (disk->base != NULL)
+    {
+        /* The ID LUT is shared with the base disk. */
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    /* Cleanup the old ID LUT before rebuilding it. */
+    swicc_disk_lutid_empty(disk);
+    disk->lutid.size_item1 = sizeof(swicc_fs_id_kt);
+    disk->lutid.size_item2 =
+        sizeof(uint32_t) + sizeof(uint8_t); /* Offset + tree index */
+    disk->lutid.count_max = SWICC_DISK_LUT_COUNT_START;
+    disk->lutid.count = 0U;
+    disk->lutid.buf1 = swicc_alloc_malloc(
+        disk->alloc, disk->lutid.count_max * disk->lutid.size_item1);
+    disk->lutid.buf2 = swicc_alloc_malloc(
+        disk->alloc, disk->lutid.count_max * disk->lutid.size_item2);
+    disk->lutname.size_item1 = 1U + SWICC_FS_NAME_LEN; /* Kind + name */
+    disk->lutname.size_item2 = disk->lutid.size_item2;
+    disk->lutname.count_max = SWICC_DISK_LUT_COUNT_START;
+    disk->lutname.count = 0U;
+    disk->lutname.buf1 = swicc_alloc_malloc(
+        disk->alloc, disk->lutname.count_max * disk->lutname.size_item1);
+    disk->lutname.buf2 = swicc_alloc_malloc(
+        disk->alloc, disk->lutname.count_max * disk->lutname.size_item2);
+    if (disk->lutid.buf1 == NULL || disk->lutid.buf2 == NULL ||
+        disk->lutname.buf1 == NULL || disk->lutname.buf2 == NULL)
+    {
+        swicc_disk_lutid_empty(disk);
+        return SWICC_RET_ERROR;
+    }
+
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st const *tree_cnt = disk->root; tree_cnt != NULL;
+         tree_cnt = tree_cnt->next)
+    {
+        tree_count += 1U;
+    }
+    if (tree_count > 0U)
+    {
+        disk->lutid_tree = swicc_alloc_malloc(
+            disk->alloc, tree_count * sizeof(swicc_disk_tree_st *));
+        if (disk->lutid_tree == NULL)
+        {
+            swicc_disk_lutid_empty(disk);
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    swicc_disk_tree_st *tree = disk->root;
+    uint8_t tree_idx = 0U;
+    while (tree != NULL)
+    {
+        disk->lutid_tree[disk->lutid_tree_count++] = tree;
+        swicc_disk_lutid_rebuild_cb_userdata_st userdata = {.lut = &disk->lutid,
+                                                 .lutname = &disk->lutname,
+                                                 .tree_idx = tree_idx};
+        swicc_fs_file_st file_root;
+        ret = swicc_disk_tree_load(tree);
+        if (ret == SWICC_RET_SUCCESS)
+        {
+            ret = swicc_disk_tree_file_root(tree, &file_root);
+        }
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            swicc_disk_lutid_empty(disk);
+            break;
+        }
+        ret = swicc_disk_file_foreach(tree, &file_root,
+                                      swicc_disk_lutid_rebuild_cb, &userdata,
+                                      true);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            swicc_disk_lutid_empty(disk);
+            break;
+        }
+
+        tree = tree->next;
+
+        /**
+         * Unsafe cast that relies on there being fewer than 256 trees in the
+         * forest.
+         */
+        tree_idx = (uint8_t)(tree_idx + 1U);
+    }
+    if (ret == SWICC_RET_SUCCESS &&
+        (swicc_disk_lut_sort(disk->alloc, &disk->lutid) !=
+             SWICC_RET_SUCCESS ||
+         swicc_disk_lut_sort(disk->alloc, &disk->lutname) !=
+             SWICC_RET_SUCCESS))
+    {
+        swicc_disk_lutid_empty(disk);
+        ret = SWICC_RET_ERROR;
+    }
+    return ret;
+}
+
+/**
+ * @brief Callback used when rebuilding the SID LUT. It receives files and
+ * inserts their info into the SID LUT.
+ * @param tree
+ * @param file
+ * @param userdata
+ * @return Return code.
+ */
+static swicc_disk_file_foreach_cb lutsid_rebuild_cb;
+static swicc_ret_et lutsid_rebuild_cb(swicc_disk_tree_st *const tree,
+                                      swicc_fs_file_st *const file,
+                                      void *const userdata)
+{
+    if (file->hdr_file.sid == SWICC_FS_SID_MISSING)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    /**
+     * Sorting puts entries with equal SIDs in reverse order of being visited
+     * so when SIDs repeat, the direct table ends up pointing to the same file
+     * as the first entry of that SID in the LUT.
+     */
+    if (file->hdr_file.sid < SWICC_DISK_LUTSID_DIRECT_COUNT)
+    {
+        tree->lutsid_direct[file->hdr_file.sid] = file->hdr_item.offset_trel;
+    }
+
+    /* Insert the SID + offset into the SID LUT. */
+    return lut_append(tree->alloc, &tree->lutsid,
+                      (uint8_t *)&file->hdr_file.sid,
+                      (uint8_t *)&file->hdr_item.offset_trel);
+}
+
+swicc_ret_et swicc_disk_tree_lutsid_rebuild(swicc_disk_tree_st *const tree)
+{
+    /* Cleanup the old SID LUT before rebuilding it. */
+    swicc_disk_lutsid_empty(tree);
+    tree->lutsid.size_item1 = sizeof(swicc_fs_sid_kt);
+    tree->lutsid.size_item2 = sizeof(uint32_t);
+    tree->lutsid.count_max = SWICC_DISK_LUT_COUNT_START;
+    tree->lutsid.count = 0U;
+    tree->lutsid.buf1 = swicc_alloc_malloc(
+        tree->alloc, tree->lutsid.count_max * tree->lutsid.size_item1);
+    tree->lutsid.buf2 = swicc_alloc_malloc(
+        tree->alloc, tree->lutsid.count_max * tree->lutsid.size_item2);
+    if (tree->lutsid.buf1 == NULL || tree->lutsid.buf2 == NULL)
+    {
+        swicc_disk_lutsid_empty(tree);
+        return SWICC_RET_ERROR;
+    }
+
+    swicc_fs_file_st file_root;
+    swicc_ret_et ret = swicc_disk_tree_file_root(tree, &file_root);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        swicc_disk_lutsid_empty(tree);
+        return ret;
+    }
+    ret = swicc_disk_descr_foreach(tree, lutsid_rebuild_cb);
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        ret = swicc_disk_lut_sort(tree->alloc, &tree->lutsid);
+    }
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        swicc_disk_lutsid_empty(tree);
+        return ret;
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_disk_lutsid_rebuild(swicc_disk_st *const disk,
+                                       swicc_disk_tree_st *const tree)
+{
+    if (disk == NULL || tree == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (tree->shared)
+    {
+        /* The SID LUT is shared with the tree of the base disk. */
+        return SWICC_RET_ERROR;
+    }
+    if (swicc_disk_tree_load(tree) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return swicc_disk_tree_lutsid_rebuild(tree);
+}
+
+swicc_ret_et swicc_disk_lutsid_lookup(swicc_disk_tree_st const *const tree,
+                                      swicc_fs_sid_kt const sid,
+                                      swicc_fs_file_st *const file)
+{
+    if (tree == NULL || file == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_disk_lut_st const *const lutsid = &tree->lutsid;
+    /* Make sure the SID LUT is as expected. */
+    if (lutsid->buf1 == NULL || lutsid->size_item1 != sizeof(swicc_fs_sid_kt) ||
+        lutsid->size_item2 != sizeof(uint32_t))
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* Find the file by SID. */
+    uint32_t offset;
+    if (sid < SWICC_DISK_LUTSID_DIRECT_COUNT)
+    {
+        offset = tree->lutsid_direct[sid];
+        if (offset == SWICC_DISK_LUTSID_DIRECT_NONE)
+        {
+            return SWICC_RET_FS_NOT_FOUND;
+        }
+    }
+    else
+    {
+        uint32_t entry_idx;
+        swicc_ret_et const ret_lookup = lut_lookup(lutsid, &sid, &entry_idx);
+        if (ret_lookup != SWICC_RET_SUCCESS)
+        {
+            return ret_lookup;
+        }
+        offset = *(uint32_t *)&lutsid->buf2[lutsid->size_item2 * entry_idx];
+    }
+    /* Offset too large. */
+    if (offset >= tree->len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (swicc_fs_file_prs(tree, offset, file) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_lutid_lookup(swicc_disk_st const *const disk,
+                                     swicc_disk_tree_st **const tree,
+                                     swicc_fs_id_kt const id,
+                                     swicc_fs_file_st *const file)
+{
+    if (disk == NULL || tree == NULL || file == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_disk_lut_st const *const lutid = &disk->lutid;
+
+    /* Make sure the ID LUT is as expected. */
+    if (lutid->buf1 == NULL || lutid->size_item1 != sizeof(swicc_fs_id_kt) ||
+        lutid->size_item2 != sizeof(uint32_t) + sizeof(uint8_t))
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* Find the file by ID. */
+    uint32_t entry_idx;
+    /* ID's are stored in big-endian inside the LUT. */
+    swicc_fs_id_kt const id_be = htobe16(id);
+    swicc_ret_et const ret_lookup =
+        lut_lookup(lutid, (uint8_t const *)&id_be, &entry_idx);
+    if (ret_lookup != SWICC_RET_SUCCESS)
+    {
+        return ret_lookup;
+    }
+
+    uint32_t const offset =
+        *(uint32_t *)&lutid->buf2[(lutid->size_item2 * entry_idx) + 0U];
+    uint8_t const tree_idx =
+        lutid->buf2[(lutid->size_item2 * entry_idx) + sizeof(uint32_t)];
+
+    /* Find the tree in which the file resides. */
+    if (tree_idx < disk->lutid_tree_count)
+    {
+        *tree = disk->lutid_tree[tree_idx];
+    }
+    else
+    {
+        /* The tree array is missing e.g. when the LUT was made elsewhere. */
+        swicc_disk_tree_iter_st tree_iter;
+        if (swicc_disk_tree_iter(disk, &tree_iter) != SWICC_RET_SUCCESS ||
+            swicc_disk_tree_iter_idx(&tree_iter, tree_idx, tree) !=
+                SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    /* Offset too large. */
+    if (offset >= (*tree)->len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /**
+     * The entries of a lazily loaded LUT were only checked to be in bounds so
+     * the ID has to be checked too.
+     */
+    if (swicc_disk_tree_load(*tree) != SWICC_RET_SUCCESS ||
+        swicc_fs_file_prs(*tree, offset, file) != SWICC_RET_SUCCESS ||
+        file->hdr_file.id != id)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_lutid_dup_find(swicc_disk_st const *const disk,
+                                       swicc_disk_tree_st **const tree,
+                                       swicc_fs_file_st *const file)
+{
+    if (disk == NULL || tree == NULL || file == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_disk_lut_st const *const lutid = &disk->lutid;
+
+    /* The LUT is sorted so files with equal IDs are next to each other. */
+    for (uint32_t entry_idx = 1U; entry_idx < lutid->count; ++entry_idx)
+    {
+        uint8_t const *const item1 =
+            &lutid->buf1[lutid->size_item1 * entry_idx];
+        uint8_t const *const item2 =
+            &lutid->buf2[lutid->size_item2 * entry_idx];
+        for (uint32_t other_idx = entry_idx; other_idx-- > 0U;)
+        {
+            uint8_t const *const other_item1 =
+                &lutid->buf1[lutid->size_item1 * other_idx];
+            uint8_t const *const other_item2 =
+                &lutid->buf2[lutid->size_item2 * other_idx];
+            if (memcmp(item1, other_item1, lutid->size_item1) != 0)
+            {
+                break;
+            }
+            uint8_t const tree_idx = item2[sizeof(uint32_t)];
+            if (tree_idx != other_item2[sizeof(uint32_t)] ||
+                tree_idx >= disk->lutid_tree_count)
+            {
+                continue;
+            }
+
+            swicc_disk_tree_st *const tree_dup = disk->lutid_tree[tree_idx];
+            if (swicc_disk_tree_load(tree_dup) != SWICC_RET_SUCCESS)
+            {
+                return SWICC_RET_ERROR;
+            }
+            uint32_t offsets[2U];
+            memcpy(&offsets[0U], item2, sizeof(uint32_t));
+            memcpy(&offsets[1U], other_item2, sizeof(uint32_t));
+            swicc_fs_file_st files[2U];
+            swicc_fs_file_st parents[2U];
+            if (swicc_fs_file_prs(tree_dup, offsets[0U], &files[0U]) !=
+                    SWICC_RET_SUCCESS ||
+                swicc_fs_file_prs(tree_dup, offsets[1U], &files[1U]) !=
+                    SWICC_RET_SUCCESS ||
+                swicc_disk_tree_file_parent(tree_dup, &files[0U],
+                                            &parents[0U]) !=
+                    SWICC_RET_SUCCESS ||
+                swicc_disk_tree_file_parent(tree_dup, &files[1U],
+                                            &parents[1U]) != SWICC_RET_SUCCESS)
+            {
+                return SWICC_RET_ERROR;
+            }
+            if (parents[0U].hdr_item.offset_trel ==
+                parents[1U].hdr_item.offset_trel)
+            {
+                *tree = tree_dup;
+                *file = offsets[0U] > offsets[1U] ? files[0U] : files[1U];
+                return SWICC_RET_SUCCESS;
+            }
+        }
+    }
+    return SWICC_RET_FS_NOT_FOUND;
+}
+
+swicc_ret_et swicc_disk_lutname_lookup(swicc_disk_st const *const disk,
+                                       swicc_disk_lutname_kind_et const kind,
+                                       uint8_t const *const name,
+                                       uint32_t const name_len,
+                                       swicc_disk_tree_st **const tree,
+                                       swicc_fs_file_st *const file)
+{
+    if (disk == NULL || name == NULL || name_len > SWICC_FS_NAME_LEN ||
+        tree == NULL || file == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_disk_lut_st const *const lutname = &disk->lutname;
+
+    /* Make sure the name LUT is as expected. */
+    if (lutname->buf1 == NULL ||
+        lutname->size_item1 != 1U + SWICC_FS_NAME_LEN ||
+        lutname->size_item2 != sizeof(uint32_t) + sizeof(uint8_t))
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /**
+     * Search for the first entry whose prefix is not less than the requested
+     * (possibly partial) name, all matches follow it.
+     */
+    uint8_t key[1U + SWICC_FS_NAME_LEN];
+    key[0U] = (uint8_t)kind;
+    memcpy(&key[1U], name, name_len);
+    uint32_t const key_len = 1U + name_len;
+    uint32_t start = 0U;
+    uint32_t end = lutname->count;
+    while (start < end)
+    {
+        uint32_t const mid = (start + end) / 2U;
+        if (memcmp(&lutname->buf1[lutname->size_item1 * mid], key, key_len) <
+            0)
+        {
+            start = mid + 1U;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+
+    /* Out of all matches, pick the one that comes first in tree order. */
+    bool found = false;
+    uint32_t offset = 0U;
+    uint8_t tree_idx = 0U;
+    for (uint32_t entry_idx = start;
+         entry_idx < lutname->count &&
+         memcmp(&lutname->buf1[lutname->size_item1 * entry_idx], key,
+                key_len) == 0;
+         ++entry_idx)
+    {
+        uint32_t entry_offset;
+        memcpy(&entry_offset, &lutname->buf2[lutname->size_item2 * entry_idx],
+               sizeof(entry_offset));
+        uint8_t const entry_tree_idx =
+            lutname->buf2[(lutname->size_item2 * entry_idx) + sizeof(uint32_t)];
+        if (!found || entry_tree_idx < tree_idx ||
+            (entry_tree_idx == tree_idx && entry_offset < offset))
+        {
+            found = true;
+            offset = entry_offset;
+            tree_idx = entry_tree_idx;
+        }
+    }
+    if (!found)
+    {
+        return SWICC_RET_FS_NOT_FOUND;
+    }
+
+    if (tree_idx >= disk->lutid_tree_count)
+    {
+        return SWICC_RET_ERROR;
+    }
+    *tree = disk->lutid_tree[tree_idx];
+    uint8_t entry_name[1U + SWICC_FS_NAME_LEN];
+    if (offset >= (*tree)->len ||
+        swicc_disk_tree_load(*tree) != SWICC_RET_SUCCESS ||
+        swicc_fs_file_prs(*tree, offset, file) != SWICC_RET_SUCCESS ||
+        swicc_disk_lutname_item(file, entry_name) != SWICC_RET_SUCCESS ||
+        memcmp(entry_name, key, key_len) != 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/**
+ * @brief Find where a page is, or would be, in the cache.
+ * @param cache
+ * @param remote_id
+ * @param page_idx
+ * @param pos Will receive the position of the page, or where to insert it.
+ * @return True if the page is in the cache.
+ * @note The cache must be locked.
+ */
+static bool cache_lookup(swicc_disk_cache_st const *const cache,
+                         uint64_t const remote_id, uint64_t const page_idx,
+                         uint32_t *const pos)
+{
+    uint32_t lo = 0U;
+    uint32_t hi = cache->page_count;
+    while (lo < hi)
+    {
+        uint32_t const mid = lo + ((hi - lo) / 2U);
+        swicc_disk_cache_page_st const *const page = &cache->page[mid];
+        if (page->remote_id < remote_id ||
+            (page->remote_id == remote_id && page->page_idx < page_idx))
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    *pos = lo;
+    return lo < cache->page_count && cache->page[lo].remote_id == remote_id &&
+           cache->page[lo].page_idx == page_idx;
+}
+
+/**
+ * @brief Add a page to the cache, replacing the least recently read one when
+ * the cache is full.
+ * @param cache
+ * @param page The page to add, its buffer is taken over by the cache.
+ * @param pos Where to insert the page as given by the lookup.
+ * @note The cache must be locked and must not hold the page yet.
+ */
+static void cache_insert(swicc_disk_cache_st *const cache,
+                         swicc_disk_cache_page_st const *const page,
+                         uint32_t pos)
+{
+    if (cache->page_count >= cache->page_count_max)
+    {
+        uint32_t evict_idx = 0U;
+        for (uint32_t page_idx = 1U; page_idx < cache->page_count; ++page_idx)
+        {
+            if (cache->page[page_idx].used < cache->page[evict_idx].used)
+            {
+                evict_idx = page_idx;
+            }
+        }
+        free(cache->page[evict_idx].buf);
+        memmove(&cache->page[evict_idx], &cache->page[evict_idx + 1U],
+                (cache->page_count - evict_idx - 1U) * sizeof(*cache->page));
+        cache->page_count -= 1U;
+        if (evict_idx < pos)
+        {
+            pos -= 1U;
+        }
+    }
+    memmove(&cache->page[pos + 1U], &cache->page[pos],
+            (cache->page_count - pos) * sizeof(*cache->page));
+    cache->page[pos] = *page;
+    cache->page_count += 1U;
+}
+
+/**
+ * @brief Read a part of one page of the disk file of a remote through its
+ * cache. The remote is read without holding the lock so other readers of the
+ * cache are not held up by fetches.
+ * @param remote
+ * @param page_idx
+ * @param page_offset Offset of the bytes in the page.
+ * @param len Number of bytes to read, they must all be in the page.
+ * @param buf
+ * @return Return code.
+ */
+static swicc_ret_et remote_page_read(swicc_disk_remote_st const *const remote,
+                                     uint64_t const page_idx,
+                                     uint32_t const page_offset,
+                                     uint32_t const len, uint8_t *const buf)
+{
+    swicc_disk_cache_st *const cache = remote->cache;
+    uint32_t pos;
+    pthread_mutex_lock(&cache->lock);
+    if (cache_lookup(cache, remote->id, page_idx, &pos))
+    {
+        cache->page[pos].used = ++cache->tick;
+        cache->hit_count += 1U;
+        memcpy(buf, &cache->page[pos].buf[page_offset], len);
+        pthread_mutex_unlock(&cache->lock);
+        return SWICC_RET_SUCCESS;
+    }
+    cache->miss_count += 1U;
+    pthread_mutex_unlock(&cache->lock);
+
+    uint64_t const offset = page_idx * SWICC_DISK_CACHE_PAGE_SIZE;
+    /* Safe cast since the page is at most the page size long. */
+    uint32_t const page_len =
+        (uint32_t)(remote->len - offset < SWICC_DISK_CACHE_PAGE_SIZE
+                       ? remote->len - offset
+                       : SWICC_DISK_CACHE_PAGE_SIZE);
+    swicc_disk_cache_page_st page = {
+        .remote_id = remote->id,
+        .page_idx = page_idx,
+        .used = 0U,
+        .len = page_len,
+        .buf = malloc(page_len),
+    };
+    if (page.buf == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (remote->read(remote->userdata, offset, page_len, page.buf) !=
+        SWICC_RET_SUCCESS)
+    {
+        free(page.buf);
+        return SWICC_RET_ERROR;
+    }
+    memcpy(buf, &page.buf[page_offset], len);
+
+    pthread_mutex_lock(&cache->lock);
+    /* Another reader may have fetched the same page in the meantime. */
+    if (cache_lookup(cache, remote->id, page_idx, &pos))
+    {
+        free(page.buf);
+    }
+    else
+    {
+        page.used = ++cache->tick;
+        cache_insert(cache, &page, pos);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_disk_cache_init(swicc_disk_cache_st *const cache,
+                                   uint32_t const page_count_max)
+{
+    if (cache == NULL || page_count_max == 0U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    memset(cache, 0U, sizeof(*cache));
+    cache->page = malloc(page_count_max * sizeof(*cache->page));
+    if (cache->page == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (pthread_mutex_init(&cache->lock, NULL) != 0)
+    {
+        free(cache->page);
+        cache->page = NULL;
+        return SWICC_RET_ERROR;
+    }
+    cache->page_count_max = page_count_max;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_disk_cache_deinit(swicc_disk_cache_st *const cache)
+{
+    if (cache == NULL || cache->page == NULL)
+    {
+        return;
+    }
+    for (uint32_t page_idx = 0U; page_idx < cache->page_count; ++page_idx)
+    {
+        free(cache->page[page_idx].buf);
+    }
+    free(cache->page);
+    pthread_mutex_destroy(&cache->lock);
+    memset(cache, 0U, sizeof(*cache));
+}
+
+swicc_ret_et swicc_disk_remote_read(swicc_disk_remote_st const *const remote,
+                                    uint64_t const offset, uint32_t const len,
+                                    uint8_t *const buf)
+{
+    if (remote == NULL || remote->read == NULL || (buf == NULL && len > 0U))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (offset > remote->len || len > remote->len - offset)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (remote->cache == NULL)
+    {
+        return len > 0U ? remote->read(remote->userdata, offset, len, buf)
+                        : SWICC_RET_SUCCESS;
+    }
+
+    uint32_t buf_len = 0U;
+    while (buf_len < len)
+    {
+        uint64_t const offset_cur = offset + buf_len;
+        /* Safe cast since the remainder is less than the page size. */
+        uint32_t const page_offset =
+            (uint32_t)(offset_cur % SWICC_DISK_CACHE_PAGE_SIZE);
+        uint32_t const page_len =
+            SWICC_DISK_CACHE_PAGE_SIZE - page_offset < len - buf_len
+                ? SWICC_DISK_CACHE_PAGE_SIZE - page_offset
+                : len - buf_len;
+        swicc_ret_et const ret = remote_page_read(
+            remote, offset_cur / SWICC_DISK_CACHE_PAGE_SIZE, page_offset,
+            page_len, &buf[buf_len]);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            return ret;
+        }
+        buf_len += page_len;
+    }
+    return SWICC_RET_SUCCESS;
+}
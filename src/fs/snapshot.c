@@ -0,0 +1,362 @@
+#include "disk_internal.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Add an extent to a snapshot buffer.
+ * @param[in, out] buf
+ * @param[in] offset Offset of the extent in the disk file.
+ * @param[in] len Length of the extent.
+ * @param[out] data Where the data of the extent has to be written.
+ * @return Return code.
+ */
+static swicc_ret_et snapshot_extent_add(swicc_snapshot_buf_st *const buf,
+                                        uint32_t const offset,
+                                        uint32_t const len,
+                                        uint8_t **const data)
+{
+    if (buf->extent_count >= buf->extent_count_max)
+    {
+        uint32_t const count_max_new =
+            buf->extent_count_max == 0U ? 8U : buf->extent_count_max * 2U;
+        swicc_snapshot_extent_st *const extent_new =
+            realloc(buf->extent, count_max_new * sizeof(*extent_new));
+        if (extent_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        buf->extent = extent_new;
+        buf->extent_count_max = count_max_new;
+    }
+    if (len > UINT32_MAX - buf->data_len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (buf->data_len + len > buf->data_size)
+    {
+        uint64_t size_new = buf->data_size == 0U
+                                ? SWICC_DISK_DIRTY_PAGE_SIZE
+                                : (uint64_t)buf->data_size * 2U;
+        while (size_new < (uint64_t)buf->data_len + len)
+        {
+            size_new *= 2U;
+        }
+        if (size_new > UINT32_MAX)
+        {
+            size_new = UINT32_MAX;
+        }
+        uint8_t *const data_new = realloc(buf->data, size_new);
+        if (data_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        buf->data = data_new;
+        /* Safe cast since the size was limited to uint32 range. */
+        buf->data_size = (uint32_t)size_new;
+    }
+    *data = &buf->data[buf->data_len];
+    buf->extent[buf->extent_count] = (swicc_snapshot_extent_st){
+        .offset = offset,
+        .len = len,
+    };
+    buf->extent_count += 1U;
+    buf->data_len += len;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Add all dirty pages of a tree to a snapshot buffer, merging
+ * consecutive pages into one extent.
+ * @param[in, out] buf
+ * @param[in] tree
+ * @param[in] tree_offset Offset of the tree in the disk file.
+ * @return Return code.
+ */
+static swicc_ret_et snapshot_tree_capture(swicc_snapshot_buf_st *const buf,
+                                          swicc_disk_tree_st const *const tree,
+                                          uint32_t const tree_offset)
+{
+    uint32_t const page_count = tree->dirty_word_count * 64U;
+    uint32_t page = 0U;
+    while (page < page_count)
+    {
+        if (page % 64U == 0U && tree->dirty[page / 64U] == 0U)
+        {
+            page += 64U;
+            continue;
+        }
+        if ((tree->dirty[page / 64U] & (1ULL << (page % 64U))) == 0U)
+        {
+            page += 1U;
+            continue;
+        }
+        uint32_t const page_start = page;
+        while (page < page_count &&
+               (tree->dirty[page / 64U] & (1ULL << (page % 64U))) != 0U)
+        {
+            page += 1U;
+        }
+
+        /* Dirty pages are inside the tree but the last one may be partial. */
+        uint32_t const start = page_start * SWICC_DISK_DIRTY_PAGE_SIZE;
+        uint64_t const end_page = (uint64_t)page * SWICC_DISK_DIRTY_PAGE_SIZE;
+        /* Safe cast since the end is limited to the tree length. */
+        uint32_t const end =
+            end_page > tree->len ? tree->len : (uint32_t)end_page;
+        uint8_t *data;
+        if (start >= end ||
+            snapshot_extent_add(buf, tree_offset + start, end - start,
+                                &data) != SWICC_RET_SUCCESS ||
+            swicc_disk_tree_read(tree, start, end - start, data) !=
+                SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Add the checksum of a modified tree to a snapshot buffer so that the
+ * index of the disk file keeps matching the tree. Only the pages that were
+ * modified get read to update the checksum.
+ * @param[in, out] buf
+ * @param[in, out] tree
+ * @param[in] index_tree_offset Offset of the index entry of the tree in the
+ * disk file.
+ * @return Return code.
+ */
+static swicc_ret_et snapshot_check_capture(swicc_snapshot_buf_st *const buf,
+                                           swicc_disk_tree_st *const tree,
+                                           uint32_t const index_tree_offset)
+{
+    uint32_t check;
+    uint8_t *data;
+    if (swicc_disk_tree_check(tree, &check) != SWICC_RET_SUCCESS ||
+        snapshot_extent_add(
+            buf,
+            index_tree_offset +
+                (uint32_t)offsetof(swicc_disk_index_tree_raw_st, check),
+            sizeof(check), &data) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(data, &check, sizeof(check));
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_snapshot_init(swicc_snapshot_st *const snapshot,
+                                 swicc_disk_st const *const disk,
+                                 char const *const disk_path)
+{
+    if (snapshot == NULL || disk == NULL || disk_path == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    memset(snapshot, 0U, sizeof(*snapshot));
+    atomic_store_explicit(&snapshot->epoch_captured, 0U, memory_order_relaxed);
+    atomic_store_explicit(&snapshot->epoch_written, 0U, memory_order_relaxed);
+
+    int const fd = open(disk_path, O_RDWR);
+    if (fd < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* The trees are preceded by the magic and maybe by an index. */
+    uint8_t const magic_plain[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC;
+    uint8_t const magic_index[SWICC_DISK_MAGIC_LEN] = SWICC_DISK_MAGIC_INDEX;
+    uint8_t magic[SWICC_DISK_MAGIC_LEN];
+    swicc_disk_index_hdr_raw_st index_hdr = {0U};
+    uint64_t tree_offset = SWICC_DISK_MAGIC_LEN;
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        tree_count += 1U;
+    }
+    if (pread(fd, magic, sizeof(magic), 0) != (ssize_t)sizeof(magic))
+    {
+        close(fd);
+        return SWICC_RET_ERROR;
+    }
+    if (memcmp(magic, magic_index, sizeof(magic)) == 0)
+    {
+        /* The checksums of the trees in the index get updated as well. */
+        if (pread(fd, &index_hdr, sizeof(index_hdr), SWICC_DISK_MAGIC_LEN) !=
+                (ssize_t)sizeof(index_hdr) ||
+            index_hdr.tree_count != tree_count ||
+            sizeof(index_hdr) + ((uint64_t)tree_count *
+                                 sizeof(swicc_disk_index_tree_raw_st)) >
+                index_hdr.size)
+        {
+            close(fd);
+            return SWICC_RET_ERROR;
+        }
+        tree_offset += index_hdr.size;
+    }
+    else if (memcmp(magic, magic_plain, sizeof(magic)) != 0)
+    {
+        close(fd);
+        return SWICC_RET_ERROR;
+    }
+
+    /* The file has to have the same layout as the disk. */
+    uint64_t disk_len = tree_offset;
+    for (swicc_disk_tree_st const *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        disk_len += tree->len;
+    }
+    struct stat f_stat;
+    if (disk_len > UINT32_MAX || fstat(fd, &f_stat) != 0 ||
+        (uint64_t)f_stat.st_size != disk_len)
+    {
+        close(fd);
+        return SWICC_RET_ERROR;
+    }
+
+    snapshot->fd = fd;
+    /* Safe cast since the whole disk was checked to fit in uint32 range. */
+    snapshot->tree_offset = (uint32_t)tree_offset;
+    snapshot->index_tree_offset =
+        index_hdr.size == 0U
+            ? 0U
+            : SWICC_DISK_MAGIC_LEN + (uint32_t)sizeof(index_hdr);
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_snapshot_deinit(swicc_snapshot_st *const snapshot)
+{
+    if (snapshot == NULL)
+    {
+        return;
+    }
+    close(snapshot->fd);
+    for (uint32_t buf_idx = 0U; buf_idx < SWICC_SNAPSHOT_BUF_COUNT; ++buf_idx)
+    {
+        free(snapshot->buf[buf_idx].extent);
+        free(snapshot->buf[buf_idx].data);
+    }
+    memset(snapshot, 0U, sizeof(*snapshot));
+}
+
+swicc_ret_et swicc_snapshot_capture(swicc_snapshot_st *const snapshot,
+                                    swicc_disk_st *const disk)
+{
+    if (snapshot == NULL || disk == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t const captured =
+        atomic_load_explicit(&snapshot->epoch_captured, memory_order_relaxed);
+    uint32_t const written =
+        atomic_load_explicit(&snapshot->epoch_written, memory_order_acquire);
+    if (captured - written >= SWICC_SNAPSHOT_BUF_COUNT)
+    {
+        return SWICC_RET_SNAPSHOT_BUSY;
+    }
+
+    swicc_snapshot_buf_st *const buf =
+        &snapshot->buf[captured % SWICC_SNAPSHOT_BUF_COUNT];
+    buf->extent_count = 0U;
+    buf->data_len = 0U;
+    uint64_t tree_offset = snapshot->tree_offset;
+    uint32_t tree_idx = 0U;
+    for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        uint32_t const extent_count = buf->extent_count;
+        if (tree_offset + tree->len > UINT32_MAX ||
+            /* Safe cast since the tree was checked to fit in uint32 range. */
+            snapshot_tree_capture(buf, tree, (uint32_t)tree_offset) !=
+                SWICC_RET_SUCCESS)
+        {
+            /* The dirty state is kept so nothing will be lost. */
+            return SWICC_RET_ERROR;
+        }
+        /* The index was checked to have an entry for every tree. */
+        uint32_t const index_tree_offset =
+            snapshot->index_tree_offset +
+            (tree_idx * (uint32_t)sizeof(swicc_disk_index_tree_raw_st));
+        if (buf->extent_count != extent_count &&
+            snapshot->index_tree_offset != 0U &&
+            snapshot_check_capture(buf, tree, index_tree_offset) !=
+                SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        tree_offset += tree->len;
+        tree_idx += 1U;
+    }
+    if (buf->extent_count == 0U)
+    {
+        /* Nothing was modified so there is no need for a snapshot. */
+        return SWICC_RET_SUCCESS;
+    }
+
+    for (swicc_disk_tree_st *tree = disk->root; tree != NULL;
+         tree = tree->next)
+    {
+        swicc_disk_tree_dirty_clear(tree);
+    }
+    /* Publish the snapshot only after it was captured. */
+    atomic_store_explicit(&snapshot->epoch_captured, captured + 1U,
+                          memory_order_release);
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_snapshot_write(swicc_snapshot_st *const snapshot)
+{
+    if (snapshot == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t const written =
+        atomic_load_explicit(&snapshot->epoch_written, memory_order_relaxed);
+    uint32_t const captured =
+        atomic_load_explicit(&snapshot->epoch_captured, memory_order_acquire);
+    if (written == captured)
+    {
+        return SWICC_RET_SNAPSHOT_EMPTY;
+    }
+
+    swicc_snapshot_buf_st const *const buf =
+        &snapshot->buf[written % SWICC_SNAPSHOT_BUF_COUNT];
+    uint32_t data_offset = 0U;
+    for (uint32_t extent_idx = 0U; extent_idx < buf->extent_count;
+         ++extent_idx)
+    {
+        swicc_snapshot_extent_st const *const extent =
+            &buf->extent[extent_idx];
+        uint32_t extent_written = 0U;
+        while (extent_written < extent->len)
+        {
+            ssize_t const ret_write =
+                pwrite(snapshot->fd, &buf->data[data_offset + extent_written],
+                       extent->len - extent_written,
+                       (off_t)extent->offset + extent_written);
+            if (ret_write <= 0)
+            {
+                /* The snapshot stays captured so writing it can be retried. */
+                return SWICC_RET_ERROR;
+            }
+            /* Safe cast since at most the remaining length gets written. */
+            extent_written += (uint32_t)ret_write;
+        }
+        data_offset += extent->len;
+    }
+    if (fdatasync(snapshot->fd) != 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* Release the buffer only after the snapshot was written out of it. */
+    atomic_store_explicit(&snapshot->epoch_written, written + 1U,
+                          memory_order_release);
+    return SWICC_RET_SUCCESS;
+}
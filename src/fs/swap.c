@@ -0,0 +1,177 @@
+#include <string.h>
+#include <swicc/swicc.h>
+
+/**
+ * @brief Check if the card is in between commands, i.e. no part of the card
+ * state references the disk on behalf of a command.
+ * @param swicc_state
+ * @return True when a disk can be swapped in.
+ */
+static bool swap_idle(swicc_st const *const swicc_state)
+{
+    if (swicc_state->internal.apduh_pending)
+    {
+        return false;
+    }
+    swicc_t1_st const *const t1 = &swicc_state->internal.t1;
+    switch (swicc_state->internal.fsm_state)
+    {
+    case SWICC_FSM_STATE_CMD_WAIT:
+        /* The header of the next command may have been received in part. */
+        return swicc_state->internal.tpdu_hdr_len == 0U;
+    case SWICC_FSM_STATE_CMD_PROCEDURE:
+    case SWICC_FSM_STATE_CMD_DATA:
+        return false;
+    case SWICC_FSM_STATE_BLOCK:
+        /* Neither receiving a (chained) C-APDU nor sending a R-APDU. */
+        return t1->blk_rx_len == 0U && t1->capdu_len == 0U &&
+               t1->exec == false && t1->rapdu_len == 0U;
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief Select again in the mounted disk what a VA had selected in the disk
+ * that was swapped out. Only file IDs, AIDs, and record numbers of the old VA
+ * are used since it points into the old disk.
+ * @param fs The resulting VA is written to the current one.
+ * @param va_old
+ */
+static void swap_va_resolve(swicc_fs_st *const fs,
+                            swicc_va_st const *const va_old)
+{
+    memset(&fs->va, 0U, sizeof(fs->va));
+    /* The MF is the root of the first tree of the disk. */
+    swicc_fs_file_st file_mf;
+    if (fs->disk.root == NULL ||
+        swicc_disk_tree_file_root(fs->disk.root, &file_mf) !=
+            SWICC_RET_SUCCESS ||
+        swicc_va_select_file_id(fs, file_mf.hdr_file.id) != SWICC_RET_SUCCESS)
+    {
+        return;
+    }
+    if (va_old->cur_adf.hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_ADF)
+    {
+        uint8_t aid[SWICC_FS_ADF_AID_LEN];
+        memcpy(aid, va_old->cur_adf.hdr_spec.adf.aid.rid,
+               SWICC_FS_ADF_AID_RID_LEN);
+        memcpy(&aid[SWICC_FS_ADF_AID_RID_LEN],
+               va_old->cur_adf.hdr_spec.adf.aid.pix, SWICC_FS_ADF_AID_PIX_LEN);
+        if (swicc_va_select_adf(fs, aid, SWICC_FS_ADF_AID_PIX_LEN) !=
+            SWICC_RET_SUCCESS)
+        {
+            return;
+        }
+    }
+    if (va_old->cur_df.hdr_item.type != SWICC_FS_ITEM_TYPE_INVALID &&
+        va_old->cur_df.hdr_item.type != SWICC_FS_ITEM_TYPE_FILE_ADF &&
+        swicc_va_select_file_id(fs, va_old->cur_df.hdr_file.id) !=
+            SWICC_RET_SUCCESS)
+    {
+        return;
+    }
+    if (va_old->cur_ef.hdr_item.type != SWICC_FS_ITEM_TYPE_INVALID &&
+        swicc_va_select_file_id(fs, va_old->cur_ef.hdr_file.id) ==
+            SWICC_RET_SUCCESS)
+    {
+        /* Fails for transparent EFs which have no records to select. */
+        swicc_va_select_record_idx(fs, va_old->cur_rcrd.idx);
+    }
+}
+
+swicc_ret_et swicc_fs_disk_swap(swicc_st *const swicc_state,
+                                swicc_disk_st *const disk)
+{
+    if (swicc_state == NULL || disk == NULL || disk->root == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_disk_st *pending = NULL;
+    /* Release so the card sees the disk as it was loaded. */
+    if (!atomic_compare_exchange_strong_explicit(
+            &swicc_state->fs.swap.pending, &pending, disk,
+            memory_order_release, memory_order_relaxed))
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_fs_disk_swap_apply(swicc_st *const swicc_state)
+{
+    if (swicc_state == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_fs_st *const fs = &swicc_state->fs;
+    swicc_disk_st *const disk =
+        atomic_load_explicit(&fs->swap.pending, memory_order_acquire);
+    if (disk == NULL)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    /**
+     * Only one swapped out disk is handed back at a time so any further swap
+     * waits for it to be reclaimed.
+     */
+    if (!swap_idle(swicc_state) ||
+        atomic_load_explicit(&fs->swap.retired, memory_order_acquire) != NULL)
+    {
+        return SWICC_RET_FS_SWAP_PENDING;
+    }
+
+    /**
+     * The VAs keep pointing into the old disk until they are re-resolved but
+     * are only used for their IDs from here on.
+     */
+    swicc_va_st const va_cur = fs->va;
+    swicc_va_st va_lchan[SWICC_VA_LCHAN_COUNT];
+    memcpy(va_lchan, fs->va_lchan, sizeof(va_lchan));
+    va_lchan[fs->lchan_cur] = va_cur;
+
+    swicc_disk_st const disk_old = fs->disk;
+    fs->disk = *disk;
+    *disk = disk_old;
+
+    memset(fs->va_lchan, 0U, sizeof(fs->va_lchan));
+    for (uint8_t lchan = 0U; lchan < SWICC_VA_LCHAN_COUNT; ++lchan)
+    {
+        /* The basic channel is always open. */
+        if (lchan == fs->lchan_cur ||
+            (lchan != 0U && (fs->lchan_open & (1U << lchan)) == 0U))
+        {
+            continue;
+        }
+        swap_va_resolve(fs, &va_lchan[lchan]);
+        fs->va_lchan[lchan] = fs->va;
+    }
+    swap_va_resolve(fs, &va_lchan[fs->lchan_cur]);
+    /**
+     * A chained response may borrow data of the old disk which is handed back
+     * below, so the rest of it can't be retrieved anymore.
+     */
+    swicc_apdu_rc_reset(&swicc_state->apdu_rc);
+
+    atomic_store_explicit(&fs->swap.pending, NULL, memory_order_relaxed);
+    /* Release so the publisher sees the old disk once it gets it back. */
+    atomic_store_explicit(&fs->swap.retired, disk, memory_order_release);
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_fs_disk_swap_reclaim(swicc_st *const swicc_state,
+                                        swicc_disk_st *const disk)
+{
+    if (swicc_state == NULL || disk == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_disk_st *retired = disk;
+    if (!atomic_compare_exchange_strong_explicit(
+            &swicc_state->fs.swap.retired, &retired, NULL,
+            memory_order_acquire, memory_order_relaxed))
+    {
+        return SWICC_RET_FS_SWAP_PENDING;
+    }
+    return SWICC_RET_SUCCESS;
+}
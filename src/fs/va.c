@@ -94,6 +94,8 @@ static swicc_ret_et va_select_file(swicc_fs_st *const fs,
             default:
                 return SWICC_RET_FS_NOT_FOUND;
             }
+            /* Guides relayouts of the tree, the count is only a hint. */
+            swicc_disk_file_access(tree, &file);
         }
     }
     return ret;
@@ -102,6 +104,9 @@ static swicc_ret_et va_select_file(swicc_fs_st *const fs,
 swicc_ret_et swicc_va_reset(swicc_fs_st *const fs)
 {
     memset(&fs->va, 0U, sizeof(fs->va));
+    memset(fs->va_lchan, 0U, sizeof(fs->va_lchan));
+    fs->lchan_open = 0U;
+    fs->lchan_cur = 0U;
     swicc_disk_tree_iter_st tree_iter;
     swicc_ret_et ret = swicc_disk_tree_iter(&fs->disk, &tree_iter);
     if (ret == SWICC_RET_SUCCESS)
@@ -115,139 +120,127 @@ swicc_ret_et swicc_va_reset(swicc_fs_st *const fs)
     return ret;
 }
 
-swicc_ret_et swicc_va_select_adf(swicc_fs_st *const fs,
-                                 uint8_t const *const aid,
-                                 uint32_t const pix_len)
+swicc_ret_et swicc_va_lchan_switch(swicc_fs_st *const fs, uint8_t const lchan)
 {
-    swicc_disk_tree_iter_st tree_iter;
-    swicc_ret_et ret = swicc_disk_tree_iter(&fs->disk, &tree_iter);
-    if (ret == SWICC_RET_SUCCESS)
+    /* The basic channel is always open. */
+    if (lchan >= SWICC_VA_LCHAN_COUNT ||
+        (lchan != 0U && (fs->lchan_open & (1U << lchan)) == 0U))
     {
-        swicc_disk_tree_st *tree;
-        do
-        {
-            ret = swicc_disk_tree_iter_next(&tree_iter, &tree);
-            if (ret == SWICC_RET_SUCCESS)
-            {
-                swicc_fs_file_st file_root;
-                ret = swicc_disk_tree_file_root(tree, &file_root);
-                if (ret == SWICC_RET_SUCCESS)
-                {
-                    if (file_root.hdr_item.type == SWICC_FS_ITEM_TYPE_FILE_ADF)
-                    {
-                        if (memcmp(file_root.hdr_spec.adf.aid.rid, aid,
-                                   SWICC_FS_ADF_AID_RID_LEN) == 0U &&
-                            memcmp(file_root.hdr_spec.adf.aid.pix,
-                                   &aid[SWICC_FS_ADF_AID_RID_LEN],
-                                   pix_len) == 0U)
-                        {
-                            return va_select_file(fs, tree, file_root);
-                        }
-                    }
-                    else
-                    {
-                        ret = SWICC_RET_ERROR;
-                    }
-                }
-            }
-        } while (ret == SWICC_RET_SUCCESS);
+        return SWICC_RET_FS_NOT_FOUND;
     }
-    return ret;
+    if (lchan != fs->lchan_cur)
+    {
+        fs->va_lchan[fs->lchan_cur] = fs->va;
+        fs->va = fs->va_lchan[lchan];
+        fs->lchan_cur = lchan;
+    }
+    return SWICC_RET_SUCCESS;
 }
 
-typedef struct va_select_file_dfname_userdata_s
+swicc_ret_et swicc_va_lchan_open(swicc_fs_st *const fs, uint8_t *const lchan)
 {
-    uint8_t const name[SWICC_FS_NAME_LEN];
-    uint32_t const name_len;
-    bool found;
-    swicc_fs_file_st file_found;
-} va_select_file_dfname_userdata_st;
-static swicc_disk_file_foreach_cb va_select_file_dfname_cb;
-static swicc_ret_et va_select_file_dfname_cb(swicc_disk_tree_st *const tree,
-                                             swicc_fs_file_st *const file,
-                                             void *const userdata)
-{
-    va_select_file_dfname_userdata_st *const ud = userdata;
-    uint8_t const *name = NULL;
-    switch (file->hdr_item.type)
+    if (*lchan == 0U)
     {
-    case SWICC_FS_ITEM_TYPE_FILE_MF:
-        name = file->hdr_spec.mf.name;
-        break;
-    case SWICC_FS_ITEM_TYPE_FILE_DF:
-        name = file->hdr_spec.df.name;
-        break;
-    default:
-        break;
+        uint8_t lchan_free = 1U;
+        while (lchan_free < SWICC_VA_LCHAN_COUNT &&
+               (fs->lchan_open & (1U << lchan_free)) != 0U)
+        {
+            lchan_free += 1U;
+        }
+        if (lchan_free >= SWICC_VA_LCHAN_COUNT)
+        {
+            return SWICC_RET_FS_NOT_FOUND;
+        }
+        *lchan = lchan_free;
     }
-    if (name != NULL)
+    else if (*lchan >= SWICC_VA_LCHAN_COUNT ||
+             (fs->lchan_open & (1U << *lchan)) != 0U)
     {
-        if (ud->name_len > SWICC_FS_NAME_LEN)
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    /* ETSI TS 102 221 V16.4.0 clause.11.1.17.2. */
+    swicc_va_st const va_cur = fs->va;
+    if (fs->lchan_cur == 0U)
+    {
+        /* The MF is the root of the first tree of the disk. */
+        memset(&fs->va, 0U, sizeof(fs->va));
+        swicc_fs_file_st file_mf;
+        swicc_ret_et ret = SWICC_RET_ERROR;
+        if (fs->disk.root != NULL &&
+            swicc_disk_tree_file_root(fs->disk.root, &file_mf) ==
+                SWICC_RET_SUCCESS)
         {
-            return SWICC_RET_PARAM_BAD;
+            ret = va_select_file(fs, fs->disk.root, file_mf);
         }
-        if (memcmp(name, ud->name, ud->name_len) == 0)
+        fs->va_lchan[*lchan] = fs->va;
+        fs->va = va_cur;
+        if (ret != SWICC_RET_SUCCESS)
         {
-            ud->found = true;
-            ud->file_found = *file;
-            /* Make the foreach iterator stop early. */
-            return SWICC_RET_ERROR;
+            return ret;
         }
     }
+    else
+    {
+        swicc_va_st *const va_new = &fs->va_lchan[*lchan];
+        *va_new = va_cur;
+        memset(&va_new->cur_ef, 0U, sizeof(va_new->cur_ef));
+        memset(&va_new->cur_rcrd, 0U, sizeof(va_new->cur_rcrd));
+        va_new->cur_file = va_new->cur_df;
+    }
+    fs->lchan_open |= 1U << *lchan;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_va_lchan_close(swicc_fs_st *const fs, uint8_t const lchan)
+{
+    if (lchan == 0U || lchan >= SWICC_VA_LCHAN_COUNT ||
+        (fs->lchan_open & (1U << lchan)) == 0U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    fs->lchan_open &= ~(1U << lchan);
+    memset(&fs->va_lchan[lchan], 0U, sizeof(fs->va_lchan[lchan]));
+    if (lchan == fs->lchan_cur)
+    {
+        fs->va = fs->va_lchan[0U];
+        fs->lchan_cur = 0U;
+    }
     return SWICC_RET_SUCCESS;
 }
 
+swicc_ret_et swicc_va_select_adf(swicc_fs_st *const fs,
+                                 uint8_t const *const aid,
+                                 uint32_t const pix_len)
+{
+    if (pix_len > SWICC_FS_ADF_AID_PIX_LEN)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    swicc_ret_et const ret = swicc_disk_lutname_lookup(
+        &fs->disk, SWICC_DISK_LUTNAME_KIND_AID, aid,
+        SWICC_FS_ADF_AID_RID_LEN + pix_len, &tree, &file);
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        return va_select_file(fs, tree, file);
+    }
+    return ret;
+}
+
 swicc_ret_et swicc_va_select_file_dfname(swicc_fs_st *const fs,
                                          uint8_t const *const df_name,
                                          uint32_t const df_name_len)
 {
-    va_select_file_dfname_userdata_st userdata = {
-        .name = {*df_name},
-        .name_len = df_name_len,
-        .found = false,
-    };
-    swicc_disk_tree_iter_st tree_iter;
-    swicc_ret_et ret = swicc_disk_tree_iter(&fs->disk, &tree_iter);
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    swicc_ret_et const ret =
+        swicc_disk_lutname_lookup(&fs->disk, SWICC_DISK_LUTNAME_KIND_DFNAME,
+                                  df_name, df_name_len, &tree, &file);
     if (ret == SWICC_RET_SUCCESS)
     {
-        swicc_disk_tree_st *tree;
-        do
-        {
-            ret = swicc_disk_tree_iter_next(&tree_iter, &tree);
-            if (ret == SWICC_RET_SUCCESS)
-            {
-                swicc_fs_file_st file_root;
-                ret = swicc_disk_tree_file_root(tree, &file_root);
-                if (ret == SWICC_RET_SUCCESS)
-                {
-                    ret = swicc_disk_file_foreach(tree, &file_root,
-                                                  va_select_file_dfname_cb,
-                                                  &userdata, true);
-                    if (ret == SWICC_RET_SUCCESS)
-                    {
-                        /**
-                         * No DF/MF with the name was found and foreach did not
-                         * fail.
-                         */
-                        ret = SWICC_RET_FS_NOT_FOUND;
-                        continue;
-                    }
-                    else
-                    {
-                        if (userdata.found == true)
-                        {
-                            ret = va_select_file(fs, tree, userdata.file_found);
-                            if (ret == SWICC_RET_SUCCESS)
-                            {
-                                return SWICC_RET_SUCCESS;
-                            }
-                        }
-                        /* Stop looking on any non-successful return. */
-                        return ret;
-                    }
-                }
-            }
-        } while (ret == SWICC_RET_SUCCESS);
+        return va_select_file(fs, tree, file);
     }
     return ret;
 }
@@ -307,6 +300,37 @@ swicc_ret_et swicc_va_select_file_path(swicc_fs_st *const fs,
     swicc_disk_tree_st *tree = NULL;
     va_select_file_path_userdata_st userdata = {0U};
 
+    /**
+     * Terminals select the same few paths over and over so the file a path led
+     * to is remembered. The key is made before the path gets modified below.
+     */
+    swicc_disk_path_cache_entry_st cache_entry = {0U};
+    bool const cacheable =
+        path.len > 0U && path.len <= SWICC_DISK_PATH_CACHE_LEN_MAX;
+    if (cacheable)
+    {
+        /* Safe casts since the enum and the length are both below 256. */
+        cache_entry.type = (uint8_t)path.type;
+        cache_entry.len = (uint8_t)path.len;
+        memcpy(cache_entry.id, path.b, path.len * sizeof(path.b[0U]));
+        if (path.type == SWICC_FS_PATH_TYPE_DF)
+        {
+            cache_entry.start_tree = fs->va.cur_tree;
+            cache_entry.start_offset_trel = fs->va.cur_df.hdr_item.offset_trel;
+        }
+        else if (path.b[0U] == 0x7FFF)
+        {
+            cache_entry.start_tree = fs->va.cur_tree_adf;
+            cache_entry.start_offset_trel = fs->va.cur_adf.hdr_item.offset_trel;
+        }
+        swicc_fs_file_st file_cached;
+        if (swicc_disk_path_cache_lookup(&fs->disk, &cache_entry, &tree,
+                                         &file_cached) == SWICC_RET_SUCCESS)
+        {
+            return va_select_file(fs, tree, file_cached);
+        }
+    }
+
     switch (path.type)
     {
     case SWICC_FS_PATH_TYPE_MF:
@@ -370,6 +394,13 @@ swicc_ret_et swicc_va_select_file_path(swicc_fs_st *const fs,
     if (ret == SWICC_RET_SUCCESS && userdata.found && tree != NULL)
     {
         ret = va_select_file(fs, tree, userdata.file_found);
+        if (ret == SWICC_RET_SUCCESS && cacheable)
+        {
+            cache_entry.tree = tree;
+            cache_entry.offset_trel = userdata.file_found.hdr_item.offset_trel;
+            /* Only a missed shortcut when it fails. */
+            swicc_disk_path_cache_insert(&fs->disk, &cache_entry);
+        }
         return ret;
     }
     return ret;
@@ -385,17 +416,11 @@ swicc_ret_et swicc_va_select_record_idx(swicc_fs_st *const fs,
         if (swicc_disk_file_rcrd_cnt(fs->va.cur_tree, &fs->va.cur_ef,
                                      &rcrd_cnt) == SWICC_RET_SUCCESS)
         {
-            swicc_fs_rcrd_idx_kt idx_abs = idx;
-            /* Cyclic EFs have records indexed relative current record. */
-            if (fs->va.cur_ef.hdr_item.type ==
-                SWICC_FS_ITEM_TYPE_FILE_EF_CYCLIC)
-            {
-                idx_abs =
-                    (swicc_fs_rcrd_idx_kt)((uint32_t)(fs->va.cur_rcrd.idx +
-                                                      idx) %
-                                           rcrd_cnt);
-            }
-            swicc_fs_rcrd_st const rcrd = {.idx = idx_abs};
+            /**
+             * Cyclic EF records are indexed from the most recent one and get
+             * mapped to their slot on access.
+             */
+            swicc_fs_rcrd_st const rcrd = {.idx = idx};
             fs->va.cur_rcrd = rcrd;
             return SWICC_RET_SUCCESS;
         }
@@ -2,6 +2,55 @@
 #include <string.h>
 #include <swicc/swicc.h>
 
+/**
+ * @brief Record the header of the current command in the trace (if enabled).
+ * @param swicc_state
+ */
+static void fsm_trace_apdu_cmd(swicc_st *const swicc_state)
+{
+    if (swicc_state->trace == NULL)
+    {
+        return;
+    }
+    uint8_t const *const hdr = swicc_state->internal.tpdu_hdr;
+    swicc_trace_evt_st evt = {
+        .type = SWICC_TRACE_EVT_TYPE_APDU_CMD,
+        .apdu_cmd =
+            {
+                .cla = hdr[0U],
+                .ins = hdr[1U],
+                .p1 = hdr[2U],
+                .p2 = hdr[3U],
+                .p3 = hdr[4U],
+            },
+    };
+    swicc_trace_push(swicc_state->trace, &evt);
+}
+
+/**
+ * @brief Record a response (or procedure) in the trace (if enabled).
+ * @param swicc_state
+ * @param res
+ */
+static void fsm_trace_apdu_res(swicc_st *const swicc_state,
+                               swicc_apdu_res_st const *const res)
+{
+    if (swicc_state->trace == NULL)
+    {
+        return;
+    }
+    swicc_trace_evt_st evt = {
+        .type = SWICC_TRACE_EVT_TYPE_APDU_RES,
+        .apdu_res =
+            {
+                .sw1 = (uint8_t)res->sw1, /* Safe cast since SW1 is a byte. */
+                .sw2 = res->sw2,
+                .data_len = res->data.len,
+            },
+    };
+    swicc_trace_push(swicc_state->trace, &evt);
+}
+
 static swicc_fsmh_ft fsm_handle_s_off;
 static void fsm_handle_s_off(swicc_st *const swicc_state)
 {
@@ -257,6 +306,13 @@ static void fsm_handle_s_pps_req(swicc_st *const swicc_state)
                               swicc_state->internal.tp.fi,
                               swicc_state->internal.tp.di,
                               swicc_state->internal.tp.fmax);
+                    swicc_state->internal.tp.t = pps_params.t;
+                    if (pps_params.t == 1U)
+                    {
+                        swicc_t1_reset(&swicc_state->internal.t1);
+                        swicc_state->internal.fsm_state =
+                            SWICC_FSM_STATE_BLOCK;
+                    }
                     swicc_state->internal.tpdu_processed = false;
                     swicc_state->buf_rx_len = 0U;
                     return;
@@ -344,6 +400,7 @@ static void fsm_handle_s_cmd_wait(swicc_st *const swicc_state)
                                            &swicc_state->internal.tpdu_cur) ==
                         SWICC_RET_SUCCESS)
                     {
+                        fsm_trace_apdu_cmd(swicc_state);
                         swicc_state->internal.fsm_state =
                             SWICC_FSM_STATE_CMD_PROCEDURE;
                         swicc_state->buf_rx_len =
@@ -383,15 +440,49 @@ static void fsm_handle_s_cmd_wait(swicc_st *const swicc_state)
     return;
 }
 
+/**
+ * @brief Send a NULL procedure byte to keep the terminal waiting while the
+ * handler of the current command is pending. The FSM stays in the procedure
+ * state and is called again without receiving any data.
+ * @param swicc_state
+ */
+static void fsm_pending_keepalive(swicc_st *const swicc_state)
+{
+    if (swicc_state->buf_tx_len >= 1U)
+    {
+        swicc_state->buf_tx[0U] = SWICC_APDU_SW1_PROC_NULL;
+        swicc_state->buf_tx_len = 1U;
+    }
+    swicc_state->buf_rx_len = 0U;
+}
+
 static swicc_fsmh_ft fsm_handle_s_cmd_procedure;
 static void fsm_handle_s_cmd_procedure(swicc_st *const swicc_state)
 {
     if (swicc_state->cont_state_rx == FSM_STATE_CONT_READY)
     {
+        if (swicc_state->internal.apduh_pending &&
+            !atomic_load_explicit(&swicc_state->internal.apduh_pending_done,
+                                  memory_order_acquire))
+        {
+            fsm_pending_keepalive(swicc_state);
+            return;
+        }
+        /* A completion only counts if it comes after calling the handler. */
+        atomic_store_explicit(&swicc_state->internal.apduh_pending_done, false,
+                              memory_order_relaxed);
+
         swicc_apdu_res_st apdu_res;
         swicc_ret_et const apdu_handle_ret =
             swicc_apduh_demux(swicc_state, &swicc_state->internal.apdu_cur,
                               &apdu_res, swicc_state->internal.procedure_count);
+        swicc_state->internal.apduh_pending =
+            apdu_handle_ret == SWICC_RET_APDU_PENDING;
+        if (swicc_state->internal.apduh_pending)
+        {
+            fsm_pending_keepalive(swicc_state);
+            return;
+        }
         if (apdu_handle_ret == SWICC_RET_SUCCESS)
         {
             swicc_ret_et const ret_res = swicc_apdu_res_deparse(
@@ -399,6 +490,7 @@ static void fsm_handle_s_cmd_procedure(swicc_st *const swicc_state)
                 &swicc_state->internal.apdu_cur, &apdu_res);
             if (ret_res == SWICC_RET_SUCCESS)
             {
+                fsm_trace_apdu_res(swicc_state, &apdu_res);
                 if (apdu_res.sw1 == SWICC_APDU_SW1_PROC_ACK_ONE ||
                     apdu_res.sw1 == SWICC_APDU_SW1_PROC_ACK_ALL)
                 {
@@ -446,6 +538,8 @@ static void fsm_handle_s_cmd_procedure(swicc_st *const swicc_state)
         swicc_state->buf_rx_len = 5U; /* Receive a new header. */
         return;
     }
+    /* An operation still pending will never get a response. */
+    swicc_state->internal.apduh_pending = false;
     swicc_state->internal.fsm_state = SWICC_FSM_STATE_OFF;
     swicc_state->buf_tx_len = 0U;
     swicc_state->buf_rx_len = 0U;
@@ -503,6 +597,68 @@ static void fsm_handle_s_cmd_data(swicc_st *const swicc_state)
     return;
 }
 
+static swicc_fsmh_ft fsm_handle_s_block;
+static void fsm_handle_s_block(swicc_st *const swicc_state)
+{
+    if (swicc_state->cont_state_rx == FSM_STATE_CONT_READY)
+    {
+        swicc_t1_st *const t1 = &swicc_state->internal.t1;
+        bool const blk_overflow =
+            t1->blk_rx_len + swicc_state->buf_rx_len > sizeof(t1->blk_rx);
+        if (!blk_overflow)
+        {
+            memcpy(&t1->blk_rx[t1->blk_rx_len], swicc_state->buf_rx,
+                   swicc_state->buf_rx_len);
+            /* Safe cast since it was checked to fit in the block buffer. */
+            t1->blk_rx_len =
+                (uint16_t)(t1->blk_rx_len + swicc_state->buf_rx_len);
+        }
+
+        uint16_t blk_len_exp;
+        if (!blk_overflow)
+        {
+            if (t1->blk_rx_len < SWICC_T1_PROLOGUE_LEN)
+            {
+                /* Get the rest of the prologue to know the block length. */
+                /* Safe cast since the length is less than the prologue. */
+                swicc_state->buf_rx_len =
+                    (uint16_t)(SWICC_T1_PROLOGUE_LEN - t1->blk_rx_len);
+                swicc_state->buf_tx_len = 0U;
+                return;
+            }
+            swicc_t1_blk_len(t1->blk_rx, t1->blk_rx_len, &blk_len_exp);
+            if (t1->blk_rx_len < blk_len_exp)
+            {
+                /* Safe cast since the length is less than the expected. */
+                swicc_state->buf_rx_len =
+                    (uint16_t)(blk_len_exp - t1->blk_rx_len);
+                swicc_state->buf_tx_len = 0U;
+                return;
+            }
+        }
+
+        /**
+         * A block that is too long (or overflows) is still passed on so the
+         * interface gets an R-block indicating the error.
+         */
+        if (swicc_t1_blk(swicc_state, t1->blk_rx, t1->blk_rx_len,
+                         swicc_state->buf_tx,
+                         &swicc_state->buf_tx_len) != SWICC_RET_SUCCESS)
+        {
+            swicc_state->buf_tx_len = 0U;
+        }
+        t1->blk_rx_len = 0U;
+        swicc_state->buf_rx_len = SWICC_T1_PROLOGUE_LEN;
+        return;
+    }
+    /* An operation still pending will never get a response. */
+    swicc_state->internal.apduh_pending = false;
+    swicc_state->internal.fsm_state = SWICC_FSM_STATE_OFF;
+    swicc_state->buf_tx_len = 0U;
+    swicc_state->buf_rx_len = 0U;
+    return;
+}
+
 static swicc_fsmh_ft *const swicc_fsmh[] = {
     [SWICC_FSM_STATE_OFF] = fsm_handle_s_off,
     [SWICC_FSM_STATE_ACTIVATION] = fsm_handle_s_activation,
@@ -514,9 +670,44 @@ static swicc_fsmh_ft *const swicc_fsmh[] = {
     [SWICC_FSM_STATE_CMD_WAIT] = fsm_handle_s_cmd_wait,
     [SWICC_FSM_STATE_CMD_PROCEDURE] = fsm_handle_s_cmd_procedure,
     [SWICC_FSM_STATE_CMD_DATA] = fsm_handle_s_cmd_data,
+    [SWICC_FSM_STATE_BLOCK] = fsm_handle_s_block,
 };
 
 void swicc_fsm(swicc_st *const swicc_state)
 {
-    swicc_fsmh[swicc_state->internal.fsm_state](swicc_state);
+    swicc_fsm_state_et const state_old = swicc_state->internal.fsm_state;
+    /* A PPS response is still sent with the parameters it replaces. */
+    swicc_tp_st const tp_old = swicc_state->internal.tp;
+    uint16_t const rx_len = swicc_state->buf_rx_len;
+    swicc_fsmh[state_old](swicc_state);
+    if (swicc_state->wire != NULL)
+    {
+        /* The first byte of the first header is received in the ATR state. */
+        bool const cmd =
+            state_old == SWICC_FSM_STATE_CMD_WAIT ||
+            state_old == SWICC_FSM_STATE_CMD_PROCEDURE ||
+            state_old == SWICC_FSM_STATE_CMD_DATA ||
+            state_old == SWICC_FSM_STATE_BLOCK ||
+            (state_old == SWICC_FSM_STATE_ATR_RES &&
+             swicc_state->internal.fsm_state == SWICC_FSM_STATE_CMD_WAIT);
+        swicc_wire_xfer(swicc_state->wire, &tp_old, rx_len,
+                        swicc_state->buf_tx_len, cmd);
+    }
+    if (swicc_state->trace != NULL &&
+        swicc_state->internal.fsm_state != state_old)
+    {
+        swicc_trace_evt_st evt = {
+            .type = SWICC_TRACE_EVT_TYPE_FSM,
+            /* Safe casts since there are only a few FSM states. */
+            .fsm.state_old = (uint8_t)state_old,
+            .fsm.state_new = (uint8_t)swicc_state->internal.fsm_state,
+        };
+        swicc_trace_push(swicc_state->trace, &evt);
+    }
+    if (swicc_state->stats != NULL &&
+        swicc_state->internal.fsm_state != state_old)
+    {
+        swicc_stats_add(
+            &swicc_state->stats->fsm[swicc_state->internal.fsm_state], 1U);
+    }
 }
@@ -42,5 +42,7 @@ uint32_t const swicc_io_fmax[SWICC_TP_CONF_NUM] = {
 
 void swicc_io(swicc_st *const swicc_state)
 {
+    /* A disk waiting to be swapped in is taken in between commands. */
+    swicc_fs_disk_swap_apply(swicc_state);
     swicc_fsm(swicc_state);
 }
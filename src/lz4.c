@@ -0,0 +1,283 @@
+#include <string.h>
+#include <swicc/swicc.h>
+
+/* Shortest match that can be encoded. */
+#define LZ4_MATCH_LEN_MIN 4U
+
+/* The last bytes of a block are always literals. */
+#define LZ4_LITERAL_LAST_LEN 5U
+
+/* The last match must start at least this many bytes before the end. */
+#define LZ4_MATCH_START_LIMIT 12U
+
+/* Matches can only refer to this many bytes back. */
+#define LZ4_OFFSET_MAX 65535U
+
+/* Lengths beyond what fits in a nibble of the token are written after it. */
+#define LZ4_TOKEN_LEN_MAX 15U
+
+#define LZ4_HASH_LOG 12U
+
+/**
+ * @brief Hash the 4 bytes at the start of a potential match.
+ * @param buf
+ * @return Index in the hash table.
+ */
+static uint32_t lz4_hash(uint8_t const *const buf)
+{
+    uint32_t seq;
+    memcpy(&seq, buf, sizeof(seq));
+    return (seq * 2654435761U) >> (32U - LZ4_HASH_LOG);
+}
+
+/**
+ * @brief Write the bytes of a length which did not fit in its nibble of the
+ * token.
+ * @param dst
+ * @param dst_size
+ * @param dst_len Length of the block, gets incremented.
+ * @param len What is left of the length after the nibble.
+ * @return Return code.
+ */
+static swicc_ret_et lz4_len_write(uint8_t *const dst, uint32_t const dst_size,
+                                  uint32_t *const dst_len, uint32_t len)
+{
+    while (len >= 255U)
+    {
+        if (*dst_len >= dst_size)
+        {
+            return SWICC_RET_ERROR;
+        }
+        dst[(*dst_len)++] = 255U;
+        len -= 255U;
+    }
+    if (*dst_len >= dst_size)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Safe cast since the length is now smaller than 255. */
+    dst[(*dst_len)++] = (uint8_t)len;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Write a sequence, i.e. literals followed by a match. The last
+ * sequence of a block has no match.
+ * @param dst
+ * @param dst_size
+ * @param dst_len Length of the block, gets incremented.
+ * @param literal
+ * @param literal_len
+ * @param offset How far back the match is, 0 for the last sequence.
+ * @param match_len
+ * @return Return code.
+ */
+static swicc_ret_et lz4_seq_write(uint8_t *const dst, uint32_t const dst_size,
+                                  uint32_t *const dst_len,
+                                  uint8_t const *const literal,
+                                  uint32_t const literal_len,
+                                  uint32_t const offset,
+                                  uint32_t const match_len)
+{
+    uint32_t const match_len_tok =
+        offset == 0U ? 0U : match_len - LZ4_MATCH_LEN_MIN;
+    if (*dst_len >= dst_size)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Safe cast since both nibbles are limited to 15. */
+    dst[(*dst_len)++] = (uint8_t)(((literal_len < LZ4_TOKEN_LEN_MAX
+                                        ? literal_len
+                                        : LZ4_TOKEN_LEN_MAX)
+                                   << 4U) |
+                                  (match_len_tok < LZ4_TOKEN_LEN_MAX
+                                       ? match_len_tok
+                                       : LZ4_TOKEN_LEN_MAX));
+    if (literal_len >= LZ4_TOKEN_LEN_MAX &&
+        lz4_len_write(dst, dst_size, dst_len,
+                      literal_len - LZ4_TOKEN_LEN_MAX) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (literal_len > dst_size - *dst_len)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(&dst[*dst_len], literal, literal_len);
+    *dst_len += literal_len;
+    if (offset == 0U)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    if (dst_size - *dst_len < 2U)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Safe casts since the offset fits in 16 bits (little-endian). */
+    dst[(*dst_len)++] = (uint8_t)(offset & 0xFFU);
+    dst[(*dst_len)++] = (uint8_t)(offset >> 8U);
+    if (match_len_tok >= LZ4_TOKEN_LEN_MAX &&
+        lz4_len_write(dst, dst_size, dst_len,
+                      match_len_tok - LZ4_TOKEN_LEN_MAX) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_lz4_compress(uint8_t const *const src,
+                                uint32_t const src_len, uint8_t *const dst,
+                                uint32_t const dst_size,
+                                uint32_t *const dst_len)
+{
+    if (src == NULL || dst == NULL || dst_len == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    *dst_len = 0U;
+    uint32_t anchor = 0U;
+    if (src_len > LZ4_MATCH_START_LIMIT)
+    {
+        /**
+         * Holds the last position every hash was seen at. Candidates are
+         * compared before being used so stale entries are harmless.
+         */
+        uint32_t table[1U << LZ4_HASH_LOG];
+        memset(table, 0U, sizeof(table));
+        uint32_t const match_start_end = src_len - LZ4_MATCH_START_LIMIT;
+        uint32_t const match_end = src_len - LZ4_LITERAL_LAST_LEN;
+        uint32_t pos = 0U;
+        while (pos <= match_start_end)
+        {
+            uint32_t const hash = lz4_hash(&src[pos]);
+            uint32_t const ref = table[hash];
+            table[hash] = pos;
+            if (ref >= pos || pos - ref > LZ4_OFFSET_MAX ||
+                memcmp(&src[ref], &src[pos], LZ4_MATCH_LEN_MIN) != 0)
+            {
+                pos += 1U;
+                continue;
+            }
+            uint32_t match_len = LZ4_MATCH_LEN_MIN;
+            while (pos + match_len < match_end &&
+                   src[ref + match_len] == src[pos + match_len])
+            {
+                match_len += 1U;
+            }
+            if (lz4_seq_write(dst, dst_size, dst_len, &src[anchor],
+                              pos - anchor, pos - ref,
+                              match_len) != SWICC_RET_SUCCESS)
+            {
+                return SWICC_RET_ERROR;
+            }
+            pos += match_len;
+            anchor = pos;
+        }
+    }
+    return lz4_seq_write(dst, dst_size, dst_len, &src[anchor], src_len - anchor,
+                         0U, 0U);
+}
+
+/**
+ * @brief Read the bytes of a length which did not fit in its nibble of the
+ * token.
+ * @param src
+ * @param src_len
+ * @param src_idx Position in the block, gets incremented.
+ * @param len Gets incremented by the length that was read.
+ * @param len_max Longest the length can be.
+ * @return Return code.
+ */
+static swicc_ret_et lz4_len_read(uint8_t const *const src,
+                                 uint32_t const src_len,
+                                 uint32_t *const src_idx, uint32_t *const len,
+                                 uint32_t const len_max)
+{
+    uint8_t byte;
+    do
+    {
+        if (*src_idx >= src_len)
+        {
+            return SWICC_RET_ERROR;
+        }
+        byte = src[(*src_idx)++];
+        *len += byte;
+        if (*len > len_max)
+        {
+            return SWICC_RET_ERROR;
+        }
+    } while (byte == 255U);
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_lz4_decompress(uint8_t const *const src,
+                                  uint32_t const src_len, uint8_t *const dst,
+                                  uint32_t const dst_len)
+{
+    if (src == NULL || dst == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t src_idx = 0U;
+    uint32_t dst_idx = 0U;
+    while (true)
+    {
+        if (src_idx >= src_len)
+        {
+            return SWICC_RET_ERROR;
+        }
+        uint8_t const token = src[src_idx++];
+
+        uint32_t literal_len = token >> 4U;
+        if (literal_len == LZ4_TOKEN_LEN_MAX &&
+            lz4_len_read(src, src_len, &src_idx, &literal_len,
+                         dst_len - dst_idx) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        if (literal_len > src_len - src_idx || literal_len > dst_len - dst_idx)
+        {
+            return SWICC_RET_ERROR;
+        }
+        memcpy(&dst[dst_idx], &src[src_idx], literal_len);
+        src_idx += literal_len;
+        dst_idx += literal_len;
+        if (src_idx == src_len)
+        {
+            /* The last sequence has no match. */
+            break;
+        }
+
+        if (src_len - src_idx < 2U)
+        {
+            return SWICC_RET_ERROR;
+        }
+        uint32_t const offset =
+            (uint32_t)src[src_idx] | ((uint32_t)src[src_idx + 1U] << 8U);
+        src_idx += 2U;
+        if (offset == 0U || offset > dst_idx)
+        {
+            return SWICC_RET_ERROR;
+        }
+        uint32_t match_len = token & 0x0FU;
+        if (match_len == LZ4_TOKEN_LEN_MAX &&
+            lz4_len_read(src, src_len, &src_idx, &match_len,
+                         dst_len - dst_idx) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        match_len += LZ4_MATCH_LEN_MIN;
+        if (match_len > dst_len - dst_idx)
+        {
+            return SWICC_RET_ERROR;
+        }
+        /* Matches can overlap with what they produce (runs) so copy bytes. */
+        for (uint32_t byte_idx = 0U; byte_idx < match_len; ++byte_idx)
+        {
+            dst[dst_idx + byte_idx] = dst[dst_idx - offset + byte_idx];
+        }
+        dst_idx += match_len;
+    }
+    return dst_idx == dst_len ? SWICC_RET_SUCCESS : SWICC_RET_ERROR;
+}
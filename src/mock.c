@@ -182,3 +182,156 @@ swicc_ret_et swicc_mock_reset_cold(swicc_st *const swicc_state,
         }
     }
 }
+
+/**
+ * @brief Perform a single TPDU exchange with an ICC that is waiting for a
+ * command.
+ * @param swicc_state
+ * @param tpdu The TPDU to send which is 5 header bytes followed by the data.
+ * @param tpdu_len Length of the TPDU.
+ * @param res Where the response (data and status bytes) will be written.
+ * @param res_len Must contain the size of the response buffer. Receives the
+ * length of the response on success.
+ * @return Return code.
+ */
+static swicc_ret_et mock_tpdu(swicc_st *const swicc_state,
+                              uint8_t const *const tpdu,
+                              uint16_t const tpdu_len, uint8_t *const res,
+                              uint16_t *const res_len)
+{
+    uint8_t buf_rx[SWICC_DATA_MAX];
+    uint16_t const res_size = *res_len;
+    uint16_t tpdu_offset = 5U;
+    swicc_fsm_state_et state_fsm;
+
+    /* Start by sending the header. */
+    memcpy(buf_rx, tpdu, 5U);
+    swicc_state->buf_rx = buf_rx;
+    swicc_state->buf_rx_len = 5U;
+    swicc_state->buf_tx = res;
+    for (;;)
+    {
+        swicc_state->buf_tx_len = res_size;
+        swicc_io(swicc_state);
+        swicc_fsm_state(swicc_state, &state_fsm);
+
+        switch (state_fsm)
+        {
+        case SWICC_FSM_STATE_CMD_WAIT:
+            /* The command is done, what was sent back is the response. */
+            if (swicc_state->buf_tx_len < 2U)
+            {
+                return SWICC_RET_ERROR;
+            }
+            *res_len = swicc_state->buf_tx_len;
+            return SWICC_RET_SUCCESS;
+        case SWICC_FSM_STATE_CMD_PROCEDURE:
+            /* Nothing to send before the ICC sends a procedure. */
+            swicc_state->buf_rx_len = 0U;
+            break;
+        case SWICC_FSM_STATE_CMD_DATA:
+            /**
+             * An ACK procedure byte was sent and the ICC requested part of the
+             * data.
+             */
+            if (swicc_state->buf_rx_len > tpdu_len - tpdu_offset)
+            {
+                return SWICC_RET_ERROR;
+            }
+            memcpy(buf_rx, &tpdu[tpdu_offset], swicc_state->buf_rx_len);
+            /* Safe cast since this will not exceed the TPDU length. */
+            tpdu_offset = (uint16_t)(tpdu_offset + swicc_state->buf_rx_len);
+            break;
+        default:
+            /* ICC left the command states so the exchange failed. */
+            return SWICC_RET_ERROR;
+        }
+    }
+}
+
+swicc_ret_et swicc_mock_apdu(swicc_st *const swicc_state,
+                             uint8_t const *const cmd, uint16_t const cmd_len,
+                             uint8_t *const res, uint16_t *const res_len)
+{
+    if (swicc_state == NULL || cmd == NULL || res == NULL || res_len == NULL ||
+        cmd_len < 5U || cmd_len - 5U > SWICC_DATA_MAX)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_fsm_state_et state_fsm;
+    swicc_fsm_state(swicc_state, &state_fsm);
+    if (state_fsm != SWICC_FSM_STATE_CMD_WAIT)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    uint8_t *const buf_rx = swicc_state->buf_rx;
+    uint8_t *const buf_tx = swicc_state->buf_tx;
+
+    uint8_t tpdu[5U + SWICC_DATA_MAX];
+    memcpy(tpdu, cmd, cmd_len);
+    uint16_t tpdu_len = cmd_len;
+    bool tpdu_reissued = false;
+
+    uint16_t const res_size = *res_len;
+    *res_len = 0U;
+
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    for (;;)
+    {
+        /* Safe cast since the response length never exceeds its size. */
+        uint16_t res_tpdu_len = (uint16_t)(res_size - *res_len);
+        ret = mock_tpdu(swicc_state, tpdu, tpdu_len, &res[*res_len],
+                        &res_tpdu_len);
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            break;
+        }
+        uint8_t const sw1 = res[*res_len + res_tpdu_len - 2U];
+        uint8_t const sw2 = res[*res_len + res_tpdu_len - 1U];
+        /* Length of the data that will be retrieved with GET RESPONSE. */
+        uint16_t const len_get = sw2 == 0U ? 256U : sw2;
+
+        if (sw1 == SWICC_APDU_SW1_CHER_LE && tpdu_len == 5U &&
+            tpdu_reissued == false)
+        {
+            /**
+             * Wrong Le field so re-issue the command (case 2) with the
+             * expected length (ISO/IEC 7816-3:2006 clause.12.2.3).
+             */
+            tpdu[4U] = sw2;
+            tpdu_reissued = true;
+            continue;
+        }
+        else if (sw1 == SWICC_APDU_SW1_NORM_BYTES_AVAILABLE &&
+                 res_tpdu_len + len_get <= res_size - *res_len &&
+                 (res_tpdu_len > 2U || tpdu[1U] != 0xC0))
+        {
+            /**
+             * Keep the data but not the status bytes then retrieve the
+             * remaining data with GET RESPONSE (ISO/IEC 7816-3:2006
+             * clause.12.2.3). This stops if a GET RESPONSE returns no data to
+             * avoid looping forever.
+             */
+            /* Safe cast since this was checked to fit in the response. */
+            *res_len = (uint16_t)(*res_len + res_tpdu_len - 2U);
+            tpdu[1U] = 0xC0;
+            tpdu[2U] = 0x00;
+            tpdu[3U] = 0x00;
+            tpdu[4U] = sw2;
+            tpdu_len = 5U;
+            tpdu_reissued = true;
+            continue;
+        }
+
+        /* Safe cast since this is at most the size of the response. */
+        *res_len = (uint16_t)(*res_len + res_tpdu_len);
+        break;
+    }
+
+    /* Restore the buffers which were replaced during the exchange. */
+    swicc_state->buf_rx = buf_rx;
+    swicc_state->buf_tx = buf_tx;
+    return ret;
+}
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <swicc/swicc.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -23,13 +24,20 @@ static void logger_default(char const *const fmt, ...)
     va_end(argptr);
 #endif
 }
-swicc_net_logger_ft *logger = logger_default;
+static _Atomic(swicc_net_logger_ft *) logger_process = logger_default;
+static _Thread_local swicc_net_logger_ft *logger_thread = NULL;
+
+/* The logger of the calling thread if it has one, else of the process. */
+#define logger                                                                 \
+    (logger_thread != NULL ? logger_thread : atomic_load(&logger_process))
 
 /**
  * @brief Send a message to a given socket.
  * @param sock The socket where the message will be sent.
  * @param msg Message to send.
- * @return Number of byte that were sent on success, -1 on failure.
+ * @return Return code.
+ * @note Sends that were interrupted or only partially done are continued until
+ * the whole message is sent.
  */
 static swicc_ret_et msg_send(int32_t const sock,
                              swicc_net_msg_st const *const msg)
@@ -50,27 +58,112 @@ static swicc_ret_et msg_send(int32_t const sock,
     /* Safe cast since the target type can fit the sum of cast ones. */
     uint32_t const size_msg =
         (uint32_t)sizeof(swicc_net_msg_hdr_st) + msg->hdr.size;
-    int64_t const sent_bytes = send(sock, &msg->hdr, size_msg, 0U);
-    if (sent_bytes == size_msg)
+    uint8_t const *const buf = (uint8_t const *)msg;
+    uint32_t size_sent = 0U;
+    while (size_sent < size_msg)
     {
-        /* Success. */
+        int64_t const sent_bytes =
+            send(sock, &buf[size_sent], size_msg - size_sent, MSG_NOSIGNAL);
+        if (sent_bytes < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            logger("Call to send() failed: %s.", strerror(errno));
+            logger("Failed to send all the message bytes.");
+            return SWICC_RET_ERROR;
+        }
+        /* Safe cast since at most 'size_msg' bytes are sent. */
+        size_sent += (uint32_t)sent_bytes;
     }
-    else if (sent_bytes < 0)
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Receive an exact number of bytes from a given socket.
+ * @param sock The socket from which to receive.
+ * @param buf Where to write the received bytes.
+ * @param len How many bytes to receive.
+ * @return Return code.
+ */
+static swicc_ret_et sock_recv_all(int32_t const sock, uint8_t *const buf,
+                                  uint32_t const len)
+{
+    uint32_t len_recvd = 0U;
+    while (len_recvd < len)
     {
-        logger("Call to send() failed: %s.", strerror(errno));
+        int64_t const recvd_bytes =
+            recv(sock, &buf[len_recvd], len - len_recvd, 0);
+        if (recvd_bytes == 0)
+        {
+            logger("Peer closed the connection.");
+            return SWICC_RET_NET_DISCONNECTED;
+        }
+        else if (recvd_bytes < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            logger("Call to recv() failed: %s.", strerror(errno));
+            return SWICC_RET_ERROR;
+        }
+        /* Safe cast since at most 'len' bytes are received. */
+        len_recvd += (uint32_t)recvd_bytes;
     }
-    else
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Check if the size in a message header is valid.
+ * @param hdr
+ * @return True if valid, false otherwise.
+ */
+static bool msg_hdr_valid(swicc_net_msg_hdr_st const *const hdr)
+{
+    if (hdr->size > sizeof(swicc_net_msg_data_st) ||
+        hdr->size < offsetof(swicc_net_msg_data_st, buf))
     {
-        logger("Failed to send message.");
-        return SWICC_RET_ERROR;
+        logger(
+            "Value of the size field in the message header is too large. Got %u, expected %lu >= n <= %lu.",
+            hdr->size, offsetof(swicc_net_msg_data_st, buf),
+            sizeof(swicc_net_msg_data_st));
+        return false;
     }
+    return true;
+}
+
+/**
+ * @brief Create a card message, see 'SWICC_NET_MSG_CTRL_CARD'.
+ * @param msg Where to write the message.
+ * @param card
+ */
+static void msg_card_create(swicc_net_msg_st *const msg, uint32_t const card)
+{
+    msg->hdr.size =
+        (uint32_t)(offsetof(swicc_net_msg_data_st, buf) + sizeof(card));
+    msg->data.cont_state = 0U;
+    msg->data.buf_len_exp = 0U;
+    msg->data.ctrl = SWICC_NET_MSG_CTRL_CARD;
+    memcpy(msg->data.buf, &card, sizeof(card));
+}
 
-    if (sent_bytes != size_msg)
+/**
+ * @brief Get the card out of a card message.
+ * @param msg
+ * @param card Where the card will be written.
+ * @return Return code.
+ */
+static swicc_ret_et msg_card_parse(swicc_net_msg_st const *const msg,
+                                   uint32_t *const card)
+{
+    if (msg->hdr.size != offsetof(swicc_net_msg_data_st, buf) + sizeof(*card))
     {
-        logger("Failed to send all the message bytes.");
+        logger("Card message has an invalid size, got %u.", msg->hdr.size);
         return SWICC_RET_ERROR;
     }
-
+    memcpy(card, msg->data.buf, sizeof(*card));
     return SWICC_RET_SUCCESS;
 }
 
@@ -78,7 +171,7 @@ static swicc_ret_et msg_send(int32_t const sock,
  * @brief Receive a message from a given socket.
  * @param sock The socket from which to receive a message.
  * @param msg Where to write the received message.
- * @return Number of received bytes on success, -1 on failure.
+ * @return Return code.
  */
 static swicc_ret_et msg_recv(int32_t const sock, swicc_net_msg_st *const msg)
 {
@@ -88,61 +181,253 @@ static swicc_ret_et msg_recv(int32_t const sock, swicc_net_msg_st *const msg)
         return SWICC_RET_PARAM_BAD;
     }
 
-    bool recv_failure = false;
-    int64_t recvd_bytes;
-    recvd_bytes = recv(sock, &msg->hdr, sizeof(swicc_net_msg_hdr_st), 0U);
-    if (recvd_bytes < 0)
-    {
-        logger("Call to recv() failed: %s.", strerror(errno));
-        return SWICC_RET_ERROR;
-    }
-    do
+    swicc_ret_et ret =
+        sock_recv_all(sock, (uint8_t *)&msg->hdr, sizeof(msg->hdr));
+    if (ret == SWICC_RET_SUCCESS)
     {
-        /* Check if succeeded. */
-        if (recvd_bytes == sizeof(swicc_net_msg_hdr_st))
+        if (msg_hdr_valid(&msg->hdr))
         {
-            /**
-             * Check if the indicated size is too large for the static
-             * message data buffer.
-             */
-            if (msg->hdr.size > sizeof(msg->data) ||
-                msg->hdr.size < offsetof(swicc_net_msg_data_st, buf))
-            {
-                logger(
-                    "Value of the size field in the message header is too large. Got %u, expected %lu >= n <= %lu.",
-                    msg->hdr.size, offsetof(swicc_net_msg_data_st, buf),
-                    sizeof(msg->data));
-                recv_failure = true;
-                break;
-            }
-            recvd_bytes = recv(sock, &msg->data, msg->hdr.size, 0);
-            /**
-             * Make sure we received the whole message also the cast here is
-             * safe.
-             */
-            if (recvd_bytes != (int64_t)msg->hdr.size)
+            ret = sock_recv_all(sock, (uint8_t *)&msg->data, msg->hdr.size);
+            if (ret == SWICC_RET_SUCCESS)
             {
-                logger("Failed to receive the whole message.");
-                recv_failure = true;
-                break;
+                return SWICC_RET_SUCCESS;
             }
+            logger("Failed to receive the whole message.");
         }
         else
         {
-            logger(
-                "Failed to receive message header: recvd_bytes=%u header_len=%u.",
-                recvd_bytes, sizeof(swicc_net_msg_hdr_st));
-            recv_failure = true;
-            break;
+            ret = SWICC_RET_ERROR;
+        }
+    }
+    else
+    {
+        logger("Failed to receive message header.");
+    }
+    return ret;
+}
+
+/**
+ * @brief Receive as much data as is available on a socket (and fits) into the
+ * buffer of a connection.
+ * @param sock The socket from which to receive.
+ * @param conn The connection which receives the data.
+ * @param flags Flags passed to recv() e.g. MSG_DONTWAIT to not block.
+ * @return Return code. When not blocking, and there is no data available, the
+ * message incomplete code is returned.
+ */
+static swicc_ret_et conn_fill(int32_t const sock, swicc_net_conn_st *const conn,
+                              int32_t const flags)
+{
+    /* Move what is left of a message to the front to make space. */
+    if (conn->offset > 0U)
+    {
+        memmove(conn->buf, &conn->buf[conn->offset],
+                conn->len - conn->offset);
+        conn->len -= conn->offset;
+        conn->offset = 0U;
+    }
+
+    for (;;)
+    {
+        int64_t const recvd_bytes =
+            recv(sock, &conn->buf[conn->len], sizeof(conn->buf) - conn->len,
+                 flags);
+        if (recvd_bytes > 0)
+        {
+            /* Safe cast since at most the free space is received. */
+            conn->len += (uint32_t)recvd_bytes;
+            return SWICC_RET_SUCCESS;
+        }
+        else if (recvd_bytes == 0)
+        {
+            logger("Peer closed the connection.");
+            return SWICC_RET_NET_DISCONNECTED;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return SWICC_RET_NET_MSG_INCOMPLETE;
         }
-    } while (0U);
-    if (recv_failure)
+        logger("Call to recv() failed: %s.", strerror(errno));
+        return SWICC_RET_ERROR;
+    }
+}
+
+/**
+ * @brief Extract the next complete message from the buffer of a connection.
+ * @param conn
+ * @param msg Where to write the message.
+ * @return Return code. If there is no complete message in the buffer, the
+ * message incomplete code is returned. On error, the stream can no longer be
+ * framed and the connection has to be dropped.
+ */
+static swicc_ret_et conn_msg_next(swicc_net_conn_st *const conn,
+                                  swicc_net_msg_st *const msg)
+{
+    uint32_t const len_avail = conn->len - conn->offset;
+    if (len_avail < sizeof(msg->hdr))
+    {
+        return SWICC_RET_NET_MSG_INCOMPLETE;
+    }
+    memcpy(&msg->hdr, &conn->buf[conn->offset], sizeof(msg->hdr));
+    if (!msg_hdr_valid(&msg->hdr))
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (len_avail < sizeof(msg->hdr) + msg->hdr.size)
+    {
+        return SWICC_RET_NET_MSG_INCOMPLETE;
+    }
+    memcpy(&msg->data, &conn->buf[conn->offset + sizeof(msg->hdr)],
+           msg->hdr.size);
+    /* Safe cast since the message is smaller than the buffer. */
+    conn->offset += (uint32_t)sizeof(msg->hdr) + msg->hdr.size;
+    if (conn->offset == conn->len)
+    {
+        conn->offset = 0U;
+        conn->len = 0U;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Check if the buffer of a connection holds a complete message, without
+ * extracting it.
+ * @param conn
+ * @return Return code. Same as for 'conn_msg_next'.
+ */
+static swicc_ret_et conn_msg_peek(swicc_net_conn_st const *const conn)
+{
+    swicc_net_msg_hdr_st hdr;
+    uint32_t const len_avail = conn->len - conn->offset;
+    if (len_avail < sizeof(hdr))
+    {
+        return SWICC_RET_NET_MSG_INCOMPLETE;
+    }
+    memcpy(&hdr, &conn->buf[conn->offset], sizeof(hdr));
+    if (!msg_hdr_valid(&hdr))
     {
         return SWICC_RET_ERROR;
     }
+    return len_avail < sizeof(hdr) + hdr.size ? SWICC_RET_NET_MSG_INCOMPLETE
+                                              : SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Receive a message on a blocking socket through the buffer of a
+ * connection.
+ * @param sock
+ * @param conn
+ * @param msg Where to write the received message.
+ * @return Return code.
+ */
+static swicc_ret_et conn_msg_recv(int32_t const sock,
+                                  swicc_net_conn_st *const conn,
+                                  swicc_net_msg_st *const msg)
+{
+    for (;;)
+    {
+        swicc_ret_et const ret_next = conn_msg_next(conn, msg);
+        if (ret_next != SWICC_RET_NET_MSG_INCOMPLETE)
+        {
+            return ret_next;
+        }
+        swicc_ret_et const ret_fill = conn_fill(sock, conn, 0);
+        if (ret_fill != SWICC_RET_SUCCESS)
+        {
+            return ret_fill;
+        }
+    }
+}
+
+/**
+ * @brief Send as much of the queued data as the socket accepts without
+ * blocking.
+ * @param sock
+ * @param conn Queued data starts at the offset.
+ * @return Return code.
+ */
+static swicc_ret_et conn_flush(int32_t const sock,
+                               swicc_net_conn_st *const conn)
+{
+    while (conn->offset < conn->len)
+    {
+        int64_t const sent_bytes =
+            send(sock, &conn->buf[conn->offset], conn->len - conn->offset,
+                 MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent_bytes < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return SWICC_RET_SUCCESS;
+            }
+            logger("Call to send() failed: %s.", strerror(errno));
+            return SWICC_RET_ERROR;
+        }
+        /* Safe cast since at most the queued bytes are sent. */
+        conn->offset += (uint32_t)sent_bytes;
+    }
+    conn->offset = 0U;
+    conn->len = 0U;
     return SWICC_RET_SUCCESS;
 }
 
+/**
+ * @brief Check if one more message of any size can be queued.
+ * @param conn
+ * @return true if there is space, false otherwise.
+ */
+static bool conn_msg_fits(swicc_net_conn_st *const conn)
+{
+    /* Move what is still queued to the front to make space. */
+    if (conn->offset > 0U)
+    {
+        memmove(conn->buf, &conn->buf[conn->offset],
+                conn->len - conn->offset);
+        conn->len -= conn->offset;
+        conn->offset = 0U;
+    }
+    return sizeof(conn->buf) - conn->len >= sizeof(swicc_net_msg_st);
+}
+
+/**
+ * @brief Queue a message to be sent. There must be enough space for it, see
+ * 'conn_msg_fits'.
+ * @param conn
+ * @param msg
+ */
+static void conn_msg_queue(swicc_net_conn_st *const conn,
+                           swicc_net_msg_st const *const msg)
+{
+    /* Safe cast since the size was validated when creating the message. */
+    uint32_t const size_msg = (uint32_t)sizeof(msg->hdr) + msg->hdr.size;
+    memcpy(&conn->buf[conn->len], msg, size_msg);
+    conn->len += size_msg;
+}
+
+/**
+ * @brief Disable Nagle's algorithm on a socket since messages are small and
+ * latency sensitive.
+ * @param sock
+ */
+static void sock_nodelay(int32_t const sock)
+{
+    int32_t const tcp_nodelay_yes = 1;
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &tcp_nodelay_yes,
+                   sizeof(tcp_nodelay_yes)) != 0)
+    {
+        logger("Failed to disable Nagle's algorithm for socket: %s.",
+               strerror(errno));
+    }
+}
+
 static void swicc_net_sock_close(int32_t const sock)
 {
     if (sock < 0)
@@ -172,9 +457,221 @@ static void swicc_net_sock_close(int32_t const sock)
     logger("Failed to close socket.");
 }
 
+/**
+ * @brief Log a message using the network logger.
+ * @param log_lvl Log level of the card that sent or received the message.
+ * @param prestr String to prepend to the message, e.g. "RX:\n" or "TX:\n".
+ * @param msg The message to log.
+ */
+static void client_msg_log(swicc_net_log_lvl_et const log_lvl,
+                           char const *const prestr,
+                           swicc_net_msg_st const *const msg)
+{
+    /* For debugging. */
+    static _Thread_local char dbg_buf[2048U];
+    uint16_t dbg_buf_len;
+
+    if (log_lvl < SWICC_NET_LOG_LVL_TRACE ||
+        (log_lvl < SWICC_NET_LOG_LVL_TRACE_KEEPALIVE &&
+         msg->data.ctrl == SWICC_NET_MSG_CTRL_KEEPALIVE))
+    {
+        return;
+    }
+
+    dbg_buf_len = sizeof(dbg_buf);
+    if (swicc_dbg_net_msg_str(dbg_buf, &dbg_buf_len, prestr, msg) ==
+        SWICC_RET_SUCCESS)
+    {
+        logger("%.*s", dbg_buf_len, dbg_buf);
+    }
+}
+
+/**
+ * @brief Parse the data of a received message as a TPDU and log it using the
+ * network logger.
+ * @param msg The received message.
+ */
+static void client_tpdu_log(swicc_net_msg_st const *const msg)
+{
+    /* For debugging. */
+    static _Thread_local char dbg_buf[2048U];
+    uint16_t dbg_buf_len;
+
+    static_assert(
+        offsetof(swicc_net_msg_data_st, buf) < UINT16_MAX,
+        "Unsafe cast since offset is larger than what uint16 can hold.");
+    swicc_tpdu_cmd_st tpdu_debug;
+    if (swicc_tpdu_cmd_parse(
+            msg->data.buf,
+            (uint16_t)(msg->hdr.size - offsetof(swicc_net_msg_data_st, buf)),
+            &tpdu_debug) == SWICC_RET_SUCCESS)
+    {
+        dbg_buf_len = sizeof(dbg_buf);
+        if (swicc_dbg_tpdu_cmd_str(dbg_buf, &dbg_buf_len, &tpdu_debug) ==
+            SWICC_RET_SUCCESS)
+        {
+            logger("%.*s", dbg_buf_len, dbg_buf);
+        }
+        else
+        {
+            logger("Failed to create debug string of TPDU.");
+        }
+    }
+    else
+    {
+        logger("Failed to parse data as a TPDU.");
+    }
+}
+
+/**
+ * @brief Process one complete message that was received by a client and
+ * prepare the response to it.
+ * @param swicc_state The swICC state of the card which received the message.
+ * @param log_lvl Log level of the card.
+ * @param msg_rx The received message.
+ * @param msg_tx Where the response to send back will be written.
+ * @return Return code. On success, the response has to be sent back.
+ */
+static swicc_ret_et client_msg_handle(swicc_st *const swicc_state,
+                                      swicc_net_log_lvl_et const log_lvl,
+                                      swicc_net_msg_st *const msg_rx,
+                                      swicc_net_msg_st *const msg_tx)
+{
+    client_msg_log(log_lvl, "RX:\n", msg_rx);
+    if (swicc_state->stats != NULL)
+    {
+        swicc_stats_add(&swicc_state->stats->net_rx_msg, 1U);
+        swicc_stats_add(&swicc_state->stats->net_rx_byte,
+                        sizeof(msg_rx->hdr) + msg_rx->hdr.size);
+    }
+
+    static_assert(
+        offsetof(swicc_net_msg_data_st, buf) < UINT8_MAX,
+        "Data buffer is offset further than 255 bytes into message data which leads to an unsafe cast.");
+    /**
+     * Safe cast since buf is not offset further than 255 bytes (as
+     * asserted).
+     */
+    uint32_t const buf_rx_len =
+        msg_rx->hdr.size - (uint8_t)offsetof(swicc_net_msg_data_st, buf);
+    if (buf_rx_len > UINT16_MAX)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    /* Perform control operations first. */
+    if (msg_rx->data.ctrl != 0U)
+    {
+        /**
+         * Control operations may send back data and have to indicate success
+         * or failure hence these values are set to defaults before performing
+         * the requested operation.
+         */
+        msg_tx->data.ctrl = SWICC_NET_MSG_CTRL_FAILURE;
+        msg_tx->hdr.size = offsetof(swicc_net_msg_data_st, buf);
+
+        switch (msg_rx->data.ctrl)
+        {
+        case SWICC_NET_MSG_CTRL_KEEPALIVE:
+            msg_tx->data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
+            break;
+        case SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_Y:
+        case SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_N:
+            /**
+             * A warm reset is not a cold reset but functionally they are the
+             * same.
+             */
+        case SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_Y:
+        case SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_N:
+            if (swicc_mock_reset_cold(
+                    swicc_state,
+                    msg_rx->data.ctrl ==
+                            SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_Y ||
+                        msg_rx->data.ctrl ==
+                            SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_Y) ==
+                SWICC_RET_SUCCESS)
+            {
+                static_assert(
+                    sizeof(swicc_atr) <= sizeof(msg_tx->data.buf),
+                    "Card ATR does not fit in the message data buffer.");
+                memcpy(msg_tx->data.buf, swicc_atr, sizeof(swicc_atr));
+                msg_tx->hdr.size =
+                    offsetof(swicc_net_msg_data_st, buf) + sizeof(swicc_atr);
+                msg_tx->data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
+            }
+            break;
+        case SWICC_NET_MSG_CTRL_APDU: {
+            uint16_t res_len = sizeof(msg_tx->data.buf);
+            /* Safe cast due to the bound check on the data length. */
+            if (swicc_mock_apdu(swicc_state, msg_rx->data.buf,
+                                (uint16_t)buf_rx_len, msg_tx->data.buf,
+                                &res_len) == SWICC_RET_SUCCESS)
+            {
+                msg_tx->hdr.size =
+                    (uint32_t)(offsetof(swicc_net_msg_data_st, buf) + res_len);
+                msg_tx->data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
+            }
+            break;
+        }
+        }
+
+        /**
+         * These data members shall not be modified by the control operations
+         * because they represent the state of the ICC after the request.
+         */
+        msg_tx->data.cont_state = swicc_state->cont_state_tx;
+        msg_tx->data.buf_len_exp = swicc_state->buf_rx_len;
+    }
+    else
+    {
+        /* Handle data. */
+        swicc_state->buf_rx = msg_rx->data.buf;
+        swicc_state->buf_rx_len =
+            (uint16_t)buf_rx_len; /* Safe cast due to bound check. */
+        swicc_state->buf_tx = msg_tx->data.buf;
+        swicc_state->buf_tx_len = sizeof(msg_tx->data.buf);
+        if (log_lvl >= SWICC_NET_LOG_LVL_TRACE_TPDU)
+        {
+            client_tpdu_log(msg_rx);
+        }
+        swicc_io(swicc_state);
+
+        /* Prepare response. */
+        if (sizeof(msg_tx->data.cont_state) + swicc_state->buf_tx_len >
+            UINT32_MAX)
+        {
+            return SWICC_RET_ERROR;
+        }
+        /**
+         * The response data was written by swICC directly into the message
+         * buffer so only the rest of the message needs to be filled in.
+         */
+        /* Safe cast because it was checked. */
+        msg_tx->hdr.size = (uint32_t)(offsetof(swicc_net_msg_data_st, buf) +
+                                      swicc_state->buf_tx_len);
+        msg_tx->data.cont_state = swicc_state->cont_state_tx;
+        msg_tx->data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
+        msg_tx->data.buf_len_exp = swicc_state->buf_rx_len;
+    }
+
+    client_msg_log(log_lvl, "TX:\n", msg_tx);
+    if (swicc_state->stats != NULL)
+    {
+        swicc_stats_add(&swicc_state->stats->net_tx_msg, 1U);
+        swicc_stats_add(&swicc_state->stats->net_tx_byte,
+                        sizeof(msg_tx->hdr) + msg_tx->hdr.size);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
 void swicc_net_logger_register(swicc_net_logger_ft *const logger_func)
 {
-    logger = logger_func;
+    atomic_store(&logger_process, logger_func);
+}
+
+void swicc_net_logger_register_thread(swicc_net_logger_ft *const logger_func)
+{
+    logger_thread = logger_func;
 }
 
 swicc_ret_et swicc_net_client_sig_register(void (*const sigh_exit)(int))
@@ -267,38 +764,417 @@ void swicc_net_client_sig_default()
     assert(signal(SIGTERM, SIG_DFL) != SIG_ERR);
 }
 
-swicc_ret_et swicc_net_server_create(swicc_net_server_st *const server_ctx,
-                                     char const *const port_str)
+/**
+ * @brief Put the keep-alive timer of a connection into the bucket of the wheel
+ * where it fires (or gets cascaded down from) at a given tick.
+ * @param server_ctx
+ * @param slot Slot holding the timer of the connection.
+ * @param expiry Tick at which to fire, not before the current tick.
+ */
+static void keepalive_link(swicc_net_server_st *const server_ctx,
+                           uint32_t const slot, uint64_t expiry)
 {
-    uint16_t const port = (uint16_t)strtol(port_str, NULL, 10U);
-    if (port == 0U)
+    swicc_net_keepalive_st *const ka = &server_ctx->keepalive;
+    uint64_t const delta_max = (1ULL << (SWICC_NET_KEEPALIVE_LEVEL_BITS *
+                                         SWICC_NET_KEEPALIVE_LEVEL_COUNT)) -
+                               1U;
+    if (expiry - ka->tick > delta_max)
     {
-        logger("Bad port was given.");
-        return SWICC_RET_PARAM_BAD;
+        expiry = ka->tick + delta_max;
+    }
+    uint32_t level = 0U;
+    while (level < SWICC_NET_KEEPALIVE_LEVEL_COUNT - 1U &&
+           expiry - ka->tick >=
+               1ULL << (SWICC_NET_KEEPALIVE_LEVEL_BITS * (level + 1U)))
+    {
+        level += 1U;
     }
+    /* Safe cast since the mask keeps only the bits of one bucket index. */
+    uint32_t const bucket =
+        (uint32_t)(expiry >> (SWICC_NET_KEEPALIVE_LEVEL_BITS * level)) &
+        (SWICC_NET_KEEPALIVE_LEVEL_SIZE - 1U);
 
-    int32_t const sock = socket(AF_INET, SOCK_STREAM, 0U);
-    if (sock != -1)
+    swicc_net_server_slot_st *const entry = &server_ctx->slot[slot];
+    entry->ka_expiry = expiry;
+    /* Safe cast since there are far fewer buckets than 2^16. */
+    entry->ka_bucket =
+        (uint16_t)((level * SWICC_NET_KEEPALIVE_LEVEL_SIZE) + bucket);
+    entry->ka_prev = SWICC_NET_KEEPALIVE_NONE;
+    entry->ka_next = ka->bucket[level][bucket];
+    if (entry->ka_next != SWICC_NET_KEEPALIVE_NONE)
     {
-        struct sockaddr_in const sock_addr = {
-            .sin_zero = {0U},
-            .sin_family = AF_INET,
-            .sin_addr.s_addr = INADDR_ANY,
-            .sin_port = htobe16(port),
-        };
-        if (bind(sock, (struct sockaddr *)&sock_addr, sizeof(sock_addr)) != -1)
-        {
-            if (listen(sock, SWICC_NET_CLIENT_COUNT_MAX) != -1)
-            {
-                if (fcntl(sock, F_SETFL, O_NONBLOCK) == 0U)
-                {
-                    logger("Listening on port %u.", port);
-                    server_ctx->sock_server = sock;
-                    return SWICC_RET_SUCCESS;
-                }
-                else
-                {
-                    logger(
+        server_ctx->slot[entry->ka_next].ka_prev = slot;
+    }
+    ka->bucket[level][bucket] = slot;
+    entry->ka_armed = true;
+    ka->armed_count += 1U;
+}
+
+/**
+ * @brief Take the keep-alive timer of a connection out of the wheel.
+ * @param server_ctx
+ * @param slot Slot holding the timer of the connection.
+ */
+static void keepalive_unlink(swicc_net_server_st *const server_ctx,
+                             uint32_t const slot)
+{
+    swicc_net_keepalive_st *const ka = &server_ctx->keepalive;
+    swicc_net_server_slot_st *const entry = &server_ctx->slot[slot];
+    if (!entry->ka_armed)
+    {
+        return;
+    }
+    if (entry->ka_prev != SWICC_NET_KEEPALIVE_NONE)
+    {
+        server_ctx->slot[entry->ka_prev].ka_next = entry->ka_next;
+    }
+    else
+    {
+        ka->bucket[entry->ka_bucket / SWICC_NET_KEEPALIVE_LEVEL_SIZE]
+                  [entry->ka_bucket % SWICC_NET_KEEPALIVE_LEVEL_SIZE] =
+            entry->ka_next;
+    }
+    if (entry->ka_next != SWICC_NET_KEEPALIVE_NONE)
+    {
+        server_ctx->slot[entry->ka_next].ka_prev = entry->ka_prev;
+    }
+    entry->ka_armed = false;
+    ka->armed_count -= 1U;
+}
+
+/**
+ * @brief Get the idle time of a server in ticks of the wheel.
+ * @param server_ctx
+ * @return At least 1 tick.
+ */
+static uint64_t keepalive_idle_tick(swicc_net_server_st const *const server_ctx)
+{
+    uint64_t const idle_tick =
+        (server_ctx->keepalive.idle + SWICC_NET_KEEPALIVE_TICK - 1U) /
+        SWICC_NET_KEEPALIVE_TICK;
+    return idle_tick > 0U ? idle_tick : 1U;
+}
+
+/**
+ * @brief Fire the timers of the current tick of the wheel. The ones that saw
+ * no traffic since they were armed are written out to be probed. All of them
+ * are armed again.
+ * @param server_ctx
+ * @param slot Where the slots to probe will be written.
+ * @param slot_size
+ * @param slot_count Number of slots written so far, gets incremented.
+ * @return False if the buffer got full before all timers were fired.
+ */
+static bool keepalive_fire(swicc_net_server_st *const server_ctx,
+                           uint16_t *const slot, uint32_t const slot_size,
+                           uint32_t *const slot_count)
+{
+    swicc_net_keepalive_st *const ka = &server_ctx->keepalive;
+    /* Safe cast since the mask keeps only the bits of one bucket index. */
+    uint32_t const bucket =
+        (uint32_t)ka->tick & (SWICC_NET_KEEPALIVE_LEVEL_SIZE - 1U);
+    while (ka->bucket[0U][bucket] != SWICC_NET_KEEPALIVE_NONE)
+    {
+        uint32_t const slot_idx = ka->bucket[0U][bucket];
+        swicc_net_server_slot_st *const entry = &server_ctx->slot[slot_idx];
+        if (!entry->ka_active && *slot_count >= slot_size)
+        {
+            ka->tick_pending = true;
+            return false;
+        }
+        keepalive_unlink(server_ctx, slot_idx);
+        if (entry->ka_active)
+        {
+            entry->ka_active = false;
+        }
+        else
+        {
+            /* Safe cast since the slot table never exceeds 2^16 slots. */
+            slot[(*slot_count)++] = (uint16_t)slot_idx;
+        }
+        keepalive_link(server_ctx, slot_idx,
+                       ka->tick + keepalive_idle_tick(server_ctx));
+    }
+    ka->tick_pending = false;
+    return true;
+}
+
+/**
+ * @brief Move all timers of a bucket to the lower levels of the wheel, now
+ * that the current tick reached the range of the bucket.
+ * @param server_ctx
+ * @param level
+ * @param bucket
+ */
+static void keepalive_cascade(swicc_net_server_st *const server_ctx,
+                              uint32_t const level, uint32_t const bucket)
+{
+    swicc_net_keepalive_st *const ka = &server_ctx->keepalive;
+    uint32_t slot_idx = ka->bucket[level][bucket];
+    ka->bucket[level][bucket] = SWICC_NET_KEEPALIVE_NONE;
+    while (slot_idx != SWICC_NET_KEEPALIVE_NONE)
+    {
+        swicc_net_server_slot_st *const entry = &server_ctx->slot[slot_idx];
+        uint32_t const slot_next = entry->ka_next;
+        entry->ka_armed = false;
+        ka->armed_count -= 1U;
+        keepalive_link(server_ctx, slot_idx, entry->ka_expiry);
+        slot_idx = slot_next;
+    }
+}
+
+/**
+ * @brief Make sure a slot is present in the slot table of a server, growing
+ * the table when it is not. New slots are unused.
+ * @param server_ctx
+ * @param slot
+ * @return Return code.
+ */
+static swicc_ret_et server_slot_reserve(swicc_net_server_st *const server_ctx,
+                                        uint16_t const slot)
+{
+    if (slot < server_ctx->slot_count)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+
+    /* Grow geometrically so that adding many slots stays cheap. */
+    uint32_t slot_count_new =
+        server_ctx->slot_count > 0U ? server_ctx->slot_count * 2U
+                                    : SWICC_NET_CLIENT_COUNT_MAX;
+    if (slot_count_new <= slot)
+    {
+        slot_count_new = slot + 1U;
+    }
+    if (slot_count_new > UINT16_MAX + 1U)
+    {
+        slot_count_new = UINT16_MAX + 1U;
+    }
+    swicc_net_server_slot_st *const slot_new = realloc(
+        server_ctx->slot, slot_count_new * sizeof(swicc_net_server_slot_st));
+    if (slot_new == NULL)
+    {
+        logger("Failed to grow the slot table.");
+        return SWICC_RET_ERROR;
+    }
+    for (uint32_t slot_idx = server_ctx->slot_count; slot_idx < slot_count_new;
+         ++slot_idx)
+    {
+        slot_new[slot_idx] = (swicc_net_server_slot_st){
+            .sock = -1,
+            .card = 0U,
+            .ka_conn = slot_idx,
+            .ka_active = false,
+            .ka_armed = false,
+            .ka_next = SWICC_NET_KEEPALIVE_NONE,
+            .ka_prev = SWICC_NET_KEEPALIVE_NONE,
+        };
+    }
+    server_ctx->slot = slot_new;
+    server_ctx->slot_count = slot_count_new;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Hash the socket and card of a slot for the slot index.
+ * @param sock
+ * @param card
+ * @return Hash, the low bits are used to place the slot in the index.
+ */
+static uint32_t server_slot_hash(int32_t const sock, uint32_t const card)
+{
+    /* Safe cast since sockets in use are never negative. */
+    uint64_t const key = ((uint64_t)(uint32_t)sock << 32U) | card;
+    /**
+     * Fibonacci hashing spreads the small socket and card numbers over all the
+     * bits. Safe cast since only the upper half of the product is kept.
+     */
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32U);
+}
+
+/**
+ * @brief Find where the slot of a card on a connection is in the slot index.
+ * @param server_ctx
+ * @param sock
+ * @param card
+ * @return Position in the index, UINT32_MAX when the card has no slot.
+ */
+static uint32_t server_slot_index_find(
+    swicc_net_server_st const *const server_ctx, int32_t const sock,
+    uint32_t const card)
+{
+    if (server_ctx->slot_index_size == 0U)
+    {
+        return UINT32_MAX;
+    }
+    uint32_t const mask = server_ctx->slot_index_size - 1U;
+    for (uint32_t pos = server_slot_hash(sock, card) & mask;
+         server_ctx->slot_index[pos] != 0U; pos = (pos + 1U) & mask)
+    {
+        swicc_net_server_slot_st const *const entry =
+            &server_ctx->slot[server_ctx->slot_index[pos] - 1U];
+        if (entry->sock == sock && entry->card == card)
+        {
+            return pos;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * @brief Put a slot in the slot index which must have space for it.
+ * @param server_ctx
+ * @param slot
+ */
+static void server_slot_index_put(swicc_net_server_st *const server_ctx,
+                                  uint32_t const slot)
+{
+    uint32_t const mask = server_ctx->slot_index_size - 1U;
+    uint32_t pos = server_slot_hash(server_ctx->slot[slot].sock,
+                                    server_ctx->slot[slot].card) &
+                   mask;
+    while (server_ctx->slot_index[pos] != 0U)
+    {
+        pos = (pos + 1U) & mask;
+    }
+    server_ctx->slot_index[pos] = slot + 1U;
+}
+
+/**
+ * @brief Assign a connection and card to an unused slot and add it to the
+ * slot index, growing the index when it would be more than half full.
+ * @param server_ctx
+ * @param slot
+ * @param sock
+ * @param card
+ * @return Return code.
+ */
+static swicc_ret_et server_slot_use(swicc_net_server_st *const server_ctx,
+                                    uint16_t const slot, int32_t const sock,
+                                    uint32_t const card)
+{
+    if ((server_ctx->slot_index_count + 1U) * 2U >
+        server_ctx->slot_index_size)
+    {
+        uint32_t const size_old = server_ctx->slot_index_size;
+        uint32_t const size_new =
+            size_old > 0U ? size_old * 2U : SWICC_NET_CLIENT_COUNT_MAX * 2U;
+        uint32_t *const index_old = server_ctx->slot_index;
+        uint32_t *const index_new = calloc(size_new, sizeof(*index_new));
+        if (index_new == NULL)
+        {
+            logger("Failed to grow the slot index.");
+            return SWICC_RET_ERROR;
+        }
+        server_ctx->slot_index = index_new;
+        server_ctx->slot_index_size = size_new;
+        for (uint32_t pos = 0U; pos < size_old; ++pos)
+        {
+            if (index_old[pos] != 0U)
+            {
+                server_slot_index_put(server_ctx, index_old[pos] - 1U);
+            }
+        }
+        free(index_old);
+    }
+    server_ctx->slot[slot].sock = sock;
+    server_ctx->slot[slot].card = card;
+    server_slot_index_put(server_ctx, slot);
+    server_ctx->slot_index_count += 1U;
+    if (slot < SWICC_NET_CLIENT_COUNT_MAX)
+    {
+        server_ctx->sock_client[slot] = sock;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Mark a used slot as unused and remove it from the slot index.
+ * @param server_ctx
+ * @param slot
+ */
+static void server_slot_free(swicc_net_server_st *const server_ctx,
+                             uint32_t const slot)
+{
+    uint32_t const mask = server_ctx->slot_index_size - 1U;
+    uint32_t hole = server_slot_index_find(
+        server_ctx, server_ctx->slot[slot].sock, server_ctx->slot[slot].card);
+    if (hole != UINT32_MAX)
+    {
+        /**
+         * Shift back the entries after the removed one that would no longer be
+         * found with a hole in front of them, so no tombstones are needed.
+         */
+        for (uint32_t pos = (hole + 1U) & mask;
+             server_ctx->slot_index[pos] != 0U; pos = (pos + 1U) & mask)
+        {
+            swicc_net_server_slot_st const *const entry =
+                &server_ctx->slot[server_ctx->slot_index[pos] - 1U];
+            uint32_t const home =
+                server_slot_hash(entry->sock, entry->card) & mask;
+            if (((pos - home) & mask) >= ((pos - hole) & mask))
+            {
+                server_ctx->slot_index[hole] = server_ctx->slot_index[pos];
+                hole = pos;
+            }
+        }
+        server_ctx->slot_index[hole] = 0U;
+        server_ctx->slot_index_count -= 1U;
+    }
+    server_ctx->slot[slot].sock = -1;
+    if (slot < SWICC_NET_CLIENT_COUNT_MAX)
+    {
+        server_ctx->sock_client[slot] = -1;
+    }
+}
+
+swicc_ret_et swicc_net_server_create(swicc_net_server_st *const server_ctx,
+                                     char const *const port_str)
+{
+    server_ctx->sock_server = -1;
+    for (uint32_t slot = 0U; slot < SWICC_NET_CLIENT_COUNT_MAX; ++slot)
+    {
+        server_ctx->sock_client[slot] = -1;
+    }
+    server_ctx->slot = NULL;
+    server_ctx->slot_count = 0U;
+    server_ctx->slot_index = NULL;
+    server_ctx->slot_index_size = 0U;
+    server_ctx->slot_index_count = 0U;
+    memset(&server_ctx->keepalive, 0U, sizeof(server_ctx->keepalive));
+    memset(server_ctx->keepalive.bucket, 0xFF,
+           sizeof(server_ctx->keepalive.bucket));
+    server_ctx->keepalive.rearm = true;
+
+    uint16_t const port = (uint16_t)strtol(port_str, NULL, 10U);
+    if (port == 0U)
+    {
+        logger("Bad port was given.");
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    int32_t const sock = socket(AF_INET, SOCK_STREAM, 0U);
+    if (sock != -1)
+    {
+        struct sockaddr_in const sock_addr = {
+            .sin_zero = {0U},
+            .sin_family = AF_INET,
+            .sin_addr.s_addr = INADDR_ANY,
+            .sin_port = htobe16(port),
+        };
+        if (bind(sock, (struct sockaddr *)&sock_addr, sizeof(sock_addr)) != -1)
+        {
+            if (listen(sock, SWICC_NET_CLIENT_COUNT_MAX) != -1)
+            {
+                if (fcntl(sock, F_SETFL, O_NONBLOCK) == 0U)
+                {
+                    logger("Listening on port %u.", port);
+                    server_ctx->sock_server = sock;
+                    return SWICC_RET_SUCCESS;
+                }
+                else
+                {
+                    logger(
                         "Failed to set listening socket to non-blocking: %s.",
                         strerror(errno));
                 }
@@ -327,18 +1203,25 @@ swicc_ret_et swicc_net_server_create(swicc_net_server_st *const server_ctx,
 
 void swicc_net_server_destroy(swicc_net_server_st *const server_ctx)
 {
-    swicc_net_sock_close(server_ctx->sock_server);
-    for (uint32_t client_idx = 0U;
-         client_idx <
-         sizeof(server_ctx->sock_client) / sizeof(server_ctx->sock_client[0U]);
-         ++client_idx)
+    if (server_ctx->sock_server >= 0)
+    {
+        swicc_net_sock_close(server_ctx->sock_server);
+    }
+    for (uint32_t slot = 0U; slot < server_ctx->slot_count; ++slot)
     {
-        if (server_ctx->sock_client[client_idx] >= 0)
+        if (server_ctx->slot[slot].sock >= 0)
         {
-            swicc_net_sock_close(server_ctx->sock_client[client_idx]);
+            /* Safe cast since the slot table never exceeds 2^16 slots. */
+            swicc_net_server_client_disconnect(server_ctx, (uint16_t)slot);
         }
-        server_ctx->sock_client[client_idx] = -1;
     }
+    free(server_ctx->slot);
+    server_ctx->slot = NULL;
+    server_ctx->slot_count = 0U;
+    free(server_ctx->slot_index);
+    server_ctx->slot_index = NULL;
+    server_ctx->slot_index_size = 0U;
+    server_ctx->slot_index_count = 0U;
     server_ctx->sock_server = -1;
 }
 
@@ -373,7 +1256,14 @@ swicc_ret_et swicc_net_client_create(swicc_net_client_st *const client_ctx,
         if (connect(sock, (struct sockaddr *)&server_addr,
                     sizeof(server_addr)) == 0)
         {
+            sock_nodelay(sock);
             client_ctx->sock_client = sock;
+            client_ctx->conn.len = 0U;
+            client_ctx->conn.offset = 0U;
+            client_ctx->conn_tx.len = 0U;
+            client_ctx->conn_tx.offset = 0U;
+            client_ctx->shm.region = NULL;
+            client_ctx->log_lvl = SWICC_NET_LOG_LVL_ERROR;
             return SWICC_RET_SUCCESS;
         }
         else
@@ -388,8 +1278,28 @@ swicc_ret_et swicc_net_client_create(swicc_net_client_st *const client_ctx,
     return SWICC_RET_ERROR;
 }
 
+swicc_ret_et swicc_net_client_create_shm(swicc_net_client_st *const client_ctx,
+                                         char const *const shm_name)
+{
+    swicc_ret_et const ret = swicc_net_shm_open(&client_ctx->shm, shm_name);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        logger("Failed to open shared-memory channel: %s.", strerror(errno));
+        client_ctx->shm.region = NULL;
+        return ret;
+    }
+    client_ctx->sock_client = -1;
+    client_ctx->conn.len = 0U;
+    client_ctx->conn.offset = 0U;
+    client_ctx->conn_tx.len = 0U;
+    client_ctx->conn_tx.offset = 0U;
+    client_ctx->log_lvl = SWICC_NET_LOG_LVL_ERROR;
+    return SWICC_RET_SUCCESS;
+}
+
 void swicc_net_client_destroy(swicc_net_client_st *const client_ctx)
 {
+    swicc_net_shm_destroy(&client_ctx->shm);
     if (client_ctx->sock_client >= 0)
     {
         swicc_net_sock_close(client_ctx->sock_client);
@@ -414,6 +1324,29 @@ swicc_ret_et swicc_net_recv(int32_t const sock, swicc_net_msg_st *const msg)
     return SWICC_RET_ERROR;
 }
 
+swicc_ret_et swicc_net_recv_card(int32_t const sock,
+                                 swicc_net_msg_st *const msg,
+                                 uint32_t *const card)
+{
+    *card = 0U;
+    swicc_ret_et ret = swicc_net_recv(sock, msg);
+    if (ret != SWICC_RET_SUCCESS || msg->data.ctrl != SWICC_NET_MSG_CTRL_CARD)
+    {
+        return ret;
+    }
+    if (msg_card_parse(msg, card) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    ret = swicc_net_recv(sock, msg);
+    if (ret == SWICC_RET_SUCCESS && msg->data.ctrl == SWICC_NET_MSG_CTRL_CARD)
+    {
+        logger("Expected a message after the card message.");
+        return SWICC_RET_ERROR;
+    }
+    return ret;
+}
+
 swicc_ret_et swicc_net_send(int32_t const sock,
                             swicc_net_msg_st const *const msg)
 {
@@ -435,12 +1368,11 @@ swicc_ret_et swicc_net_send(int32_t const sock,
 swicc_ret_et swicc_net_server_client_connect(
     swicc_net_server_st *const server_ctx, uint16_t const slot)
 {
-    if (slot > SWICC_NET_CLIENT_COUNT_MAX)
+    if (server_slot_reserve(server_ctx, slot) != SWICC_RET_SUCCESS)
     {
-        logger("Requested slot is not present.");
-        return SWICC_RET_PARAM_BAD;
+        return SWICC_RET_ERROR;
     }
-    if (server_ctx->sock_client[slot] != -1)
+    if (server_ctx->slot[slot].sock != -1)
     {
         logger("Value of socket must be -1 before accepting.");
         return SWICC_RET_PARAM_BAD;
@@ -475,8 +1407,14 @@ swicc_ret_et swicc_net_server_client_connect(
                 return SWICC_RET_ERROR;
             }
         }
+        sock_nodelay(sock);
+        if (swicc_net_server_client_adopt(server_ctx, slot, sock) !=
+            SWICC_RET_SUCCESS)
+        {
+            swicc_net_sock_close(sock);
+            return SWICC_RET_ERROR;
+        }
         logger("Client connected.");
-        server_ctx->sock_client[slot] = sock;
         return SWICC_RET_SUCCESS;
     }
     else if (errno == EAGAIN || errno == EWOULDBLOCK)
@@ -499,220 +1437,1467 @@ swicc_ret_et swicc_net_server_client_connect(
     }
 }
 
+swicc_ret_et swicc_net_server_client_adopt(
+    swicc_net_server_st *const server_ctx, uint16_t const slot,
+    int32_t const sock)
+{
+    if (sock < 0)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (server_slot_reserve(server_ctx, slot) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Card 0 has a slot for as long as the connection is used. */
+    if (server_ctx->slot[slot].sock != -1 ||
+        server_slot_index_find(server_ctx, sock, 0U) != UINT32_MAX)
+    {
+        logger("Requested slot or socket is already in use.");
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (server_slot_use(server_ctx, slot, sock, 0U) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Connecting counts as traffic so a new card is not probed at once. */
+    server_ctx->slot[slot].ka_conn = slot;
+    server_ctx->slot[slot].ka_active = true;
+    if (server_ctx->keepalive.idle > 0U && !server_ctx->keepalive.rearm)
+    {
+        keepalive_link(server_ctx, slot,
+                       server_ctx->keepalive.tick +
+                           keepalive_idle_tick(server_ctx));
+    }
+    return SWICC_RET_SUCCESS;
+}
+
 void swicc_net_server_client_disconnect(swicc_net_server_st *const server_ctx,
                                         uint16_t const slot)
 {
-    if (slot > SWICC_NET_CLIENT_COUNT_MAX)
+    if (slot >= server_ctx->slot_count)
     {
         logger("Requested slot is not present.");
         return;
     }
-    if (server_ctx->sock_client[slot] < 0)
+    int32_t const sock = server_ctx->slot[slot].sock;
+    if (sock < 0)
     {
-        logger("Invalid socket FD, expected >=0 got %i.",
-               server_ctx->sock_client[slot]);
+        logger("Invalid socket FD, expected >=0 got %i.", sock);
         return;
     }
 
-    swicc_net_sock_close(server_ctx->sock_client[slot]);
+    swicc_net_sock_close(sock);
+    keepalive_unlink(server_ctx, server_ctx->slot[slot].ka_conn);
     /**
      * On failure to close, socket is still set to -1 so it is lost forever
      * because there is no way to recover here.
      */
-    server_ctx->sock_client[slot] = -1;
+    for (uint32_t slot_idx = 0U; slot_idx < server_ctx->slot_count; ++slot_idx)
+    {
+        if (server_ctx->slot[slot_idx].sock == sock)
+        {
+            server_slot_free(server_ctx, slot_idx);
+        }
+    }
 
     return;
 }
 
-swicc_ret_et swicc_net_client(swicc_st *const swicc_state,
-                              swicc_net_client_st *const client_ctx)
+swicc_ret_et swicc_net_server_slot_attach(swicc_net_server_st *const server_ctx,
+                                          uint16_t const slot,
+                                          uint16_t const slot_conn,
+                                          uint32_t const card)
 {
-    /* For debugging. */
-    static char dbg_buf[2048U];
-    uint16_t dbg_buf_len;
-
-    swicc_ret_et ret = SWICC_RET_ERROR;
-    swicc_net_msg_st msg_rx;
-    swicc_net_msg_st msg_tx;
+    if (slot_conn >= server_ctx->slot_count ||
+        server_ctx->slot[slot_conn].sock < 0)
+    {
+        logger("Requested slot has no connected client.");
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (server_slot_reserve(server_ctx, slot) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (server_ctx->slot[slot].sock != -1)
+    {
+        logger("Requested slot is already in use.");
+        return SWICC_RET_PARAM_BAD;
+    }
+    int32_t const sock = server_ctx->slot[slot_conn].sock;
+    if (server_slot_index_find(server_ctx, sock, card) != UINT32_MAX)
+    {
+        logger("Card %u of the connection already has a slot.", card);
+        return SWICC_RET_PARAM_BAD;
+    }
+    if (server_slot_use(server_ctx, slot, sock, card) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    server_ctx->slot[slot].ka_conn = server_ctx->slot[slot_conn].ka_conn;
+    return SWICC_RET_SUCCESS;
+}
 
-    swicc_state->buf_rx = msg_rx.data.buf;
-    swicc_state->buf_rx_len = 0U;
-    swicc_state->buf_tx = msg_tx.data.buf;
-    swicc_state->buf_tx_len = sizeof(msg_tx.data.buf);
+swicc_ret_et swicc_net_server_slot_find(
+    swicc_net_server_st *const server_ctx, int32_t const sock,
+    uint32_t const card, uint16_t *const slot)
+{
+    uint32_t const pos = server_slot_index_find(server_ctx, sock, card);
+    if (pos == UINT32_MAX)
+    {
+        return SWICC_RET_ERROR;
+    }
+    uint32_t const slot_idx = server_ctx->slot_index[pos] - 1U;
+    /* Safe cast since the slot table never exceeds 2^16 slots. */
+    *slot = (uint16_t)slot_idx;
+    server_ctx->slot[server_ctx->slot[slot_idx].ka_conn].ka_active = true;
+    return SWICC_RET_SUCCESS;
+}
 
-    bool msg_received = false;
-    while (swicc_state->shutdown == false &&
-           swicc_net_recv(client_ctx->sock_client, &msg_rx) ==
-               SWICC_RET_SUCCESS)
+swicc_ret_et swicc_net_server_slot_send(
+    swicc_net_server_st const *const server_ctx, uint16_t const slot,
+    swicc_net_msg_st const *const msg)
+{
+    if (slot >= server_ctx->slot_count)
+    {
+        logger("Requested slot is not present.");
+        return SWICC_RET_PARAM_BAD;
+    }
+    int32_t const sock = server_ctx->slot[slot].sock;
+    uint32_t const card = server_ctx->slot[slot].card;
+    if (card != 0U)
     {
-        if (SWICC_NET_CLIENT_LOG_KEEPALIVE ||
-            msg_rx.data.ctrl != SWICC_NET_MSG_CTRL_KEEPALIVE)
+        swicc_net_msg_st msg_card;
+        msg_card_create(&msg_card, card);
+        if (swicc_net_send(sock, &msg_card) != SWICC_RET_SUCCESS)
         {
-            dbg_buf_len = sizeof(dbg_buf);
-            if (swicc_dbg_net_msg_str(dbg_buf, &dbg_buf_len, "RX:\n",
-                                      &msg_rx) == SWICC_RET_SUCCESS)
-            {
-                logger("%.*s", dbg_buf_len, dbg_buf);
-            }
+            return SWICC_RET_ERROR;
         }
+    }
+    return swicc_net_send(sock, msg);
+}
 
-        static_assert(
-            offsetof(swicc_net_msg_data_st, buf) < UINT8_MAX,
-            "Data buffer is offset further than 255 bytes into message data which leads to an unsafe cast.");
-        /**
-         * Safe cast since buf is not offset further than 255 bytes (as
-         * asserted).
+swicc_ret_et swicc_net_server_slot_recv(
+    swicc_net_server_st *const server_ctx, uint16_t const slot,
+    swicc_net_msg_st *const msg)
+{
+    if (slot >= server_ctx->slot_count)
+    {
+        logger("Requested slot is not present.");
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t card;
+    swicc_ret_et const ret =
+        swicc_net_recv_card(server_ctx->slot[slot].sock, msg, &card);
+    if (ret == SWICC_RET_SUCCESS && card != server_ctx->slot[slot].card)
+    {
+        logger("Received a response for card %u, expected card %u.", card,
+               server_ctx->slot[slot].card);
+        return SWICC_RET_ERROR;
+    }
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        server_ctx->slot[server_ctx->slot[slot].ka_conn].ka_active = true;
+    }
+    return ret;
+}
+
+void swicc_net_server_keepalive_set(swicc_net_server_st *const server_ctx,
+                                    uint32_t const idle)
+{
+    server_ctx->keepalive.idle = idle;
+    server_ctx->keepalive.rearm = true;
+}
+
+swicc_ret_et swicc_net_server_keepalive_poll(
+    swicc_net_server_st *const server_ctx, uint64_t const now,
+    uint16_t *const slot, uint32_t const slot_size, uint32_t *const slot_count)
+{
+    if (server_ctx == NULL || slot_count == NULL ||
+        (slot == NULL && slot_size > 0U))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    *slot_count = 0U;
+    swicc_net_keepalive_st *const ka = &server_ctx->keepalive;
+    uint64_t const now_tick = now / SWICC_NET_KEEPALIVE_TICK;
+
+    if (ka->rearm)
+    {
+        ka->rearm = false;
+        ka->tick_pending = false;
+        ka->tick = now_tick;
+        for (uint32_t slot_idx = 0U; slot_idx < server_ctx->slot_count;
+             ++slot_idx)
+        {
+            keepalive_unlink(server_ctx, slot_idx);
+            swicc_net_server_slot_st *const entry = &server_ctx->slot[slot_idx];
+            if (ka->idle > 0U && entry->sock >= 0 &&
+                entry->ka_conn == slot_idx)
+            {
+                entry->ka_active = false;
+                keepalive_link(server_ctx, slot_idx,
+                               ka->tick + keepalive_idle_tick(server_ctx));
+            }
+        }
+        return SWICC_RET_SUCCESS;
+    }
+    if (ka->tick_pending &&
+        !keepalive_fire(server_ctx, slot, slot_size, slot_count))
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    while (ka->tick < now_tick)
+    {
+        if (ka->armed_count == 0U)
+        {
+            ka->tick = now_tick;
+            break;
+        }
+        ka->tick += 1U;
+        /**
+         * Whenever a level wraps around, the next bucket of the level above
+         * it gets spread over the levels below.
          */
-        uint32_t const buf_rx_len =
-            msg_rx.hdr.size - (uint8_t)offsetof(swicc_net_msg_data_st, buf);
+        for (uint32_t level = 1U; level < SWICC_NET_KEEPALIVE_LEVEL_COUNT;
+             ++level)
+        {
+            uint32_t const shift = SWICC_NET_KEEPALIVE_LEVEL_BITS * level;
+            if ((ka->tick & ((1ULL << shift) - 1U)) != 0U)
+            {
+                break;
+            }
+            /* Safe cast since the mask keeps only the bits of one index. */
+            keepalive_cascade(server_ctx, level,
+                              (uint32_t)(ka->tick >> shift) &
+                                  (SWICC_NET_KEEPALIVE_LEVEL_SIZE - 1U));
+        }
+        if (!keepalive_fire(server_ctx, slot, slot_size, slot_count))
+        {
+            break;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Check if any of the cards of a client was asked to shut down.
+ * @param swicc_state
+ * @param card_count
+ * @return true if the client should stop, false otherwise.
+ */
+static bool client_shutdown(swicc_st *const *const swicc_state,
+                            uint32_t const card_count)
+{
+    for (uint32_t card = 0U; card < card_count; ++card)
+    {
+        if (swicc_state[card]->shutdown == true)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Send a response of a client for a card. For cards other than 0, the
+ * response is preceded by a card message.
+ * @param client_ctx
+ * @param card
+ * @param msg
+ * @return Return code.
+ */
+static swicc_ret_et client_send(swicc_net_client_st *const client_ctx,
+                                uint32_t const card,
+                                swicc_net_msg_st const *const msg)
+{
+    bool const shm = client_ctx->shm.region != NULL;
+    if (card != 0U)
+    {
+        swicc_net_msg_st msg_card;
+        msg_card_create(&msg_card, card);
+        if ((shm ? swicc_net_shm_send(&client_ctx->shm, &msg_card)
+                 : swicc_net_send(client_ctx->sock_client, &msg_card)) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    return shm ? swicc_net_shm_send(&client_ctx->shm, msg)
+               : swicc_net_send(client_ctx->sock_client, msg);
+}
+
+/**
+ * @brief Receive loop of a client that handles one or more cards.
+ * @param swicc_state Array of swICC states, one per card.
+ * @param card_count Number of cards.
+ * @param client_ctx
+ * @return Return code.
+ */
+static swicc_ret_et client_run(swicc_st *const *const swicc_state,
+                               uint32_t const card_count,
+                               swicc_net_client_st *const client_ctx)
+{
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    swicc_net_msg_st msg_rx;
+    swicc_net_msg_st msg_tx;
 
-        if (buf_rx_len <= UINT16_MAX)
+    /* All cards share the buffers since messages are handled one by one. */
+    for (uint32_t card = 0U; card < card_count; ++card)
+    {
+        swicc_state[card]->buf_rx = msg_rx.data.buf;
+        swicc_state[card]->buf_rx_len = 0U;
+        swicc_state[card]->buf_tx = msg_tx.data.buf;
+        swicc_state[card]->buf_tx_len = sizeof(msg_tx.data.buf);
+    }
+
+    bool const shm = client_ctx->shm.region != NULL;
+    bool msg_received = false;
+    /* Card of the next message, card messages only apply to one message. */
+    uint32_t card = 0U;
+    while (client_shutdown(swicc_state, card_count) == false &&
+           (shm ? swicc_net_shm_recv(&client_ctx->shm, &msg_rx)
+                : conn_msg_recv(client_ctx->sock_client, &client_ctx->conn,
+                                &msg_rx)) == SWICC_RET_SUCCESS)
+    {
+        if (msg_rx.data.ctrl == SWICC_NET_MSG_CTRL_CARD)
         {
-            /* Perform control operations first. */
-            if (msg_rx.data.ctrl != 0U)
+            if (card != 0U ||
+                msg_card_parse(&msg_rx, &card) != SWICC_RET_SUCCESS)
             {
-                /**
-                 * Control operations may send back data and have to indicate
-                 * success or failure hence these values are set to defaults
-                 * before performing the requested operation.
-                 */
-                msg_tx.data.ctrl = SWICC_NET_MSG_CTRL_FAILURE;
-                msg_tx.hdr.size = offsetof(swicc_net_msg_data_st, buf);
+                logger("Received an unexpected card message.");
+                ret = SWICC_RET_ERROR;
+                break;
+            }
+            continue;
+        }
+        if (card >= card_count)
+        {
+            logger("Received a message for card %u but only have %u cards.",
+                   card, card_count);
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        if (client_msg_handle(swicc_state[card], client_ctx->log_lvl, &msg_rx,
+                              &msg_tx) != SWICC_RET_SUCCESS ||
+            client_send(client_ctx, card, &msg_tx) != SWICC_RET_SUCCESS)
+        {
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        card = 0U;
 
-                switch (msg_rx.data.ctrl)
-                {
-                case SWICC_NET_MSG_CTRL_KEEPALIVE:
-                    msg_tx.data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
-                    break;
-                case SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_Y:
-                case SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_N:
-                    /**
-                     * A warm reset is not a cold reset but functionally they
-                     * are the same.
-                     */
-                case SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_Y:
-                case SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_N:
-                    if (swicc_mock_reset_cold(
-                            swicc_state,
-                            msg_rx.data.ctrl ==
-                                    SWICC_NET_MSG_CTRL_MOCK_RESET_WARM_PPS_Y ||
-                                msg_rx.data.ctrl ==
-                                    SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_Y) ==
-                        SWICC_RET_SUCCESS)
-                    {
-                        static_assert(
-                            sizeof(swicc_atr) <= sizeof(msg_tx.data.buf),
-                            "Card ATR does not fit in the message data buffer.");
-                        memcpy(msg_tx.data.buf, swicc_atr, sizeof(swicc_atr));
-                        msg_tx.hdr.size = offsetof(swicc_net_msg_data_st, buf) +
-                                          sizeof(swicc_atr);
-                        msg_tx.data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
-                    }
-                    break;
-                }
+        /**
+         * Useful to see if client got disconnected or failed to connect at
+         * all.
+         */
+        msg_received = true;
+    }
 
-                /**
-                 * These data members shall not be modified by the control
-                 * operations because they represent the state of the ICC after
-                 * the request.
-                 */
-                msg_tx.data.cont_state = swicc_state->cont_state_tx;
-                msg_tx.data.buf_len_exp = swicc_state->buf_rx_len;
+    if (client_shutdown(swicc_state, card_count) == true)
+    {
+        return SWICC_RET_SUCCESS;
+    }
+    if (ret != SWICC_RET_SUCCESS && msg_received)
+    {
+        return SWICC_RET_NET_DISCONNECTED;
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_net_client(swicc_st *const swicc_state,
+                              swicc_net_client_st *const client_ctx)
+{
+    return client_run(&swicc_state, 1U, client_ctx);
+}
+
+swicc_ret_et swicc_net_client_mux(swicc_st *const *const swicc_state,
+                                  uint32_t const card_count,
+                                  swicc_net_client_st *const client_ctx)
+{
+    if (swicc_state == NULL || card_count == 0U || client_ctx == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    return client_run(swicc_state, card_count, client_ctx);
+}
+
+swicc_ret_et swicc_net_client_step(swicc_st *const swicc_state,
+                                   swicc_net_client_st *const client_ctx,
+                                   uint8_t *const ready)
+{
+    if (swicc_state == NULL || client_ctx == NULL || ready == NULL ||
+        client_ctx->sock_client < 0)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    int32_t const sock = client_ctx->sock_client;
+    swicc_net_conn_st *const conn_rx = &client_ctx->conn;
+    swicc_net_conn_st *const conn_tx = &client_ctx->conn_tx;
+    swicc_net_msg_st msg_rx;
+    swicc_net_msg_st msg_tx;
+
+    swicc_state->buf_rx = msg_rx.data.buf;
+    swicc_state->buf_rx_len = 0U;
+    swicc_state->buf_tx = msg_tx.data.buf;
+    swicc_state->buf_tx_len = sizeof(msg_tx.data.buf);
 
-                if (swicc_net_send(client_ctx->sock_client, &msg_tx) !=
-                    SWICC_RET_SUCCESS)
+    swicc_ret_et ret = conn_flush(sock, conn_tx);
+    /**
+     * Handling stops when the responses of buffered requests fill the queue,
+     * so it is resumed after each flush which made space again. Otherwise the
+     * socket would be reported as only readable while the peer waits for the
+     * responses to requests it already sent.
+     */
+    do
+    {
+        /**
+         * Stop receiving while responses can't be queued so that a peer which
+         * does not read gets back-pressure instead of making the queue grow.
+         */
+        while (ret == SWICC_RET_SUCCESS && conn_msg_fits(conn_tx))
+        {
+            swicc_ret_et const ret_next = conn_msg_next(conn_rx, &msg_rx);
+            if (ret_next == SWICC_RET_SUCCESS)
+            {
+                ret = client_msg_handle(swicc_state, client_ctx->log_lvl,
+                                        &msg_rx, &msg_tx);
+                if (ret == SWICC_RET_SUCCESS)
                 {
-                    ret = SWICC_RET_ERROR;
-                    break;
+                    conn_msg_queue(conn_tx, &msg_tx);
                 }
             }
-            else
+            else if (ret_next == SWICC_RET_NET_MSG_INCOMPLETE)
             {
-                /* Handle data. */
-                swicc_state->buf_rx = msg_rx.data.buf;
-                swicc_state->buf_rx_len =
-                    (uint16_t)buf_rx_len; /* Safe cast due to bound check. */
-                swicc_state->buf_tx = msg_tx.data.buf;
-                swicc_state->buf_tx_len = sizeof(msg_tx.data.buf);
-#ifdef DEBUG_NET_MSG
-                static_assert(
-                    offsetof(swicc_net_msg_data_st, buf) < UINT16_MAX,
-                    "Unsafe cast since offset is larger than what uint16 can hold.");
-                swicc_tpdu_cmd_st tpdu_debug;
-                if (swicc_tpdu_cmd_parse(
-                        msg_rx.data.buf,
-                        (uint16_t)(msg_rx.hdr.size -
-                                   offsetof(swicc_net_msg_data_st, buf)),
-                        &tpdu_debug) == SWICC_RET_SUCCESS)
-                {
-                    dbg_buf_len = sizeof(dbg_buf);
-                    if (swicc_dbg_tpdu_cmd_str(dbg_buf, &dbg_buf_len,
-                                               &tpdu_debug) ==
-                        SWICC_RET_SUCCESS)
-                    {
-                        logger("%.*s", dbg_buf_len, dbg_buf);
-                    }
-                    else
-                    {
-                        logger("Failed to create debug string of TPDU.");
-                    }
-                }
-                else
-                {
-                    logger("Failed to parse data as a TPDU.");
-                }
-#endif
-                swicc_io(swicc_state);
-
-                /* Prepare response. */
-                if (sizeof(msg_tx.data.cont_state) + swicc_state->buf_tx_len >
-                    UINT32_MAX)
-                {
-                    break;
-                }
-                /* Safe cast because it was checked. */
-                msg_tx.hdr.size =
-                    (uint32_t)(offsetof(swicc_net_msg_data_st, buf) +
-                               swicc_state->buf_tx_len);
-                msg_tx.data.cont_state = swicc_state->cont_state_tx;
-                msg_tx.data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
-                msg_tx.data.buf_len_exp = swicc_state->buf_rx_len;
-                memcpy(msg_tx.data.buf, swicc_state->buf_tx,
-                       swicc_state->buf_tx_len);
-                if (swicc_net_send(client_ctx->sock_client, &msg_tx) !=
-                    SWICC_RET_SUCCESS)
+                swicc_ret_et const ret_fill =
+                    conn_fill(sock, conn_rx, MSG_DONTWAIT);
+                if (ret_fill == SWICC_RET_NET_MSG_INCOMPLETE)
                 {
-                    ret = SWICC_RET_ERROR;
+                    /* Everything available was consumed. */
                     break;
                 }
+                ret = ret_fill;
             }
-
-            /**
-             * Useful to see if client got disconnected or failed to connect at
-             * all.
-             */
-            msg_received = true;
-
-            if (SWICC_NET_CLIENT_LOG_KEEPALIVE ||
-                msg_rx.data.ctrl != SWICC_NET_MSG_CTRL_KEEPALIVE)
+            else
             {
-                dbg_buf_len = sizeof(dbg_buf);
-                if (swicc_dbg_net_msg_str(dbg_buf, &dbg_buf_len, "TX:\n",
-                                          &msg_tx) == SWICC_RET_SUCCESS)
-                {
-                    logger("%.*s", dbg_buf_len, dbg_buf);
-                }
+                ret = ret_next;
             }
         }
+        if (ret == SWICC_RET_SUCCESS)
+        {
+            ret = conn_flush(sock, conn_tx);
+        }
+    } while (ret == SWICC_RET_SUCCESS && conn_msg_fits(conn_tx) &&
+             conn_msg_peek(conn_rx) == SWICC_RET_SUCCESS);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        *ready = SWICC_NET_READY_NONE;
+        return ret;
+    }
+
+    *ready = conn_msg_fits(conn_tx) ? SWICC_NET_READY_READ
+                                    : SWICC_NET_READY_NONE;
+    if (conn_tx->len > 0U)
+    {
+        *ready |= SWICC_NET_READY_WRITE;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+static_assert(sizeof(swicc_net_msg_st) <= SWICC_POOL_BUF_SIZE,
+              "A message does not fit in a buffer of the pool.");
+
+/* Messages a reactor card borrowed while handling what it received. */
+typedef struct reactor_msg_s
+{
+    swicc_net_msg_st *rx;
+    swicc_net_msg_st *tx;
+} reactor_msg_st;
+
+/**
+ * @brief Borrow the message buffers of a card from the pool of the thread and
+ * make them the RX and TX buffers of the card.
+ * @param card
+ * @param msg Where the borrowed messages will be written.
+ * @return Return code.
+ */
+static swicc_ret_et reactor_msg_borrow(swicc_net_reactor_card_st *const card,
+                                       reactor_msg_st *const msg)
+{
+    swicc_pool_st *const pool = swicc_pool_thread();
+    msg->rx = swicc_pool_get(pool);
+    msg->tx = swicc_pool_get(pool);
+    if (msg->rx == NULL || msg->tx == NULL)
+    {
+        logger("Failed to borrow message buffers.");
+        swicc_pool_put(pool, msg->rx);
+        swicc_pool_put(pool, msg->tx);
+        return SWICC_RET_ERROR;
+    }
+    /* The RX length is kept, it's the length the card expects next. */
+    card->swicc_state->buf_rx = msg->rx->data.buf;
+    card->swicc_state->buf_tx = msg->tx->data.buf;
+    card->swicc_state->buf_tx_len = sizeof(msg->tx->data.buf);
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Give back the message buffers of a card to the pool of the thread.
+ * @param card
+ * @param msg
+ */
+static void reactor_msg_return(swicc_net_reactor_card_st *const card,
+                               reactor_msg_st const *const msg)
+{
+    swicc_pool_st *const pool = swicc_pool_thread();
+    swicc_pool_put(pool, msg->rx);
+    swicc_pool_put(pool, msg->tx);
+    card->swicc_state->buf_rx = NULL;
+    card->swicc_state->buf_tx = NULL;
+    card->swicc_state->buf_tx_len = 0U;
+}
+
+/**
+ * @brief Put a card at the back of the run queue of its priority class.
+ * @param reactor
+ * @param card A card that is not ready.
+ * @param now When the card became ready.
+ */
+static void reactor_sched_push(swicc_net_reactor_st *const reactor,
+                               swicc_net_reactor_card_st *const card,
+                               uint64_t const now)
+{
+    card->sched_next = NULL;
+    card->sched_time = now;
+    card->sched_ready = true;
+    if (reactor->sched_tail[card->prio] == NULL)
+    {
+        reactor->sched_head[card->prio] = card;
+    }
+    else
+    {
+        reactor->sched_tail[card->prio]->sched_next = card;
+    }
+    reactor->sched_tail[card->prio] = card;
+    reactor->sched_count += 1U;
+}
+
+/**
+ * @brief Take the card at the front of the highest priority run queue that
+ * is not empty.
+ * @param reactor There has to be a ready card.
+ * @return The card, it's no longer ready.
+ */
+static swicc_net_reactor_card_st *reactor_sched_pop(
+    swicc_net_reactor_st *const reactor)
+{
+    uint32_t prio = 0U;
+    while (reactor->sched_head[prio] == NULL)
+    {
+        prio += 1U;
+    }
+    swicc_net_reactor_card_st *const card = reactor->sched_head[prio];
+    reactor->sched_head[prio] = card->sched_next;
+    if (reactor->sched_head[prio] == NULL)
+    {
+        reactor->sched_tail[prio] = NULL;
+    }
+    card->sched_next = NULL;
+    card->sched_ready = false;
+    reactor->sched_count -= 1U;
+    return card;
+}
+
+/**
+ * @brief Take a card out of the run queue of its priority class.
+ * @param reactor
+ * @param card A card that is ready.
+ */
+static void reactor_sched_unlink(swicc_net_reactor_st *const reactor,
+                                 swicc_net_reactor_card_st *const card)
+{
+    swicc_net_reactor_card_st *prev = NULL;
+    swicc_net_reactor_card_st *cur = reactor->sched_head[card->prio];
+    while (cur != card)
+    {
+        prev = cur;
+        cur = cur->sched_next;
+    }
+    if (prev == NULL)
+    {
+        reactor->sched_head[card->prio] = card->sched_next;
     }
+    else
+    {
+        prev->sched_next = card->sched_next;
+    }
+    if (reactor->sched_tail[card->prio] == card)
+    {
+        reactor->sched_tail[card->prio] = prev;
+    }
+    card->sched_next = NULL;
+    card->sched_ready = false;
+    reactor->sched_count -= 1U;
+}
+
+/**
+ * @brief Check if one more response of a card can be queued for sending with
+ * io_uring. The queue is not compacted while a send from it is in flight.
+ * @param card
+ * @return true if there is space, false otherwise.
+ */
+static bool reactor_uring_tx_fits(swicc_net_reactor_card_st *const card)
+{
+    swicc_net_conn_st *const conn_tx = &card->client_ctx->conn_tx;
+    return (card->uring_op & SWICC_NET_REACTOR_URING_OP_SEND) != 0U
+               ? sizeof(conn_tx->buf) - conn_tx->len >=
+                     sizeof(swicc_net_msg_st)
+               : conn_msg_fits(conn_tx);
+}
 
-    if (swicc_state->shutdown == true)
+/**
+ * @brief Handle messages buffered for a card, sending back (or with io_uring,
+ * queueing) the responses.
+ * @param reactor
+ * @param card
+ * @param msg_max Most messages to handle.
+ * @param budget Time after which no more messages are handled.
+ * @param now Time when called, receives the time when done.
+ * @return Return code. Anything other than success means the card has to be
+ * removed from the reactor.
+ * @note The card is counted as having waited since its 'sched_time'. At least
+ * one message is handled if there is one, whatever the budget.
+ */
+static swicc_ret_et reactor_sched_turn(swicc_net_reactor_st *const reactor,
+                                       swicc_net_reactor_card_st *const card,
+                                       uint32_t const msg_max,
+                                       uint64_t const budget,
+                                       uint64_t *const now)
+{
+    bool const uring = reactor->backend == SWICC_NET_REACTOR_BACKEND_URING;
+    swicc_net_conn_st *const conn_rx = &card->client_ctx->conn;
+    if (conn_msg_peek(conn_rx) != SWICC_RET_SUCCESS ||
+        (uring && !reactor_uring_tx_fits(card)))
     {
+        /* Nothing that can be handled, the peek is repeated by the caller. */
         return SWICC_RET_SUCCESS;
     }
-    if (ret != SWICC_RET_SUCCESS && msg_received)
+    if (card->swicc_state->stats != NULL)
     {
-        return SWICC_RET_NET_DISCONNECTED;
+        swicc_stats_sched(card->swicc_state->stats, *now - card->sched_time);
     }
-    return ret;
+
+    reactor_msg_st msg;
+    if (reactor_msg_borrow(card, &msg) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    uint64_t const turn_start = *now;
+    uint32_t msg_count = 0U;
+    swicc_ret_et ret_next;
+    do
+    {
+        ret_next = conn_msg_next(conn_rx, msg.rx);
+        if (ret_next != SWICC_RET_SUCCESS)
+        {
+            break;
+        }
+        if (client_msg_handle(card->swicc_state, card->client_ctx->log_lvl,
+                              msg.rx, msg.tx) != SWICC_RET_SUCCESS)
+        {
+            ret_next = SWICC_RET_ERROR;
+            break;
+        }
+        if (uring)
+        {
+            conn_msg_queue(&card->client_ctx->conn_tx, msg.tx);
+        }
+        else if (swicc_net_send(card->client_ctx->sock_client, msg.tx) !=
+                 SWICC_RET_SUCCESS)
+        {
+            ret_next = SWICC_RET_ERROR;
+            break;
+        }
+        msg_count += 1U;
+        *now = swicc_stats_time();
+    } while (msg_count < msg_max && *now - turn_start < budget &&
+             (uring == false || reactor_uring_tx_fits(card)));
+    reactor_msg_return(card, &msg);
+    return ret_next == SWICC_RET_NET_MSG_INCOMPLETE ? SWICC_RET_SUCCESS
+                                                    : ret_next;
+}
+
+/**
+ * @brief Create the user data of an io_uring operation of a card.
+ * @param slot Slot of the card.
+ * @param gen Generation of the slot.
+ * @param send If it's a send (=true) or receive (=false).
+ * @return User data.
+ */
+static uint64_t reactor_uring_user_data(uint32_t const slot, uint32_t const gen,
+                                        bool const send)
+{
+    return ((send ? 1ULL : 0ULL) << 63U) | ((uint64_t)gen << 32U) | slot;
+}
+
+/**
+ * @brief Give a card a free io_uring slot and start receiving on it.
+ * @param reactor
+ * @param card
+ * @return Return code.
+ */
+static swicc_ret_et
+reactor_uring_card_add(swicc_net_reactor_st *const reactor,
+                       swicc_net_reactor_card_st *const card)
+{
+    uint32_t slot_idx = 0U;
+    while (slot_idx < reactor->uring_slot_count &&
+           reactor->uring_slot[slot_idx].card != NULL)
+    {
+        ++slot_idx;
+    }
+    if (slot_idx == reactor->uring_slot_count)
+    {
+        uint32_t const slot_count_new =
+            reactor->uring_slot_count > 0U ? reactor->uring_slot_count * 2U
+                                           : SWICC_NET_REACTOR_EVENT_COUNT_MAX;
+        swicc_net_reactor_uring_slot_st *const slot_new =
+            realloc(reactor->uring_slot,
+                    slot_count_new * sizeof(swicc_net_reactor_uring_slot_st));
+        if (slot_new == NULL)
+        {
+            logger("Failed to grow the io_uring slot table.");
+            return SWICC_RET_ERROR;
+        }
+        for (uint32_t slot_init = reactor->uring_slot_count;
+             slot_init < slot_count_new; ++slot_init)
+        {
+            slot_new[slot_init].card = NULL;
+            slot_new[slot_init].gen = 0U;
+        }
+        reactor->uring_slot = slot_new;
+        reactor->uring_slot_count = slot_count_new;
+    }
+
+    swicc_net_reactor_uring_slot_st *const slot =
+        &reactor->uring_slot[slot_idx];
+    /* Generation is 31-bit (top bit of user data is the opcode) and never 0. */
+    slot->gen = (slot->gen + 1U) & 0x7FFFFFFFU;
+    if (slot->gen == 0U)
+    {
+        slot->gen = 1U;
+    }
+    card->uring_slot = slot_idx;
+    card->uring_op = 0U;
+    card->uring_closed = false;
+    card->uring_held_head = SWICC_NET_URING_BUF_ID_NONE;
+    card->uring_held_tail = SWICC_NET_URING_BUF_ID_NONE;
+    card->client_ctx->conn_tx.len = 0U;
+    card->client_ctx->conn_tx.offset = 0U;
+    if (swicc_net_uring_recv(&reactor->uring, card->client_ctx->sock_client,
+                             reactor_uring_user_data(slot_idx, slot->gen,
+                                                     false)) !=
+        SWICC_RET_SUCCESS)
+    {
+        logger("Failed to queue a receive for a card.");
+        return SWICC_RET_ERROR;
+    }
+    card->uring_op |= SWICC_NET_REACTOR_URING_OP_RECV;
+    slot->card = card;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Move as many of the buffers held by a card as fit into the receive
+ * buffer of its client and give them back to the kernel.
+ * @param reactor
+ * @param card
+ */
+static void reactor_uring_held_flush(swicc_net_reactor_st *const reactor,
+                                     swicc_net_reactor_card_st *const card)
+{
+    swicc_net_conn_st *const conn_rx = &card->client_ctx->conn;
+    if (card->uring_held_head != SWICC_NET_URING_BUF_ID_NONE &&
+        conn_rx->offset > 0U)
+    {
+        memmove(conn_rx->buf, &conn_rx->buf[conn_rx->offset],
+                conn_rx->len - conn_rx->offset);
+        conn_rx->len -= conn_rx->offset;
+        conn_rx->offset = 0U;
+    }
+    while (card->uring_held_head != SWICC_NET_URING_BUF_ID_NONE)
+    {
+        uint16_t const buf_id = card->uring_held_head;
+        uint32_t const buf_len = reactor->uring_held_len[buf_id];
+        if (sizeof(conn_rx->buf) - conn_rx->len < buf_len)
+        {
+            return;
+        }
+        swicc_net_uring_cqe_st const held = {
+            .buf = &reactor->uring.buf[buf_id * SWICC_NET_URING_BUF_SIZE],
+            .buf_id = buf_id,
+        };
+        memcpy(&conn_rx->buf[conn_rx->len], held.buf, buf_len);
+        conn_rx->len += buf_len;
+        card->uring_held_head = reactor->uring_held_next[buf_id];
+        swicc_net_uring_buf_release(&reactor->uring, &held);
+    }
+    card->uring_held_tail = SWICC_NET_URING_BUF_ID_NONE;
+}
+
+/**
+ * @brief Buffer data received by a card using io_uring and make the card ready
+ * once it has a complete message.
+ * @param reactor
+ * @param card
+ * @param cqe Completion of the receive. Its buffer is given back to the kernel
+ * by this, or held by the card when the data does not fit yet.
+ * @param now When the receive completed.
+ * @return Return code.
+ */
+static swicc_ret_et reactor_uring_recvd(swicc_net_reactor_st *const reactor,
+                                        swicc_net_reactor_card_st *const card,
+                                        swicc_net_uring_cqe_st const *const cqe,
+                                        uint64_t const now)
+{
+    if (cqe->more == false)
+    {
+        card->uring_op &= (uint8_t)~SWICC_NET_REACTOR_URING_OP_RECV;
+    }
+    if (cqe->res <= 0 || cqe->buf == NULL)
+    {
+        swicc_net_uring_buf_release(&reactor->uring, cqe);
+    }
+    if (cqe->res == -ENOBUFS || cqe->res == -ECANCELED)
+    {
+        /**
+         * All buffers were in use, or receiving was stopped to hold back the
+         * peer. The receive gets queued again once it can be.
+         */
+        return SWICC_RET_SUCCESS;
+    }
+    else if (cqe->res == 0)
+    {
+        /**
+         * Requests received in the same batch may not have been handled yet,
+         * the card gets removed once they are answered.
+         */
+        logger("Peer closed the connection.");
+        card->uring_closed = true;
+        return SWICC_RET_SUCCESS;
+    }
+    else if (cqe->res < 0 || cqe->buf == NULL)
+    {
+        logger("Receive of io_uring failed: %s.", strerror(-cqe->res));
+        return SWICC_RET_ERROR;
+    }
+
+    swicc_net_conn_st *const conn_rx = &card->client_ctx->conn;
+    /* Safe cast since the result was checked to be positive. */
+    uint32_t const recvd_bytes = (uint32_t)cqe->res;
+    bool const held_none = card->uring_held_head == SWICC_NET_URING_BUF_ID_NONE;
+    if (held_none &&
+        sizeof(conn_rx->buf) - (conn_rx->len - conn_rx->offset) < recvd_bytes)
+    {
+        /**
+         * Space is made by handling what is buffered right away instead of
+         * waiting for a turn.
+         */
+        uint64_t now_turn = now;
+        if (card->sched_ready == false)
+        {
+            card->sched_time = now;
+        }
+        if (reactor_sched_turn(reactor, card, UINT32_MAX, UINT64_MAX,
+                               &now_turn) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    if (conn_rx->offset > 0U)
+    {
+        memmove(conn_rx->buf, &conn_rx->buf[conn_rx->offset],
+                conn_rx->len - conn_rx->offset);
+        conn_rx->len -= conn_rx->offset;
+        conn_rx->offset = 0U;
+    }
+    if (held_none && sizeof(conn_rx->buf) - conn_rx->len >= recvd_bytes)
+    {
+        memcpy(&conn_rx->buf[conn_rx->len], cqe->buf, recvd_bytes);
+        conn_rx->len += recvd_bytes;
+        swicc_net_uring_buf_release(&reactor->uring, cqe);
+    }
+    else
+    {
+        /**
+         * Responses can't be queued until a send completes, so the data is held
+         * and receiving stops like epoll stops waiting for input. It is moved
+         * into the client once answering made space for it.
+         */
+        if (held_none)
+        {
+            card->uring_held_head = cqe->buf_id;
+        }
+        else
+        {
+            reactor->uring_held_next[card->uring_held_tail] = cqe->buf_id;
+        }
+        card->uring_held_tail = cqe->buf_id;
+        reactor->uring_held_next[cqe->buf_id] = SWICC_NET_URING_BUF_ID_NONE;
+        reactor->uring_held_len[cqe->buf_id] = recvd_bytes;
+        if (held_none &&
+            (card->uring_op & SWICC_NET_REACTOR_URING_OP_RECV) != 0U &&
+            swicc_net_uring_cancel(
+                &reactor->uring,
+                reactor_uring_user_data(
+                    card->uring_slot, reactor->uring_slot[card->uring_slot].gen,
+                    false)) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    if (card->sched_ready == false)
+    {
+        swicc_ret_et const ret_peek = conn_msg_peek(conn_rx);
+        if (ret_peek == SWICC_RET_SUCCESS)
+        {
+            reactor_sched_push(reactor, card, now);
+        }
+        else if (ret_peek != SWICC_RET_NET_MSG_INCOMPLETE)
+        {
+            return ret_peek;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Handle the completion of a send of a card using io_uring.
+ * @param card
+ * @param cqe Completion of the send.
+ * @return Return code.
+ */
+static swicc_ret_et reactor_uring_sent(swicc_net_reactor_card_st *const card,
+                                       swicc_net_uring_cqe_st const *const cqe)
+{
+    card->uring_op &= (uint8_t)~SWICC_NET_REACTOR_URING_OP_SEND;
+    if (cqe->res < 0)
+    {
+        logger("Send of io_uring failed: %s.", strerror(-cqe->res));
+        return SWICC_RET_ERROR;
+    }
+    swicc_net_conn_st *const conn_tx = &card->client_ctx->conn_tx;
+    /* Safe cast since the result was checked to not be negative. */
+    conn_tx->offset += (uint32_t)cqe->res;
+    if (conn_tx->offset >= conn_tx->len)
+    {
+        conn_tx->offset = 0U;
+        conn_tx->len = 0U;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Queue the operations a card needs but does not have in flight i.e. a
+ * receive if the multishot receive ended and a send if responses are queued.
+ * Held data is moved into the client first, and receiving only resumes once
+ * none is left and a response can be queued.
+ * @param reactor
+ * @param card
+ * @return Return code. Once the peer closed its side and every request it sent
+ * was answered, the disconnected code is returned.
+ */
+static swicc_ret_et reactor_uring_arm(swicc_net_reactor_st *const reactor,
+                                      swicc_net_reactor_card_st *const card)
+{
+    int32_t const sock = card->client_ctx->sock_client;
+    uint32_t const gen = reactor->uring_slot[card->uring_slot].gen;
+    reactor_uring_held_flush(reactor, card);
+    /* Like with epoll, nothing is received while no response can be queued. */
+    if ((card->uring_op & SWICC_NET_REACTOR_URING_OP_RECV) == 0U &&
+        card->uring_closed == false &&
+        card->uring_held_head == SWICC_NET_URING_BUF_ID_NONE &&
+        reactor_uring_tx_fits(card))
+    {
+        if (swicc_net_uring_recv(
+                &reactor->uring, sock,
+                reactor_uring_user_data(card->uring_slot, gen, false)) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        card->uring_op |= SWICC_NET_REACTOR_URING_OP_RECV;
+    }
+    swicc_net_conn_st *const conn_tx = &card->client_ctx->conn_tx;
+    if ((card->uring_op & SWICC_NET_REACTOR_URING_OP_SEND) == 0U &&
+        conn_tx->offset < conn_tx->len)
+    {
+        if (swicc_net_uring_send(
+                &reactor->uring, sock, &conn_tx->buf[conn_tx->offset],
+                conn_tx->len - conn_tx->offset,
+                reactor_uring_user_data(card->uring_slot, gen, true)) !=
+            SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        card->uring_op |= SWICC_NET_REACTOR_URING_OP_SEND;
+    }
+    if (card->uring_closed &&
+        (card->uring_op & SWICC_NET_REACTOR_URING_OP_SEND) == 0U &&
+        card->uring_held_head == SWICC_NET_URING_BUF_ID_NONE &&
+        conn_msg_peek(&card->client_ctx->conn) != SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_NET_DISCONNECTED;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Give turns to the ready cards until none is ready or the time budget
+ * of the reactor is used up, so that I/O gets polled again in time for the
+ * cards that will become ready meanwhile.
+ * @param reactor
+ */
+static void reactor_sched_run(swicc_net_reactor_st *const reactor)
+{
+    uint64_t now = swicc_stats_time();
+    uint64_t const pass_start = now;
+    while (reactor->sched_count > 0U)
+    {
+        swicc_net_reactor_card_st *const card = reactor_sched_pop(reactor);
+        swicc_ret_et ret = reactor_sched_turn(reactor, card, card->weight,
+                                              reactor->budget, &now);
+        if (ret == SWICC_RET_SUCCESS &&
+            reactor->backend == SWICC_NET_REACTOR_BACKEND_URING)
+        {
+            ret = reactor_uring_arm(reactor, card);
+        }
+        if (ret == SWICC_RET_SUCCESS && card->swicc_state->shutdown == false)
+        {
+            /**
+             * Cards with messages left go to the back of their class, unless
+             * they wait for a send to make space for the responses.
+             */
+            swicc_ret_et const ret_peek =
+                conn_msg_peek(&card->client_ctx->conn);
+            if (ret_peek == SWICC_RET_SUCCESS &&
+                (reactor->backend != SWICC_NET_REACTOR_BACKEND_URING ||
+                 reactor_uring_tx_fits(card)))
+            {
+                reactor_sched_push(reactor, card, now);
+                if (card->swicc_state->stats != NULL)
+                {
+                    swicc_stats_add(&card->swicc_state->stats->sched_yield,
+                                    1U);
+                }
+            }
+            else if (ret_peek != SWICC_RET_NET_MSG_INCOMPLETE)
+            {
+                ret = ret_peek;
+            }
+        }
+        else if (ret == SWICC_RET_SUCCESS)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            swicc_net_reactor_card_remove(reactor, card);
+        }
+        if (now - pass_start >= reactor->budget)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Same as 'swicc_net_reactor_run' but for the io_uring backend. All the
+ * operations queued while handling a batch of completions are submitted
+ * together at the start of the next wait.
+ * @param reactor
+ * @return Return code.
+ */
+static swicc_ret_et reactor_run_uring(swicc_net_reactor_st *const reactor)
+{
+    while (reactor->shutdown == false && reactor->card_count > 0U)
+    {
+        /* Ready cards only wait for completions that are already there. */
+        if (swicc_net_uring_wait(&reactor->uring,
+                                 reactor->sched_count > 0U
+                                     ? 0U
+                                     : SWICC_NET_REACTOR_TIMEOUT) !=
+            SWICC_RET_SUCCESS)
+        {
+            logger("Failed to wait for io_uring: %s.", strerror(errno));
+            return SWICC_RET_ERROR;
+        }
+        uint64_t const now = swicc_stats_time();
+
+        swicc_net_uring_cqe_st cqe;
+        while (swicc_net_uring_next(&reactor->uring, &cqe))
+        {
+            /* Safe cast since the lower 32 bits hold the slot. */
+            uint32_t const slot_idx = (uint32_t)cqe.user_data;
+            uint32_t const gen = (uint32_t)(cqe.user_data >> 32U) & 0x7FFFFFFFU;
+            bool const send = (cqe.user_data >> 63U) != 0U;
+            swicc_net_reactor_card_st *const card =
+                cqe.user_data != SWICC_NET_URING_USER_DATA_NONE &&
+                        slot_idx < reactor->uring_slot_count &&
+                        reactor->uring_slot[slot_idx].gen == gen
+                    ? reactor->uring_slot[slot_idx].card
+                    : NULL;
+            if (card == NULL)
+            {
+                /* Cancellation or completion of an already removed card. */
+                swicc_net_uring_buf_release(&reactor->uring, &cqe);
+                continue;
+            }
+
+            swicc_ret_et ret = send
+                                   ? reactor_uring_sent(card, &cqe)
+                                   : reactor_uring_recvd(reactor, card, &cqe,
+                                                         now);
+            if (ret == SWICC_RET_SUCCESS &&
+                card->swicc_state->shutdown == false)
+            {
+                ret = reactor_uring_arm(reactor, card);
+            }
+            else if (ret == SWICC_RET_SUCCESS)
+            {
+                ret = SWICC_RET_ERROR;
+            }
+            if (ret == SWICC_RET_SUCCESS && card->sched_ready == false &&
+                reactor_uring_tx_fits(card) &&
+                conn_msg_peek(&card->client_ctx->conn) == SWICC_RET_SUCCESS)
+            {
+                /* A send made space for the responses, or held data came in. */
+                reactor_sched_push(reactor, card, now);
+            }
+            if (ret != SWICC_RET_SUCCESS)
+            {
+                swicc_net_reactor_card_remove(reactor, card);
+            }
+        }
+        reactor_sched_run(reactor);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Start a reactor without ready cards and with the default budget.
+ * @param reactor
+ */
+static void reactor_sched_init(swicc_net_reactor_st *const reactor)
+{
+    for (uint32_t prio = 0U; prio < SWICC_NET_REACTOR_PRIO_COUNT; ++prio)
+    {
+        reactor->sched_head[prio] = NULL;
+        reactor->sched_tail[prio] = NULL;
+    }
+    reactor->sched_count = 0U;
+    reactor->budget = SWICC_NET_REACTOR_BUDGET_DEFAULT;
+}
+
+swicc_ret_et swicc_net_reactor_create(swicc_net_reactor_st *const reactor)
+{
+    if (reactor == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    int32_t const fd_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (fd_epoll < 0)
+    {
+        logger("Call to epoll_create1() failed: %s.", strerror(errno));
+        return SWICC_RET_ERROR;
+    }
+    reactor->backend = SWICC_NET_REACTOR_BACKEND_EPOLL;
+    reactor->fd_epoll = fd_epoll;
+    memset(&reactor->uring, 0U, sizeof(reactor->uring));
+    reactor->uring.fd = -1;
+    reactor->uring_slot = NULL;
+    reactor->uring_slot_count = 0U;
+    reactor->card_count = 0U;
+    reactor_sched_init(reactor);
+    reactor->shutdown = false;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_net_reactor_create_uring(
+    swicc_net_reactor_st *const reactor)
+{
+    if (reactor == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    if (swicc_net_uring_create(&reactor->uring) != SWICC_RET_SUCCESS)
+    {
+        logger("Failed to create an io_uring: %s.", strerror(errno));
+        return SWICC_RET_ERROR;
+    }
+    reactor->backend = SWICC_NET_REACTOR_BACKEND_URING;
+    reactor->fd_epoll = -1;
+    reactor->uring_slot = NULL;
+    reactor->uring_slot_count = 0U;
+    reactor->card_count = 0U;
+    reactor_sched_init(reactor);
+    reactor->shutdown = false;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_net_reactor_destroy(swicc_net_reactor_st *const reactor)
+{
+    if (reactor->fd_epoll >= 0)
+    {
+        if (close(reactor->fd_epoll) == -1)
+        {
+            logger("Call to close() failed: %s.", strerror(errno));
+        }
+    }
+    reactor->fd_epoll = -1;
+    if (reactor->backend == SWICC_NET_REACTOR_BACKEND_URING)
+    {
+        swicc_net_uring_destroy(&reactor->uring);
+    }
+    free(reactor->uring_slot);
+    reactor->uring_slot = NULL;
+    reactor->uring_slot_count = 0U;
+    reactor->card_count = 0U;
+}
+
+swicc_ret_et swicc_net_reactor_card_add(swicc_net_reactor_st *const reactor,
+                                        swicc_net_reactor_card_st *const card,
+                                        swicc_st *const swicc_state,
+                                        swicc_net_client_st *const client_ctx)
+{
+    if (reactor == NULL || card == NULL || swicc_state == NULL ||
+        client_ctx == NULL || client_ctx->sock_client < 0)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    card->swicc_state = swicc_state;
+    card->client_ctx = client_ctx;
+    card->connected = false;
+    card->prio = SWICC_NET_REACTOR_PRIO_NORMAL;
+    card->weight = 1U;
+    card->sched_next = NULL;
+    card->sched_time = 0U;
+    card->sched_ready = false;
+
+    swicc_state->buf_rx = NULL;
+    swicc_state->buf_rx_len = 0U;
+    swicc_state->buf_tx = NULL;
+    swicc_state->buf_tx_len = 0U;
+
+    if (reactor->backend == SWICC_NET_REACTOR_BACKEND_URING)
+    {
+        if (reactor_uring_card_add(reactor, card) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+        card->connected = true;
+        reactor->card_count += 1U;
+        return SWICC_RET_SUCCESS;
+    }
+
+    struct epoll_event event = {
+        .events = EPOLLIN | EPOLLRDHUP,
+        .data.ptr = card,
+    };
+    if (epoll_ctl(reactor->fd_epoll, EPOLL_CTL_ADD, client_ctx->sock_client,
+                  &event) != 0)
+    {
+        logger("Call to epoll_ctl() failed: %s.", strerror(errno));
+        return SWICC_RET_ERROR;
+    }
+    card->connected = true;
+    reactor->card_count += 1U;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_net_reactor_card_remove(swicc_net_reactor_st *const reactor,
+                                   swicc_net_reactor_card_st *const card)
+{
+    if (card->connected == false)
+    {
+        return;
+    }
+    if (reactor->backend == SWICC_NET_REACTOR_BACKEND_URING)
+    {
+        swicc_net_reactor_uring_slot_st *const slot =
+            &reactor->uring_slot[card->uring_slot];
+        if ((card->uring_op & SWICC_NET_REACTOR_URING_OP_RECV) != 0U &&
+            swicc_net_uring_cancel(
+                &reactor->uring,
+                reactor_uring_user_data(card->uring_slot, slot->gen, false)) !=
+                SWICC_RET_SUCCESS)
+        {
+            logger("Failed to cancel the receive of a card.");
+        }
+        /**
+         * A send reads from the client, which the user may reuse as soon as
+         * this returns, so it has to be over before.
+         */
+        if ((card->uring_op & SWICC_NET_REACTOR_URING_OP_SEND) != 0U &&
+            swicc_net_uring_cancel_sync(
+                &reactor->uring,
+                reactor_uring_user_data(card->uring_slot, slot->gen, true)) !=
+                SWICC_RET_SUCCESS)
+        {
+            logger("Failed to cancel the send of a card.");
+        }
+        while (card->uring_held_head != SWICC_NET_URING_BUF_ID_NONE)
+        {
+            uint16_t const buf_id = card->uring_held_head;
+            swicc_net_uring_cqe_st const held = {
+                .buf = &reactor->uring.buf[buf_id * SWICC_NET_URING_BUF_SIZE],
+                .buf_id = buf_id,
+            };
+            card->uring_held_head = reactor->uring_held_next[buf_id];
+            swicc_net_uring_buf_release(&reactor->uring, &held);
+        }
+        card->uring_held_tail = SWICC_NET_URING_BUF_ID_NONE;
+        card->uring_op = 0U;
+        /* Completions that are still in flight will be ignored. */
+        slot->card = NULL;
+    }
+    else if (epoll_ctl(reactor->fd_epoll, EPOLL_CTL_DEL,
+                       card->client_ctx->sock_client, NULL) != 0)
+    {
+        logger("Call to epoll_ctl() failed: %s.", strerror(errno));
+    }
+    if (card->sched_ready)
+    {
+        reactor_sched_unlink(reactor, card);
+    }
+    card->connected = false;
+    reactor->card_count -= 1U;
+}
+
+swicc_ret_et swicc_net_reactor_card_sched_set(
+    swicc_net_reactor_st *const reactor, swicc_net_reactor_card_st *const card,
+    swicc_net_reactor_prio_et const prio, uint32_t const weight)
+{
+    if (reactor == NULL || card == NULL ||
+        (uint32_t)prio >= SWICC_NET_REACTOR_PRIO_COUNT || weight == 0U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    card->weight = weight;
+    if (card->sched_ready)
+    {
+        /* A ready card moves to the run queue of its new class. */
+        uint64_t const sched_time = card->sched_time;
+        reactor_sched_unlink(reactor, card);
+        card->prio = prio;
+        reactor_sched_push(reactor, card, sched_time);
+    }
+    else
+    {
+        card->prio = prio;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Receive what is available on the socket of a card and make the card
+ * ready once it has a complete message.
+ * @param reactor
+ * @param card The card whose socket is readable. It must not be ready so that
+ * there is always space to receive into.
+ * @param now When the socket became readable.
+ * @return Return code. Anything other than success means the card has to be
+ * removed from the reactor.
+ */
+static swicc_ret_et reactor_card_readable(swicc_net_reactor_st *const reactor,
+                                          swicc_net_reactor_card_st *const card,
+                                          uint64_t const now)
+{
+    swicc_net_conn_st *const conn = &card->client_ctx->conn;
+    swicc_ret_et const ret_fill =
+        conn_fill(card->client_ctx->sock_client, conn, MSG_DONTWAIT);
+    if (ret_fill == SWICC_RET_NET_MSG_INCOMPLETE)
+    {
+        /* Everything available was consumed already. */
+        return SWICC_RET_SUCCESS;
+    }
+    else if (ret_fill != SWICC_RET_SUCCESS)
+    {
+        return ret_fill;
+    }
+
+    swicc_ret_et const ret_peek = conn_msg_peek(conn);
+    if (ret_peek == SWICC_RET_SUCCESS)
+    {
+        reactor_sched_push(reactor, card, now);
+    }
+    return ret_peek == SWICC_RET_NET_MSG_INCOMPLETE ? SWICC_RET_SUCCESS
+                                                    : ret_peek;
+}
+
+swicc_ret_et swicc_net_reactor_run(swicc_net_reactor_st *const reactor)
+{
+    if (reactor != NULL && reactor->backend == SWICC_NET_REACTOR_BACKEND_URING)
+    {
+        return reactor_run_uring(reactor);
+    }
+    if (reactor == NULL || reactor->fd_epoll < 0)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    struct epoll_event events[SWICC_NET_REACTOR_EVENT_COUNT_MAX];
+    while (reactor->shutdown == false && reactor->card_count > 0U)
+    {
+        /* Ready cards only wait for events that are already there. */
+        int32_t const event_count = epoll_wait(
+            reactor->fd_epoll, events, SWICC_NET_REACTOR_EVENT_COUNT_MAX,
+            reactor->sched_count > 0U ? 0 : SWICC_NET_REACTOR_TIMEOUT);
+        if (event_count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            logger("Call to epoll_wait() failed: %s.", strerror(errno));
+            return SWICC_RET_ERROR;
+        }
+        uint64_t const now = swicc_stats_time();
+
+        /* Safe cast since the event count was checked to not be negative. */
+        for (uint32_t event_idx = 0U; event_idx < (uint32_t)event_count;
+             ++event_idx)
+        {
+            swicc_net_reactor_card_st *const card = events[event_idx].data.ptr;
+            if (card->connected == false)
+            {
+                /* Removed while handling an earlier event of this batch. */
+                continue;
+            }
+            if (card->swicc_state->shutdown == true)
+            {
+                swicc_net_reactor_card_remove(reactor, card);
+            }
+            else if (card->sched_ready)
+            {
+                /**
+                 * The socket is not read until the buffered messages were
+                 * handled, which holds back peers that send faster than their
+                 * card gets turns.
+                 */
+                continue;
+            }
+            else if (reactor_card_readable(reactor, card, now) !=
+                     SWICC_RET_SUCCESS)
+            {
+                swicc_net_reactor_card_remove(reactor, card);
+            }
+        }
+        reactor_sched_run(reactor);
+    }
+    return SWICC_RET_SUCCESS;
 }
@@ -0,0 +1,212 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <stddef.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Signal a change of a ring to the peer, waking it up if it waits.
+ * @param ring
+ */
+static void shm_ring_signal(swicc_net_shm_ring_st *const ring)
+{
+    atomic_fetch_add(&ring->seq, 1U);
+    if (atomic_load(&ring->waiting) > 0U)
+    {
+        syscall(SYS_futex, &ring->seq, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    }
+}
+
+/**
+ * @brief Wait for a ring to change.
+ * @param ring
+ * @param seq The sequence number that was seen before deciding to wait.
+ * @return Return code.
+ */
+static swicc_ret_et shm_ring_wait(swicc_net_shm_ring_st *const ring,
+                                  uint32_t const seq)
+{
+    atomic_fetch_add(&ring->waiting, 1U);
+    long const ret =
+        syscall(SYS_futex, &ring->seq, FUTEX_WAIT, seq, NULL, NULL, 0);
+    int const err = errno;
+    atomic_fetch_sub(&ring->waiting, 1U);
+    if (ret != 0 && err == EINTR)
+    {
+        /* Interrupted e.g. by a signal that requests a shutdown. */
+        return SWICC_RET_ERROR;
+    }
+    /* Woken up or the sequence number changed before waiting. */
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Map the shared memory of a channel.
+ * @param shm
+ * @param name
+ * @param server If creating the channel (server) or opening it (client).
+ * @return Return code.
+ */
+static swicc_ret_et shm_map(swicc_net_shm_st *const shm,
+                            char const *const name, bool const server)
+{
+    if (shm == NULL || name == NULL ||
+        strlen(name) >= SWICC_NET_SHM_NAME_LEN_MAX)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_ret_et ret = SWICC_RET_ERROR;
+    int32_t const fd =
+        shm_open(name, server ? O_RDWR | O_CREAT | O_EXCL : O_RDWR,
+                 S_IRUSR | S_IWUSR);
+    if (fd >= 0)
+    {
+        if (!server || ftruncate(fd, sizeof(swicc_net_shm_region_st)) == 0)
+        {
+            void *const region =
+                mmap(NULL, sizeof(swicc_net_shm_region_st),
+                     PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (region != MAP_FAILED)
+            {
+                shm->region = region;
+                shm->server = server;
+                memset(shm->name, 0U, sizeof(shm->name));
+                strcpy(shm->name, name);
+                ret = SWICC_RET_SUCCESS;
+            }
+        }
+        /* The mapping stays valid after closing the descriptor. */
+        close(fd);
+        if (ret != SWICC_RET_SUCCESS && server)
+        {
+            shm_unlink(name);
+        }
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_net_shm_create(swicc_net_shm_st *const shm,
+                                  char const *const name)
+{
+    swicc_ret_et const ret = shm_map(shm, name, true);
+    if (ret == SWICC_RET_SUCCESS)
+    {
+        /* A new shared memory object is zero-filled so all rings are empty. */
+        atomic_store(&shm->region->closed, 0U);
+    }
+    return ret;
+}
+
+swicc_ret_et swicc_net_shm_open(swicc_net_shm_st *const shm,
+                                char const *const name)
+{
+    return shm_map(shm, name, false);
+}
+
+void swicc_net_shm_destroy(swicc_net_shm_st *const shm)
+{
+    if (shm->region == NULL)
+    {
+        return;
+    }
+    atomic_store(&shm->region->closed, 1U);
+    shm_ring_signal(&shm->region->ring_req);
+    shm_ring_signal(&shm->region->ring_res);
+    munmap(shm->region, sizeof(swicc_net_shm_region_st));
+    if (shm->server)
+    {
+        shm_unlink(shm->name);
+    }
+    shm->region = NULL;
+}
+
+swicc_ret_et swicc_net_shm_send(swicc_net_shm_st *const shm,
+                                swicc_net_msg_st const *const msg)
+{
+    if (shm == NULL || shm->region == NULL || msg == NULL ||
+        msg->hdr.size > sizeof(msg->data))
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_net_shm_ring_st *const ring =
+        shm->server ? &shm->region->ring_req : &shm->region->ring_res;
+    uint32_t const head =
+        atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;)
+    {
+        uint32_t const seq = atomic_load(&ring->seq);
+        if (atomic_load(&shm->region->closed) != 0U)
+        {
+            return SWICC_RET_NET_DISCONNECTED;
+        }
+        if (head - atomic_load(&ring->tail) < SWICC_NET_SHM_RING_LEN)
+        {
+            break;
+        }
+        if (shm_ring_wait(ring, seq) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    /* Only copy the used part of the message. */
+    memcpy(&ring->msg[head % SWICC_NET_SHM_RING_LEN], msg,
+           sizeof(msg->hdr) + msg->hdr.size);
+    atomic_store(&ring->head, head + 1U);
+    shm_ring_signal(ring);
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_net_shm_recv(swicc_net_shm_st *const shm,
+                                swicc_net_msg_st *const msg)
+{
+    if (shm == NULL || shm->region == NULL || msg == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_net_shm_ring_st *const ring =
+        shm->server ? &shm->region->ring_res : &shm->region->ring_req;
+    uint32_t const tail =
+        atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (;;)
+    {
+        uint32_t const seq = atomic_load(&ring->seq);
+        if (atomic_load(&ring->head) != tail)
+        {
+            break;
+        }
+        if (atomic_load(&shm->region->closed) != 0U)
+        {
+            return SWICC_RET_NET_DISCONNECTED;
+        }
+        if (shm_ring_wait(ring, seq) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+
+    swicc_net_msg_st const *const msg_ring =
+        &ring->msg[tail % SWICC_NET_SHM_RING_LEN];
+    /**
+     * The peer can modify the message at any time so the size is read only
+     * once, the same size that was checked is used for the copy.
+     */
+    uint32_t const size = *(uint32_t const volatile *)&msg_ring->hdr.size;
+    if (size > sizeof(msg_ring->data) ||
+        size < offsetof(swicc_net_msg_data_st, buf))
+    {
+        return SWICC_RET_ERROR;
+    }
+    memcpy(msg, msg_ring, sizeof(msg_ring->hdr) + size);
+    msg->hdr.size = size;
+    atomic_store(&ring->tail, tail + 1U);
+    shm_ring_signal(ring);
+    return SWICC_RET_SUCCESS;
+}
@@ -0,0 +1,339 @@
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static_assert((SWICC_NET_URING_BUF_COUNT & (SWICC_NET_URING_BUF_COUNT - 1U)) ==
+                  0U,
+              "Buffer count of io_uring must be a power of 2.");
+static_assert(SWICC_NET_URING_BUF_COUNT <= UINT16_MAX,
+              "Buffer IDs of io_uring are 16-bit.");
+
+/* ID of the group of buffers that receives select from. */
+#define URING_BUF_GROUP 0U
+
+/**
+ * @brief Hand a buffer over to the kernel so receives can use it.
+ * @param uring
+ * @param buf_id
+ */
+static void uring_buf_provide(swicc_net_uring_st *const uring,
+                              uint16_t const buf_id)
+{
+    struct io_uring_buf_ring *const buf_ring = uring->buf_ring;
+    uint16_t const tail = buf_ring->tail;
+    struct io_uring_buf *const buf =
+        &buf_ring->bufs[tail & (SWICC_NET_URING_BUF_COUNT - 1U)];
+    buf->addr =
+        (uint64_t)(uintptr_t)&uring->buf[buf_id * SWICC_NET_URING_BUF_SIZE];
+    buf->len = SWICC_NET_URING_BUF_SIZE;
+    buf->bid = buf_id;
+    /* Safe cast since the tail is meant to wrap around. */
+    __atomic_store_n(&buf_ring->tail, (uint16_t)(tail + 1U), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Get a free submission queue entry, submitting what is queued when
+ * the queue is full.
+ * @param uring
+ * @return The entry (zeroed) or NULL on failure.
+ */
+static struct io_uring_sqe *uring_sqe_get(swicc_net_uring_st *const uring)
+{
+    uint32_t const tail = *uring->sq_tail;
+    if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >=
+        uring->sq_entries)
+    {
+        if (syscall(__NR_io_uring_enter, uring->fd, uring->to_submit, 0U, 0U,
+                    NULL, 0U) < 0)
+        {
+            return NULL;
+        }
+        uring->to_submit = 0U;
+        if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >=
+            uring->sq_entries)
+        {
+            return NULL;
+        }
+    }
+    uint32_t const idx = tail & *uring->sq_mask;
+    struct io_uring_sqe *const sqe = &((struct io_uring_sqe *)uring->sqe)[idx];
+    memset(sqe, 0U, sizeof(*sqe));
+    uring->sq_array[idx] = idx;
+    __atomic_store_n(uring->sq_tail, tail + 1U, __ATOMIC_RELEASE);
+    uring->to_submit += 1U;
+    return sqe;
+}
+
+swicc_ret_et swicc_net_uring_create(swicc_net_uring_st *const uring)
+{
+    memset(uring, 0U, sizeof(*uring));
+    uring->fd = -1;
+
+    struct io_uring_params params;
+    memset(&params, 0U, sizeof(params));
+    int64_t const fd =
+        syscall(__NR_io_uring_setup, SWICC_NET_URING_ENTRY_COUNT, &params);
+    if (fd < 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+    /* Safe cast since file descriptors fit in an int. */
+    uring->fd = (int32_t)fd;
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0U ||
+        (params.features & IORING_FEAT_EXT_ARG) == 0U)
+    {
+        /* Kernel is too old. */
+        swicc_net_uring_destroy(uring);
+        return SWICC_RET_ERROR;
+    }
+
+    size_t const sq_size =
+        params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t const cq_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    uring->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    uring->ring =
+        mmap(NULL, uring->ring_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+    if (uring->ring == MAP_FAILED)
+    {
+        uring->ring = NULL;
+        swicc_net_uring_destroy(uring);
+        return SWICC_RET_ERROR;
+    }
+    uring->sqe_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sqe = mmap(NULL, uring->sqe_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+    if (uring->sqe == MAP_FAILED)
+    {
+        uring->sqe = NULL;
+        swicc_net_uring_destroy(uring);
+        return SWICC_RET_ERROR;
+    }
+
+    uint8_t *const ring = uring->ring;
+    uring->sq_entries = params.sq_entries;
+    uring->sq_head = (uint32_t *)&ring[params.sq_off.head];
+    uring->sq_tail = (uint32_t *)&ring[params.sq_off.tail];
+    uring->sq_mask = (uint32_t *)&ring[params.sq_off.ring_mask];
+    uring->sq_array = (uint32_t *)&ring[params.sq_off.array];
+    uring->cq_head = (uint32_t *)&ring[params.cq_off.head];
+    uring->cq_tail = (uint32_t *)&ring[params.cq_off.tail];
+    uring->cq_mask = (uint32_t *)&ring[params.cq_off.ring_mask];
+    uring->cqe = &ring[params.cq_off.cqes];
+
+    /* The buffer ring has to be page aligned so it gets its own mapping. */
+    uring->buf_ring_size =
+        SWICC_NET_URING_BUF_COUNT * sizeof(struct io_uring_buf);
+    uring->buf_ring = mmap(NULL, uring->buf_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uring->buf = malloc(SWICC_NET_URING_BUF_COUNT * SWICC_NET_URING_BUF_SIZE);
+    if (uring->buf_ring == MAP_FAILED || uring->buf == NULL)
+    {
+        if (uring->buf_ring == MAP_FAILED)
+        {
+            uring->buf_ring = NULL;
+        }
+        swicc_net_uring_destroy(uring);
+        return SWICC_RET_ERROR;
+    }
+    struct io_uring_buf_reg buf_reg;
+    memset(&buf_reg, 0U, sizeof(buf_reg));
+    buf_reg.ring_addr = (uint64_t)(uintptr_t)uring->buf_ring;
+    buf_reg.ring_entries = SWICC_NET_URING_BUF_COUNT;
+    buf_reg.bgid = URING_BUF_GROUP;
+    if (syscall(__NR_io_uring_register, uring->fd, IORING_REGISTER_PBUF_RING,
+                &buf_reg, 1U) != 0)
+    {
+        swicc_net_uring_destroy(uring);
+        return SWICC_RET_ERROR;
+    }
+    for (uint16_t buf_id = 0U; buf_id < SWICC_NET_URING_BUF_COUNT; ++buf_id)
+    {
+        uring_buf_provide(uring, buf_id);
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_net_uring_destroy(swicc_net_uring_st *const uring)
+{
+    /* Closing the ring cancels everything that is still in flight. */
+    if (uring->fd >= 0)
+    {
+        close(uring->fd);
+    }
+    if (uring->ring != NULL)
+    {
+        munmap(uring->ring, uring->ring_size);
+    }
+    if (uring->sqe != NULL)
+    {
+        munmap(uring->sqe, uring->sqe_size);
+    }
+    if (uring->buf_ring != NULL)
+    {
+        munmap(uring->buf_ring, uring->buf_ring_size);
+    }
+    free(uring->buf);
+    memset(uring, 0U, sizeof(*uring));
+    uring->fd = -1;
+}
+
+swicc_ret_et swicc_net_uring_recv(swicc_net_uring_st *const uring,
+                                  int32_t const sock, uint64_t const user_data)
+{
+    struct io_uring_sqe *const sqe = uring_sqe_get(uring);
+    if (sqe == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sock;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    sqe->user_data = user_data;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_net_uring_send(swicc_net_uring_st *const uring,
+                                  int32_t const sock, uint8_t const *const buf,
+                                  uint32_t const buf_len,
+                                  uint64_t const user_data)
+{
+    struct io_uring_sqe *const sqe = uring_sqe_get(uring);
+    if (sqe == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = sock;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = buf_len;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = user_data;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_net_uring_cancel(swicc_net_uring_st *const uring,
+                                    uint64_t const user_data)
+{
+    struct io_uring_sqe *const sqe = uring_sqe_get(uring);
+    if (sqe == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = SWICC_NET_URING_USER_DATA_NONE;
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_net_uring_cancel_sync(swicc_net_uring_st *const uring,
+                                         uint64_t const user_data)
+{
+    /* The kernel only knows about operations that were submitted. */
+    if (uring->to_submit > 0U)
+    {
+        int64_t const ret = syscall(__NR_io_uring_enter, uring->fd,
+                                    uring->to_submit, 0U, 0U, NULL, 0U);
+        if (ret < 0)
+        {
+            return SWICC_RET_ERROR;
+        }
+        /* Safe cast since at most 'to_submit' entries are submitted. */
+        uring->to_submit -= (uint32_t)ret;
+        if (uring->to_submit > 0U)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+    struct io_uring_sync_cancel_reg const reg = {
+        .addr = user_data,
+        .fd = -1,
+        .flags = 0U,
+        /* Wait for as long as it takes. */
+        .timeout = {.tv_sec = -1, .tv_nsec = -1},
+    };
+    if (syscall(__NR_io_uring_register, uring->fd, IORING_REGISTER_SYNC_CANCEL,
+                &reg, 1U) < 0 &&
+        errno != ENOENT)
+    {
+        return SWICC_RET_ERROR;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+swicc_ret_et swicc_net_uring_wait(swicc_net_uring_st *const uring,
+                                  uint32_t const timeout_ms)
+{
+    struct __kernel_timespec const timeout = {
+        .tv_sec = timeout_ms / 1000U,
+        .tv_nsec = (timeout_ms % 1000U) * 1000000U,
+    };
+    struct io_uring_getevents_arg const arg = {
+        .sigmask = 0U,
+        .sigmask_sz = 0U,
+        .pad = 0U,
+        .ts = (uint64_t)(uintptr_t)&timeout,
+    };
+    /* Only block when nothing is completed yet. */
+    uint32_t const wait_count =
+        __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE) == *uring->cq_head
+            ? 1U
+            : 0U;
+    int64_t const ret = syscall(
+        __NR_io_uring_enter, uring->fd, uring->to_submit, wait_count,
+        IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret < 0 && errno != ETIME && errno != EINTR)
+    {
+        return SWICC_RET_ERROR;
+    }
+    if (ret > 0)
+    {
+        /* Safe cast since at most 'to_submit' entries are submitted. */
+        uring->to_submit -= (uint32_t)ret;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+bool swicc_net_uring_next(swicc_net_uring_st *const uring,
+                          swicc_net_uring_cqe_st *const cqe)
+{
+    uint32_t const head = *uring->cq_head;
+    if (head == __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+    struct io_uring_cqe const *const cqe_ring =
+        &((struct io_uring_cqe *)uring->cqe)[head & *uring->cq_mask];
+    cqe->user_data = cqe_ring->user_data;
+    cqe->res = cqe_ring->res;
+    cqe->more = (cqe_ring->flags & IORING_CQE_F_MORE) != 0U;
+    cqe->buf = NULL;
+    if ((cqe_ring->flags & IORING_CQE_F_BUFFER) != 0U)
+    {
+        /* Safe cast since buffer IDs are 16-bit. */
+        cqe->buf_id = (uint16_t)(cqe_ring->flags >> IORING_CQE_BUFFER_SHIFT);
+        cqe->buf = &uring->buf[cqe->buf_id * SWICC_NET_URING_BUF_SIZE];
+    }
+    __atomic_store_n(uring->cq_head, head + 1U, __ATOMIC_RELEASE);
+    return true;
+}
+
+void swicc_net_uring_buf_release(swicc_net_uring_st *const uring,
+                                 swicc_net_uring_cqe_st const *const cqe)
+{
+    if (cqe->buf != NULL)
+    {
+        uring_buf_provide(uring, cqe->buf_id);
+    }
+}
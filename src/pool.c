@@ -0,0 +1,86 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <swicc/swicc.h>
+
+static _Thread_local swicc_pool_st pool_thread;
+static _Thread_local bool pool_thread_init = false;
+
+/* Only used to be told when a thread exits. */
+static pthread_key_t pool_thread_key;
+static pthread_once_t pool_thread_key_once = PTHREAD_ONCE_INIT;
+
+void swicc_pool_init(swicc_pool_st *const pool, uint32_t const buf_size,
+                     uint32_t const free_count_max)
+{
+    pool->free = NULL;
+    pool->free_count = 0U;
+    pool->free_count_max = free_count_max;
+    pool->buf_size = buf_size > sizeof(void *) ? buf_size : sizeof(void *);
+}
+
+void *swicc_pool_get(swicc_pool_st *const pool)
+{
+    void *const buf = pool->free;
+    if (buf == NULL)
+    {
+        return malloc(pool->buf_size);
+    }
+    pool->free = *(void **)buf;
+    pool->free_count -= 1U;
+    return buf;
+}
+
+void swicc_pool_put(swicc_pool_st *const pool, void *const buf)
+{
+    if (buf == NULL)
+    {
+        return;
+    }
+    if (pool->free_count >= pool->free_count_max)
+    {
+        free(buf);
+        return;
+    }
+    *(void **)buf = pool->free;
+    pool->free = buf;
+    pool->free_count += 1U;
+}
+
+void swicc_pool_empty(swicc_pool_st *const pool)
+{
+    while (pool->free != NULL)
+    {
+        void *const buf_next = *(void **)pool->free;
+        free(pool->free);
+        pool->free = buf_next;
+    }
+    pool->free_count = 0U;
+}
+
+/**
+ * @brief Free the free buffers of the pool of a thread which is exiting.
+ * @param pool
+ */
+static void pool_thread_exit(void *const pool)
+{
+    swicc_pool_empty(pool);
+}
+
+static void pool_thread_key_create(void)
+{
+    /* Without the key, buffers of exiting threads are leaked (not fatal). */
+    (void)pthread_key_create(&pool_thread_key, pool_thread_exit);
+}
+
+swicc_pool_st *swicc_pool_thread(void)
+{
+    if (!pool_thread_init)
+    {
+        swicc_pool_init(&pool_thread, SWICC_POOL_BUF_SIZE,
+                        SWICC_POOL_THREAD_FREE_COUNT_MAX);
+        pthread_once(&pool_thread_key_once, pool_thread_key_create);
+        (void)pthread_setspecific(pool_thread_key, &pool_thread);
+        pool_thread_init = true;
+    }
+    return &pool_thread;
+}
@@ -54,9 +54,9 @@ static swicc_ret_et pps_parse(swicc_pps_params_st *const pps_params,
             switch (pps_idx)
             {
             case 1:
-                /* PPS1 */
-                pps_params->fi_idx = ppsi & 0x0F;
-                pps_params->di_idx = (ppsi & 0xF0) >> 4U;
+                /* PPS1 holds FI in the high nibble and DI in the low one. */
+                pps_params->fi_idx = (ppsi & 0xF0) >> 4U;
+                pps_params->di_idx = ppsi & 0x0F;
                 break;
             case 2:
                 /* PPS2 */
@@ -108,6 +108,15 @@ static swicc_ret_et pps_deparse(swicc_pps_params_st *const pps_params,
     ppsi[ppsi_next++] = SWICC_PPS_PPSS;
     ppsi[ppsi_next++] = pps0; /* PPS0 */
 
+    if (pps_params->t != 0U && pps_params->t != 1U)
+    {
+        /**
+         * Only T=0 and T=1 are offered in the ATR so the response indicates the
+         * default protocol instead, this makes the exchange fail.
+         */
+        ppsi[1U] &= 0xF0;
+    }
+
     if ((pps_params->fi_idx == SWICC_TP_CONF_DEFAULT &&
          pps_params->di_idx == SWICC_TP_CONF_DEFAULT) ||
         (pps0 & 0b00010000) == 0 /* PPS1 was not present? */)
@@ -123,7 +132,7 @@ static swicc_ret_et pps_deparse(swicc_pps_params_st *const pps_params,
         assert((pps_params->fi_idx & 0xF0) == 0U);
         assert((pps_params->di_idx & 0xF0) == 0U);
         ppsi[ppsi_next++] =
-            (uint8_t)(pps_params->di_idx << 4U) | pps_params->fi_idx; /* PPS1 */
+            (uint8_t)(pps_params->fi_idx << 4U) | pps_params->di_idx; /* PPS1 */
     }
 
     if (pps0 & 0b00100000)
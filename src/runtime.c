@@ -0,0 +1,183 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <signal.h>
+#include <swicc/swicc.h>
+#include <unistd.h>
+
+/**
+ * @brief Entry point of a worker thread.
+ * @param arg The shard driven by the worker.
+ * @return Always NULL, the result is in the shard.
+ */
+static void *runtime_worker(void *const arg)
+{
+    swicc_runtime_shard_st *const shard = arg;
+    if (shard->logger != NULL)
+    {
+        swicc_net_logger_register_thread(shard->logger);
+    }
+    shard->ret = swicc_net_reactor_run(&shard->reactor);
+    return NULL;
+}
+
+swicc_ret_et swicc_runtime_create(swicc_runtime_st *const runtime,
+                                  uint32_t const shard_count)
+{
+    if (runtime == NULL)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    int64_t const core_count = sysconf(_SC_NPROCESSORS_ONLN);
+    /* Safe cast since the core count is checked to be in range of uint32. */
+    uint32_t const core_count_valid =
+        core_count > 0 && core_count <= UINT32_MAX ? (uint32_t)core_count : 1U;
+    uint32_t const shard_count_valid =
+        shard_count > 0U ? shard_count : core_count_valid;
+    if (shard_count_valid > SWICC_RUNTIME_SHARD_COUNT_MAX)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    runtime->shard_count = 0U;
+    runtime->running = false;
+    for (uint32_t shard_idx = 0U; shard_idx < shard_count_valid; ++shard_idx)
+    {
+        swicc_runtime_shard_st *const shard = &runtime->shard[shard_idx];
+        if (swicc_net_reactor_create(&shard->reactor) != SWICC_RET_SUCCESS)
+        {
+            swicc_runtime_destroy(runtime);
+            return SWICC_RET_ERROR;
+        }
+        shard->core = shard_idx % core_count_valid;
+        shard->logger = NULL;
+        shard->ret = SWICC_RET_SUCCESS;
+        runtime->shard_count = shard_idx + 1U;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_runtime_destroy(swicc_runtime_st *const runtime)
+{
+    for (uint32_t shard_idx = 0U; shard_idx < runtime->shard_count;
+         ++shard_idx)
+    {
+        swicc_net_reactor_destroy(&runtime->shard[shard_idx].reactor);
+    }
+    runtime->shard_count = 0U;
+}
+
+swicc_ret_et swicc_runtime_card_add(swicc_runtime_st *const runtime,
+                                    swicc_net_reactor_card_st *const card,
+                                    swicc_st *const swicc_state,
+                                    swicc_net_client_st *const client_ctx)
+{
+    if (runtime == NULL || runtime->shard_count == 0U ||
+        runtime->running == true)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    /* The number of cards is used as the load of a shard. */
+    swicc_runtime_shard_st *shard = &runtime->shard[0U];
+    for (uint32_t shard_idx = 1U; shard_idx < runtime->shard_count;
+         ++shard_idx)
+    {
+        if (runtime->shard[shard_idx].reactor.card_count <
+            shard->reactor.card_count)
+        {
+            shard = &runtime->shard[shard_idx];
+        }
+    }
+    return swicc_net_reactor_card_add(&shard->reactor, card, swicc_state,
+                                      client_ctx);
+}
+
+swicc_ret_et swicc_runtime_start(swicc_runtime_st *const runtime)
+{
+    if (runtime == NULL || runtime->running == true)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    /* Workers inherit the signal mask so block the signals while spawning. */
+    sigset_t sig_block;
+    sigset_t sig_old;
+    sigemptyset(&sig_block);
+    sigaddset(&sig_block, SIGINT);
+    sigaddset(&sig_block, SIGHUP);
+    sigaddset(&sig_block, SIGTERM);
+    if (pthread_sigmask(SIG_BLOCK, &sig_block, &sig_old) != 0)
+    {
+        return SWICC_RET_ERROR;
+    }
+
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    uint32_t shard_idx = 0U;
+    for (; shard_idx < runtime->shard_count; ++shard_idx)
+    {
+        swicc_runtime_shard_st *const shard = &runtime->shard[shard_idx];
+        shard->reactor.shutdown = false;
+        if (pthread_create(&shard->thread, NULL, runtime_worker, shard) != 0)
+        {
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+
+        /* Pinning is only an optimization so a failure is not fatal. */
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(shard->core, &cpu_set);
+        pthread_setaffinity_np(shard->thread, sizeof(cpu_set), &cpu_set);
+    }
+    pthread_sigmask(SIG_SETMASK, &sig_old, NULL);
+
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        /* Stop the workers that were already started. */
+        for (uint32_t shard_started = 0U; shard_started < shard_idx;
+             ++shard_started)
+        {
+            runtime->shard[shard_started].reactor.shutdown = true;
+        }
+        for (uint32_t shard_started = 0U; shard_started < shard_idx;
+             ++shard_started)
+        {
+            pthread_join(runtime->shard[shard_started].thread, NULL);
+        }
+        return ret;
+    }
+    runtime->running = true;
+    return SWICC_RET_SUCCESS;
+}
+
+void swicc_runtime_stop(swicc_runtime_st *const runtime)
+{
+    for (uint32_t shard_idx = 0U; shard_idx < runtime->shard_count;
+         ++shard_idx)
+    {
+        runtime->shard[shard_idx].reactor.shutdown = true;
+    }
+}
+
+swicc_ret_et swicc_runtime_wait(swicc_runtime_st *const runtime)
+{
+    if (runtime == NULL || runtime->running == false)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    for (uint32_t shard_idx = 0U; shard_idx < runtime->shard_count;
+         ++shard_idx)
+    {
+        swicc_runtime_shard_st *const shard = &runtime->shard[shard_idx];
+        if (pthread_join(shard->thread, NULL) != 0 ||
+            shard->ret != SWICC_RET_SUCCESS)
+        {
+            ret = SWICC_RET_ERROR;
+        }
+    }
+    runtime->running = false;
+    return ret;
+}
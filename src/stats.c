@@ -0,0 +1,331 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <time.h>
+
+/* Exported names of the CLA types, same order as 'swicc_apdu_cla_type_et'. */
+static char const *const stats_cla_type_name[SWICC_STATS_CLA_TYPE_COUNT] = {
+    "invalid",
+    "interindustry",
+    "proprietary",
+    "rfu",
+};
+
+/* Exported names of the FSM states, same order as 'swicc_fsm_state_et'. */
+static char const *const stats_fsm_state_name[SWICC_STATS_FSM_STATE_COUNT] = {
+    "off",
+    "activation",
+    "reset_cold",
+    "atr_req",
+    "atr_res",
+    "reset_warm",
+    "pps_req",
+    "cmd_wait",
+    "cmd_procedure",
+    "cmd_data",
+    "block",
+};
+
+/* Where the text of an export is written to. */
+typedef struct stats_prom_buf_s
+{
+    char *buf;
+    uint32_t size;
+    uint32_t len;
+    bool full;
+} stats_prom_buf_st;
+
+/**
+ * @brief Append formatted text to an export.
+ * @param buf
+ * @param fmt
+ */
+static void stats_prom_printf(stats_prom_buf_st *const buf,
+                              char const *const fmt, ...)
+{
+    if (buf->full)
+    {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int const len =
+        vsnprintf(&buf->buf[buf->len], buf->size - buf->len, fmt, args);
+    va_end(args);
+    /* Safe cast since the length is checked to be positive. */
+    if (len < 0 || (uint32_t)len >= buf->size - buf->len)
+    {
+        buf->full = true;
+        return;
+    }
+    buf->len += (uint32_t)len;
+}
+
+static uint64_t stats_load(swicc_stats_ctr_kt const *const ctr)
+{
+    return atomic_load_explicit(ctr, memory_order_relaxed);
+}
+
+/**
+ * @brief Get the bucket of a latency histogram a latency falls into.
+ * @param time Latency in nanoseconds.
+ * @return Index of the bucket.
+ */
+static uint32_t stats_bucket(uint64_t const time)
+{
+    /* Bucket is the index of the highest bit set, capped to the last one. */
+    uint32_t bucket = 0U;
+    if (time > 1U)
+    {
+        /* Safe cast since the result is in 0..63. */
+        bucket = 63U - (uint32_t)__builtin_clzll(time);
+        if (bucket >= SWICC_STATS_LAT_BUCKET_COUNT)
+        {
+            bucket = SWICC_STATS_LAT_BUCKET_COUNT - 1U;
+        }
+    }
+    return bucket;
+}
+
+void swicc_stats_reset(swicc_stats_st *const stats)
+{
+    memset(stats, 0U, sizeof(*stats));
+}
+
+void swicc_stats_add(swicc_stats_ctr_kt *const ctr, uint64_t const val)
+{
+    /**
+     * There is only one writer so this does not have to be an atomic
+     * read-modify-write, it only has to be free of torn reads and writes.
+     */
+    atomic_store_explicit(
+        ctr, atomic_load_explicit(ctr, memory_order_relaxed) + val,
+        memory_order_relaxed);
+}
+
+void swicc_stats_max(swicc_stats_ctr_kt *const ctr, uint64_t const val)
+{
+    if (val > atomic_load_explicit(ctr, memory_order_relaxed))
+    {
+        atomic_store_explicit(ctr, val, memory_order_relaxed);
+    }
+}
+
+uint64_t swicc_stats_time(void)
+{
+    struct timespec time;
+    if (clock_gettime(CLOCK_MONOTONIC, &time) != 0)
+    {
+        return 0U;
+    }
+    /* Safe cast since the monotonic time is never negative. */
+    return (uint64_t)time.tv_sec * 1000000000U + (uint64_t)time.tv_nsec;
+}
+
+void swicc_stats_handler(swicc_stats_st *const stats, uint8_t const cla_type,
+                         uint8_t const ins, uint64_t const time)
+{
+    swicc_stats_add(&stats->cmd_ins_time[cla_type][ins], time);
+    swicc_stats_max(&stats->cmd_ins_time_max[cla_type][ins], time);
+
+    uint32_t const bucket = stats_bucket(time);
+    swicc_stats_add(&stats->lat[bucket], 1U);
+    swicc_stats_add(&stats->lat_sum, time);
+}
+
+void swicc_stats_sched(swicc_stats_st *const stats, uint64_t const delay)
+{
+    swicc_stats_add(&stats->sched_delay[stats_bucket(delay)], 1U);
+    swicc_stats_add(&stats->sched_delay_sum, delay);
+}
+
+void swicc_stats_snapshot(swicc_stats_st *const snapshot,
+                          swicc_stats_st *const *const stats,
+                          uint32_t const stats_count)
+{
+    static_assert(sizeof(swicc_stats_st) % sizeof(swicc_stats_ctr_kt) == 0U,
+                  "Stats block is expected to only hold counters.");
+    static_assert(offsetof(swicc_stats_st, cmd_ins_time_max) %
+                          sizeof(swicc_stats_ctr_kt) ==
+                      0U,
+                  "Counters of the stats block are expected to be packed.");
+    /**
+     * All the members are counters so the blocks get aggregated as arrays of
+     * counters where only the maximums are not summed up.
+     */
+    size_t const ctr_count =
+        sizeof(swicc_stats_st) / sizeof(swicc_stats_ctr_kt);
+    size_t const max_first =
+        offsetof(swicc_stats_st, cmd_ins_time_max) / sizeof(swicc_stats_ctr_kt);
+    size_t const max_count =
+        sizeof(snapshot->cmd_ins_time_max) / sizeof(swicc_stats_ctr_kt);
+    swicc_stats_reset(snapshot);
+    swicc_stats_ctr_kt *const ctr_dst = (swicc_stats_ctr_kt *)snapshot;
+    for (uint32_t stats_idx = 0U; stats_idx < stats_count; ++stats_idx)
+    {
+        swicc_stats_ctr_kt const *const ctr_src =
+            (swicc_stats_ctr_kt const *)stats[stats_idx];
+        for (size_t ctr_idx = 0U; ctr_idx < ctr_count; ++ctr_idx)
+        {
+            uint64_t const val = stats_load(&ctr_src[ctr_idx]);
+            if (ctr_idx >= max_first && ctr_idx < max_first + max_count)
+            {
+                swicc_stats_max(&ctr_dst[ctr_idx], val);
+            }
+            else
+            {
+                swicc_stats_add(&ctr_dst[ctr_idx], val);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Append a latency histogram to an export.
+ * @param buf
+ * @param name Name of the histogram.
+ * @param bucket Counters of the buckets.
+ * @param sum Sum of the latencies in nanoseconds.
+ */
+static void stats_prom_hist(stats_prom_buf_st *const buf,
+                            char const *const name,
+                            swicc_stats_ctr_kt const *const bucket,
+                            swicc_stats_ctr_kt const *const sum)
+{
+    /* The buckets of Prometheus histograms are cumulative. */
+    stats_prom_printf(buf, "# TYPE %s histogram\n", name);
+    uint64_t count = 0U;
+    for (uint32_t bucket_idx = 0U;
+         bucket_idx < SWICC_STATS_LAT_BUCKET_COUNT - 1U; ++bucket_idx)
+    {
+        count += stats_load(&bucket[bucket_idx]);
+        stats_prom_printf(buf, "%s_bucket{le=\"%.9f\"} %llu\n", name,
+                          (double)(2ULL << bucket_idx) / 1e9,
+                          (unsigned long long)count);
+    }
+    count += stats_load(&bucket[SWICC_STATS_LAT_BUCKET_COUNT - 1U]);
+    stats_prom_printf(buf,
+                      "%s_bucket{le=\"+Inf\"} %llu\n"
+                      "%s_sum %.9f\n"
+                      "%s_count %llu\n",
+                      name, (unsigned long long)count, name,
+                      (double)stats_load(sum) / 1e9, name,
+                      (unsigned long long)count);
+}
+
+swicc_ret_et swicc_stats_prom(swicc_stats_st const *const stats,
+                              char *const buf, uint32_t *const buf_len)
+{
+    if (*buf_len == 0U)
+    {
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+    stats_prom_buf_st out = {.buf = buf, .size = *buf_len};
+    out.buf[0U] = '\0';
+
+    stats_prom_printf(&out, "# TYPE swicc_cmd_cla_total counter\n");
+    for (uint32_t cla_type = 0U; cla_type < SWICC_STATS_CLA_TYPE_COUNT;
+         ++cla_type)
+    {
+        stats_prom_printf(&out, "swicc_cmd_cla_total{cla=\"%s\"} %llu\n",
+                          stats_cla_type_name[cla_type],
+                          (unsigned long long)stats_load(
+                              &stats->cmd_cla[cla_type]));
+    }
+
+    /* Handlers of interindustry and proprietary classes. */
+    stats_prom_printf(&out, "# TYPE swicc_cmd_total counter\n"
+                            "# TYPE swicc_cmd_seconds_total counter\n"
+                            "# TYPE swicc_cmd_seconds_max gauge\n");
+    for (uint32_t cla_type = 0U; cla_type < SWICC_APDUH_CLA_TYPE_COUNT;
+         ++cla_type)
+    {
+        char const *const cla_name =
+            stats_cla_type_name[SWICC_APDU_CLA_TYPE_INTERINDUSTRY + cla_type];
+        for (uint32_t ins = 0U; ins < SWICC_APDUH_INS_COUNT; ++ins)
+        {
+            uint64_t const count = stats_load(&stats->cmd_ins[cla_type][ins]);
+            uint64_t const time =
+                stats_load(&stats->cmd_ins_time[cla_type][ins]);
+            if (count == 0U && time == 0U)
+            {
+                continue;
+            }
+            stats_prom_printf(
+                &out,
+                "swicc_cmd_total{cla=\"%s\",ins=\"%02X\"} %llu\n"
+                "swicc_cmd_seconds_total{cla=\"%s\",ins=\"%02X\"} %.9f\n"
+                "swicc_cmd_seconds_max{cla=\"%s\",ins=\"%02X\"} %.9f\n",
+                cla_name, ins, (unsigned long long)count, cla_name, ins,
+                (double)time / 1e9, cla_name, ins,
+                (double)stats_load(&stats->cmd_ins_time_max[cla_type][ins]) /
+                    1e9);
+        }
+    }
+
+    stats_prom_printf(&out, "# TYPE swicc_sw1_total counter\n");
+    for (uint32_t sw1 = 0U; sw1 <= UINT8_MAX; ++sw1)
+    {
+        uint64_t const count = stats_load(&stats->sw1[sw1]);
+        if (count > 0U)
+        {
+            stats_prom_printf(&out, "swicc_sw1_total{sw1=\"%02X\"} %llu\n", sw1,
+                              (unsigned long long)count);
+        }
+    }
+    stats_prom_printf(&out, "# TYPE swicc_sw_total counter\n");
+    for (uint32_t sw1_idx = 0U; sw1_idx < SWICC_STATS_SW2_SW1_COUNT; ++sw1_idx)
+    {
+        for (uint32_t sw2 = 0U; sw2 <= UINT8_MAX; ++sw2)
+        {
+            uint64_t const count = stats_load(&stats->sw2[sw1_idx][sw2]);
+            if (count > 0U)
+            {
+                stats_prom_printf(
+                    &out, "swicc_sw_total{sw1=\"%02X\",sw2=\"%02X\"} %llu\n",
+                    SWICC_STATS_SW2_SW1_FIRST + sw1_idx, sw2,
+                    (unsigned long long)count);
+            }
+        }
+    }
+
+    stats_prom_hist(&out, "swicc_handler_seconds", stats->lat,
+                    &stats->lat_sum);
+
+    stats_prom_printf(&out, "# TYPE swicc_fsm_transition_total counter\n");
+    for (uint32_t state = 0U; state < SWICC_STATS_FSM_STATE_COUNT; ++state)
+    {
+        stats_prom_printf(&out,
+                          "swicc_fsm_transition_total{state=\"%s\"} %llu\n",
+                          stats_fsm_state_name[state],
+                          (unsigned long long)stats_load(&stats->fsm[state]));
+    }
+
+    stats_prom_printf(
+        &out,
+        "# TYPE swicc_reset_total counter\n"
+        "swicc_reset_total %llu\n"
+        "# TYPE swicc_net_messages_total counter\n"
+        "swicc_net_messages_total{dir=\"rx\"} %llu\n"
+        "swicc_net_messages_total{dir=\"tx\"} %llu\n"
+        "# TYPE swicc_net_bytes_total counter\n"
+        "swicc_net_bytes_total{dir=\"rx\"} %llu\n"
+        "swicc_net_bytes_total{dir=\"tx\"} %llu\n",
+        (unsigned long long)stats_load(&stats->reset),
+        (unsigned long long)stats_load(&stats->net_rx_msg),
+        (unsigned long long)stats_load(&stats->net_tx_msg),
+        (unsigned long long)stats_load(&stats->net_rx_byte),
+        (unsigned long long)stats_load(&stats->net_tx_byte));
+
+    stats_prom_hist(&out, "swicc_sched_delay_seconds", stats->sched_delay,
+                    &stats->sched_delay_sum);
+    stats_prom_printf(&out,
+                      "# TYPE swicc_sched_yield_total counter\n"
+                      "swicc_sched_yield_total %llu\n",
+                      (unsigned long long)stats_load(&stats->sched_yield));
+
+    *buf_len = out.len;
+    return out.full ? SWICC_RET_BUFFER_TOO_SHORT : SWICC_RET_SUCCESS;
+}
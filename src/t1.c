@@ -0,0 +1,322 @@
+#include <string.h>
+#include <swicc/swicc.h>
+
+/**
+ * Bits of the PCB (protocol control byte) of the block types.
+ * ISO/IEC 7816-3:2006 clause.11.3.2.2.
+ */
+#define T1_PCB_I_NS 0x40U
+#define T1_PCB_I_MORE 0x20U
+#define T1_PCB_R 0x80U
+#define T1_PCB_R_NR 0x10U
+#define T1_PCB_R_ERR_EDC 0x01U
+#define T1_PCB_R_ERR_OTHER 0x02U
+#define T1_PCB_S 0xC0U
+#define T1_PCB_S_RES 0x20U
+#define T1_PCB_S_RESYNCH 0x00U
+#define T1_PCB_S_IFS 0x01U
+#define T1_PCB_S_ABORT 0x02U
+#define T1_PCB_S_WTX 0x03U
+
+void swicc_t1_reset(swicc_t1_st *const t1)
+{
+    memset(t1, 0U, sizeof(*t1));
+    t1->ifsc = SWICC_T1_IFSC;
+    t1->ifsd = SWICC_T1_IFS_DEFAULT;
+}
+
+swicc_ret_et swicc_t1_blk_len(uint8_t const *const blk, uint16_t const blk_len,
+                              uint16_t *const blk_len_exp)
+{
+    if (blk_len < SWICC_T1_PROLOGUE_LEN)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    /* The LEN byte is followed by the information field and the LRC. */
+    *blk_len_exp = (uint16_t)(SWICC_T1_PROLOGUE_LEN + blk[2U] + 1U);
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Create a block to send, a copy of it is kept for retransmission.
+ * @param t1
+ * @param nad Node address of the received block, the addresses get swapped.
+ * @param pcb
+ * @param inf Information field.
+ * @param inf_len Length of the information field.
+ * @param buf_tx
+ * @param buf_tx_len
+ * @return Return code.
+ */
+static swicc_ret_et t1_blk_write(swicc_t1_st *const t1, uint8_t const nad,
+                                 uint8_t const pcb, uint8_t const *const inf,
+                                 uint8_t const inf_len, uint8_t *const buf_tx,
+                                 uint16_t *const buf_tx_len)
+{
+    /* Safe cast since the information field is at most 254 bytes long. */
+    uint16_t const blk_len =
+        (uint16_t)(SWICC_T1_PROLOGUE_LEN + inf_len + 1U);
+    if (inf_len > SWICC_T1_IFS_MAX || *buf_tx_len < blk_len)
+    {
+        return SWICC_RET_BUFFER_TOO_SHORT;
+    }
+    /* SAD and DAD of the response are the DAD and SAD of the request. */
+    t1->blk_tx[0U] =
+        (uint8_t)(((nad & 0x07U) << 4U) | ((nad >> 4U) & 0x07U));
+    t1->blk_tx[1U] = pcb;
+    t1->blk_tx[2U] = inf_len;
+    if (inf_len > 0U)
+    {
+        memcpy(&t1->blk_tx[SWICC_T1_PROLOGUE_LEN], inf, inf_len);
+    }
+    /* The epilogue is an LRC i.e. the XOR of all other bytes. */
+    t1->blk_tx[blk_len - 1U] = swicc_ck(t1->blk_tx, (uint16_t)(blk_len - 1U));
+    t1->blk_tx_len = blk_len;
+
+    memcpy(buf_tx, t1->blk_tx, blk_len);
+    *buf_tx_len = blk_len;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Create an R-block requesting the next I-block of the interface.
+ * @param t1
+ * @param nad
+ * @param err Error code of the R-block, 0 if there was no error.
+ * @param buf_tx
+ * @param buf_tx_len
+ * @return Return code.
+ */
+static swicc_ret_et t1_blk_write_r(swicc_t1_st *const t1, uint8_t const nad,
+                                   uint8_t const err, uint8_t *const buf_tx,
+                                   uint16_t *const buf_tx_len)
+{
+    uint8_t const pcb =
+        (uint8_t)(T1_PCB_R | (t1->ns_rx != 0U ? T1_PCB_R_NR : 0U) | err);
+    return t1_blk_write(t1, nad, pcb, NULL, 0U, buf_tx, buf_tx_len);
+}
+
+/**
+ * @brief Send the next part of the R-APDU in an I-block. Parts that do not fit
+ * in the IFSD are chained.
+ * @param t1
+ * @param nad
+ * @param buf_tx
+ * @param buf_tx_len
+ * @return Return code.
+ */
+static swicc_ret_et t1_rapdu_send(swicc_t1_st *const t1, uint8_t const nad,
+                                  uint8_t *const buf_tx,
+                                  uint16_t *const buf_tx_len)
+{
+    /* Safe cast since the offset never goes past the length. */
+    uint16_t const len_rem = (uint16_t)(t1->rapdu_len - t1->rapdu_offset);
+    /* Safe cast since IFSD is never more than 254. */
+    uint8_t const inf_len =
+        (uint8_t)(len_rem > t1->ifsd ? t1->ifsd : len_rem);
+    uint8_t const pcb =
+        (uint8_t)((t1->ns_tx != 0U ? T1_PCB_I_NS : 0U) |
+                  (len_rem > inf_len ? T1_PCB_I_MORE : 0U));
+    swicc_ret_et const ret =
+        t1_blk_write(t1, nad, pcb, &t1->rapdu[t1->rapdu_offset], inf_len,
+                     buf_tx, buf_tx_len);
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        return ret;
+    }
+    t1->ns_tx ^= 1U;
+    /* Safe cast since this does not go past the R-APDU length. */
+    t1->rapdu_offset = (uint16_t)(t1->rapdu_offset + inf_len);
+    if (t1->rapdu_offset == t1->rapdu_len)
+    {
+        /* The last block can still be retransmitted on request. */
+        t1->rapdu_len = 0U;
+        t1->rapdu_offset = 0U;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Drop the C-APDU and R-APDU along with any handling in progress.
+ * @param swicc_state
+ */
+static void t1_apdu_drop(swicc_st *const swicc_state)
+{
+    swicc_t1_st *const t1 = &swicc_state->internal.t1;
+    t1->capdu_len = 0U;
+    t1->exec = false;
+    t1->rapdu_len = 0U;
+    t1->rapdu_offset = 0U;
+    swicc_state->internal.apduh_pending = false;
+}
+
+/**
+ * @brief Run the handler of the current command until it has a response.
+ * @param swicc_state
+ * @return Pending if the handler is waiting for an external operation, success
+ * once the R-APDU is ready.
+ */
+static swicc_ret_et t1_exec(swicc_st *const swicc_state)
+{
+    swicc_t1_st *const t1 = &swicc_state->internal.t1;
+    swicc_ret_et const ret =
+        swicc_apduh_exec_handle(swicc_state, t1->rapdu, sizeof(t1->rapdu));
+    if (ret == SWICC_RET_APDU_PENDING)
+    {
+        return ret;
+    }
+    t1->rapdu_len = ret == SWICC_RET_SUCCESS
+                        ? swicc_state->internal.apduh_exec.rapdu_len
+                        : 0U;
+    t1->exec = false;
+    t1->capdu_len = 0U;
+    t1->rapdu_offset = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Send the result of running the handler: the R-APDU once it is ready
+ * or a WTX request to keep the interface waiting while the handler is pending.
+ * @param swicc_state
+ * @param nad
+ * @param ret What running the handler returned.
+ * @param buf_tx
+ * @param buf_tx_len
+ * @return Return code.
+ */
+static swicc_ret_et t1_exec_send(swicc_st *const swicc_state,
+                                 uint8_t const nad, swicc_ret_et const ret,
+                                 uint8_t *const buf_tx,
+                                 uint16_t *const buf_tx_len)
+{
+    swicc_t1_st *const t1 = &swicc_state->internal.t1;
+    if (ret == SWICC_RET_APDU_PENDING)
+    {
+        uint8_t const wtx_mult = 1U;
+        return t1_blk_write(t1, nad, T1_PCB_S | T1_PCB_S_WTX, &wtx_mult, 1U,
+                            buf_tx, buf_tx_len);
+    }
+    return t1_rapdu_send(t1, nad, buf_tx, buf_tx_len);
+}
+
+swicc_ret_et swicc_t1_blk(swicc_st *const swicc_state, uint8_t const *const blk,
+                          uint16_t const blk_len, uint8_t *const buf_tx,
+                          uint16_t *const buf_tx_len)
+{
+    swicc_t1_st *const t1 = &swicc_state->internal.t1;
+    uint8_t const nad = blk_len > 0U ? blk[0U] : 0U;
+
+    /* The block is checked before looking at anything else in it. */
+    uint16_t blk_len_exp;
+    if (swicc_t1_blk_len(blk, blk_len, &blk_len_exp) != SWICC_RET_SUCCESS ||
+        blk_len != blk_len_exp || blk[2U] > SWICC_T1_IFS_MAX)
+    {
+        return t1_blk_write_r(t1, nad, T1_PCB_R_ERR_OTHER, buf_tx, buf_tx_len);
+    }
+    if (swicc_ck(blk, blk_len) != 0U)
+    {
+        return t1_blk_write_r(t1, nad, T1_PCB_R_ERR_EDC, buf_tx, buf_tx_len);
+    }
+    uint8_t const pcb = blk[1U];
+    uint8_t const *const inf = &blk[SWICC_T1_PROLOGUE_LEN];
+    uint8_t const inf_len = blk[2U];
+
+    if ((pcb & 0x80U) == 0U)
+    {
+        /* I-block */
+        uint8_t const ns = (pcb & T1_PCB_I_NS) != 0U;
+        if (t1->exec || ns != t1->ns_rx || inf_len > t1->ifsc ||
+            t1->capdu_len + inf_len > sizeof(t1->capdu))
+        {
+            return t1_blk_write_r(t1, nad, T1_PCB_R_ERR_OTHER, buf_tx,
+                                  buf_tx_len);
+        }
+        /* A new C-APDU ends the chaining of the previous R-APDU. */
+        t1->rapdu_len = 0U;
+        t1->rapdu_offset = 0U;
+        memcpy(&t1->capdu[t1->capdu_len], inf, inf_len);
+        /* Safe cast since this was checked to fit in the C-APDU. */
+        t1->capdu_len = (uint16_t)(t1->capdu_len + inf_len);
+        t1->ns_rx ^= 1U;
+        if ((pcb & T1_PCB_I_MORE) != 0U)
+        {
+            /* Acknowledge the chained block and ask for the next one. */
+            return t1_blk_write_r(t1, nad, 0U, buf_tx, buf_tx_len);
+        }
+
+        if (swicc_apduh_exec_cmd_set(swicc_state, t1->capdu, t1->capdu_len) !=
+            SWICC_RET_SUCCESS)
+        {
+            /* Wrong length. */
+            t1->capdu_len = 0U;
+            t1->rapdu[0U] = SWICC_APDU_SW1_CHER_LEN;
+            t1->rapdu[1U] = 0U;
+            t1->rapdu_len = 2U;
+            t1->rapdu_offset = 0U;
+            return t1_rapdu_send(t1, nad, buf_tx, buf_tx_len);
+        }
+        t1->exec = true;
+        t1->rapdu_len = 0U;
+        t1->rapdu_offset = 0U;
+        return t1_exec_send(swicc_state, nad, t1_exec(swicc_state), buf_tx,
+                            buf_tx_len);
+    }
+    else if ((pcb & 0xC0U) == T1_PCB_R)
+    {
+        /* R-block */
+        uint8_t const nr = (pcb & T1_PCB_R_NR) != 0U;
+        if (t1->rapdu_offset < t1->rapdu_len && nr == t1->ns_tx)
+        {
+            /* The interface received the last part and wants the next. */
+            return t1_rapdu_send(t1, nad, buf_tx, buf_tx_len);
+        }
+        if (t1->blk_tx_len > 0U && *buf_tx_len >= t1->blk_tx_len)
+        {
+            /* Retransmit the last block. */
+            memcpy(buf_tx, t1->blk_tx, t1->blk_tx_len);
+            *buf_tx_len = t1->blk_tx_len;
+            return SWICC_RET_SUCCESS;
+        }
+        return t1_blk_write_r(t1, nad, T1_PCB_R_ERR_OTHER, buf_tx, buf_tx_len);
+    }
+
+    /* S-block */
+    uint8_t const pcb_res = (uint8_t)(pcb | T1_PCB_S_RES);
+    switch (pcb)
+    {
+    case T1_PCB_S | T1_PCB_S_RESYNCH:
+        t1_apdu_drop(swicc_state);
+        t1->ns_tx = 0U;
+        t1->ns_rx = 0U;
+        t1->ifsd = SWICC_T1_IFS_DEFAULT;
+        return t1_blk_write(t1, nad, pcb_res, NULL, 0U, buf_tx, buf_tx_len);
+    case T1_PCB_S | T1_PCB_S_IFS:
+        if (inf_len == 1U && inf[0U] >= 1U && inf[0U] <= SWICC_T1_IFS_MAX)
+        {
+            t1->ifsd = inf[0U];
+            return t1_blk_write(t1, nad, pcb_res, inf, inf_len, buf_tx,
+                                buf_tx_len);
+        }
+        break;
+    case T1_PCB_S | T1_PCB_S_ABORT:
+        t1_apdu_drop(swicc_state);
+        return t1_blk_write(t1, nad, pcb_res, NULL, 0U, buf_tx, buf_tx_len);
+    case T1_PCB_S | T1_PCB_S_RES | T1_PCB_S_WTX:
+        if (!t1->exec)
+        {
+            break;
+        }
+        if (swicc_state->internal.apduh_pending &&
+            !atomic_load_explicit(&swicc_state->internal.apduh_pending_done,
+                                  memory_order_acquire))
+        {
+            return t1_exec_send(swicc_state, nad, SWICC_RET_APDU_PENDING,
+                                buf_tx, buf_tx_len);
+        }
+        return t1_exec_send(swicc_state, nad, t1_exec(swicc_state), buf_tx,
+                            buf_tx_len);
+    default:
+        break;
+    }
+    return t1_blk_write_r(t1, nad, T1_PCB_R_ERR_OTHER, buf_tx, buf_tx_len);
+}
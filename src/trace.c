@@ -0,0 +1,57 @@
+#include <string.h>
+#include <swicc/swicc.h>
+#include <time.h>
+
+void swicc_trace_reset(swicc_trace_st *const trace)
+{
+    atomic_store_explicit(&trace->head, 0U, memory_order_relaxed);
+    atomic_store_explicit(&trace->tail, 0U, memory_order_relaxed);
+    atomic_store_explicit(&trace->dropped, 0U, memory_order_relaxed);
+}
+
+void swicc_trace_push(swicc_trace_st *const trace,
+                      swicc_trace_evt_st *const evt)
+{
+    uint32_t const head =
+        atomic_load_explicit(&trace->head, memory_order_relaxed);
+    uint32_t const tail =
+        atomic_load_explicit(&trace->tail, memory_order_acquire);
+    if (head - tail >= SWICC_TRACE_EVT_COUNT)
+    {
+        atomic_fetch_add_explicit(&trace->dropped, 1U, memory_order_relaxed);
+        return;
+    }
+
+    struct timespec time;
+    if (clock_gettime(CLOCK_MONOTONIC, &time) == 0)
+    {
+        /* Safe cast since the monotonic time is never negative. */
+        evt->time = (uint64_t)time.tv_sec * 1000000000U + (uint64_t)time.tv_nsec;
+    }
+    else
+    {
+        evt->time = 0U;
+    }
+
+    trace->evt[head & (SWICC_TRACE_EVT_COUNT - 1U)] = *evt;
+    /* Publish the event only after it was written. */
+    atomic_store_explicit(&trace->head, head + 1U, memory_order_release);
+}
+
+swicc_ret_et swicc_trace_pop(swicc_trace_st *const trace,
+                             swicc_trace_evt_st *const evt)
+{
+    uint32_t const tail =
+        atomic_load_explicit(&trace->tail, memory_order_relaxed);
+    uint32_t const head =
+        atomic_load_explicit(&trace->head, memory_order_acquire);
+    if (tail == head)
+    {
+        return SWICC_RET_TRACE_EMPTY;
+    }
+
+    *evt = trace->evt[tail & (SWICC_TRACE_EVT_COUNT - 1U)];
+    /* Release the slot only after the event was read out of it. */
+    atomic_store_explicit(&trace->tail, tail + 1U, memory_order_release);
+    return SWICC_RET_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include <string.h>
+#include <swicc/swicc.h>
+
+void swicc_wire_init(swicc_wire_st *const wire, uint32_t const clk)
+{
+    memset(wire, 0U, sizeof(*wire));
+    wire->clk = clk == 0U ? SWICC_WIRE_CLK_DEFAULT : clk;
+}
+
+uint64_t swicc_wire_etu_time(swicc_wire_st const *const wire,
+                             swicc_tp_st const *const tp,
+                             uint64_t const etu_count)
+{
+    /* Nothing was negotiated yet so the defaults are used. */
+    bool const tp_default = tp->fi == 0U || tp->di == 0U || tp->fmax == 0U;
+    uint64_t const fi =
+        tp_default ? swicc_io_fi[SWICC_TP_CONF_DEFAULT] : tp->fi;
+    uint64_t const di =
+        tp_default ? swicc_io_di[SWICC_TP_CONF_DEFAULT] : tp->di;
+    /* The table of f(max) is in kHz. */
+    uint64_t const fmax =
+        1000U * (tp_default ? swicc_io_fmax[SWICC_TP_CONF_DEFAULT] : tp->fmax);
+    uint64_t const clk = wire->clk < fmax ? wire->clk : fmax;
+    return etu_count * fi * 1000000000U / (di * clk);
+}
+
+void swicc_wire_xfer(swicc_wire_st *const wire, swicc_tp_st const *const tp,
+                     uint16_t const rx_len, uint16_t const tx_len,
+                     bool const cmd)
+{
+    bool const t1 = tp->t == 1U;
+    uint64_t const etu_char =
+        t1 ? SWICC_WIRE_ETU_T1_CHAR : SWICC_WIRE_ETU_T0_CHAR;
+    uint64_t const etu_turn =
+        t1 ? SWICC_WIRE_ETU_T1_TURN : SWICC_WIRE_ETU_T0_TURN;
+    uint64_t etu_count = (uint64_t)(rx_len + tx_len) * etu_char;
+    /* Every change of direction makes the other side wait a little longer. */
+    if (rx_len > 0U && wire->dir_tx)
+    {
+        etu_count += etu_turn - etu_char;
+        wire->dir_tx = false;
+    }
+    if (tx_len > 0U)
+    {
+        if (!wire->dir_tx)
+        {
+            etu_count += etu_turn - etu_char;
+        }
+        wire->dir_tx = true;
+    }
+
+    uint64_t const time = swicc_wire_etu_time(wire, tp, etu_count);
+    wire->time += time;
+    wire->char_count += rx_len + tx_len;
+    if (cmd)
+    {
+        wire->cmd_time += time;
+        wire->cmd_char += rx_len + tx_len;
+    }
+    if (wire->cmd_done)
+    {
+        wire->cmd_last_time = wire->cmd_time;
+        wire->cmd_last_char = wire->cmd_char;
+        wire->cmd_time = 0U;
+        wire->cmd_char = 0U;
+        wire->cmd_count += 1U;
+        wire->cmd_done = false;
+    }
+}
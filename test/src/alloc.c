@@ -0,0 +1,119 @@
+#include <tau/tau.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/* Backing allocator which counts the chunks an arena takes. */
+typedef struct alloc_count_s
+{
+    uint32_t malloc_count;
+    uint32_t free_count;
+} alloc_count_st;
+
+static swicc_alloc_malloc_ft count_malloc;
+static void *count_malloc(void *const ctx, size_t const size)
+{
+    /* Only called holding the lock of the arena. */
+    ((alloc_count_st *)ctx)->malloc_count += 1U;
+    return malloc(size);
+}
+
+static swicc_alloc_realloc_ft count_realloc;
+static void *count_realloc(void *const ctx, void *const ptr,
+                           size_t const size_old, size_t const size)
+{
+    return realloc(ptr, size);
+}
+
+static swicc_alloc_free_ft count_free;
+static void count_free(void *const ctx, void *const ptr)
+{
+    ((alloc_count_st *)ctx)->free_count += 1U;
+    free(ptr);
+}
+
+TEST(alloc, swicc_alloc_arena_init__param_check)
+{
+    swicc_alloc_arena_st arena;
+    swicc_alloc_st const backing_nofree = {
+        .malloc = count_malloc, .realloc = count_realloc, .free = NULL};
+    CHECK_EQ(swicc_alloc_arena_init(NULL, NULL, 0U), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_alloc_arena_init(&arena, &backing_nofree, 0U),
+             SWICC_RET_PARAM_BAD);
+    REQUIRE_EQ(swicc_alloc_arena_init(&arena, NULL, 0U), SWICC_RET_SUCCESS);
+    CHECK_EQ(arena.chunk_size, SWICC_ALLOC_ARENA_CHUNK_SIZE_MIN);
+    swicc_alloc_arena_free(&arena);
+}
+
+TEST(alloc, swicc_alloc_arena__realloc)
+{
+    swicc_alloc_arena_st arena;
+    REQUIRE_EQ(swicc_alloc_arena_init(&arena, NULL, 0U), SWICC_RET_SUCCESS);
+    uint8_t *const a = swicc_alloc_malloc(&arena.alloc, 16U);
+    REQUIRE_NE((void *)a, NULL);
+    memset(a, 0xA5, 16U);
+
+    /* The last allocation grows in place. */
+    CHECK_EQ((void *)swicc_alloc_realloc(&arena.alloc, a, 16U, 64U),
+             (void *)a);
+
+    /* Anything else is copied. */
+    uint8_t *const b = swicc_alloc_calloc(&arena.alloc, 4U, 4U);
+    REQUIRE_NE((void *)b, NULL);
+    uint8_t const b_zero[16U] = {0U};
+    CHECK_BUF_EQ(b, b_zero, sizeof(b_zero));
+    uint8_t *const a_new = swicc_alloc_realloc(&arena.alloc, a, 64U, 128U);
+    REQUIRE_NE((void *)a_new, NULL);
+    CHECK_NE((void *)a_new, (void *)a);
+    CHECK_BUF_EQ(a_new, a, 64U);
+
+    /* Larger than a chunk. */
+    uint8_t *const c = swicc_alloc_malloc(
+        &arena.alloc, SWICC_ALLOC_ARENA_CHUNK_SIZE_MIN * 4U);
+    CHECK_NE((void *)c, NULL);
+    swicc_alloc_arena_free(&arena);
+    CHECK_EQ((void *)arena.chunk, NULL);
+}
+
+TEST(alloc, swicc_alloc__disk)
+{
+    static swicc_st swicc_state;
+    alloc_count_st count = {0U};
+    swicc_alloc_st const backing = {.malloc = count_malloc,
+                                    .realloc = count_realloc,
+                                    .free = count_free,
+                                    .ctx = &count};
+    swicc_alloc_arena_st arena;
+    REQUIRE_EQ(swicc_alloc_arena_init(&arena, &backing, 0U),
+               SWICC_RET_SUCCESS);
+
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_state.fs.disk.alloc = &arena.alloc;
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ((void *)swicc_state.fs.disk.alloc, (void *)&arena.alloc);
+    CHECK_EQ((void *)swicc_state.fs.disk.root->alloc, (void *)&arena.alloc);
+    CHECK_NE(count.malloc_count, 0U);
+
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE7C7),
+               SWICC_RET_SUCCESS);
+    uint8_t const capdu[] = {0x00, 0xA4, 0x00, 0x04, 0x02, 0xE9, 0x9D};
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu, sizeof(capdu), rapdu,
+                                &rapdu_len),
+               SWICC_RET_SUCCESS);
+    /* The FCP template is ready to be fetched using GET RESPONSE. */
+    REQUIRE_EQ(rapdu_len, 2U);
+    CHECK_EQ(rapdu[0U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+
+    /* Unloading leaves the memory to the arena. */
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+    CHECK_EQ((void *)swicc_state.fs.disk.alloc, (void *)&arena.alloc);
+    CHECK_EQ(count.free_count, 0U);
+    swicc_alloc_arena_free(&arena);
+    CHECK_EQ(count.free_count, count.malloc_count);
+}
@@ -24,7 +24,7 @@ TEST(apdu_rc, swicc_apdu_rc_enq__param_check)
 
 TEST(apdu_rc, swicc_apdu_rc_enq__data)
 {
-    uint8_t buf_enq[SWICC_DATA_MAX + 1U];
+    static uint8_t buf_enq[SWICC_DATA_MAX_LONG + 1U];
     for (uint32_t buf_enq_idx = 0U; buf_enq_idx < sizeof(buf_enq);
          ++buf_enq_idx)
     {
@@ -32,16 +32,28 @@ TEST(apdu_rc, swicc_apdu_rc_enq__data)
         buf_enq[buf_enq_idx] = (uint8_t)(buf_enq_idx % UINT8_MAX);
     }
 
-    swicc_apdu_rc_st rc;
-    swicc_apdu_rc_reset(&rc);
-    CHECK_EQ(sizeof(rc.b), sizeof(buf_enq) - 1U);
+    swicc_apdu_rc_st rc = {0};
     CHECK_EQ(swicc_apdu_rc_enq(&rc, buf_enq, sizeof(buf_enq)),
              SWICC_RET_BUFFER_TOO_SHORT);
-    CHECK_EQ(swicc_apdu_rc_enq(&rc, buf_enq, sizeof(buf_enq) - 1U),
+    CHECK_EQ(swicc_apdu_rc_enq(&rc, buf_enq, SWICC_DATA_MAX),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(rc.size, SWICC_DATA_MAX);
+    /* Grows past a short response up to an extended one. */
+    CHECK_EQ(swicc_apdu_rc_enq(&rc, &buf_enq[SWICC_DATA_MAX],
+                               sizeof(buf_enq) - 1U - SWICC_DATA_MAX),
              SWICC_RET_SUCCESS);
+    CHECK_EQ(rc.size, SWICC_DATA_MAX_LONG);
     CHECK_BUF_EQ(rc.b, buf_enq, sizeof(buf_enq) - 1U);
     CHECK_EQ(rc.len, sizeof(buf_enq) - 1U);
     CHECK_EQ(rc.offset, 0U);
+    CHECK_EQ(swicc_apdu_rc_enq(&rc, buf_enq, 1U), SWICC_RET_BUFFER_TOO_SHORT);
+
+    /* Resetting keeps the buffer. */
+    swicc_apdu_rc_reset(&rc);
+    CHECK_EQ(rc.len, 0U);
+    CHECK_EQ(rc.size, SWICC_DATA_MAX_LONG);
+    swicc_apdu_rc_free(&rc);
+    CHECK_EQ(rc.size, 0U);
 }
 
 TEST(apdu_rc, swicc_apdu_rc_deq__param_check)
@@ -69,9 +81,7 @@ TEST(apdu_rc, swicc_apdu_rc_deq__data)
     uint32_t buf_deq_len_exp = sizeof(buf_deq);
     uint32_t buf_deq_len = buf_deq_len_exp;
 
-    swicc_apdu_rc_st rc;
-    swicc_apdu_rc_reset(&rc);
-    CHECK_EQ(sizeof(rc.b), sizeof(buf_enq));
+    swicc_apdu_rc_st rc = {0};
     CHECK_EQ(swicc_apdu_rc_enq(&rc, buf_enq, buf_deq_len_exp),
              SWICC_RET_SUCCESS);
 
@@ -147,12 +157,12 @@ TEST(apdu_rc, swicc_apdu_rc_deq__data)
     CHECK_EQ(rc.offset, buf_deq_len_tot + buf_deq_len_exp);
     CHECK_EQ(rc.offset, rc.len);
     buf_deq_len_tot += buf_deq_len;
+    swicc_apdu_rc_free(&rc);
 }
 
 TEST(apdu_rc, swicc_apdu_rc_len_rem)
 {
-    swicc_apdu_rc_st rc;
-    swicc_apdu_rc_reset(&rc);
+    swicc_apdu_rc_st rc = {0};
     uint8_t buf[SWICC_DATA_MAX];
     for (uint32_t buf_idx = 0U; buf_idx < sizeof(buf); ++buf_idx)
     {
@@ -168,4 +178,64 @@ TEST(apdu_rc, swicc_apdu_rc_len_rem)
     uint32_t len_deq = sizeof(buf) - 20U;
     CHECK_EQ(swicc_apdu_rc_deq(&rc, buf, &len_deq), SWICC_RET_SUCCESS);
     CHECK_EQ(swicc_apdu_rc_len_rem(&rc), 20U);
+    swicc_apdu_rc_free(&rc);
+}
+
+TEST(apdu_rc, swicc_apdu_rc_enq_ref)
+{
+    uint8_t buf[600U];
+    for (uint32_t buf_idx = 0U; buf_idx < sizeof(buf); ++buf_idx)
+    {
+        /* Safe cast due to the modulo operation. */
+        buf[buf_idx] = (uint8_t)(buf_idx % UINT8_MAX);
+    }
+
+    /* Copied, borrowed, then copied data again. */
+    swicc_apdu_rc_st rc = {0};
+    REQUIRE_EQ(swicc_apdu_rc_enq(&rc, buf, 100U), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_apdu_rc_enq_ref(&rc, &buf[100U], 400U),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_apdu_rc_enq(&rc, &buf[500U], 100U), SWICC_RET_SUCCESS);
+    CHECK_EQ(rc.seg_count, 3U);
+    CHECK_EQ(rc.b_len, 200U);
+    CHECK_EQ(swicc_apdu_rc_len_rem(&rc), sizeof(buf));
+
+    /* Data split across segments can't be borrowed. */
+    uint8_t const *buf_ref;
+    CHECK_EQ(swicc_apdu_rc_deq_ref(&rc, &buf_ref, 101U), SWICC_RET_ERROR);
+    REQUIRE_EQ(swicc_apdu_rc_deq_ref(&rc, &buf_ref, 90U), SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(buf_ref, buf, 90U);
+
+    uint8_t buf_deq[256U];
+    uint32_t buf_deq_len = 20U;
+    REQUIRE_EQ(swicc_apdu_rc_deq(&rc, buf_deq, &buf_deq_len),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(buf_deq, &buf[90U], 20U);
+
+    /* Borrowed data is given back without a copy. */
+    REQUIRE_EQ(swicc_apdu_rc_deq_ref(&rc, &buf_ref, 256U), SWICC_RET_SUCCESS);
+    CHECK_EQ(buf_ref == &buf[110U], true);
+
+    /* Copies can span segments. */
+    buf_deq_len = 150U;
+    REQUIRE_EQ(swicc_apdu_rc_deq(&rc, buf_deq, &buf_deq_len),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(buf_deq, &buf[366U], 150U);
+    CHECK_EQ(swicc_apdu_rc_len_rem(&rc), 84U);
+    CHECK_EQ(swicc_apdu_rc_deq_ref(&rc, &buf_ref, 85U),
+             SWICC_RET_BUFFER_TOO_SHORT);
+    REQUIRE_EQ(swicc_apdu_rc_deq_ref(&rc, &buf_ref, 84U), SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(buf_ref, &buf[516U], 84U);
+    CHECK_EQ(swicc_apdu_rc_len_rem(&rc), 0U);
+
+    /* Running out of segments. */
+    swicc_apdu_rc_reset(&rc);
+    for (uint32_t seg_idx = 0U; seg_idx < SWICC_APDU_RC_SEG_COUNT_MAX;
+         ++seg_idx)
+    {
+        REQUIRE_EQ(swicc_apdu_rc_enq_ref(&rc, buf, 1U), SWICC_RET_SUCCESS);
+    }
+    CHECK_EQ(swicc_apdu_rc_enq_ref(&rc, buf, 1U), SWICC_RET_BUFFER_TOO_SHORT);
+    CHECK_EQ(swicc_apdu_rc_enq(&rc, buf, 1U), SWICC_RET_BUFFER_TOO_SHORT);
+    swicc_apdu_rc_free(&rc);
 }
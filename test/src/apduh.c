@@ -0,0 +1,689 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+static swicc_apduh_ft apduh_test_handled;
+static swicc_ret_et apduh_test_handled(swicc_st *const swicc_state,
+                                       swicc_apdu_cmd_st const *const cmd,
+                                       swicc_apdu_res_st *const res,
+                                       uint32_t const procedure_count)
+{
+    res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+    res->sw2 = cmd->hdr->ins;
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+static swicc_apduh_ft apduh_test_unhandled;
+static swicc_ret_et apduh_test_unhandled(swicc_st *const swicc_state,
+                                         swicc_apdu_cmd_st const *const cmd,
+                                         swicc_apdu_res_st *const res,
+                                         uint32_t const procedure_count)
+{
+    return SWICC_RET_APDU_UNHANDLED;
+}
+
+static void demux(swicc_st *const swicc_state,
+                  swicc_apdu_cla_type_et const cla_type, uint8_t const ins,
+                  swicc_apdu_res_st *const res)
+{
+    swicc_apdu_cmd_hdr_st hdr = {.cla = {.type = cla_type}, .ins = ins};
+    uint8_t p3 = 0U;
+    swicc_apdu_data_st data = {.len = 0U};
+    swicc_apdu_cmd_st const cmd = {.hdr = &hdr, .p3 = &p3, .data = &data};
+    memset(res, 0U, sizeof(*res));
+    swicc_apduh_demux(swicc_state, &cmd, res, 1U);
+}
+
+TEST(apduh, swicc_apduh_register)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_apdu_res_st res;
+
+    CHECK_EQ(swicc_apduh_register(&swicc_state, SWICC_APDU_CLA_TYPE_RFU, 0x10,
+                                  apduh_test_handled),
+             SWICC_RET_PARAM_BAD);
+
+    /* Unknown proprietary instructions stay unhandled. */
+    demux(&swicc_state, SWICC_APDU_CLA_TYPE_PROPRIETARY, 0x10, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_INS);
+    REQUIRE_EQ(swicc_apduh_register(&swicc_state,
+                                    SWICC_APDU_CLA_TYPE_PROPRIETARY, 0x10,
+                                    apduh_test_handled),
+               SWICC_RET_SUCCESS);
+    demux(&swicc_state, SWICC_APDU_CLA_TYPE_PROPRIETARY, 0x10, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(res.sw2, 0x10);
+    /* Only the registered instruction is affected. */
+    demux(&swicc_state, SWICC_APDU_CLA_TYPE_PROPRIETARY, 0x12, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_INS);
+    demux(&swicc_state, SWICC_APDU_CLA_TYPE_INTERINDUSTRY, 0x10, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_INS);
+
+    /* Overriding an interindustry instruction. */
+    REQUIRE_EQ(swicc_apduh_register(&swicc_state,
+                                    SWICC_APDU_CLA_TYPE_INTERINDUSTRY, 0xB0,
+                                    apduh_test_handled),
+               SWICC_RET_SUCCESS);
+    demux(&swicc_state, SWICC_APDU_CLA_TYPE_INTERINDUSTRY, 0xB0, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(res.sw2, 0xB0);
+
+    /* Leaving it unhandled falls back to the default READ BINARY. */
+    REQUIRE_EQ(swicc_apduh_register(&swicc_state,
+                                    SWICC_APDU_CLA_TYPE_INTERINDUSTRY, 0xB0,
+                                    apduh_test_unhandled),
+               SWICC_RET_SUCCESS);
+    demux(&swicc_state, SWICC_APDU_CLA_TYPE_INTERINDUSTRY, 0xB0, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_CMD);
+    CHECK_EQ(res.sw2, 0x86);
+
+    /* Registrations survive a reset. */
+    swicc_reset(&swicc_state);
+    demux(&swicc_state, SWICC_APDU_CLA_TYPE_PROPRIETARY, 0x10, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+}
+
+/**
+ * @brief Send a command with a data field and get the response data with GET
+ * RESPONSE when the command has some.
+ * @param[in, out] swicc_state
+ * @param[in] ins
+ * @param[in] p1
+ * @param[in] p2
+ * @param[in] data
+ * @param[in] data_len
+ * @param[out] res Response of the command, or of GET RESPONSE if it was sent.
+ */
+static void demux_data(swicc_st *const swicc_state, uint8_t const ins,
+                       uint8_t const p1, uint8_t const p2,
+                       uint8_t const *const data, uint8_t const data_len,
+                       swicc_apdu_res_st *const res)
+{
+    swicc_apdu_cmd_hdr_st hdr = {
+        .cla = {.type = SWICC_APDU_CLA_TYPE_INTERINDUSTRY},
+        .ins = ins,
+        .p1 = p1,
+        .p2 = p2,
+    };
+    uint8_t p3 = data_len;
+    swicc_apdu_data_st cmd_data = {.len = 0U};
+    swicc_apdu_cmd_st const cmd = {.hdr = &hdr, .p3 = &p3, .data = &cmd_data};
+    memset(res, 0U, sizeof(*res));
+    swicc_apduh_demux(swicc_state, &cmd, res, 0U);
+    if (res->sw1 != SWICC_APDU_SW1_PROC_ACK_ALL)
+    {
+        return;
+    }
+    cmd_data.len = data_len;
+    if (data_len > 0U)
+    {
+        memcpy(cmd_data.b, data, data_len);
+    }
+    memset(res, 0U, sizeof(*res));
+    swicc_apduh_demux(swicc_state, &cmd, res, 1U);
+    if (res->sw1 != SWICC_APDU_SW1_NORM_BYTES_AVAILABLE)
+    {
+        return;
+    }
+
+    hdr = (swicc_apdu_cmd_hdr_st){
+        .cla = {.type = SWICC_APDU_CLA_TYPE_INTERINDUSTRY},
+        .ins = 0xC0,
+    };
+    p3 = res->sw2;
+    cmd_data.len = 0U;
+    memset(res, 0U, sizeof(*res));
+    swicc_apduh_demux(swicc_state, &cmd, res, 1U);
+    if (res->data_ref != NULL)
+    {
+        memmove(res->data.b, res->data_ref, res->data.len);
+        res->data_ref = NULL;
+    }
+}
+
+/**
+ * @brief Send a command without a data field which expects response data.
+ * @param[in, out] swicc_state
+ * @param[in] ins
+ * @param[in] p1
+ * @param[in] p2
+ * @param[in] le Expected length of the response data.
+ * @param[out] res
+ */
+static void demux_le(swicc_st *const swicc_state, uint8_t const ins,
+                     uint8_t const p1, uint8_t const p2, uint8_t const le,
+                     swicc_apdu_res_st *const res)
+{
+    swicc_apdu_cmd_hdr_st hdr = {
+        .cla = {.type = SWICC_APDU_CLA_TYPE_INTERINDUSTRY},
+        .ins = ins,
+        .p1 = p1,
+        .p2 = p2,
+    };
+    uint8_t p3 = le;
+    swicc_apdu_data_st cmd_data = {.len = 0U};
+    swicc_apdu_cmd_st const cmd = {.hdr = &hdr, .p3 = &p3, .data = &cmd_data};
+    memset(res, 0U, sizeof(*res));
+    swicc_apduh_demux(swicc_state, &cmd, res, 1U);
+}
+
+TEST(apduh, apduh_rcrd_search)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_mount(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    /**
+     * Linear-fixed EF with records:
+     * 1: F672FF993B80830FAEEEC95884DC99E5
+     * 2: 46F198E14E678E14B0F1FADAB19E13EC
+     * 3: CF0028E5673C5D1AA4C9160B63384929
+     */
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    swicc_apdu_res_st res;
+
+    /* Simple search forward and backward. */
+    static uint8_t const str_e5[] = {0xE5};
+    demux_data(&swicc_state, 0xA2, 1U, 0x04, str_e5, sizeof(str_e5), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    REQUIRE_EQ(res.data.len, 2U);
+    CHECK_BUF_EQ(res.data.b, ((uint8_t[]){1U, 3U}), 2U);
+    CHECK_EQ(swicc_state.fs.va.cur_rcrd.idx, 0U);
+    demux_data(&swicc_state, 0xA2, 3U, 0x05, str_e5, sizeof(str_e5), &res);
+    REQUIRE_EQ(res.data.len, 2U);
+    CHECK_BUF_EQ(res.data.b, ((uint8_t[]){3U, 1U}), 2U);
+    CHECK_EQ(swicc_state.fs.va.cur_rcrd.idx, 2U);
+    demux_data(&swicc_state, 0xA2, 2U, 0x04, str_e5, sizeof(str_e5), &res);
+    REQUIRE_EQ(res.data.len, 1U);
+    CHECK_EQ(res.data.b[0U], 3U);
+
+    /* Matches never span two records. */
+    static uint8_t const str_span[] = {0xE5, 0x46};
+    demux_data(&swicc_state, 0xA2, 1U, 0x04, str_span, sizeof(str_span),
+               &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_WARN_NVM_CHGN);
+    CHECK_EQ(res.sw2, 0x82);
+
+    /* Enhanced search from an offset and after a value. */
+    static uint8_t const str_offset[] = {0x04, 0x04, 0xE5};
+    demux_data(&swicc_state, 0xA2, 1U, 0x06, str_offset, sizeof(str_offset),
+               &res);
+    REQUIRE_EQ(res.data.len, 1U);
+    CHECK_EQ(res.data.b[0U], 1U);
+    static uint8_t const str_value[] = {0x0D, 0xE5, 0x67};
+    demux_data(&swicc_state, 0xA2, 3U, 0x06, str_value, sizeof(str_value),
+               &res);
+    REQUIRE_EQ(res.data.len, 1U);
+    CHECK_EQ(res.data.b[0U], 3U);
+
+    /* Invalid parameters. */
+    demux_data(&swicc_state, 0xA2, 4U, 0x04, str_e5, sizeof(str_e5), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x83);
+    demux_data(&swicc_state, 0xA2, 0U, 0x04, str_e5, sizeof(str_e5), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x86);
+    demux_data(&swicc_state, 0xA2, 1U, 0x06, str_e5, sizeof(str_e5), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_LEN);
+    demux_data(&swicc_state, 0xA2, 1U, 0x04, str_e5, 0U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_LEN);
+
+    /* Only files with records can be searched. */
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xF4F4),
+               SWICC_RET_SUCCESS);
+    demux_data(&swicc_state, 0xA2, 1U, 0x04, str_e5, sizeof(str_e5), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_CMD);
+    CHECK_EQ(res.sw2, 0x81);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(apduh, apduh_rcrd_update__cyclic)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_mount(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    /**
+     * Cyclic EF with records:
+     * 1: C411A9C107C9E84DF3C78DB59ED3DD57
+     * 2: 4F7613D2665B282C54C71D23B1410712
+     * 3: CC3E321EC6CBA4FB34EC41166A98FAE5
+     */
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0x5ABD),
+               SWICC_RET_SUCCESS);
+    swicc_apdu_res_st res;
+    uint8_t rcrd_new[16U];
+    memset(rcrd_new, 0xA5, sizeof(rcrd_new));
+
+    /* The oldest record gets replaced and becomes record number 1. */
+    demux_data(&swicc_state, 0xDC, 0U, 0x03, rcrd_new, sizeof(rcrd_new), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(swicc_state.fs.va.cur_rcrd.idx, 0U);
+    uint8_t rcrd_head;
+    REQUIRE_EQ(swicc_disk_file_rcrd_head(swicc_state.fs.va.cur_tree,
+                                         &swicc_state.fs.va.cur_ef, &rcrd_head),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(rcrd_head, 2U);
+    uint8_t *rcrd;
+    uint8_t rcrd_len;
+    REQUIRE_EQ(swicc_disk_file_rcrd(swicc_state.fs.va.cur_tree,
+                                    &swicc_state.fs.va.cur_ef, 0U, &rcrd,
+                                    &rcrd_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rcrd_len, sizeof(rcrd_new));
+    CHECK_BUF_EQ(rcrd, rcrd_new, sizeof(rcrd_new));
+    REQUIRE_EQ(swicc_disk_file_rcrd(swicc_state.fs.va.cur_tree,
+                                    &swicc_state.fs.va.cur_ef, 2U, &rcrd,
+                                    &rcrd_len),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(rcrd[0U], 0x4F);
+
+    /* Searching follows the record numbering. */
+    static uint8_t const str_c4[] = {0xC4, 0x11};
+    demux_data(&swicc_state, 0xA2, 1U, 0x04, str_c4, sizeof(str_c4), &res);
+    REQUIRE_EQ(res.data.len, 1U);
+    CHECK_EQ(res.data.b[0U], 2U);
+
+    /* Only PREVIOUS mode is allowed on cyclic EFs and only on them. */
+    demux_data(&swicc_state, 0xDC, 1U, 0x04, rcrd_new, sizeof(rcrd_new), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_CMD);
+    CHECK_EQ(res.sw2, 0x81);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    demux_data(&swicc_state, 0xDC, 0U, 0x03, rcrd_new, sizeof(rcrd_new), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x81);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(apduh, apduh_bin_update)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_mount(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    /* Transparent EF with 16 bytes: 3F2911577FE290374411AAC80FA0FB43 */
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xF4F4),
+               SWICC_RET_SUCCESS);
+    swicc_apdu_res_st res;
+    static uint8_t const data_new[] = {0xA5, 0x5A, 0xC3};
+    static uint8_t const data_exp[] = {0x3F, 0x29, 0x11, 0x57, 0x7F, 0xE2,
+                                       0x90, 0x37, 0x44, 0x11, 0xA5, 0x5A,
+                                       0xC3, 0xA0, 0xFB, 0x43};
+
+    /* Only the bytes at the offset get updated. */
+    demux_data(&swicc_state, 0xD6, 0x00, 0x0A, data_new, sizeof(data_new),
+               &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    uint8_t *data;
+    REQUIRE_EQ(swicc_disk_file_data(swicc_state.fs.va.cur_tree,
+                                    &swicc_state.fs.va.cur_ef, &data),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(data, data_exp, sizeof(data_exp));
+
+    /* Offset outside of the EF and data past its end. */
+    demux_data(&swicc_state, 0xD6, 0x00, 0x10, data_new, sizeof(data_new),
+               &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2);
+    demux_data(&swicc_state, 0xD6, 0x00, 0x0E, data_new, sizeof(data_new),
+               &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_LEN);
+    CHECK_BUF_EQ(data, data_exp, sizeof(data_exp));
+
+    /* No EF with this SID and P1 b6-b7 set. */
+    demux_data(&swicc_state, 0xD6, 0x80 | 0x1E, 0x00, data_new,
+               sizeof(data_new), &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x82);
+    demux_data(&swicc_state, 0xD6, 0xA0, 0x00, data_new, sizeof(data_new),
+               &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x86);
+
+    /* Only transparent EFs can be updated. */
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    demux_data(&swicc_state, 0xD6, 0x00, 0x00, data_new, sizeof(data_new),
+               &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_CMD);
+    CHECK_EQ(res.sw2, 0x81);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(apduh, apduh_rcrd_read__many)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_mount(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    /* Linear-fixed EF with 3 records of 16 bytes. */
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    swicc_apdu_res_st res;
+    uint8_t *rcrd[3U];
+    uint8_t rcrd_len;
+    for (uint8_t rcrd_idx = 0U; rcrd_idx < 3U; ++rcrd_idx)
+    {
+        REQUIRE_EQ(swicc_disk_file_rcrd(swicc_state.fs.va.cur_tree,
+                                        &swicc_state.fs.va.cur_ef, rcrd_idx,
+                                        &rcrd[rcrd_idx], &rcrd_len),
+                   SWICC_RET_SUCCESS);
+    }
+
+    /* From P1 to the last record and the other way around. */
+    demux_le(&swicc_state, 0xB2, 2U, 0x05, 32U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    REQUIRE_EQ(res.data.len, 32U);
+    CHECK_BUF_EQ(res.data.b, rcrd[1U], 16U);
+    CHECK_BUF_EQ(&res.data.b[16U], rcrd[2U], 16U);
+    CHECK_EQ(swicc_state.fs.va.cur_rcrd.idx, 1U);
+    demux_le(&swicc_state, 0xB2, 1U, 0x06, 48U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    REQUIRE_EQ(res.data.len, 48U);
+    CHECK_BUF_EQ(res.data.b, rcrd[2U], 16U);
+    CHECK_BUF_EQ(&res.data.b[16U], rcrd[1U], 16U);
+    CHECK_BUF_EQ(&res.data.b[32U], rcrd[0U], 16U);
+    CHECK_EQ(swicc_state.fs.va.cur_rcrd.idx, 0U);
+
+    /* Le must cover all the records. */
+    demux_le(&swicc_state, 0xB2, 1U, 0x05, 16U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_LE);
+    CHECK_EQ(res.sw2, 48U);
+    demux_le(&swicc_state, 0xB2, 4U, 0x05, 16U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x83);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(apduh, apduh_lchan_manage)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_mount(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    swicc_apdu_res_st res;
+
+    /* Interindustry and UICC proprietary classes carry the channel. */
+    CHECK_EQ(swicc_apdu_cmd_cla_parse(0x03).lchan, 3U);
+    CHECK_EQ(swicc_apdu_cmd_cla_parse(0x4F).lchan, 19U);
+    CHECK_EQ(swicc_apdu_cmd_cla_parse(0x81).lchan, 1U);
+    CHECK_EQ(swicc_apdu_cmd_cla_parse(0xC2).lchan, 6U);
+
+    /* The card picks the channel and it starts with the MF selected. */
+    demux_data(&swicc_state, 0x70, 0x00, 0x00, NULL, 0U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    REQUIRE_EQ(res.data.len, 1U);
+    CHECK_EQ(res.data.b[0U], 1U);
+    demux_data(&swicc_state, 0x70, 0x00, 0x03, NULL, 0U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(res.data.len, 0U);
+    demux_data(&swicc_state, 0x70, 0x00, 0x03, NULL, 0U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x86);
+    CHECK_EQ(swicc_state.fs.lchan_open, (1U << 1U) | (1U << 3U));
+
+    /* Every channel keeps its own VA. */
+    REQUIRE_EQ(swicc_va_lchan_switch(&swicc_state.fs, 1U), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_state.fs.va.cur_file.hdr_item.type,
+             SWICC_FS_ITEM_TYPE_FILE_MF);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xF4F4),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_lchan_switch(&swicc_state.fs, 0U), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_state.fs.va.cur_ef.hdr_file.id, 0xE99D);
+    REQUIRE_EQ(swicc_va_lchan_switch(&swicc_state.fs, 1U), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_state.fs.va.cur_ef.hdr_file.id, 0xF4F4);
+
+    /* Commands on a closed channel are rejected. */
+    swicc_apdu_cmd_hdr_st hdr = {.cla = swicc_apdu_cmd_cla_parse(0x02),
+                                 .ins = 0xB0};
+    uint8_t p3 = 0U;
+    swicc_apdu_data_st data = {.len = 0U};
+    swicc_apdu_cmd_st const cmd = {.hdr = &hdr, .p3 = &p3, .data = &data};
+    memset(&res, 0U, sizeof(res));
+    CHECK_EQ(swicc_apduh_demux(&swicc_state, &cmd, &res, 0U),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_CLA_FUNC);
+    CHECK_EQ(res.sw2, 0x81);
+
+    /* Closing the current channel goes back to the basic one. */
+    demux_data(&swicc_state, 0x70, 0x80, 0x01, NULL, 0U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(swicc_state.fs.lchan_cur, 0U);
+    CHECK_EQ(swicc_state.fs.va.cur_ef.hdr_file.id, 0xE99D);
+    demux_data(&swicc_state, 0x70, 0x80, 0x00, NULL, 0U, &res);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(res.sw2, 0x86);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(apduh, swicc_apduh_demux__ctx)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_mount(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    swicc_apdu_res_st res;
+
+    /* UPDATE RECORD looks the record up before asking for the data. */
+    swicc_apdu_cmd_hdr_st hdr = {
+        .cla = {.type = SWICC_APDU_CLA_TYPE_INTERINDUSTRY},
+        .ins = 0xDC,
+        .p1 = 1U,
+        .p2 = 0x04,
+    };
+    uint8_t p3 = 16U;
+    swicc_apdu_data_st data = {.len = 0U};
+    swicc_apdu_cmd_st const cmd = {.hdr = &hdr, .p3 = &p3, .data = &data};
+    memset(&res, 0U, sizeof(res));
+    swicc_apduh_demux(&swicc_state, &cmd, &res, 0U);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_PROC_ACK_ALL);
+    CHECK_EQ(res.data.len, 16U);
+    CHECK_EQ(swicc_state.internal.apduh_ctx.valid, true);
+    CHECK_EQ(swicc_state.internal.apduh_ctx.file.hdr_file.id, 0xE99D);
+
+    /* The data phase continues with the EF resolved in the first phase. */
+    data.len = 16U;
+    memset(data.b, 0x5A, data.len);
+    memset(&res, 0U, sizeof(res));
+    swicc_apduh_demux(&swicc_state, &cmd, &res, 1U);
+    CHECK_EQ(res.sw1, SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(swicc_state.fs.va.cur_ef.hdr_file.id, 0xE99D);
+    uint8_t *rcrd;
+    uint8_t rcrd_len;
+    REQUIRE_EQ(swicc_disk_file_rcrd(swicc_state.fs.va.cur_tree,
+                                    &swicc_state.fs.va.cur_ef, 0U, &rcrd,
+                                    &rcrd_len),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(rcrd, data.b, rcrd_len);
+
+    /* A later phase of another command does not get the context. */
+    hdr.p1 = 2U;
+    memset(&res, 0U, sizeof(res));
+    swicc_apduh_demux(&swicc_state, &cmd, &res, 1U);
+    CHECK_EQ(swicc_state.internal.apduh_ctx.valid, false);
+    CHECK_EQ(swicc_state.internal.apduh_ctx.p1, 2U);
+    swicc_terminate(&swicc_state);
+}
+
+/* Set by the test once the external operation has a result. */
+static bool apduh_test_pending_result;
+
+static swicc_apduh_ft apduh_test_pending;
+static swicc_ret_et apduh_test_pending(swicc_st *const swicc_state,
+                                       swicc_apdu_cmd_st const *const cmd,
+                                       swicc_apdu_res_st *const res,
+                                       uint32_t const procedure_count)
+{
+    swicc_apduh_ctx_st *const apduh_ctx = &swicc_state->internal.apduh_ctx;
+    if (!apduh_ctx->valid)
+    {
+        /* Start the operation. */
+        apduh_ctx->param[0U] = cmd->hdr->p1;
+        apduh_ctx->valid = true;
+        return SWICC_RET_APDU_PENDING;
+    }
+    if (!apduh_test_pending_result)
+    {
+        return SWICC_RET_APDU_PENDING;
+    }
+    res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+    res->sw2 = apduh_ctx->param[0U];
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+TEST(apduh, swicc_apduh_pending_complete)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    REQUIRE_EQ(swicc_apduh_pro_register(&swicc_state, apduh_test_pending),
+               SWICC_RET_SUCCESS);
+    uint8_t buf_tx[8U];
+    swicc_apdu_cmd_hdr_st hdr = {
+        .cla = {.type = SWICC_APDU_CLA_TYPE_PROPRIETARY},
+        .ins = 0x88,
+        .p1 = 0x42,
+    };
+    uint8_t p3 = 0U;
+    swicc_apdu_data_st data = {.len = 0U};
+    swicc_state.internal.apdu_cur =
+        (swicc_apdu_cmd_st){.hdr = &hdr, .p3 = &p3, .data = &data};
+    swicc_state.internal.fsm_state = SWICC_FSM_STATE_CMD_PROCEDURE;
+    swicc_state.cont_state_rx = FSM_STATE_CONT_READY;
+    swicc_state.buf_tx = buf_tx;
+    apduh_test_pending_result = false;
+
+    /* Keep sending NULL procedure bytes until the operation completes. */
+    for (uint32_t step = 0U; step < 3U; ++step)
+    {
+        swicc_state.buf_tx_len = sizeof(buf_tx);
+        swicc_fsm(&swicc_state);
+        CHECK_EQ(swicc_state.internal.fsm_state,
+                 SWICC_FSM_STATE_CMD_PROCEDURE);
+        REQUIRE_EQ(swicc_state.buf_tx_len, 1U);
+        CHECK_EQ(buf_tx[0U], SWICC_APDU_SW1_PROC_NULL);
+        CHECK_EQ(swicc_state.buf_rx_len, 0U);
+    }
+
+    /* A completion without a result lets the handler wait some more. */
+    swicc_apduh_pending_complete(&swicc_state);
+    swicc_state.buf_tx_len = sizeof(buf_tx);
+    swicc_fsm(&swicc_state);
+    REQUIRE_EQ(swicc_state.buf_tx_len, 1U);
+    CHECK_EQ(buf_tx[0U], SWICC_APDU_SW1_PROC_NULL);
+    swicc_state.buf_tx_len = sizeof(buf_tx);
+    swicc_fsm(&swicc_state);
+    REQUIRE_EQ(swicc_state.buf_tx_len, 1U);
+    CHECK_EQ(buf_tx[0U], SWICC_APDU_SW1_PROC_NULL);
+
+    /* Once resumed with a result, the response is sent. */
+    apduh_test_pending_result = true;
+    swicc_apduh_pending_complete(&swicc_state);
+    swicc_state.buf_tx_len = sizeof(buf_tx);
+    swicc_fsm(&swicc_state);
+    CHECK_EQ(swicc_state.internal.fsm_state, SWICC_FSM_STATE_CMD_WAIT);
+    CHECK_EQ(swicc_state.internal.apduh_pending, false);
+    REQUIRE_EQ(swicc_state.buf_tx_len, 2U);
+    CHECK_EQ(buf_tx[0U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+    CHECK_EQ(buf_tx[1U], 0x42);
+}
+
+static swicc_apduh_ft apduh_test_echo;
+static swicc_ret_et apduh_test_echo(swicc_st *const swicc_state,
+                                    swicc_apdu_cmd_st const *const cmd,
+                                    swicc_apdu_res_st *const res,
+                                    uint32_t const procedure_count)
+{
+    if (procedure_count == 0U)
+    {
+        /* Ask for all of the data. */
+        SWICC_APDUH_RES(res, SWICC_APDU_SW1_PROC_ACK_ALL, 0U, *cmd->p3);
+        return SWICC_RET_SUCCESS;
+    }
+    /* Send the data back, twice. */
+    swicc_apdu_rc_reset(&swicc_state->apdu_rc);
+    swicc_apdu_rc_enq(&swicc_state->apdu_rc, cmd->data->b, cmd->data->len);
+    swicc_apdu_rc_enq(&swicc_state->apdu_rc, cmd->data->b, cmd->data->len);
+    /* Safe cast since the test data is short. */
+    SWICC_APDUH_RES(res, SWICC_APDU_SW1_NORM_BYTES_AVAILABLE,
+                    (uint8_t)(cmd->data->len * 2U), 0U);
+    return SWICC_RET_SUCCESS;
+}
+
+TEST(apduh, swicc_apduh_exec)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    REQUIRE_EQ(swicc_apduh_register(&swicc_state,
+                                    SWICC_APDU_CLA_TYPE_PROPRIETARY, 0x20,
+                                    apduh_test_echo),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_apduh_pro_register(&swicc_state, apduh_test_pending),
+               SWICC_RET_SUCCESS);
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_len;
+
+    /* With Le, the bytes available are retrieved in the same call. */
+    uint8_t const capdu_le[] = {0x80, 0x20, 0x00, 0x00, 0x03,
+                                0xA1, 0xA2, 0xA3, 0x00};
+    uint8_t const rapdu_le[] = {0xA1, 0xA2, 0xA3, 0xA1, 0xA2, 0xA3,
+                                0x90, 0x00};
+    rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu_le, sizeof(capdu_le),
+                                rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len, sizeof(rapdu_le));
+    CHECK_BUF_EQ(rapdu, rapdu_le, sizeof(rapdu_le));
+
+    /* Without Le, the response says how many bytes are available. */
+    rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu_le, sizeof(capdu_le) - 1U,
+                                rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len, 2U);
+    CHECK_EQ(rapdu[0U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+    CHECK_EQ(rapdu[1U], 6U);
+
+    /* Lc not matching the data. */
+    rapdu_len = sizeof(rapdu);
+    CHECK_EQ(swicc_apduh_exec(&swicc_state, capdu_le, sizeof(capdu_le) - 2U,
+                              rapdu, &rapdu_len),
+             SWICC_RET_PARAM_BAD);
+
+    /* A pending handler finishes the exchange when resumed. */
+    uint8_t const capdu_pending[] = {0x80, 0x88, 0x42, 0x00};
+    apduh_test_pending_result = false;
+    rapdu_len = sizeof(rapdu);
+    CHECK_EQ(swicc_apduh_exec(&swicc_state, capdu_pending,
+                              sizeof(capdu_pending), rapdu, &rapdu_len),
+             SWICC_RET_APDU_PENDING);
+    CHECK_EQ(swicc_apduh_exec_resume(&swicc_state, rapdu, &rapdu_len),
+             SWICC_RET_APDU_PENDING);
+    apduh_test_pending_result = true;
+    swicc_apduh_pending_complete(&swicc_state);
+    REQUIRE_EQ(swicc_apduh_exec_resume(&swicc_state, rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len, 2U);
+    CHECK_EQ(rapdu[0U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+    CHECK_EQ(rapdu[1U], 0x42);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+}
@@ -0,0 +1,211 @@
+#include <tau/tau.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <swicc/swicc.h>
+#include <time.h>
+
+/* Makes every successful SELECT fail in a way the replay has to notice. */
+static swicc_ret_et capture_override(swicc_st *const swicc_state,
+                                     swicc_apdu_cmd_st const *const cmd,
+                                     swicc_apdu_res_st *const res,
+                                     uint32_t const procedure_count)
+{
+    if (cmd->hdr->ins == 0xA4 && res->sw1 == SWICC_APDU_SW1_NORM_NONE)
+    {
+        res->sw1 = SWICC_APDU_SW1_CHER_UNK;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/* If operations of 'capture_pending' complete once they were started. */
+static bool capture_pending_done;
+
+/* Waits for an external operation before answering. */
+static swicc_apduh_ft capture_pending;
+static swicc_ret_et capture_pending(swicc_st *const swicc_state,
+                                    swicc_apdu_cmd_st const *const cmd,
+                                    swicc_apdu_res_st *const res,
+                                    uint32_t const procedure_count)
+{
+    swicc_apduh_ctx_st *const apduh_ctx = &swicc_state->internal.apduh_ctx;
+    if (!apduh_ctx->valid || !capture_pending_done)
+    {
+        apduh_ctx->valid = true;
+        return SWICC_RET_APDU_PENDING;
+    }
+    res->sw1 = SWICC_APDU_SW1_NORM_NONE;
+    res->sw2 = 0U;
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Complete the operation of a pending handler a bit later.
+ * @param arg The swICC state.
+ * @return NULL.
+ */
+static void *capture_pending_complete(void *const arg)
+{
+    struct timespec const pause = {.tv_sec = 0, .tv_nsec = 10000000};
+    nanosleep(&pause, NULL);
+    swicc_apduh_pending_complete(arg);
+    return NULL;
+}
+
+TEST(capture, swicc_capture_replay)
+{
+    char const *const capture_path = "build/tmp/Vn2bQ8sLr4XkZc0m.swicccap";
+    static swicc_st swicc_state;
+    static swicc_capture_st capture;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(
+        swicc_capture_open(&capture, &swicc_state.fs.disk, capture_path),
+        SWICC_RET_SUCCESS);
+    swicc_state.capture = &capture;
+
+    uint8_t const capdu[][8U] = {
+        /* SELECT MF then an EF which gets its FCP with GET RESPONSE. */
+        {0x00, 0xA4, 0x00, 0x0C, 0x02, 0xE7, 0xC7},
+        {0x00, 0xA4, 0x00, 0x04, 0x02, 0xE9, 0x9D, 0x00},
+        {0x00, 0xB2, 0x01, 0x04, 0x00}, /* READ RECORD. */
+        {0x00, 0xFF, 0x00, 0x00},       /* Unknown INS. */
+    };
+    uint16_t const capdu_len[] = {7U, 8U, 5U, 4U};
+    for (uint32_t capdu_idx = 0U; capdu_idx < 4U; ++capdu_idx)
+    {
+        uint8_t rapdu[SWICC_DATA_MAX + 2U];
+        uint16_t rapdu_len = sizeof(rapdu);
+        REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu[capdu_idx],
+                                    capdu_len[capdu_idx], rapdu, &rapdu_len),
+                   SWICC_RET_SUCCESS);
+    }
+    swicc_state.capture = NULL;
+    REQUIRE_EQ(swicc_capture_close(&capture), SWICC_RET_SUCCESS);
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+
+    /* Replaying on the same disk gives back the same responses. */
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    swicc_capture_replay_st replay;
+    REQUIRE_EQ(swicc_capture_replay(&swicc_state, capture_path, &replay),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(replay.reset_count, 0U);
+    /* The GET RESPONSE sent for the 2nd SELECT is a command of its own. */
+    CHECK_EQ(replay.cmd_count, 5U);
+    CHECK_EQ(replay.mismatch_count, 0U);
+
+    /* Responses which differ are all counted. */
+    REQUIRE_EQ(swicc_apduh_override_register(&swicc_state, capture_override),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_capture_replay(&swicc_state, capture_path, &replay),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(replay.cmd_count, 5U);
+    CHECK_EQ(replay.mismatch_count, 1U);
+    CHECK_EQ(replay.mismatch_first, 0U);
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+
+    /* The capture only replays on the disk it was made with. */
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/007-in.json"),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_capture_replay(&swicc_state, capture_path, &replay),
+             SWICC_RET_ERROR);
+    swicc_disk_unload(&swicc_state.fs.disk);
+}
+
+TEST(capture, swicc_capture_reset)
+{
+    char const *const capture_path = "build/tmp/Jd7tWm1Pq9YfHs3e.swicccap";
+    static swicc_st swicc_state;
+    static swicc_capture_st capture;
+    uint8_t buf_rx[SWICC_DATA_MAX];
+    uint8_t buf_tx[SWICC_DATA_MAX];
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_state.buf_rx = buf_rx;
+    swicc_state.buf_tx = buf_tx;
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/007-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(
+        swicc_capture_open(&capture, &swicc_state.fs.disk, capture_path),
+        SWICC_RET_SUCCESS);
+    swicc_state.capture = &capture;
+    REQUIRE_EQ(swicc_reset(&swicc_state), SWICC_RET_SUCCESS);
+    uint8_t const capdu[] = {0x00, 0xA4, 0x00, 0x0C, 0x02, 0x3F, 0x00};
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu, sizeof(capdu), rapdu,
+                                &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_reset(&swicc_state), SWICC_RET_SUCCESS);
+    swicc_state.capture = NULL;
+    REQUIRE_EQ(swicc_capture_close(&capture), SWICC_RET_SUCCESS);
+
+    swicc_capture_replay_st replay;
+    REQUIRE_EQ(swicc_capture_replay(&swicc_state, capture_path, &replay),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(replay.reset_count, 2U);
+    CHECK_EQ(replay.cmd_count, 1U);
+    CHECK_EQ(replay.mismatch_count, 0U);
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+}
+
+TEST(capture, swicc_capture_replay__pending)
+{
+    char const *const capture_path = "build/tmp/Qm5cHv8ZtE2wLx6R.swicccap";
+    static swicc_st swicc_state;
+    static swicc_capture_st capture;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/007-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_apduh_pro_register(&swicc_state, capture_pending),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(
+        swicc_capture_open(&capture, &swicc_state.fs.disk, capture_path),
+        SWICC_RET_SUCCESS);
+    swicc_state.capture = &capture;
+    capture_pending_done = true;
+    uint8_t const capdu[] = {0x80, 0x88, 0x00, 0x00};
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu, sizeof(capdu), rapdu,
+                                &rapdu_len),
+               SWICC_RET_APDU_PENDING);
+    swicc_apduh_pending_complete(&swicc_state);
+    REQUIRE_EQ(swicc_apduh_exec_resume(&swicc_state, rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    swicc_state.capture = NULL;
+    REQUIRE_EQ(swicc_capture_close(&capture), SWICC_RET_SUCCESS);
+
+    /* An operation that never completes stops the replay instead of hanging. */
+    capture_pending_done = false;
+    swicc_capture_replay_st replay;
+    CHECK_EQ(swicc_capture_replay(&swicc_state, capture_path, &replay),
+             SWICC_RET_APDU_PENDING);
+    CHECK_EQ(replay.cmd_count, 0U);
+
+    /* One that completes meanwhile is waited on. */
+    capture_pending_done = true;
+    pthread_t thread;
+    REQUIRE_EQ(pthread_create(&thread, NULL, capture_pending_complete,
+                              &swicc_state),
+               0);
+    CHECK_EQ(swicc_capture_replay(&swicc_state, capture_path, &replay),
+             SWICC_RET_SUCCESS);
+    pthread_join(thread, NULL);
+    CHECK_EQ(replay.cmd_count, 1U);
+    CHECK_EQ(replay.mismatch_count, 0U);
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+}
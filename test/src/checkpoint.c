@@ -0,0 +1,131 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+/**
+ * @brief Fill the first record of a file with a byte.
+ * @param disk
+ * @param id ID of the file.
+ * @param byte
+ * @return Return code.
+ */
+static swicc_ret_et checkpoint_test_modify(swicc_disk_st *const disk,
+                                           swicc_fs_id_kt const id,
+                                           uint8_t const byte)
+{
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    uint8_t *rcrd;
+    uint8_t rcrd_len;
+    if (swicc_disk_lutid_lookup(disk, &tree, id, &file) != SWICC_RET_SUCCESS ||
+        swicc_disk_file_cow(tree, &file) != SWICC_RET_SUCCESS ||
+        swicc_disk_file_rcrd(tree, &file, 0U, &rcrd, &rcrd_len) !=
+            SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memset(rcrd, byte, rcrd_len);
+    /* Safe cast since the record is inside the file data. */
+    return swicc_disk_file_dirty_mark(tree, &file, (uint32_t)(rcrd - file.data),
+                                      rcrd_len);
+}
+
+TEST(checkpoint, swicc_checkpoint__disk)
+{
+    static swicc_st swicc_state;
+    static swicc_checkpoint_st checkpoint;
+    swicc_disk_st disk_base = {0U};
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_base, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+
+    /* Once for a disk of its own and once for an overlay of a base disk. */
+    for (uint8_t shared = 0U; shared < 2U; ++shared)
+    {
+        if (shared)
+        {
+            REQUIRE_EQ(
+                swicc_disk_overlay_create(&swicc_state.fs.disk, &disk_base),
+                SWICC_RET_SUCCESS);
+        }
+        else
+        {
+            REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                                "test/data/disk/006-in.json"),
+                       SWICC_RET_SUCCESS);
+        }
+        swicc_disk_tree_st *const tree = swicc_state.fs.disk.root;
+        uint8_t tree_buf[tree->len];
+        uint8_t tree_buf_cp[tree->len];
+
+        CHECK_EQ(checkpoint_test_modify(&swicc_state.fs.disk, 0xE99D, 0xA1),
+                 SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_checkpoint_capture(&checkpoint, &swicc_state),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_disk_tree_read(tree, 0U, tree->len, tree_buf_cp),
+                   SWICC_RET_SUCCESS);
+
+        /* Restoring twice must give the same disk both times. */
+        for (uint8_t restore = 0U; restore < 2U; ++restore)
+        {
+            CHECK_EQ(
+                checkpoint_test_modify(&swicc_state.fs.disk, 0xE99D, 0xB2),
+                SWICC_RET_SUCCESS);
+            CHECK_EQ(
+                checkpoint_test_modify(&swicc_state.fs.disk, 0x89E7, 0xC3),
+                SWICC_RET_SUCCESS);
+            CHECK_EQ(swicc_checkpoint_restore(&checkpoint, &swicc_state),
+                     SWICC_RET_SUCCESS);
+            REQUIRE_EQ(swicc_disk_tree_read(tree, 0U, tree->len, tree_buf),
+                       SWICC_RET_SUCCESS);
+            CHECK_BUF_EQ(tree_buf, tree_buf_cp, tree->len);
+        }
+        swicc_checkpoint_free(&checkpoint);
+        swicc_disk_unload(&swicc_state.fs.disk);
+    }
+    swicc_disk_unload(&disk_base);
+}
+
+TEST(checkpoint, swicc_checkpoint__state)
+{
+    static swicc_st swicc_state;
+    static swicc_checkpoint_st checkpoint;
+    uint8_t buf_rx[SWICC_DATA_MAX];
+    uint8_t buf_tx[SWICC_DATA_MAX];
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_state.buf_rx = buf_rx;
+    swicc_state.buf_tx = buf_tx;
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/007-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_mock_reset_cold(&swicc_state, true), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_checkpoint_capture(&checkpoint, &swicc_state),
+               SWICC_RET_SUCCESS);
+
+    /* Power the card off and come back to where it was without the ATR. */
+    REQUIRE_EQ(swicc_reset(&swicc_state), SWICC_RET_SUCCESS);
+    swicc_fsm_state_et state_fsm;
+    swicc_fsm_state(&swicc_state, &state_fsm);
+    CHECK_EQ(state_fsm, SWICC_FSM_STATE_OFF);
+    swicc_state.cont_state_rx = 0U;
+    REQUIRE_EQ(swicc_checkpoint_restore(&checkpoint, &swicc_state),
+               SWICC_RET_SUCCESS);
+    swicc_fsm_state(&swicc_state, &state_fsm);
+    CHECK_EQ(state_fsm, SWICC_FSM_STATE_CMD_WAIT);
+    CHECK_EQ(swicc_state.cont_state_rx, checkpoint.state->cont_state_rx);
+    CHECK_EQ(swicc_state.internal.tp.di, checkpoint.state->internal.tp.di);
+    CHECK_EQ(swicc_state.buf_rx, buf_rx);
+    CHECK_EQ(swicc_state.buf_tx_len, 0U);
+
+    /* A disk made of other trees can't be restored into. */
+    swicc_disk_tree_st *const tree = swicc_state.fs.disk.root;
+    swicc_state.fs.disk.root = NULL;
+    CHECK_EQ(swicc_checkpoint_restore(&checkpoint, &swicc_state),
+             SWICC_RET_ERROR);
+    swicc_state.fs.disk.root = tree;
+
+    swicc_checkpoint_free(&checkpoint);
+    CHECK_EQ(checkpoint.state, NULL);
+    swicc_terminate(&swicc_state);
+}
@@ -0,0 +1,96 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+TEST(common, swicc_hexstr_bytearr__valid)
+{
+    static char const hex_char[] = "0123456789ABCDEF";
+    char hexstr[2U * 80U];
+    uint8_t bytearr_exp[80U];
+    uint8_t bytearr[80U];
+    /* Cover lengths on both sides of the vectorized step sizes. */
+    for (uint32_t bytearr_len_exp = 0U; bytearr_len_exp <= sizeof(bytearr);
+         ++bytearr_len_exp)
+    {
+        for (uint32_t byte_idx = 0U; byte_idx < bytearr_len_exp; ++byte_idx)
+        {
+            /* Safe cast since only the lower 8 bits are kept. */
+            bytearr_exp[byte_idx] =
+                (uint8_t)((byte_idx * 151U + bytearr_len_exp * 31U) & 0xFFU);
+            hexstr[byte_idx * 2U] = hex_char[bytearr_exp[byte_idx] >> 4U];
+            hexstr[byte_idx * 2U + 1U] = hex_char[bytearr_exp[byte_idx] & 0xFU];
+        }
+        uint32_t bytearr_len = bytearr_len_exp;
+        REQUIRE_EQ(swicc_hexstr_bytearr(hexstr, bytearr_len_exp * 2U, bytearr,
+                                        &bytearr_len),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(bytearr_len, bytearr_len_exp);
+        CHECK_BUF_EQ(bytearr, bytearr_exp, bytearr_len);
+    }
+}
+
+TEST(common, swicc_hexstr_bytearr__invalid)
+{
+    char hexstr[2U * 40U];
+    uint8_t bytearr[40U];
+    uint32_t bytearr_len = sizeof(bytearr);
+    memset(hexstr, '5', sizeof(hexstr));
+    CHECK_EQ(swicc_hexstr_bytearr(hexstr, sizeof(hexstr) - 1U, bytearr,
+                                  &bytearr_len),
+             SWICC_RET_PARAM_BAD);
+    bytearr_len = sizeof(bytearr) - 1U;
+    CHECK_EQ(
+        swicc_hexstr_bytearr(hexstr, sizeof(hexstr), bytearr, &bytearr_len),
+        SWICC_RET_BUFFER_TOO_SHORT);
+
+    /* Every position must be validated, also inside the vectorized steps. */
+    static char const char_invalid[] = {'/', ':', '@', 'G', 'a', 'f', '\x80'};
+    for (uint32_t char_idx = 0U; char_idx < sizeof(hexstr); ++char_idx)
+    {
+        for (uint32_t invalid_idx = 0U; invalid_idx < sizeof(char_invalid);
+             ++invalid_idx)
+        {
+            hexstr[char_idx] = char_invalid[invalid_idx];
+            bytearr_len = sizeof(bytearr);
+            CHECK_EQ(swicc_hexstr_bytearr(hexstr, sizeof(hexstr), bytearr,
+                                          &bytearr_len),
+                     SWICC_RET_PARAM_BAD);
+        }
+        hexstr[char_idx] = '5';
+    }
+}
+
+TEST(common, swicc_mem_find)
+{
+    uint8_t buf[80U];
+    memset(buf, 0xAA, sizeof(buf));
+    static uint8_t const pat[] = {0x01, 0xAA, 0x02};
+    uint32_t offset;
+    CHECK_EQ(swicc_mem_find(buf, sizeof(buf), pat, 0U, &offset),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(offset, 0U);
+    CHECK_EQ(swicc_mem_find(buf, 2U, pat, sizeof(pat), &offset),
+             SWICC_RET_FS_NOT_FOUND);
+
+    /* Cover every position on both sides of the vectorized step sizes. */
+    for (uint32_t pat_offset = 0U; pat_offset + sizeof(pat) <= sizeof(buf);
+         ++pat_offset)
+    {
+        memcpy(&buf[pat_offset], pat, sizeof(pat));
+        /* A partial match right before must not be taken as a match. */
+        if (pat_offset >= 3U)
+        {
+            buf[pat_offset - 3U] = pat[0U];
+            buf[pat_offset - 2U] = 0xBB;
+            buf[pat_offset - 1U] = pat[2U];
+        }
+        REQUIRE_EQ(swicc_mem_find(buf, sizeof(buf), pat, sizeof(pat), &offset),
+                   SWICC_RET_SUCCESS);
+        CHECK_EQ(offset, pat_offset);
+        /* Cut off the last byte of the string. */
+        CHECK_EQ(swicc_mem_find(buf, pat_offset + sizeof(pat) - 1U, pat,
+                                sizeof(pat), &offset),
+                 SWICC_RET_FS_NOT_FOUND);
+        memset(buf, 0xAA, sizeof(buf));
+    }
+}
@@ -0,0 +1,53 @@
+#include <tau/tau.h>
+
+#include <string.h>
+#include <swicc/swicc.h>
+
+TEST(crc32c, swicc_crc32c)
+{
+    /* Check value of the CRC-32C catalogue entry. */
+    uint8_t const check[] = "123456789";
+    CHECK_EQ(swicc_crc32c(0U, check, sizeof(check) - 1U), 0xE3069283U);
+    CHECK_EQ(swicc_crc32c(0U, check, 0U), 0U);
+
+    /**
+     * Long enough to be split into lanes, at an odd address, and compared to
+     * going over it one byte at a time.
+     */
+    static uint8_t buf[4099U];
+    for (uint32_t byte_idx = 0U; byte_idx < sizeof(buf); ++byte_idx)
+    {
+        /* Safe cast since only the low byte is kept. */
+        buf[byte_idx] = (uint8_t)((byte_idx * 31U) ^ (byte_idx >> 8U));
+    }
+    uint32_t const crc = swicc_crc32c(0U, &buf[1U], sizeof(buf) - 1U);
+    uint32_t crc_byte = 0U;
+    for (uint32_t byte_idx = 1U; byte_idx < sizeof(buf); ++byte_idx)
+    {
+        crc_byte = swicc_crc32c(crc_byte, &buf[byte_idx], 1U);
+    }
+    CHECK_EQ(crc, crc_byte);
+}
+
+TEST(crc32c, swicc_crc32c_combine)
+{
+    static uint8_t buf[2000U];
+    for (uint32_t byte_idx = 0U; byte_idx < sizeof(buf); ++byte_idx)
+    {
+        /* Safe cast since only the low byte is kept. */
+        buf[byte_idx] = (uint8_t)(byte_idx * 7U);
+    }
+    uint32_t const crc = swicc_crc32c(0U, buf, sizeof(buf));
+    uint32_t const len_a_all[] = {0U, 1U, 256U, 1337U, sizeof(buf)};
+    for (uint32_t len_idx = 0U;
+         len_idx < sizeof(len_a_all) / sizeof(len_a_all[0U]); ++len_idx)
+    {
+        uint32_t const len_a = len_a_all[len_idx];
+        uint32_t const len_b = (uint32_t)sizeof(buf) - len_a;
+        uint32_t const crc_a = swicc_crc32c(0U, buf, len_a);
+        uint32_t const crc_b = swicc_crc32c(0U, &buf[len_a], len_b);
+        CHECK_EQ(swicc_crc32c_combine_op(crc_a, crc_b,
+                                         swicc_crc32c_combine_gen(len_b)),
+                 crc);
+    }
+}
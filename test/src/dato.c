@@ -0,0 +1,172 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+static bool tag_get(swicc_dato_bertlv_tag_st *const tag, uint8_t const tag_raw)
+{
+    uint32_t tag_len;
+    return swicc_dato_bertlv_tag_prs(tag, &tag_len, &tag_raw, 1U) ==
+               SWICC_RET_SUCCESS &&
+           tag_len == 1U;
+}
+
+TEST(dato, swicc_dato_bertlv_idx__lookup)
+{
+    uint8_t buf[11U + 133U + 6U] = {
+        0x6F, 0x09, 0x84, 0x02, 0xA0, 0x00, 0xA5, 0x03, 0x88, 0x01, 0x01,
+        0x5A, 0x81, 0x82,
+    };
+    /* A value of 130 bytes so the length uses the long form. */
+    memset(&buf[14U], 0xAB, 130U);
+    /* Two DOs with the same tag so the first one is expected to be found. */
+    uint8_t const dup[6U] = {0x84, 0x01, 0xFF, 0x84, 0x01, 0xEE};
+    memcpy(&buf[144U], dup, sizeof(dup));
+
+    swicc_dato_bertlv_idx_st idx;
+    REQUIRE_EQ(swicc_dato_bertlv_idx_build(&idx, NULL, buf, sizeof(buf)),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(idx.node_count, 7U);
+
+    swicc_dato_bertlv_tag_st tag_path[3U];
+    REQUIRE_EQ(tag_get(&tag_path[0U], 0x5A), true);
+    uint32_t node_idx;
+    REQUIRE_EQ(swicc_dato_bertlv_idx_lookup(&idx,
+                                            SWICC_DATO_BERTLV_NODE_PARENT_ROOT,
+                                            &tag_path[0U], &node_idx),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(idx.node[node_idx].offset, 11U);
+    CHECK_EQ(idx.node[node_idx].len_hdr, 3U);
+    CHECK_EQ(idx.node[node_idx].len_val, 130U);
+
+    REQUIRE_EQ(tag_get(&tag_path[0U], 0x84), true);
+    REQUIRE_EQ(swicc_dato_bertlv_idx_lookup_path(&idx, tag_path, 1U,
+                                                 &node_idx),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(idx.node[node_idx].offset, 144U);
+
+    REQUIRE_EQ(tag_get(&tag_path[0U], 0x6F), true);
+    REQUIRE_EQ(tag_get(&tag_path[1U], 0x84), true);
+    REQUIRE_EQ(swicc_dato_bertlv_idx_lookup_path(&idx, tag_path, 2U,
+                                                 &node_idx),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(idx.node[node_idx].offset, 2U);
+    CHECK_EQ(idx.node[node_idx].len_val, 2U);
+
+    REQUIRE_EQ(tag_get(&tag_path[1U], 0xA5), true);
+    REQUIRE_EQ(tag_get(&tag_path[2U], 0x88), true);
+    REQUIRE_EQ(swicc_dato_bertlv_idx_lookup_path(&idx, tag_path, 3U,
+                                                 &node_idx),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(idx.node[node_idx].offset, 8U);
+    CHECK_EQ(buf[idx.node[node_idx].offset + idx.node[node_idx].len_hdr],
+             0x01);
+
+    /* Nested DOs are not found at the root level. */
+    CHECK_EQ(swicc_dato_bertlv_idx_lookup_path(&idx, &tag_path[2U], 1U,
+                                               &node_idx),
+             SWICC_RET_FS_NOT_FOUND);
+    swicc_dato_bertlv_idx_free(&idx);
+}
+
+TEST(dato, swicc_dato_bertlv_idx__invalid)
+{
+    swicc_dato_bertlv_idx_st idx;
+    /* The value of the nested DO goes past the end of its parent. */
+    uint8_t buf_nstd[] = {0x6F, 0x03, 0x84, 0x02, 0xA0, 0x00};
+    CHECK_EQ(
+        swicc_dato_bertlv_idx_build(&idx, NULL, buf_nstd, sizeof(buf_nstd)),
+        SWICC_RET_ERROR);
+    /* The long length is cut short. */
+    uint8_t buf_len[] = {0x5A, 0x82, 0x01};
+    CHECK_EQ(swicc_dato_bertlv_idx_build(&idx, NULL, buf_len, sizeof(buf_len)),
+             SWICC_RET_ERROR);
+
+    /* An empty buffer has nothing to find. */
+    REQUIRE_EQ(swicc_dato_bertlv_idx_build(&idx, NULL, NULL, 0U),
+               SWICC_RET_SUCCESS);
+    swicc_dato_bertlv_tag_st tag;
+    REQUIRE_EQ(tag_get(&tag, 0x5A), true);
+    uint32_t node_idx;
+    CHECK_EQ(swicc_dato_bertlv_idx_lookup(
+                 &idx, SWICC_DATO_BERTLV_NODE_PARENT_ROOT, &tag, &node_idx),
+             SWICC_RET_FS_NOT_FOUND);
+    swicc_dato_bertlv_idx_free(&idx);
+}
+
+TEST(dato, swicc_dato_bertlv_dec_all__data)
+{
+    /* Mix of the short path and of long tags and lengths. */
+    uint8_t buf[] = {0x62, 0x0C, 0x82, 0x02, 0x41, 0x21, 0xBF, 0x1F, 0x81,
+                     0x04, 0x9F, 0x21, 0x01, 0x07, 0x8A, 0x00, 0x80, 0x00};
+    swicc_dato_bertlv_node_st node[sizeof(buf) / 2U];
+    uint32_t node_count;
+    REQUIRE_EQ(swicc_dato_bertlv_dec_all(buf, sizeof(buf), node,
+                                         sizeof(node) / sizeof(node[0U]),
+                                         &node_count),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(node_count, 6U);
+
+    uint32_t const depth_exp[] = {0U, 1U, 1U, 2U, 0U, 0U};
+    uint32_t const parent_exp[] = {SWICC_DATO_BERTLV_NODE_PARENT_ROOT,
+                                   0U,
+                                   0U,
+                                   2U,
+                                   SWICC_DATO_BERTLV_NODE_PARENT_ROOT,
+                                   SWICC_DATO_BERTLV_NODE_PARENT_ROOT};
+    uint32_t const offset_exp[] = {0U, 2U, 6U, 10U, 14U, 16U};
+    uint32_t const len_hdr_exp[] = {2U, 2U, 4U, 3U, 2U, 2U};
+    uint32_t const len_val_exp[] = {12U, 2U, 4U, 1U, 0U, 0U};
+    for (uint32_t node_idx = 0U; node_idx < node_count; ++node_idx)
+    {
+        CHECK_EQ(node[node_idx].depth, depth_exp[node_idx]);
+        CHECK_EQ(node[node_idx].parent_idx, parent_exp[node_idx]);
+        CHECK_EQ(node[node_idx].offset, offset_exp[node_idx]);
+        CHECK_EQ(node[node_idx].len_hdr, len_hdr_exp[node_idx]);
+        CHECK_EQ(node[node_idx].len_val, len_val_exp[node_idx]);
+    }
+
+    /* The short path must agree with the regular decoder. */
+    swicc_dato_bertlv_dec_st decoder;
+    swicc_dato_bertlv_dec_init(&decoder, buf, sizeof(buf));
+    REQUIRE_EQ(swicc_dato_bertlv_dec_next(&decoder), SWICC_RET_SUCCESS);
+    CHECK_EQ(node[0U].tag.num, decoder.cur.tag.num);
+    CHECK_EQ(node[0U].tag.cla, decoder.cur.tag.cla);
+    CHECK_EQ(node[0U].tag.pc, decoder.cur.tag.pc);
+
+    CHECK_EQ(swicc_dato_bertlv_dec_all(buf, sizeof(buf), node, 5U,
+                                       &node_count),
+             SWICC_RET_BUFFER_TOO_SHORT);
+}
+
+TEST(dato, swicc_dato_bertlv_dec_all__invalid)
+{
+    swicc_dato_bertlv_node_st node[32U];
+    uint32_t node_count;
+    /* Nested deeper than supported. */
+    uint8_t buf_deep[2U * (SWICC_DATO_BERTLV_DEPTH_MAX + 1U)];
+    for (uint32_t depth = 0U; depth <= SWICC_DATO_BERTLV_DEPTH_MAX; ++depth)
+    {
+        buf_deep[depth * 2U] = 0x62;
+        /* Safe cast since the buffer is far shorter than 256 bytes. */
+        buf_deep[depth * 2U + 1U] =
+            (uint8_t)(sizeof(buf_deep) - 2U * depth - 2U);
+    }
+    CHECK_EQ(swicc_dato_bertlv_dec_all(buf_deep, sizeof(buf_deep), node, 32U,
+                                       &node_count),
+             SWICC_RET_ERROR);
+    CHECK_EQ(swicc_dato_bertlv_dec_all(buf_deep, sizeof(buf_deep) - 2U, node,
+                                       32U, &node_count),
+             SWICC_RET_ERROR);
+    /* Exactly as deep as supported. */
+    buf_deep[sizeof(buf_deep) - 2U] = 0x82;
+    CHECK_EQ(swicc_dato_bertlv_dec_all(buf_deep, sizeof(buf_deep), node, 32U,
+                                       &node_count),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(node_count, SWICC_DATO_BERTLV_DEPTH_MAX + 1U);
+
+    /* A single stray byte after the last DO. */
+    uint8_t buf_stray[] = {0x82, 0x00, 0x82};
+    CHECK_EQ(swicc_dato_bertlv_dec_all(buf_stray, sizeof(buf_stray), node, 32U,
+                                       &node_count),
+             SWICC_RET_ERROR);
+}
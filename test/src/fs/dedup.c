@@ -0,0 +1,202 @@
+#include <tau/tau.h>
+
+#include <string.h>
+#include <swicc/swicc.h>
+
+/**
+ * @brief Get the first byte of the data of a file.
+ * @param disk
+ * @param id ID of the file.
+ * @return The byte, -1 on failure.
+ */
+static int32_t file_byte(swicc_disk_st *const disk, swicc_fs_id_kt const id)
+{
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    if (swicc_disk_lutid_lookup(disk, &tree, id, &file) != SWICC_RET_SUCCESS ||
+        file.data_size == 0U)
+    {
+        return -1;
+    }
+    return file.data[0U];
+}
+
+TEST(fs_dedup, swicc_disk_dedup__param_check)
+{
+    swicc_disk_dedup_st dedup;
+    swicc_disk_st disk = {0U};
+    CHECK_EQ(swicc_disk_dedup_init(NULL, NULL), SWICC_RET_PARAM_BAD);
+    REQUIRE_EQ(swicc_disk_dedup_init(&dedup, NULL), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_dedup(NULL, &dedup), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_dedup(&disk, &dedup), SWICC_RET_PARAM_BAD);
+    swicc_disk_dedup_tree_st *dedup_tree;
+    CHECK_EQ(swicc_disk_dedup_tree_get(&dedup, NULL, &dedup_tree),
+             SWICC_RET_PARAM_BAD);
+    swicc_disk_dedup_deinit(&dedup);
+}
+
+TEST(fs_dedup, swicc_disk_dedup)
+{
+    static swicc_disk_dedup_st dedup;
+    swicc_alloc_arena_st arena;
+    REQUIRE_EQ(swicc_alloc_arena_init(&arena, NULL, 0U), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_dedup_init(&dedup, &arena.alloc),
+               SWICC_RET_SUCCESS);
+    swicc_disk_st disk[3U] = {{0U}};
+    for (uint32_t disk_idx = 0U; disk_idx < 3U; ++disk_idx)
+    {
+        REQUIRE_EQ(swicc_diskjs_disk_create(&disk[disk_idx],
+                                            "test/data/disk/006-in.json"),
+                   SWICC_RET_SUCCESS);
+    }
+
+    /* The second card differs from the others in one file. */
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk[1U], &tree, 0xF4F4, &file),
+               SWICC_RET_SUCCESS);
+    file.data[0U] = 0x00;
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st *tree_cur = disk[0U].root; tree_cur != NULL;
+         tree_cur = tree_cur->next)
+    {
+        tree_count += 1U;
+    }
+
+    for (uint32_t disk_idx = 0U; disk_idx < 3U; ++disk_idx)
+    {
+        REQUIRE_EQ(swicc_disk_dedup(&disk[disk_idx], &dedup),
+                   SWICC_RET_SUCCESS);
+    }
+    /* Sharing again has no effect. */
+    REQUIRE_EQ(swicc_disk_dedup(&disk[0U], &dedup), SWICC_RET_SUCCESS);
+    CHECK_EQ(dedup.tree_count, tree_count);
+    CHECK_EQ(dedup.len_ref, dedup.len_held * 3U);
+    /* Trees of the store come from the allocator of the store. */
+    CHECK_EQ((void const *)dedup.tree[0U]->tree.alloc,
+             (void const *)&arena.alloc);
+
+    /* All cards use the same buffer and only the one file is kept aside. */
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk[1U], &tree, 0xF4F4, &file),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(tree->shared, true);
+    CHECK_EQ(tree->overlay_count, 1U);
+    for (uint32_t disk_idx = 0U; disk_idx < 3U; ++disk_idx)
+    {
+        CHECK_EQ((void *)disk[disk_idx].root->buf, (void *)disk[0U].root->buf);
+    }
+    CHECK_EQ(file_byte(&disk[0U], 0xF4F4), 0x3F);
+    CHECK_EQ(file_byte(&disk[1U], 0xF4F4), 0x00);
+    CHECK_EQ(file_byte(&disk[2U], 0xF4F4), 0x3F);
+
+    /* A write to a shared file stays local to its card. */
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk[2U], &tree, 0xF4F4, &file),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_file_cow(tree, &file), SWICC_RET_SUCCESS);
+    file.data[0U] = 0x01;
+    CHECK_EQ(file_byte(&disk[0U], 0xF4F4), 0x3F);
+    CHECK_EQ(file_byte(&disk[1U], 0xF4F4), 0x00);
+    CHECK_EQ(file_byte(&disk[2U], 0xF4F4), 0x01);
+
+    /* Private files are saved like the shared ones. */
+    char const *const disk_path = "build/tmp/Qz7mK3xTgW5pLr9N.swiccfs";
+    REQUIRE_EQ(swicc_disk_save(&disk[1U], disk_path), SWICC_RET_SUCCESS);
+    swicc_disk_st disk_saved = {0U};
+    REQUIRE_EQ(swicc_disk_load(&disk_saved, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(file_byte(&disk_saved, 0xF4F4), 0x00);
+    swicc_disk_unload(&disk_saved);
+
+    /* Trees held by the store are freed with the last card sharing them. */
+    swicc_disk_unload(&disk[0U]);
+    swicc_disk_unload(&disk[1U]);
+    CHECK_EQ(dedup.tree_count, tree_count);
+    CHECK_EQ(dedup.len_ref, dedup.len_held);
+    swicc_disk_unload(&disk[2U]);
+    CHECK_EQ(dedup.tree_count, 0U);
+    CHECK_EQ(dedup.len_held, 0U);
+    swicc_disk_dedup_deinit(&dedup);
+    swicc_alloc_arena_free(&arena);
+}
+
+TEST(fs_dedup, swicc_disk_dedup__extent)
+{
+    static swicc_disk_dedup_st dedup;
+    REQUIRE_EQ(swicc_disk_dedup_init(&dedup, NULL), SWICC_RET_SUCCESS);
+    swicc_disk_dedup_extent_st *extent;
+    CHECK_EQ(swicc_disk_dedup_extent_get(NULL, NULL, 0U, &extent),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_dedup_extent_get(&dedup, NULL, 1U, &extent),
+             SWICC_RET_PARAM_BAD);
+    swicc_disk_st disk[3U] = {{0U}};
+    for (uint32_t disk_idx = 0U; disk_idx < 3U; ++disk_idx)
+    {
+        REQUIRE_EQ(swicc_diskjs_disk_create(&disk[disk_idx],
+                                            "test/data/disk/006-in.json"),
+                   SWICC_RET_SUCCESS);
+    }
+
+    /* The last two cards differ from the first one in the same way. */
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file[3U];
+    for (uint32_t disk_idx = 1U; disk_idx < 3U; ++disk_idx)
+    {
+        REQUIRE_EQ(swicc_disk_lutid_lookup(&disk[disk_idx], &tree, 0xF4F4,
+                                           &file[disk_idx]),
+                   SWICC_RET_SUCCESS);
+        file[disk_idx].data[0U] = 0x00;
+    }
+    for (uint32_t disk_idx = 0U; disk_idx < 3U; ++disk_idx)
+    {
+        REQUIRE_EQ(swicc_disk_dedup(&disk[disk_idx], &dedup),
+                   SWICC_RET_SUCCESS);
+    }
+
+    /* Both of them share one copy of the data of the file. */
+    for (uint32_t disk_idx = 0U; disk_idx < 3U; ++disk_idx)
+    {
+        REQUIRE_EQ(swicc_disk_lutid_lookup(&disk[disk_idx], &tree, 0xF4F4,
+                                           &file[disk_idx]),
+                   SWICC_RET_SUCCESS);
+    }
+    REQUIRE_EQ(dedup.extent_count, 1U);
+    CHECK_EQ(dedup.extent[0U]->ref_count, 2U);
+    CHECK_EQ(dedup.extent_len_held, file[1U].data_size);
+    CHECK_EQ(dedup.extent_len_ref, file[1U].data_size * 2U);
+    CHECK_EQ((void *)file[1U].data, (void *)dedup.extent[0U]->data);
+    CHECK_EQ((void *)file[2U].data, (void *)dedup.extent[0U]->data);
+    CHECK_NE((void *)file[0U].data, (void *)dedup.extent[0U]->data);
+
+    /* A write to a shared extent goes to a private copy. */
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk[2U], &tree, 0xF4F4, &file[2U]),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_file_cow(tree, &file[2U]), SWICC_RET_SUCCESS);
+    CHECK_NE((void *)file[2U].data, (void *)dedup.extent[0U]->data);
+    file[2U].data[0U] = 0x01;
+    CHECK_EQ(dedup.extent[0U]->ref_count, 1U);
+    CHECK_EQ(dedup.extent_len_ref, dedup.extent_len_held);
+    CHECK_EQ(file_byte(&disk[0U], 0xF4F4), 0x3F);
+    CHECK_EQ(file_byte(&disk[1U], 0xF4F4), 0x00);
+    CHECK_EQ(file_byte(&disk[2U], 0xF4F4), 0x01);
+
+    /* So does one through the tree, and the unused extent gets freed. */
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk[1U], &tree, 0xF4F4, &file[1U]),
+               SWICC_RET_SUCCESS);
+    uint8_t const byte = 0x02;
+    REQUIRE_EQ(swicc_disk_tree_write(
+                   tree,
+                   file[1U].hdr_item.offset_trel +
+                       swicc_fs_item_hdr_raw_size[file[1U].hdr_item.type],
+                   sizeof(byte), &byte),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(dedup.extent_count, 0U);
+    CHECK_EQ(dedup.extent_len_held, 0U);
+    CHECK_EQ(file_byte(&disk[1U], 0xF4F4), 0x02);
+    CHECK_EQ(file_byte(&disk[0U], 0xF4F4), 0x3F);
+
+    for (uint32_t disk_idx = 0U; disk_idx < 3U; ++disk_idx)
+    {
+        swicc_disk_unload(&disk[disk_idx]);
+    }
+    CHECK_EQ(dedup.tree_count, 0U);
+    swicc_disk_dedup_deinit(&dedup);
+}
@@ -1,7 +1,11 @@
 #include <tau/tau.h>
 
+#include "src/fs/disk_internal.h"
 #include <cJSON.h>
+#include <signal.h>
 #include <swicc/swicc.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 static int32_t filesize(char const *const path, uint32_t *const size)
 {
@@ -23,7 +27,8 @@ static int32_t filesize(char const *const path, uint32_t *const size)
 }
 
 /**
- * @warning The static function 'lut_insert' is not tested because it's static.
+ * @warning The static functions 'lut_append' and 'lut_sort' are not tested
+ * because they're static.
  */
 
 TEST(fs_disk, swicc_disk_save__param_check)
@@ -64,6 +69,413 @@ TEST(fs_disk, swicc_disk_save__disk)
     }
 }
 
+TEST(fs_disk, swicc_disk_save_index__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    char const *const disk_path = "";
+    CHECK_EQ(swicc_disk_save_index(NULL, disk_path), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_save_index(disk, NULL), SWICC_RET_PARAM_BAD);
+}
+
+/**
+ * @brief Check that the LUTs of two disks are identical.
+ * @param disk_a
+ * @param disk_b
+ * @return 0 if identical, 1 otherwise.
+ */
+static int32_t disk_lut_cmp(swicc_disk_st const *const disk_a,
+                            swicc_disk_st const *const disk_b)
+{
+    swicc_disk_lut_st const *const lutid_a = &disk_a->lutid;
+    swicc_disk_lut_st const *const lutid_b = &disk_b->lutid;
+    swicc_disk_lut_st const *const lutname_a = &disk_a->lutname;
+    swicc_disk_lut_st const *const lutname_b = &disk_b->lutname;
+    if (lutname_a->count != lutname_b->count ||
+        memcmp(lutname_a->buf1, lutname_b->buf1,
+               lutname_a->count * lutname_a->size_item1) != 0 ||
+        memcmp(lutname_a->buf2, lutname_b->buf2,
+               lutname_a->count * lutname_a->size_item2) != 0)
+    {
+        return 1;
+    }
+    if (lutid_a->count != lutid_b->count ||
+        memcmp(lutid_a->buf1, lutid_b->buf1,
+               lutid_a->count * lutid_a->size_item1) != 0 ||
+        memcmp(lutid_a->buf2, lutid_b->buf2,
+               lutid_a->count * lutid_a->size_item2) != 0)
+    {
+        return 1;
+    }
+    swicc_disk_tree_st const *tree_a = disk_a->root;
+    swicc_disk_tree_st const *tree_b = disk_b->root;
+    for (; tree_a != NULL && tree_b != NULL;
+         tree_a = tree_a->next, tree_b = tree_b->next)
+    {
+        if (tree_a->lutsid.count != tree_b->lutsid.count ||
+            memcmp(tree_a->lutsid.buf1, tree_b->lutsid.buf1,
+                   tree_a->lutsid.count * tree_a->lutsid.size_item1) != 0 ||
+            memcmp(tree_a->lutsid.buf2, tree_b->lutsid.buf2,
+                   tree_a->lutsid.count * tree_a->lutsid.size_item2) != 0 ||
+            memcmp(tree_a->lutsid_direct, tree_b->lutsid_direct,
+                   sizeof(tree_a->lutsid_direct)) != 0)
+        {
+            return 1;
+        }
+    }
+    return tree_a == tree_b ? 0 : 1;
+}
+
+TEST(fs_disk, swicc_disk_save_index__disk)
+{
+    char const *const disk_path = "build/tmp/T5mcy2Qe0JbWvXoN.swiccfs";
+    swicc_disk_st disk_exp = {0U};
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_exp, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save_index(&disk_exp, disk_path), SWICC_RET_SUCCESS);
+
+    /* Both loaders shall use the index and end up with the same LUTs. */
+    REQUIRE_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_lut_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+    REQUIRE_EQ(swicc_disk_load_mmap(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_lut_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+
+    /**
+     * Corrupt the offset of the first ID LUT entry, the loader shall notice and
+     * rebuild the LUTs instead.
+     */
+    uint32_t tree_count = 0U;
+    for (swicc_disk_tree_st *tree = disk_exp.root; tree != NULL;
+         tree = tree->next)
+    {
+        tree_count += 1U;
+    }
+    FILE *const fdisk = fopen(disk_path, "r+b");
+    REQUIRE_NE(fdisk, NULL);
+    uint8_t const corrupt = 0xA5;
+    CHECK_EQ(fseek(fdisk,
+                   (long)(SWICC_DISK_MAGIC_LEN +
+                          sizeof(swicc_disk_index_hdr_raw_st) +
+                          (tree_count * sizeof(swicc_disk_index_tree_raw_st)) +
+                          (disk_exp.lutid.count * disk_exp.lutid.size_item1)),
+                   SEEK_SET),
+             0);
+    CHECK_EQ(fwrite(&corrupt, sizeof(corrupt), 1U, fdisk), 1U);
+    fclose(fdisk);
+    REQUIRE_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_lut_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+    swicc_disk_unload(&disk_exp);
+}
+
+/**
+ * @brief Compare the trees of two disks.
+ * @param disk_a
+ * @param disk_b
+ * @return 0 if the trees are equal, non-zero otherwise.
+ */
+static int32_t disk_tree_cmp(swicc_disk_st const *const disk_a,
+                             swicc_disk_st const *const disk_b)
+{
+    swicc_disk_tree_st const *tree_a = disk_a->root;
+    swicc_disk_tree_st const *tree_b = disk_b->root;
+    for (; tree_a != NULL && tree_b != NULL;
+         tree_a = tree_a->next, tree_b = tree_b->next)
+    {
+        if (tree_a->len != tree_b->len ||
+            memcmp(tree_a->buf, tree_b->buf, tree_a->len) != 0)
+        {
+            return -1;
+        }
+    }
+    return tree_a == tree_b ? 0 : -1;
+}
+
+TEST(fs_disk, swicc_disk_journal__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    swicc_disk_tree_st *const tree = (swicc_disk_tree_st *)1U;
+    swicc_fs_file_st *const file = (swicc_fs_file_st *)1U;
+    char const *const path = "";
+    CHECK_EQ(swicc_disk_journal_open(NULL, path, 0U), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_open(disk, NULL, 0U), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_close(NULL), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_sync(NULL), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_append(NULL, tree, file, 0U, 0U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_append(disk, NULL, file, 0U, 0U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_append(disk, tree, NULL, 0U, 0U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_replay(NULL, path), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_replay(disk, NULL), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_compact(NULL, path), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_journal_compact(disk, NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_journal__disk)
+{
+    char const *const disk_path = "build/tmp/q3VhJx8RkLw0cTzA.swiccfs";
+    char const *const journal_path = "build/tmp/q3VhJx8RkLw0cTzA.journal";
+    static swicc_fs_id_kt const file_id[2U] = {0xE99D, 0x89E7};
+    remove(journal_path);
+
+    swicc_disk_st disk = {0U};
+    swicc_disk_st disk_replay = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save(&disk, disk_path), SWICC_RET_SUCCESS);
+
+    /* Modify one record of a few files and journal each modification. */
+    REQUIRE_EQ(swicc_disk_journal_open(&disk, journal_path, 1U),
+               SWICC_RET_SUCCESS);
+    for (uint8_t file_idx = 0U; file_idx < 2U; ++file_idx)
+    {
+        swicc_disk_tree_st *tree;
+        swicc_fs_file_st file;
+        uint8_t *rcrd;
+        uint8_t rcrd_len;
+        REQUIRE_EQ(
+            swicc_disk_lutid_lookup(&disk, &tree, file_id[file_idx], &file),
+            SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_disk_file_rcrd(tree, &file, 1U, &rcrd, &rcrd_len),
+                   SWICC_RET_SUCCESS);
+        memset(rcrd, 0xA0 + file_idx, rcrd_len);
+        /* Safe cast since the record is inside the file data. */
+        CHECK_EQ(swicc_disk_journal_append(&disk, tree, &file,
+                                           (uint32_t)(rcrd - file.data),
+                                           rcrd_len),
+                 SWICC_RET_SUCCESS);
+    }
+    CHECK_EQ(swicc_disk_journal_close(&disk), SWICC_RET_SUCCESS);
+
+    /* Replaying onto the saved disk shall give back the modified disk. */
+    REQUIRE_EQ(swicc_disk_load(&disk_replay, disk_path), SWICC_RET_SUCCESS);
+    CHECK_NE(disk_tree_cmp(&disk, &disk_replay), 0);
+    CHECK_EQ(swicc_disk_journal_replay(&disk_replay, journal_path),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_tree_cmp(&disk, &disk_replay), 0);
+    swicc_disk_unload(&disk_replay);
+
+    /* A torn record at the end shall be ignored and cut off. */
+    uint32_t journal_size;
+    REQUIRE_EQ(filesize(journal_path, &journal_size), 0);
+    FILE *const fjournal = fopen(journal_path, "ab");
+    REQUIRE_NE(fjournal, NULL);
+    uint32_t const magic = SWICC_DISK_JOURNAL_MAGIC;
+    CHECK_EQ(fwrite(&magic, sizeof(magic), 1U, fjournal), 1U);
+    fclose(fjournal);
+    REQUIRE_EQ(swicc_disk_load(&disk_replay, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_journal_replay(&disk_replay, journal_path),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_tree_cmp(&disk, &disk_replay), 0);
+    uint32_t journal_size_replay;
+    REQUIRE_EQ(filesize(journal_path, &journal_size_replay), 0);
+    CHECK_EQ(journal_size_replay, journal_size);
+
+    /* Compaction shall persist the disk and empty the journal. */
+    REQUIRE_EQ(swicc_disk_journal_open(&disk_replay, journal_path, 0U),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_journal_compact(&disk_replay, disk_path),
+             SWICC_RET_SUCCESS);
+    REQUIRE_EQ(filesize(journal_path, &journal_size_replay), 0);
+    CHECK_EQ(journal_size_replay, 0U);
+    swicc_disk_unload(&disk_replay);
+    REQUIRE_EQ(swicc_disk_load(&disk_replay, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_tree_cmp(&disk, &disk_replay), 0);
+    swicc_disk_unload(&disk_replay);
+    swicc_disk_unload(&disk);
+}
+
+TEST(fs_disk, swicc_disk_journal_append__torn)
+{
+    char const *const journal_path = "build/tmp/Tn4cXw7QeLm2rHsV.journal";
+    remove(journal_path);
+    swicc_disk_st disk = {0U};
+    swicc_disk_st disk_replay = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk_replay,
+                                        "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_journal_open(&disk, journal_path, 0U),
+               SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk, &tree, 0xF4F4, &file),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_file_cow(tree, &file), SWICC_RET_SUCCESS);
+    file.data[0U] = 0xA0;
+    CHECK_EQ(swicc_disk_journal_append(&disk, tree, &file, 0U, 1U),
+             SWICC_RET_SUCCESS);
+    uint32_t journal_size;
+    REQUIRE_EQ(filesize(journal_path, &journal_size), 0);
+
+    /* A record that only fits in part is not left behind in the journal. */
+    struct rlimit limit_old;
+    REQUIRE_EQ(getrlimit(RLIMIT_FSIZE, &limit_old), 0);
+    void (*const sigxfsz_old)(int) = signal(SIGXFSZ, SIG_IGN);
+    struct rlimit const limit = {
+        .rlim_cur = journal_size + 4U,
+        .rlim_max = limit_old.rlim_max,
+    };
+    REQUIRE_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+    file.data[1U] = 0xA1;
+    CHECK_EQ(swicc_disk_journal_append(&disk, tree, &file, 0U, 2U),
+             SWICC_RET_ERROR);
+    REQUIRE_EQ(setrlimit(RLIMIT_FSIZE, &limit_old), 0);
+    signal(SIGXFSZ, sigxfsz_old);
+    uint32_t journal_size_torn;
+    REQUIRE_EQ(filesize(journal_path, &journal_size_torn), 0);
+    CHECK_EQ(journal_size_torn, journal_size);
+
+    /* So records appended after it are replayed. */
+    file.data[2U] = 0xA2;
+    CHECK_EQ(swicc_disk_journal_append(&disk, tree, &file, 0U, 3U),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_journal_close(&disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_journal_replay(&disk_replay, journal_path),
+             SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *tree_replay;
+    swicc_fs_file_st file_replay;
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk_replay, &tree_replay, 0xF4F4,
+                                       &file_replay),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(file_replay.data, file.data, 3U);
+    swicc_disk_unload(&disk_replay);
+    swicc_disk_unload(&disk);
+}
+
+TEST(fs_disk, swicc_disk_load__v1)
+{
+    /* Saved before cyclic EFs had a record head, with a journal of 1 write. */
+    char const *const disk_path = "test/data/disk/006-v1.swiccfs";
+    char const *const journal_path_v1 = "test/data/disk/006-v1.journal";
+    char const *const journal_path = "build/tmp/Wb5nYr8KdPq2sFxM.journal";
+    swicc_disk_st disk = {0U};
+    CHECK_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk.root, NULL);
+    CHECK_EQ(swicc_disk_load_mmap(&disk, disk_path), SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk.root, NULL);
+    CHECK_EQ(swicc_disk_load_lazy(&disk, disk_path), SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk.root, NULL);
+    CHECK_EQ(swicc_disk_load_parallel(&disk, disk_path, 2U), SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk.root, NULL);
+
+    /* The old journal is kept as is instead of being cut off as torn. */
+    uint8_t journal[64U];
+    FILE *f = fopen(journal_path_v1, "rb");
+    REQUIRE_NE(f, NULL);
+    size_t const journal_len = fread(journal, 1U, sizeof(journal), f);
+    fclose(f);
+    REQUIRE_EQ(journal_len > 0U && journal_len < sizeof(journal), true);
+    f = fopen(journal_path, "wb");
+    REQUIRE_NE(f, NULL);
+    REQUIRE_EQ(fwrite(journal, journal_len, 1U, f), 1U);
+    fclose(f);
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_journal_replay(&disk, journal_path), SWICC_RET_ERROR);
+    CHECK_EQ(swicc_disk_journal_open(&disk, journal_path, 1U),
+             SWICC_RET_ERROR);
+    uint32_t journal_size;
+    REQUIRE_EQ(filesize(journal_path, &journal_size), 0);
+    CHECK_EQ(journal_size, journal_len);
+    swicc_disk_unload(&disk);
+}
+
+TEST(fs_disk, swicc_disk_txn__disk)
+{
+    char const *const disk_path = "build/tmp/Hs7cQe2VnXbL5uTk.swiccfs";
+    char const *const journal_path = "build/tmp/Hs7cQe2VnXbL5uTk.journal";
+    static swicc_fs_id_kt const file_id[2U] = {0xE99D, 0x89E7};
+    remove(journal_path);
+
+    swicc_disk_st disk = {0U};
+    swicc_disk_st disk_replay = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save(&disk, disk_path), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_journal_open(&disk, journal_path, 1U),
+               SWICC_RET_SUCCESS);
+
+    /* Nothing is written before the commit. */
+    swicc_disk_txn_st txn;
+    REQUIRE_EQ(swicc_disk_txn_begin(&disk, &txn), SWICC_RET_SUCCESS);
+    uint8_t rcrd_new[16U];
+    for (uint8_t file_idx = 0U; file_idx < 2U; ++file_idx)
+    {
+        swicc_disk_tree_st *tree;
+        swicc_fs_file_st file;
+        uint8_t *rcrd;
+        uint8_t rcrd_len;
+        REQUIRE_EQ(
+            swicc_disk_lutid_lookup(&disk, &tree, file_id[file_idx], &file),
+            SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_disk_file_rcrd(tree, &file, 1U, &rcrd, &rcrd_len),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(rcrd_len <= sizeof(rcrd_new), true);
+        memset(rcrd_new, 0xB0 + file_idx, rcrd_len);
+        /* Safe cast since the record is inside the file data. */
+        CHECK_EQ(swicc_disk_txn_write(&txn, tree, &file,
+                                      (uint32_t)(rcrd - file.data), rcrd_new,
+                                      rcrd_len),
+                 SWICC_RET_SUCCESS);
+        CHECK_NE(rcrd[0U], rcrd_new[0U]);
+        CHECK_EQ(swicc_disk_txn_write(&txn, tree, &file, file.data_size,
+                                      rcrd_new, 1U),
+                 SWICC_RET_PARAM_BAD);
+    }
+    uint32_t journal_size;
+    REQUIRE_EQ(filesize(journal_path, &journal_size), 0);
+    CHECK_EQ(journal_size, 0U);
+
+    /* All writes are applied and appended as one record. */
+    uint32_t const txn_len = txn.len;
+    CHECK_EQ(swicc_disk_txn_commit(&txn), SWICC_RET_SUCCESS);
+    CHECK_EQ((void *)txn.buf, NULL);
+    REQUIRE_EQ(filesize(journal_path, &journal_size), 0);
+    CHECK_EQ(journal_size,
+             sizeof(swicc_disk_journal_rcrd_hdr_raw_st) + txn_len);
+    for (uint8_t file_idx = 0U; file_idx < 2U; ++file_idx)
+    {
+        swicc_disk_tree_st *tree;
+        swicc_fs_file_st file;
+        uint8_t *rcrd;
+        uint8_t rcrd_len;
+        REQUIRE_EQ(
+            swicc_disk_lutid_lookup(&disk, &tree, file_id[file_idx], &file),
+            SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_disk_file_rcrd(tree, &file, 1U, &rcrd, &rcrd_len),
+                   SWICC_RET_SUCCESS);
+        CHECK_EQ(rcrd[0U], 0xB0 + file_idx);
+    }
+    CHECK_EQ(swicc_disk_journal_close(&disk), SWICC_RET_SUCCESS);
+
+    REQUIRE_EQ(swicc_disk_load(&disk_replay, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_journal_replay(&disk_replay, journal_path),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_tree_cmp(&disk, &disk_replay), 0);
+    swicc_disk_unload(&disk_replay);
+
+    /* A torn transaction shall apply none of its writes. */
+    REQUIRE_EQ(truncate(journal_path, journal_size - 1U), 0);
+    REQUIRE_EQ(swicc_disk_load(&disk_replay, disk_path), SWICC_RET_SUCCESS);
+    CHECK_NE(disk_tree_cmp(&disk, &disk_replay), 0);
+    CHECK_EQ(swicc_disk_journal_replay(&disk_replay, journal_path),
+             SWICC_RET_SUCCESS);
+    swicc_disk_unload(&disk);
+    REQUIRE_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_tree_cmp(&disk, &disk_replay), 0);
+    REQUIRE_EQ(filesize(journal_path, &journal_size), 0);
+    CHECK_EQ(journal_size, 0U);
+    swicc_disk_unload(&disk_replay);
+    swicc_disk_unload(&disk);
+}
+
 TEST(fs_disk, swicc_disk_load__param_check)
 {
     swicc_disk_st *const disk = (swicc_disk_st *)1U;
@@ -106,6 +518,376 @@ TEST(fs_disk, swicc_disk_load__disk)
     }
 }
 
+TEST(fs_disk, swicc_disk_load_mmap__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    char const *const disk_path = "";
+    CHECK_EQ(swicc_disk_load_mmap(NULL, disk_path), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_load_mmap(disk, NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_load_mmap__disk)
+{
+    char const *const disk_path0 = "build/tmp/qX8h3LbVuT1cEJmA.swiccfs";
+    char const *const disk_path1 = "build/tmp/Wd4nRp0KsYg7ZoHf.swiccfs";
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/004-in.json"),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_save(&disk, disk_path0), SWICC_RET_SUCCESS);
+    swicc_disk_unload(&disk);
+    REQUIRE_EQ(swicc_disk_load_mmap(&disk, disk_path0), SWICC_RET_SUCCESS);
+    CHECK_NE(disk.map, NULL);
+
+    /* Writes to the mapped disk must never reach the file. */
+    uint8_t const byte_last = disk.root->buf[disk.root->len - 1U];
+    disk.root->buf[disk.root->len - 1U] = (uint8_t)~byte_last;
+    CHECK_EQ(swicc_disk_save(&disk, disk_path1), SWICC_RET_SUCCESS);
+    disk.root->buf[disk.root->len - 1U] = byte_last;
+    swicc_disk_unload(&disk);
+
+    uint32_t disk_filesize0;
+    uint32_t disk_filesize1;
+    REQUIRE_EQ(filesize(disk_path0, &disk_filesize0), 0);
+    REQUIRE_EQ(filesize(disk_path1, &disk_filesize1), 0);
+    REQUIRE_EQ(disk_filesize0, disk_filesize1);
+    uint8_t disk_buf0[disk_filesize0];
+    uint8_t disk_buf1[disk_filesize1];
+    FILE *const fdisk0 = fopen(disk_path0, "rb");
+    FILE *const fdisk1 = fopen(disk_path1, "rb");
+    REQUIRE_NE(fdisk0, NULL);
+    REQUIRE_NE(fdisk1, NULL);
+    CHECK_EQ(fread(disk_buf0, disk_filesize0, 1U, fdisk0), 1U);
+    CHECK_EQ(fread(disk_buf1, disk_filesize1, 1U, fdisk1), 1U);
+    fclose(fdisk0);
+    fclose(fdisk1);
+    /* Only the modified byte shall differ between the two files. */
+    uint32_t diff_count = 0U;
+    for (uint32_t byte_idx = 0U; byte_idx < disk_filesize0; ++byte_idx)
+    {
+        diff_count += disk_buf0[byte_idx] != disk_buf1[byte_idx] ? 1U : 0U;
+    }
+    CHECK_EQ(diff_count, 1U);
+}
+
+TEST(fs_disk, swicc_disk_load_lazy__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    char const *const disk_path = "";
+    CHECK_EQ(swicc_disk_load_lazy(NULL, disk_path), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_load_lazy(disk, NULL), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_tree_load(NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_load_lazy__disk)
+{
+    char const *const disk_path_plain = "build/tmp/Nc4vLr8TsQm2XyWb.swiccfs";
+    char const *const disk_path_index = "build/tmp/Hd7pKw1ZeJf6UaGo.swiccfs";
+    swicc_disk_st disk_exp = {0U};
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_exp, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save(&disk_exp, disk_path_plain), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save_index(&disk_exp, disk_path_index),
+               SWICC_RET_SUCCESS);
+
+    /* Without an index, everything is loaded right away. */
+    REQUIRE_EQ(swicc_disk_load_lazy(&disk, disk_path_plain), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk.lazy, false);
+    CHECK_EQ(disk_lut_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+
+    /* With an index, no tree is read until it gets accessed. */
+    REQUIRE_EQ(swicc_disk_load_lazy(&disk, disk_path_index), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk.lazy, true);
+    REQUIRE_EQ(disk.lutid_tree_count, disk_exp.lutid_tree_count);
+    for (uint32_t tree_idx = 0U; tree_idx < disk.lutid_tree_count; ++tree_idx)
+    {
+        CHECK_EQ(disk.lutid_tree[tree_idx]->lazy, true);
+        CHECK_EQ(disk.lutid_tree[tree_idx]->buf, NULL);
+    }
+
+    /* A lookup reads only the tree containing the file. */
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    CHECK_EQ(swicc_disk_lutid_lookup(&disk, &tree, 0x89E7, &file),
+             SWICC_RET_SUCCESS);
+    uint32_t tree_loaded_count = 0U;
+    for (uint32_t tree_idx = 0U; tree_idx < disk.lutid_tree_count; ++tree_idx)
+    {
+        swicc_disk_tree_st const *const tree_cur = disk.lutid_tree[tree_idx];
+        swicc_disk_tree_st const *const tree_exp =
+            disk_exp.lutid_tree[tree_idx];
+        if (!tree_cur->lazy)
+        {
+            tree_loaded_count += 1U;
+            CHECK_EQ(tree_cur, tree);
+            REQUIRE_EQ(tree_cur->len, tree_exp->len);
+            CHECK_EQ(memcmp(tree_cur->buf, tree_exp->buf, tree_exp->len), 0);
+            CHECK_EQ(tree_cur->lutsid.count, tree_exp->lutsid.count);
+        }
+    }
+    CHECK_EQ(tree_loaded_count, 1U);
+
+    /* Saving reads all remaining trees. */
+    CHECK_EQ(swicc_disk_save_index(&disk, disk_path_index), SWICC_RET_SUCCESS);
+    swicc_disk_unload(&disk);
+    REQUIRE_EQ(swicc_disk_load(&disk, disk_path_index), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_lut_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+    swicc_disk_unload(&disk_exp);
+}
+
+TEST(fs_disk, swicc_disk_load_batch__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    char const *const disk_path = "";
+    CHECK_EQ(swicc_disk_load_parallel(NULL, disk_path, 0U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_load_parallel(disk, NULL, 0U), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_load_batch(NULL, &disk_path, NULL, 1U, 0U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_load_batch(disk, NULL, NULL, 1U, 0U),
+             SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_load_batch__disk)
+{
+    char const *const disk_path_plain = "build/tmp/Rb5wNe2JqUk8HsTz.swiccfs";
+    char const *const disk_path_index = "build/tmp/Gm3xVa9LcPo1DyQe.swiccfs";
+    swicc_disk_st disk_exp = {0U};
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_exp, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save(&disk_exp, disk_path_plain), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save_index(&disk_exp, disk_path_index),
+               SWICC_RET_SUCCESS);
+
+    /* A single disk on several workers. */
+    swicc_disk_st disk[4U];
+    memset(disk, 0U, sizeof(disk));
+    REQUIRE_EQ(swicc_disk_load_parallel(&disk[0U], disk_path_plain, 3U),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_lut_cmp(&disk_exp, &disk[0U]), 0);
+    CHECK_EQ(disk_tree_cmp(&disk_exp, &disk[0U]), 0);
+    swicc_disk_unload(&disk[0U]);
+
+    /* A missing disk file fails alone. */
+    char const *const disk_path[4U] = {disk_path_plain, disk_path_index,
+                                       "build/tmp/missing.swiccfs",
+                                       disk_path_plain};
+    swicc_ret_et disk_ret[4U];
+    CHECK_EQ(swicc_disk_load_batch(disk, disk_path, disk_ret, 4U, 2U),
+             SWICC_RET_ERROR);
+    for (uint32_t disk_idx = 0U; disk_idx < 4U; ++disk_idx)
+    {
+        if (disk_idx == 2U)
+        {
+            CHECK_EQ(disk_ret[disk_idx], SWICC_RET_ERROR);
+            CHECK_EQ(disk[disk_idx].root, NULL);
+            continue;
+        }
+        CHECK_EQ(disk_ret[disk_idx], SWICC_RET_SUCCESS);
+        CHECK_EQ(disk_lut_cmp(&disk_exp, &disk[disk_idx]), 0);
+        CHECK_EQ(disk_tree_cmp(&disk_exp, &disk[disk_idx]), 0);
+        CHECK_EQ(disk[disk_idx].lutid_tree_count, disk_exp.lutid_tree_count);
+    }
+
+    /* Loaded disks must be unloaded before loading them again. */
+    CHECK_EQ(swicc_disk_load_batch(disk, disk_path, disk_ret, 1U, 1U),
+             SWICC_RET_ERROR);
+    CHECK_NE(disk[0U].root, NULL);
+    for (uint32_t disk_idx = 0U; disk_idx < 4U; ++disk_idx)
+    {
+        swicc_disk_unload(&disk[disk_idx]);
+    }
+    swicc_disk_unload(&disk_exp);
+}
+
+TEST(fs_disk, swicc_disk_save_lz4__disk)
+{
+    char const *const disk_path = "build/tmp/Wk3sRb9FqLx5VhTz.swiccfs";
+    swicc_disk_st disk_exp = {0U};
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_exp, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_save_lz4(NULL, disk_path), SWICC_RET_PARAM_BAD);
+    REQUIRE_EQ(swicc_disk_save_lz4(&disk_exp, disk_path), SWICC_RET_SUCCESS);
+
+    /* Every loader ends up with the same trees and LUTs. */
+    REQUIRE_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk.lazy, false);
+    CHECK_EQ(disk_tree_cmp(&disk_exp, &disk), 0);
+    CHECK_EQ(disk_lut_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+    REQUIRE_EQ(swicc_disk_load_mmap(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_tree_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+
+    /* Lazily, a tree only gets decompressed once it is accessed. */
+    REQUIRE_EQ(swicc_disk_load_lazy(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk.lutid_tree[0U]->lazy, true);
+    uint8_t tree_head[8U];
+    CHECK_EQ(swicc_disk_tree_read(disk.lutid_tree[0U], 0U, sizeof(tree_head),
+                                  tree_head),
+             SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(tree_head, disk_exp.lutid_tree[0U]->buf, sizeof(tree_head));
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    CHECK_EQ(swicc_disk_lutid_lookup(&disk, &tree, 0x89E7, &file),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(tree->lazy, false);
+    swicc_disk_unload(&disk);
+
+    /* A corrupted tree fails its check. */
+    FILE *const fdisk = fopen(disk_path, "r+b");
+    REQUIRE_NE(fdisk, NULL);
+    CHECK_EQ(fseek(fdisk, -1, SEEK_END), 0);
+    uint8_t corrupt;
+    CHECK_EQ(fread(&corrupt, sizeof(corrupt), 1U, fdisk), 1U);
+    corrupt ^= 0x01U;
+    CHECK_EQ(fseek(fdisk, -1, SEEK_END), 0);
+    CHECK_EQ(fwrite(&corrupt, sizeof(corrupt), 1U, fdisk), 1U);
+    fclose(fdisk);
+    CHECK_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_ERROR);
+    CHECK_EQ(disk.root, NULL);
+    swicc_disk_unload(&disk_exp);
+}
+
+TEST(fs_disk, swicc_disk_tree_check__disk)
+{
+    char const *const disk_path = "build/tmp/Qm7cZt2WkDs9RxLe.swiccfs";
+    swicc_disk_st disk_exp = {0U};
+    swicc_disk_st disk = {0U};
+    uint32_t check;
+    CHECK_EQ(swicc_disk_tree_check(NULL, &check), SWICC_RET_PARAM_BAD);
+
+    /**
+     * Spans a few pages (the last one partial), the checksum does not care
+     * about what the tree holds.
+     */
+    static uint8_t buf[(3U * SWICC_DISK_DIRTY_PAGE_SIZE) + 7U];
+    for (uint32_t byte_idx = 0U; byte_idx < sizeof(buf); ++byte_idx)
+    {
+        /* Safe cast since only the low byte is kept. */
+        buf[byte_idx] = (uint8_t)(byte_idx * 3U);
+    }
+    swicc_disk_tree_st tree = {
+        .size = sizeof(buf),
+        .len = sizeof(buf),
+        .buf = buf,
+    };
+    CHECK_EQ(swicc_disk_tree_check(&tree, NULL), SWICC_RET_PARAM_BAD);
+    REQUIRE_EQ(swicc_disk_tree_check(&tree, &check), SWICC_RET_SUCCESS);
+    CHECK_EQ(check, swicc_crc32c(0U, buf, sizeof(buf)));
+
+    /* After modifications, the checksum is the one of the modified tree. */
+    uint8_t const bytes[2U] = {0xA5, 0x5A};
+    uint32_t const offset_all[] = {SWICC_DISK_DIRTY_PAGE_SIZE - 1U, 0U,
+                                   sizeof(buf) - sizeof(bytes)};
+    for (uint32_t offset_idx = 0U;
+         offset_idx < sizeof(offset_all) / sizeof(offset_all[0U]);
+         ++offset_idx)
+    {
+        REQUIRE_EQ(swicc_disk_tree_write(&tree, offset_all[offset_idx],
+                                         sizeof(bytes), bytes),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_disk_tree_check(&tree, &check), SWICC_RET_SUCCESS);
+        CHECK_EQ(check, swicc_crc32c(0U, buf, sizeof(buf)));
+    }
+    free(tree.dirty);
+    free(tree.check_page);
+    free(tree.check_stale);
+
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_exp, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *const tree_mf = disk_exp.root;
+    uint8_t const byte = (uint8_t)~tree_mf->buf[tree_mf->len - 1U];
+    REQUIRE_EQ(swicc_disk_tree_write(tree_mf, tree_mf->len - 1U, 1U, &byte),
+               SWICC_RET_SUCCESS);
+
+    /* The modified disk is saved with its checksums and loads again. */
+    REQUIRE_EQ(swicc_disk_save_index(&disk_exp, disk_path), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_tree_cmp(&disk_exp, &disk), 0);
+    swicc_disk_unload(&disk);
+
+    /* A corrupted tree fails to load, lazily only once it is read. */
+    FILE *const fdisk = fopen(disk_path, "r+b");
+    REQUIRE_NE(fdisk, NULL);
+    CHECK_EQ(fseek(fdisk, -1, SEEK_END), 0);
+    uint8_t corrupt;
+    CHECK_EQ(fread(&corrupt, sizeof(corrupt), 1U, fdisk), 1U);
+    corrupt ^= 0x01U;
+    CHECK_EQ(fseek(fdisk, -1, SEEK_END), 0);
+    CHECK_EQ(fwrite(&corrupt, sizeof(corrupt), 1U, fdisk), 1U);
+    fclose(fdisk);
+    CHECK_EQ(swicc_disk_load(&disk, disk_path), SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk.root, NULL);
+    CHECK_EQ(swicc_disk_load_mmap(&disk, disk_path), SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk.root, NULL);
+    CHECK_EQ(swicc_disk_load_parallel(&disk, disk_path, 2U), SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk.root, NULL);
+    REQUIRE_EQ(swicc_disk_load_lazy(&disk, disk_path), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_tree_load(disk.root), SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *tree_last = disk.root;
+    while (tree_last->next != NULL)
+    {
+        tree_last = tree_last->next;
+    }
+    CHECK_EQ(swicc_disk_tree_load(tree_last), SWICC_RET_ERROR);
+    swicc_disk_unload(&disk);
+    swicc_disk_unload(&disk_exp);
+}
+
+TEST(fs_disk, swicc_disk_overlay_create__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    CHECK_EQ(swicc_disk_overlay_create(NULL, disk), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_overlay_create(disk, NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_overlay_create__disk)
+{
+    swicc_disk_st disk_base = {0U};
+    swicc_disk_st disk_a = {0U};
+    swicc_disk_st disk_b = {0U};
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_base, "test/data/disk/004-in.json"),
+        SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_overlay_create(&disk_a, &disk_base),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_overlay_create(&disk_b, &disk_base),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_lutid_rebuild(&disk_a), SWICC_RET_ERROR);
+
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk_a, &tree, 0x15B4, &file),
+               SWICC_RET_SUCCESS);
+    uint8_t const byte_base = file.data[0U];
+    uint8_t const byte_new = (uint8_t)~byte_base;
+    REQUIRE_EQ(swicc_disk_file_cow(tree, &file), SWICC_RET_SUCCESS);
+    file.data[0U] = byte_new;
+
+    /* Only the overlay that was written to shall see the modification. */
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk_a, &tree, 0x15B4, &file),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(file.data[0U], byte_new);
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk_b, &tree, 0x15B4, &file),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(file.data[0U], byte_base);
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk_base, &tree, 0x15B4, &file),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(file.data[0U], byte_base);
+
+    swicc_disk_unload(&disk_a);
+    swicc_disk_unload(&disk_b);
+    swicc_disk_unload(&disk_base);
+}
+
 TEST(fs_disk, swicc_disk_unload__disk)
 {
     swicc_disk_st const disk_zero = {0U};
@@ -598,6 +1380,213 @@ TEST(fs_disk, swicc_disk_lutid_lookup__disk)
     swicc_disk_unload(&disk);
 }
 
+static swicc_disk_file_foreach_cb dup_find_cb;
+static swicc_ret_et dup_find_cb(swicc_disk_tree_st *const tree,
+                                swicc_fs_file_st *const file,
+                                void *const userdata)
+{
+    /* Collects offsets of the first 2 files in the folder. */
+    uint32_t *const offsets = userdata;
+    if (offsets[2U] < 2U)
+    {
+        offsets[offsets[2U]++] = file->hdr_item.offset_trel;
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+TEST(fs_disk, swicc_disk_lutid_dup_find__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    swicc_disk_tree_st **const tree = (swicc_disk_tree_st **)1U;
+    swicc_fs_file_st *const file = (swicc_fs_file_st *)1U;
+    CHECK_EQ(swicc_disk_lutid_dup_find(NULL, tree, file), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_lutid_dup_find(disk, NULL, file), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_lutid_dup_find(disk, tree, NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_lutid_dup_find__disk)
+{
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    CHECK_EQ(swicc_disk_lutid_dup_find(&disk, &tree, &file),
+             SWICC_RET_FS_NOT_FOUND);
+
+    /* Give the second file in the MF the ID of the first one. */
+    swicc_disk_tree_st *const tree_mf = disk.root;
+    swicc_fs_file_st file_mf;
+    REQUIRE_EQ(swicc_disk_tree_file_root(tree_mf, &file_mf),
+               SWICC_RET_SUCCESS);
+    uint32_t offsets[3U] = {0U};
+    REQUIRE_EQ(swicc_disk_file_foreach(tree_mf, &file_mf, dup_find_cb,
+                                       offsets, false),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(offsets[2U], 2U);
+    swicc_fs_file_raw_st const *const file_first =
+        (swicc_fs_file_raw_st *)&tree_mf->buf[offsets[0U]];
+    swicc_fs_file_raw_st *const file_second =
+        (swicc_fs_file_raw_st *)&tree_mf->buf[offsets[1U]];
+    file_second->hdr_file.id = file_first->hdr_file.id;
+    REQUIRE_EQ(swicc_disk_lutsid_rebuild(&disk, tree_mf), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_lutid_rebuild(&disk), SWICC_RET_SUCCESS);
+
+    CHECK_EQ(swicc_disk_lutid_dup_find(&disk, &tree, &file),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(tree, tree_mf);
+    CHECK_EQ(file.hdr_item.offset_trel, offsets[1U]);
+    swicc_disk_unload(&disk);
+}
+
+TEST(fs_disk, swicc_disk_lutname_lookup__param_check)
+{
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    uint8_t const name[SWICC_FS_NAME_LEN] = {0U};
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    CHECK_EQ(swicc_disk_lutname_lookup(NULL, SWICC_DISK_LUTNAME_KIND_AID, name,
+                                       sizeof(name), &tree, &file),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_lutname_lookup(disk, SWICC_DISK_LUTNAME_KIND_AID, NULL,
+                                       sizeof(name), &tree, &file),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_lutname_lookup(disk, SWICC_DISK_LUTNAME_KIND_AID, name,
+                                       sizeof(name) + 1U, &tree, &file),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_lutname_lookup(disk, SWICC_DISK_LUTNAME_KIND_AID, name,
+                                       sizeof(name), NULL, &file),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_lutname_lookup(disk, SWICC_DISK_LUTNAME_KIND_AID, name,
+                                       sizeof(name), &tree, NULL),
+             SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_lutname_lookup__disk)
+{
+    static uint8_t const aid[][SWICC_FS_ADF_AID_LEN] = {
+        {0xF6, 0x18, 0xF6, 0x86, 0x9D, 0x19, 0x4B, 0xAD, 0x83, 0xD1, 0x07,
+         0x62, 0x2B, 0x92, 0x0D, 0x04},
+        {0x6A, 0x55, 0xA1, 0x75, 0x8A, 0x7E, 0x2F, 0xF4, 0x58, 0x01, 0xAA,
+         0x15, 0x13, 0x13, 0x40, 0x51},
+        {0x07, 0x0A, 0xB9, 0xE0, 0xCA, 0xE6, 0x5B, 0x68, 0x5B, 0x23, 0x62,
+         0x70, 0xF7, 0xC4, 0x61, 0x1F},
+    };
+    static char const mf_name[] = "salLJvEedfbpIT0M";
+
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    for (uint32_t aid_idx = 0U; aid_idx < sizeof(aid) / sizeof(aid[0U]);
+         ++aid_idx)
+    {
+        /* Full and partial (RID only) AIDs shall both find the ADF. */
+        for (uint32_t aid_len = SWICC_FS_ADF_AID_RID_LEN;
+             aid_len <= SWICC_FS_ADF_AID_LEN;
+             aid_len += SWICC_FS_ADF_AID_PIX_LEN)
+        {
+            REQUIRE_EQ(swicc_disk_lutname_lookup(&disk,
+                                                 SWICC_DISK_LUTNAME_KIND_AID,
+                                                 aid[aid_idx], aid_len, &tree,
+                                                 &file),
+                       SWICC_RET_SUCCESS);
+            CHECK_EQ(file.hdr_item.type, SWICC_FS_ITEM_TYPE_FILE_ADF);
+            CHECK_EQ(disk.lutid_tree[aid_idx + 1U], tree);
+            CHECK_EQ(memcmp(file.hdr_spec.adf.aid.rid, aid[aid_idx],
+                            SWICC_FS_ADF_AID_RID_LEN),
+                     0);
+        }
+        /* An AID is never found when looking for a DF name. */
+        CHECK_EQ(swicc_disk_lutname_lookup(&disk,
+                                           SWICC_DISK_LUTNAME_KIND_DFNAME,
+                                           aid[aid_idx], SWICC_FS_ADF_AID_LEN,
+                                           &tree, &file),
+                 SWICC_RET_FS_NOT_FOUND);
+    }
+
+    REQUIRE_EQ(swicc_disk_lutname_lookup(
+                   &disk, SWICC_DISK_LUTNAME_KIND_DFNAME,
+                   (uint8_t const *)mf_name, SWICC_FS_NAME_LEN, &tree, &file),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(file.hdr_item.type, SWICC_FS_ITEM_TYPE_FILE_MF);
+    CHECK_EQ(swicc_disk_lutname_lookup(
+                 &disk, SWICC_DISK_LUTNAME_KIND_AID, (uint8_t const *)mf_name,
+                 SWICC_FS_NAME_LEN, &tree, &file),
+             SWICC_RET_FS_NOT_FOUND);
+    swicc_disk_unload(&disk);
+}
+
+static swicc_disk_file_foreach_cb descr_check_cb;
+static swicc_ret_et descr_check_cb(swicc_disk_tree_st *const tree,
+                                   swicc_fs_file_st *const file,
+                                   void *const userdata)
+{
+    uint32_t *const file_count = userdata;
+    uint32_t descr_idx;
+    if (swicc_disk_descr_lookup(tree, file->hdr_item.offset_trel,
+                                &descr_idx) != SWICC_RET_SUCCESS ||
+        descr_idx != *file_count)
+    {
+        return SWICC_RET_ERROR;
+    }
+    *file_count += 1U;
+    return SWICC_RET_SUCCESS;
+}
+
+TEST(fs_disk, swicc_disk_descr_lookup__param_check)
+{
+    swicc_disk_tree_st *const tree = (swicc_disk_tree_st *)1U;
+    uint32_t descr_idx;
+    CHECK_EQ(swicc_disk_descr_lookup(NULL, 0U, &descr_idx),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_descr_lookup(tree, 0U, NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_descr_lookup__disk)
+{
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    for (swicc_disk_tree_st *tree = disk.root; tree != NULL; tree = tree->next)
+    {
+        /* A copy of the tree without descriptors parses the raw headers. */
+        swicc_disk_tree_st tree_raw = *tree;
+        tree_raw.descr = NULL;
+        tree_raw.descr_count = 0U;
+
+        /* Every file has a descriptor and they are ordered like the files. */
+        swicc_fs_file_st file_root;
+        REQUIRE_EQ(swicc_disk_tree_file_root(&tree_raw, &file_root),
+                   SWICC_RET_SUCCESS);
+        uint32_t file_count = 0U;
+        CHECK_EQ(swicc_disk_file_foreach(tree, &file_root, descr_check_cb,
+                                         &file_count, true),
+                 SWICC_RET_SUCCESS);
+        CHECK_EQ(file_count, tree->descr_count);
+
+        /* Files made from descriptors must be the same as parsed ones. */
+        for (uint32_t descr_idx = 0U; descr_idx < tree->descr_count;
+             ++descr_idx)
+        {
+            swicc_disk_descr_st const *const descr = &tree->descr[descr_idx];
+            swicc_fs_file_st file_descr;
+            swicc_fs_file_st file_prs;
+            REQUIRE_EQ(swicc_fs_file_prs(tree, descr->offset_trel, &file_descr),
+                       SWICC_RET_SUCCESS);
+            REQUIRE_EQ(
+                swicc_fs_file_prs(&tree_raw, descr->offset_trel, &file_prs),
+                SWICC_RET_SUCCESS);
+            CHECK_EQ(memcmp(&file_descr, &file_prs, sizeof(file_prs)), 0);
+            CHECK_EQ(tree->descr[descr->parent_idx].offset_trel,
+                     descr->offset_trel - descr->offset_prel);
+        }
+    }
+    swicc_disk_unload(&disk);
+}
+
 TEST(fs_disk, swicc_disk_file_rcrd__param_check)
 {
     swicc_disk_tree_st *const tree = (swicc_disk_tree_st *)1U;
@@ -740,7 +1729,7 @@ TEST(fs_disk, swicc_disk_file_rcrd__disk)
                     if (ret_file_rcrd == SWICC_RET_SUCCESS)
                     {
                         bool const buf_len_equal = len == rcrd_len;
-                        CHECK_TRUE(buf_len_equal);
+                        CHECK_EQ(buf_len_equal, true);
 
                         /**
                          * Make sure the claimed buffer size is equal to the
@@ -864,3 +1853,211 @@ TEST(fs_disk, swicc_disk_tree_file_root__disk)
     }
     swicc_disk_unload(&disk);
 }
+
+TEST(fs_disk, swicc_disk_file_fcp__param_check)
+{
+    swicc_disk_tree_st *const tree = (swicc_disk_tree_st *)1U;
+    swicc_fs_file_st *const file = (swicc_fs_file_st *)1U;
+    uint8_t const *buf;
+    uint32_t len;
+    CHECK_EQ(swicc_disk_file_fcp_lookup(NULL, file, 0U, &buf, &len),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_file_fcp_lookup(tree, NULL, 0U, &buf, &len),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_file_fcp_lookup(tree, file, 0U, NULL, &len),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_file_fcp_lookup(tree, file, 0U, &buf, NULL),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_file_fcp_insert(NULL, file, 0U, buf, 1U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_file_fcp_insert(tree, NULL, 0U, buf, 1U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_file_fcp_insert(tree, file, 0U, NULL, 1U),
+             SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_file_fcp__disk)
+{
+    static uint8_t const fcp_root[] = {0x62, 0x01, 0x00};
+    static uint8_t const fcp_root_other[] = {0x64, 0x00};
+    static uint8_t const fcp_sid[] = {0x62, 0x01, 0x01};
+
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *const tree = disk.root;
+    swicc_fs_file_st file_root;
+    swicc_fs_file_st file_sid;
+    REQUIRE_EQ(swicc_disk_tree_file_root(tree, &file_root), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_lutsid_lookup(tree, 0x95, &file_sid),
+               SWICC_RET_SUCCESS);
+
+    uint8_t const *buf;
+    uint32_t len;
+    CHECK_EQ(swicc_disk_file_fcp_lookup(tree, &file_root, 1U, &buf, &len),
+             SWICC_RET_FS_NOT_FOUND);
+    /* Inserted out of order on purpose. */
+    REQUIRE_EQ(swicc_disk_file_fcp_insert(tree, &file_sid, 1U, fcp_sid,
+                                          sizeof(fcp_sid)),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_file_fcp_insert(tree, &file_root, 2U, fcp_root_other,
+                                          sizeof(fcp_root_other)),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_file_fcp_insert(tree, &file_root, 1U, fcp_sid,
+                                          sizeof(fcp_sid)),
+               SWICC_RET_SUCCESS);
+    /* Replaces the one inserted before. */
+    REQUIRE_EQ(swicc_disk_file_fcp_insert(tree, &file_root, 1U, fcp_root,
+                                          sizeof(fcp_root)),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(tree->fcp_count, 3U);
+
+    REQUIRE_EQ(swicc_disk_file_fcp_lookup(tree, &file_root, 1U, &buf, &len),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(len, sizeof(fcp_root));
+    CHECK_BUF_EQ(buf, fcp_root, sizeof(fcp_root));
+    REQUIRE_EQ(swicc_disk_file_fcp_lookup(tree, &file_root, 2U, &buf, &len),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(buf, fcp_root_other, sizeof(fcp_root_other));
+    REQUIRE_EQ(swicc_disk_file_fcp_lookup(tree, &file_sid, 1U, &buf, &len),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(buf, fcp_sid, sizeof(fcp_sid));
+    CHECK_EQ(swicc_disk_file_fcp_lookup(tree, &file_sid, 2U, &buf, &len),
+             SWICC_RET_FS_NOT_FOUND);
+
+    /* Modifying file data keeps the templates. */
+    CHECK_EQ(swicc_disk_file_dirty_mark(tree, &file_sid, 0U, 1U),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(tree->fcp_count, 3U);
+
+    /* Modifying the header of a file drops only its templates. */
+    CHECK_EQ(swicc_disk_tree_dirty_mark(tree, file_sid.hdr_item.offset_trel,
+                                        1U),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_file_fcp_lookup(tree, &file_sid, 1U, &buf, &len),
+             SWICC_RET_FS_NOT_FOUND);
+    CHECK_EQ(swicc_disk_file_fcp_lookup(tree, &file_root, 1U, &buf, &len),
+             SWICC_RET_SUCCESS);
+
+    swicc_disk_lutsid_empty(tree);
+    CHECK_EQ(tree->fcp_count, 0U);
+    swicc_disk_unload(&disk);
+}
+
+TEST(fs_disk, swicc_disk_tree_relayout__param_check)
+{
+    swicc_disk_st disk = {0U};
+    swicc_disk_tree_st tree = {0U};
+    swicc_fs_file_st file = {0U};
+    CHECK_EQ(swicc_disk_file_access(NULL, &file), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_file_access(&tree, NULL), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_tree_relayout(NULL, &tree), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_tree_relayout(&disk, NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_disk, swicc_disk_tree_relayout__disk)
+{
+    static swicc_disk_st disk;
+    static swicc_disk_st disk_ovl;
+    memset(&disk, 0U, sizeof(disk));
+    memset(&disk_ovl, 0U, sizeof(disk_ovl));
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    swicc_fs_id_kt const id[] = {0xF4F4, 0xE99D, 0x5ABD};
+    /* How often each file gets accessed and where it should end up. */
+    uint32_t const access_count[] = {0U, 1U, 3U};
+    uint32_t const order_exp[] = {2U, 1U, 0U};
+    uint32_t const id_count = sizeof(id) / sizeof(id[0U]);
+
+    swicc_disk_tree_st *tree = NULL;
+    swicc_fs_file_st file;
+    uint32_t data_size[id_count];
+    uint8_t data[id_count][256U];
+    uint32_t tree_len = 0U;
+    for (uint32_t id_idx = 0U; id_idx < id_count; ++id_idx)
+    {
+        REQUIRE_EQ(swicc_disk_lutid_lookup(&disk, &tree, id[id_idx], &file),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(file.data_size <= sizeof(data[id_idx]), true);
+        data_size[id_idx] = file.data_size;
+        memcpy(data[id_idx], file.data, file.data_size);
+        for (uint32_t access = 0U; access < access_count[id_idx]; ++access)
+        {
+            CHECK_EQ(swicc_disk_file_access(tree, &file), SWICC_RET_SUCCESS);
+        }
+        tree_len = tree->len;
+    }
+
+    /* Trees shared with a base disk can't be rewritten. */
+    REQUIRE_EQ(swicc_disk_overlay_create(&disk_ovl, &disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_tree_relayout(&disk_ovl, disk_ovl.root),
+             SWICC_RET_ERROR);
+    swicc_disk_unload(&disk_ovl);
+
+    REQUIRE_EQ(swicc_disk_tree_relayout(&disk, tree), SWICC_RET_SUCCESS);
+    CHECK_EQ((void *)tree->access, NULL);
+    CHECK_EQ(tree->len, tree_len);
+
+    swicc_fs_file_st file_root;
+    REQUIRE_EQ(swicc_disk_tree_file_root(tree, &file_root), SWICC_RET_SUCCESS);
+    uint32_t offset_trel =
+        swicc_fs_item_hdr_raw_size[file_root.hdr_item.type];
+    for (uint32_t order = 0U; order < id_count; ++order)
+    {
+        uint32_t const id_idx = order_exp[order];
+        REQUIRE_EQ(swicc_disk_lutid_lookup(&disk, &tree, id[id_idx], &file),
+                   SWICC_RET_SUCCESS);
+        CHECK_EQ(file.hdr_item.offset_trel, offset_trel);
+        CHECK_EQ(file.hdr_item.offset_prel, offset_trel);
+        CHECK_EQ(file.data_size, data_size[id_idx]);
+        CHECK_BUF_EQ(file.data, data[id_idx], data_size[id_idx]);
+        offset_trel += file.hdr_item.size;
+    }
+    swicc_disk_unload(&disk);
+}
+
+TEST(fs_disk, swicc_disk_path_cache__disk)
+{
+    static swicc_disk_st disk;
+    memset(&disk, 0U, sizeof(disk));
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    REQUIRE_EQ(swicc_disk_lutid_lookup(&disk, &tree, 0xE99D, &file),
+               SWICC_RET_SUCCESS);
+
+    swicc_disk_path_cache_entry_st entry = {
+        .type = SWICC_FS_PATH_TYPE_MF,
+        .len = 2U,
+        .id = {0xE7C7, 0xE99D},
+        .tree = tree,
+        .offset_trel = file.hdr_item.offset_trel,
+    };
+    swicc_disk_tree_st *tree_cached;
+    swicc_fs_file_st file_cached;
+    CHECK_EQ(swicc_disk_path_cache_lookup(&disk, &entry, &tree_cached,
+                                          &file_cached),
+             SWICC_RET_FS_NOT_FOUND);
+    CHECK_EQ(swicc_disk_path_cache_insert(&disk, &entry), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_path_cache_lookup(&disk, &entry, &tree_cached,
+                                            &file_cached),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ((void *)tree_cached, (void *)tree);
+    CHECK_EQ(file_cached.hdr_file.id, 0xE99D);
+
+    /* The same path from somewhere else is a different path. */
+    swicc_disk_path_cache_entry_st key = entry;
+    key.type = SWICC_FS_PATH_TYPE_DF;
+    key.start_tree = tree;
+    CHECK_EQ(swicc_disk_path_cache_lookup(&disk, &key, &tree_cached,
+                                          &file_cached),
+             SWICC_RET_FS_NOT_FOUND);
+
+    /* Files may move when the LUTs get rebuilt. */
+    REQUIRE_EQ(swicc_disk_lutid_rebuild(&disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_disk_path_cache_lookup(&disk, &entry, &tree_cached,
+                                          &file_cached),
+             SWICC_RET_FS_NOT_FOUND);
+    swicc_disk_unload(&disk);
+}
@@ -0,0 +1,98 @@
+#include <tau/tau.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/**
+ * Generated at build time by running the diskc tool on the disk
+ * 'test/data/disk/006-in.json'.
+ */
+extern swicc_disk_st const test_disk_rom;
+
+TEST(fs_diskc, swicc_diskc_gen)
+{
+    char const *const c_path = "build/tmp/Qw8eHn3Kz7TjXb5r.c";
+    static swicc_disk_st disk;
+    memset(&disk, 0U, sizeof(disk));
+    CHECK_EQ(swicc_diskc_gen(&disk, c_path, "disk_rom"), SWICC_RET_ERROR);
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_diskc_gen(&disk, c_path, "0disk"), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_diskc_gen(&disk, c_path, "disk-rom"), SWICC_RET_PARAM_BAD);
+    REQUIRE_EQ(swicc_diskc_gen(&disk, c_path, "disk_rom"), SWICC_RET_SUCCESS);
+
+    /* The file ends with the definition of the disk. */
+    FILE *const f = fopen(c_path, "r");
+    REQUIRE_NE((void *)f, NULL);
+    char line[128U];
+    bool disk_found = false;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (strcmp(line, "swicc_disk_st const disk_rom SWICC_DISKC_RODATA = "
+                         "{\n") == 0)
+        {
+            disk_found = true;
+        }
+    }
+    fclose(f);
+    CHECK_EQ(disk_found, true);
+    CHECK_BUF_EQ(line, "};\n", sizeof("};\n"));
+    swicc_disk_unload(&disk);
+}
+
+TEST(fs_diskc, swicc_diskc_gen__linked)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk_exp = {0U};
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_exp, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_overlay_create(&disk, &test_disk_rom),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_mount(&swicc_state, &disk), SWICC_RET_SUCCESS);
+
+    /* The mounted disk has the same trees as the one compiled from JSON. */
+    swicc_disk_tree_st const *tree_exp = disk_exp.root;
+    swicc_disk_tree_st const *tree = swicc_state.fs.disk.root;
+    for (; tree_exp != NULL && tree != NULL;
+         tree_exp = tree_exp->next, tree = tree->next)
+    {
+        REQUIRE_EQ(tree->len, tree_exp->len);
+        CHECK_BUF_EQ(tree->buf, tree_exp->buf, tree_exp->len);
+    }
+    CHECK_EQ((void const *)tree, (void const *)tree_exp);
+
+    /* Every file can be found by its ID and holds the same data. */
+    swicc_disk_lut_st const *const lutid = &disk_exp.lutid;
+    REQUIRE_EQ(swicc_state.fs.disk.lutid.count, lutid->count);
+    for (uint32_t item_idx = 0U; item_idx < lutid->count; ++item_idx)
+    {
+        /* IDs are stored in big-endian inside the LUT. */
+        swicc_fs_id_kt id_be;
+        memcpy(&id_be, &lutid->buf1[item_idx * lutid->size_item1],
+               sizeof(id_be));
+        swicc_fs_id_kt const id = be16toh(id_be);
+        swicc_disk_tree_st *file_tree;
+        swicc_fs_file_st file_exp;
+        swicc_fs_file_st file;
+        REQUIRE_EQ(swicc_disk_lutid_lookup(&disk_exp, &file_tree, id,
+                                           &file_exp),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_disk_lutid_lookup(&swicc_state.fs.disk, &file_tree,
+                                           id, &file),
+                   SWICC_RET_SUCCESS);
+        CHECK_EQ(file.hdr_item.type, file_exp.hdr_item.type);
+        REQUIRE_EQ(file.data_size, file_exp.data_size);
+        CHECK_BUF_EQ(file.data, file_exp.data, file_exp.data_size);
+    }
+
+    /* Files of the mounted disk can be selected. */
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_state.fs.va.cur_file.hdr_file.id, 0xE99D);
+    swicc_terminate(&swicc_state);
+    swicc_disk_unload(&disk_exp);
+}
@@ -534,111 +534,207 @@ TEST(fs_diskjs, jsitem_prs_item_ascii__data)
                         0x3EA78A0C);
 }
 
-TEST(fs_diskjs, disk_json_prs__param_check)
+TEST(fs_diskjs, disk_json_split__data)
+{
+    static diskjs_job_st job;
+    char const disk_json[] =
+        "{\"name\": \"]\\\"}\", \"n\": [1, {\"disk\": 2}], \"x\": -1,\n"
+        " \"disk\": [ {\"a\": \"[\"} ,{}, [\"}\"]\t], \"disk\": 3}";
+    job.json = disk_json;
+    REQUIRE_EQ(disk_json_split(&job, sizeof(disk_json) - 1U),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(job.tree_count, 3U);
+    CHECK_EQ(memcmp(&disk_json[job.tree[0U].json_offset], "{\"a\": \"[\"}",
+                    job.tree[0U].json_len),
+             0);
+    CHECK_EQ(job.tree[1U].json_len, 2U);
+    CHECK_EQ(memcmp(&disk_json[job.tree[2U].json_offset], "[\"}\"]",
+                    job.tree[2U].json_len),
+             0);
+
+    char const *const disk_json_bad[] = {
+        "",
+        "[]",
+        "{\"name\": 1}",
+        "{\"disk\": {}}",
+        "{\"disk\": [{}}",
+        "{\"disk\": [{} {}]}",
+        "{\"disk\": [\"}]",
+    };
+    for (uint32_t bad_idx = 0U;
+         bad_idx < sizeof(disk_json_bad) / sizeof(disk_json_bad[0U]);
+         ++bad_idx)
+    {
+        job.json = disk_json_bad[bad_idx];
+        /* Safe cast since the test strings are short. */
+        uint32_t const disk_json_bad_len =
+            (uint32_t)strlen(disk_json_bad[bad_idx]);
+        CHECK_EQ(disk_json_split(&job, disk_json_bad_len), SWICC_RET_ERROR);
+    }
+}
+
+TEST(fs_diskjs, disk_json_compile__param_check)
 {
     swicc_disk_st disk;
-    cJSON const disk_json;
-    CHECK_EQ(disk_json_prs(NULL, &disk_json), SWICC_RET_PARAM_BAD);
-    CHECK_EQ(disk_json_prs(&disk, NULL), SWICC_RET_PARAM_BAD);
+    char const disk_json[] = "{\"disk\":[]}";
+    uint32_t const disk_json_len = sizeof(disk_json) - 1U;
+    CHECK_EQ(disk_json_compile(NULL, disk_json, disk_json_len, 1U, NULL),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(disk_json_compile(&disk, NULL, disk_json_len, 1U, NULL),
+             SWICC_RET_PARAM_BAD);
 }
 
-TEST(fs_diskjs, disk_json_prs__data)
+TEST(fs_diskjs, disk_json_compile__data)
 {
     swicc_disk_st disk = {0U};
     TEST_DATA_FOREACH("test/data/disk/", {
-        cJSON *const obj = cJSON_ParseWithLength((char *)buf_in, buf_in_len);
-        if (obj == NULL)
-        {
-            failed = true;
-        }
-        else
+        /* Compile on a few threads even for disks with fewer trees. */
+        swicc_ret_et const ret_disk_prs =
+            disk_json_compile(&disk, (char *)buf_in, buf_in_len, 4U, NULL);
+        CHECK_EQ(ret_disk_prs, SWICC_RET_SUCCESS);
+        (void)buf_out_len;
+        (void)buf_out;
+
+        uint32_t buf_out_idx = 0U;
+        swicc_disk_tree_st *tree = disk.root;
+        while (tree != NULL)
         {
-            swicc_ret_et const ret_disk_prs = disk_json_prs(&disk, obj);
-            CHECK_EQ(ret_disk_prs, SWICC_RET_SUCCESS);
-            (void)buf_out_len;
-            (void)buf_out;
-
-            uint32_t buf_out_idx = 0U;
-            swicc_disk_tree_st *tree = disk.root;
-            while (tree != NULL)
+            CHECK_LE(tree->len, buf_out_len - buf_out_idx);
+            if (buf_out_idx + tree->len >= buf_out_len)
             {
-                CHECK_LE(tree->len, buf_out_len - buf_out_idx);
-                if (buf_out_idx + tree->len >= buf_out_len)
-                {
-                    break;
-                }
-                /**
-                 * @note This weird casting here is to avoid triggering
-                 * -Wconversion.
-                 */
-                int32_t const buf_len = (int32_t)tree->len;
-                CHECK_BUF_EQ(tree->buf, &buf_out[buf_out_idx], (size_t)buf_len);
-                buf_out_idx += tree->len;
-                tree = tree->next;
+                break;
             }
+            /**
+             * @note This weird casting here is to avoid triggering
+             * -Wconversion.
+             */
+            int32_t const buf_len = (int32_t)tree->len;
+            CHECK_BUF_EQ(tree->buf, &buf_out[buf_out_idx], (size_t)buf_len);
+            buf_out_idx += tree->len;
+            tree = tree->next;
+        }
 
-            if (buf_out_idx + sizeof(disk.lutid.count) > buf_out_len)
+        if (buf_out_idx + sizeof(disk.lutid.count) > buf_out_len)
+        {
+            WARN(
+                "Test out file is too short to contain ID LUT item count (4B).");
+            CHECK_LE(buf_out_idx + sizeof(disk.lutid.count), buf_out_len);
+        }
+        else
+        {
+            /**
+             * The test out file contains not only expected contents but
+             * some extra data that we extract here. Safe cast since this is
+             * checked to be safe in the 'if' condition.
+             */
+            uint32_t const lutid_count_exp =
+                *(uint32_t *)&buf_out[buf_out_idx];
+            /* Safe case due to 'if' condition. */
+            buf_out_idx = (uint32_t)(buf_out_idx + sizeof(lutid_count_exp));
+
+            /* Make sure the LUTs were also created correctly. */
+            CHECK_NE((void *)disk.lutid.buf1, NULL);
+            CHECK_NE((void *)disk.lutid.buf2, NULL);
+            CHECK_EQ(disk.lutid.count, lutid_count_exp);
+            CHECK_EQ(disk.lutid.size_item1, sizeof(swicc_fs_id_kt));
+            CHECK_EQ(disk.lutid.size_item2,
+                     sizeof(uint32_t) + sizeof(uint8_t));
+            if (buf_out_idx + lutid_count_exp * (disk.lutid.size_item1 +
+                                                 disk.lutid.size_item2) >
+                buf_out_len)
             {
                 WARN(
-                    "Test out file is too short to contain ID LUT item count (4B).");
-                CHECK_LE(buf_out_idx + sizeof(disk.lutid.count), buf_out_len);
+                    "Test out file is too short to contain ID LUT entries.");
+                CHECK_LE(buf_out_idx +
+                             lutid_count_exp * (disk.lutid.size_item1 +
+                                                disk.lutid.size_item2),
+                         buf_out_len);
             }
             else
             {
                 /**
-                 * The test out file contains not only expected contents but
-                 * some extra data that we extract here. Safe cast since this is
-                 * checked to be safe in the 'if' condition.
+                 * @note This weird casting here is to avoid triggering
+                 * -Wconversion. These are UNSAFE casts.
                  */
-                uint32_t const lutid_count_exp =
-                    *(uint32_t *)&buf_out[buf_out_idx];
-                /* Safe case due to 'if' condition. */
-                buf_out_idx = (uint32_t)(buf_out_idx + sizeof(lutid_count_exp));
-
-                /* Make sure the LUTs were also created correctly. */
-                CHECK_NE((void *)disk.lutid.buf1, NULL);
-                CHECK_NE((void *)disk.lutid.buf2, NULL);
-                CHECK_EQ(disk.lutid.count, lutid_count_exp);
-                CHECK_EQ(disk.lutid.size_item1, sizeof(swicc_fs_id_kt));
-                CHECK_EQ(disk.lutid.size_item2,
-                         sizeof(uint32_t) + sizeof(uint8_t));
-                if (buf_out_idx + lutid_count_exp * (disk.lutid.size_item1 +
-                                                     disk.lutid.size_item2) >
-                    buf_out_len)
-                {
-                    WARN(
-                        "Test out file is too short to contain ID LUT entries.");
-                    CHECK_LE(buf_out_idx +
-                                 lutid_count_exp * (disk.lutid.size_item1 +
-                                                    disk.lutid.size_item2),
-                             buf_out_len);
-                }
-                else
-                {
-                    /**
-                     * @note This weird casting here is to avoid triggering
-                     * -Wconversion. These are UNSAFE casts.
-                     */
-                    int32_t const lutid_buf1_len =
-                        (int32_t)(lutid_count_exp * disk.lutid.size_item1);
-                    int32_t const lutid_buf2_len =
-                        (int32_t)(lutid_count_exp * disk.lutid.size_item2);
-                    CHECK_BUF_EQ(disk.lutid.buf1, &buf_out[buf_out_idx],
-                                 (size_t)lutid_buf1_len);
-                    buf_out_idx =
-                        (uint32_t)(buf_out_idx + (uint32_t)lutid_buf1_len);
-                    CHECK_BUF_EQ(disk.lutid.buf2, &buf_out[buf_out_idx],
-                                 (size_t)lutid_buf2_len);
-                    buf_out_idx =
-                        (uint32_t)(buf_out_idx + (uint32_t)lutid_buf2_len);
-                }
+                int32_t const lutid_buf1_len =
+                    (int32_t)(lutid_count_exp * disk.lutid.size_item1);
+                int32_t const lutid_buf2_len =
+                    (int32_t)(lutid_count_exp * disk.lutid.size_item2);
+                CHECK_BUF_EQ(disk.lutid.buf1, &buf_out[buf_out_idx],
+                             (size_t)lutid_buf1_len);
+                buf_out_idx =
+                    (uint32_t)(buf_out_idx + (uint32_t)lutid_buf1_len);
+                CHECK_BUF_EQ(disk.lutid.buf2, &buf_out[buf_out_idx],
+                             (size_t)lutid_buf2_len);
+                buf_out_idx =
+                    (uint32_t)(buf_out_idx + (uint32_t)lutid_buf2_len);
             }
+        }
 
-            if (ret_disk_prs == SWICC_RET_SUCCESS)
-            {
-                swicc_disk_unload(&disk);
-            }
-            cJSON_Delete(obj);
+        if (ret_disk_prs == SWICC_RET_SUCCESS)
+        {
+            swicc_disk_unload(&disk);
         }
     });
 }
+
+TEST(fs_diskjs, swicc_diskjs_disk_create_cached__disk)
+{
+    char const *const disk_json_path = "test/data/disk/006-in.json";
+    char const *const cache_path = "build/tmp";
+    swicc_disk_st disk_exp = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create_mt(&disk_exp, disk_json_path, 1U),
+               SWICC_RET_SUCCESS);
+
+    /* First run fills the cache and the second one only reads from it. */
+    for (uint32_t run_idx = 0U; run_idx < 2U; ++run_idx)
+    {
+        swicc_disk_st disk = {0U};
+        REQUIRE_EQ(swicc_diskjs_disk_create_cached(&disk, disk_json_path, 2U,
+                                                   cache_path),
+                   SWICC_RET_SUCCESS);
+        swicc_disk_tree_st *tree = disk.root;
+        swicc_disk_tree_st *tree_exp = disk_exp.root;
+        while (tree != NULL && tree_exp != NULL)
+        {
+            REQUIRE_EQ(tree->len, tree_exp->len);
+            CHECK_BUF_EQ(tree->buf, tree_exp->buf, tree->len);
+            CHECK_EQ(tree->lutsid.count, tree_exp->lutsid.count);
+            tree = tree->next;
+            tree_exp = tree_exp->next;
+        }
+        CHECK_EQ((void *)tree, NULL);
+        CHECK_EQ((void *)tree_exp, NULL);
+        CHECK_EQ(disk.lutid.count, disk_exp.lutid.count);
+        CHECK_BUF_EQ(disk.lutid.buf1, disk_exp.lutid.buf1,
+                     disk.lutid.count * disk.lutid.size_item1);
+        swicc_disk_unload(&disk);
+    }
+
+    /* A tree that was cached must not need its JSON anymore. */
+    static diskjs_job_st job;
+    char const tree_json[] = "{\"type\": \"file_mf\"}";
+    swicc_disk_tree_st tree = {0U};
+    job.json = tree_json;
+    job.cache_path = cache_path;
+    job.tree[0U] = (diskjs_tree_job_st){
+        .json_offset = 0U,
+        .json_len = sizeof(tree_json) - 1U,
+        .tree = &tree,
+    };
+    /* Could be left over from an earlier run. */
+    char *const tree_cache_path = cache_file_path(&job, &job.tree[0U]);
+    REQUIRE_NE((void *)tree_cache_path, NULL);
+    unlink(tree_cache_path);
+    free(tree_cache_path);
+    CHECK_EQ(cache_load(&job, &job.tree[0U]), SWICC_RET_FS_NOT_FOUND);
+    tree.buf = disk_exp.root->buf;
+    tree.len = disk_exp.root->len;
+    REQUIRE_EQ(cache_store(&job, &job.tree[0U]), SWICC_RET_SUCCESS);
+    memset(&tree, 0U, sizeof(tree));
+    REQUIRE_EQ(cache_load(&job, &job.tree[0U]), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(tree.len, disk_exp.root->len);
+    CHECK_BUF_EQ(tree.buf, disk_exp.root->buf, tree.len);
+    free(tree.buf);
+    swicc_disk_unload(&disk_exp);
+}
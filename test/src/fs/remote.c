@@ -0,0 +1,170 @@
+#include <tau/tau.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+/* A disk file kept in memory standing in for an object in a remote store. */
+typedef struct object_s
+{
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t read_count;
+} object_st;
+
+static swicc_disk_remote_read_ft object_read;
+static swicc_ret_et object_read(void *const userdata, uint64_t const offset,
+                                uint32_t const len, uint8_t *const buf)
+{
+    object_st *const object = userdata;
+    if (offset > object->len || len > object->len - offset)
+    {
+        return SWICC_RET_ERROR;
+    }
+    object->read_count += 1U;
+    memcpy(buf, &object->buf[offset], len);
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Read a whole file into memory.
+ * @param path
+ * @param object Will receive the allocated contents of the file.
+ * @return 0 on success, -1 on failure.
+ */
+static int32_t object_create(char const *const path, object_st *const object)
+{
+    FILE *const f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return -1;
+    }
+    int32_t ret = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+        long const len = ftell(f);
+        if (len > 0 && fseek(f, 0, SEEK_SET) == 0)
+        {
+            /* Safe cast since the length was checked to be positive. */
+            object->len = (uint32_t)len;
+            object->buf = malloc(object->len);
+            object->read_count = 0U;
+            if (object->buf != NULL &&
+                fread(object->buf, object->len, 1U, f) == 1U)
+            {
+                ret = 0;
+            }
+        }
+    }
+    fclose(f);
+    return ret;
+}
+
+TEST(fs_remote, swicc_disk_remote_read__param_check)
+{
+    swicc_disk_remote_st const remote = {.read = object_read, .len = 2U};
+    uint8_t buf[2U];
+    CHECK_EQ(swicc_disk_remote_read(NULL, 0U, 1U, buf), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_remote_read(&remote, 0U, 1U, NULL),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_remote_read(&remote, 1U, 2U, buf),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_disk_cache_init(NULL, 1U), SWICC_RET_PARAM_BAD);
+    swicc_disk_cache_st cache;
+    CHECK_EQ(swicc_disk_cache_init(&cache, 0U), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_remote, swicc_disk_load_remote)
+{
+    char const *const disk_path = "build/tmp/Vj4pW9sNqE2hRc6Y.swiccfs";
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save_index(&disk, disk_path), SWICC_RET_SUCCESS);
+    object_st object;
+    REQUIRE_EQ(object_create(disk_path, &object), 0);
+
+    swicc_disk_cache_st cache;
+    REQUIRE_EQ(swicc_disk_cache_init(&cache, 64U), SWICC_RET_SUCCESS);
+    swicc_disk_remote_st const remote = {
+        .read = object_read,
+        .userdata = &object,
+        .len = object.len,
+        .id = 1U,
+        .cache = &cache,
+    };
+
+    /* Only the index is fetched until a tree gets accessed. */
+    swicc_disk_st disk_remote[2U] = {{0U}};
+    REQUIRE_EQ(swicc_disk_load_remote(&disk_remote[0U], &remote),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(disk_remote[0U].root->lazy, true);
+    uint32_t const read_count_index = object.read_count;
+    CHECK_EQ(read_count_index <= 1U + (object.len - 1U) /
+                                          SWICC_DISK_CACHE_PAGE_SIZE,
+             true);
+
+    /* Files read from the remote are the same as in the original disk. */
+    static swicc_fs_id_kt const file_id[2U] = {0xF4F4, 0x5ABD};
+    for (uint8_t file_idx = 0U; file_idx < 2U; ++file_idx)
+    {
+        swicc_disk_tree_st *tree;
+        swicc_fs_file_st file;
+        swicc_disk_tree_st *tree_remote;
+        swicc_fs_file_st file_remote;
+        REQUIRE_EQ(
+            swicc_disk_lutid_lookup(&disk, &tree, file_id[file_idx], &file),
+            SWICC_RET_SUCCESS);
+        REQUIRE_EQ(swicc_disk_lutid_lookup(&disk_remote[0U], &tree_remote,
+                                           file_id[file_idx], &file_remote),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(file_remote.data_size, file.data_size);
+        CHECK_BUF_EQ(file_remote.data, file.data, file.data_size);
+    }
+
+    /* Another disk of the same remote is served by the cache. */
+    uint32_t const read_count = object.read_count;
+    REQUIRE_EQ(swicc_disk_load_remote(&disk_remote[1U], &remote),
+               SWICC_RET_SUCCESS);
+    for (uint8_t file_idx = 0U; file_idx < 2U; ++file_idx)
+    {
+        swicc_disk_tree_st *tree_remote;
+        swicc_fs_file_st file_remote;
+        CHECK_EQ(swicc_disk_lutid_lookup(&disk_remote[1U], &tree_remote,
+                                         file_id[file_idx], &file_remote),
+                 SWICC_RET_SUCCESS);
+    }
+    CHECK_EQ(object.read_count, read_count);
+    CHECK_NE(cache.hit_count, 0U);
+    swicc_disk_unload(&disk_remote[1U]);
+
+    /* A full cache keeps only the most recently read pages. */
+    swicc_disk_cache_deinit(&cache);
+    REQUIRE_EQ(swicc_disk_cache_init(&cache, 1U), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_load_remote(&disk_remote[1U], &remote),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(cache.page_count, 1U);
+    swicc_disk_unload(&disk_remote[1U]);
+
+    /* A disk file without an index can't be loaded from a remote. */
+    REQUIRE_EQ(swicc_disk_save(&disk, disk_path), SWICC_RET_SUCCESS);
+    object_st object_plain;
+    REQUIRE_EQ(object_create(disk_path, &object_plain), 0);
+    swicc_disk_remote_st const remote_plain = {
+        .read = object_read,
+        .userdata = &object_plain,
+        .len = object_plain.len,
+        .id = 2U,
+        .cache = NULL,
+    };
+    CHECK_EQ(swicc_disk_load_remote(&disk_remote[1U], &remote_plain),
+             SWICC_RET_ERROR);
+    CHECK_EQ((void *)disk_remote[1U].root, NULL);
+
+    free(object_plain.buf);
+    swicc_disk_unload(&disk_remote[0U]);
+    swicc_disk_cache_deinit(&cache);
+    free(object.buf);
+    swicc_disk_unload(&disk);
+}
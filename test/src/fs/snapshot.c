@@ -0,0 +1,109 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+/**
+ * @brief Modify a record of a file and mark it as dirty.
+ * @param disk
+ * @param id ID of the file.
+ * @param rcrd_idx Index of the record to modify.
+ * @param byte Value to write to every byte of the record.
+ * @return Return code.
+ */
+static swicc_ret_et rcrd_modify(swicc_disk_st *const disk,
+                                swicc_fs_id_kt const id,
+                                swicc_fs_rcrd_idx_kt const rcrd_idx,
+                                uint8_t const byte)
+{
+    swicc_disk_tree_st *tree;
+    swicc_fs_file_st file;
+    uint8_t *rcrd;
+    uint8_t rcrd_len;
+    if (swicc_disk_lutid_lookup(disk, &tree, id, &file) != SWICC_RET_SUCCESS ||
+        swicc_disk_file_cow(tree, &file) != SWICC_RET_SUCCESS ||
+        swicc_disk_file_rcrd(tree, &file, rcrd_idx, &rcrd, &rcrd_len) !=
+            SWICC_RET_SUCCESS)
+    {
+        return SWICC_RET_ERROR;
+    }
+    memset(rcrd, byte, rcrd_len);
+    /* Safe cast since the record is inside the file data. */
+    return swicc_disk_file_dirty_mark(tree, &file, (uint32_t)(rcrd - file.data),
+                                      rcrd_len);
+}
+
+TEST(fs_snapshot, swicc_snapshot__param_check)
+{
+    swicc_snapshot_st *const snapshot = (swicc_snapshot_st *)1U;
+    swicc_disk_st *const disk = (swicc_disk_st *)1U;
+    char const *const disk_path = "";
+    CHECK_EQ(swicc_snapshot_init(NULL, disk, disk_path), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_snapshot_init(snapshot, NULL, disk_path),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_snapshot_init(snapshot, disk, NULL), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_snapshot_capture(NULL, disk), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_snapshot_capture(snapshot, NULL), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_snapshot_write(NULL), SWICC_RET_PARAM_BAD);
+}
+
+TEST(fs_snapshot, swicc_snapshot__disk)
+{
+    char const *const disk_path = "build/tmp/Fh2kWq9ZtLc5NbYe.swiccfs";
+    swicc_disk_st disk_base = {0U};
+    swicc_disk_st disk = {0U};
+    swicc_disk_st disk_snapshot = {0U};
+    REQUIRE_EQ(
+        swicc_diskjs_disk_create(&disk_base, "test/data/disk/006-in.json"),
+        SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_save_index(&disk_base, disk_path),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_disk_overlay_create(&disk, &disk_base),
+               SWICC_RET_SUCCESS);
+
+    static swicc_snapshot_st snapshot;
+    REQUIRE_EQ(swicc_snapshot_init(&snapshot, &disk, disk_path),
+               SWICC_RET_SUCCESS);
+
+    /* Without modifications, there is nothing to write. */
+    CHECK_EQ(swicc_snapshot_capture(&snapshot, &disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_write(&snapshot), SWICC_RET_SNAPSHOT_EMPTY);
+
+    /* Capturing shall not wait for writing until all buffers are used. */
+    CHECK_EQ(rcrd_modify(&disk, 0xE99D, 0U, 0xA1), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_capture(&snapshot, &disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(rcrd_modify(&disk, 0x89E7, 2U, 0xA2), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_capture(&snapshot, &disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(rcrd_modify(&disk, 0x5240, 1U, 0xA3), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_capture(&snapshot, &disk),
+             SWICC_RET_SNAPSHOT_BUSY);
+    CHECK_EQ(swicc_snapshot_write(&snapshot), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_capture(&snapshot, &disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_write(&snapshot), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_write(&snapshot), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_snapshot_write(&snapshot), SWICC_RET_SNAPSHOT_EMPTY);
+    swicc_snapshot_deinit(&snapshot);
+
+    /* The disk file shall now hold the disk with all modifications. */
+    REQUIRE_EQ(swicc_disk_load(&disk_snapshot, disk_path), SWICC_RET_SUCCESS);
+    swicc_disk_tree_st const *tree = disk.root;
+    swicc_disk_tree_st const *tree_snapshot = disk_snapshot.root;
+    for (; tree != NULL && tree_snapshot != NULL;
+         tree = tree->next, tree_snapshot = tree_snapshot->next)
+    {
+        REQUIRE_EQ(tree->len, tree_snapshot->len);
+        uint8_t tree_buf[tree->len];
+        CHECK_EQ(swicc_disk_tree_read(tree, 0U, tree->len, tree_buf),
+                 SWICC_RET_SUCCESS);
+        CHECK_EQ(memcmp(tree_buf, tree_snapshot->buf, tree->len), 0);
+    }
+    CHECK_EQ(tree, NULL);
+    CHECK_EQ(tree_snapshot, NULL);
+
+    /* The base disk was never modified. */
+    CHECK_NE(memcmp(disk_base.root->buf, disk_snapshot.root->buf,
+                    disk_base.root->len),
+             0);
+    swicc_disk_unload(&disk_snapshot);
+    swicc_disk_unload(&disk);
+    swicc_disk_unload(&disk_base);
+}
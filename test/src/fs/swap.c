@@ -0,0 +1,150 @@
+#include <tau/tau.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <swicc/swicc.h>
+
+TEST(fs_swap, swicc_fs_disk_swap)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    swicc_disk_tree_st *const root_old = swicc_state.fs.disk.root;
+    swicc_disk_tree_st *const root_new = disk.root;
+
+    /* Something other than the MF is selected on 2 channels. */
+    uint8_t lchan = 1U;
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE7C7),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_lchan_open(&swicc_state.fs, &lchan), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE99D),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_select_record_idx(&swicc_state.fs, 1U),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_lchan_switch(&swicc_state.fs, 1U), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0x89E7),
+               SWICC_RET_SUCCESS);
+
+    CHECK_EQ(swicc_fs_disk_swap_apply(&swicc_state), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_swap(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_fs_disk_swap(&swicc_state, &disk), SWICC_RET_ERROR);
+    CHECK_EQ(swicc_fs_disk_swap_reclaim(&swicc_state, &disk),
+             SWICC_RET_FS_SWAP_PENDING);
+
+    /* Not swapped in the middle of a command. */
+    swicc_state.internal.fsm_state = SWICC_FSM_STATE_CMD_PROCEDURE;
+    CHECK_EQ(swicc_fs_disk_swap_apply(&swicc_state),
+             SWICC_RET_FS_SWAP_PENDING);
+    CHECK_EQ((void *)swicc_state.fs.disk.root, (void *)root_old);
+    swicc_state.internal.fsm_state = SWICC_FSM_STATE_CMD_WAIT;
+    REQUIRE_EQ(swicc_fs_disk_swap_apply(&swicc_state), SWICC_RET_SUCCESS);
+    CHECK_EQ((void *)swicc_state.fs.disk.root, (void *)root_new);
+
+    /* The selections were resolved again in the new disk. */
+    CHECK_EQ(swicc_state.fs.lchan_cur, 1U);
+    CHECK_EQ(swicc_state.fs.lchan_open, 1U << 1U);
+    CHECK_EQ(swicc_state.fs.va.cur_ef.hdr_file.id, 0x89E7);
+    CHECK_EQ(swicc_state.fs.va_lchan[0U].cur_ef.hdr_file.id, 0xE99D);
+    CHECK_EQ(swicc_state.fs.va_lchan[0U].cur_rcrd.idx, 1U);
+    for (uint8_t va_idx = 0U; va_idx < 2U; ++va_idx)
+    {
+        swicc_va_st const *const va = va_idx == 0U
+                                          ? &swicc_state.fs.va
+                                          : &swicc_state.fs.va_lchan[0U];
+        bool tree_found = false;
+        for (swicc_disk_tree_st const *tree = root_new; tree != NULL;
+             tree = tree->next)
+        {
+            tree_found = tree_found || tree == va->cur_tree;
+        }
+        CHECK_EQ(tree_found, true);
+    }
+
+    /* The old disk is handed back exactly once. */
+    CHECK_EQ(swicc_fs_disk_swap_reclaim(&swicc_state, &disk),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ((void *)disk.root, (void *)root_old);
+    CHECK_EQ(swicc_fs_disk_swap_reclaim(&swicc_state, &disk),
+             SWICC_RET_FS_SWAP_PENDING);
+    swicc_disk_unload(&disk);
+    swicc_disk_unload(&swicc_state.fs.disk);
+}
+
+TEST(fs_swap, swicc_fs_disk_swap__rc)
+{
+    /* An EF with more data than fits in a short response. */
+    char const *const json_path = "build/tmp/Rm6tXc2WqP8zLh4N.json";
+    FILE *const f = fopen(json_path, "w");
+    REQUIRE_NE((void *)f, NULL);
+    fputs("{\"disk\":[{\"type\":\"file_mf\",\"id\":\"3F00\",\"sid\":\"01\","
+          "\"name\":{\"type\":\"ascii\",\"contents\":\"Rm6tXc2WqP8zLh4N\"},"
+          "\"contents\":[{\"type\":\"file_ef_transparent\",\"id\":\"2F00\","
+          "\"sid\":\"02\",\"contents\":{\"type\":\"hex\",\"contents\":\"",
+          f);
+    for (uint32_t byte_idx = 0U; byte_idx < 300U; ++byte_idx)
+    {
+        fprintf(f, "%02X", byte_idx & 0xFFU);
+    }
+    fputs("\"}}]}]}", f);
+    REQUIRE_EQ(fclose(f), 0);
+
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_disk_st disk = {0U};
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk, json_path),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_diskjs_disk_create(&disk, json_path), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0x2F00),
+               SWICC_RET_SUCCESS);
+
+    uint8_t const capdu_read[] = {0x00, 0xB0, 0x00, 0x00};
+    uint8_t const capdu_get[] = {0x00, 0xC0, 0x00, 0x00, 0x00};
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_len;
+
+    /* Without a swap, the chained data is retrieved with GET RESPONSE. */
+    rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu_read, sizeof(capdu_read),
+                                rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len, 2U);
+    CHECK_EQ(rapdu[0U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+    rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu_get, sizeof(capdu_get),
+                                rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len, 256U + 2U);
+    CHECK_EQ(rapdu[255U], 0xFF);
+    CHECK_EQ(rapdu[256U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+    CHECK_EQ(rapdu[257U], 300U - 256U);
+
+    /* A swap in between the command and GET RESPONSE drops the chain. */
+    rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu_read, sizeof(capdu_read),
+                                rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len, 2U);
+    CHECK_EQ(rapdu[0U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+    REQUIRE_EQ(swicc_fs_disk_swap(&swicc_state, &disk), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_fs_disk_swap_apply(&swicc_state), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_apdu_rc_len_rem(&swicc_state.apdu_rc), 0U);
+    REQUIRE_EQ(swicc_fs_disk_swap_reclaim(&swicc_state, &disk),
+               SWICC_RET_SUCCESS);
+    /* The old disk is gone before the interface asks for the rest. */
+    swicc_disk_unload(&disk);
+    rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu_get, sizeof(capdu_get),
+                                rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len, 2U);
+    CHECK_EQ(rapdu[0U], SWICC_APDU_SW1_WARN_NVM_CHGN);
+    CHECK_EQ(rapdu[1U], 0x82);
+
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+    swicc_disk_unload(&swicc_state.fs.disk);
+}
@@ -0,0 +1,35 @@
+#include <tau/tau.h>
+
+#include <string.h>
+#include <swicc/swicc.h>
+
+TEST(lz4, swicc_lz4__roundtrip)
+{
+    /* Padding-filled records compress to a fraction of their size. */
+    uint8_t src[1024U];
+    memset(src, 0xFF, sizeof(src));
+    for (uint32_t rcrd_idx = 0U; rcrd_idx < sizeof(src) / 32U; ++rcrd_idx)
+    {
+        /* Safe cast since there are fewer than 256 records. */
+        src[rcrd_idx * 32U] = (uint8_t)rcrd_idx;
+    }
+    uint8_t dst[SWICC_LZ4_BOUND(sizeof(src))];
+    uint32_t dst_len;
+    REQUIRE_EQ(swicc_lz4_compress(src, sizeof(src), dst, sizeof(dst), &dst_len),
+               SWICC_RET_SUCCESS);
+    CHECK_LT(dst_len, sizeof(src) / 4U);
+    uint8_t out[sizeof(src)];
+    REQUIRE_EQ(swicc_lz4_decompress(dst, dst_len, out, sizeof(out)),
+               SWICC_RET_SUCCESS);
+    CHECK_BUF_EQ(out, src, sizeof(src));
+
+    /* The length must match exactly and the block must not be cut. */
+    CHECK_EQ(swicc_lz4_decompress(dst, dst_len, out, sizeof(out) - 1U),
+             SWICC_RET_ERROR);
+    CHECK_EQ(swicc_lz4_decompress(dst, dst_len - 1U, out, sizeof(out)),
+             SWICC_RET_ERROR);
+
+    /* Too small of a destination is reported instead of being overrun. */
+    CHECK_EQ(swicc_lz4_compress(src, sizeof(src), dst, 8U, &dst_len),
+             SWICC_RET_ERROR);
+}
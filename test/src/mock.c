@@ -0,0 +1,46 @@
+#include <tau/tau.h>
+
+#include <string.h>
+#include <swicc/swicc.h>
+
+TEST(mock, swicc_mock_apdu)
+{
+    static swicc_st swicc_state;
+    uint8_t buf_rx[SWICC_DATA_MAX];
+    uint8_t buf_tx[SWICC_DATA_MAX];
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_state.buf_rx = buf_rx;
+    swicc_state.buf_tx = buf_tx;
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/007-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_mock_reset_cold(&swicc_state, true), SWICC_RET_SUCCESS);
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_len = sizeof(rapdu);
+    CHECK_EQ(swicc_mock_apdu(&swicc_state, NULL, 5U, rapdu, &rapdu_len),
+             SWICC_RET_PARAM_BAD);
+
+    /* The FCP is retrieved with GET RESPONSE after '61XX'. */
+    uint8_t const capdu_select[] = {0x00, 0xA4, 0x00, 0x04, 0x02, 0x3F, 0x00};
+    REQUIRE_EQ(swicc_mock_apdu(&swicc_state, capdu_select,
+                               sizeof(capdu_select), rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(rapdu_len > 2U, true);
+    CHECK_EQ(rapdu[0U], 0x62);
+    CHECK_EQ(rapdu[1U], rapdu_len - 4U);
+    CHECK_EQ(rapdu[rapdu_len - 2U], SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(rapdu[rapdu_len - 1U], 0x00);
+    uint16_t const fcp_len = (uint16_t)(rapdu_len - 2U);
+
+    /* When the data won't fit, the '61XX' is returned as is. */
+    rapdu_len = fcp_len + 1U;
+    REQUIRE_EQ(swicc_mock_apdu(&swicc_state, capdu_select,
+                               sizeof(capdu_select), rapdu, &rapdu_len),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(rapdu_len, 2U);
+    CHECK_EQ(rapdu[0U], SWICC_APDU_SW1_NORM_BYTES_AVAILABLE);
+    CHECK_EQ(rapdu[1U], fcp_len);
+
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+}
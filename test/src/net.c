@@ -0,0 +1,1120 @@
+#include <tau/tau.h>
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <swicc/swicc.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Poll the keep-alive of a server.
+ * @param server
+ * @param now
+ * @param slot_size Number of slots that can be returned.
+ * @return Bit mask of the slots that are due, UINT32_MAX on failure.
+ */
+static uint32_t keepalive_poll(swicc_net_server_st *const server,
+                               uint64_t const now, uint32_t const slot_size)
+{
+    uint16_t slot[4U];
+    uint32_t slot_count;
+    if (swicc_net_server_keepalive_poll(server, now, slot, slot_size,
+                                        &slot_count) != SWICC_RET_SUCCESS)
+    {
+        return UINT32_MAX;
+    }
+    uint32_t slot_due = 0U;
+    for (uint32_t slot_idx = 0U; slot_idx < slot_count; ++slot_idx)
+    {
+        slot_due |= 1U << slot[slot_idx];
+    }
+    return slot_due;
+}
+
+/**
+ * @brief Send keep-alive requests to a card.
+ * @param sock Socket of the peer of the card.
+ * @param msg_count How many requests to send.
+ * @return 0 on success, -1 on failure.
+ */
+static int32_t keepalive_send(int32_t const sock, uint32_t const msg_count)
+{
+    static swicc_net_msg_st msg;
+    memset(&msg, 0U, sizeof(msg));
+    msg.hdr.size = offsetof(swicc_net_msg_data_st, buf);
+    msg.data.ctrl = SWICC_NET_MSG_CTRL_KEEPALIVE;
+    size_t const msg_size = sizeof(msg.hdr) + msg.hdr.size;
+    for (uint32_t msg_idx = 0U; msg_idx < msg_count; ++msg_idx)
+    {
+        if (write(sock, &msg, msg_size) != (ssize_t)msg_size)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Count the turns a card was given by the scheduler.
+ * @param stats
+ * @return Number of turns.
+ */
+static uint64_t sched_turn_count(swicc_stats_st const *const stats)
+{
+    uint64_t turn_count = 0U;
+    for (uint32_t bucket = 0U; bucket < SWICC_STATS_LAT_BUCKET_COUNT; ++bucket)
+    {
+        turn_count += stats->sched_delay[bucket];
+    }
+    return turn_count;
+}
+
+/* A C-APDU of SELECT for the MF of the card. */
+static uint8_t const capdu_select_mf[] = {0x00, 0xA4, 0x00, 0x0C,
+                                          0x02, 0x3F, 0x00};
+
+/**
+ * @brief Create a card for the tests which exchange messages with a peer.
+ * @param swicc_state
+ * @return Return code.
+ */
+static swicc_ret_et card_create(swicc_st *const swicc_state)
+{
+    memset(swicc_state, 0U, sizeof(*swicc_state));
+    return swicc_diskjs_disk_create(&swicc_state->fs.disk,
+                                    "test/data/disk/007-in.json");
+}
+
+/**
+ * @brief Create the requests a peer sends to a card: a cold reset, then a
+ * SELECT of the MF.
+ * @param req Where the 2 requests will be written.
+ */
+static void card_req_create(swicc_net_msg_st *const req)
+{
+    memset(req, 0U, 2U * sizeof(*req));
+    req[0U].hdr.size = offsetof(swicc_net_msg_data_st, buf);
+    req[0U].data.ctrl = SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_Y;
+    req[1U].hdr.size =
+        offsetof(swicc_net_msg_data_st, buf) + sizeof(capdu_select_mf);
+    req[1U].data.ctrl = SWICC_NET_MSG_CTRL_APDU;
+    memcpy(req[1U].data.buf, capdu_select_mf, sizeof(capdu_select_mf));
+}
+
+/**
+ * @brief Check the responses of a card to the requests of 'card_req_create'.
+ * @param res The 2 responses.
+ * @return true if they are as expected, false otherwise.
+ */
+static bool card_res_valid(swicc_net_msg_st const *const res)
+{
+    return res[0U].data.ctrl == SWICC_NET_MSG_CTRL_SUCCESS &&
+           res[0U].hdr.size ==
+               offsetof(swicc_net_msg_data_st, buf) + sizeof(swicc_atr) &&
+           memcmp(res[0U].data.buf, swicc_atr, sizeof(swicc_atr)) == 0 &&
+           res[1U].data.ctrl == SWICC_NET_MSG_CTRL_SUCCESS &&
+           res[1U].hdr.size == offsetof(swicc_net_msg_data_st, buf) + 2U &&
+           res[1U].data.buf[0U] == SWICC_APDU_SW1_NORM_NONE &&
+           res[1U].data.buf[1U] == 0x00;
+}
+
+/**
+ * @brief Send the requests of 'card_req_create' to a card.
+ * @param sock Socket of the peer of the card.
+ * @return 0 on success, -1 on failure.
+ */
+static int32_t card_req_send(int32_t const sock)
+{
+    static swicc_net_msg_st req[2U];
+    card_req_create(req);
+    for (uint32_t req_idx = 0U; req_idx < 2U; ++req_idx)
+    {
+        if (swicc_net_send(sock, &req[req_idx]) != SWICC_RET_SUCCESS)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Receive the responses of a card and check them, see
+ * 'card_res_valid'.
+ * @param sock Socket of the peer of the card.
+ * @return 0 on success, -1 on failure.
+ */
+static int32_t card_res_recv(int32_t const sock)
+{
+    static swicc_net_msg_st res[2U];
+    for (uint32_t res_idx = 0U; res_idx < 2U; ++res_idx)
+    {
+        if (swicc_net_recv(sock, &res[res_idx]) != SWICC_RET_SUCCESS)
+        {
+            return -1;
+        }
+    }
+    return card_res_valid(res) ? 0 : -1;
+}
+
+/* Number of signals caught while a client was blocked. */
+static atomic_uint sig_count = 0U;
+
+static void sig_count_handler(int const sig)
+{
+    (void)sig;
+    atomic_fetch_add(&sig_count, 1U);
+}
+
+/**
+ * @brief Send the requests of 'card_req_create' one byte at a time with a
+ * pause after each byte, then close the sending side of the socket.
+ * @param arg Pointer to the socket of the peer of the card.
+ * @return NULL.
+ */
+static void *card_req_send_slow(void *const arg)
+{
+    int32_t const sock = *(int32_t const *)arg;
+    static swicc_net_msg_st req[2U];
+    card_req_create(req);
+    struct timespec const pause = {.tv_sec = 0, .tv_nsec = 2000000};
+    for (uint32_t req_idx = 0U; req_idx < 2U; ++req_idx)
+    {
+        uint8_t const *const buf = (uint8_t const *)&req[req_idx];
+        size_t const len = sizeof(req[req_idx].hdr) + req[req_idx].hdr.size;
+        for (size_t idx = 0U; idx < len; ++idx)
+        {
+            if (send(sock, &buf[idx], 1U, MSG_NOSIGNAL) != 1)
+            {
+                break;
+            }
+            nanosleep(&pause, NULL);
+        }
+    }
+    shutdown(sock, SHUT_WR);
+    return NULL;
+}
+
+/* Number of keep-alive requests 'card_ka_send' sends. */
+#define CARD_KA_COUNT 2000U
+
+/**
+ * @brief Send many keep-alive requests at once, then close the sending side.
+ * @param arg The socket of the peer.
+ * @return NULL.
+ */
+static void *card_ka_send(void *const arg)
+{
+    int32_t const sock = *(int32_t const *)arg;
+    static uint8_t buf[CARD_KA_COUNT * sizeof(swicc_net_msg_st)];
+    swicc_net_msg_st ka;
+    memset(&ka, 0U, sizeof(ka));
+    ka.hdr.size = offsetof(swicc_net_msg_data_st, buf);
+    ka.data.ctrl = SWICC_NET_MSG_CTRL_KEEPALIVE;
+    size_t const ka_len = sizeof(ka.hdr) + ka.hdr.size;
+    for (uint32_t msg_idx = 0U; msg_idx < CARD_KA_COUNT; ++msg_idx)
+    {
+        memcpy(&buf[msg_idx * ka_len], &ka, ka_len);
+    }
+    size_t sent = 0U;
+    while (sent < CARD_KA_COUNT * ka_len)
+    {
+        ssize_t const ret = send(sock, &buf[sent],
+                                 CARD_KA_COUNT * ka_len - sent, MSG_NOSIGNAL);
+        if (ret <= 0)
+        {
+            break;
+        }
+        sent += (size_t)ret;
+    }
+    shutdown(sock, SHUT_WR);
+    return NULL;
+}
+
+/* A card and its client that get run on their own thread. */
+typedef struct card_thread_s
+{
+    swicc_st *swicc_state;
+    swicc_net_client_st *client;
+    swicc_ret_et ret;
+} card_thread_st;
+
+/**
+ * @brief Run a network client until it stops.
+ * @param arg Pointer to a card thread context.
+ * @return NULL.
+ */
+static void *card_thread_run(void *const arg)
+{
+    card_thread_st *const card_thread = arg;
+    card_thread->ret =
+        swicc_net_client(card_thread->swicc_state, card_thread->client);
+    return NULL;
+}
+
+/**
+ * @brief Run a reactor until it has no cards left.
+ * @param arg Pointer to the reactor.
+ * @return NULL.
+ */
+static void *reactor_thread_run(void *const arg)
+{
+    swicc_net_reactor_run(arg);
+    return NULL;
+}
+
+TEST(net, swicc_net_client_create_shm)
+{
+    char const *const shm_name = "/swicc-Lk3vPz8Qn";
+    shm_unlink(shm_name);
+    swicc_net_shm_st shm;
+    REQUIRE_EQ(swicc_net_shm_create(&shm, shm_name), SWICC_RET_SUCCESS);
+    swicc_net_client_st client;
+    memset(&client, 0xFF, sizeof(client));
+    REQUIRE_EQ(swicc_net_client_create_shm(&client, shm_name),
+               SWICC_RET_SUCCESS);
+    /* Only errors are logged by default. */
+    CHECK_EQ(client.log_lvl, SWICC_NET_LOG_LVL_ERROR);
+    CHECK_EQ(client.sock_client, -1);
+    swicc_net_client_destroy(&client);
+    swicc_net_shm_destroy(&shm);
+}
+
+TEST(net, swicc_net_shm)
+{
+    char const *const shm_name = "/swicc-Rf6tHw2Jd";
+    shm_unlink(shm_name);
+    static swicc_net_shm_st shm_server;
+    static swicc_net_shm_st shm_client;
+    static swicc_net_msg_st msg_tx;
+    static swicc_net_msg_st msg_rx;
+    CHECK_EQ(swicc_net_shm_send(NULL, &msg_tx), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_net_shm_recv(NULL, &msg_rx), SWICC_RET_PARAM_BAD);
+    REQUIRE_EQ(swicc_net_shm_create(&shm_server, shm_name), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_shm_open(&shm_client, shm_name), SWICC_RET_SUCCESS);
+
+    /* Requests and responses each go through their own queue. */
+    memset(&msg_tx, 0U, sizeof(msg_tx));
+    msg_tx.hdr.size = offsetof(swicc_net_msg_data_st, buf) + 5U;
+    msg_tx.data.ctrl = SWICC_NET_MSG_CTRL_APDU;
+    memcpy(msg_tx.data.buf, (uint8_t[]){0x00, 0xA4, 0x00, 0x04, 0x02}, 5U);
+    for (uint8_t msg_idx = 0U; msg_idx < SWICC_NET_SHM_RING_LEN; ++msg_idx)
+    {
+        msg_tx.data.buf[4U] = msg_idx;
+        REQUIRE_EQ(swicc_net_shm_send(&shm_server, &msg_tx),
+                   SWICC_RET_SUCCESS);
+    }
+    for (uint8_t msg_idx = 0U; msg_idx < SWICC_NET_SHM_RING_LEN; ++msg_idx)
+    {
+        msg_tx.data.buf[4U] = msg_idx;
+        REQUIRE_EQ(swicc_net_shm_recv(&shm_client, &msg_rx),
+                   SWICC_RET_SUCCESS);
+        CHECK_EQ(msg_rx.hdr.size, msg_tx.hdr.size);
+        CHECK_BUF_EQ((uint8_t *)&msg_rx.data, (uint8_t *)&msg_tx.data,
+                     msg_tx.hdr.size);
+    }
+    msg_tx.data.ctrl = SWICC_NET_MSG_CTRL_SUCCESS;
+    REQUIRE_EQ(swicc_net_shm_send(&shm_client, &msg_tx), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_shm_recv(&shm_server, &msg_rx), SWICC_RET_SUCCESS);
+    CHECK_EQ(msg_rx.data.ctrl, SWICC_NET_MSG_CTRL_SUCCESS);
+
+    /* A message with a bad size is never copied out of the queue. */
+    REQUIRE_EQ(swicc_net_shm_send(&shm_server, &msg_tx), SWICC_RET_SUCCESS);
+    swicc_net_shm_ring_st *const ring = &shm_server.region->ring_req;
+    ring->msg[(atomic_load(&ring->head) - 1U) % SWICC_NET_SHM_RING_LEN]
+        .hdr.size = UINT32_MAX;
+    CHECK_EQ(swicc_net_shm_recv(&shm_client, &msg_rx), SWICC_RET_ERROR);
+
+    /* The client sees the channel closed once the server is gone. */
+    swicc_net_shm_destroy(&shm_server);
+    CHECK_EQ(swicc_net_shm_send(&shm_client, &msg_tx),
+             SWICC_RET_NET_DISCONNECTED);
+    swicc_net_shm_destroy(&shm_client);
+    CHECK_EQ(swicc_net_shm_open(&shm_client, shm_name), SWICC_RET_ERROR);
+}
+
+TEST(net, swicc_net_client__shm)
+{
+    char const *const shm_name = "/swicc-Hq7mVc2Lx";
+    shm_unlink(shm_name);
+    static swicc_net_shm_st shm;
+    static swicc_st swicc_state;
+    static swicc_net_client_st client;
+    static swicc_net_msg_st msg[2U];
+    REQUIRE_EQ(card_create(&swicc_state), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_shm_create(&shm, shm_name), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_client_create_shm(&client, shm_name),
+               SWICC_RET_SUCCESS);
+    card_thread_st card_thread = {
+        .swicc_state = &swicc_state,
+        .client = &client,
+        .ret = SWICC_RET_UNKNOWN,
+    };
+    pthread_t thread;
+    REQUIRE_EQ(pthread_create(&thread, NULL, card_thread_run, &card_thread),
+               0);
+
+    /* Every request is answered before the next one is sent. */
+    card_req_create(msg);
+    for (uint32_t msg_idx = 0U; msg_idx < 2U; ++msg_idx)
+    {
+        CHECK_EQ(swicc_net_shm_send(&shm, &msg[msg_idx]), SWICC_RET_SUCCESS);
+        CHECK_EQ(swicc_net_shm_recv(&shm, &msg[msg_idx]), SWICC_RET_SUCCESS);
+    }
+    CHECK_EQ(card_res_valid(msg), true);
+
+    /* The client stops once the server closes the channel. */
+    swicc_net_shm_destroy(&shm);
+    pthread_join(thread, NULL);
+    CHECK_EQ(card_thread.ret, SWICC_RET_NET_DISCONNECTED);
+    swicc_net_client_destroy(&client);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(net, swicc_net_reactor_run__sched)
+{
+    static swicc_net_reactor_st reactor;
+    static swicc_st swicc_state[2U];
+    static swicc_stats_st stats[2U];
+    static swicc_net_client_st client[2U];
+    swicc_net_reactor_card_st card[2U];
+    int32_t sock_peer[2U];
+    REQUIRE_EQ(swicc_net_reactor_create(&reactor), SWICC_RET_SUCCESS);
+    /* Only the weights end turns. */
+    reactor.budget = 1000000000U;
+
+    /* The requests are all there by the time the reactor runs. */
+    uint32_t const msg_count[2U] = {6U, 1U};
+    for (uint32_t card_idx = 0U; card_idx < 2U; ++card_idx)
+    {
+        memset(&swicc_state[card_idx], 0U, sizeof(swicc_state[card_idx]));
+        swicc_stats_reset(&stats[card_idx]);
+        swicc_state[card_idx].stats = &stats[card_idx];
+        int sock_pair[2U];
+        REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+        memset(&client[card_idx], 0U, sizeof(client[card_idx]));
+        client[card_idx].sock_client = sock_pair[0U];
+        sock_peer[card_idx] = sock_pair[1U];
+        REQUIRE_EQ(swicc_net_reactor_card_add(&reactor, &card[card_idx],
+                                              &swicc_state[card_idx],
+                                              &client[card_idx]),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(keepalive_send(sock_peer[card_idx], msg_count[card_idx]),
+                   0);
+        /* Cards get removed once all requests are handled. */
+        REQUIRE_EQ(shutdown(sock_peer[card_idx], SHUT_WR), 0);
+    }
+    CHECK_EQ(swicc_net_reactor_card_sched_set(&reactor, &card[0U],
+                                              SWICC_NET_REACTOR_PRIO_COUNT,
+                                              1U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_net_reactor_card_sched_set(&reactor, &card[0U],
+                                              SWICC_NET_REACTOR_PRIO_LOW, 0U),
+             SWICC_RET_PARAM_BAD);
+    REQUIRE_EQ(swicc_net_reactor_card_sched_set(
+                   &reactor, &card[0U], SWICC_NET_REACTOR_PRIO_LOW, 2U),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_reactor_card_sched_set(
+                   &reactor, &card[1U], SWICC_NET_REACTOR_PRIO_HIGH, 1U),
+               SWICC_RET_SUCCESS);
+
+    CHECK_EQ(swicc_net_reactor_run(&reactor), SWICC_RET_SUCCESS);
+    CHECK_EQ(reactor.card_count, 0U);
+    CHECK_EQ(reactor.sched_count, 0U);
+
+    /* The busy card handled its requests 2 at a time. */
+    CHECK_EQ(stats[0U].net_tx_msg, 6U);
+    CHECK_EQ(sched_turn_count(&stats[0U]), 3U);
+    CHECK_EQ(stats[0U].sched_yield, 2U);
+    CHECK_EQ(stats[1U].net_tx_msg, 1U);
+    CHECK_EQ(sched_turn_count(&stats[1U]), 1U);
+    CHECK_EQ(stats[1U].sched_yield, 0U);
+
+    for (uint32_t card_idx = 0U; card_idx < 2U; ++card_idx)
+    {
+        close(sock_peer[card_idx]);
+        close(client[card_idx].sock_client);
+    }
+    swicc_net_reactor_destroy(&reactor);
+}
+
+TEST(net, swicc_net_reactor_run__loopback)
+{
+    static swicc_net_reactor_st reactor;
+    static swicc_st swicc_state[2U];
+    static swicc_net_client_st client[2U];
+    swicc_net_reactor_card_st card[2U];
+    int32_t sock_peer[2U];
+    REQUIRE_EQ(swicc_net_reactor_create(&reactor), SWICC_RET_SUCCESS);
+    for (uint32_t card_idx = 0U; card_idx < 2U; ++card_idx)
+    {
+        REQUIRE_EQ(card_create(&swicc_state[card_idx]), SWICC_RET_SUCCESS);
+        int sock_pair[2U];
+        REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+        memset(&client[card_idx], 0U, sizeof(client[card_idx]));
+        client[card_idx].sock_client = sock_pair[0U];
+        sock_peer[card_idx] = sock_pair[1U];
+        REQUIRE_EQ(swicc_net_reactor_card_add(&reactor, &card[card_idx],
+                                              &swicc_state[card_idx],
+                                              &client[card_idx]),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(card_req_send(sock_peer[card_idx]), 0);
+        REQUIRE_EQ(shutdown(sock_peer[card_idx], SHUT_WR), 0);
+    }
+
+    /* Each card resets and answers the SELECT on its own connection. */
+    CHECK_EQ(swicc_net_reactor_run(&reactor), SWICC_RET_SUCCESS);
+    CHECK_EQ(reactor.card_count, 0U);
+    for (uint32_t card_idx = 0U; card_idx < 2U; ++card_idx)
+    {
+        CHECK_EQ(card_res_recv(sock_peer[card_idx]), 0);
+        close(sock_peer[card_idx]);
+        close(client[card_idx].sock_client);
+        swicc_terminate(&swicc_state[card_idx]);
+    }
+    swicc_net_reactor_destroy(&reactor);
+}
+
+TEST(net, swicc_runtime__loopback)
+{
+    static swicc_runtime_st runtime;
+    static swicc_st swicc_state[4U];
+    static swicc_net_client_st client[4U];
+    swicc_net_reactor_card_st card[4U];
+    int32_t sock_peer[4U];
+    REQUIRE_EQ(swicc_runtime_create(&runtime, 2U), SWICC_RET_SUCCESS);
+    for (uint32_t card_idx = 0U; card_idx < 4U; ++card_idx)
+    {
+        REQUIRE_EQ(card_create(&swicc_state[card_idx]), SWICC_RET_SUCCESS);
+        int sock_pair[2U];
+        REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+        memset(&client[card_idx], 0U, sizeof(client[card_idx]));
+        client[card_idx].sock_client = sock_pair[0U];
+        sock_peer[card_idx] = sock_pair[1U];
+        REQUIRE_EQ(swicc_runtime_card_add(&runtime, &card[card_idx],
+                                          &swicc_state[card_idx],
+                                          &client[card_idx]),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(card_req_send(sock_peer[card_idx]), 0);
+        REQUIRE_EQ(shutdown(sock_peer[card_idx], SHUT_WR), 0);
+    }
+    /* Cards are spread evenly over the shards. */
+    CHECK_EQ(runtime.shard[0U].reactor.card_count, 2U);
+    CHECK_EQ(runtime.shard[1U].reactor.card_count, 2U);
+
+    /* Workers stop on their own once all their peers are gone. */
+    REQUIRE_EQ(swicc_runtime_start(&runtime), SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_runtime_wait(&runtime), SWICC_RET_SUCCESS);
+    for (uint32_t card_idx = 0U; card_idx < 4U; ++card_idx)
+    {
+        close(client[card_idx].sock_client);
+        CHECK_EQ(card_res_recv(sock_peer[card_idx]), 0);
+        close(sock_peer[card_idx]);
+        swicc_terminate(&swicc_state[card_idx]);
+    }
+    swicc_runtime_destroy(&runtime);
+}
+
+TEST(net, swicc_net_client__fragmented)
+{
+    static swicc_st swicc_state;
+    static swicc_net_client_st client;
+    REQUIRE_EQ(card_create(&swicc_state), SWICC_RET_SUCCESS);
+    int sock_pair[2U];
+    REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+    memset(&client, 0U, sizeof(client));
+    client.sock_client = sock_pair[0U];
+    int32_t sock_peer = sock_pair[1U];
+
+    /**
+     * Signals interrupt the blocked client without restarting its calls. Only
+     * the thread of the client gets them.
+     */
+    struct sigaction sa;
+    memset(&sa, 0U, sizeof(sa));
+    sa.sa_handler = sig_count_handler;
+    REQUIRE_EQ(sigaction(SIGALRM, &sa, NULL), 0);
+    sigset_t sig_alrm;
+    sigemptyset(&sig_alrm);
+    sigaddset(&sig_alrm, SIGALRM);
+    REQUIRE_EQ(pthread_sigmask(SIG_BLOCK, &sig_alrm, NULL), 0);
+    pthread_t sender;
+    REQUIRE_EQ(pthread_create(&sender, NULL, card_req_send_slow, &sock_peer),
+               0);
+    REQUIRE_EQ(pthread_sigmask(SIG_UNBLOCK, &sig_alrm, NULL), 0);
+    atomic_store(&sig_count, 0U);
+    struct itimerval const timer = {
+        .it_interval = {.tv_sec = 0, .tv_usec = 1000},
+        .it_value = {.tv_sec = 0, .tv_usec = 1000},
+    };
+    REQUIRE_EQ(setitimer(ITIMER_REAL, &timer, NULL), 0);
+
+    /* Requests arrive in many pieces and are handled once complete. */
+    CHECK_EQ(swicc_net_client(&swicc_state, &client),
+             SWICC_RET_NET_DISCONNECTED);
+    struct itimerval const timer_off = {0};
+    setitimer(ITIMER_REAL, &timer_off, NULL);
+    close(client.sock_client);
+    pthread_join(sender, NULL);
+    signal(SIGALRM, SIG_DFL);
+    CHECK_GT(atomic_load(&sig_count), 0U);
+    CHECK_EQ(card_res_recv(sock_peer), 0);
+
+    close(sock_peer);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(net, swicc_net_client_step__loopback)
+{
+    static swicc_st swicc_state;
+    static swicc_net_client_st client;
+    static swicc_net_msg_st req[2U];
+    REQUIRE_EQ(card_create(&swicc_state), SWICC_RET_SUCCESS);
+    int sock_pair[2U];
+    REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+    memset(&client, 0U, sizeof(client));
+    client.sock_client = sock_pair[0U];
+    int32_t const sock_peer = sock_pair[1U];
+    uint8_t ready;
+    CHECK_EQ(swicc_net_client_step(&swicc_state, &client, NULL),
+             SWICC_RET_PARAM_BAD);
+
+    /* Nothing to do yet, the client waits for requests. */
+    REQUIRE_EQ(swicc_net_client_step(&swicc_state, &client, &ready),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(ready, SWICC_NET_READY_READ);
+
+    /* Part of a request is kept until the rest of it arrives. */
+    card_req_create(req);
+    uint8_t const *const buf_req = (uint8_t const *)&req[0U];
+    REQUIRE_EQ(write(sock_peer, buf_req, 3U), 3);
+    REQUIRE_EQ(swicc_net_client_step(&swicc_state, &client, &ready),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(ready, SWICC_NET_READY_READ);
+    uint8_t byte;
+    CHECK_EQ(recv(sock_peer, &byte, 1U, MSG_DONTWAIT), -1);
+    size_t const req_len = sizeof(req[0U].hdr) + req[0U].hdr.size;
+    REQUIRE_EQ(write(sock_peer, &buf_req[3U], req_len - 3U),
+               (ssize_t)(req_len - 3U));
+    REQUIRE_EQ(swicc_net_send(sock_peer, &req[1U]), SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_client_step(&swicc_state, &client, &ready),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(ready, SWICC_NET_READY_READ);
+    CHECK_EQ(card_res_recv(sock_peer), 0);
+
+    /**
+     * A peer that does not read its responses makes the client stop reading
+     * once the socket and the queue are full.
+     */
+    int32_t const sndbuf = 1;
+    REQUIRE_EQ(setsockopt(client.sock_client, SOL_SOCKET, SO_SNDBUF, &sndbuf,
+                          sizeof(sndbuf)),
+               0);
+    uint32_t const msg_count = 1000U;
+    size_t const ka_len = sizeof(req[0U].hdr) +
+                          offsetof(swicc_net_msg_data_st, buf);
+    static uint8_t buf_ka[1000U * sizeof(swicc_net_msg_st)];
+    swicc_net_msg_st ka;
+    memset(&ka, 0U, sizeof(ka));
+    ka.hdr.size = offsetof(swicc_net_msg_data_st, buf);
+    ka.data.ctrl = SWICC_NET_MSG_CTRL_KEEPALIVE;
+    for (uint32_t msg_idx = 0U; msg_idx < msg_count; ++msg_idx)
+    {
+        memcpy(&buf_ka[msg_idx * ka_len], &ka, ka_len);
+    }
+    /* All requests are written at once to not block on the socket. */
+    REQUIRE_EQ(write(sock_peer, buf_ka, msg_count * ka_len),
+               (ssize_t)(msg_count * ka_len));
+    uint32_t step_count = 0U;
+    do
+    {
+        REQUIRE_EQ(swicc_net_client_step(&swicc_state, &client, &ready),
+                   SWICC_RET_SUCCESS);
+    } while (ready != SWICC_NET_READY_WRITE && ++step_count < msg_count);
+    CHECK_EQ(ready, SWICC_NET_READY_WRITE);
+
+    /* Once the peer reads, every request gets answered. */
+    /* A keep-alive response is as long as its request. */
+    size_t const res_len = ka_len;
+    size_t res_recvd = 0U;
+    for (step_count = 0U;
+         res_recvd < msg_count * res_len && step_count < msg_count;
+         ++step_count)
+    {
+        static uint8_t buf_res[4096U];
+        ssize_t const recvd =
+            recv(sock_peer, buf_res, sizeof(buf_res), MSG_DONTWAIT);
+        if (recvd > 0)
+        {
+            res_recvd += (size_t)recvd;
+        }
+        REQUIRE_EQ(swicc_net_client_step(&swicc_state, &client, &ready),
+                   SWICC_RET_SUCCESS);
+    }
+    CHECK_EQ(res_recvd, msg_count * res_len);
+    CHECK_EQ(ready, SWICC_NET_READY_READ);
+
+    close(sock_peer);
+    close(client.sock_client);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(net, swicc_net_client_step__pipelined)
+{
+    static swicc_st swicc_state;
+    static swicc_net_client_st client;
+    REQUIRE_EQ(card_create(&swicc_state), SWICC_RET_SUCCESS);
+    int sock_pair[2U];
+    REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+    memset(&client, 0U, sizeof(client));
+    client.sock_client = sock_pair[0U];
+    int32_t const sock_peer = sock_pair[1U];
+    uint8_t ready;
+
+    /**
+     * As many requests as fit in the receive buffer at once. Their responses
+     * fill the queue before all of them are handled.
+     */
+    swicc_net_msg_st ka;
+    memset(&ka, 0U, sizeof(ka));
+    ka.hdr.size = offsetof(swicc_net_msg_data_st, buf);
+    ka.data.ctrl = SWICC_NET_MSG_CTRL_KEEPALIVE;
+    size_t const ka_len = sizeof(ka.hdr) + ka.hdr.size;
+    size_t const msg_count = SWICC_NET_CONN_BUF_SIZE / ka_len;
+    REQUIRE_GT(msg_count, SWICC_NET_CONN_BUF_SIZE / sizeof(swicc_net_msg_st));
+    static uint8_t buf_ka[SWICC_NET_CONN_BUF_SIZE];
+    for (size_t msg_idx = 0U; msg_idx < msg_count; ++msg_idx)
+    {
+        memcpy(&buf_ka[msg_idx * ka_len], &ka, ka_len);
+    }
+    REQUIRE_EQ(write(sock_peer, buf_ka, msg_count * ka_len),
+               (ssize_t)(msg_count * ka_len));
+
+    /**
+     * Step only when the socket is ready as reported, like an event loop
+     * would. The peer waits for all responses before sending anything else.
+     */
+    uint32_t step_count = 0U;
+    do
+    {
+        REQUIRE_EQ(swicc_net_client_step(&swicc_state, &client, &ready),
+                   SWICC_RET_SUCCESS);
+    } while ((ready & SWICC_NET_READY_WRITE) != 0U && ++step_count < 100U);
+    CHECK_EQ(ready, SWICC_NET_READY_READ);
+    uint8_t byte;
+    CHECK_EQ(recv(client.sock_client, &byte, 1U, MSG_DONTWAIT | MSG_PEEK),
+             -1);
+
+    size_t res_recvd = 0U;
+    for (;;)
+    {
+        ssize_t const recvd =
+            recv(sock_peer, buf_ka, sizeof(buf_ka), MSG_DONTWAIT);
+        if (recvd <= 0)
+        {
+            break;
+        }
+        res_recvd += (size_t)recvd;
+    }
+    CHECK_EQ(res_recvd, msg_count * ka_len);
+
+    close(sock_peer);
+    close(client.sock_client);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(net, swicc_net_reactor_run__uring)
+{
+    static swicc_net_reactor_st reactor;
+    static swicc_st swicc_state[2U];
+    static swicc_net_client_st client[2U];
+    swicc_net_reactor_card_st card[2U];
+    int32_t sock_peer[2U];
+    /* io_uring is often disabled, e.g. in containers, so there is no test. */
+    if (swicc_net_reactor_create_uring(&reactor) != SWICC_RET_SUCCESS)
+    {
+        return;
+    }
+    for (uint32_t card_idx = 0U; card_idx < 2U; ++card_idx)
+    {
+        REQUIRE_EQ(card_create(&swicc_state[card_idx]), SWICC_RET_SUCCESS);
+        int sock_pair[2U];
+        REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+        memset(&client[card_idx], 0U, sizeof(client[card_idx]));
+        client[card_idx].sock_client = sock_pair[0U];
+        sock_peer[card_idx] = sock_pair[1U];
+        REQUIRE_EQ(swicc_net_reactor_card_add(&reactor, &card[card_idx],
+                                              &swicc_state[card_idx],
+                                              &client[card_idx]),
+                   SWICC_RET_SUCCESS);
+        REQUIRE_EQ(card_req_send(sock_peer[card_idx]), 0);
+        REQUIRE_EQ(shutdown(sock_peer[card_idx], SHUT_WR), 0);
+    }
+
+    /* Same answers as with epoll, only the way they are sent differs. */
+    CHECK_EQ(swicc_net_reactor_run(&reactor), SWICC_RET_SUCCESS);
+    CHECK_EQ(reactor.card_count, 0U);
+    for (uint32_t card_idx = 0U; card_idx < 2U; ++card_idx)
+    {
+        close(client[card_idx].sock_client);
+        CHECK_EQ(card_res_recv(sock_peer[card_idx]), 0);
+        close(sock_peer[card_idx]);
+        swicc_terminate(&swicc_state[card_idx]);
+    }
+    swicc_net_reactor_destroy(&reactor);
+}
+
+TEST(net, swicc_net_reactor_run__uring_throttle)
+{
+    static swicc_net_reactor_st reactor;
+    static swicc_st swicc_state;
+    static swicc_net_client_st client;
+    swicc_net_reactor_card_st card;
+    if (swicc_net_reactor_create_uring(&reactor) != SWICC_RET_SUCCESS)
+    {
+        return;
+    }
+    REQUIRE_EQ(card_create(&swicc_state), SWICC_RET_SUCCESS);
+    int sock_pair[2U];
+    REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+    memset(&client, 0U, sizeof(client));
+    client.sock_client = sock_pair[0U];
+    int32_t sock_peer = sock_pair[1U];
+    int32_t const sndbuf = 1;
+    REQUIRE_EQ(setsockopt(client.sock_client, SOL_SOCKET, SO_SNDBUF, &sndbuf,
+                          sizeof(sndbuf)),
+               0);
+    /* A card that gets dropped must not make the test hang. */
+    struct timeval const rcvtimeo = {.tv_sec = 1, .tv_usec = 0};
+    REQUIRE_EQ(setsockopt(sock_peer, SOL_SOCKET, SO_RCVTIMEO, &rcvtimeo,
+                          sizeof(rcvtimeo)),
+               0);
+    REQUIRE_EQ(swicc_net_reactor_card_add(&reactor, &card, &swicc_state,
+                                          &client),
+               SWICC_RET_SUCCESS);
+
+    /**
+     * The peer reads its responses only after it sent all requests, so the
+     * card has to stop receiving until it can answer again.
+     */
+    pthread_t sender;
+    REQUIRE_EQ(pthread_create(&sender, NULL, card_ka_send, &sock_peer), 0);
+    size_t const ka_len = sizeof(swicc_net_msg_hdr_st) +
+                          offsetof(swicc_net_msg_data_st, buf);
+    size_t res_recvd = 0U;
+    pthread_t runner;
+    REQUIRE_EQ(pthread_create(&runner, NULL, reactor_thread_run, &reactor), 0);
+    struct timespec const pause = {.tv_sec = 0, .tv_nsec = 50000000};
+    nanosleep(&pause, NULL);
+    for (;;)
+    {
+        static uint8_t buf_res[4096U];
+        ssize_t const recvd = recv(sock_peer, buf_res, sizeof(buf_res), 0);
+        if (recvd <= 0)
+        {
+            break;
+        }
+        res_recvd += (size_t)recvd;
+        if (res_recvd == CARD_KA_COUNT * ka_len)
+        {
+            break;
+        }
+    }
+    pthread_join(sender, NULL);
+    pthread_join(runner, NULL);
+    CHECK_EQ(res_recvd, CARD_KA_COUNT * ka_len);
+    CHECK_EQ(reactor.card_count, 0U);
+
+    close(client.sock_client);
+    close(sock_peer);
+    swicc_terminate(&swicc_state);
+    swicc_net_reactor_destroy(&reactor);
+}
+
+TEST(net, swicc_net_client__select_fid)
+{
+    static swicc_st swicc_state;
+    static swicc_net_client_st client;
+    static swicc_net_msg_st msg[3U];
+    REQUIRE_EQ(card_create(&swicc_state), SWICC_RET_SUCCESS);
+    int sock_pair[2U];
+    REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+    memset(&client, 0U, sizeof(client));
+    client.sock_client = sock_pair[0U];
+    int32_t const sock_peer = sock_pair[1U];
+
+    /* After the reset, files are selected by FID through the ID LUT. */
+    uint8_t const capdu_select[2U][7U] = {
+        {0x00, 0xA4, 0x00, 0x04, 0x02, 0x3F, 0x00},
+        {0x00, 0xA4, 0x00, 0x04, 0x02, 0x2F, 0xE2},
+    };
+    card_req_create(msg);
+    for (uint32_t msg_idx = 1U; msg_idx < 3U; ++msg_idx)
+    {
+        msg[msg_idx].hdr.size =
+            offsetof(swicc_net_msg_data_st, buf) + sizeof(capdu_select[0U]);
+        msg[msg_idx].data.ctrl = SWICC_NET_MSG_CTRL_APDU;
+        memcpy(msg[msg_idx].data.buf, capdu_select[msg_idx - 1U],
+               sizeof(capdu_select[0U]));
+    }
+    for (uint32_t msg_idx = 0U; msg_idx < 3U; ++msg_idx)
+    {
+        REQUIRE_EQ(swicc_net_send(sock_peer, &msg[msg_idx]), SWICC_RET_SUCCESS);
+    }
+    REQUIRE_EQ(shutdown(sock_peer, SHUT_WR), 0);
+    CHECK_EQ(swicc_net_client(&swicc_state, &client),
+             SWICC_RET_NET_DISCONNECTED);
+    close(client.sock_client);
+    for (uint32_t msg_idx = 0U; msg_idx < 3U; ++msg_idx)
+    {
+        REQUIRE_EQ(swicc_net_recv(sock_peer, &msg[msg_idx]), SWICC_RET_SUCCESS);
+        CHECK_EQ(msg[msg_idx].data.ctrl, SWICC_NET_MSG_CTRL_SUCCESS);
+    }
+
+    /* The FCP of the MF holds its FID. */
+    uint32_t const rapdu_len =
+        msg[1U].hdr.size - (uint32_t)offsetof(swicc_net_msg_data_st, buf);
+    REQUIRE_EQ(rapdu_len > 2U, true);
+    uint8_t const *const rapdu = msg[1U].data.buf;
+    CHECK_EQ(rapdu[rapdu_len - 2U], SWICC_APDU_SW1_NORM_NONE);
+    uint8_t const fcp_fid[] = {0x83, 0x02, 0x3F, 0x00};
+    bool fcp_fid_found = false;
+    for (uint32_t idx = 0U; idx + sizeof(fcp_fid) <= rapdu_len - 2U; ++idx)
+    {
+        fcp_fid_found |= memcmp(&rapdu[idx], fcp_fid, sizeof(fcp_fid)) == 0;
+    }
+    CHECK_EQ(fcp_fid_found, true);
+
+    /* A FID that is not on the disk is not found. */
+    CHECK_EQ(msg[2U].hdr.size, offsetof(swicc_net_msg_data_st, buf) + 2U);
+    CHECK_EQ(msg[2U].data.buf[0U], SWICC_APDU_SW1_CHER_P1P2_INFO);
+    CHECK_EQ(msg[2U].data.buf[1U], 0x82);
+
+    close(sock_peer);
+    swicc_terminate(&swicc_state);
+}
+
+TEST(net, swicc_net_client_mux)
+{
+    /* Card 0 must stay compatible with peers that don't multiplex. */
+    static_assert(sizeof(swicc_net_msg_hdr_st) == sizeof(uint32_t),
+                  "Message header must keep its size.");
+    static swicc_st swicc_state[3U];
+    static swicc_stats_st stats[3U];
+    swicc_st *swicc_state_ptr[3U];
+    static swicc_net_client_st client;
+    int sock_pair[2U];
+    REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+    memset(&client, 0U, sizeof(client));
+    client.sock_client = sock_pair[0U];
+
+    /* All slots are cards on the one connection. */
+    static swicc_net_server_st server;
+    memset(&server, 0U, sizeof(server));
+    server.sock_server = -1;
+    memset(server.keepalive.bucket, 0xFF, sizeof(server.keepalive.bucket));
+    REQUIRE_EQ(swicc_net_server_client_adopt(&server, 0U, sock_pair[1U]),
+               SWICC_RET_SUCCESS);
+    for (uint16_t slot_idx = 0U; slot_idx < 4U; ++slot_idx)
+    {
+        if (slot_idx > 0U)
+        {
+            REQUIRE_EQ(swicc_net_server_slot_attach(&server, slot_idx, 0U,
+                                                    slot_idx),
+                       SWICC_RET_SUCCESS);
+        }
+        if (slot_idx < 3U)
+        {
+            memset(&swicc_state[slot_idx], 0U, sizeof(swicc_state[slot_idx]));
+            swicc_stats_reset(&stats[slot_idx]);
+            swicc_state[slot_idx].stats = &stats[slot_idx];
+            swicc_state_ptr[slot_idx] = &swicc_state[slot_idx];
+        }
+    }
+    /* A card only gets one slot and the first slots are mirrored. */
+    CHECK_EQ(swicc_net_server_slot_attach(&server, 4U, 0U, 2U),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(server.sock_client[3U], sock_pair[1U]);
+    CHECK_EQ(swicc_net_client_mux(NULL, 3U, &client), SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_net_client_mux(swicc_state_ptr, 0U, &client),
+             SWICC_RET_PARAM_BAD);
+
+    /* Requests are all there by the time the client runs. */
+    uint16_t const slot_req[] = {2U, 0U, 2U, 1U};
+    uint32_t const req_count = sizeof(slot_req) / sizeof(slot_req[0U]);
+    static swicc_net_msg_st msg;
+    memset(&msg, 0U, sizeof(msg));
+    msg.hdr.size = offsetof(swicc_net_msg_data_st, buf);
+    msg.data.ctrl = SWICC_NET_MSG_CTRL_KEEPALIVE;
+    for (uint32_t req_idx = 0U; req_idx < req_count; ++req_idx)
+    {
+        REQUIRE_EQ(swicc_net_server_slot_send(&server, slot_req[req_idx], &msg),
+                   SWICC_RET_SUCCESS);
+    }
+    REQUIRE_EQ(shutdown(sock_pair[1U], SHUT_WR), 0);
+    CHECK_EQ(swicc_net_client_mux(swicc_state_ptr, 3U, &client),
+             SWICC_RET_NET_DISCONNECTED);
+    CHECK_EQ(stats[0U].net_rx_msg, 1U);
+    CHECK_EQ(stats[1U].net_rx_msg, 1U);
+    CHECK_EQ(stats[2U].net_rx_msg, 2U);
+
+    /**
+     * Responses come back in order, each for the card of its request. The
+     * first one is for card 2 so it is not the response of slot 0.
+     */
+    CHECK_EQ(swicc_net_server_slot_recv(&server, 0U, &msg), SWICC_RET_ERROR);
+    for (uint32_t req_idx = 1U; req_idx < req_count; ++req_idx)
+    {
+        uint32_t card;
+        uint16_t slot;
+        REQUIRE_EQ(swicc_net_recv_card(sock_pair[1U], &msg, &card),
+                   SWICC_RET_SUCCESS);
+        CHECK_EQ(msg.data.ctrl, SWICC_NET_MSG_CTRL_SUCCESS);
+        REQUIRE_EQ(swicc_net_server_slot_find(&server, sock_pair[1U], card,
+                                              &slot),
+                   SWICC_RET_SUCCESS);
+        CHECK_EQ(slot, slot_req[req_idx]);
+    }
+    close(sock_pair[0U]);
+    /* Disconnecting frees every slot of the connection. */
+    swicc_net_server_client_disconnect(&server, 2U);
+    CHECK_EQ(server.sock_client[0U], -1);
+    CHECK_EQ(server.sock_client[3U], -1);
+    CHECK_EQ(server.slot_index_count, 0U);
+
+    /* A message for a card the client does not have is an error. */
+    REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair), 0);
+    client.sock_client = sock_pair[0U];
+    memset(&client.conn, 0U, sizeof(client.conn));
+    REQUIRE_EQ(swicc_net_server_client_adopt(&server, 0U, sock_pair[1U]),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_server_slot_attach(&server, 3U, 0U, 3U),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_net_server_slot_send(&server, 3U, &msg),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(swicc_net_client_mux(swicc_state_ptr, 3U, &client),
+             SWICC_RET_ERROR);
+    close(sock_pair[0U]);
+    swicc_net_server_destroy(&server);
+}
+
+TEST(net, swicc_net_server_slot_find)
+{
+    /**
+     * Many cards on 3 connections, slot N is card N % 200 of connection
+     * N / 200.
+     */
+    static swicc_net_server_st server;
+    memset(&server, 0U, sizeof(server));
+    server.sock_server = -1;
+    memset(server.keepalive.bucket, 0xFF, sizeof(server.keepalive.bucket));
+    int sock_pair[3U][2U];
+    for (uint16_t conn_idx = 0U; conn_idx < 3U; ++conn_idx)
+    {
+        REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair[conn_idx]), 0);
+        uint16_t const slot_conn = conn_idx * 200U;
+        REQUIRE_EQ(swicc_net_server_client_adopt(&server, slot_conn,
+                                                 sock_pair[conn_idx][1U]),
+                   SWICC_RET_SUCCESS);
+        for (uint16_t card = 1U; card < 200U; ++card)
+        {
+            REQUIRE_EQ(swicc_net_server_slot_attach(
+                           &server, slot_conn + card, slot_conn, card),
+                       SWICC_RET_SUCCESS);
+        }
+    }
+    CHECK_EQ(swicc_net_server_client_adopt(&server, 600U, sock_pair[0U][1U]),
+             SWICC_RET_PARAM_BAD);
+
+    /* Removing a connection leaves the slots of the others findable. */
+    swicc_net_server_client_disconnect(&server, 250U);
+    CHECK_EQ(server.slot_index_count, 400U);
+    uint16_t slot;
+    for (uint16_t slot_idx = 0U; slot_idx < 600U; ++slot_idx)
+    {
+        uint16_t const conn_idx = slot_idx / 200U;
+        swicc_ret_et const ret = swicc_net_server_slot_find(
+            &server, sock_pair[conn_idx][1U], slot_idx % 200U, &slot);
+        if (conn_idx == 1U)
+        {
+            CHECK_EQ(ret, SWICC_RET_ERROR);
+            continue;
+        }
+        REQUIRE_EQ(ret, SWICC_RET_SUCCESS);
+        CHECK_EQ(slot, slot_idx);
+    }
+    CHECK_EQ(swicc_net_server_slot_find(&server, sock_pair[0U][1U], 200U,
+                                        &slot),
+             SWICC_RET_ERROR);
+
+    for (uint16_t conn_idx = 0U; conn_idx < 3U; ++conn_idx)
+    {
+        close(sock_pair[conn_idx][0U]);
+    }
+    swicc_net_server_destroy(&server);
+}
+
+TEST(net, swicc_net_server_keepalive_poll)
+{
+    /* Slots 0 and 1 are 2 cards on one connection, slot 2 has its own. */
+    static swicc_net_server_st server;
+    memset(&server, 0U, sizeof(server));
+    server.sock_server = -1;
+    memset(server.keepalive.bucket, 0xFF, sizeof(server.keepalive.bucket));
+    int sock_pair[2U][2U];
+    for (uint16_t conn_idx = 0U; conn_idx < 2U; ++conn_idx)
+    {
+        REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair[conn_idx]), 0);
+        REQUIRE_EQ(swicc_net_server_client_adopt(&server, conn_idx * 2U,
+                                                 sock_pair[conn_idx][1U]),
+                   SWICC_RET_SUCCESS);
+    }
+    REQUIRE_EQ(swicc_net_server_slot_attach(&server, 1U, 0U, 1U),
+               SWICC_RET_SUCCESS);
+    uint32_t slot_count;
+    CHECK_EQ(swicc_net_server_keepalive_poll(NULL, 0U, NULL, 0U, &slot_count),
+             SWICC_RET_PARAM_BAD);
+    CHECK_EQ(swicc_net_server_keepalive_poll(&server, 0U, NULL, 1U,
+                                             &slot_count),
+             SWICC_RET_PARAM_BAD);
+
+    /* Idle connections are probed once per connection. */
+    swicc_net_server_keepalive_set(&server, 1000U);
+    CHECK_EQ(keepalive_poll(&server, 0U, 4U), 0U);
+    CHECK_EQ(keepalive_poll(&server, 900U, 4U), 0U);
+    CHECK_EQ(keepalive_poll(&server, 1000U, 4U), 0b101U);
+
+    /* Traffic of any card counts for the whole connection. */
+    uint16_t slot_found;
+    REQUIRE_EQ(swicc_net_server_slot_find(&server, sock_pair[0U][1U], 1U,
+                                          &slot_found),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(slot_found, 1U);
+    CHECK_EQ(keepalive_poll(&server, 2000U, 4U), 0b100U);
+    CHECK_EQ(keepalive_poll(&server, 3000U, 4U), 0b101U);
+
+    /* What does not fit is returned by the next poll. */
+    uint32_t const slot_due = keepalive_poll(&server, 4000U, 1U);
+    CHECK_EQ(slot_due == 0b001U || slot_due == 0b100U, true);
+    CHECK_EQ(keepalive_poll(&server, 4000U, 1U), 0b101U & ~slot_due);
+    CHECK_EQ(keepalive_poll(&server, 4000U, 4U), 0U);
+
+    /* Timers on the upper levels of the wheel cascade down on time. */
+    swicc_net_server_keepalive_set(&server, 3600U * 1000U);
+    CHECK_EQ(keepalive_poll(&server, 10000U, 4U), 0U);
+    CHECK_EQ(keepalive_poll(&server, 10000U + (3599U * 1000U), 4U), 0U);
+    CHECK_EQ(keepalive_poll(&server, 10000U + (3600U * 1000U), 4U), 0b101U);
+
+    swicc_net_server_keepalive_set(&server, 0U);
+    CHECK_EQ(keepalive_poll(&server, 20000000U, 4U), 0U);
+    CHECK_EQ(keepalive_poll(&server, 40000000U, 4U), 0U);
+    CHECK_EQ(server.keepalive.armed_count, 0U);
+    close(sock_pair[0U][0U]);
+    close(sock_pair[1U][0U]);
+    swicc_net_server_destroy(&server);
+}
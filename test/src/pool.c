@@ -0,0 +1,45 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+TEST(pool, swicc_pool__reuse)
+{
+    swicc_pool_st pool;
+    swicc_pool_init(&pool, 1U, 1U);
+    CHECK_EQ(pool.buf_size, sizeof(void *));
+
+    void *const buf_a = swicc_pool_get(&pool);
+    void *const buf_b = swicc_pool_get(&pool);
+    REQUIRE_NE(buf_a, NULL);
+    REQUIRE_NE(buf_b, NULL);
+
+    /* Only one free buffer is kept, the other one gets freed. */
+    swicc_pool_put(&pool, buf_a);
+    swicc_pool_put(&pool, buf_b);
+    CHECK_EQ(pool.free_count, 1U);
+    CHECK_EQ(swicc_pool_get(&pool), buf_a);
+    CHECK_EQ(pool.free_count, 0U);
+    swicc_pool_put(&pool, buf_a);
+    swicc_pool_empty(&pool);
+    CHECK_EQ(pool.free_count, 0U);
+    CHECK_EQ(pool.free, NULL);
+}
+
+TEST(pool, swicc_pool_thread__apdu_rc)
+{
+    swicc_pool_st *const pool = swicc_pool_thread();
+    CHECK_EQ(pool, swicc_pool_thread());
+    CHECK_EQ(pool->buf_size, SWICC_POOL_BUF_SIZE);
+
+    /* A short response buffer is only held until the RC buffer is reset. */
+    swicc_apdu_rc_st rc = {0};
+    uint8_t const buf[4U] = {0x01, 0x02, 0x03, 0x04};
+    REQUIRE_EQ(swicc_apdu_rc_enq(&rc, buf, sizeof(buf)), SWICC_RET_SUCCESS);
+    CHECK_EQ(rc.b_pooled, true);
+    uint32_t const free_count = pool->free_count;
+    swicc_apdu_rc_reset(&rc);
+    CHECK_EQ((void *)rc.b, NULL);
+    CHECK_EQ(rc.size, 0U);
+    CHECK_EQ(pool->free_count, free_count + 1U);
+    swicc_apdu_rc_free(&rc);
+}
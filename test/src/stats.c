@@ -0,0 +1,94 @@
+#include <tau/tau.h>
+
+#include <string.h>
+#include <swicc/swicc.h>
+
+TEST(stats, swicc_stats__apduh)
+{
+    static swicc_st swicc_state;
+    static swicc_stats_st stats;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_stats_reset(&stats);
+    swicc_state.stats = &stats;
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/006-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_va_select_file_id(&swicc_state.fs, 0xE7C7),
+               SWICC_RET_SUCCESS);
+
+    uint8_t const capdu[][7U] = {
+        {0x00, 0xA4, 0x00, 0x0C, 0x02, 0xE9, 0x9D}, /* SELECT, found. */
+        {0x00, 0xA4, 0x00, 0x0C, 0x02, 0x00, 0x01}, /* SELECT, not found. */
+        {0x00, 0xFF, 0x00, 0x00},                   /* Unknown INS. */
+        {0x80, 0x10, 0x00, 0x00},                   /* No handler. */
+    };
+    uint16_t const capdu_len[] = {7U, 7U, 4U, 4U};
+    for (uint32_t capdu_idx = 0U; capdu_idx < 4U; ++capdu_idx)
+    {
+        uint8_t rapdu[SWICC_DATA_MAX + 2U];
+        uint16_t rapdu_len = sizeof(rapdu);
+        REQUIRE_EQ(swicc_apduh_exec(&swicc_state, capdu[capdu_idx],
+                                    capdu_len[capdu_idx], rapdu, &rapdu_len),
+                   SWICC_RET_SUCCESS);
+    }
+
+    CHECK_EQ(stats.cmd_cla[SWICC_APDU_CLA_TYPE_INTERINDUSTRY], 3U);
+    CHECK_EQ(stats.cmd_cla[SWICC_APDU_CLA_TYPE_PROPRIETARY], 1U);
+    CHECK_EQ(stats.cmd_ins[0U][0xA4], 2U);
+    CHECK_EQ(stats.cmd_ins[0U][0xFF], 1U);
+    CHECK_EQ(stats.cmd_ins[1U][0x10], 1U);
+    CHECK_EQ(stats.sw1[SWICC_APDU_SW1_NORM_NONE], 1U);
+    CHECK_EQ(stats.sw1[SWICC_APDU_SW1_CHER_P1P2_INFO], 1U);
+    CHECK_EQ(stats.sw2[SWICC_APDU_SW1_CHER_P1P2_INFO -
+                       SWICC_STATS_SW2_SW1_FIRST][0x82],
+             1U);
+    CHECK_EQ(stats.sw1[SWICC_APDU_SW1_CHER_INS], 2U);
+    uint64_t lat_count = 0U;
+    for (uint32_t bucket = 0U; bucket < SWICC_STATS_LAT_BUCKET_COUNT; ++bucket)
+    {
+        lat_count += stats.lat[bucket];
+    }
+    /* Commands with data get their handler called once more for the data. */
+    CHECK_EQ(lat_count, 6U);
+
+    static char prom[32768U];
+    uint32_t prom_len = sizeof(prom);
+    REQUIRE_EQ(swicc_stats_prom(&stats, prom, &prom_len), SWICC_RET_SUCCESS);
+    CHECK_EQ(prom_len, strlen(prom));
+    CHECK_NE((void *)strstr(prom, "swicc_cmd_total{cla=\"interindustry\","
+                                  "ins=\"A4\"} 2\n"),
+             NULL);
+    CHECK_NE(
+        (void *)strstr(prom, "swicc_sw_total{sw1=\"6A\",sw2=\"82\"} 1\n"),
+        NULL);
+    CHECK_NE((void *)strstr(prom, "swicc_handler_seconds_count 6\n"), NULL);
+    CHECK_NE((void *)strstr(prom, "swicc_sched_delay_seconds_count 0\n"),
+             NULL);
+    prom_len = 64U;
+    CHECK_EQ(swicc_stats_prom(&stats, prom, &prom_len),
+             SWICC_RET_BUFFER_TOO_SHORT);
+
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+}
+
+TEST(stats, swicc_stats_snapshot)
+{
+    static swicc_stats_st stats[2U];
+    static swicc_stats_st snapshot;
+    swicc_stats_st *const stats_ptr[] = {&stats[0U], &stats[1U]};
+    for (uint32_t stats_idx = 0U; stats_idx < 2U; ++stats_idx)
+    {
+        swicc_stats_reset(&stats[stats_idx]);
+        swicc_stats_handler(&stats[stats_idx], 0U, 0xB0,
+                            1000U * (stats_idx + 1U));
+        swicc_stats_add(&stats[stats_idx].net_rx_msg, stats_idx + 1U);
+    }
+    swicc_stats_snapshot(&snapshot, stats_ptr, 2U);
+    CHECK_EQ(snapshot.cmd_ins_time[0U][0xB0], 3000U);
+    CHECK_EQ(snapshot.cmd_ins_time_max[0U][0xB0], 2000U);
+    CHECK_EQ(snapshot.lat[9U], 1U);  /* 1000ns */
+    CHECK_EQ(snapshot.lat[10U], 1U); /* 2000ns */
+    CHECK_EQ(snapshot.lat_sum, 3000U);
+    CHECK_EQ(snapshot.net_rx_msg, 3U);
+}
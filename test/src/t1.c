@@ -0,0 +1,139 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+/* Bytes of the response data sent by the test handler. */
+#define T1_TEST_DATA_LEN 40U
+
+static swicc_apduh_ft t1_test_handler;
+static swicc_ret_et t1_test_handler(swicc_st *const swicc_state,
+                                    swicc_apdu_cmd_st const *const cmd,
+                                    swicc_apdu_res_st *const res,
+                                    uint32_t const procedure_count)
+{
+    uint8_t data[T1_TEST_DATA_LEN];
+    for (uint8_t i = 0U; i < sizeof(data); ++i)
+    {
+        data[i] = i;
+    }
+    swicc_apdu_rc_reset(&swicc_state->apdu_rc);
+    swicc_apdu_rc_enq(&swicc_state->apdu_rc, data, sizeof(data));
+    res->sw1 = SWICC_APDU_SW1_NORM_BYTES_AVAILABLE;
+    res->sw2 = sizeof(data);
+    res->data.len = 0U;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Create a block with NAD 0.
+ * @param[out] blk Receives the block.
+ * @param[in] pcb
+ * @param[in] inf
+ * @param[in] inf_len
+ * @return Length of the block.
+ */
+static uint16_t t1_test_blk(uint8_t *const blk, uint8_t const pcb,
+                            uint8_t const *const inf, uint8_t const inf_len)
+{
+    blk[0U] = 0U;
+    blk[1U] = pcb;
+    blk[2U] = inf_len;
+    if (inf_len > 0U)
+    {
+        memcpy(&blk[3U], inf, inf_len);
+    }
+    blk[3U + inf_len] = swicc_ck(blk, (uint16_t)(3U + inf_len));
+    return (uint16_t)(3U + inf_len + 1U);
+}
+
+TEST(t1, swicc_t1_blk)
+{
+    static swicc_st swicc_state;
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_t1_reset(&swicc_state.internal.t1);
+    REQUIRE_EQ(swicc_apduh_register(&swicc_state,
+                                    SWICC_APDU_CLA_TYPE_PROPRIETARY, 0x10,
+                                    t1_test_handler),
+               SWICC_RET_SUCCESS);
+    uint8_t blk[SWICC_T1_BLK_LEN_MAX];
+    uint16_t blk_len;
+    uint8_t buf_tx[SWICC_T1_BLK_LEN_MAX];
+    uint16_t buf_tx_len;
+
+    /* The response data comes right away, without a GET RESPONSE. */
+    uint8_t const capdu[] = {0x80, 0x10, 0x00, 0x00, T1_TEST_DATA_LEN};
+    blk_len = t1_test_blk(blk, 0x00, capdu, sizeof(capdu));
+    buf_tx_len = sizeof(buf_tx);
+    REQUIRE_EQ(
+        swicc_t1_blk(&swicc_state, blk, blk_len, buf_tx, &buf_tx_len),
+        SWICC_RET_SUCCESS);
+    /* Default IFSD is 32 so the 42 byte R-APDU is chained. */
+    REQUIRE_EQ(buf_tx_len, 3U + 32U + 1U);
+    CHECK_EQ(buf_tx[1U], 0x20); /* N(S)=0 and M=1 */
+    CHECK_EQ(buf_tx[2U], 32U);
+    CHECK_EQ(buf_tx[3U + 31U], 31U);
+    CHECK_EQ(swicc_ck(buf_tx, buf_tx_len), 0U);
+
+    /* A corrupted R-block gets an R-block with an EDC error. */
+    blk_len = t1_test_blk(blk, 0x90, NULL, 0U);
+    blk[blk_len - 1U] ^= 0xFF;
+    buf_tx_len = sizeof(buf_tx);
+    swicc_t1_blk(&swicc_state, blk, blk_len, buf_tx, &buf_tx_len);
+    REQUIRE_EQ(buf_tx_len, 4U);
+    CHECK_EQ(buf_tx[1U], 0x91); /* N(R)=1 */
+
+    /* The interface asks for the next part. */
+    blk_len = t1_test_blk(blk, 0x90, NULL, 0U);
+    buf_tx_len = sizeof(buf_tx);
+    swicc_t1_blk(&swicc_state, blk, blk_len, buf_tx, &buf_tx_len);
+    REQUIRE_EQ(buf_tx_len, 3U + 10U + 1U);
+    CHECK_EQ(buf_tx[1U], 0x40); /* N(S)=1 and M=0 */
+    CHECK_EQ(buf_tx[3U], 32U);
+    CHECK_EQ(buf_tx[3U + 8U], SWICC_APDU_SW1_NORM_NONE);
+    CHECK_EQ(buf_tx[3U + 9U], 0x00);
+
+    /* A bigger IFSD lets the whole R-APDU fit in one block. */
+    uint8_t const ifsd = 64U;
+    blk_len = t1_test_blk(blk, 0xC1, &ifsd, 1U);
+    buf_tx_len = sizeof(buf_tx);
+    swicc_t1_blk(&swicc_state, blk, blk_len, buf_tx, &buf_tx_len);
+    REQUIRE_EQ(buf_tx_len, 5U);
+    CHECK_EQ(buf_tx[1U], 0xE1);
+    CHECK_EQ(buf_tx[3U], ifsd);
+
+    blk_len = t1_test_blk(blk, 0x40, capdu, sizeof(capdu));
+    buf_tx_len = sizeof(buf_tx);
+    swicc_t1_blk(&swicc_state, blk, blk_len, buf_tx, &buf_tx_len);
+    REQUIRE_EQ(buf_tx_len, 3U + T1_TEST_DATA_LEN + 2U + 1U);
+    CHECK_EQ(buf_tx[1U], 0x00); /* N(S)=0 and M=0 */
+
+    /* An I-block with the wrong sequence number is rejected. */
+    blk_len = t1_test_blk(blk, 0x40, capdu, sizeof(capdu));
+    buf_tx_len = sizeof(buf_tx);
+    swicc_t1_blk(&swicc_state, blk, blk_len, buf_tx, &buf_tx_len);
+    REQUIRE_EQ(buf_tx_len, 4U);
+    CHECK_EQ(buf_tx[1U], 0x82);
+}
+
+TEST(t1, swicc_pps__t1)
+{
+    swicc_pps_params_st pps_params = {0U};
+    uint8_t buf_tx[SWICC_PPS_LEN_MAX];
+    uint16_t buf_tx_len = sizeof(buf_tx);
+
+    /* T=1 is offered in the ATR. */
+    uint8_t const pps_t1[] = {0xFF, 0x01, 0xFE};
+    CHECK_EQ(swicc_pps(&pps_params, pps_t1, sizeof(pps_t1), buf_tx,
+                       &buf_tx_len),
+             SWICC_RET_SUCCESS);
+    CHECK_EQ(pps_params.t, 1U);
+
+    /* Other protocols are not. */
+    uint8_t const pps_t2[] = {0xFF, 0x02, 0xFD};
+    buf_tx_len = sizeof(buf_tx);
+    CHECK_EQ(swicc_pps(&pps_params, pps_t2, sizeof(pps_t2), buf_tx,
+                       &buf_tx_len),
+             SWICC_RET_PPS_FAILED);
+    REQUIRE_EQ(buf_tx_len, 3U);
+    CHECK_EQ(buf_tx[1U], 0x00);
+}
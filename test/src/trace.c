@@ -0,0 +1,63 @@
+#include <tau/tau.h>
+
+#include <swicc/swicc.h>
+
+TEST(trace, swicc_trace_pop__empty)
+{
+    static swicc_trace_st trace;
+    swicc_trace_reset(&trace);
+    swicc_trace_evt_st evt;
+    CHECK_EQ(swicc_trace_pop(&trace, &evt), SWICC_RET_TRACE_EMPTY);
+}
+
+TEST(trace, swicc_trace_push__order)
+{
+    static swicc_trace_st trace;
+    swicc_trace_reset(&trace);
+    for (uint8_t evt_idx = 0U; evt_idx < 3U; ++evt_idx)
+    {
+        swicc_trace_evt_st evt = {
+            .type = SWICC_TRACE_EVT_TYPE_APDU_CMD,
+            .apdu_cmd.ins = evt_idx,
+        };
+        swicc_trace_push(&trace, &evt);
+    }
+
+    swicc_trace_evt_st evt;
+    uint64_t time_prev = 0U;
+    for (uint8_t evt_idx = 0U; evt_idx < 3U; ++evt_idx)
+    {
+        REQUIRE_EQ(swicc_trace_pop(&trace, &evt), SWICC_RET_SUCCESS);
+        CHECK_EQ(evt.type, SWICC_TRACE_EVT_TYPE_APDU_CMD);
+        CHECK_EQ(evt.apdu_cmd.ins, evt_idx);
+        CHECK_LE(time_prev, evt.time);
+        time_prev = evt.time;
+    }
+    CHECK_EQ(swicc_trace_pop(&trace, &evt), SWICC_RET_TRACE_EMPTY);
+}
+
+TEST(trace, swicc_trace_push__full)
+{
+    static swicc_trace_st trace;
+    swicc_trace_reset(&trace);
+    for (uint32_t evt_idx = 0U; evt_idx < SWICC_TRACE_EVT_COUNT + 2U;
+         ++evt_idx)
+    {
+        swicc_trace_evt_st evt = {
+            .type = SWICC_TRACE_EVT_TYPE_APDU_RES,
+            /* Safe cast since only the lower byte is kept. */
+            .apdu_res.sw2 = (uint8_t)(evt_idx & 0xFF),
+        };
+        swicc_trace_push(&trace, &evt);
+    }
+    CHECK_EQ(trace.dropped, 2U);
+
+    /* The oldest events are kept, the newest ones get dropped. */
+    swicc_trace_evt_st evt;
+    REQUIRE_EQ(swicc_trace_pop(&trace, &evt), SWICC_RET_SUCCESS);
+    CHECK_EQ(evt.apdu_res.sw2, 0U);
+
+    /* Space was made so the next event fits. */
+    swicc_trace_push(&trace, &evt);
+    CHECK_EQ(trace.dropped, 2U);
+}
@@ -0,0 +1,70 @@
+#include <tau/tau.h>
+
+#include <string.h>
+#include <swicc/swicc.h>
+
+TEST(wire, swicc_wire__fsm)
+{
+    static swicc_st swicc_state;
+    static swicc_wire_st wire;
+    uint8_t buf_rx[SWICC_DATA_MAX];
+    uint8_t buf_tx[SWICC_DATA_MAX];
+    memset(&swicc_state, 0U, sizeof(swicc_state));
+    swicc_state.buf_rx = buf_rx;
+    swicc_state.buf_tx = buf_tx;
+    swicc_wire_init(&wire, 0U);
+    swicc_state.wire = &wire;
+    REQUIRE_EQ(swicc_diskjs_disk_create(&swicc_state.fs.disk,
+                                        "test/data/disk/007-in.json"),
+               SWICC_RET_SUCCESS);
+    REQUIRE_EQ(swicc_mock_reset_cold(&swicc_state, true), SWICC_RET_SUCCESS);
+    CHECK_EQ(wire.cmd_count, 0U);
+    CHECK_EQ(wire.cmd_time, 0U);
+    uint64_t const char_count_reset = wire.char_count;
+    uint64_t const time_reset = wire.time;
+
+    /* SELECT: header, ACK, data, then the status. */
+    uint8_t const capdu[] = {0x00, 0xA4, 0x00, 0x0C, 0x02, 0x3F, 0x00};
+    uint8_t rapdu[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_len = sizeof(rapdu);
+    REQUIRE_EQ(swicc_mock_apdu(&swicc_state, capdu, sizeof(capdu), rapdu,
+                               &rapdu_len),
+               SWICC_RET_SUCCESS);
+    CHECK_EQ(wire.cmd_count, 1U);
+    CHECK_EQ(wire.cmd_last_char, 10U);
+    CHECK_EQ(wire.char_count - char_count_reset, 10U);
+
+    /**
+     * The PPS of the mock negotiated Fi=512 and Di=8. That is 12 ETUs per
+     * character and 4 more on each of the 4 changes of direction.
+     */
+    uint64_t const cmd_time =
+        (10U * 12U + 4U * 4U) * 512U * 1000000000ULL / (8U * 3571200U);
+    CHECK_EQ(wire.cmd_last_time, cmd_time);
+    CHECK_EQ(wire.time - time_reset, cmd_time);
+
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+}
+
+TEST(wire, swicc_wire_xfer)
+{
+    swicc_wire_st wire;
+    swicc_wire_init(&wire, 5000000U);
+    /* Nothing negotiated: 372 clock cycles per ETU. */
+    swicc_tp_st const tp_default = {0};
+    swicc_wire_xfer(&wire, &tp_default, 5U, 0U, true);
+    CHECK_EQ(wire.cmd_time, (5U * 12U) * 372U * 1000000000ULL / 5000000U);
+
+    /* Clock is capped to f(max) and T=1 characters are shorter. */
+    swicc_wire_init(&wire, 50000000U);
+    swicc_tp_st const tp_t1 = {.fi = 512U, .di = 8U, .fmax = 5000U, .t = 1U};
+    swicc_wire_xfer(&wire, &tp_t1, 4U, 0U, true);
+    wire.cmd_done = true;
+    swicc_wire_xfer(&wire, &tp_t1, 0U, 4U, true);
+    CHECK_EQ(wire.cmd_count, 1U);
+    CHECK_EQ(wire.cmd_last_char, 8U);
+    CHECK_EQ(wire.cmd_last_time,
+             (8U * 11U + 11U) * 64U * 1000000000ULL / 5000000U);
+    CHECK_EQ(wire.cmd_time, 0U);
+}
@@ -0,0 +1,72 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEBUG_CLR
+#include <swicc/swicc.h>
+
+static void print_usage(char const *const arg0)
+{
+    // clang-format off
+    fprintf(stderr, "Usage: %s <"CLR_VAL("/path/to/disk")"> <"CLR_VAL("/path/to/output.c")"> <"CLR_VAL("name")">"
+        "\n"
+        "\nGenerates a C source file which defines the disk as constant data"
+        "\nnamed 'name' (of type 'swicc_disk_st const'). Once linked into a"
+        "\nbinary, the disk is mounted without loading anything by creating an"
+        "\noverlay disk on top of it. The disk is either a JSON definition"
+        "\n(when the path ends with '.json') or a disk file."
+        "\n",
+        arg0);
+    // clang-format on
+}
+
+/**
+ * @brief Load a disk from a JSON definition or a disk file.
+ * @param disk
+ * @param disk_path
+ * @return Return code.
+ */
+static swicc_ret_et disk_load(swicc_disk_st *const disk,
+                              char const *const disk_path)
+{
+    size_t const disk_path_len = strlen(disk_path);
+    if (disk_path_len >= 5U &&
+        strcmp(&disk_path[disk_path_len - 5U], ".json") == 0)
+    {
+        return swicc_diskjs_disk_create(disk, disk_path);
+    }
+    return swicc_disk_load(disk, disk_path);
+}
+
+int main(int const argc, char *const argv[])
+{
+    static swicc_disk_st disk;
+    if (argc != 4)
+    {
+        print_usage(argv[0U]);
+        return -1;
+    }
+    char const *const str_disk_path = argv[1U];
+    char const *const str_c_path = argv[2U];
+    char const *const str_name = argv[3U];
+
+    if (disk_load(&disk, str_disk_path) != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to load disk '%s'.\n", str_disk_path);
+        return -1;
+    }
+    swicc_ret_et const ret = swicc_diskc_gen(&disk, str_c_path, str_name);
+    swicc_disk_unload(&disk);
+    if (ret == SWICC_RET_PARAM_BAD)
+    {
+        fprintf(stderr, CLR_TXT(CLR_RED, "Invalid name '%s'.\n"), str_name);
+        print_usage(argv[0U]);
+        return -1;
+    }
+    if (ret != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to generate '%s'.\n", str_c_path);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,420 @@
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEBUG_CLR
+#include <swicc/swicc.h>
+
+#define PROFILE_EXT_IN ".json"
+#define PROFILE_EXT_OUT ".swiccfs"
+
+/* Maximum number of worker threads. */
+#define WORKER_COUNT_MAX 1024U
+
+typedef struct profile_s
+{
+    char *path_in;
+    char *path_out;
+
+    /* Filled in by the worker that compiled the profile. */
+    swicc_ret_et ret;
+    double time_ms;
+    int64_t size;
+} profile_st;
+
+typedef struct batch_s
+{
+    profile_st *profile;
+    uint32_t profile_count;
+    uint32_t profile_size;
+    _Atomic uint32_t profile_next;
+
+    char const *cache_path;
+    bool index;
+    bool lz4;
+} batch_st;
+
+static void print_usage(char const *const arg0)
+{
+    // clang-format off
+    fprintf(stderr, "Usage: %s [-j "CLR_VAL("workers")"] [-i] [-z] [-c "CLR_VAL("/path/to/cache")"] <"CLR_VAL("/path/to/profiles")"> <"CLR_VAL("/path/to/output")">"
+        "\n"
+        "\nCompiles JSON profiles to swICC FS disks. The profiles are either"
+        "\nall '" PROFILE_EXT_IN "' files of a directory or the paths listed in a"
+        "\nmanifest file, one per line. Every profile is saved in the output"
+        "\ndirectory with the same name but the '" PROFILE_EXT_OUT "' extension."
+        "\n"
+        "\n  -j  Number of profiles compiled at once, one per online core by"
+        "\n      default."
+        "\n  -i  Save the disks with the persisted index."
+        "\n  -z  Save the disks with the persisted index and compressed trees."
+        "\n  -c  Reuse trees compiled before from this cache directory."
+        "\n"
+        "\nFor each profile a line with its path, compile time in"
+        "\nmilliseconds, disk size in bytes and result ('ok' or 'error' with"
+        "\nthe return code) gets printed."
+        "\n",
+        arg0);
+    // clang-format on
+}
+
+/**
+ * @brief Add a profile to the batch.
+ * @param[in, out] batch
+ * @param[in] path_in Path of the profile JSON.
+ * @param[in] path_in_len Length of the path.
+ * @param[in] dir_out Directory where the disk is saved.
+ * @return Return code.
+ */
+static swicc_ret_et batch_add(batch_st *const batch, char const *const path_in,
+                              size_t const path_in_len,
+                              char const *const dir_out)
+{
+    if (batch->profile_count >= batch->profile_size)
+    {
+        uint32_t const profile_size_new =
+            batch->profile_size == 0U ? 64U : batch->profile_size * 2U;
+        profile_st *const profile_new =
+            realloc(batch->profile, profile_size_new * sizeof(profile_st));
+        if (profile_new == NULL)
+        {
+            return SWICC_RET_ERROR;
+        }
+        batch->profile = profile_new;
+        batch->profile_size = profile_size_new;
+    }
+
+    /* The output file is named like the input without the directories. */
+    char const *name = path_in;
+    size_t name_len = path_in_len;
+    for (size_t char_idx = 0U; char_idx < path_in_len; ++char_idx)
+    {
+        if (path_in[char_idx] == '/')
+        {
+            name = &path_in[char_idx + 1U];
+            name_len = path_in_len - char_idx - 1U;
+        }
+    }
+    size_t const ext_in_len = strlen(PROFILE_EXT_IN);
+    if (name_len > ext_in_len &&
+        memcmp(&name[name_len - ext_in_len], PROFILE_EXT_IN, ext_in_len) == 0)
+    {
+        name_len -= ext_in_len;
+    }
+
+    profile_st *const profile = &batch->profile[batch->profile_count];
+    memset(profile, 0U, sizeof(*profile));
+    profile->path_in = malloc(path_in_len + 1U);
+    size_t const path_out_len =
+        strlen(dir_out) + 1U + name_len + sizeof(PROFILE_EXT_OUT);
+    profile->path_out = malloc(path_out_len);
+    if (profile->path_in == NULL || profile->path_out == NULL)
+    {
+        free(profile->path_in);
+        free(profile->path_out);
+        return SWICC_RET_ERROR;
+    }
+    memcpy(profile->path_in, path_in, path_in_len);
+    profile->path_in[path_in_len] = '\0';
+    /* Safe cast since a file name can't be longer than an int. */
+    snprintf(profile->path_out, path_out_len, "%s/%.*s%s", dir_out,
+             (int)name_len, name, PROFILE_EXT_OUT);
+    profile->ret = SWICC_RET_ERROR;
+    profile->size = -1;
+    batch->profile_count += 1U;
+    return SWICC_RET_SUCCESS;
+}
+
+static int profile_cmp(void const *const a, void const *const b)
+{
+    return strcmp(((profile_st const *)a)->path_in,
+                  ((profile_st const *)b)->path_in);
+}
+
+/**
+ * @brief Add all JSON files of a directory to the batch, sorted by name so the
+ * report is the same on every run.
+ * @param[in, out] batch
+ * @param[in] dir_in
+ * @param[in] dir_out
+ * @return Return code.
+ */
+static swicc_ret_et batch_add_dir(batch_st *const batch,
+                                  char const *const dir_in,
+                                  char const *const dir_out)
+{
+    DIR *const dir = opendir(dir_in);
+    if (dir == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    size_t const ext_in_len = strlen(PROFILE_EXT_IN);
+    size_t const dir_in_len = strlen(dir_in);
+    struct dirent *entry;
+    while (ret == SWICC_RET_SUCCESS && (entry = readdir(dir)) != NULL)
+    {
+        size_t const name_len = strlen(entry->d_name);
+        if (name_len <= ext_in_len ||
+            memcmp(&entry->d_name[name_len - ext_in_len], PROFILE_EXT_IN,
+                   ext_in_len) != 0)
+        {
+            continue;
+        }
+        size_t const path_len = dir_in_len + 1U + name_len;
+        char *const path = malloc(path_len + 1U);
+        if (path == NULL)
+        {
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        snprintf(path, path_len + 1U, "%s/%s", dir_in, entry->d_name);
+        ret = batch_add(batch, path, path_len, dir_out);
+        free(path);
+    }
+    closedir(dir);
+    if (ret == SWICC_RET_SUCCESS && batch->profile_count > 0U)
+    {
+        qsort(batch->profile, batch->profile_count, sizeof(profile_st),
+              profile_cmp);
+    }
+    return ret;
+}
+
+/**
+ * @brief Add all profiles listed in a manifest to the batch. Empty lines and
+ * lines starting with '#' are skipped.
+ * @param[in, out] batch
+ * @param[in] manifest_path
+ * @param[in] dir_out
+ * @return Return code.
+ */
+static swicc_ret_et batch_add_manifest(batch_st *const batch,
+                                       char const *const manifest_path,
+                                       char const *const dir_out)
+{
+    FILE *const manifest = fopen(manifest_path, "r");
+    if (manifest == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    char *line = NULL;
+    size_t line_size = 0U;
+    ssize_t line_len;
+    while (ret == SWICC_RET_SUCCESS &&
+           (line_len = getline(&line, &line_size, manifest)) >= 0)
+    {
+        /* Safe cast since the length was checked to not be negative. */
+        size_t path_len = (size_t)line_len;
+        while (path_len > 0U &&
+               (line[path_len - 1U] == '\n' || line[path_len - 1U] == '\r'))
+        {
+            --path_len;
+        }
+        if (path_len == 0U || line[0U] == '#')
+        {
+            continue;
+        }
+        ret = batch_add(batch, line, path_len, dir_out);
+    }
+    free(line);
+    fclose(manifest);
+    return ret;
+}
+
+/**
+ * @brief Entry point of a worker. Compiles profiles until none are left. Each
+ * profile is compiled on one thread since there are many more profiles than
+ * cores.
+ * @param arg The batch.
+ * @return Always NULL, results are stored with the profiles.
+ */
+static void *batch_worker(void *const arg)
+{
+    batch_st *const batch = arg;
+    for (;;)
+    {
+        uint32_t const profile_idx = atomic_fetch_add_explicit(
+            &batch->profile_next, 1U, memory_order_relaxed);
+        if (profile_idx >= batch->profile_count)
+        {
+            break;
+        }
+        profile_st *const profile = &batch->profile[profile_idx];
+
+        struct timespec time_start;
+        struct timespec time_end;
+        clock_gettime(CLOCK_MONOTONIC, &time_start);
+        swicc_disk_st disk = {0U};
+        profile->ret =
+            batch->cache_path == NULL
+                ? swicc_diskjs_disk_create_mt(&disk, profile->path_in, 1U)
+                : swicc_diskjs_disk_create_cached(&disk, profile->path_in, 1U,
+                                                  batch->cache_path);
+        if (profile->ret == SWICC_RET_SUCCESS)
+        {
+            if (batch->lz4)
+            {
+                profile->ret = swicc_disk_save_lz4(&disk, profile->path_out);
+            }
+            else
+            {
+                profile->ret =
+                    batch->index
+                        ? swicc_disk_save_index(&disk, profile->path_out)
+                        : swicc_disk_save(&disk, profile->path_out);
+            }
+            swicc_disk_unload(&disk);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &time_end);
+        profile->time_ms =
+            (double)(time_end.tv_sec - time_start.tv_sec) * 1e3 +
+            (double)(time_end.tv_nsec - time_start.tv_nsec) / 1e6;
+
+        struct stat disk_stat;
+        if (profile->ret == SWICC_RET_SUCCESS &&
+            stat(profile->path_out, &disk_stat) == 0)
+        {
+            profile->size = disk_stat.st_size;
+        }
+    }
+    return NULL;
+}
+
+int main(int const argc, char *const argv[])
+{
+    batch_st batch = {0U};
+    atomic_init(&batch.profile_next, 0U);
+    uint32_t worker_count = 0U;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:izc:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j': {
+            long const worker_count_arg = strtol(optarg, NULL, 10);
+            if (worker_count_arg <= 0 || worker_count_arg > WORKER_COUNT_MAX)
+            {
+                fprintf(stderr,
+                        CLR_TXT(CLR_RED, "Worker count must be in 1..%u.\n"),
+                        WORKER_COUNT_MAX);
+                return -1;
+            }
+            /* Safe cast due to the range check. */
+            worker_count = (uint32_t)worker_count_arg;
+            break;
+        }
+        case 'i':
+            batch.index = true;
+            break;
+        case 'z':
+            batch.lz4 = true;
+            break;
+        case 'c':
+            batch.cache_path = optarg;
+            break;
+        default:
+            print_usage(argv[0U]);
+            return -1;
+        }
+    }
+    if (argc - optind != 2)
+    {
+        print_usage(argv[0U]);
+        return -1;
+    }
+    char const *const str_profiles_path = argv[optind];
+    char const *const str_out_path = argv[optind + 1];
+
+    struct stat profiles_stat;
+    if (stat(str_profiles_path, &profiles_stat) != 0)
+    {
+        fprintf(stderr, CLR_TXT(CLR_RED, "Profiles '%s' not found.\n"),
+                str_profiles_path);
+        return -1;
+    }
+    swicc_ret_et const ret_add =
+        S_ISDIR(profiles_stat.st_mode)
+            ? batch_add_dir(&batch, str_profiles_path, str_out_path)
+            : batch_add_manifest(&batch, str_profiles_path, str_out_path);
+    if (ret_add != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to list the profiles of '%s'.\n",
+                str_profiles_path);
+        return -1;
+    }
+
+    if (worker_count == 0U)
+    {
+        long const core_count = sysconf(_SC_NPROCESSORS_ONLN);
+        /* Safe cast since the core count is checked to be in range. */
+        worker_count = core_count > 0 && core_count <= WORKER_COUNT_MAX
+                           ? (uint32_t)core_count
+                           : 1U;
+    }
+    if (worker_count > batch.profile_count)
+    {
+        worker_count = batch.profile_count;
+    }
+    fprintf(stderr, "Compiling %u profiles on %u workers...\n",
+            batch.profile_count, worker_count);
+
+    struct timespec time_start;
+    struct timespec time_end;
+    clock_gettime(CLOCK_MONOTONIC, &time_start);
+    static pthread_t worker[WORKER_COUNT_MAX];
+    uint32_t worker_started = 0U;
+    for (; worker_started < worker_count; ++worker_started)
+    {
+        if (pthread_create(&worker[worker_started], NULL, batch_worker,
+                           &batch) != 0)
+        {
+            fprintf(stderr, "Failed to start worker %u.\n", worker_started);
+            break;
+        }
+    }
+    if (worker_started == 0U)
+    {
+        /* Still get the work done without any workers. */
+        batch_worker(&batch);
+    }
+    for (uint32_t worker_idx = 0U; worker_idx < worker_started; ++worker_idx)
+    {
+        pthread_join(worker[worker_idx], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &time_end);
+
+    uint32_t failed_count = 0U;
+    for (uint32_t profile_idx = 0U; profile_idx < batch.profile_count;
+         ++profile_idx)
+    {
+        profile_st *const profile = &batch.profile[profile_idx];
+        if (profile->ret == SWICC_RET_SUCCESS)
+        {
+            fprintf(stdout, "%s\t%.3f\t%lld\tok\n", profile->path_in,
+                    profile->time_ms, (long long)profile->size);
+        }
+        else
+        {
+            fprintf(stdout, "%s\t%.3f\t%lld\terror %u\n", profile->path_in,
+                    profile->time_ms, (long long)profile->size, profile->ret);
+            failed_count += 1U;
+        }
+        free(profile->path_in);
+        free(profile->path_out);
+    }
+    free(batch.profile);
+    fprintf(stderr, "Compiled %u profiles (%u failed) in %.3f ms.\n",
+            batch.profile_count, failed_count,
+            (double)(time_end.tv_sec - time_start.tv_sec) * 1e3 +
+                (double)(time_end.tv_nsec - time_start.tv_nsec) / 1e6);
+    return failed_count == 0U ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/**
+ * Persistent-mode fuzz target (libFuzzer, or AFL++ through its libFuzzer
+ * support) for the APDU handlers. The disk given in 'SWICC_FUZZ_DISK' (a JSON
+ * definition when the path ends with '.json', otherwise a disk file) is loaded
+ * once. Every input is a sequence of C-APDUs, each preceded by its length as a
+ * 2 byte big-endian integer, which are executed in-process one after another.
+ * After every input, the card and the disk are put back into the state they
+ * were in after loading by restoring a checkpoint, which only writes back the
+ * pages of the disk that were modified.
+ *
+ *     SWICC_FUZZ_DISK=profile.json ./build/fuzz corpus/
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <swicc/swicc.h>
+
+/* Most times a pending handler is resumed before the command is abandoned. */
+#define FUZZ_RESUME_COUNT_MAX 4U
+
+static swicc_st fuzz_state;
+static swicc_checkpoint_st checkpoint;
+static uint8_t buf_rx[SWICC_DATA_MAX];
+static uint8_t buf_tx[SWICC_DATA_MAX];
+
+int LLVMFuzzerInitialize(int *const argc, char ***const argv);
+int LLVMFuzzerTestOneInput(uint8_t const *const data, size_t const size);
+
+/**
+ * @brief Register additional handlers (e.g. proprietary ones) before the
+ * checkpoint is captured. Defined by linking in another object, by default
+ * only the interindustry handlers are fuzzed.
+ * @param[in, out] swicc_state
+ * @return Return code.
+ */
+__attribute__((weak)) swicc_ret_et
+fuzz_handler_register(swicc_st *const swicc_state);
+__attribute__((weak)) swicc_ret_et
+fuzz_handler_register(swicc_st *const swicc_state)
+{
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Load a disk from a JSON definition or a disk file.
+ * @param disk
+ * @param disk_path
+ * @return Return code.
+ */
+static swicc_ret_et disk_load(swicc_disk_st *const disk,
+                              char const *const disk_path)
+{
+    size_t const disk_path_len = strlen(disk_path);
+    if (disk_path_len >= 5U &&
+        strcmp(&disk_path[disk_path_len - 5U], ".json") == 0)
+    {
+        return swicc_diskjs_disk_create(disk, disk_path);
+    }
+    return swicc_disk_load(disk, disk_path);
+}
+
+int LLVMFuzzerInitialize(int *const argc, char ***const argv)
+{
+    char const *const disk_path = getenv("SWICC_FUZZ_DISK");
+    if (disk_path == NULL)
+    {
+        fprintf(stderr, "Set SWICC_FUZZ_DISK to the disk to fuzz with.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fuzz_state.buf_rx = buf_rx;
+    fuzz_state.buf_tx = buf_tx;
+    if (disk_load(&fuzz_state.fs.disk, disk_path) != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to load disk '%s'.\n", disk_path);
+        exit(EXIT_FAILURE);
+    }
+    if (fuzz_handler_register(&fuzz_state) != SWICC_RET_SUCCESS ||
+        swicc_checkpoint_capture(&checkpoint, &fuzz_state) !=
+            SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to get the card ready for fuzzing.\n");
+        exit(EXIT_FAILURE);
+    }
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(uint8_t const *const data, size_t const size)
+{
+    size_t offset = 0U;
+    while (size - offset >= sizeof(uint16_t))
+    {
+        /* Safe cast since just concatenating 2 bytes into short. */
+        uint16_t capdu_len =
+            (uint16_t)((data[offset] << 8U) | data[offset + 1U]);
+        offset += sizeof(uint16_t);
+        if (capdu_len > size - offset)
+        {
+            /* Safe cast since the remainder is shorter than the length. */
+            capdu_len = (uint16_t)(size - offset);
+        }
+
+        uint8_t rapdu[SWICC_DATA_MAX + 2U];
+        uint16_t rapdu_len = sizeof(rapdu);
+        swicc_ret_et ret = swicc_apduh_exec(&fuzz_state, &data[offset],
+                                            capdu_len, rapdu, &rapdu_len);
+        /* There is no external operation so it completes right away. */
+        for (uint32_t resume_count = 0U;
+             ret == SWICC_RET_APDU_PENDING &&
+             resume_count < FUZZ_RESUME_COUNT_MAX;
+             ++resume_count)
+        {
+            swicc_apduh_pending_complete(&fuzz_state);
+            rapdu_len = sizeof(rapdu);
+            ret = swicc_apduh_exec_resume(&fuzz_state, rapdu, &rapdu_len);
+        }
+        offset += capdu_len;
+        if (ret == SWICC_RET_APDU_PENDING)
+        {
+            /* The rest of the input can't be executed on a busy card. */
+            break;
+        }
+    }
+
+    if (swicc_checkpoint_restore(&checkpoint, &fuzz_state) !=
+        SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to restore the card after an input.\n");
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,876 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEBUG_CLR
+#include <swicc/swicc.h>
+
+/* Maximum number of cards that can be driven at once. */
+#define CARD_COUNT_MAX 4096U
+
+/* Maximum number of commands in a script. */
+#define CMD_COUNT_MAX 4096U
+
+/**
+ * Latencies are kept in log-linear histograms: every power of 2 is split into
+ * 2^HIST_SUB_BITS buckets so a recorded value is off by at most 1/16.
+ */
+#define HIST_SUB_BITS 4U
+#define HIST_SUB_COUNT (1U << HIST_SUB_BITS)
+#define HIST_BUCKET_COUNT ((64U - HIST_SUB_BITS + 1U) * HIST_SUB_COUNT)
+
+/* How long to wait for responses when there is nothing to send (in ms). */
+#define POLL_TIMEOUT 100
+
+typedef struct hist_s
+{
+    uint64_t count;
+    uint64_t max;
+    uint64_t bucket[HIST_BUCKET_COUNT];
+} hist_st;
+
+typedef struct cmd_s
+{
+    uint8_t capdu[5U + SWICC_DATA_MAX];
+    uint16_t capdu_len;
+
+    /* The R-APDU has to end with these bytes, none to accept any R-APDU. */
+    uint8_t rapdu_exp[SWICC_DATA_MAX + 2U];
+    uint16_t rapdu_exp_len;
+
+    uint64_t error_count;
+    uint64_t mismatch_count;
+    hist_st hist; /* Latency in nanoseconds. */
+} cmd_st;
+
+typedef struct card_s
+{
+    bool busy;           /* If a command is in flight. */
+    uint32_t cmd_idx;    /* Command in flight or the next one to send. */
+    uint64_t time_sched; /* When the command in flight was due (in ns). */
+} card_st;
+
+typedef struct run_s
+{
+    swicc_net_server_st server;
+
+    cmd_st *cmd;
+    uint32_t cmd_count;
+
+    /* The card with index N uses slot N of the server. */
+    card_st *card;
+    uint32_t card_count;
+    uint32_t card_per_conn;
+    uint32_t card_next; /* Where to start looking for an idle card. */
+
+    uint64_t rate;      /* Commands per second, 0 to send in a closed loop. */
+    uint64_t duration;  /* In ns, 0 for no limit. */
+    uint64_t issue_max; /* 0 for no limit. */
+
+    uint64_t issued;
+    uint64_t in_flight;
+    uint64_t error_count; /* Errors which can't be tied to a command. */
+} run_st;
+
+static volatile sig_atomic_t run_stop = 0;
+
+static void sig_exit_handler(__attribute__((unused)) int signum)
+{
+    run_stop = 1;
+}
+
+static void print_usage(char const *const arg0)
+{
+    // clang-format off
+    fprintf(stderr, "Usage: %s [-c "CLR_VAL("cards")"] [-m "CLR_VAL("cards-per-connection")"] [-r "CLR_VAL("rate")"] [-d "CLR_VAL("seconds")"] [-n "CLR_VAL("commands")"] <"CLR_VAL("port")"> <"CLR_VAL("/path/to/script")">"
+        "\n"
+        "\nWaits for the cards to connect and then replays a script of"
+        "\nC-APDUs to all of them at once. The script has one C-APDU in hex per"
+        "\nline (just like the data of server-dummy), optionally followed by"
+        "\n'=' and the bytes the R-APDU has to end with (e.g. '9000'). Empty"
+        "\nlines and lines starting with '#' are skipped. Every card goes"
+        "\nthrough the script in a loop, starting with a cold reset."
+        "\n"
+        "\n  -c  Number of cards, 1 by default."
+        "\n  -m  Number of cards on each (multiplexing) connection, 1 by"
+        "\n      default."
+        "\n  -r  Commands per second over all cards. Commands are sent when"
+        "\n      due no matter if earlier ones were answered (open loop) so"
+        "\n      latency includes waiting for a card to become idle. When 0"
+        "\n      (default), each card gets its next command as soon as it"
+        "\n      answers (closed loop)."
+        "\n  -d  Stop sending after this many seconds, 10 by default, 0 for"
+        "\n      no limit."
+        "\n  -n  Stop sending after this many commands, 0 (default) for no"
+        "\n      limit."
+        "\n"
+        "\nAt the end, latency percentiles (in microseconds) are printed for"
+        "\nevery command of the script and for all commands together."
+        "\nProtocol errors (failed requests, malformed or unexpected"
+        "\nresponses) and mismatching R-APDUs are counted and make the exit"
+        "\ncode non-zero."
+        "\n",
+        arg0);
+    // clang-format on
+}
+
+/**
+ * @brief Get the time of the monotonic clock.
+ * @return Time in nanoseconds.
+ */
+static uint64_t time_now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    /* Safe cast since the monotonic clock is never negative. */
+    return (uint64_t)time.tv_sec * 1000000000U + (uint64_t)time.tv_nsec;
+}
+
+/**
+ * @brief Get the bucket of a histogram a value belongs in.
+ * @param val
+ * @return Index of the bucket.
+ */
+static uint32_t hist_idx(uint64_t const val)
+{
+    if (val < HIST_SUB_COUNT)
+    {
+        /* Safe cast since the value is less than the sub-bucket count. */
+        return (uint32_t)val;
+    }
+    /* Safe cast since the value is non-zero so this is in 0..63. */
+    uint32_t const exp = 63U - (uint32_t)__builtin_clzll(val);
+    /* Safe cast since the sub-bucket is masked to 4 bits. */
+    uint32_t const sub =
+        (uint32_t)(val >> (exp - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1U);
+    return (exp - HIST_SUB_BITS + 1U) * HIST_SUB_COUNT + sub;
+}
+
+/**
+ * @brief Get the largest value a bucket of a histogram holds.
+ * @param idx Index of the bucket.
+ * @return Value.
+ */
+static uint64_t hist_val(uint32_t const idx)
+{
+    if (idx < HIST_SUB_COUNT)
+    {
+        return idx;
+    }
+    uint32_t const exp = idx / HIST_SUB_COUNT + HIST_SUB_BITS - 1U;
+    uint64_t const width = 1ULL << (exp - HIST_SUB_BITS);
+    return (1ULL << exp) + (idx % HIST_SUB_COUNT) * width + (width - 1U);
+}
+
+static void hist_add(hist_st *const hist, uint64_t const val)
+{
+    hist->bucket[hist_idx(val)] += 1U;
+    hist->count += 1U;
+    if (val > hist->max)
+    {
+        hist->max = val;
+    }
+}
+
+static void hist_merge(hist_st *const hist, hist_st const *const hist_src)
+{
+    for (uint32_t bucket_idx = 0U; bucket_idx < HIST_BUCKET_COUNT;
+         ++bucket_idx)
+    {
+        hist->bucket[bucket_idx] += hist_src->bucket[bucket_idx];
+    }
+    hist->count += hist_src->count;
+    if (hist_src->max > hist->max)
+    {
+        hist->max = hist_src->max;
+    }
+}
+
+/**
+ * @brief Get a percentile of the values recorded in a histogram.
+ * @param hist
+ * @param pct Which percentile, in 0..1 e.g. 0.99 for p99.
+ * @return The value, 0 when the histogram is empty.
+ */
+static uint64_t hist_pct(hist_st const *const hist, double const pct)
+{
+    if (hist->count == 0U)
+    {
+        return 0U;
+    }
+    /* Rank of the value, rounded up. Safe cast since it's <= the count. */
+    double const rank_exact = (double)hist->count * pct;
+    uint64_t rank = (uint64_t)rank_exact;
+    if ((double)rank < rank_exact || rank == 0U)
+    {
+        rank += 1U;
+    }
+    uint64_t count = 0U;
+    for (uint32_t bucket_idx = 0U; bucket_idx < HIST_BUCKET_COUNT;
+         ++bucket_idx)
+    {
+        count += hist->bucket[bucket_idx];
+        if (count >= rank)
+        {
+            uint64_t const val = hist_val(bucket_idx);
+            return val < hist->max ? val : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+/**
+ * @brief Decode a hex string where spaces are skipped and lower case nibbles
+ * are accepted.
+ * @param str
+ * @param str_len
+ * @param buf Where the bytes are written.
+ * @param[in, out] buf_len Size of the buffer on input, number of bytes written
+ * on output.
+ * @return Return code.
+ */
+static swicc_ret_et script_hex_prs(char const *const str,
+                                   uint32_t const str_len, uint8_t *const buf,
+                                   uint16_t *const buf_len)
+{
+    char hexstr[2U * (SWICC_DATA_MAX + 5U)];
+    uint32_t hexstr_len = 0U;
+    for (uint32_t char_idx = 0U; char_idx < str_len; ++char_idx)
+    {
+        char const nibble_char = str[char_idx];
+        if (nibble_char == ' ' || nibble_char == '\t' || nibble_char == '\r')
+        {
+            continue;
+        }
+        if (hexstr_len >= sizeof(hexstr))
+        {
+            return SWICC_RET_BUFFER_TOO_SHORT;
+        }
+        if (nibble_char >= 'a' && nibble_char <= 'f')
+        {
+            hexstr[hexstr_len++] = (char)(nibble_char - ('a' - 'A'));
+        }
+        else if ((nibble_char >= '0' && nibble_char <= '9') ||
+                 (nibble_char >= 'A' && nibble_char <= 'F'))
+        {
+            hexstr[hexstr_len++] = nibble_char;
+        }
+        else
+        {
+            return SWICC_RET_PARAM_BAD;
+        }
+    }
+    if (hexstr_len % 2U != 0U)
+    {
+        return SWICC_RET_PARAM_BAD;
+    }
+    uint32_t len = *buf_len;
+    swicc_ret_et const ret =
+        swicc_hexstr_bytearr(hexstr, hexstr_len, buf, &len);
+    /* Safe cast since the length is at most the size of the buffer. */
+    *buf_len = (uint16_t)len;
+    return ret;
+}
+
+/**
+ * @brief Load the commands of a script.
+ * @param[in, out] run The commands are added to this run.
+ * @param[in] path
+ * @return Return code.
+ */
+static swicc_ret_et script_load(run_st *const run, char const *const path)
+{
+    FILE *const file = fopen(path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, CLR_TXT(CLR_RED, "Failed to open script '%s'.\n"),
+                path);
+        return SWICC_RET_ERROR;
+    }
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    char line[4U * (SWICC_DATA_MAX + 5U)];
+    uint32_t line_nr = 0U;
+    while (ret == SWICC_RET_SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        line_nr += 1U;
+        /* Safe cast since the line fits in the buffer. */
+        uint32_t line_len = (uint32_t)strnlen(line, sizeof(line));
+        if (line_len > 0U && line[line_len - 1U] == '\n')
+        {
+            line_len -= 1U;
+        }
+        uint32_t char_first = 0U;
+        while (char_first < line_len &&
+               (line[char_first] == ' ' || line[char_first] == '\t' ||
+                line[char_first] == '\r'))
+        {
+            char_first += 1U;
+        }
+        if (char_first == line_len || line[char_first] == '#')
+        {
+            continue;
+        }
+        if (run->cmd_count >= CMD_COUNT_MAX)
+        {
+            fprintf(stderr, "Script has more than %u commands.\n",
+                    CMD_COUNT_MAX);
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+
+        cmd_st *const cmd_new =
+            realloc(run->cmd, (run->cmd_count + 1U) * sizeof(cmd_st));
+        if (cmd_new == NULL)
+        {
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        run->cmd = cmd_new;
+        cmd_st *const cmd = &run->cmd[run->cmd_count];
+        memset(cmd, 0U, sizeof(*cmd));
+
+        char const *const sep = memchr(line, '=', line_len);
+        /* Safe cast since the separator is inside the line. */
+        uint32_t const capdu_str_len =
+            sep == NULL ? line_len : (uint32_t)(sep - line);
+        cmd->capdu_len = sizeof(cmd->capdu);
+        cmd->rapdu_exp_len = sep == NULL ? 0U : sizeof(cmd->rapdu_exp);
+        if (script_hex_prs(line, capdu_str_len, cmd->capdu, &cmd->capdu_len) !=
+                SWICC_RET_SUCCESS ||
+            (sep != NULL &&
+             script_hex_prs(sep + 1U, line_len - capdu_str_len - 1U,
+                            cmd->rapdu_exp,
+                            &cmd->rapdu_exp_len) != SWICC_RET_SUCCESS))
+        {
+            fprintf(stderr, "Line %u of the script is not valid hex.\n",
+                    line_nr);
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        if (cmd->capdu_len < 5U)
+        {
+            fprintf(stderr,
+                    "Line %u of the script has a command of %u bytes, it "
+                    "needs at least 5.\n",
+                    line_nr, cmd->capdu_len);
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        run->cmd_count += 1U;
+    }
+    fclose(file);
+    if (ret == SWICC_RET_SUCCESS && run->cmd_count == 0U)
+    {
+        fprintf(stderr, "Script '%s' has no commands.\n", path);
+        ret = SWICC_RET_ERROR;
+    }
+    return ret;
+}
+
+/**
+ * @brief Wait for all cards to connect and reset them.
+ * @param[in, out] run
+ * @return Return code.
+ */
+static swicc_ret_et run_connect(run_st *const run)
+{
+    uint32_t const conn_count =
+        (run->card_count + run->card_per_conn - 1U) / run->card_per_conn;
+    fprintf(stderr, "Waiting for %u connections...\n", conn_count);
+    for (uint32_t conn_idx = 0U; conn_idx < conn_count; ++conn_idx)
+    {
+        /* Safe cast since the card count limits the slot to 16 bits. */
+        uint16_t const slot_conn = (uint16_t)(conn_idx * run->card_per_conn);
+        swicc_ret_et ret;
+        while ((ret = swicc_net_server_client_connect(
+                    &run->server, slot_conn)) != SWICC_RET_SUCCESS)
+        {
+            if (run_stop)
+            {
+                return SWICC_RET_ERROR;
+            }
+            if (ret == SWICC_RET_NET_CONN_QUEUE_EMPTY)
+            {
+                struct timespec const wait = {.tv_nsec = 10000000};
+                nanosleep(&wait, NULL);
+            }
+            else if (ret != SWICC_RET_ERROR)
+            {
+                return ret;
+            }
+        }
+        for (uint32_t card = 1U; card < run->card_per_conn &&
+                                 slot_conn + card < run->card_count;
+             ++card)
+        {
+            /* Safe cast since the slot is less than the card count. */
+            if (swicc_net_server_slot_attach(&run->server,
+                                             (uint16_t)(slot_conn + card),
+                                             slot_conn, card) !=
+                SWICC_RET_SUCCESS)
+            {
+                return SWICC_RET_ERROR;
+            }
+        }
+    }
+
+    fprintf(stderr, "Resetting %u cards...\n", run->card_count);
+    for (uint32_t card_idx = 0U; card_idx < run->card_count; ++card_idx)
+    {
+        swicc_net_msg_st msg = {
+            .hdr.size = (uint32_t)offsetof(swicc_net_msg_data_st, buf),
+            .data.ctrl = SWICC_NET_MSG_CTRL_MOCK_RESET_COLD_PPS_Y,
+        };
+        /* Safe cast since the card count limits the slot to 16 bits. */
+        uint16_t const slot = (uint16_t)card_idx;
+        if (swicc_net_server_slot_send(&run->server, slot, &msg) !=
+                SWICC_RET_SUCCESS ||
+            swicc_net_server_slot_recv(&run->server, slot, &msg) !=
+                SWICC_RET_SUCCESS ||
+            msg.data.ctrl != SWICC_NET_MSG_CTRL_SUCCESS)
+        {
+            fprintf(stderr, "Failed to reset card %u.\n", card_idx);
+            return SWICC_RET_ERROR;
+        }
+    }
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Send the next command of a card.
+ * @param[in, out] run
+ * @param[in] card_idx
+ * @param[in] time_sched When the command was due, latency is measured from
+ * this point on.
+ * @return Return code.
+ */
+static swicc_ret_et run_card_send(run_st *const run, uint32_t const card_idx,
+                                  uint64_t const time_sched)
+{
+    card_st *const card = &run->card[card_idx];
+    cmd_st const *const cmd = &run->cmd[card->cmd_idx];
+    static swicc_net_msg_st msg;
+    memcpy(msg.data.buf, cmd->capdu, cmd->capdu_len);
+    msg.hdr.size =
+        (uint32_t)(offsetof(swicc_net_msg_data_st, buf) + cmd->capdu_len);
+    msg.data.cont_state = 0U;
+    msg.data.buf_len_exp = 0U;
+    msg.data.ctrl = SWICC_NET_MSG_CTRL_APDU;
+    /* Safe cast since the card count limits the slot to 16 bits. */
+    if (swicc_net_server_slot_send(&run->server, (uint16_t)card_idx, &msg) !=
+        SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to send a command to card %u.\n", card_idx);
+        return SWICC_RET_ERROR;
+    }
+    card->busy = true;
+    card->time_sched = time_sched;
+    run->issued += 1U;
+    run->in_flight += 1U;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Receive one response on a connection and account for it.
+ * @param[in, out] run
+ * @param[in] sock Socket of the connection.
+ * @return Return code. Only failures of the connection are errors, protocol
+ * errors just get counted.
+ */
+static swicc_ret_et run_conn_recv(run_st *const run, int32_t const sock)
+{
+    static swicc_net_msg_st msg;
+    uint32_t card_id;
+    if (swicc_net_recv_card(sock, &msg, &card_id) != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to receive a response.\n");
+        return SWICC_RET_ERROR;
+    }
+    uint64_t const time = time_now();
+
+    uint16_t slot;
+    if (swicc_net_server_slot_find(&run->server, sock, card_id, &slot) !=
+            SWICC_RET_SUCCESS ||
+        slot >= run->card_count || !run->card[slot].busy)
+    {
+        fprintf(stderr, "Got an unexpected response for card %u.\n",
+                card_id);
+        run->error_count += 1U;
+        return SWICC_RET_SUCCESS;
+    }
+    card_st *const card = &run->card[slot];
+    cmd_st *const cmd = &run->cmd[card->cmd_idx];
+    uint32_t const hdr_size = (uint32_t)offsetof(swicc_net_msg_data_st, buf);
+    if (msg.data.ctrl != SWICC_NET_MSG_CTRL_SUCCESS ||
+        msg.hdr.size < hdr_size + 2U)
+    {
+        /* Only the first errors are logged to not flood the output. */
+        if (cmd->error_count < 8U)
+        {
+            fprintf(stderr,
+                    "Card %u failed command %u: ctrl=0x%02X length=%u.\n",
+                    slot, card->cmd_idx, msg.data.ctrl,
+                    msg.hdr.size - hdr_size);
+        }
+        cmd->error_count += 1U;
+    }
+    else
+    {
+        uint32_t const rapdu_len = msg.hdr.size - hdr_size;
+        if (cmd->rapdu_exp_len > 0U &&
+            (rapdu_len < cmd->rapdu_exp_len ||
+             memcmp(&msg.data.buf[rapdu_len - cmd->rapdu_exp_len],
+                    cmd->rapdu_exp, cmd->rapdu_exp_len) != 0))
+        {
+            if (cmd->mismatch_count < 8U)
+            {
+                fprintf(stderr, "Card %u got a mismatching R-APDU for command "
+                                "%u: '",
+                        slot, card->cmd_idx);
+                for (uint32_t byte_idx = 0U; byte_idx < rapdu_len; ++byte_idx)
+                {
+                    fprintf(stderr, "%02X", msg.data.buf[byte_idx]);
+                }
+                fprintf(stderr, "'.\n");
+            }
+            cmd->mismatch_count += 1U;
+        }
+        hist_add(&cmd->hist, time - card->time_sched);
+    }
+    card->busy = false;
+    card->cmd_idx = (card->cmd_idx + 1U) % run->cmd_count;
+    run->in_flight -= 1U;
+    return SWICC_RET_SUCCESS;
+}
+
+/**
+ * @brief Get when the next command is due when sending at a fixed rate. This
+ * is computed from the start of the run so rounding does not add up.
+ * @param run
+ * @param time_start When the run started (in ns).
+ * @return Time in nanoseconds.
+ */
+static uint64_t run_time_due(run_st const *const run,
+                             uint64_t const time_start)
+{
+    return time_start + (run->issued / run->rate) * 1000000000U +
+           (run->issued % run->rate) * 1000000000U / run->rate;
+}
+
+/**
+ * @brief Send all commands that are due.
+ * @param[in, out] run
+ * @param[in] time_start When the run started (in ns).
+ * @param[in] time_now_ns
+ * @return Return code.
+ */
+static swicc_ret_et run_send_due(run_st *const run, uint64_t const time_start,
+                                 uint64_t const time_now_ns)
+{
+    for (;;)
+    {
+        if (run->issue_max != 0U && run->issued >= run->issue_max)
+        {
+            return SWICC_RET_SUCCESS;
+        }
+        uint64_t const time_due =
+            run->rate != 0U ? run_time_due(run, time_start) : time_now_ns;
+        if (time_due > time_now_ns)
+        {
+            return SWICC_RET_SUCCESS;
+        }
+
+        /**
+         * A command that is due while all cards are busy stays due so the
+         * time it waits for a card counts towards its latency.
+         */
+        uint32_t card_idx = run->card_count;
+        for (uint32_t card_off = 0U; card_off < run->card_count; ++card_off)
+        {
+            uint32_t const card_cand =
+                (run->card_next + card_off) % run->card_count;
+            if (!run->card[card_cand].busy)
+            {
+                card_idx = card_cand;
+                break;
+            }
+        }
+        if (card_idx == run->card_count)
+        {
+            return SWICC_RET_SUCCESS;
+        }
+        run->card_next = (card_idx + 1U) % run->card_count;
+
+        if (run_card_send(run, card_idx, time_due) != SWICC_RET_SUCCESS)
+        {
+            return SWICC_RET_ERROR;
+        }
+    }
+}
+
+/**
+ * @brief Drive all cards until the run is over.
+ * @param[in, out] run
+ * @param[out] time_total How long the run took (in ns).
+ * @return Return code.
+ */
+static swicc_ret_et run_loop(run_st *const run, uint64_t *const time_total)
+{
+    uint32_t const conn_count =
+        (run->card_count + run->card_per_conn - 1U) / run->card_per_conn;
+    struct pollfd *const fd = calloc(conn_count, sizeof(struct pollfd));
+    if (fd == NULL)
+    {
+        return SWICC_RET_ERROR;
+    }
+    for (uint32_t conn_idx = 0U; conn_idx < conn_count; ++conn_idx)
+    {
+        fd[conn_idx].fd =
+            run->server.slot[conn_idx * run->card_per_conn].sock;
+        fd[conn_idx].events = POLLIN;
+    }
+
+    swicc_ret_et ret = SWICC_RET_SUCCESS;
+    uint64_t const time_start = time_now();
+    uint64_t time = time_start;
+    for (;;)
+    {
+        bool const sending =
+            !run_stop &&
+            (run->duration == 0U || time - time_start < run->duration) &&
+            (run->issue_max == 0U || run->issued < run->issue_max);
+        if (!sending && run->in_flight == 0U)
+        {
+            break;
+        }
+        if (sending &&
+            run_send_due(run, time_start, time) != SWICC_RET_SUCCESS)
+        {
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+
+        struct timespec timeout = {.tv_nsec = POLL_TIMEOUT * 1000000};
+        if (sending && run->rate != 0U)
+        {
+            uint64_t const time_due = run_time_due(run, time_start);
+            uint64_t const time_wait = time_due > time ? time_due - time : 0U;
+            if (time_wait < POLL_TIMEOUT * 1000000U)
+            {
+                /* Safe cast since the wait is less than the poll timeout. */
+                timeout.tv_nsec = (long)time_wait;
+            }
+        }
+        int const ready = ppoll(fd, conn_count, &timeout, NULL);
+        if (ready < 0 && errno != EINTR)
+        {
+            fprintf(stderr, "Failed to wait for responses: %s.\n",
+                    strerror(errno));
+            ret = SWICC_RET_ERROR;
+            break;
+        }
+        for (uint32_t conn_idx = 0U; ready > 0 && conn_idx < conn_count;
+             ++conn_idx)
+        {
+            if ((fd[conn_idx].revents & (POLLIN | POLLHUP | POLLERR)) != 0 &&
+                run_conn_recv(run, fd[conn_idx].fd) != SWICC_RET_SUCCESS)
+            {
+                ret = SWICC_RET_ERROR;
+                break;
+            }
+        }
+        if (ret != SWICC_RET_SUCCESS)
+        {
+            break;
+        }
+        time = time_now();
+    }
+    *time_total = time_now() - time_start;
+    free(fd);
+    return ret;
+}
+
+/**
+ * @brief Print a line of the latency report.
+ * @param name
+ * @param hist
+ * @param error_count
+ * @param mismatch_count
+ */
+static void report_line(char const *const name, hist_st const *const hist,
+                        uint64_t const error_count,
+                        uint64_t const mismatch_count)
+{
+    fprintf(stdout, "%s\t%llu\t%llu\t%llu\t%.1f\t%.1f\t%.1f\t%.1f\n", name,
+            (unsigned long long)hist->count, (unsigned long long)error_count,
+            (unsigned long long)mismatch_count,
+            (double)hist_pct(hist, 0.5) / 1000.0,
+            (double)hist_pct(hist, 0.99) / 1000.0,
+            (double)hist_pct(hist, 0.999) / 1000.0,
+            (double)hist->max / 1000.0);
+}
+
+/**
+ * @brief Print the latency report of a run.
+ * @param run
+ * @param time_total How long the run took (in ns).
+ * @return Total number of protocol errors and mismatches.
+ */
+static uint64_t report(run_st const *const run, uint64_t const time_total)
+{
+    static hist_st hist_all;
+    uint64_t error_count = run->error_count;
+    uint64_t mismatch_count = 0U;
+    fprintf(stdout, "command\tcount\terrors\tmismatches\tp50_us\tp99_us\t"
+                    "p999_us\tmax_us\n");
+    for (uint32_t cmd_idx = 0U; cmd_idx < run->cmd_count; ++cmd_idx)
+    {
+        cmd_st const *const cmd = &run->cmd[cmd_idx];
+        char name[2U * sizeof(cmd->capdu) + 1U];
+        for (uint16_t byte_idx = 0U; byte_idx < cmd->capdu_len; ++byte_idx)
+        {
+            snprintf(&name[2U * byte_idx], 3U, "%02X", cmd->capdu[byte_idx]);
+        }
+        report_line(name, &cmd->hist, cmd->error_count, cmd->mismatch_count);
+        hist_merge(&hist_all, &cmd->hist);
+        error_count += cmd->error_count;
+        mismatch_count += cmd->mismatch_count;
+    }
+    report_line("all", &hist_all, error_count, mismatch_count);
+
+    double const time_s = (double)time_total / 1000000000.0;
+    fprintf(stderr,
+            "Completed %llu commands on %u cards in %.3f s (%.1f commands/s) "
+            "with %llu errors and %llu mismatches.\n",
+            (unsigned long long)hist_all.count, run->card_count, time_s,
+            time_s > 0.0 ? (double)hist_all.count / time_s : 0.0,
+            (unsigned long long)error_count,
+            (unsigned long long)mismatch_count);
+    return error_count + mismatch_count;
+}
+
+/**
+ * @brief Parse an unsigned number argument.
+ * @param str
+ * @param max Largest value allowed.
+ * @param[out] val
+ * @return true on success, false otherwise.
+ */
+static bool arg_prs(char const *const str, uint64_t const max,
+                    uint64_t *const val)
+{
+    char *end;
+    errno = 0;
+    unsigned long long const val_arg = strtoull(str, &end, 10);
+    if (errno != 0 || end == str || *end != '\0' || str[0U] == '-' ||
+        val_arg > max)
+    {
+        return false;
+    }
+    *val = val_arg;
+    return true;
+}
+
+int main(int const argc, char *const argv[])
+{
+    static run_st run;
+    uint64_t card_count = 1U;
+    uint64_t card_per_conn = 1U;
+    uint64_t duration_s = 10U;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:m:r:d:n:")) != -1)
+    {
+        bool valid = true;
+        switch (opt)
+        {
+        case 'c':
+            valid = arg_prs(optarg, CARD_COUNT_MAX, &card_count) &&
+                    card_count > 0U;
+            break;
+        case 'm':
+            valid = arg_prs(optarg, CARD_COUNT_MAX, &card_per_conn) &&
+                    card_per_conn > 0U;
+            break;
+        case 'r':
+            valid = arg_prs(optarg, 1000000000U, &run.rate);
+            break;
+        case 'd':
+            valid = arg_prs(optarg, UINT32_MAX, &duration_s);
+            break;
+        case 'n':
+            valid = arg_prs(optarg, UINT64_MAX, &run.issue_max);
+            break;
+        default:
+            print_usage(argv[0U]);
+            return -1;
+        }
+        if (!valid)
+        {
+            fprintf(stderr, CLR_TXT(CLR_RED, "Invalid value for -%c.\n"), opt);
+            print_usage(argv[0U]);
+            return -1;
+        }
+    }
+    if (argc - optind != 2)
+    {
+        print_usage(argv[0U]);
+        return -1;
+    }
+    char const *const str_port = argv[optind];
+    char const *const str_script_path = argv[optind + 1];
+    /* Safe casts since the counts are at most the maximum card count. */
+    run.card_count = (uint32_t)card_count;
+    run.card_per_conn = (uint32_t)card_per_conn;
+    run.duration = duration_s * 1000000000U;
+
+    if (script_load(&run, str_script_path) != SWICC_RET_SUCCESS)
+    {
+        free(run.cmd);
+        return -1;
+    }
+    run.card = calloc(run.card_count, sizeof(card_st));
+    if (run.card == NULL)
+    {
+        free(run.cmd);
+        return -1;
+    }
+
+    if (swicc_net_client_sig_register(sig_exit_handler) != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to register signal handler.\n");
+        free(run.card);
+        free(run.cmd);
+        return -1;
+    }
+
+    fprintf(stderr, "Starting server on port %s with script at '%s'...\n",
+            str_port, str_script_path);
+    int32_t ret = -1;
+    uint64_t time_total = 0U;
+    if (swicc_net_server_create(&run.server, str_port) != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to create server context.\n");
+    }
+    else if (run_connect(&run) == SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Running %u commands on %u cards...\n", run.cmd_count,
+                run.card_count);
+        swicc_ret_et const ret_loop = run_loop(&run, &time_total);
+        if (report(&run, time_total) == 0U && ret_loop == SWICC_RET_SUCCESS)
+        {
+            ret = 0;
+        }
+    }
+    swicc_net_server_destroy(&run.server);
+    free(run.card);
+    free(run.cmd);
+    return ret;
+}
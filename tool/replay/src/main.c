@@ -0,0 +1,164 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEBUG_CLR
+#include <swicc/swicc.h>
+
+static void print_usage(char const *const arg0)
+{
+    // clang-format off
+    fprintf(stderr, "Usage: %s [-n "CLR_VAL("passes")"] <"CLR_VAL("/path/to/disk")"> <"CLR_VAL("/path/to/capture")">"
+        "\n"
+        "\nReplays a capture of the traffic of a card as fast as possible on"
+        "\nthe disk it was captured with and compares the responses with the"
+        "\ncaptured ones. The disk is either a JSON definition (when the path"
+        "\nends with '.json') or a disk file. Before every pass, the card and"
+        "\nthe disk are put back into the state they were in after loading."
+        "\n"
+        "\n  -n  Number of passes, 1 by default."
+        "\n"
+        "\nEvery pass prints the number of commands, resets and mismatching"
+        "\nresponses, the time the card spent on the commands during the"
+        "\nreplay and during the capture (in microseconds), and the time per"
+        "\ncommand of the replay (in nanoseconds). Mismatches make the exit"
+        "\ncode non-zero."
+        "\n",
+        arg0);
+    // clang-format on
+}
+
+/**
+ * @brief Parse an unsigned number argument.
+ * @param str
+ * @param max Largest value allowed.
+ * @param[out] val
+ * @return true on success, false otherwise.
+ */
+static bool arg_prs(char const *const str, uint64_t const max,
+                    uint64_t *const val)
+{
+    char *end;
+    errno = 0;
+    unsigned long long const val_arg = strtoull(str, &end, 10);
+    if (errno != 0 || end == str || *end != '\0' || str[0U] == '-' ||
+        val_arg > max)
+    {
+        return false;
+    }
+    *val = val_arg;
+    return true;
+}
+
+/**
+ * @brief Load a disk from a JSON definition or a disk file.
+ * @param disk
+ * @param disk_path
+ * @return Return code.
+ */
+static swicc_ret_et disk_load(swicc_disk_st *const disk,
+                              char const *const disk_path)
+{
+    size_t const disk_path_len = strlen(disk_path);
+    if (disk_path_len >= 5U &&
+        strcmp(&disk_path[disk_path_len - 5U], ".json") == 0)
+    {
+        return swicc_diskjs_disk_create(disk, disk_path);
+    }
+    return swicc_disk_load(disk, disk_path);
+}
+
+int main(int const argc, char *const argv[])
+{
+    static swicc_st swicc_state;
+    static swicc_checkpoint_st checkpoint;
+    static uint8_t buf_rx[SWICC_DATA_MAX];
+    static uint8_t buf_tx[SWICC_DATA_MAX];
+    uint64_t pass_count = 1U;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        bool valid = true;
+        switch (opt)
+        {
+        case 'n':
+            valid = arg_prs(optarg, UINT32_MAX, &pass_count) && pass_count > 0U;
+            break;
+        default:
+            print_usage(argv[0U]);
+            return -1;
+        }
+        if (!valid)
+        {
+            fprintf(stderr, CLR_TXT(CLR_RED, "Invalid value for -%c.\n"), opt);
+            print_usage(argv[0U]);
+            return -1;
+        }
+    }
+    if (argc - optind != 2)
+    {
+        print_usage(argv[0U]);
+        return -1;
+    }
+    char const *const str_disk_path = argv[optind];
+    char const *const str_capture_path = argv[optind + 1];
+
+    swicc_state.buf_rx = buf_rx;
+    swicc_state.buf_tx = buf_tx;
+    if (disk_load(&swicc_state.fs.disk, str_disk_path) != SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to load disk '%s'.\n", str_disk_path);
+        return -1;
+    }
+    if (swicc_checkpoint_capture(&checkpoint, &swicc_state) !=
+        SWICC_RET_SUCCESS)
+    {
+        fprintf(stderr, "Failed to capture a checkpoint of the card.\n");
+        swicc_disk_unload(&swicc_state.fs.disk);
+        return -1;
+    }
+
+    int32_t ret = 0;
+    printf("pass\tcommands\tresets\tmismatches\treplay_us\tcapture_us\t"
+           "ns_per_cmd\n");
+    for (uint64_t pass = 0U; pass < pass_count; ++pass)
+    {
+        swicc_capture_replay_st replay;
+        if (swicc_checkpoint_restore(&checkpoint, &swicc_state) !=
+                SWICC_RET_SUCCESS ||
+            swicc_capture_replay(&swicc_state, str_capture_path, &replay) !=
+                SWICC_RET_SUCCESS)
+        {
+            fprintf(stderr,
+                    "Failed to replay '%s' (not a capture or captured with "
+                    "a different disk).\n",
+                    str_capture_path);
+            ret = -1;
+            break;
+        }
+        printf("%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\n",
+               (unsigned long long)pass,
+               (unsigned long long)replay.cmd_count,
+               (unsigned long long)replay.reset_count,
+               (unsigned long long)replay.mismatch_count,
+               (unsigned long long)(replay.time_replay / 1000U),
+               (unsigned long long)(replay.time_capture / 1000U),
+               (unsigned long long)(replay.cmd_count == 0U
+                                        ? 0U
+                                        : replay.time_replay /
+                                              replay.cmd_count));
+        if (replay.mismatch_count > 0U)
+        {
+            fprintf(stderr, "First mismatching response in record %llu.\n",
+                    (unsigned long long)replay.mismatch_first);
+            ret = -1;
+        }
+    }
+    swicc_checkpoint_free(&checkpoint);
+    swicc_disk_unload(&swicc_state.fs.disk);
+    swicc_apdu_rc_free(&swicc_state.apdu_rc);
+    return ret;
+}
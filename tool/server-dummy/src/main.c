@@ -39,49 +39,43 @@ static uint32_t parse_file_data(char const *const data_in,
                                 uint32_t const data_in_len,
                                 uint32_t const data_out_len_max)
 {
-    uint32_t data_out_len = 0U;
-    uint8_t nibble_count = 0U;
-    uint32_t nibbles[2U] = {0U};
-    for (uint32_t data_idx = 0U; data_idx < data_in_len; ++data_idx)
+    /**
+     * Spaces are skipped and lower case nibbles are accepted here, then all
+     * nibbles up to the first invalid character get decoded in one go.
+     */
+    char hexstr[1024U];
+    uint32_t hexstr_len = 0U;
+    for (uint32_t data_idx = 0U; data_idx < data_in_len &&
+                                 hexstr_len < sizeof(hexstr) &&
+                                 hexstr_len / 2U < data_out_len_max;
+         ++data_idx)
     {
-        if (data_in[data_idx] == ' ')
-        {
-            continue;
-        }
         char const nibble_char = data_in[data_idx];
-        char base;
-        uint8_t base_val;
-        if (nibble_char >= '0' && nibble_char <= '9')
+        if (nibble_char == ' ')
         {
-            base = '0';
-            base_val = 0;
+            continue;
         }
-        else if (nibble_char >= 'A' && nibble_char <= 'F')
+        if (nibble_char >= 'a' && nibble_char <= 'f')
         {
-            base = 'A';
-            base_val = 0x0A;
+            hexstr[hexstr_len++] = (char)(nibble_char - ('a' - 'A'));
         }
-        else if (nibble_char >= 'a' && nibble_char <= 'f')
+        else if ((nibble_char >= '0' && nibble_char <= '9') ||
+                 (nibble_char >= 'A' && nibble_char <= 'F'))
         {
-            base = 'a';
-            base_val = 0x0A;
+            hexstr[hexstr_len++] = nibble_char;
         }
         else
         {
             break;
         }
-        nibbles[nibble_count++] =
-            (uint8_t)(base_val + (data_in[data_idx] - base));
-        if (nibble_count == 2U)
-        {
-            if (data_out_len + 1U > data_out_len_max)
-            {
-                break;
-            }
-            data_out[data_out_len++] =
-                (uint8_t)((nibbles[0U] << 4U) | nibbles[1U]);
-            nibble_count = 0U;
-        }
+    }
+
+    /* A trailing nibble without a pair is ignored. */
+    uint32_t data_out_len = data_out_len_max;
+    if (swicc_hexstr_bytearr(hexstr, hexstr_len & ~1U, data_out,
+                             &data_out_len) != SWICC_RET_SUCCESS)
+    {
+        return 0U;
     }
     return data_out_len;
 }
@@ -90,12 +84,12 @@ static uint32_t message_io(swicc_net_msg_st *const msg,
                            uint32_t const response_lenexp_expected,
                            uint32_t const response_length_expected_max)
 {
-    if (swicc_net_send(server_ctx.sock_client[0U], msg) != SWICC_RET_SUCCESS)
+    if (swicc_net_server_slot_send(&server_ctx, 0U, msg) != SWICC_RET_SUCCESS)
     {
         fprintf(stderr, "Failed to send message to client.\n");
         return 1;
     }
-    if (swicc_net_recv(server_ctx.sock_client[0U], msg) != SWICC_RET_SUCCESS)
+    if (swicc_net_server_slot_recv(&server_ctx, 0U, msg) != SWICC_RET_SUCCESS)
     {
         fprintf(stderr, "Failed to receive message from client.\n");
         return 2;
@@ -187,13 +181,8 @@ int32_t main(int32_t const argc, char const *const argv[argc])
 
     /* Prepare the server context. */
     server_ctx.sock_server = -1;
-    for (uint16_t client_idx = 0U;
-         client_idx <
-         sizeof(server_ctx.sock_client) / sizeof(server_ctx.sock_client[0U]);
-         ++client_idx)
-    {
-        server_ctx.sock_client[client_idx] = -1;
-    }
+    server_ctx.slot = NULL;
+    server_ctx.slot_count = 0U;
 
     char const *const str_port = argv[1U];
     char const *const str_data_path = argv[2U];